@@ -378,6 +378,9 @@ static gboolean gst_dash_demux_process_manifest (GstAdaptiveDemux * ademux,
 static gboolean gst_dash_demux_seek (GstAdaptiveDemux * demux, GstEvent * seek);
 static GstFlowReturn
 gst_dash_demux_stream_update_fragment_info (GstAdaptiveDemuxStream * stream);
+static GstFlowReturn
+gst_dash_demux_stream_peek_fragment_info (GstAdaptiveDemuxStream * stream,
+    guint n, GstAdaptiveDemuxStreamFragment * fragment);
 static GstFlowReturn gst_dash_demux_stream_seek (GstAdaptiveDemuxStream *
     stream, gboolean forward, GstSeekFlags flags, GstClockTime ts,
     GstClockTime * final_ts);
@@ -640,6 +643,8 @@ gst_dash_demux_class_init (GstDashDemuxClass * klass)
       gst_dash_demux_stream_select_bitrate;
   gstadaptivedemux_class->stream_update_fragment_info =
       gst_dash_demux_stream_update_fragment_info;
+  gstadaptivedemux_class->stream_peek_fragment_info =
+      gst_dash_demux_stream_peek_fragment_info;
   gstadaptivedemux_class->stream_free = gst_dash_demux_stream_free;
   gstadaptivedemux_class->get_live_seek_range =
       gst_dash_demux_get_live_seek_range;
@@ -1068,6 +1073,8 @@ gst_dash_demux_process_manifest (GstAdaptiveDemux * demux, GstBuffer * buf)
   if (ret)
     ret = gst_dash_demux_setup_streams (demux);
 
+  gst_buffer_replace (&dashdemux->last_manifest, ret ? buf : NULL);
+
   return ret;
 }
 
@@ -1125,6 +1132,7 @@ gst_dash_demux_reset (GstAdaptiveDemux * ademux)
     gst_mpd_client_free (demux->client);
     demux->client = NULL;
   }
+  gst_buffer_replace (&demux->last_manifest, NULL);
   gst_dash_demux_clock_drift_free (demux->clock_drift);
   demux->clock_drift = NULL;
   demux->client = gst_mpd_client_new ();
@@ -1427,6 +1435,55 @@ gst_dash_demux_stream_update_fragment_info (GstAdaptiveDemuxStream * stream)
   return GST_FLOW_EOS;
 }
 
+static GstFlowReturn
+gst_dash_demux_stream_peek_fragment_info (GstAdaptiveDemuxStream * stream,
+    guint n, GstAdaptiveDemuxStreamFragment * fragment)
+{
+  GstDashDemuxStream *dashstream = (GstDashDemuxStream *) stream;
+  GstDashDemux *dashdemux = GST_DASH_DEMUX_CAST (stream->demux);
+  GstActiveStream *active_stream = dashstream->active_stream;
+  gboolean forward = stream->demux->segment.rate > 0;
+  GstMediaFragmentInfo info = { 0, };
+  GstFlowReturn ret = GST_FLOW_OK;
+  guint segment_repeat_index;
+  gint segment_index;
+
+  /* Subsegments and key unit trick modes download byte ranges that are only
+   * known once the previous data was parsed, and live segments might not be
+   * available yet */
+  if (active_stream == NULL
+      || gst_mpd_client_has_isoff_ondemand_profile (dashdemux->client)
+      || GST_ADAPTIVE_DEMUX_IN_TRICKMODE_KEY_UNITS (dashdemux)
+      || gst_mpd_client_is_live (dashdemux->client))
+    return GST_FLOW_EOS;
+
+  /* Walk forward on the active stream and restore its position afterwards */
+  segment_index = active_stream->segment_index;
+  segment_repeat_index = active_stream->segment_repeat_index;
+
+  while (n-- > 0 && ret == GST_FLOW_OK)
+    ret = gst_mpd_client_advance_segment (dashdemux->client, active_stream,
+        forward);
+
+  if (ret == GST_FLOW_OK && gst_mpd_client_get_next_fragment (dashdemux->client,
+          dashstream->index, &info)) {
+    fragment->uri = info.uri;
+    info.uri = NULL;
+    fragment->range_start = info.range_start;
+    fragment->range_end = info.range_end;
+    fragment->timestamp = info.timestamp;
+    fragment->duration = info.duration;
+    gst_mpdparser_media_fragment_info_clear (&info);
+  } else {
+    ret = GST_FLOW_EOS;
+  }
+
+  active_stream->segment_index = segment_index;
+  active_stream->segment_repeat_index = segment_repeat_index;
+
+  return ret;
+}
+
 static gint
 gst_dash_demux_index_entry_search (GstSidxBoxEntry * entry, GstClockTime * ts,
     gpointer user_data)
@@ -2446,6 +2503,30 @@ gst_dash_demux_get_manifest_update_interval (GstAdaptiveDemux * demux)
       SLOW_CLOCK_UPDATE_INTERVAL);
 }
 
+static gboolean
+gst_dash_demux_manifest_unchanged (GstDashDemux * dashdemux,
+    GstBuffer * buffer)
+{
+  GstMapInfo mapinfo;
+  gboolean ret;
+
+  if (dashdemux->last_manifest == NULL)
+    return FALSE;
+  if (dashdemux->last_manifest == buffer)
+    return TRUE;
+  if (gst_buffer_get_size (dashdemux->last_manifest) !=
+      gst_buffer_get_size (buffer))
+    return FALSE;
+
+  if (!gst_buffer_map (buffer, &mapinfo, GST_MAP_READ))
+    return FALSE;
+  ret = gst_buffer_memcmp (dashdemux->last_manifest, 0, mapinfo.data,
+      mapinfo.size) == 0;
+  gst_buffer_unmap (buffer, &mapinfo);
+
+  return ret;
+}
+
 static GstFlowReturn
 gst_dash_demux_update_manifest_data (GstAdaptiveDemux * demux,
     GstBuffer * buffer)
@@ -2454,6 +2535,18 @@ gst_dash_demux_update_manifest_data (GstAdaptiveDemux * demux,
   GstMPDClient *new_client = NULL;
   GstMapInfo mapinfo;
 
+  /* Live MPDs that describe their segments with a template are usually
+   * served unchanged between refreshes, don't parse them again then. When
+   * a SegmentTimeline was updated, the new client reuses the segments the
+   * current one already built */
+  if (gst_dash_demux_manifest_unchanged (dashdemux, buffer)) {
+    GST_DEBUG_OBJECT (demux, "Manifest is the same as the previous one");
+    if (dashdemux->clock_drift) {
+      gst_dash_demux_poll_clock_drift (dashdemux);
+    }
+    return GST_FLOW_OK;
+  }
+
   GST_DEBUG_OBJECT (demux, "Updating manifest file from URL");
 
   /* parse the manifest file */
@@ -2461,6 +2554,7 @@ gst_dash_demux_update_manifest_data (GstAdaptiveDemux * demux,
   gst_mpd_client_set_uri_downloader (new_client, demux->downloader);
   new_client->mpd_uri = g_strdup (demux->manifest_uri);
   new_client->mpd_base_uri = g_strdup (demux->manifest_base_uri);
+  new_client->previous = dashdemux->client;
   gst_buffer_map (buffer, &mapinfo, GST_MAP_READ);
 
   if (gst_mpd_client_parse (new_client, (gchar *) mapinfo.data, mapinfo.size)) {
@@ -2595,10 +2689,12 @@ gst_dash_demux_update_manifest_data (GstAdaptiveDemux * demux,
       demux_stream->active_stream = new_stream;
     }
 
+    new_client->previous = NULL;
     gst_mpd_client_free (dashdemux->client);
     dashdemux->client = new_client;
 
     GST_DEBUG_OBJECT (demux, "Manifest file successfully updated");
+    gst_buffer_replace (&dashdemux->last_manifest, buffer);
     if (dashdemux->clock_drift) {
       gst_dash_demux_poll_clock_drift (dashdemux);
     }
@@ -129,6 +129,7 @@ struct _GstDashDemux
 
   GstMPDClient *client;         /* MPD client */
   GMutex client_lock;
+  GstBuffer *last_manifest;     /* last parsed MPD, to skip identical updates */
 
   GstDashDemuxClockDrift *clock_drift;
 
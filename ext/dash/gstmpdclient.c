@@ -790,6 +790,80 @@ gst_mpd_client_get_segment_end_time (GstMPDClient * client,
   return end;
 }
 
+/* Returns the index of the first segment of @segments ending after @ts, or
+ * at @ts in reverse mode, which is where a seek to @ts starts looking */
+static guint
+gst_mpd_client_find_segment_index (GstMPDClient * client,
+    GPtrArray * segments, GstClockTime ts, gboolean forward)
+{
+  guint lo = 0, hi = segments->len;
+
+  while (lo < hi) {
+    guint mid = lo + (hi - lo) / 2;
+    GstClockTime end_time = gst_mpd_client_get_segment_end_time (client,
+        segments, g_ptr_array_index (segments, mid), mid);
+
+    if (forward ? ts < end_time : ts <= end_time)
+      hi = mid;
+    else
+      lo = mid + 1;
+  }
+
+  return lo;
+}
+
+/* Returns segment @n of @stream, copied first if it is still shared with
+ * the previous version of the MPD */
+static GstMediaSegment *
+gst_mpd_client_get_writable_media_segment (GstActiveStream * stream, guint n)
+{
+  GstMediaSegment *segment = g_ptr_array_index (stream->segments, n);
+
+  if (g_atomic_int_get (&segment->ref_count) > 1) {
+    GstMediaSegment *copy = g_slice_dup (GstMediaSegment, segment);
+
+    copy->ref_count = 1;
+    g_ptr_array_index (stream->segments, n) = copy;
+    gst_mpdparser_free_media_segment (segment);
+    segment = copy;
+  }
+
+  return segment;
+}
+
+/* Extends the last segment of @stream instead of adding a new one if the
+ * S element continues it with the same duration. Many packagers write one
+ * S element per segment instead of using S@r. Segments crossing @period_end
+ * are kept separate, so that they can be clipped afterwards */
+static gboolean
+gst_mpd_client_extend_media_segment (GstActiveStream * stream, gint repeat,
+    guint64 scale_start, guint64 scale_duration, GstClockTime period_end)
+{
+  GstMediaSegment *last;
+
+  if (repeat < 0 || stream->segments->len == 0)
+    return FALSE;
+
+  last = g_ptr_array_index (stream->segments, stream->segments->len - 1);
+  if (last->SegmentURL != NULL || last->repeat < 0
+      || last->scale_duration != scale_duration
+      || last->scale_start + scale_duration * (last->repeat + 1) !=
+      scale_start)
+    return FALSE;
+
+  if (GST_CLOCK_TIME_IS_VALID (period_end) && last->start +
+      last->duration * (last->repeat + repeat + 2) > period_end)
+    return FALSE;
+
+  last = gst_mpd_client_get_writable_media_segment (stream,
+      stream->segments->len - 1);
+  last->repeat += repeat + 1;
+  GST_LOG ("Extended segment number %d, repeat %d", last->number,
+      last->repeat);
+
+  return TRUE;
+}
+
 static gboolean
 gst_mpd_client_add_media_segment (GstActiveStream * stream,
     GstMPDSegmentURLNode * url_node, guint number, gint repeat,
@@ -809,6 +883,7 @@ gst_mpd_client_add_media_segment (GstActiveStream * stream,
   media_segment->start = start;
   media_segment->duration = duration;
   media_segment->repeat = repeat;
+  media_segment->ref_count = 1;
 
   g_ptr_array_add (stream->segments, media_segment);
   GST_LOG ("Added new segment: number %d, repeat %d, "
@@ -819,6 +894,160 @@ gst_mpd_client_add_media_segment (GstActiveStream * stream,
   return TRUE;
 }
 
+/* Returns the stream of the previous version of a live MPD whose segments
+ * @stream can reuse: it plays the same Representation with a SegmentTimeline
+ * of the same timescale, in an open ended Period starting at the same time */
+static GstActiveStream *
+gst_mpd_client_get_previous_stream (GstMPDClient * client,
+    GstActiveStream * stream, GstMPDMultSegmentBaseNode * mult_seg,
+    GstStreamPeriod * stream_period)
+{
+  GstStreamPeriod *previous_period;
+  GstActiveStream *previous;
+  GstMPDMultSegmentBaseNode *previous_seg;
+
+  if (client->previous == NULL || client->previous->periods == NULL
+      || GST_CLOCK_TIME_IS_VALID (stream_period->duration)
+      || stream->cur_representation->id == NULL)
+    return NULL;
+
+  previous_period = gst_mpd_client_get_stream_period (client->previous);
+  if (previous_period == NULL || previous_period->start != stream_period->start
+      || GST_CLOCK_TIME_IS_VALID (previous_period->duration)
+      || g_strcmp0 (previous_period->period->id,
+          stream_period->period->id) != 0)
+    return NULL;
+
+  previous = g_list_nth_data (client->previous->active_streams,
+      g_list_index (client->active_streams, stream));
+  if (previous == NULL || previous->segments == NULL
+      || previous->segments->len == 0 || previous->cur_seg_template == NULL
+      || previous->cur_representation == NULL
+      || g_strcmp0 (previous->cur_representation->id,
+          stream->cur_representation->id) != 0)
+    return NULL;
+
+  previous_seg = GST_MPD_MULT_SEGMENT_BASE_NODE (previous->cur_seg_template);
+  if (previous_seg->SegmentTimeline == NULL
+      || previous_seg->SegmentBase->timescale !=
+      mult_seg->SegmentBase->timescale
+      || previous_seg->SegmentBase->presentationTimeOffset !=
+      mult_seg->SegmentBase->presentationTimeOffset)
+    return NULL;
+
+  return previous;
+}
+
+/* Reuses the segments of @previous that the S elements from @list still
+ * describe, so that a live MPD update only adds the segments past the end of
+ * the previous version. Returns the first S element that remains to be
+ * processed, from @number, @start and @start_time, or @list untouched if the
+ * timelines don't match */
+static GList *
+gst_mpd_client_reuse_media_segments (GstActiveStream * stream,
+    GstActiveStream * previous, GList * list, guint * number, guint64 * start,
+    GstClockTime * start_time, guint timescale)
+{
+  GstMediaSegment *first = NULL, *last, *segment;
+  GstMPDSNode *S = NULL;
+  GList *l;
+  guint64 first_start, previous_end, cur_start, known = 0;
+  GstClockTime previous_end_time, duration;
+  guint first_number, previous_end_number, cur_number, n, skip;
+
+  last = g_ptr_array_index (previous->segments, previous->segments->len - 1);
+  if (last->repeat < 0)
+    return list;
+  previous_end = last->scale_start + last->scale_duration * (last->repeat + 1);
+  previous_end_number = last->number + last->repeat + 1;
+
+  /* find the S element that continues past the previous timeline */
+  first_number = cur_number = *number;
+  first_start = cur_start = *start;
+  for (l = list; l; l = g_list_next (l)) {
+    S = (GstMPDSNode *) l->data;
+    if (S->r < 0 || S->d == 0)
+      return list;
+    if (S->t > 0) {
+      cur_start = S->t;
+      if (l == list)
+        first_start = S->t;
+    }
+    if (cur_start + S->d * (S->r + 1) > previous_end)
+      break;
+    cur_number += S->r + 1;
+    cur_start += S->d * (S->r + 1);
+  }
+
+  /* ... and the previous segment that the timeline now starts with */
+  for (n = 0; n < previous->segments->len; n++) {
+    first = g_ptr_array_index (previous->segments, n);
+    if (first->SegmentURL != NULL || first->repeat < 0
+        || first->scale_duration == 0)
+      return list;
+    if (first->scale_start + first->scale_duration * (first->repeat + 1) >
+        first_start)
+      break;
+  }
+  if (n == previous->segments->len || first_start < first->scale_start
+      || (first_start - first->scale_start) % first->scale_duration != 0)
+    return list;
+  skip = (first_start - first->scale_start) / first->scale_duration;
+  if (first->number + skip != first_number)
+    return list;
+
+  if (l == NULL || cur_start >= previous_end) {
+    /* the timeline only adds S elements after the previous one */
+    if (cur_start < previous_end || cur_number != previous_end_number)
+      return list;
+  } else {
+    /* the timeline extends the repeat count of an S element */
+    if (cur_start < last->scale_start || S->d != last->scale_duration
+        || (previous_end - cur_start) % S->d != 0)
+      return list;
+    known = (previous_end - cur_start) / S->d;
+    if (cur_number + known != previous_end_number)
+      return list;
+  }
+
+  GST_LOG ("Reusing %u segments of the previous MPD, from number %u",
+      previous->segments->len - n, first_number);
+  for (; n < previous->segments->len; n++) {
+    segment = g_ptr_array_index (previous->segments, n);
+    g_atomic_int_inc (&segment->ref_count);
+    g_ptr_array_add (stream->segments, segment);
+  }
+
+  /* the segments that went out of the timeline window */
+  if (skip > 0) {
+    first = gst_mpd_client_get_writable_media_segment (stream, 0);
+    first->number += skip;
+    first->repeat -= skip;
+    first->scale_start = first_start;
+    first->start += first->duration * skip;
+  }
+
+  previous_end_time = last->start + last->duration * (last->repeat + 1);
+  *number = cur_number;
+  *start = cur_start;
+  *start_time = previous_end_time;
+
+  if (known == 0)
+    return l;
+
+  duration = gst_util_uint64_scale (S->d, GST_SECOND, timescale);
+  if (!gst_mpd_client_extend_media_segment (stream, S->r - known,
+          previous_end, S->d, GST_CLOCK_TIME_NONE))
+    gst_mpd_client_add_media_segment (stream, NULL, previous_end_number,
+        S->r - known, previous_end, S->d, previous_end_time, duration);
+
+  *number = cur_number + S->r + 1;
+  *start = cur_start + S->d * (S->r + 1);
+  *start_time = previous_end_time + duration * (S->r + 1 - known);
+
+  return g_list_next (l);
+}
+
 static void
 gst_mpd_client_stream_update_presentation_time_offset (GstMPDClient * client,
     GstActiveStream * stream)
@@ -1040,10 +1269,17 @@ gst_mpd_client_setup_representation (GstMPDClient * client,
         GstMPDSNode *S;
         GList *list;
 
+        GstActiveStream *previous;
+
         timeline = mult_seg->SegmentTimeline;
         gst_mpdparser_init_active_stream_segments (stream);
-        for (list = g_queue_peek_head_link (&timeline->S); list;
-            list = g_list_next (list)) {
+        list = g_queue_peek_head_link (&timeline->S);
+        previous = gst_mpd_client_get_previous_stream (client, stream,
+            mult_seg, stream_period);
+        if (previous)
+          list = gst_mpd_client_reuse_media_segments (stream, previous, list,
+              &i, &start, &start_time, mult_seg->SegmentBase->timescale);
+        for (; list; list = g_list_next (list)) {
           guint timescale;
 
           S = (GstMPDSNode *) list->data;
@@ -1057,8 +1293,10 @@ gst_mpd_client_setup_representation (GstMPDClient * client,
                 + PeriodStart - presentationTimeOffset;
           }
 
-          if (!gst_mpd_client_add_media_segment (stream, NULL, i, S->r, start,
-                  S->d, start_time, duration)) {
+          if (!gst_mpd_client_extend_media_segment (stream, S->r, start,
+                  S->d, PeriodEnd)
+              && !gst_mpd_client_add_media_segment (stream, NULL, i, S->r,
+                  start, S->d, start_time, duration)) {
             return FALSE;
           }
           i += S->r + 1;
@@ -1683,7 +1921,10 @@ gst_mpd_client_stream_seek (GstMPDClient * client, GstActiveStream * stream,
   g_return_val_if_fail (stream != NULL, 0);
 
   if (stream->segments) {
-    for (index = 0; index < stream->segments->len; index++) {
+    /* The first iteration of the loop below finds the segment, unless the
+     * seek is after the last one */
+    for (index = gst_mpd_client_find_segment_index (client, stream->segments,
+            ts, forward); index < stream->segments->len; index++) {
       gboolean in_segment = FALSE;
       GstMediaSegment *segment = g_ptr_array_index (stream->segments, index);
       GstClockTime end_time;
@@ -1718,7 +1959,7 @@ gst_mpd_client_stream_seek (GstMPDClient * client, GstActiveStream * stream,
           repeat_index--;
 
         if ((flags & GST_SEEK_FLAG_SNAP_NEAREST) == GST_SEEK_FLAG_SNAP_NEAREST) {
-          if (repeat_index + 1 < segment->repeat) {
+          if (repeat_index < segment->repeat) {
             if (ts - chunk_time > chunk_time + segment->duration - ts)
               repeat_index++;
           } else if (index + 1 < stream->segments->len) {
@@ -1735,7 +1976,7 @@ gst_mpd_client_stream_seek (GstMPDClient * client, GstActiveStream * stream,
                 (!forward && flags & GST_SEEK_FLAG_SNAP_BEFORE)) &&
             ts != chunk_time) {
 
-          if (repeat_index + 1 < segment->repeat) {
+          if (repeat_index < segment->repeat) {
             repeat_index++;
           } else {
             repeat_index = 0;
@@ -47,6 +47,8 @@ struct _GstMPDClient
   gboolean profile_isoff_ondemand;
 
   GstUriDownloader * downloader;
+
+  GstMPDClient *previous;                     /* client of the previous MPD while a live MPD is updated */
 };
 
 /* Basic initialization/deinitialization functions */
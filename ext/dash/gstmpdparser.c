@@ -1338,7 +1338,7 @@ gst_mpdparser_free_stream_period (GstStreamPeriod * stream_period)
 void
 gst_mpdparser_free_media_segment (GstMediaSegment * media_segment)
 {
-  if (media_segment) {
+  if (media_segment && g_atomic_int_dec_and_test (&media_segment->ref_count)) {
     g_slice_free (GstMediaSegment, media_segment);
   }
 }
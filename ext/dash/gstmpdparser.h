@@ -102,6 +102,7 @@ struct _GstMediaSegment
   guint64 scale_duration;                     /* duration in timescale units */
   GstClockTime start;                         /* segment start time */
   GstClockTime duration;                      /* segment duration */
+  gint ref_count;                             /* shared by the segment lists of successive live MPD updates */
 };
 
 struct _GstMediaFragmentInfo
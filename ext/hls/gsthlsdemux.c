@@ -109,6 +109,8 @@ static GstFlowReturn gst_hls_demux_advance_fragment (GstAdaptiveDemuxStream *
     stream);
 static GstFlowReturn gst_hls_demux_update_fragment_info (GstAdaptiveDemuxStream
     * stream);
+static GstFlowReturn gst_hls_demux_peek_fragment_info (GstAdaptiveDemuxStream *
+    stream, guint n, GstAdaptiveDemuxStreamFragment * fragment);
 static gboolean gst_hls_demux_select_bitrate (GstAdaptiveDemuxStream * stream,
     guint64 bitrate);
 static void gst_hls_demux_reset (GstAdaptiveDemux * demux);
@@ -178,6 +180,8 @@ gst_hls_demux_class_init (GstHLSDemuxClass * klass)
   adaptivedemux_class->stream_advance_fragment = gst_hls_demux_advance_fragment;
   adaptivedemux_class->stream_update_fragment_info =
       gst_hls_demux_update_fragment_info;
+  adaptivedemux_class->stream_peek_fragment_info =
+      gst_hls_demux_peek_fragment_info;
   adaptivedemux_class->stream_select_bitrate = gst_hls_demux_select_bitrate;
   adaptivedemux_class->stream_free = gst_hls_demux_stream_free;
 
@@ -425,8 +429,23 @@ gst_hls_demux_stream_seek (GstAdaptiveDemuxStream * stream, gboolean forward,
   snap_after = ! !(flags & GST_SEEK_FLAG_SNAP_AFTER);
 
   GST_M3U8_CLIENT_LOCK (hlsdemux->client);
+  /* Start looking from the fragment before the one containing the target,
+   * none of the earlier ones can be selected by the snapping below */
+  walk = hls_stream->playlist->files;
+  if (ts > current_pos) {
+    GstClockTime file_start = 0;
+
+    walk = gst_m3u8_find_file_by_position (hls_stream->playlist,
+        ts - current_pos, &file_start);
+    if (walk && walk->prev) {
+      walk = walk->prev;
+      file_start -= GST_M3U8_MEDIA_FILE (walk->data)->duration;
+    }
+    current_pos += file_start;
+  }
+
   /* FIXME: Here we need proper discont handling */
-  for (walk = hls_stream->playlist->files; walk; walk = walk->next) {
+  for (; walk; walk = walk->next) {
     file = walk->data;
 
     current_sequence = file->sequence;
@@ -1312,6 +1331,34 @@ gst_hls_demux_update_fragment_info (GstAdaptiveDemuxStream * stream)
   return GST_FLOW_OK;
 }
 
+static GstFlowReturn
+gst_hls_demux_peek_fragment_info (GstAdaptiveDemuxStream * stream, guint n,
+    GstAdaptiveDemuxStreamFragment * fragment)
+{
+  GstHLSDemuxStream *hlsdemux_stream = GST_HLS_DEMUX_STREAM_CAST (stream);
+  GstM3U8MediaFile *file;
+  GstM3U8 *m3u8;
+
+  m3u8 = gst_hls_demux_stream_get_m3u8 (hlsdemux_stream);
+
+  file = gst_m3u8_peek_fragment (m3u8, stream->demux->segment.rate > 0, n);
+  if (file == NULL)
+    return GST_FLOW_EOS;
+
+  fragment->uri = g_strdup (file->uri);
+  fragment->range_start = file->offset;
+  if (file->size != -1)
+    fragment->range_end = file->offset + file->size - 1;
+  else
+    fragment->range_end = -1;
+  fragment->timestamp = GST_CLOCK_TIME_NONE;
+  fragment->duration = file->duration;
+
+  gst_m3u8_media_file_unref (file);
+
+  return GST_FLOW_OK;
+}
+
 static gboolean
 gst_hls_demux_select_bitrate (GstAdaptiveDemuxStream * stream, guint64 bitrate)
 {
@@ -1697,10 +1744,10 @@ retry:
     gint64 last_sequence, first_sequence;
 
     GST_M3U8_CLIENT_LOCK (demux->client);
-    last_sequence =
-        GST_M3U8_MEDIA_FILE (g_list_last (m3u8->files)->data)->sequence;
-    first_sequence =
-        GST_M3U8_MEDIA_FILE (g_list_first (m3u8->files)->data)->sequence;
+    last_sequence = GST_M3U8_MEDIA_FILE (((GList *)
+            g_ptr_array_index (m3u8->files_index,
+                m3u8->files_index->len - 1))->data)->sequence;
+    first_sequence = GST_M3U8_MEDIA_FILE (m3u8->files->data)->sequence;
 
     GST_DEBUG_OBJECT (demux,
         "sequence:%" G_GINT64_FORMAT " , first_sequence:%" G_GINT64_FORMAT
@@ -1742,7 +1789,8 @@ retry:
         GST_TIME_FORMAT " in updated playlist", GST_TIME_ARGS (target_pos));
 
     current_pos = 0;
-    for (walk = m3u8->files; walk; walk = walk->next) {
+    walk = gst_m3u8_find_file_by_position (m3u8, target_pos, &current_pos);
+    for (; walk; walk = walk->next) {
       GstM3U8MediaFile *file = walk->data;
 
       sequence = file->sequence;
@@ -50,6 +50,8 @@ gst_m3u8_new (void)
   m3u8->sequence_position = 0;
   m3u8->highest_sequence_number = -1;
   m3u8->duration = GST_CLOCK_TIME_NONE;
+  m3u8->files_index = g_ptr_array_new ();
+  m3u8->files_start = g_array_new (FALSE, FALSE, sizeof (GstClockTime));
 
   g_mutex_init (&m3u8->lock);
   m3u8->ref_count = 1;
@@ -108,6 +110,8 @@ gst_m3u8_unref (GstM3U8 * self)
 
     g_list_foreach (self->files, (GFunc) gst_m3u8_media_file_unref, NULL);
     g_list_free (self->files);
+    g_ptr_array_unref (self->files_index);
+    g_array_unref (self->files_start);
 
     g_free (self->last_data);
     g_mutex_clear (&self->lock);
@@ -346,6 +350,98 @@ gst_hls_variant_stream_compare_by_bitrate (gconstpointer a, gconstpointer b)
   return vs_a->bandwidth - vs_b->bandwidth;
 }
 
+/* call with M3U8_LOCK held.
+ * Returns the position in files_index of the first file with a sequence
+ * number equal or higher than @sequence. Sequence numbers are normally
+ * contiguous, so this is a direct lookup in most cases */
+static guint
+m3u8_index_lower_bound (GstM3U8 * self, gint64 sequence)
+{
+  GPtrArray *index = self->files_index;
+  GstM3U8MediaFile *file;
+  guint lo = 0, hi = index->len;
+  gint64 pos;
+
+  if (index->len == 0)
+    return 0;
+
+  file = GST_M3U8_MEDIA_FILE (((GList *) g_ptr_array_index (index, 0))->data);
+  pos = sequence - file->sequence;
+  if (pos <= 0)
+    return 0;
+  if (pos < index->len) {
+    file = ((GList *) g_ptr_array_index (index, pos))->data;
+    if (file->sequence == sequence)
+      return pos;
+  }
+
+  while (lo < hi) {
+    guint mid = lo + (hi - lo) / 2;
+
+    file = ((GList *) g_ptr_array_index (index, mid))->data;
+    if (file->sequence < sequence)
+      lo = mid + 1;
+    else
+      hi = mid;
+  }
+
+  return lo;
+}
+
+/* call with M3U8_LOCK held */
+static GList *
+m3u8_index_lookup (GstM3U8 * self, gint64 sequence)
+{
+  guint pos = m3u8_index_lower_bound (self, sequence);
+  GList *l;
+
+  if (pos >= self->files_index->len)
+    return NULL;
+
+  l = g_ptr_array_index (self->files_index, pos);
+  if (GST_M3U8_MEDIA_FILE (l->data)->sequence != sequence)
+    return NULL;
+
+  return l;
+}
+
+/* call with M3U8_LOCK held */
+static void
+m3u8_rebuild_index (GstM3U8 * self)
+{
+  GstClockTime start = 0;
+  GList *l;
+
+  g_ptr_array_set_size (self->files_index, 0);
+  g_array_set_size (self->files_start, 0);
+
+  for (l = self->files; l; l = l->next) {
+    g_ptr_array_add (self->files_index, l);
+    g_array_append_val (self->files_start, start);
+    start += GST_M3U8_MEDIA_FILE (l->data)->duration;
+  }
+}
+
+/* call with M3U8_LOCK held, while parsing an update of the playlist.
+ * Returns the file with @sequence if it was in the previous version of the
+ * playlist already, in which case its lines don't need to be parsed again.
+ * This is only possible if the playlist has a MEDIA-SEQUENCE, as the
+ * sequence numbers are generated from the URIs otherwise */
+static GstM3U8MediaFile *
+m3u8_find_parsed_file (GstM3U8 * self, GList * previous_files,
+    gboolean have_mediasequence, gint64 sequence)
+{
+  GList *l;
+
+  if (!previous_files || !have_mediasequence)
+    return NULL;
+
+  /* files_index still points into previous_files at this point */
+  l = m3u8_index_lookup (self, sequence);
+
+  return l ? l->data : NULL;
+}
+
 /* If we have MEDIA-SEQUENCE, ensure that it's consistent. If it is not,
  * the client SHOULD halt playback (6.3.4), which is what we do then. */
 static gboolean
@@ -395,7 +491,8 @@ check_media_seqnums (GstM3U8 * self, GList * previous_files)
     f1 = l->data;
     f2 = m->data;
 
-    if (f1->sequence == f2->sequence && !g_str_equal (f1->uri, f2->uri)) {
+    if (f1->sequence == f2->sequence && f1 != f2
+        && !g_str_equal (f1->uri, f2->uri)) {
       /* Same sequence, different URI. This is bad! */
       GST_ERROR ("Media URIs inconsistent (sequence %" G_GINT64_FORMAT
           "): had '%s', got '%s'", f1->sequence, f2->uri, f1->uri);
@@ -487,9 +584,10 @@ gboolean
 gst_m3u8_update (GstM3U8 * self, gchar * data)
 {
   gint val;
-  GstDateTime *program_dt = NULL;
   GstClockTime duration;
-  gchar *title, *end;
+  gchar *end;
+  /* Point into the playlist, only parsed for new fragments */
+  const gchar *title = NULL, *program_dt = NULL;
   gboolean discontinuity = FALSE;
   gchar *current_key = NULL;
   gboolean have_iv = FALSE;
@@ -499,6 +597,8 @@ gst_m3u8_update (GstM3U8 * self, gchar * data)
   GList *previous_files = NULL;
   gboolean have_mediasequence = FALSE;
   GstM3U8InitFile *last_init_file = NULL;
+  GstM3U8MediaFile *parsed_file;
+  guint n_reused = 0;
 
   g_return_val_if_fail (self != NULL, FALSE);
   g_return_val_if_fail (data != NULL, FALSE);
@@ -541,7 +641,6 @@ gst_m3u8_update (GstM3U8 * self, gchar * data)
   self->allowcache = TRUE;
 
   duration = 0;
-  title = NULL;
   data += 7;
   while (TRUE) {
     gchar *r;
@@ -555,60 +654,87 @@ gst_m3u8_update (GstM3U8 * self, gchar * data)
       *r = '\0';
 
     if (data[0] != '#' && data[0] != '\0') {
+      GstM3U8MediaFile *file;
+      GstDateTime *dt = NULL;
+
       if (duration <= 0) {
         GST_LOG ("%s: got line without EXTINF, dropping", data);
         goto next_line;
       }
 
       data = uri_join (self->base_uri ? self->base_uri : self->uri, data);
-      if (data != NULL) {
-        GstM3U8MediaFile *file;
-        file =
-            gst_m3u8_media_file_new (data, title, duration,
-            mediasequence++, program_dt);
-        program_dt = NULL;
-
-        /* set encryption params */
-        file->key = current_key ? g_strdup (current_key) : NULL;
-        if (file->key) {
-          if (have_iv) {
-            memcpy (file->iv, iv, sizeof (iv));
-          } else {
-            guint8 *iv = file->iv + 12;
-            GST_WRITE_UINT32_BE (iv, file->sequence);
-          }
+      if (data == NULL)
+        goto next_line;
+
+      /* Live playlists mostly repeat what we had already, keep the
+       * previously parsed files instead of creating them again. If the URI
+       * changed, parse it and let check_media_seqnums() report it */
+      parsed_file = m3u8_find_parsed_file (self, previous_files,
+          have_mediasequence, mediasequence);
+      if (parsed_file && g_str_equal (parsed_file->uri, data)) {
+        g_free (data);
+        mediasequence++;
+        n_reused++;
+
+        duration = 0;
+        title = program_dt = NULL;
+        discontinuity = FALSE;
+        size = offset = -1;
+        self->files = g_list_prepend (self->files,
+            gst_m3u8_media_file_ref (parsed_file));
+        goto next_line;
+      }
+
+      if (program_dt) {
+        dt = gst_date_time_new_from_iso8601_string (program_dt);
+        if (!dt) {
+          GST_WARNING ("Could not parse program date/time");
         }
+      }
 
-        if (size != -1) {
-          file->size = size;
-          if (offset != -1) {
-            file->offset = offset;
-          } else {
-            GstM3U8MediaFile *prev = self->files ? self->files->data : NULL;
+      file = gst_m3u8_media_file_new (data, g_strdup (title), duration,
+          mediasequence++, dt);
 
-            if (!prev) {
-              offset = 0;
-            } else {
-              offset = prev->offset + prev->size;
-            }
-            file->offset = offset;
-          }
+      /* set encryption params */
+      file->key = current_key ? g_strdup (current_key) : NULL;
+      if (file->key) {
+        if (have_iv) {
+          memcpy (file->iv, iv, sizeof (iv));
         } else {
-          file->size = -1;
-          file->offset = 0;
+          guint8 *iv = file->iv + 12;
+          GST_WRITE_UINT32_BE (iv, file->sequence);
         }
+      }
 
-        file->discont = discontinuity;
-        if (last_init_file)
-          file->init_file = gst_m3u8_init_file_ref (last_init_file);
+      if (size != -1) {
+        file->size = size;
+        if (offset != -1) {
+          file->offset = offset;
+        } else {
+          GstM3U8MediaFile *prev = self->files ? self->files->data : NULL;
 
-        duration = 0;
-        title = NULL;
-        discontinuity = FALSE;
-        size = offset = -1;
-        self->files = g_list_prepend (self->files, file);
+          if (!prev) {
+            offset = 0;
+          } else {
+            offset = prev->offset + prev->size;
+          }
+          file->offset = offset;
+        }
+      } else {
+        file->size = -1;
+        file->offset = 0;
       }
 
+      file->discont = discontinuity;
+      if (last_init_file)
+        file->init_file = gst_m3u8_init_file_ref (last_init_file);
+
+      duration = 0;
+      title = program_dt = NULL;
+      discontinuity = FALSE;
+      size = offset = -1;
+      self->files = g_list_prepend (self->files, file);
+
     } else if (g_str_has_prefix (data, "#EXTINF:")) {
       gdouble fval;
       if (!double_from_string (data + 8, &data, &fval)) {
@@ -624,10 +750,8 @@ gst_m3u8_update (GstM3U8 * self, gchar * data)
       if (!data || *data != ',')
         goto next_line;
       data = g_utf8_next_char (data);
-      if (data != end) {
-        g_free (title);
-        title = g_strdup (data);
-      }
+      if (data != end)
+        title = data;
     } else if (g_str_has_prefix (data, "#EXT-X-")) {
       gchar *data_ext_x = data + 7;
 
@@ -655,12 +779,7 @@ gst_m3u8_update (GstM3U8 * self, gchar * data)
         self->discont_sequence++;
         discontinuity = TRUE;
       } else if (g_str_has_prefix (data_ext_x, "PROGRAM-DATE-TIME:")) {
-        if (program_dt)
-          gst_date_time_unref (program_dt);
-        program_dt = gst_date_time_new_from_iso8601_string (data + 25);
-        if (!program_dt) {
-          GST_WARNING ("Could not parse program date/time");
-        }
+        program_dt = data + 25;
       } else if (g_str_has_prefix (data_ext_x, "ALLOW-CACHE:")) {
         self->allowcache = g_ascii_strcasecmp (data + 19, "YES") == 0;
       } else if (g_str_has_prefix (data_ext_x, "KEY:")) {
@@ -779,12 +898,10 @@ gst_m3u8_update (GstM3U8 * self, gchar * data)
   g_free (current_key);
   current_key = NULL;
 
-  if (program_dt) {
-    gst_date_time_unref (program_dt);
-    program_dt = NULL;
-  }
-
   self->files = g_list_reverse (self->files);
+  m3u8_rebuild_index (self);
+
+  GST_LOG ("reused %u already parsed fragments", n_reused);
 
   if (last_init_file)
     gst_m3u8_init_file_unref (last_init_file);
@@ -895,7 +1012,7 @@ gst_m3u8_update (GstM3U8 * self, gchar * data)
   }
 
   GST_LOG ("processed media playlist %s, %u fragments", self->name,
-      g_list_length (self->files));
+      self->files_index->len);
 
   GST_M3U8_UNLOCK (self);
 
@@ -906,32 +1023,20 @@ gst_m3u8_update (GstM3U8 * self, gchar * data)
 static GList *
 m3u8_find_next_fragment (GstM3U8 * m3u8, gboolean forward)
 {
-  GstM3U8MediaFile *file;
-  GList *l = m3u8->files;
-
-  if (forward) {
-    while (l) {
-      file = l->data;
+  guint pos = m3u8_index_lower_bound (m3u8, m3u8->sequence);
+  GList *l = NULL;
 
-      if (file->sequence >= m3u8->sequence)
-        break;
-
-      l = l->next;
-    }
-  } else {
-    l = g_list_last (l);
+  if (pos < m3u8->files_index->len)
+    l = g_ptr_array_index (m3u8->files_index, pos);
 
-    while (l) {
-      file = l->data;
-
-      if (file->sequence <= m3u8->sequence)
-        break;
+  if (forward)
+    return l;
 
-      l = l->prev;
-    }
-  }
+  /* last fragment with a sequence number lower or equal */
+  if (l && GST_M3U8_MEDIA_FILE (l->data)->sequence == m3u8->sequence)
+    return l;
 
-  return l;
+  return pos > 0 ? g_ptr_array_index (m3u8->files_index, pos - 1) : NULL;
 }
 
 GstM3U8MediaFile *
@@ -1007,13 +1112,41 @@ gst_m3u8_has_next_fragment (GstM3U8 * m3u8, gboolean forward)
   return have_next;
 }
 
+/* Returns the fragment @n positions after the current one in the playback
+ * direction, without moving the current position */
+GstM3U8MediaFile *
+gst_m3u8_peek_fragment (GstM3U8 * m3u8, gboolean forward, guint n)
+{
+  GstM3U8MediaFile *file = NULL;
+  GList *l;
+
+  g_return_val_if_fail (m3u8 != NULL, NULL);
+
+  GST_M3U8_LOCK (m3u8);
+
+  l = m3u8->current_file;
+  if (l == NULL)
+    l = m3u8_find_next_fragment (m3u8, forward);
+
+  while (l && n > 0) {
+    l = forward ? l->next : l->prev;
+    n--;
+  }
+
+  if (l)
+    file = gst_m3u8_media_file_ref (l->data);
+
+  GST_M3U8_UNLOCK (m3u8);
+
+  return file;
+}
+
 /* call with M3U8_LOCK held */
 static void
 m3u8_alternate_advance (GstM3U8 * m3u8, gboolean forward)
 {
   gint targetnum = m3u8->sequence;
   GList *tmp;
-  GstM3U8MediaFile *mf;
 
   /* figure out the target seqnum */
   if (forward)
@@ -1021,11 +1154,7 @@ m3u8_alternate_advance (GstM3U8 * m3u8, gboolean forward)
   else
     targetnum -= 1;
 
-  for (tmp = m3u8->files; tmp; tmp = tmp->next) {
-    mf = (GstM3U8MediaFile *) tmp->data;
-    if (mf->sequence == targetnum)
-      break;
-  }
+  tmp = m3u8_index_lookup (m3u8, targetnum);
   if (tmp == NULL) {
     GST_WARNING ("Can't find next fragment");
     return;
@@ -1059,15 +1188,8 @@ gst_m3u8_advance_fragment (GstM3U8 * m3u8, gboolean forward)
         GST_TIME_ARGS (m3u8->sequence_position));
   }
   if (!m3u8->current_file) {
-    GList *l;
-
     GST_DEBUG ("Looking for fragment %" G_GINT64_FORMAT, m3u8->sequence);
-    for (l = m3u8->files; l != NULL; l = l->next) {
-      if (GST_M3U8_MEDIA_FILE (l->data)->sequence == m3u8->sequence) {
-        m3u8->current_file = l;
-        break;
-      }
-    }
+    m3u8->current_file = m3u8_index_lookup (m3u8, m3u8->sequence);
     if (m3u8->current_file == NULL) {
       GST_DEBUG
           ("Could not find current fragment, trying next fragment directly");
@@ -1078,8 +1200,9 @@ gst_m3u8_advance_fragment (GstM3U8 * m3u8, gboolean forward)
         /* for live streams, start GST_M3U8_LIVE_MIN_FRAGMENT_DISTANCE from
            the end of the playlist. See section 6.3.3 of HLS draft */
         gint pos =
-            g_list_length (m3u8->files) - GST_M3U8_LIVE_MIN_FRAGMENT_DISTANCE;
-        m3u8->current_file = g_list_nth (m3u8->files, pos >= 0 ? pos : 0);
+            (gint) m3u8->files_index->len - GST_M3U8_LIVE_MIN_FRAGMENT_DISTANCE;
+        m3u8->current_file =
+            g_ptr_array_index (m3u8->files_index, pos >= 0 ? pos : 0);
         m3u8->current_file_duration =
             GST_M3U8_MEDIA_FILE (m3u8->current_file->data)->duration;
 
@@ -1118,6 +1241,39 @@ out:
   GST_M3U8_UNLOCK (m3u8);
 }
 
+/* Must be called with the M3U8 lock held, or while the playlist can't be
+ * updated otherwise, like when accessing the files list directly.
+ *
+ * Returns the last file starting at or before @position, relative to the
+ * start of the first file of the playlist, or NULL if the playlist is
+ * empty. @file_start is set to the start of the returned file */
+GList *
+gst_m3u8_find_file_by_position (GstM3U8 * m3u8, GstClockTime position,
+    GstClockTime * file_start)
+{
+  guint lo = 0, hi;
+
+  g_return_val_if_fail (m3u8 != NULL, NULL);
+
+  hi = m3u8->files_start->len;
+  if (hi == 0)
+    return NULL;
+
+  while (hi - lo > 1) {
+    guint mid = lo + (hi - lo) / 2;
+
+    if (g_array_index (m3u8->files_start, GstClockTime, mid) <= position)
+      lo = mid;
+    else
+      hi = mid;
+  }
+
+  if (file_start)
+    *file_start = g_array_index (m3u8->files_start, GstClockTime, lo);
+
+  return g_ptr_array_index (m3u8->files_index, lo);
+}
+
 GstClockTime
 gst_m3u8_get_duration (GstM3U8 * m3u8)
 {
@@ -1265,7 +1421,7 @@ gst_m3u8_get_seek_range (GstM3U8 * m3u8, gint64 * start, gint64 * stop)
        playlist - see 6.3.3. "Playing the Playlist file" of the HLS draft */
     min_distance = GST_M3U8_LIVE_MIN_FRAGMENT_DISTANCE;
   }
-  count = g_list_length (m3u8->files);
+  count = m3u8->files_index->len;
 
   for (walk = m3u8->files; walk && count > min_distance; walk = walk->next) {
     file = walk->data;
@@ -65,6 +65,8 @@ struct _GstM3U8
   gboolean allowcache;          /* last EXT-X-ALLOWCACHE */
 
   GList *files;
+  GPtrArray *files_index;       /* links of files, by position in the playlist */
+  GArray *files_start;          /* start of each file relative to the first one */
 
   /* state */
   GList *current_file;
@@ -134,9 +136,17 @@ GstM3U8MediaFile * gst_m3u8_get_next_fragment    (GstM3U8      * m3u8,
 gboolean           gst_m3u8_has_next_fragment    (GstM3U8 * m3u8,
                                                   gboolean  forward);
 
+GstM3U8MediaFile * gst_m3u8_peek_fragment        (GstM3U8 * m3u8,
+                                                  gboolean  forward,
+                                                  guint     n);
+
 void               gst_m3u8_advance_fragment     (GstM3U8 * m3u8,
                                                   gboolean  forward);
 
+GList *            gst_m3u8_find_file_by_position (GstM3U8      * m3u8,
+                                                   GstClockTime   position,
+                                                   GstClockTime * file_start);
+
 GstClockTime       gst_m3u8_get_duration         (GstM3U8 * m3u8);
 
 GstClockTime       gst_m3u8_get_target_duration  (GstM3U8 * m3u8);
@@ -53,6 +53,8 @@ GST_STATIC_PAD_TEMPLATE ("src_%u", GST_PAD_SRC,
 enum
 {
   SIGNAL_RESET_STREAM,
+  SIGNAL_NEW_MESSAGE,
+  SIGNAL_STREAM_RESET,
   NUM_SIGNALS
 };
 
@@ -64,6 +66,8 @@ enum
 
   PROP_GST_SCTP_ASSOCIATION_ID,
   PROP_LOCAL_SCTP_PORT,
+  PROP_EMIT_MESSAGES,
+  PROP_SHARED_WORKER,
 
   NUM_PROPERTIES
 };
@@ -72,6 +76,8 @@ static GParamSpec *properties[NUM_PROPERTIES];
 
 #define DEFAULT_GST_SCTP_ASSOCIATION_ID 1
 #define DEFAULT_LOCAL_SCTP_PORT 0
+#define DEFAULT_EMIT_MESSAGES FALSE
+#define DEFAULT_SHARED_WORKER FALSE
 #define MAX_SCTP_PORT 65535
 #define MAX_GST_SCTP_ASSOCIATION_ID 65535
 #define MAX_STREAM_ID 65535
@@ -92,16 +98,21 @@ struct _GstSctpDecPad
   GstPad parent;
 
   GstDataQueue *packet_queue;
+  GstSctpBatch packet_batch;
 };
 
 G_DEFINE_TYPE (GstSctpDecPad, gst_sctp_dec_pad, GST_TYPE_PAD);
 
+static GstFlowReturn gst_sctp_dec_pad_push_packets (GstPad * pad,
+    GstBufferList * list);
+
 static void
 gst_sctp_dec_pad_finalize (GObject * object)
 {
   GstSctpDecPad *self = GST_SCTP_DEC_PAD (object);
 
   gst_object_unref (self->packet_queue);
+  gst_sctp_batch_clear (&self->packet_batch);
 
   G_OBJECT_CLASS (gst_sctp_dec_pad_parent_class)->finalize (object);
 }
@@ -139,6 +150,8 @@ gst_sctp_dec_pad_init (GstSctpDecPad * self)
 {
   self->packet_queue = gst_data_queue_new (data_queue_check_full_cb,
       data_queue_full_cb, data_queue_empty_cb, NULL);
+  gst_sctp_batch_init (&self->packet_batch, GST_OBJECT (self),
+      (GstSctpBatchPushFunc) gst_sctp_dec_pad_push_packets);
 }
 
 static void gst_sctp_dec_set_property (GObject * object, guint prop_id,
@@ -208,6 +221,42 @@ gst_sctp_dec_class_init (GstSctpDecClass * klass)
       0, MAX_SCTP_PORT, DEFAULT_LOCAL_SCTP_PORT,
       G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS);
 
+  /**
+   * GstSctpDec:emit-messages:
+   *
+   * Emit received messages with the #GstSctpDec::new-message signal and
+   * stream resets with the #GstSctpDec::stream-reset signal instead of
+   * pushing them on a source pad per stream. This avoids a pad, a queue
+   * and a streaming thread per stream for applications that handle the
+   * messages themselves.
+   *
+   * Since: 1.24
+   */
+  properties[PROP_EMIT_MESSAGES] =
+      g_param_spec_boolean ("emit-messages",
+      "Emit messages",
+      "Emit received messages as signals instead of pushing them on source pads",
+      DEFAULT_EMIT_MESSAGES,
+      G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS);
+
+  /**
+   * GstSctpDec:shared-worker:
+   *
+   * Push the received messages from a worker pool that is shared by all
+   * SCTP elements instead of a streaming thread per source pad. All
+   * messages that a stream received since the last wakeup of the worker are
+   * pushed as one buffer list.
+   *
+   * Since: 1.24
+   */
+  properties[PROP_SHARED_WORKER] =
+      g_param_spec_boolean ("shared-worker",
+      "Shared worker",
+      "Push messages as buffer lists from a worker pool shared by all SCTP "
+      "elements instead of a streaming thread per source pad",
+      DEFAULT_SHARED_WORKER,
+      G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS | GST_PARAM_MUTABLE_READY);
+
   g_object_class_install_properties (gobject_class, NUM_PROPERTIES, properties);
 
   signals[SIGNAL_RESET_STREAM] = g_signal_new ("reset-stream",
@@ -215,6 +264,36 @@ gst_sctp_dec_class_init (GstSctpDecClass * klass)
       G_STRUCT_OFFSET (GstSctpDecClass, on_reset_stream), NULL, NULL,
       NULL, G_TYPE_NONE, 1, G_TYPE_UINT);
 
+  /**
+   * GstSctpDec::new-message:
+   * @sctpdec: the #GstSctpDec
+   * @stream_id: the SCTP stream the message was received on
+   * @ppid: the payload protocol identifier of the message
+   * @data: the message
+   *
+   * Emitted from the SCTP stack's thread for each received message when
+   * #GstSctpDec:emit-messages is enabled. Handlers must not block.
+   *
+   * Since: 1.24
+   */
+  signals[SIGNAL_NEW_MESSAGE] = g_signal_new ("new-message",
+      G_TYPE_FROM_CLASS (gobject_class), G_SIGNAL_RUN_LAST, 0, NULL, NULL,
+      NULL, G_TYPE_NONE, 3, G_TYPE_UINT, G_TYPE_UINT, G_TYPE_BYTES);
+
+  /**
+   * GstSctpDec::stream-reset:
+   * @sctpdec: the #GstSctpDec
+   * @stream_id: the SCTP stream that was reset
+   *
+   * Emitted when the peer resets a stream and #GstSctpDec:emit-messages is
+   * enabled. Without it, the source pad of the stream is removed instead.
+   *
+   * Since: 1.24
+   */
+  signals[SIGNAL_STREAM_RESET] = g_signal_new ("stream-reset",
+      G_TYPE_FROM_CLASS (gobject_class), G_SIGNAL_RUN_LAST, 0, NULL, NULL,
+      NULL, G_TYPE_NONE, 1, G_TYPE_UINT);
+
   gst_element_class_set_static_metadata (element_class,
       "SCTP Decoder",
       "Decoder/Network/SCTP",
@@ -227,6 +306,8 @@ gst_sctp_dec_init (GstSctpDec * self)
 {
   self->sctp_association_id = DEFAULT_GST_SCTP_ASSOCIATION_ID;
   self->local_sctp_port = DEFAULT_LOCAL_SCTP_PORT;
+  self->emit_messages = DEFAULT_EMIT_MESSAGES;
+  self->shared_worker = DEFAULT_SHARED_WORKER;
 
   self->flow_combiner = gst_flow_combiner_new ();
 
@@ -252,6 +333,14 @@ gst_sctp_dec_set_property (GObject * object, guint prop_id,
     case PROP_LOCAL_SCTP_PORT:
       self->local_sctp_port = g_value_get_uint (value);
       break;
+    case PROP_EMIT_MESSAGES:
+      GST_OBJECT_LOCK (self);
+      self->emit_messages = g_value_get_boolean (value);
+      GST_OBJECT_UNLOCK (self);
+      break;
+    case PROP_SHARED_WORKER:
+      self->shared_worker = g_value_get_boolean (value);
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (self, prop_id, pspec);
       break;
@@ -271,6 +360,14 @@ gst_sctp_dec_get_property (GObject * object, guint prop_id, GValue * value,
     case PROP_LOCAL_SCTP_PORT:
       g_value_set_uint (value, self->local_sctp_port);
       break;
+    case PROP_EMIT_MESSAGES:
+      GST_OBJECT_LOCK (self);
+      g_value_set_boolean (value, self->emit_messages);
+      GST_OBJECT_UNLOCK (self);
+      break;
+    case PROP_SHARED_WORKER:
+      g_value_set_boolean (value, self->shared_worker);
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (self, prop_id, pspec);
       break;
@@ -354,12 +451,12 @@ gst_sctp_dec_packet_chain (GstPad * pad, GstSctpDec * self, GstBuffer * buf)
 }
 
 static void
-flush_srcpad (const GValue * item, gpointer user_data)
+set_srcpad_flushing (GstSctpDec * self, GstSctpDecPad * sctpdec_pad,
+    gboolean flush)
 {
-  GstSctpDecPad *sctpdec_pad = g_value_get_object (item);
-  gboolean flush = GPOINTER_TO_INT (user_data);
-
-  if (flush) {
+  if (self->shared_worker) {
+    gst_sctp_batch_set_flushing (&sctpdec_pad->packet_batch, flush);
+  } else if (flush) {
     gst_data_queue_set_flushing (sctpdec_pad->packet_queue, TRUE);
     gst_data_queue_flush (sctpdec_pad->packet_queue);
   } else {
@@ -369,6 +466,16 @@ flush_srcpad (const GValue * item, gpointer user_data)
   }
 }
 
+static void
+flush_srcpad (const GValue * item, gpointer user_data)
+{
+  GstSctpDecPad *sctpdec_pad = g_value_get_object (item);
+  gboolean flush = GPOINTER_TO_INT (user_data);
+  GstSctpDec *self = GST_SCTP_DEC (GST_PAD_PARENT (sctpdec_pad));
+
+  set_srcpad_flushing (self, sctpdec_pad, flush);
+}
+
 static gboolean
 gst_sctp_dec_packet_event (GstPad * pad, GstSctpDec * self, GstEvent * event)
 {
@@ -463,6 +570,42 @@ gst_sctp_data_srcpad_loop (GstPad * pad)
   gst_object_unref (self);
 }
 
+/* Called from the shared worker pool instead of the srcpad loop */
+static GstFlowReturn
+gst_sctp_dec_pad_push_packets (GstPad * pad, GstBufferList * list)
+{
+  GstSctpDec *self;
+  GstFlowReturn flow_ret;
+
+  self = GST_SCTP_DEC (gst_pad_get_parent (pad));
+  if (!self) {
+    gst_buffer_list_unref (list);
+    return GST_FLOW_FLUSHING;
+  }
+
+  GST_DEBUG_OBJECT (pad, "Forwarding %u buffers",
+      gst_buffer_list_length (list));
+
+  flow_ret = gst_pad_push_list (pad, list);
+
+  GST_OBJECT_LOCK (self);
+  gst_flow_combiner_update_pad_flow (self->flow_combiner, pad, flow_ret);
+  GST_OBJECT_UNLOCK (self);
+
+  if (G_UNLIKELY (flow_ret == GST_FLOW_FLUSHING
+          || flow_ret == GST_FLOW_NOT_LINKED) || flow_ret == GST_FLOW_EOS) {
+    GST_DEBUG_OBJECT (pad, "Push failed on packet source pad. Error: %s",
+        gst_flow_get_name (flow_ret));
+  } else if (G_UNLIKELY (flow_ret != GST_FLOW_OK)) {
+    GST_ERROR_OBJECT (pad, "Push failed on packet source pad. Error: %s",
+        gst_flow_get_name (flow_ret));
+  }
+
+  gst_object_unref (self);
+
+  return flow_ret;
+}
+
 static gboolean
 configure_association (GstSctpDec * self)
 {
@@ -501,20 +644,13 @@ gst_sctp_dec_src_event (GstPad * pad, GstSctpDec * self, GstEvent * event)
   switch (GST_EVENT_TYPE (event)) {
     case GST_EVENT_RECONFIGURE:
     case GST_EVENT_FLUSH_STOP:{
-      GstSctpDecPad *sctpdec_pad = GST_SCTP_DEC_PAD (pad);
-
       /* Unflush and start task again */
-      gst_data_queue_set_flushing (sctpdec_pad->packet_queue, FALSE);
-      gst_pad_start_task (pad, (GstTaskFunction) gst_sctp_data_srcpad_loop, pad,
-          NULL);
+      set_srcpad_flushing (self, GST_SCTP_DEC_PAD (pad), FALSE);
 
       return gst_pad_event_default (pad, GST_OBJECT (self), event);
     }
     case GST_EVENT_FLUSH_START:{
-      GstSctpDecPad *sctpdec_pad = GST_SCTP_DEC_PAD (pad);
-
-      gst_data_queue_set_flushing (sctpdec_pad->packet_queue, TRUE);
-      gst_data_queue_flush (sctpdec_pad->packet_queue);
+      set_srcpad_flushing (self, GST_SCTP_DEC_PAD (pad), TRUE);
 
       return gst_pad_event_default (pad, GST_OBJECT (self), event);
     }
@@ -589,8 +725,12 @@ get_pad_for_stream_id (GstSctpDec * self, guint16 stream_id)
   gst_flow_combiner_add_pad (self->flow_combiner, new_pad);
   GST_OBJECT_UNLOCK (self);
 
-  gst_pad_start_task (new_pad, (GstTaskFunction) gst_sctp_data_srcpad_loop,
-      new_pad, NULL);
+  if (self->shared_worker)
+    gst_sctp_batch_set_flushing (&GST_SCTP_DEC_PAD (new_pad)->packet_batch,
+        FALSE);
+  else
+    gst_pad_start_task (new_pad, (GstTaskFunction) gst_sctp_data_srcpad_loop,
+        new_pad, NULL);
 
   gst_object_ref (new_pad);
 
@@ -622,9 +762,19 @@ on_gst_sctp_association_stream_reset (GstSctpAssociation * gst_sctp_association,
 {
   gchar *pad_name;
   GstPad *srcpad;
+  gboolean emit_messages;
 
   GST_DEBUG_OBJECT (self, "Stream %u reset", stream_id);
 
+  GST_OBJECT_LOCK (self);
+  emit_messages = self->emit_messages;
+  GST_OBJECT_UNLOCK (self);
+
+  if (emit_messages) {
+    g_signal_emit (self, signals[SIGNAL_STREAM_RESET], 0, (guint) stream_id);
+    return;
+  }
+
   pad_name = g_strdup_printf ("src_%hu", stream_id);
   srcpad = gst_element_get_static_pad (GST_ELEMENT (self), pad_name);
   g_free (pad_name);
@@ -659,6 +809,27 @@ on_receive (GstSctpAssociation * sctp_association, guint8 * buf,
   GstPad *src_pad;
   GstDataQueueItem *item;
   GstBuffer *gstbuf;
+  gboolean emit_messages;
+
+  GST_OBJECT_LOCK (self);
+  emit_messages = self->emit_messages;
+  GST_OBJECT_UNLOCK (self);
+
+  if (emit_messages) {
+    GBytes *bytes;
+
+    GST_LOG_OBJECT (self,
+        "Received incoming message of size %" G_GSIZE_FORMAT
+        " with stream id %u ppid %u", length, stream_id, ppid);
+
+    /* Hand out the usrsctp buffer without copying it */
+    bytes = g_bytes_new_with_free_func (buf, length,
+        (GDestroyNotify) usrsctp_freedumpbuffer, buf);
+    g_signal_emit (self, signals[SIGNAL_NEW_MESSAGE], 0, (guint) stream_id,
+        ppid, bytes);
+    g_bytes_unref (bytes);
+    return;
+  }
 
   src_pad = get_pad_for_stream_id (self, stream_id);
   g_assert (src_pad);
@@ -673,6 +844,12 @@ on_receive (GstSctpAssociation * sctp_association, guint8 * buf,
       (GDestroyNotify) usrsctp_freedumpbuffer);
   gst_sctp_buffer_add_receive_meta (gstbuf, ppid);
 
+  if (self->shared_worker) {
+    gst_sctp_batch_add (&sctpdec_pad->packet_batch, gstbuf);
+    gst_object_unref (src_pad);
+    return;
+  }
+
   item = g_new0 (GstDataQueueItem, 1);
   item->object = GST_MINI_OBJECT (gstbuf);
   item->size = length;
@@ -691,6 +868,7 @@ stop_srcpad_task (GstPad * pad)
 {
   GstSctpDecPad *sctpdec_pad = GST_SCTP_DEC_PAD (pad);
 
+  gst_sctp_batch_stop (&sctpdec_pad->packet_batch);
   gst_data_queue_set_flushing (sctpdec_pad->packet_queue, TRUE);
   gst_data_queue_flush (sctpdec_pad->packet_queue);
   gst_pad_stop_task (pad);
@@ -50,6 +50,8 @@ struct _GstSctpDec
   GstPad *sink_pad;
   guint sctp_association_id;
   guint local_sctp_port;
+  gboolean emit_messages;
+  gboolean shared_worker;
 
   GstSctpAssociation *sctp_association;
   gulong signal_handler_stream_reset;
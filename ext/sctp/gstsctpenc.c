@@ -51,6 +51,7 @@ enum
 {
   SIGNAL_SCTP_ASSOCIATION_ESTABLISHED,
   SIGNAL_GET_STREAM_BYTES_SENT,
+  SIGNAL_SEND_BUFFER_LIST,
   NUM_SIGNALS
 };
 
@@ -63,6 +64,7 @@ enum
   PROP_GST_SCTP_ASSOCIATION_ID,
   PROP_REMOTE_SCTP_PORT,
   PROP_USE_SOCK_STREAM,
+  PROP_SHARED_WORKER,
 
   NUM_PROPERTIES
 };
@@ -74,6 +76,7 @@ static GParamSpec *properties[NUM_PROPERTIES];
 #define DEFAULT_GST_SCTP_ORDERED TRUE
 #define DEFAULT_SCTP_PPID 1
 #define DEFAULT_USE_SOCK_STREAM FALSE
+#define DEFAULT_SHARED_WORKER FALSE
 
 #define BUFFER_FULL_SLEEP_TIME 100000
 
@@ -147,6 +150,9 @@ static GstPad *gst_sctp_enc_request_new_pad (GstElement * element,
     GstPadTemplate * template, const gchar * name, const GstCaps * caps);
 static void gst_sctp_enc_release_pad (GstElement * element, GstPad * pad);
 static void gst_sctp_enc_srcpad_loop (GstPad * pad);
+static GstSctpAssociation *gst_sctp_enc_get_association (GstSctpEnc * self);
+static GstFlowReturn gst_sctp_enc_push_packets (GstSctpEnc * self,
+    GstBufferList * list);
 static GstFlowReturn gst_sctp_enc_sink_chain (GstPad * pad, GstObject * parent,
     GstBuffer * buffer);
 static gboolean gst_sctp_enc_sink_event (GstPad * pad, GstObject * parent,
@@ -165,6 +171,8 @@ static void get_config_from_caps (const GstCaps * caps, gboolean * ordered,
     GstSctpAssociationPartialReliability * reliability,
     guint32 * reliability_param, guint32 * ppid, gboolean * ppid_available);
 static guint64 on_get_stream_bytes_sent (GstSctpEnc * self, guint stream_id);
+static GstFlowReturn on_send_buffer_list (GstSctpEnc * self, guint stream_id,
+    GstBufferList * list, gboolean more);
 
 static void
 gst_sctp_enc_class_init (GstSctpEncClass * klass)
@@ -215,6 +223,24 @@ gst_sctp_enc_class_init (GstSctpEncClass * klass)
       "When TRUE the partial reliability parameters of the channel are ignored.",
       DEFAULT_USE_SOCK_STREAM, G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS);
 
+  /**
+   * GstSctpEnc:shared-worker:
+   *
+   * Push the outgoing SCTP packets from a worker pool that is shared by all
+   * SCTP elements instead of a streaming thread per element. All packets
+   * that the association produced since the last wakeup of the worker are
+   * pushed as one buffer list.
+   *
+   * Since: 1.24
+   */
+  properties[PROP_SHARED_WORKER] =
+      g_param_spec_boolean ("shared-worker",
+      "Shared worker",
+      "Push packets as buffer lists from a worker pool shared by all SCTP "
+      "elements instead of a streaming thread per element",
+      DEFAULT_SHARED_WORKER,
+      G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS | GST_PARAM_MUTABLE_READY);
+
   g_object_class_install_properties (gobject_class, NUM_PROPERTIES, properties);
 
   signals[SIGNAL_SCTP_ASSOCIATION_ESTABLISHED] =
@@ -228,8 +254,32 @@ gst_sctp_enc_class_init (GstSctpEncClass * klass)
       G_STRUCT_OFFSET (GstSctpEncClass, on_get_stream_bytes_sent), NULL, NULL,
       NULL, G_TYPE_UINT64, 1, G_TYPE_UINT);
 
+  /**
+   * GstSctpEnc::send-buffer-list:
+   * @sctpenc: the #GstSctpEnc
+   * @stream_id: the SCTP stream to send on
+   * @list: the messages to send, one per buffer, configured like buffers
+   *     arriving on the sink pad of the stream
+   * @more: %TRUE if more messages are going to be sent right after
+   *
+   * Sends messages on an SCTP stream from the calling thread, bypassing the
+   * sink pad of the stream. The sink pad must have been requested before.
+   * Small messages of the list are bundled into as few packets as possible,
+   * and with @more they can also be bundled with the ones of the next call.
+   *
+   * Returns: the #GstFlowReturn of sending the messages
+   *
+   * Since: 1.24
+   */
+  signals[SIGNAL_SEND_BUFFER_LIST] = g_signal_new ("send-buffer-list",
+      G_TYPE_FROM_CLASS (gobject_class), G_SIGNAL_RUN_LAST | G_SIGNAL_ACTION,
+      G_STRUCT_OFFSET (GstSctpEncClass, send_buffer_list), NULL, NULL,
+      NULL, GST_TYPE_FLOW_RETURN, 3, G_TYPE_UINT, GST_TYPE_BUFFER_LIST,
+      G_TYPE_BOOLEAN);
+
   klass->on_get_stream_bytes_sent =
       GST_DEBUG_FUNCPTR (on_get_stream_bytes_sent);
+  klass->send_buffer_list = GST_DEBUG_FUNCPTR (on_send_buffer_list);
 
   gst_element_class_set_static_metadata (element_class,
       "SCTP Encoder",
@@ -261,11 +311,14 @@ gst_sctp_enc_init (GstSctpEnc * self)
 {
   self->sctp_association_id = DEFAULT_GST_SCTP_ASSOCIATION_ID;
   self->remote_sctp_port = DEFAULT_REMOTE_SCTP_PORT;
+  self->shared_worker = DEFAULT_SHARED_WORKER;
 
   self->sctp_association = NULL;
   self->outbound_sctp_packet_queue =
       gst_data_queue_new (data_queue_check_full_cb, data_queue_full_cb,
       data_queue_empty_cb, NULL);
+  gst_sctp_batch_init (&self->packet_batch, GST_OBJECT (self),
+      (GstSctpBatchPushFunc) gst_sctp_enc_push_packets);
 
   self->src_pad = gst_pad_new_from_static_template (&src_template, "src");
   gst_pad_set_event_function (self->src_pad,
@@ -283,6 +336,7 @@ gst_sctp_enc_finalize (GObject * object)
 
   g_queue_clear (&self->pending_pads);
   gst_object_unref (self->outbound_sctp_packet_queue);
+  gst_sctp_batch_clear (&self->packet_batch);
 
   G_OBJECT_CLASS (parent_class)->finalize (object);
 }
@@ -303,6 +357,9 @@ gst_sctp_enc_set_property (GObject * object, guint prop_id,
     case PROP_USE_SOCK_STREAM:
       self->use_sock_stream = g_value_get_boolean (value);
       break;
+    case PROP_SHARED_WORKER:
+      self->shared_worker = g_value_get_boolean (value);
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (self, prop_id, pspec);
       break;
@@ -325,6 +382,9 @@ gst_sctp_enc_get_property (GObject * object, guint prop_id, GValue * value,
     case PROP_USE_SOCK_STREAM:
       g_value_set_boolean (value, self->use_sock_stream);
       break;
+    case PROP_SHARED_WORKER:
+      g_value_set_boolean (value, self->shared_worker);
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (self, prop_id, pspec);
       break;
@@ -372,7 +432,10 @@ gst_sctp_enc_change_state (GstElement * element, GstStateChange transition)
     case GST_STATE_CHANGE_READY_TO_PAUSED:
       self->need_segment = self->need_stream_start_caps = TRUE;
       self->src_ret = GST_FLOW_OK;
-      gst_data_queue_set_flushing (self->outbound_sctp_packet_queue, FALSE);
+      if (self->shared_worker)
+        gst_sctp_batch_set_flushing (&self->packet_batch, FALSE);
+      else
+        gst_data_queue_set_flushing (self->outbound_sctp_packet_queue, FALSE);
       res = configure_association (self);
       break;
     case GST_STATE_CHANGE_PLAYING_TO_PAUSED:
@@ -395,8 +458,9 @@ gst_sctp_enc_change_state (GstElement * element, GstStateChange transition)
     case GST_STATE_CHANGE_NULL_TO_READY:
       break;
     case GST_STATE_CHANGE_READY_TO_PAUSED:
-      gst_pad_start_task (self->src_pad,
-          (GstTaskFunction) gst_sctp_enc_srcpad_loop, self->src_pad, NULL);
+      if (!self->shared_worker)
+        gst_pad_start_task (self->src_pad,
+            (GstTaskFunction) gst_sctp_enc_srcpad_loop, self->src_pad, NULL);
       break;
     case GST_STATE_CHANGE_PLAYING_TO_PAUSED:
       break;
@@ -498,6 +562,7 @@ static void
 gst_sctp_enc_release_pad (GstElement * element, GstPad * pad)
 {
   GstSctpEncPad *sctpenc_pad = GST_SCTP_ENC_PAD (pad);
+  GstSctpAssociation *association;
   GstSctpEnc *self;
   guint stream_id = 0;
 
@@ -511,8 +576,11 @@ gst_sctp_enc_release_pad (GstElement * element, GstPad * pad)
   stream_id = sctpenc_pad->stream_id;
   gst_pad_set_active (pad, FALSE);
 
-  if (self->sctp_association)
-    gst_sctp_association_reset_stream (self->sctp_association, stream_id);
+  association = gst_sctp_enc_get_association (self);
+  if (association) {
+    gst_sctp_association_reset_stream (association, stream_id);
+    g_object_unref (association);
+  }
 
   GST_PAD_STREAM_LOCK (pad);
   if (gst_object_has_as_parent (GST_OBJECT (pad), GST_OBJECT (element)))
@@ -521,12 +589,8 @@ gst_sctp_enc_release_pad (GstElement * element, GstPad * pad)
 }
 
 static void
-gst_sctp_enc_srcpad_loop (GstPad * pad)
+gst_sctp_enc_push_sticky_events (GstSctpEnc * self)
 {
-  GstSctpEnc *self = GST_SCTP_ENC (GST_PAD_PARENT (pad));
-  GstFlowReturn flow_ret;
-  GstDataQueueItem *item;
-
   if (self->need_stream_start_caps) {
     gchar s_id[32];
     GstCaps *caps;
@@ -549,6 +613,16 @@ gst_sctp_enc_srcpad_loop (GstPad * pad)
 
     self->need_segment = FALSE;
   }
+}
+
+static void
+gst_sctp_enc_srcpad_loop (GstPad * pad)
+{
+  GstSctpEnc *self = GST_SCTP_ENC (GST_PAD_PARENT (pad));
+  GstFlowReturn flow_ret;
+  GstDataQueueItem *item;
+
+  gst_sctp_enc_push_sticky_events (self);
 
   if (gst_data_queue_pop (self->outbound_sctp_packet_queue, &item)) {
     GstBuffer *buffer = GST_BUFFER (item->object);
@@ -589,78 +663,75 @@ gst_sctp_enc_srcpad_loop (GstPad * pad)
   }
 }
 
+/* Called from the shared worker pool instead of the srcpad loop */
 static GstFlowReturn
-gst_sctp_enc_sink_chain (GstPad * pad, GstObject * parent, GstBuffer * buffer)
+gst_sctp_enc_push_packets (GstSctpEnc * self, GstBufferList * list)
 {
-  GstSctpEnc *self = GST_SCTP_ENC (parent);
-  GstSctpEncPad *sctpenc_pad = GST_SCTP_ENC_PAD (pad);
-  GstSctpEncPad *sctpenc_pad_next = NULL;
-  GstMapInfo map;
-  guint32 ppid;
-  gboolean ordered;
-  GstSctpAssociationPartialReliability pr;
-  guint32 pr_param;
-  gpointer state = NULL;
-  GstMeta *meta;
-  const GstMetaInfo *meta_info = GST_SCTP_SEND_META_INFO;
-  GstFlowReturn flow_ret = GST_FLOW_ERROR;
-  const guint8 *data;
-  guint32 length;
-  gboolean clear_to_send;
+  GstFlowReturn flow_ret;
+
+  gst_sctp_enc_push_sticky_events (self);
+
+  GST_DEBUG_OBJECT (self, "Forwarding %u packets",
+      gst_buffer_list_length (list));
+
+  flow_ret = gst_pad_push_list (self->src_pad, list);
 
   GST_OBJECT_LOCK (self);
-  if (self->src_ret != GST_FLOW_OK) {
-    GST_ERROR_OBJECT (pad, "Pushing on source pad failed before: %s",
-        gst_flow_get_name (self->src_ret));
-    flow_ret = self->src_ret;
-    GST_OBJECT_UNLOCK (self);
-    gst_buffer_unref (buffer);
-    return flow_ret;
-  }
+  self->src_ret = flow_ret;
   GST_OBJECT_UNLOCK (self);
 
-  ppid = sctpenc_pad->ppid;
-  ordered = sctpenc_pad->ordered;
-  pr = sctpenc_pad->reliability;
-  pr_param = sctpenc_pad->reliability_param;
-
-  while ((meta = gst_buffer_iterate_meta (buffer, &state))) {
-    if (meta->info->api == meta_info->api) {
-      GstSctpSendMeta *sctp_send_meta = (GstSctpSendMeta *) meta;
-
-      ppid = sctp_send_meta->ppid;
-      ordered = sctp_send_meta->ordered;
-      pr_param = sctp_send_meta->pr_param;
-      switch (sctp_send_meta->pr) {
-        case GST_SCTP_SEND_META_PARTIAL_RELIABILITY_NONE:
-          pr = GST_SCTP_ASSOCIATION_PARTIAL_RELIABILITY_NONE;
-          break;
-        case GST_SCTP_SEND_META_PARTIAL_RELIABILITY_RTX:
-          pr = GST_SCTP_ASSOCIATION_PARTIAL_RELIABILITY_RTX;
-          break;
-        case GST_SCTP_SEND_META_PARTIAL_RELIABILITY_BUF:
-          pr = GST_SCTP_ASSOCIATION_PARTIAL_RELIABILITY_BUF;
-          break;
-        case GST_SCTP_SEND_META_PARTIAL_RELIABILITY_TTL:
-          pr = GST_SCTP_ASSOCIATION_PARTIAL_RELIABILITY_TTL;
-          break;
-      }
-      break;
-    }
+  if (G_UNLIKELY (flow_ret == GST_FLOW_FLUSHING
+          || flow_ret == GST_FLOW_NOT_LINKED)) {
+    GST_DEBUG_OBJECT (self, "Push failed on packet source pad. Error: %s",
+        gst_flow_get_name (flow_ret));
+  } else if (G_UNLIKELY (flow_ret != GST_FLOW_OK)) {
+    GST_ERROR_OBJECT (self, "Push failed on packet source pad. Error: %s",
+        gst_flow_get_name (flow_ret));
   }
 
-  GST_DEBUG_OBJECT (pad,
-      "Sending buffer %" GST_PTR_FORMAT
-      " with ppid %u ordered %d pr %d pr_param %u", buffer, ppid, ordered, pr,
-      pr_param);
+  return flow_ret;
+}
 
-  if (!gst_buffer_map (buffer, &map, GST_MAP_READ)) {
-    GST_ERROR_OBJECT (pad, "Could not map GstBuffer");
-    goto error;
+static void
+get_config_from_meta (GstSctpEncPad * sctpenc_pad, GstBuffer * buffer,
+    guint32 * ppid, gboolean * ordered,
+    GstSctpAssociationPartialReliability * pr, guint32 * pr_param)
+{
+  GstSctpSendMeta *sctp_send_meta;
+
+  *ppid = sctpenc_pad->ppid;
+  *ordered = sctpenc_pad->ordered;
+  *pr = sctpenc_pad->reliability;
+  *pr_param = sctpenc_pad->reliability_param;
+
+  sctp_send_meta = gst_sctp_buffer_get_send_meta (buffer);
+  if (!sctp_send_meta)
+    return;
+
+  *ppid = sctp_send_meta->ppid;
+  *ordered = sctp_send_meta->ordered;
+  *pr_param = sctp_send_meta->pr_param;
+  switch (sctp_send_meta->pr) {
+    case GST_SCTP_SEND_META_PARTIAL_RELIABILITY_NONE:
+      *pr = GST_SCTP_ASSOCIATION_PARTIAL_RELIABILITY_NONE;
+      break;
+    case GST_SCTP_SEND_META_PARTIAL_RELIABILITY_RTX:
+      *pr = GST_SCTP_ASSOCIATION_PARTIAL_RELIABILITY_RTX;
+      break;
+    case GST_SCTP_SEND_META_PARTIAL_RELIABILITY_BUF:
+      *pr = GST_SCTP_ASSOCIATION_PARTIAL_RELIABILITY_BUF;
+      break;
+    case GST_SCTP_SEND_META_PARTIAL_RELIABILITY_TTL:
+      *pr = GST_SCTP_ASSOCIATION_PARTIAL_RELIABILITY_TTL;
+      break;
   }
+}
 
-  data = map.data;
-  length = map.size;
+/* Waits until it's this pad's turn to send. Returns with the pad lock held */
+static void
+gst_sctp_enc_pad_wait_turn (GstSctpEnc * self, GstSctpEncPad * sctpenc_pad)
+{
+  gboolean clear_to_send;
 
   GST_OBJECT_LOCK (self);
   clear_to_send = g_queue_is_empty (&self->pending_pads);
@@ -676,6 +747,59 @@ gst_sctp_enc_sink_chain (GstPad * pad, GstObject * parent, GstBuffer * buffer)
   while (!sctpenc_pad->flushing && !sctpenc_pad->clear_to_send) {
     g_cond_wait (&sctpenc_pad->cond, &sctpenc_pad->lock);
   }
+}
+
+/* Must be called with the pad lock held, releases it */
+static void
+gst_sctp_enc_pad_end_turn (GstSctpEnc * self, GstSctpEncPad * sctpenc_pad)
+{
+  GstSctpEncPad *sctpenc_pad_next = NULL;
+
+  sctpenc_pad->clear_to_send = FALSE;
+  g_mutex_unlock (&sctpenc_pad->lock);
+
+  GST_OBJECT_LOCK (self);
+  g_queue_remove (&self->pending_pads, sctpenc_pad);
+  sctpenc_pad_next = g_queue_peek_head (&self->pending_pads);
+  GST_OBJECT_UNLOCK (self);
+
+  if (sctpenc_pad_next) {
+    g_mutex_lock (&sctpenc_pad_next->lock);
+    sctpenc_pad_next->clear_to_send = TRUE;
+    g_cond_signal (&sctpenc_pad_next->cond);
+    g_mutex_unlock (&sctpenc_pad_next->lock);
+  }
+}
+
+/* Must be called with the pad lock held during the pad's turn */
+static GstFlowReturn
+gst_sctp_enc_pad_send_buffer (GstSctpEnc * self, GstSctpEncPad * sctpenc_pad,
+    GstSctpAssociation * association, GstBuffer * buffer)
+{
+  GstPad *pad = GST_PAD (sctpenc_pad);
+  GstMapInfo map;
+  guint32 ppid;
+  gboolean ordered;
+  GstSctpAssociationPartialReliability pr;
+  guint32 pr_param;
+  GstFlowReturn flow_ret = GST_FLOW_ERROR;
+  const guint8 *data;
+  guint32 length;
+
+  get_config_from_meta (sctpenc_pad, buffer, &ppid, &ordered, &pr, &pr_param);
+
+  GST_DEBUG_OBJECT (pad,
+      "Sending buffer %" GST_PTR_FORMAT
+      " with ppid %u ordered %d pr %d pr_param %u", buffer, ppid, ordered, pr,
+      pr_param);
+
+  if (!gst_buffer_map (buffer, &map, GST_MAP_READ)) {
+    GST_ERROR_OBJECT (pad, "Could not map GstBuffer");
+    return GST_FLOW_ERROR;
+  }
+
+  data = map.data;
+  length = map.size;
 
   while (!sctpenc_pad->flushing) {
     guint32 bytes_sent;
@@ -683,7 +807,7 @@ gst_sctp_enc_sink_chain (GstPad * pad, GstObject * parent, GstBuffer * buffer)
     g_mutex_unlock (&sctpenc_pad->lock);
 
     flow_ret =
-        gst_sctp_association_send_data (self->sctp_association, data,
+        gst_sctp_association_send_data (association, data,
         length, sctpenc_pad->stream_id, ppid, ordered, pr, pr_param,
         &bytes_sent);
 
@@ -716,27 +840,135 @@ gst_sctp_enc_sink_chain (GstPad * pad, GstObject * parent, GstBuffer * buffer)
   flow_ret = sctpenc_pad->flushing ? GST_FLOW_FLUSHING : GST_FLOW_OK;
 
 out:
-  sctpenc_pad->clear_to_send = FALSE;
-  g_mutex_unlock (&sctpenc_pad->lock);
+  gst_buffer_unmap (buffer, &map);
+
+  return flow_ret;
+}
+
+/* The association is replaced on state changes, which can happen while
+ * messages are sent from the send-buffer-list action signal */
+static GstSctpAssociation *
+gst_sctp_enc_get_association (GstSctpEnc * self)
+{
+  GstSctpAssociation *association = NULL;
 
   GST_OBJECT_LOCK (self);
-  g_queue_remove (&self->pending_pads, sctpenc_pad);
-  sctpenc_pad_next = g_queue_peek_head (&self->pending_pads);
+  if (self->sctp_association)
+    association = g_object_ref (self->sctp_association);
   GST_OBJECT_UNLOCK (self);
 
-  if (sctpenc_pad_next) {
-    g_mutex_lock (&sctpenc_pad_next->lock);
-    sctpenc_pad_next->clear_to_send = TRUE;
-    g_cond_signal (&sctpenc_pad_next->cond);
-    g_mutex_unlock (&sctpenc_pad_next->lock);
+  return association;
+}
+
+static GstFlowReturn
+gst_sctp_enc_check_src_ret (GstSctpEnc * self, GstPad * pad)
+{
+  GstFlowReturn flow_ret;
+
+  GST_OBJECT_LOCK (self);
+  flow_ret = self->src_ret;
+  if (flow_ret != GST_FLOW_OK) {
+    GST_ERROR_OBJECT (pad, "Pushing on source pad failed before: %s",
+        gst_flow_get_name (flow_ret));
   }
+  GST_OBJECT_UNLOCK (self);
 
-  gst_buffer_unmap (buffer, &map);
-error:
+  return flow_ret;
+}
+
+static GstFlowReturn
+gst_sctp_enc_sink_chain (GstPad * pad, GstObject * parent, GstBuffer * buffer)
+{
+  GstSctpEnc *self = GST_SCTP_ENC (parent);
+  GstSctpEncPad *sctpenc_pad = GST_SCTP_ENC_PAD (pad);
+  GstSctpAssociation *association;
+  GstFlowReturn flow_ret;
+
+  flow_ret = gst_sctp_enc_check_src_ret (self, pad);
+  if (flow_ret != GST_FLOW_OK) {
+    gst_buffer_unref (buffer);
+    return flow_ret;
+  }
+
+  association = gst_sctp_enc_get_association (self);
+  if (!association) {
+    gst_buffer_unref (buffer);
+    return GST_FLOW_FLUSHING;
+  }
+
+  gst_sctp_enc_pad_wait_turn (self, sctpenc_pad);
+  flow_ret = gst_sctp_enc_pad_send_buffer (self, sctpenc_pad, association,
+      buffer);
+  gst_sctp_enc_pad_end_turn (self, sctpenc_pad);
+
+  g_object_unref (association);
   gst_buffer_unref (buffer);
   return flow_ret;
 }
 
+static GstFlowReturn
+on_send_buffer_list (GstSctpEnc * self, guint stream_id,
+    GstBufferList * list, gboolean more)
+{
+  GstSctpAssociation *association;
+  GstSctpEncPad *sctpenc_pad;
+  GstFlowReturn flow_ret;
+  gchar *pad_name;
+  GstPad *pad;
+  guint i, n;
+
+  association = gst_sctp_enc_get_association (self);
+  if (!association)
+    return GST_FLOW_FLUSHING;
+
+  pad_name = g_strdup_printf ("sink_%u", stream_id);
+  pad = gst_element_get_static_pad (GST_ELEMENT (self), pad_name);
+  g_free (pad_name);
+
+  if (!pad) {
+    GST_DEBUG_OBJECT (self, "No sink pad for stream %u", stream_id);
+    flow_ret = GST_FLOW_NOT_LINKED;
+    goto uncork;
+  }
+  sctpenc_pad = GST_SCTP_ENC_PAD (pad);
+
+  flow_ret = gst_sctp_enc_check_src_ret (self, pad);
+  if (flow_ret != GST_FLOW_OK) {
+    gst_object_unref (pad);
+    goto uncork;
+  }
+
+  n = gst_buffer_list_length (list);
+
+  gst_sctp_enc_pad_wait_turn (self, sctpenc_pad);
+  if (n > 1 || more)
+    gst_sctp_association_set_corked (association, TRUE);
+  for (i = 0; i < n && flow_ret == GST_FLOW_OK; i++) {
+    /* The last message of the batch pushes out everything queued before,
+     * including what previous calls with @more left behind */
+    if (i == n - 1 && !more)
+      gst_sctp_association_set_corked (association, FALSE);
+
+    flow_ret = gst_sctp_enc_pad_send_buffer (self, sctpenc_pad, association,
+        gst_buffer_list_get (list, i));
+  }
+  gst_sctp_enc_pad_end_turn (self, sctpenc_pad);
+
+  gst_object_unref (pad);
+
+  if (flow_ret == GST_FLOW_OK)
+    goto done;
+
+uncork:
+  if (!more)
+    gst_sctp_association_set_corked (association, FALSE);
+
+done:
+  g_object_unref (association);
+
+  return flow_ret;
+}
+
 static gboolean
 gst_sctp_enc_sink_event (GstPad * pad, GstObject * parent, GstEvent * event)
 {
@@ -801,8 +1033,12 @@ gst_sctp_enc_src_event (GstPad * pad, GstObject * parent, GstEvent * event)
 
   switch (GST_EVENT_TYPE (event)) {
     case GST_EVENT_FLUSH_START:{
-      gst_data_queue_set_flushing (self->outbound_sctp_packet_queue, TRUE);
-      gst_data_queue_flush (self->outbound_sctp_packet_queue);
+      if (self->shared_worker) {
+        gst_sctp_batch_set_flushing (&self->packet_batch, TRUE);
+      } else {
+        gst_data_queue_set_flushing (self->outbound_sctp_packet_queue, TRUE);
+        gst_data_queue_flush (self->outbound_sctp_packet_queue);
+      }
 
       flush_sinkpads (self, TRUE);
 
@@ -813,13 +1049,17 @@ gst_sctp_enc_src_event (GstPad * pad, GstObject * parent, GstEvent * event)
     case GST_EVENT_FLUSH_STOP:{
       flush_sinkpads (self, FALSE);
 
-      gst_data_queue_set_flushing (self->outbound_sctp_packet_queue, FALSE);
       self->need_segment = TRUE;
       GST_OBJECT_LOCK (self);
       self->src_ret = GST_FLOW_OK;
       GST_OBJECT_UNLOCK (self);
-      gst_pad_start_task (self->src_pad,
-          (GstTaskFunction) gst_sctp_enc_srcpad_loop, self->src_pad, NULL);
+      if (self->shared_worker) {
+        gst_sctp_batch_set_flushing (&self->packet_batch, FALSE);
+      } else {
+        gst_data_queue_set_flushing (self->outbound_sctp_packet_queue, FALSE);
+        gst_pad_start_task (self->src_pad,
+            (GstTaskFunction) gst_sctp_enc_srcpad_loop, self->src_pad, NULL);
+      }
 
       ret = gst_pad_event_default (pad, parent, event);
       break;
@@ -834,20 +1074,24 @@ gst_sctp_enc_src_event (GstPad * pad, GstObject * parent, GstEvent * event)
 static gboolean
 configure_association (GstSctpEnc * self)
 {
+  GstSctpAssociation *association;
   gint state;
 
-  self->sctp_association = gst_sctp_association_get (self->sctp_association_id);
+  association = gst_sctp_association_get (self->sctp_association_id);
 
-  g_object_get (self->sctp_association, "state", &state, NULL);
+  g_object_get (association, "state", &state, NULL);
 
   if (state != GST_SCTP_ASSOCIATION_STATE_NEW) {
     GST_WARNING_OBJECT (self,
         "Could not configure SCTP association. Association already in use!");
-    g_object_unref (self->sctp_association);
-    self->sctp_association = NULL;
+    g_object_unref (association);
     goto error;
   }
 
+  GST_OBJECT_LOCK (self);
+  self->sctp_association = association;
+  GST_OBJECT_UNLOCK (self);
+
   self->signal_handler_state_changed =
       g_signal_connect_object (self->sctp_association, "notify::state",
       G_CALLBACK (on_sctp_association_state_changed), self, 0);
@@ -922,15 +1166,19 @@ on_sctp_packet_out (GstSctpAssociation * _association, const guint8 * buf,
 
   gstbuf = gst_buffer_new_memdup (buf, length);
 
-  item = g_new0 (GstDataQueueItem, 1);
-  item->object = GST_MINI_OBJECT (gstbuf);
-  item->size = length;
-  item->visible = TRUE;
-  item->destroy = (GDestroyNotify) data_queue_item_free;
-
-  if (!gst_data_queue_push (self->outbound_sctp_packet_queue, item)) {
-    item->destroy (item);
-    GST_DEBUG_OBJECT (self, "Failed to push item because we're flushing");
+  if (self->shared_worker) {
+    gst_sctp_batch_add (&self->packet_batch, gstbuf);
+  } else {
+    item = g_new0 (GstDataQueueItem, 1);
+    item->object = GST_MINI_OBJECT (gstbuf);
+    item->size = length;
+    item->visible = TRUE;
+    item->destroy = (GDestroyNotify) data_queue_item_free;
+
+    if (!gst_data_queue_push (self->outbound_sctp_packet_queue, item)) {
+      item->destroy (item);
+      GST_DEBUG_OBJECT (self, "Failed to push item because we're flushing");
+    }
   }
 
   /* Wake up the oldest pad which is the one that needs to finish first */
@@ -954,6 +1202,7 @@ on_sctp_packet_out (GstSctpAssociation * _association, const guint8 * buf,
 static void
 stop_srcpad_task (GstPad * pad, GstSctpEnc * self)
 {
+  gst_sctp_batch_stop (&self->packet_batch);
   gst_data_queue_set_flushing (self->outbound_sctp_packet_queue, TRUE);
   gst_data_queue_flush (self->outbound_sctp_packet_queue);
   gst_pad_stop_task (pad);
@@ -971,16 +1220,20 @@ remove_sinkpad (const GValue * item, gpointer user_data)
 static void
 sctpenc_cleanup (GstSctpEnc * self)
 {
+  GstSctpAssociation *association;
   GstIterator *it;
 
-  gst_sctp_association_set_on_packet_out (self->sctp_association, NULL, NULL,
-      NULL);
+  GST_OBJECT_LOCK (self);
+  association = self->sctp_association;
+  self->sctp_association = NULL;
+  GST_OBJECT_UNLOCK (self);
+
+  gst_sctp_association_set_on_packet_out (association, NULL, NULL, NULL);
 
-  g_signal_handler_disconnect (self->sctp_association,
+  g_signal_handler_disconnect (association,
       self->signal_handler_state_changed);
-  gst_sctp_association_force_close (self->sctp_association);
-  g_object_unref (self->sctp_association);
-  self->sctp_association = NULL;
+  gst_sctp_association_force_close (association);
+  g_object_unref (association);
 
   it = gst_element_iterate_sink_pads (GST_ELEMENT (self));
   while (gst_iterator_foreach (it, remove_sinkpad, self) == GST_ITERATOR_RESYNC)
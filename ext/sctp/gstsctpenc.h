@@ -51,9 +51,11 @@ struct _GstSctpEnc
   guint32 sctp_association_id;
   guint16 remote_sctp_port;
   gboolean use_sock_stream;
+  gboolean shared_worker;
 
   GstSctpAssociation *sctp_association;
   GstDataQueue *outbound_sctp_packet_queue;
+  GstSctpBatch packet_batch;
 
   GQueue pending_pads;
 
@@ -68,6 +70,8 @@ struct _GstSctpEncClass
       gboolean established);
     guint64 (*on_get_stream_bytes_sent) (GstSctpEnc * sctp_enc,
       guint stream_id);
+  GstFlowReturn (*send_buffer_list) (GstSctpEnc * sctp_enc, guint stream_id,
+      GstBufferList * list, gboolean more);
 
 };
 
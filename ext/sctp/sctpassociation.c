@@ -231,6 +231,8 @@ gst_sctp_association_init (GstSctpAssociation * self)
   self->sctp_ass_sock = NULL;
 
   g_mutex_init (&self->association_mutex);
+  g_rw_lock_init (&self->packet_received_lock);
+  g_rw_lock_init (&self->packet_out_lock);
 
   self->state = GST_SCTP_ASSOCIATION_STATE_NEW;
 
@@ -255,6 +257,9 @@ gst_sctp_association_finalize (GObject * object)
   }
   G_UNLOCK (associations_lock);
 
+  g_rw_lock_clear (&self->packet_received_lock);
+  g_rw_lock_clear (&self->packet_out_lock);
+
   G_OBJECT_CLASS (gst_sctp_association_parent_class)->finalize (object);
 }
 
@@ -309,11 +314,18 @@ static void
 maybe_set_state_to_ready (GstSctpAssociation * self)
 {
   gboolean signal_ready_state = FALSE;
+  gboolean have_callbacks;
+
+  g_rw_lock_reader_lock (&self->packet_out_lock);
+  have_callbacks = self->packet_out_cb != NULL;
+  g_rw_lock_reader_unlock (&self->packet_out_lock);
+  g_rw_lock_reader_lock (&self->packet_received_lock);
+  have_callbacks &= self->packet_received_cb != NULL;
+  g_rw_lock_reader_unlock (&self->packet_received_lock);
 
   g_mutex_lock (&self->association_mutex);
   if ((self->state == GST_SCTP_ASSOCIATION_STATE_NEW) &&
-      (self->local_port != 0 && self->remote_port != 0)
-      && (self->packet_out_cb != NULL) && (self->packet_received_cb != NULL)) {
+      (self->local_port != 0 && self->remote_port != 0) && have_callbacks) {
     signal_ready_state =
         gst_sctp_association_change_state (self,
         GST_SCTP_ASSOCIATION_STATE_READY, FALSE);
@@ -424,13 +436,13 @@ gst_sctp_association_set_on_packet_out (GstSctpAssociation * self,
 {
   g_return_if_fail (GST_SCTP_IS_ASSOCIATION (self));
 
-  g_mutex_lock (&self->association_mutex);
+  g_rw_lock_writer_lock (&self->packet_out_lock);
   if (self->packet_out_destroy_notify)
     self->packet_out_destroy_notify (self->packet_out_user_data);
   self->packet_out_cb = packet_out_cb;
   self->packet_out_user_data = user_data;
   self->packet_out_destroy_notify = destroy_notify;
-  g_mutex_unlock (&self->association_mutex);
+  g_rw_lock_writer_unlock (&self->packet_out_lock);
 
   maybe_set_state_to_ready (self);
 }
@@ -442,13 +454,13 @@ gst_sctp_association_set_on_packet_received (GstSctpAssociation * self,
 {
   g_return_if_fail (GST_SCTP_IS_ASSOCIATION (self));
 
-  g_mutex_lock (&self->association_mutex);
+  g_rw_lock_writer_lock (&self->packet_received_lock);
   if (self->packet_received_destroy_notify)
     self->packet_received_destroy_notify (self->packet_received_user_data);
   self->packet_received_cb = packet_received_cb;
   self->packet_received_user_data = user_data;
   self->packet_received_destroy_notify = destroy_notify;
-  g_mutex_unlock (&self->association_mutex);
+  g_rw_lock_writer_unlock (&self->packet_received_lock);
 
   maybe_set_state_to_ready (self);
 }
@@ -538,6 +550,24 @@ end:
   return flow_ret;
 }
 
+/* While corked, Nagle's algorithm holds back small messages as long as data
+ * is in flight so that they get bundled into fewer packets. Uncorking does
+ * not flush by itself, the next send pushes out everything that is queued. */
+void
+gst_sctp_association_set_corked (GstSctpAssociation * self, gboolean corked)
+{
+  int value = corked ? 0 : 1;
+
+  if (!self->sctp_ass_sock)
+    return;
+
+  if (usrsctp_setsockopt (self->sctp_ass_sock, IPPROTO_SCTP, SCTP_NODELAY,
+          &value, sizeof (int))) {
+    GST_DEBUG_OBJECT (self, "Could not set SCTP_NODELAY: (%u) %s", errno,
+        g_strerror (errno));
+  }
+}
+
 void
 gst_sctp_association_reset_stream (GstSctpAssociation * self, guint16 stream_id)
 {
@@ -570,6 +600,273 @@ gst_sctp_association_force_close (GstSctpAssociation * self)
       GST_SCTP_ASSOCIATION_STATE_DISCONNECTED, TRUE);
 }
 
+/* The worker pool is shared by all batches and only exists while there are
+ * batches using it, like usrsctp only runs while there are associations.
+ * When all its workers are busy, for example because downstream of some
+ * associations blocks, batches are pushed from the fallback pool instead,
+ * which starts more threads as needed. */
+G_LOCK_DEFINE_STATIC (worker_pool_lock);
+static GstTaskPool *worker_pool = NULL;
+static GstTaskPool *fallback_pool = NULL;
+static guint worker_pool_users = 0;
+static gint worker_pool_max_threads = 0;
+static gint workers_busy = 0;
+
+/* Set in the threads of both pools */
+static GPrivate in_worker = G_PRIVATE_INIT (NULL);
+
+static gpointer
+free_worker_pools (GstTaskPool ** pools)
+{
+  gst_task_pool_cleanup (pools[0]);
+  gst_object_unref (pools[0]);
+  gst_task_pool_cleanup (pools[1]);
+  gst_object_unref (pools[1]);
+  g_free (pools);
+
+  return NULL;
+}
+
+static void
+ref_worker_pools (void)
+{
+  G_LOCK (worker_pool_lock);
+  if (worker_pool_users++ == 0) {
+    /* Pushing downstream is all the workers do, so one per processor keeps
+     * up with any number of associations */
+    worker_pool_max_threads = MAX (g_get_num_processors (), 2);
+    worker_pool = gst_shared_task_pool_new ();
+    gst_shared_task_pool_set_max_threads (GST_SHARED_TASK_POOL (worker_pool),
+        worker_pool_max_threads);
+    gst_task_pool_prepare (worker_pool, NULL);
+
+    fallback_pool = gst_task_pool_new ();
+    gst_task_pool_prepare (fallback_pool, NULL);
+  }
+  G_UNLOCK (worker_pool_lock);
+}
+
+static void
+unref_worker_pools (void)
+{
+  GstTaskPool **pools = NULL;
+
+  G_LOCK (worker_pool_lock);
+  if (--worker_pool_users == 0) {
+    pools = g_new (GstTaskPool *, 2);
+    pools[0] = worker_pool;
+    pools[1] = fallback_pool;
+    worker_pool = fallback_pool = NULL;
+  }
+  G_UNLOCK (worker_pool_lock);
+
+  if (!pools)
+    return;
+
+  /* Cleaning up waits for all workers to finish, which a worker dropping
+   * the last batch can't do itself */
+  if (g_private_get (&in_worker))
+    g_thread_unref (g_thread_new ("sctp-pool-cleanup",
+            (GThreadFunc) free_worker_pools, pools));
+  else
+    free_worker_pools (pools);
+}
+
+static void gst_sctp_batch_schedule (GstSctpBatch * batch);
+
+static void
+gst_sctp_batch_run (GstSctpBatch * batch)
+{
+  GstObject *object = batch->object;
+  GstBufferList *list;
+  GstFlowReturn flow_ret;
+
+  g_private_set (&in_worker, GINT_TO_POINTER (TRUE));
+
+  g_mutex_lock (&batch->lock);
+  list = batch->pending;
+  batch->pending = NULL;
+  if (list && !batch->flushing) {
+    batch->thread = g_thread_self ();
+    g_mutex_unlock (&batch->lock);
+
+    GST_LOG_OBJECT (object, "Pushing %u buffers",
+        gst_buffer_list_length (list));
+    flow_ret = batch->push_func (object, list);
+
+    g_mutex_lock (&batch->lock);
+    batch->thread = NULL;
+    if (flow_ret != GST_FLOW_OK) {
+      GST_DEBUG_OBJECT (object, "Flushing because of %s",
+          gst_flow_get_name (flow_ret));
+      batch->flushing = TRUE;
+    }
+  } else if (list) {
+    gst_buffer_list_unref (list);
+  }
+
+  /* Only one list is pushed per run, anything added meanwhile goes to the
+   * back of the queue so that a busy association doesn't keep a worker to
+   * itself. The ref on the object goes to the next run, or is released by
+   * gst_sctp_batch_schedule() along with the pending buffers if that can't
+   * be scheduled. */
+  if (!batch->flushing && batch->pending) {
+    g_mutex_unlock (&batch->lock);
+    gst_sctp_batch_schedule (batch);
+    return;
+  }
+
+  gst_clear_buffer_list (&batch->pending);
+  batch->scheduled = FALSE;
+  g_cond_broadcast (&batch->cond);
+  g_mutex_unlock (&batch->lock);
+
+  gst_object_unref (object);
+}
+
+static void
+gst_sctp_batch_run_shared (GstSctpBatch * batch)
+{
+  g_atomic_int_inc (&workers_busy);
+  gst_sctp_batch_run (batch);
+  g_atomic_int_add (&workers_busy, -1);
+}
+
+/* Pushes the batch to one of the pools. Called with a ref on the object of
+ * the batch, which is released by the worker, or here on failure. */
+static void
+gst_sctp_batch_schedule (GstSctpBatch * batch)
+{
+  GstTaskPoolFunction func;
+  GstTaskPool *pool;
+  GError *err = NULL;
+  gpointer handle;
+
+  /* The batch holds a ref on the pools, so they are set */
+  G_LOCK (worker_pool_lock);
+  if (g_atomic_int_get (&workers_busy) < worker_pool_max_threads) {
+    pool = gst_object_ref (worker_pool);
+    func = (GstTaskPoolFunction) gst_sctp_batch_run_shared;
+  } else {
+    GST_LOG_OBJECT (batch->object, "All shared workers busy, using fallback");
+    pool = gst_object_ref (fallback_pool);
+    func = (GstTaskPoolFunction) gst_sctp_batch_run;
+  }
+  G_UNLOCK (worker_pool_lock);
+
+  handle = gst_task_pool_push (pool, func, batch, &err);
+  if (!handle && err) {
+    GST_ERROR_OBJECT (batch->object, "Could not schedule worker: %s",
+        err->message);
+    g_clear_error (&err);
+    gst_object_unref (pool);
+
+    g_mutex_lock (&batch->lock);
+    gst_clear_buffer_list (&batch->pending);
+    batch->scheduled = FALSE;
+    g_cond_broadcast (&batch->cond);
+    g_mutex_unlock (&batch->lock);
+    gst_object_unref (batch->object);
+    return;
+  }
+
+  if (handle)
+    gst_task_pool_dispose_handle (pool, handle);
+  gst_object_unref (pool);
+}
+
+void
+gst_sctp_batch_init (GstSctpBatch * batch, GstObject * object,
+    GstSctpBatchPushFunc push_func)
+{
+  g_mutex_init (&batch->lock);
+  g_cond_init (&batch->cond);
+  batch->pending = NULL;
+  batch->scheduled = FALSE;
+  batch->flushing = TRUE;
+  batch->has_pools = FALSE;
+  batch->thread = NULL;
+  batch->object = object;
+  batch->push_func = push_func;
+}
+
+void
+gst_sctp_batch_clear (GstSctpBatch * batch)
+{
+  gst_clear_buffer_list (&batch->pending);
+  if (batch->has_pools)
+    unref_worker_pools ();
+  g_cond_clear (&batch->cond);
+  g_mutex_clear (&batch->lock);
+}
+
+/* Takes ownership of @buffer */
+void
+gst_sctp_batch_add (GstSctpBatch * batch, GstBuffer * buffer)
+{
+  g_mutex_lock (&batch->lock);
+  if (batch->flushing) {
+    g_mutex_unlock (&batch->lock);
+    GST_DEBUG_OBJECT (batch->object, "Dropping buffer because we're flushing");
+    gst_buffer_unref (buffer);
+    return;
+  }
+
+  if (!batch->pending)
+    batch->pending = gst_buffer_list_new ();
+  gst_buffer_list_add (batch->pending, buffer);
+
+  /* A scheduled worker picks the buffer up */
+  if (batch->scheduled) {
+    g_mutex_unlock (&batch->lock);
+    return;
+  }
+  batch->scheduled = TRUE;
+  g_mutex_unlock (&batch->lock);
+
+  /* Keeps the object alive until the worker is done with it */
+  gst_object_ref (batch->object);
+  gst_sctp_batch_schedule (batch);
+}
+
+/* Flushing drops pending buffers and makes a running worker stop after its
+ * current push, without waiting for it. The batch uses the pools from the
+ * first time it stops flushing until it is cleared. */
+void
+gst_sctp_batch_set_flushing (GstSctpBatch * batch, gboolean flushing)
+{
+  gboolean ref_pools;
+
+  if (!flushing) {
+    g_mutex_lock (&batch->lock);
+    ref_pools = !batch->has_pools;
+    batch->has_pools = TRUE;
+    g_mutex_unlock (&batch->lock);
+
+    if (ref_pools)
+      ref_worker_pools ();
+  }
+
+  g_mutex_lock (&batch->lock);
+  batch->flushing = flushing;
+  if (flushing)
+    gst_clear_buffer_list (&batch->pending);
+  g_mutex_unlock (&batch->lock);
+}
+
+/* Like gst_sctp_batch_set_flushing() but also waits for a running worker to
+ * finish, unless called from the worker itself */
+void
+gst_sctp_batch_stop (GstSctpBatch * batch)
+{
+  g_mutex_lock (&batch->lock);
+  batch->flushing = TRUE;
+  gst_clear_buffer_list (&batch->pending);
+  while (batch->scheduled && batch->thread != g_thread_self ())
+    g_cond_wait (&batch->cond, &batch->lock);
+  g_mutex_unlock (&batch->lock);
+}
+
 static struct socket *
 create_sctp_socket (GstSctpAssociation * self)
 {
@@ -776,11 +1073,11 @@ sctp_packet_out (void *addr, void *buffer, size_t length, guint8 tos,
 {
   GstSctpAssociation *self = GST_SCTP_ASSOCIATION (addr);
 
-  g_mutex_lock (&self->association_mutex);
+  g_rw_lock_reader_lock (&self->packet_out_lock);
   if (self->packet_out_cb) {
     self->packet_out_cb (self, buffer, length, self->packet_out_user_data);
   }
-  g_mutex_unlock (&self->association_mutex);
+  g_rw_lock_reader_unlock (&self->packet_out_lock);
 
   return 0;
 }
@@ -941,7 +1238,7 @@ static void
 handle_message (GstSctpAssociation * self, guint8 * data, guint32 datalen,
     guint16 stream_id, guint32 ppid)
 {
-  g_mutex_lock (&self->association_mutex);
+  g_rw_lock_reader_lock (&self->packet_received_lock);
   if (self->packet_received_cb) {
     /* It's the callbacks job to free the data correctly */
     self->packet_received_cb (self, data, datalen, stream_id, ppid,
@@ -953,7 +1250,7 @@ handle_message (GstSctpAssociation * self, guint8 * data, guint32 datalen,
      * CRTs. */
     usrsctp_freedumpbuffer ((gchar *) data);
   }
-  g_mutex_unlock (&self->association_mutex);
+  g_rw_lock_reader_unlock (&self->packet_received_lock);
 }
 
 /* Returns TRUE if lock==FALSE and notification is needed later.
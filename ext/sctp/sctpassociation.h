@@ -83,10 +83,14 @@ struct _GstSctpAssociation
 
   GstSctpAssociationState state;
 
+  /* The callbacks are replaced rarely but invoked for every packet, so they
+   * have their own locks instead of association_mutex */
+  GRWLock packet_received_lock;
   GstSctpAssociationPacketReceivedCb packet_received_cb;
   gpointer packet_received_user_data;
   GDestroyNotify packet_received_destroy_notify;
 
+  GRWLock packet_out_lock;
   GstSctpAssociationPacketOutCb packet_out_cb;
   gpointer packet_out_user_data;
   GDestroyNotify packet_out_destroy_notify;
@@ -100,6 +104,26 @@ struct _GstSctpAssociationClass
       guint16 stream_id);
 };
 
+typedef GstFlowReturn (*GstSctpBatchPushFunc) (GstObject * object,
+    GstBufferList * list);
+
+/* Buffers waiting to be pushed by a worker of the pool shared by all
+ * associations. Everything added while the previous list was pushed is
+ * pushed as one buffer list. */
+typedef struct
+{
+  GMutex lock;
+  GCond cond;
+  GstBufferList *pending;
+  gboolean scheduled;
+  gboolean flushing;
+  gboolean has_pools;
+  GThread *thread;
+
+  GstObject *object;
+  GstSctpBatchPushFunc push_func;
+} GstSctpBatch;
+
 GType gst_sctp_association_get_type (void);
 
 GstSctpAssociation *gst_sctp_association_get (guint32 association_id);
@@ -115,10 +139,19 @@ GstFlowReturn gst_sctp_association_send_data (GstSctpAssociation * self,
     const guint8 * buf, guint32 length, guint16 stream_id, guint32 ppid,
     gboolean ordered, GstSctpAssociationPartialReliability pr,
     guint32 reliability_param, guint32 *bytes_sent);
+void gst_sctp_association_set_corked (GstSctpAssociation * self,
+    gboolean corked);
 void gst_sctp_association_reset_stream (GstSctpAssociation * self,
     guint16 stream_id);
 void gst_sctp_association_force_close (GstSctpAssociation * self);
 
+void gst_sctp_batch_init (GstSctpBatch * batch, GstObject * object,
+    GstSctpBatchPushFunc push_func);
+void gst_sctp_batch_clear (GstSctpBatch * batch);
+void gst_sctp_batch_add (GstSctpBatch * batch, GstBuffer * buffer);
+void gst_sctp_batch_set_flushing (GstSctpBatch * batch, gboolean flushing);
+void gst_sctp_batch_stop (GstSctpBatch * batch);
+
 G_END_DECLS
 
 #endif /* __GST_SCTP_ASSOCIATION_H__ */
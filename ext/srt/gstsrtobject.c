@@ -73,12 +73,28 @@ enum
   PROP_LAST
 };
 
+/* How often the sender thread checks whether blocked callers can take
+ * data again while there is nothing else to send, in ms */
+#define SENDER_POLL_INTERVAL 10
+
 typedef struct
 {
   SRTSOCKET sock;
   gint poll_id;
   GSocketAddress *sockaddr;
   gboolean sent_headers;
+
+  /* Buffers waiting for the sender thread, and how much of the first one
+   * was already sent */
+  GQueue send_queue;
+  gsize send_offset;
+  guint64 queued_bytes;
+  guint64 dropped_buffers;
+  gint payload_size;
+  /* the socket's send buffer is full */
+  gboolean blocked;
+  /* the sender thread is sending the first buffer without sock_lock */
+  gboolean sending;
 } SRTCaller;
 
 static SRTCaller *
@@ -88,6 +104,7 @@ srt_caller_new (void)
   caller->sock = SRT_INVALID_SOCK;
   caller->poll_id = SRT_ERROR;
   caller->sent_headers = FALSE;
+  g_queue_init (&caller->send_queue);
 
   return caller;
 }
@@ -98,6 +115,7 @@ srt_caller_free (SRTCaller * caller)
   g_return_if_fail (caller != NULL);
 
   g_clear_object (&caller->sockaddr);
+  g_queue_clear_full (&caller->send_queue, (GDestroyNotify) gst_buffer_unref);
 
   if (caller->sock != SRT_INVALID_SOCK) {
     srt_close (caller->sock);
@@ -355,8 +373,12 @@ gst_srt_object_new (GstElement * element)
   srtobject->sent_headers = FALSE;
   srtobject->wait_for_connection = GST_SRT_DEFAULT_WAIT_FOR_CONNECTION;
   srtobject->auto_reconnect = GST_SRT_DEFAULT_AUTO_RECONNECT;
+  srtobject->recv_sock = SRT_INVALID_SOCK;
+  srtobject->caller_queue_size = GST_SRT_DEFAULT_CALLER_QUEUE_SIZE;
+  srtobject->sender_poll_id = SRT_ERROR;
 
   g_cond_init (&srtobject->sock_cond);
+  g_cond_init (&srtobject->sender_cond);
   return srtobject;
 }
 
@@ -372,6 +394,7 @@ gst_srt_object_destroy (GstSRTObject * srtobject)
   srt_epoll_release (srtobject->poll_id);
 
   g_cond_clear (&srtobject->sock_cond);
+  g_cond_clear (&srtobject->sender_cond);
 
   GST_DEBUG_OBJECT (srtobject->element, "Destroying srtobject");
   gst_structure_free (srtobject->parameters);
@@ -1012,6 +1035,210 @@ thread_func (gpointer data)
   }
 }
 
+/* called with sock_lock */
+static void
+srt_caller_unblock (SRTCaller * caller, GstSRTObject * srtobject)
+{
+  if (caller->blocked) {
+    srt_epoll_remove_usock (srtobject->sender_poll_id, caller->sock);
+    caller->blocked = FALSE;
+  }
+}
+
+/* called with sock_lock, which is released while sending so that the
+ * streaming thread can keep queueing. Returns FALSE if the caller has to be
+ * dropped */
+static gboolean
+srt_caller_flush_queue (SRTCaller * caller, GstSRTObject * srtobject)
+{
+  GstBuffer *buffer;
+
+  if (caller->blocked)
+    return TRUE;
+
+  if (caller->payload_size == 0 && !g_queue_is_empty (&caller->send_queue)) {
+    gint optlen = sizeof (caller->payload_size);
+
+    if (srt_getsockflag (caller->sock, SRTO_PAYLOADSIZE, &caller->payload_size,
+            &optlen)) {
+      GST_WARNING_OBJECT (srtobject->element, "%s", srt_getlasterror_str ());
+      return FALSE;
+    }
+  }
+
+  while ((buffer = g_queue_peek_head (&caller->send_queue))) {
+    GstMapInfo info = GST_MAP_INFO_INIT;
+    gsize offset = caller->send_offset;
+    guint64 bytes = 0;
+    gboolean mapped;
+    gint sent = 0;
+
+    /* The head of the queue is left alone while it is being sent */
+    gst_buffer_ref (buffer);
+    caller->sending = TRUE;
+    g_mutex_unlock (&srtobject->sock_lock);
+
+    mapped = gst_buffer_map (buffer, &info, GST_MAP_READ);
+    if (mapped) {
+      while (offset < info.size) {
+        gint rest = MIN (info.size - offset, caller->payload_size);
+
+        sent = srt_sendmsg2 (caller->sock, (char *) (info.data + offset),
+            rest, 0);
+        if (sent < 0)
+          break;
+
+        offset += sent;
+        bytes += sent;
+      }
+      gst_buffer_unmap (buffer, &info);
+    }
+
+    g_mutex_lock (&srtobject->sock_lock);
+    caller->sending = FALSE;
+    caller->send_offset = offset;
+    srtobject->bytes += bytes;
+    gst_buffer_unref (buffer);
+
+    if (!mapped) {
+      GST_WARNING_OBJECT (srtobject->element, "Failed to map %" GST_PTR_FORMAT,
+          buffer);
+      caller->dropped_buffers++;
+    }
+
+    if (sent < 0) {
+      gint flags = SRT_EPOLL_OUT | SRT_EPOLL_ERR;
+
+      if (srt_getlasterror (NULL) != SRT_EASYNCSND) {
+        GST_WARNING_OBJECT (srtobject->element, "Dropping caller %d: %s",
+            caller->sock, srt_getlasterror_str ());
+        return FALSE;
+      }
+
+      GST_LOG_OBJECT (srtobject->element, "Caller %d is blocked with %u "
+          "buffers queued", caller->sock,
+          g_queue_get_length (&caller->send_queue));
+
+      if (srt_epoll_add_usock (srtobject->sender_poll_id, caller->sock,
+              &flags)) {
+        GST_WARNING_OBJECT (srtobject->element, "Dropping caller %d: %s",
+            caller->sock, srt_getlasterror_str ());
+        return FALSE;
+      }
+
+      caller->blocked = TRUE;
+      return TRUE;
+    }
+
+    g_queue_pop_head (&caller->send_queue);
+    caller->queued_bytes -= gst_buffer_get_size (buffer);
+    caller->send_offset = 0;
+    gst_buffer_unref (buffer);
+  }
+
+  return TRUE;
+}
+
+/* called with sock_lock */
+static void
+srt_caller_queue_buffer (SRTCaller * caller, GstBuffer * buffer,
+    guint max_size)
+{
+  while (g_queue_get_length (&caller->send_queue) >= max_size) {
+    GstBuffer *old;
+    guint idx;
+
+    /* Drop the oldest buffer, unless it is being sent or it is a stream
+     * header the caller still needs */
+    idx = caller->send_offset > 0 || caller->sending ? 1 : 0;
+    while ((old = g_queue_peek_nth (&caller->send_queue, idx))
+        && GST_BUFFER_FLAG_IS_SET (old, GST_BUFFER_FLAG_HEADER))
+      idx++;
+
+    if (!old)
+      break;
+
+    g_queue_pop_nth (&caller->send_queue, idx);
+    caller->queued_bytes -= gst_buffer_get_size (old);
+    caller->dropped_buffers++;
+    gst_buffer_unref (old);
+  }
+
+  g_queue_push_tail (&caller->send_queue, gst_buffer_ref (buffer));
+  caller->queued_bytes += gst_buffer_get_size (buffer);
+}
+
+static gpointer
+sender_thread_func (gpointer data)
+{
+  GstSRTObject *srtobject = data;
+
+  g_mutex_lock (&srtobject->sock_lock);
+
+  while (srtobject->sender_running) {
+    GList *item, *next;
+    gboolean blocked = FALSE;
+    SRTSOCKET wsock;
+    gint wsocklen = 1;
+
+    srtobject->sender_pending = FALSE;
+
+    for (item = srtobject->callers; item; item = item->next) {
+      SRTCaller *caller = item->data;
+
+      blocked |= caller->blocked;
+    }
+
+    /* SRT can't wake up an epoll wait from another thread, so only poll the
+     * blocked callers without waiting, and let new data wake us up. Any of
+     * them being writable or in error is enough to retry them all. */
+    if (blocked && srt_epoll_wait (srtobject->sender_poll_id, NULL, NULL,
+            &wsock, &wsocklen, 0, NULL, 0, NULL, 0) > 0) {
+      for (item = srtobject->callers; item; item = item->next)
+        srt_caller_unblock (item->data, srtobject);
+    }
+
+    /* Send everything we can, callers stop at the first message that does
+     * not fit in their send buffer */
+    blocked = FALSE;
+    for (item = srtobject->callers; item; item = next) {
+      SRTCaller *caller = item->data;
+      gboolean flushed = srt_caller_flush_queue (caller, srtobject);
+
+      /* The other callers may have been removed while we were sending */
+      next = item->next;
+
+      if (!flushed) {
+        srt_caller_unblock (caller, srtobject);
+        srtobject->callers = g_list_delete_link (srtobject->callers, item);
+        srt_caller_signal_removed (caller, srtobject);
+        srt_caller_free (caller);
+        continue;
+      }
+
+      blocked |= caller->blocked;
+    }
+
+    /* Buffers were queued or we were stopped while sending */
+    if (srtobject->sender_pending || !srtobject->sender_running)
+      continue;
+
+    if (blocked) {
+      gint64 end_time = g_get_monotonic_time () +
+          SENDER_POLL_INTERVAL * G_TIME_SPAN_MILLISECOND;
+
+      g_cond_wait_until (&srtobject->sender_cond, &srtobject->sock_lock,
+          end_time);
+    } else {
+      g_cond_wait (&srtobject->sender_cond, &srtobject->sock_lock);
+    }
+  }
+
+  g_mutex_unlock (&srtobject->sock_lock);
+
+  return NULL;
+}
+
 static GSocketAddress *
 peeraddr_to_g_socket_address (const struct sockaddr *peeraddr)
 {
@@ -1080,6 +1307,7 @@ gst_srt_object_wait_connect (GstSRTObject * srtobject,
   gpointer bind_sa;
   gsize bind_sa_len;
   GSocketAddress *bind_addr = NULL;
+  guint caller_queue_size;
 
   GST_OBJECT_LOCK (srtobject->element);
 
@@ -1152,6 +1380,27 @@ gst_srt_object_wait_connect (GstSRTObject * srtobject,
     goto failed;
   }
 
+  GST_OBJECT_LOCK (srtobject->element);
+  caller_queue_size = srtobject->caller_queue_size;
+  GST_OBJECT_UNLOCK (srtobject->element);
+
+  if (caller_queue_size > 0 &&
+      gst_uri_handler_get_uri_type (GST_URI_HANDLER (srtobject->element)) ==
+      GST_URI_SINK) {
+    GST_DEBUG_OBJECT (srtobject->element, "Queueing up to %u buffers per "
+        "caller", caller_queue_size);
+
+    srtobject->sender_poll_id = srt_epoll_create ();
+    srtobject->sender_running = TRUE;
+    srtobject->sender_pending = FALSE;
+    srtobject->sender_thread = g_thread_try_new ("GstSRTObjectSender",
+        sender_thread_func, srtobject, error);
+    if (srtobject->sender_thread == NULL) {
+      GST_ERROR_OBJECT (srtobject->element, "Failed to start sender thread");
+      goto failed;
+    }
+  }
+
   srtobject->thread =
       g_thread_try_new ("GstSRTObjectListener", thread_func, srtobject, error);
   if (srtobject->thread == NULL) {
@@ -1163,6 +1412,19 @@ gst_srt_object_wait_connect (GstSRTObject * srtobject,
 
 failed:
 
+  if (srtobject->sender_thread) {
+    g_mutex_lock (&srtobject->sock_lock);
+    srtobject->sender_running = FALSE;
+    g_cond_signal (&srtobject->sender_cond);
+    g_mutex_unlock (&srtobject->sock_lock);
+    g_thread_join (g_steal_pointer (&srtobject->sender_thread));
+  }
+
+  if (srtobject->sender_poll_id != SRT_ERROR) {
+    srt_epoll_release (srtobject->sender_poll_id);
+    srtobject->sender_poll_id = SRT_ERROR;
+  }
+
   if (srtobject->listener_poll_id != SRT_ERROR) {
     srt_epoll_release (srtobject->listener_poll_id);
   }
@@ -1421,6 +1683,22 @@ gst_srt_object_close (GstSRTObject * srtobject)
     g_mutex_lock (&srtobject->sock_lock);
   }
 
+  if (srtobject->sender_thread) {
+    GThread *thread = g_steal_pointer (&srtobject->sender_thread);
+    srtobject->sender_running = FALSE;
+    g_cond_signal (&srtobject->sender_cond);
+    g_mutex_unlock (&srtobject->sock_lock);
+    g_thread_join (thread);
+    g_mutex_lock (&srtobject->sock_lock);
+  }
+
+  if (srtobject->sender_poll_id != SRT_ERROR) {
+    srt_epoll_release (srtobject->sender_poll_id);
+    srtobject->sender_poll_id = SRT_ERROR;
+  }
+
+  srtobject->recv_sock = SRT_INVALID_SOCK;
+
   if (srtobject->listener_sock != SRT_INVALID_SOCK) {
     GST_DEBUG_OBJECT (srtobject->element, "Closing SRT listener socket (0x%x)",
         srtobject->listener_sock);
@@ -1600,12 +1878,41 @@ gst_srt_object_read (GstSRTObject * srtobject,
     }
 
     srtobject->bytes += len;
+    srtobject->recv_sock = rsock;
     break;
   }
 
   return len;
 }
 
+/* Takes another message from the socket the last one was read from,
+ * without waiting. Returns 0 if there is none pending. */
+gssize
+gst_srt_object_read_next (GstSRTObject * srtobject,
+    guint8 * data, gsize size, SRT_MSGCTRL * mctrl)
+{
+  gssize len;
+
+  if (srtobject->recv_sock == SRT_INVALID_SOCK)
+    return 0;
+
+  srt_msgctrl_init (mctrl);
+  len = srt_recvmsg2 (srtobject->recv_sock, (char *) (data), size, mctrl);
+
+  if (len == SRT_ERROR) {
+    /* Errors are reported by the next blocking read */
+    if (srt_getlasterror (NULL) != SRT_EASYNCRCV) {
+      GST_DEBUG_OBJECT (srtobject->element, "Failed to receive: %s",
+          srt_getlasterror_str ());
+    }
+    return 0;
+  }
+
+  srtobject->bytes += len;
+
+  return len;
+}
+
 void
 gst_srt_object_wakeup (GstSRTObject * srtobject, GCancellable * cancellable)
 {
@@ -1766,6 +2073,35 @@ cancelled:
   return 0;
 }
 
+static gssize
+gst_srt_object_queue_to_callers (GstSRTObject * srtobject,
+    GstBufferList * headers, GstBuffer * buffer, guint caller_queue_size)
+{
+  GList *item;
+
+  g_mutex_lock (&srtobject->sock_lock);
+  for (item = srtobject->callers; item; item = item->next) {
+    SRTCaller *caller = item->data;
+
+    if (!caller->sent_headers) {
+      guint i, n_headers = headers ? gst_buffer_list_length (headers) : 0;
+
+      for (i = 0; i < n_headers; i++)
+        srt_caller_queue_buffer (caller, gst_buffer_list_get (headers, i),
+            G_MAXUINT);
+
+      caller->sent_headers = TRUE;
+    }
+
+    srt_caller_queue_buffer (caller, buffer, caller_queue_size);
+  }
+  srtobject->sender_pending = TRUE;
+  g_cond_signal (&srtobject->sender_cond);
+  g_mutex_unlock (&srtobject->sock_lock);
+
+  return gst_buffer_get_size (buffer);
+}
+
 static gssize
 gst_srt_object_write_one (GstSRTObject * srtobject,
     GstBufferList * headers,
@@ -1891,11 +2227,13 @@ gst_srt_object_write_one (GstSRTObject * srtobject,
 gssize
 gst_srt_object_write (GstSRTObject * srtobject,
     GstBufferList * headers,
-    const GstMapInfo * mapinfo, GCancellable * cancellable, GError ** error)
+    GstBuffer * buffer, GCancellable * cancellable, GError ** error)
 {
   gssize len = 0;
   GstSRTConnectionMode connection_mode = GST_SRT_CONNECTION_MODE_NONE;
   gboolean wait_for_connection;
+  guint caller_queue_size;
+  GstMapInfo mapinfo;
 
   /* Only sink element can write data */
   g_return_val_if_fail (gst_uri_handler_get_uri_type (GST_URI_HANDLER
@@ -1905,6 +2243,7 @@ gst_srt_object_write (GstSRTObject * srtobject,
   gst_structure_get_enum (srtobject->parameters, "mode",
       GST_TYPE_SRT_CONNECTION_MODE, (gint *) & connection_mode);
   wait_for_connection = srtobject->wait_for_connection;
+  caller_queue_size = srtobject->caller_queue_size;
   GST_OBJECT_UNLOCK (srtobject->element);
 
   if (connection_mode == GST_SRT_CONNECTION_MODE_LISTENER) {
@@ -1912,15 +2251,32 @@ gst_srt_object_write (GstSRTObject * srtobject,
       if (!gst_srt_object_wait_caller (srtobject, cancellable))
         return 0;
     }
+
+    /* The sender thread only exists if caller-queue-size was set when the
+     * listener was started */
+    if (caller_queue_size > 0 && srtobject->sender_thread)
+      return gst_srt_object_queue_to_callers (srtobject, headers, buffer,
+          caller_queue_size);
+  }
+
+  if (!gst_buffer_map (buffer, &mapinfo, GST_MAP_READ)) {
+    g_set_error (error, GST_RESOURCE_ERROR, GST_RESOURCE_ERROR_READ,
+        "Could not map the input stream");
+    return -1;
+  }
+
+  if (connection_mode == GST_SRT_CONNECTION_MODE_LISTENER) {
     len =
-        gst_srt_object_write_to_callers (srtobject, headers, mapinfo,
+        gst_srt_object_write_to_callers (srtobject, headers, &mapinfo,
         cancellable);
   } else {
     len =
-        gst_srt_object_write_one (srtobject, headers, mapinfo, cancellable,
+        gst_srt_object_write_one (srtobject, headers, &mapinfo, cancellable,
         error);
   }
 
+  gst_buffer_unmap (buffer, &mapinfo);
+
   return len;
 }
 
@@ -2014,6 +2370,11 @@ gst_srt_object_get_stats (GstSRTObject * srtobject)
 
       tmp = get_stats_for_srtsock (srtobject, caller->sock);
       if (tmp == NULL) {
+        /* The sender thread drops it itself once it is done sending */
+        if (caller->sending)
+          continue;
+
+        srt_caller_unblock (caller, srtobject);
         srtobject->callers = g_list_delete_link (srtobject->callers, item);
         srt_caller_signal_removed (caller, srtobject);
         srt_caller_free (caller);
@@ -2023,6 +2384,15 @@ gst_srt_object_get_stats (GstSRTObject * srtobject)
       gst_structure_set (tmp, "caller-address", G_TYPE_SOCKET_ADDRESS,
           caller->sockaddr, NULL);
 
+      if (srtobject->sender_thread) {
+        gst_structure_set (tmp,
+            "send-queue-buffers", G_TYPE_UINT,
+            g_queue_get_length (&caller->send_queue),
+            "send-queue-bytes", G_TYPE_UINT64, caller->queued_bytes,
+            "send-queue-dropped", G_TYPE_UINT64, caller->dropped_buffers,
+            NULL);
+      }
+
       g_value_array_append (callers_stats, NULL);
       v = g_value_array_get_nth (callers_stats, callers_stats->n_values - 1);
       g_value_init (v, GST_TYPE_STRUCTURE);
@@ -43,6 +43,7 @@ G_BEGIN_DECLS
 #define GST_SRT_DEFAULT_MSG_SIZE 1316
 #define GST_SRT_DEFAULT_WAIT_FOR_CONNECTION (TRUE)
 #define GST_SRT_DEFAULT_AUTO_RECONNECT (TRUE)
+#define GST_SRT_DEFAULT_CALLER_QUEUE_SIZE 0
 
 typedef struct _GstSRTObject GstSRTObject;
 
@@ -69,6 +70,21 @@ struct _GstSRTObject
 
   GList                        *callers;
 
+  /* socket the last message was read from */
+  SRTSOCKET                     recv_sock;
+
+  /* Number of buffers queued per caller in listener mode before the oldest
+   * ones are dropped, 0 to send from the streaming thread */
+  guint                         caller_queue_size;
+
+  /* Sends the queued buffers to the callers, protected by sock_lock */
+  GThread                      *sender_thread;
+  GCond                         sender_cond;
+  gboolean                      sender_running;
+  /* buffers were queued since the sender thread last looked */
+  gboolean                      sender_pending;
+  gint                          sender_poll_id;
+
   gboolean                     wait_for_connection;
   gboolean                     auto_reconnect;
 
@@ -105,9 +121,13 @@ gssize          gst_srt_object_read     (GstSRTObject * srtobject,
                                          GError **err,
 					 SRT_MSGCTRL *mctrl);
 
+gssize          gst_srt_object_read_next (GstSRTObject * srtobject,
+                                          guint8 *data, gsize size,
+                                          SRT_MSGCTRL *mctrl);
+
 gssize          gst_srt_object_write    (GstSRTObject * srtobject,
                                          GstBufferList * headers,
-                                         const GstMapInfo * mapinfo,
+                                         GstBuffer * buffer,
                                          GCancellable *cancellable,
                                          GError **err);
 
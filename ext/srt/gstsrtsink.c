@@ -62,6 +62,11 @@ enum
   LAST_SIGNAL
 };
 
+enum
+{
+  PROP_CALLER_QUEUE_SIZE = 128
+};
+
 static guint signals[LAST_SIGNAL] = { 0 };
 
 static void gst_srt_sink_uri_handler_init (gpointer g_iface,
@@ -109,7 +114,15 @@ gst_srt_sink_set_property (GObject * object,
 
   if (!gst_srt_object_set_property_helper (self->srtobject, prop_id, value,
           pspec)) {
-    G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
+    switch (prop_id) {
+      case PROP_CALLER_QUEUE_SIZE:
+        GST_OBJECT_LOCK (self);
+        self->srtobject->caller_queue_size = g_value_get_uint (value);
+        GST_OBJECT_UNLOCK (self);
+        break;
+      default:
+        G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
+    }
   }
 }
 
@@ -121,7 +134,15 @@ gst_srt_sink_get_property (GObject * object,
 
   if (!gst_srt_object_get_property_helper (self->srtobject, prop_id, value,
           pspec)) {
-    G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
+    switch (prop_id) {
+      case PROP_CALLER_QUEUE_SIZE:
+        GST_OBJECT_LOCK (self);
+        g_value_set_uint (value, self->srtobject->caller_queue_size);
+        GST_OBJECT_UNLOCK (self);
+        break;
+      default:
+        G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
+    }
   }
 }
 
@@ -181,7 +202,6 @@ gst_srt_sink_render (GstBaseSink * sink, GstBuffer * buffer)
 {
   GstSRTSink *self = GST_SRT_SINK (sink);
   GstFlowReturn ret = GST_FLOW_OK;
-  GstMapInfo info;
   GError *error = NULL;
 
   if (g_cancellable_is_cancelled (self->cancellable)) {
@@ -194,13 +214,7 @@ gst_srt_sink_render (GstBaseSink * sink, GstBuffer * buffer)
     return GST_FLOW_OK;
   }
 
-  if (!gst_buffer_map (buffer, &info, GST_MAP_READ)) {
-    GST_ELEMENT_ERROR (self, RESOURCE, READ,
-        ("Could not map the input stream"), (NULL));
-    return GST_FLOW_ERROR;
-  }
-
-  if (gst_srt_object_write (self->srtobject, self->headers, &info,
+  if (gst_srt_object_write (self->srtobject, self->headers, buffer,
           self->cancellable, &error) < 0) {
     GST_ELEMENT_ERROR (self, RESOURCE, WRITE,
         ("Failed to write to SRT socket: %s",
@@ -209,8 +223,6 @@ gst_srt_sink_render (GstBaseSink * sink, GstBuffer * buffer)
     ret = GST_FLOW_ERROR;
   }
 
-  gst_buffer_unmap (buffer, &info);
-
   GST_TRACE_OBJECT (self, "sending buffer %p, offset %"
       G_GINT64_FORMAT ", offset_end %" G_GINT64_FORMAT
       ", timestamp %" GST_TIME_FORMAT ", duration %" GST_TIME_FORMAT
@@ -370,6 +382,26 @@ gst_srt_sink_class_init (GstSRTSinkClass * klass)
 
   gst_srt_object_install_properties_helper (gobject_class);
 
+  /**
+   * GstSRTSink:caller-queue-size:
+   *
+   * In listener mode, the number of buffers queued for each caller. When
+   * not 0, buffers are sent to the callers from a separate thread instead
+   * of the streaming thread, and a caller that can't keep up has its oldest
+   * buffers dropped instead of slowing down or disconnecting. The backlog
+   * and the number of dropped buffers of each caller are reported in the
+   * "stats" property.
+   *
+   * Since: 1.24
+   */
+  g_object_class_install_property (gobject_class, PROP_CALLER_QUEUE_SIZE,
+      g_param_spec_uint ("caller-queue-size", "Caller queue size",
+          "Number of buffers queued per caller in listener mode "
+          "(0 = send from the streaming thread)", 0, G_MAXUINT,
+          GST_SRT_DEFAULT_CALLER_QUEUE_SIZE,
+          G_PARAM_READWRITE | GST_PARAM_MUTABLE_READY |
+          G_PARAM_STATIC_STRINGS));
+
   gst_element_class_add_static_pad_template (gstelement_class, &sink_template);
   gst_element_class_set_metadata (gstelement_class,
       "SRT sink", "Sink/Network",
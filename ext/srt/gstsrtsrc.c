@@ -67,9 +67,12 @@ enum
 
 enum
 {
-  PROP_KEEP_LISTENING = 128
+  PROP_KEEP_LISTENING = 128,
+  PROP_MAX_BATCH_MESSAGES,
 };
 
+#define DEFAULT_MAX_BATCH_MESSAGES 1
+
 static guint signals[LAST_SIGNAL] = { 0 };
 
 static void gst_srt_src_uri_handler_init (gpointer g_iface,
@@ -141,10 +144,12 @@ gst_srt_src_stop (GstBaseSrc * bsrc)
   return TRUE;
 }
 
+/* With @wait FALSE, only takes a message that is already pending and returns
+ * GST_FLOW_CUSTOM_SUCCESS if there is none */
 static GstFlowReturn
-gst_srt_src_fill (GstPushSrc * src, GstBuffer * outbuf)
+gst_srt_src_receive (GstSRTSrc * self, GstBuffer * outbuf, gboolean wait)
 {
-  GstSRTSrc *self = GST_SRT_SRC (src);
+  GstPushSrc *src = GST_PUSH_SRC (self);
   GstFlowReturn ret = GST_FLOW_OK;
   GstMapInfo info;
   GError *err = NULL;
@@ -172,13 +177,19 @@ retry:
   clock = gst_element_get_clock (GST_ELEMENT (src));
   if (!clock) {
     GST_DEBUG_OBJECT (src, "Clock missing, flushing");
+    gst_buffer_unmap (outbuf, &info);
     return GST_FLOW_FLUSHING;
   }
 
   base_time = gst_element_get_base_time (GST_ELEMENT (src));
 
-  recv_len = gst_srt_object_read (self->srtobject, info.data,
-      gst_buffer_get_size (outbuf), self->cancellable, &err, &mctrl);
+  if (wait) {
+    recv_len = gst_srt_object_read (self->srtobject, info.data,
+        gst_buffer_get_size (outbuf), self->cancellable, &err, &mctrl);
+  } else {
+    recv_len = gst_srt_object_read_next (self->srtobject, info.data,
+        gst_buffer_get_size (outbuf), &mctrl);
+  }
 
   /* Capture clock values ASAP */
   capture_time = gst_clock_get_time (clock);
@@ -202,6 +213,11 @@ retry:
     goto out;
   }
 
+  if (!wait && recv_len <= 0) {
+    ret = GST_FLOW_CUSTOM_SUCCESS;
+    goto out;
+  }
+
   if (recv_len < 0) {
     GST_ELEMENT_ERROR (src, RESOURCE, READ, (NULL), ("%s", err->message));
     ret = GST_FLOW_ERROR;
@@ -272,11 +288,75 @@ out:
   return ret;
 }
 
+static GstFlowReturn
+gst_srt_src_fill (GstPushSrc * src, GstBuffer * outbuf)
+{
+  return gst_srt_src_receive (GST_SRT_SRC (src), outbuf, TRUE);
+}
+
+static GstFlowReturn
+gst_srt_src_create (GstPushSrc * src, GstBuffer ** outbuf)
+{
+  GstSRTSrc *self = GST_SRT_SRC (src);
+  GstBaseSrc *bsrc = GST_BASE_SRC (src);
+  GstBaseSrcClass *bclass = GST_BASE_SRC_GET_CLASS (src);
+  GstBufferList *list = NULL;
+  GstFlowReturn ret;
+  guint blocksize, max_batch_messages, i;
+
+  GST_OBJECT_LOCK (self);
+  max_batch_messages = self->max_batch_messages;
+  GST_OBJECT_UNLOCK (self);
+
+  blocksize = gst_base_src_get_blocksize (bsrc);
+
+  if (*outbuf == NULL) {
+    ret = bclass->alloc (bsrc, -1, blocksize, outbuf);
+    if (ret != GST_FLOW_OK)
+      return ret;
+  }
+
+  ret = gst_srt_src_receive (self, *outbuf, TRUE);
+  if (ret != GST_FLOW_OK) {
+    gst_clear_buffer (outbuf);
+    return ret;
+  }
+
+  /* Take whatever else is already pending, up to max-batch-messages, and
+   * push it all at once */
+  for (i = 1; i < max_batch_messages; i++) {
+    GstBuffer *buf = NULL;
+
+    if (bclass->alloc (bsrc, -1, blocksize, &buf) != GST_FLOW_OK)
+      break;
+
+    if (gst_srt_src_receive (self, buf, FALSE) != GST_FLOW_OK) {
+      gst_buffer_unref (buf);
+      break;
+    }
+
+    if (!list) {
+      list = gst_buffer_list_new_sized (max_batch_messages);
+      gst_buffer_list_add (list, g_steal_pointer (outbuf));
+    }
+    gst_buffer_list_add (list, buf);
+  }
+
+  if (list) {
+    GST_LOG_OBJECT (self, "received %u messages at once",
+        gst_buffer_list_length (list));
+    gst_base_src_submit_buffer_list (bsrc, list);
+  }
+
+  return GST_FLOW_OK;
+}
+
 static void
 gst_srt_src_init (GstSRTSrc * self)
 {
   self->srtobject = gst_srt_object_new (GST_ELEMENT (self));
   self->cancellable = g_cancellable_new ();
+  self->max_batch_messages = DEFAULT_MAX_BATCH_MESSAGES;
 
   gst_base_src_set_format (GST_BASE_SRC (self), GST_FORMAT_TIME);
   gst_base_src_set_live (GST_BASE_SRC (self), TRUE);
@@ -330,6 +410,11 @@ gst_srt_src_set_property (GObject * object,
       case PROP_KEEP_LISTENING:
         self->keep_listening = g_value_get_boolean (value);
         break;
+      case PROP_MAX_BATCH_MESSAGES:
+        GST_OBJECT_LOCK (self);
+        self->max_batch_messages = g_value_get_uint (value);
+        GST_OBJECT_UNLOCK (self);
+        break;
       default:
         G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
     }
@@ -348,6 +433,11 @@ gst_srt_src_get_property (GObject * object,
       case PROP_KEEP_LISTENING:
         g_value_set_boolean (value, self->keep_listening);
         break;
+      case PROP_MAX_BATCH_MESSAGES:
+        GST_OBJECT_LOCK (self);
+        g_value_set_uint (value, self->max_batch_messages);
+        GST_OBJECT_UNLOCK (self);
+        break;
       default:
         G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
     }
@@ -465,6 +555,23 @@ gst_srt_src_class_init (GstSRTSrcClass * klass)
           "Toggle keep-listening for connection reuse",
           FALSE, G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
 
+  /**
+   * GstSRTSrc:max-batch-messages:
+   *
+   * The maximum number of SRT messages pushed at once. When more than one
+   * message has been received by the time the source wakes up, all the
+   * pending ones up to this number are pushed downstream as a buffer list,
+   * one buffer per message.
+   *
+   * Since: 1.24
+   */
+  g_object_class_install_property (gobject_class, PROP_MAX_BATCH_MESSAGES,
+      g_param_spec_uint ("max-batch-messages",
+          "Maximum batch messages",
+          "Maximum number of received messages pushed at once as a buffer list",
+          1, G_MAXUINT16, DEFAULT_MAX_BATCH_MESSAGES,
+          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
   gst_element_class_add_static_pad_template (gstelement_class, &src_template);
   gst_element_class_set_metadata (gstelement_class,
       "SRT source", "Source/Network",
@@ -477,6 +584,7 @@ gst_srt_src_class_init (GstSRTSrcClass * klass)
   gstbasesrc_class->unlock_stop = GST_DEBUG_FUNCPTR (gst_srt_src_unlock_stop);
   gstbasesrc_class->query = GST_DEBUG_FUNCPTR (gst_srt_src_query);
 
+  gstpushsrc_class->create = GST_DEBUG_FUNCPTR (gst_srt_src_create);
   gstpushsrc_class->fill = GST_DEBUG_FUNCPTR (gst_srt_src_fill);
 }
 
@@ -52,6 +52,7 @@ struct _GstSRTSrc {
 
   guint32       next_pktseq;
   gboolean      keep_listening;
+  guint         max_batch_messages;
 };
 
 struct _GstSRTSrcClass {
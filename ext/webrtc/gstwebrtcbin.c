@@ -65,6 +65,7 @@
 #define RTPSTORAGE_EXTRA_TIME (50)
 
 #define DEFAULT_JB_LATENCY 200
+#define DEFAULT_DIRECT_DATA_CHANNELS FALSE
 
 #define RTPHDREXT_MID GST_RTP_HDREXT_BASE "sdes:mid"
 #define RTPHDREXT_STREAM_ID GST_RTP_HDREXT_BASE "sdes:rtp-stream-id"
@@ -673,7 +674,8 @@ enum
   PROP_ICE_AGENT,
   PROP_LATENCY,
   PROP_SCTP_TRANSPORT,
-  PROP_HTTP_PROXY
+  PROP_HTTP_PROXY,
+  PROP_DIRECT_DATA_CHANNELS,
 };
 
 static guint gst_webrtc_bin_signals[LAST_SIGNAL] = { 0 };
@@ -2527,6 +2529,35 @@ _on_data_channel_ready_state (WebRTCDataChannel * channel,
   }
 }
 
+/* always called with dc_lock held */
+static WebRTCDataChannel *
+_create_remote_data_channel (GstWebRTCBin * webrtc, guint stream_id)
+{
+  WebRTCDataChannel *channel;
+
+  channel = g_object_new (WEBRTC_TYPE_DATA_CHANNEL, "direct",
+      webrtc->priv->direct_data_channels, NULL);
+  channel->parent.id = stream_id;
+  webrtc_data_channel_set_webrtcbin (channel, webrtc);
+
+  g_signal_emit (webrtc, gst_webrtc_bin_signals[PREPARE_DATA_CHANNEL_SIGNAL],
+      0, channel, FALSE);
+
+  if (!channel->direct) {
+    gst_bin_add (GST_BIN (webrtc), channel->src_bin);
+    gst_bin_add (GST_BIN (webrtc), channel->sink_bin);
+
+    gst_element_sync_state_with_parent (channel->src_bin);
+    gst_element_sync_state_with_parent (channel->sink_bin);
+  }
+
+  webrtc_data_channel_link_to_sctp (channel, webrtc->priv->sctp_transport);
+
+  g_ptr_array_add (webrtc->priv->pending_data_channels, channel);
+
+  return channel;
+}
+
 static void
 _on_sctpdec_pad_added (GstElement * sctpdec, GstPad * pad,
     GstWebRTCBin * webrtc)
@@ -2540,24 +2571,8 @@ _on_sctpdec_pad_added (GstElement * sctpdec, GstPad * pad,
 
   DC_LOCK (webrtc);
   channel = _find_data_channel_for_id (webrtc, stream_id);
-  if (!channel) {
-    channel = g_object_new (WEBRTC_TYPE_DATA_CHANNEL, NULL);
-    channel->parent.id = stream_id;
-    webrtc_data_channel_set_webrtcbin (channel, webrtc);
-
-    g_signal_emit (webrtc, gst_webrtc_bin_signals[PREPARE_DATA_CHANNEL_SIGNAL],
-        0, channel, FALSE);
-
-    gst_bin_add (GST_BIN (webrtc), channel->src_bin);
-    gst_bin_add (GST_BIN (webrtc), channel->sink_bin);
-
-    gst_element_sync_state_with_parent (channel->src_bin);
-    gst_element_sync_state_with_parent (channel->sink_bin);
-
-    webrtc_data_channel_link_to_sctp (channel, webrtc->priv->sctp_transport);
-
-    g_ptr_array_add (webrtc->priv->pending_data_channels, channel);
-  }
+  if (!channel)
+    channel = _create_remote_data_channel (webrtc, stream_id);
   DC_UNLOCK (webrtc);
 
   g_signal_connect (channel, "notify::ready-state",
@@ -2570,6 +2585,31 @@ _on_sctpdec_pad_added (GstElement * sctpdec, GstPad * pad,
   gst_object_unref (sink_pad);
 }
 
+/* called from the SCTP stack's thread for each message in direct mode */
+static void
+_on_sctpdec_new_message (GstElement * sctpdec, guint stream_id, guint ppid,
+    GBytes * data, GstWebRTCBin * webrtc)
+{
+  WebRTCDataChannel *channel;
+
+  channel = webrtc_sctp_transport_get_channel (webrtc->priv->sctp_transport,
+      stream_id);
+  if (!channel) {
+    DC_LOCK (webrtc);
+    channel = _find_data_channel_for_id (webrtc, stream_id);
+    if (!channel) {
+      channel = _create_remote_data_channel (webrtc, stream_id);
+      g_signal_connect (channel, "notify::ready-state",
+          G_CALLBACK (_on_data_channel_ready_state), webrtc);
+    }
+    gst_object_ref (channel);
+    DC_UNLOCK (webrtc);
+  }
+
+  webrtc_data_channel_receive (channel, ppid, data);
+  gst_object_unref (channel);
+}
+
 static void
 _on_sctp_state_notify (WebRTCSCTPTransport * sctp, GParamSpec * pspec,
     GstWebRTCBin * webrtc)
@@ -2716,12 +2756,19 @@ _get_or_create_data_channel_transports (GstWebRTCBin * webrtc, guint session_id)
       gst_element_set_locked_state (sctp_transport->sctpdec, TRUE);
       gst_element_set_locked_state (sctp_transport->sctpenc, TRUE);
 
+      if (webrtc->priv->direct_data_channels)
+        webrtc_sctp_transport_set_direct (sctp_transport);
+
       gst_bin_add (GST_BIN (webrtc), sctp_transport->sctpdec);
       gst_bin_add (GST_BIN (webrtc), sctp_transport->sctpenc);
     }
 
-    g_signal_connect (sctp_transport->sctpdec, "pad-added",
-        G_CALLBACK (_on_sctpdec_pad_added), webrtc);
+    if (sctp_transport->direct)
+      g_signal_connect (sctp_transport->sctpdec, "new-message",
+          G_CALLBACK (_on_sctpdec_new_message), webrtc);
+    else
+      g_signal_connect (sctp_transport->sctpdec, "pad-added",
+          G_CALLBACK (_on_sctpdec_pad_added), webrtc);
     g_signal_connect (sctp_transport, "notify::state",
         G_CALLBACK (_on_sctp_state_notify), webrtc);
 
@@ -7154,7 +7201,8 @@ gst_webrtc_bin_create_data_channel (GstWebRTCBin * webrtc, const gchar * label,
   ret = g_object_new (WEBRTC_TYPE_DATA_CHANNEL, "label", label,
       "ordered", ordered, "max-packet-lifetime", max_packet_lifetime,
       "max-retransmits", max_retransmits, "protocol", protocol,
-      "negotiated", negotiated, "id", id, "priority", priority, NULL);
+      "negotiated", negotiated, "id", id, "priority", priority,
+      "direct", webrtc->priv->direct_data_channels, NULL);
 
   if (!ret) {
     DC_UNLOCK (webrtc);
@@ -7165,11 +7213,13 @@ gst_webrtc_bin_create_data_channel (GstWebRTCBin * webrtc, const gchar * label,
   g_signal_emit (webrtc, gst_webrtc_bin_signals[PREPARE_DATA_CHANNEL_SIGNAL], 0,
       ret, TRUE);
 
-  gst_bin_add (GST_BIN (webrtc), ret->src_bin);
-  gst_bin_add (GST_BIN (webrtc), ret->sink_bin);
+  if (!ret->direct) {
+    gst_bin_add (GST_BIN (webrtc), ret->src_bin);
+    gst_bin_add (GST_BIN (webrtc), ret->sink_bin);
 
-  gst_element_sync_state_with_parent (ret->src_bin);
-  gst_element_sync_state_with_parent (ret->sink_bin);
+    gst_element_sync_state_with_parent (ret->src_bin);
+    gst_element_sync_state_with_parent (ret->sink_bin);
+  }
 
   ret = gst_object_ref (ret);
   webrtc_data_channel_set_webrtcbin (ret, webrtc);
@@ -8265,6 +8315,19 @@ gst_webrtc_bin_set_property (GObject * object, guint prop_id,
       gst_webrtc_ice_set_http_proxy (webrtc->priv->ice,
           g_value_get_string (value));
       break;
+    case PROP_DIRECT_DATA_CHANNELS:
+      PC_LOCK (webrtc);
+      DC_LOCK (webrtc);
+      if (webrtc->priv->sctp_transport || webrtc->priv->data_channels->len > 0
+          || webrtc->priv->pending_data_channels->len > 0) {
+        GST_WARNING_OBJECT (webrtc, "Can't change direct-data-channels once "
+            "data channels exist");
+      } else {
+        webrtc->priv->direct_data_channels = g_value_get_boolean (value);
+      }
+      DC_UNLOCK (webrtc);
+      PC_UNLOCK (webrtc);
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
       break;
@@ -8346,6 +8409,9 @@ gst_webrtc_bin_get_property (GObject * object, guint prop_id,
       g_value_take_string (value,
           gst_webrtc_ice_get_http_proxy (webrtc->priv->ice));
       break;
+    case PROP_DIRECT_DATA_CHANNELS:
+      g_value_set_boolean (value, webrtc->priv->direct_data_channels);
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
       break;
@@ -8389,6 +8455,8 @@ gst_webrtc_bin_dispose (GObject * object)
     g_array_free (webrtc->priv->ice_stream_map, TRUE);
   webrtc->priv->ice_stream_map = NULL;
 
+  if (webrtc->priv->sctp_transport)
+    webrtc_sctp_transport_stop_sending (webrtc->priv->sctp_transport);
   g_clear_object (&webrtc->priv->sctp_transport);
 
   G_OBJECT_CLASS (parent_class)->dispose (object);
@@ -8646,6 +8714,26 @@ gst_webrtc_bin_class_init (GstWebRTCBinClass * klass)
           "http://[username:password@]hostname[:port]",
           NULL, G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
 
+  /**
+   * GstWebRTCBin:direct-data-channels:
+   *
+   * Send and receive data channel messages directly through the SCTP
+   * elements instead of through an appsrc and appsink per data channel.
+   * Messages that are sent in quick succession are bundled into fewer SCTP
+   * packets and received messages are emitted in batches. All data channel
+   * signals are still emitted from the same thread as without it.
+   *
+   * Must be set before any data channel is created.
+   *
+   * Since: 1.24
+   */
+  g_object_class_install_property (gobject_class,
+      PROP_DIRECT_DATA_CHANNELS,
+      g_param_spec_boolean ("direct-data-channels", "Direct data channels",
+          "Send and receive data channel messages without a per channel "
+          "appsrc and appsink", DEFAULT_DIRECT_DATA_CHANNELS,
+          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
   /**
    * GstWebRTCBin:sctp-transport:
    *
@@ -9053,4 +9141,5 @@ gst_webrtc_bin_init (GstWebRTCBin * webrtc)
   /* we start off closed until we move to READY */
   webrtc->priv->is_closed = TRUE;
   webrtc->priv->jb_latency = DEFAULT_JB_LATENCY;
+  webrtc->priv->direct_data_channels = DEFAULT_DIRECT_DATA_CHANNELS;
 }
@@ -117,6 +117,8 @@ struct _GstWebRTCBinPrivate
   GMutex dc_lock;
 
   guint jb_latency;
+  /* data channels send and receive without appsrc/appsink */
+  gboolean direct_data_channels;
 
   WebRTCSCTPTransport *sctp_transport;
   TransportStream *data_channel_transport;
@@ -45,6 +45,8 @@
 GST_DEBUG_CATEGORY_STATIC (GST_CAT_DEFAULT);
 
 static void _close_procedure (WebRTCDataChannel * channel, gpointer user_data);
+static void _close_sctp_stream (WebRTCDataChannel * channel,
+    gpointer user_data);
 
 typedef void (*ChannelTask) (GstWebRTCDataChannel * channel,
     gpointer user_data);
@@ -198,6 +200,18 @@ G_DEFINE_TYPE_WITH_CODE (WebRTCDataChannel, webrtc_data_channel,
 G_LOCK_DEFINE_STATIC (outstanding_channels_lock);
 static GList *outstanding_channels;
 
+enum
+{
+  PROP_0,
+  PROP_DIRECT,
+};
+
+typedef struct
+{
+  gboolean is_string;
+  gpointer data;
+} PendingMessage;
+
 typedef enum
 {
   DATA_CHANNEL_PPID_WEBRTC_CONTROL = 50,
@@ -254,6 +268,135 @@ priority_uint_to_type (guint16 val)
   return GST_WEBRTC_PRIORITY_TYPE_HIGH;
 }
 
+static void
+_emit_low_threshold (WebRTCDataChannel * channel, gpointer user_data)
+{
+  gst_webrtc_data_channel_on_buffered_amount_low (GST_WEBRTC_DATA_CHANNEL
+      (channel));
+}
+
+/* Accounts for @size bytes that left the channel */
+static void
+_channel_sent_bytes (WebRTCDataChannel * channel, guint64 size)
+{
+  guint64 prev_amount;
+
+  if (size == 0)
+    return;
+
+  GST_WEBRTC_DATA_CHANNEL_LOCK (channel);
+  prev_amount = channel->parent.buffered_amount;
+  channel->parent.buffered_amount -= size;
+  GST_TRACE_OBJECT (channel, "checking low-threshold: prev %"
+      G_GUINT64_FORMAT " low-threshold %" G_GUINT64_FORMAT " buffered %"
+      G_GUINT64_FORMAT, prev_amount,
+      channel->parent.buffered_amount_low_threshold,
+      channel->parent.buffered_amount);
+  if (prev_amount >= channel->parent.buffered_amount_low_threshold
+      && channel->parent.buffered_amount <=
+      channel->parent.buffered_amount_low_threshold) {
+    _channel_enqueue_task (channel, (ChannelTask) _emit_low_threshold, NULL,
+        NULL);
+  }
+
+  GST_WEBRTC_DATA_CHANNEL_UNLOCK (channel);
+  g_object_notify (G_OBJECT (&channel->parent), "buffered-amount");
+}
+
+static void
+_on_direct_buffer_sent (WebRTCSCTPTransport * sctp, GstFlowReturn ret,
+    gsize size, WebRTCDataChannel * channel)
+{
+  _channel_sent_bytes (channel, size);
+
+  if (ret != GST_FLOW_OK && ret != GST_FLOW_FLUSHING) {
+    GError *error = NULL;
+
+    g_set_error (&error, GST_WEBRTC_ERROR,
+        GST_WEBRTC_ERROR_DATA_CHANNEL_FAILURE, "Failed to send data: %s",
+        gst_flow_get_name (ret));
+    _channel_store_error (channel, error);
+    _channel_enqueue_task (channel, (ChannelTask) _close_procedure, NULL, NULL);
+  }
+
+  gst_object_unref (channel);
+}
+
+static void
+_on_direct_close_marker_sent (WebRTCSCTPTransport * sctp, GstFlowReturn ret,
+    gsize size, WebRTCDataChannel * channel)
+{
+  _channel_enqueue_task (channel, (ChannelTask) _close_sctp_stream, NULL,
+      NULL);
+  gst_object_unref (channel);
+}
+
+/* Hands @buffer to the SCTP stream of @channel, either through the appsrc or
+ * in direct mode through the transport's sender thread */
+static GstFlowReturn
+_channel_push_buffer (WebRTCDataChannel * channel, GstBuffer * buffer)
+{
+  gboolean linked;
+
+  if (!channel->direct)
+    return gst_app_src_push_buffer (GST_APP_SRC (channel->appsrc), buffer);
+
+  GST_WEBRTC_DATA_CHANNEL_LOCK (channel);
+  linked = channel->sctp_pad != NULL;
+  GST_WEBRTC_DATA_CHANNEL_UNLOCK (channel);
+
+  if (!linked) {
+    gst_buffer_unref (buffer);
+    return GST_FLOW_NOT_LINKED;
+  }
+
+  webrtc_sctp_transport_send (channel->sctp_transport, channel->parent.id,
+      buffer, (WebRTCSCTPTransportSentFunc) _on_direct_buffer_sent,
+      gst_object_ref (channel));
+
+  return GST_FLOW_OK;
+}
+
+/* In direct mode, small messages are copied into a buffer from the
+ * transport's pool instead of wrapping them into a new buffer */
+static GstBuffer *
+_channel_copy_to_pooled_buffer (WebRTCDataChannel * channel,
+    gconstpointer data, gsize size)
+{
+  GstBuffer *buffer;
+
+  if (!channel->direct || !channel->sctp_transport)
+    return NULL;
+
+  buffer = webrtc_sctp_transport_acquire_buffer (channel->sctp_transport,
+      size);
+  if (buffer)
+    gst_buffer_fill (buffer, 0, data, size);
+
+  return buffer;
+}
+
+/* Pooled buffers keep their meta, so only update it if it's already there */
+static void
+_buffer_set_send_meta (GstBuffer * buffer, guint32 ppid, gboolean ordered,
+    GstSctpSendMetaPartiallyReliability reliability, guint rel_param)
+{
+  GstSctpSendMeta *meta;
+
+  meta = gst_sctp_buffer_get_send_meta (buffer);
+  if (!meta) {
+    meta = gst_sctp_buffer_add_send_meta (buffer, ppid, ordered, reliability,
+        rel_param);
+    GST_META_FLAG_SET (meta, GST_META_FLAG_POOLED);
+    return;
+  }
+
+  meta->ppid = ppid;
+  meta->ordered = ordered;
+  meta->pr = reliability;
+  meta->pr_param = rel_param;
+}
+
 static GstBuffer *
 construct_open_packet (WebRTCDataChannel * channel)
 {
@@ -402,6 +545,24 @@ _close_sctp_stream (WebRTCDataChannel * channel, gpointer user_data)
   GST_INFO_OBJECT (channel, "Closing outgoing SCTP stream %i label \"%s\"",
       channel->parent.id, channel->parent.label);
 
+  if (channel->direct) {
+    GST_WEBRTC_DATA_CHANNEL_LOCK (channel);
+    pad = channel->sctp_pad;
+    channel->sctp_pad = NULL;
+    GST_WEBRTC_DATA_CHANNEL_UNLOCK (channel);
+
+    if (pad) {
+      GST_TRACE_OBJECT (channel, "removing sctpenc pad %" GST_PTR_FORMAT, pad);
+      webrtc_sctp_transport_remove_channel (channel->sctp_transport,
+          channel->parent.id);
+      gst_element_release_request_pad (channel->sctp_transport->sctpenc, pad);
+      gst_object_unref (pad);
+    }
+
+    _transport_closed (channel);
+    return;
+  }
+
   pad = gst_element_get_static_pad (channel->src_bin, "src");
   peer = gst_pad_get_peer (pad);
   gst_object_unref (pad);
@@ -437,6 +598,25 @@ _close_procedure (WebRTCDataChannel * channel, gpointer user_data)
     GST_WEBRTC_DATA_CHANNEL_UNLOCK (channel);
     g_object_notify (G_OBJECT (channel), "ready-state");
 
+    if (channel->direct) {
+      gboolean linked;
+
+      GST_WEBRTC_DATA_CHANNEL_LOCK (channel);
+      linked = channel->sctp_pad != NULL;
+      GST_WEBRTC_DATA_CHANNEL_UNLOCK (channel);
+
+      /* The transport calls back once everything queued before was sent */
+      if (linked)
+        webrtc_sctp_transport_send (channel->sctp_transport,
+            channel->parent.id, NULL,
+            (WebRTCSCTPTransportSentFunc) _on_direct_close_marker_sent,
+            gst_object_ref (channel));
+      else
+        _channel_enqueue_task (channel, (ChannelTask) _close_sctp_stream, NULL,
+            NULL);
+      return;
+    }
+
     /* Make sure that all data enqueued gets properly sent before data channel is closed. */
     GstFlowReturn ret =
         gst_app_src_end_of_stream (GST_APP_SRC (WEBRTC_DATA_CHANNEL
@@ -573,7 +753,7 @@ _parse_control_packet (WebRTCDataChannel * channel, guint8 * data,
     channel->parent.buffered_amount += gst_buffer_get_size (buffer);
     GST_WEBRTC_DATA_CHANNEL_UNLOCK (channel);
 
-    ret = gst_app_src_push_buffer (GST_APP_SRC (channel->appsrc), buffer);
+    ret = _channel_push_buffer (channel, buffer);
     if (ret != GST_FLOW_OK) {
       g_set_error (error, GST_WEBRTC_ERROR,
           GST_WEBRTC_ERROR_DATA_CHANNEL_FAILURE, "Could not send ack packet");
@@ -619,6 +799,15 @@ buffer_unmap_and_unref (struct map_info *info)
   g_free (info);
 }
 
+static void
+_pending_message_clear (PendingMessage * msg)
+{
+  if (msg->is_string)
+    g_free (msg->data);
+  else if (msg->data)
+    g_bytes_unref (msg->data);
+}
+
 static void
 _emit_have_data (WebRTCDataChannel * channel, GBytes * data)
 {
@@ -633,13 +822,105 @@ _emit_have_string (GstWebRTCDataChannel * channel, gchar * str)
       str);
 }
 
+/* Emits all messages received so far with a single task instead of one
+ * task per message, in direct mode */
+static void
+_emit_pending_messages (WebRTCDataChannel * channel, gpointer user_data)
+{
+  GstWebRTCDataChannel *base_channel = GST_WEBRTC_DATA_CHANNEL (channel);
+
+  GST_WEBRTC_DATA_CHANNEL_LOCK (channel);
+  while (!gst_queue_array_is_empty (channel->pending_messages)) {
+    PendingMessage msg =
+        *(PendingMessage *) gst_queue_array_pop_head_struct
+        (channel->pending_messages);
+
+    GST_WEBRTC_DATA_CHANNEL_UNLOCK (channel);
+    if (msg.is_string)
+      gst_webrtc_data_channel_on_message_string (base_channel, msg.data);
+    else
+      gst_webrtc_data_channel_on_message_data (base_channel, msg.data);
+    _pending_message_clear (&msg);
+    GST_WEBRTC_DATA_CHANNEL_LOCK (channel);
+  }
+  GST_WEBRTC_DATA_CHANNEL_UNLOCK (channel);
+}
+
+static void
+_queue_pending_message (WebRTCDataChannel * channel, gboolean is_string,
+    gpointer data)
+{
+  PendingMessage msg = { is_string, data };
+  gboolean was_empty;
+
+  if (!channel->direct) {
+    if (is_string)
+      _channel_enqueue_task (channel, (ChannelTask) _emit_have_string, data,
+          g_free);
+    else
+      _channel_enqueue_task (channel, (ChannelTask) _emit_have_data, data,
+          data ? (GDestroyNotify) g_bytes_unref : NULL);
+    return;
+  }
+
+  GST_WEBRTC_DATA_CHANNEL_LOCK (channel);
+  was_empty = gst_queue_array_is_empty (channel->pending_messages);
+  gst_queue_array_push_tail_struct (channel->pending_messages, &msg);
+  GST_WEBRTC_DATA_CHANNEL_UNLOCK (channel);
+
+  if (was_empty)
+    _channel_enqueue_task (channel, (ChannelTask) _emit_pending_messages, NULL,
+        NULL);
+}
+
+static GstFlowReturn
+_data_channel_handle_message (WebRTCDataChannel * channel, guint ppid,
+    GBytes * bytes, GError ** error)
+{
+  GstFlowReturn ret = GST_FLOW_OK;
+  gconstpointer data;
+  gsize size;
+
+  data = g_bytes_get_data (bytes, &size);
+
+  switch (ppid) {
+    case DATA_CHANNEL_PPID_WEBRTC_CONTROL:
+      ret = _parse_control_packet (channel, (guint8 *) data, size, error);
+      break;
+    case DATA_CHANNEL_PPID_WEBRTC_STRING:
+    case DATA_CHANNEL_PPID_WEBRTC_STRING_PARTIAL:
+      _queue_pending_message (channel, TRUE, g_strndup (data, size));
+      break;
+    case DATA_CHANNEL_PPID_WEBRTC_BINARY:
+    case DATA_CHANNEL_PPID_WEBRTC_BINARY_PARTIAL:
+      _queue_pending_message (channel, FALSE, g_bytes_ref (bytes));
+      break;
+    case DATA_CHANNEL_PPID_WEBRTC_BINARY_EMPTY:
+      _queue_pending_message (channel, FALSE, NULL);
+      break;
+    case DATA_CHANNEL_PPID_WEBRTC_STRING_EMPTY:
+      _queue_pending_message (channel, TRUE, NULL);
+      break;
+    default:
+      g_set_error (error, GST_WEBRTC_ERROR,
+          GST_WEBRTC_ERROR_DATA_CHANNEL_FAILURE,
+          "Unknown SCTP PPID %u received", ppid);
+      ret = GST_FLOW_ERROR;
+      break;
+  }
+
+  return ret;
+}
+
 static GstFlowReturn
 _data_channel_have_sample (WebRTCDataChannel * channel, GstSample * sample,
     GError ** error)
 {
   GstSctpReceiveMeta *receive;
   GstBuffer *buffer;
-  GstFlowReturn ret = GST_FLOW_OK;
+  struct map_info *info;
+  GBytes *bytes;
+  GstFlowReturn ret;
 
   GST_LOG_OBJECT (channel, "Received sample %" GST_PTR_FORMAT, sample);
 
@@ -659,72 +940,49 @@ _data_channel_have_sample (WebRTCDataChannel * channel, GstSample * sample,
     return GST_FLOW_ERROR;
   }
 
-  switch (receive->ppid) {
-    case DATA_CHANNEL_PPID_WEBRTC_CONTROL:{
-      GstMapInfo info = GST_MAP_INFO_INIT;
-      if (!gst_buffer_map (buffer, &info, GST_MAP_READ)) {
-        g_set_error (error, GST_WEBRTC_ERROR,
-            GST_WEBRTC_ERROR_DATA_CHANNEL_FAILURE,
-            "Failed to map received buffer");
-        ret = GST_FLOW_ERROR;
-      } else {
-        ret = _parse_control_packet (channel, info.data, info.size, error);
-        gst_buffer_unmap (buffer, &info);
-      }
-      break;
-    }
-    case DATA_CHANNEL_PPID_WEBRTC_STRING:
-    case DATA_CHANNEL_PPID_WEBRTC_STRING_PARTIAL:{
-      GstMapInfo info = GST_MAP_INFO_INIT;
-      if (!gst_buffer_map (buffer, &info, GST_MAP_READ)) {
-        g_set_error (error, GST_WEBRTC_ERROR,
-            GST_WEBRTC_ERROR_DATA_CHANNEL_FAILURE,
-            "Failed to map received buffer");
-        ret = GST_FLOW_ERROR;
-      } else {
-        gchar *str = g_strndup ((gchar *) info.data, info.size);
-        _channel_enqueue_task (channel, (ChannelTask) _emit_have_string, str,
-            g_free);
-        gst_buffer_unmap (buffer, &info);
-      }
-      break;
-    }
-    case DATA_CHANNEL_PPID_WEBRTC_BINARY:
-    case DATA_CHANNEL_PPID_WEBRTC_BINARY_PARTIAL:{
-      struct map_info *info = g_new0 (struct map_info, 1);
-      if (!gst_buffer_map (buffer, &info->map_info, GST_MAP_READ)) {
-        g_set_error (error, GST_WEBRTC_ERROR,
-            GST_WEBRTC_ERROR_DATA_CHANNEL_FAILURE,
-            "Failed to map received buffer");
-        ret = GST_FLOW_ERROR;
-      } else {
-        GBytes *data = g_bytes_new_with_free_func (info->map_info.data,
-            info->map_info.size, (GDestroyNotify) buffer_unmap_and_unref, info);
-        info->buffer = gst_buffer_ref (buffer);
-        _channel_enqueue_task (channel, (ChannelTask) _emit_have_data, data,
-            (GDestroyNotify) g_bytes_unref);
-      }
-      break;
-    }
-    case DATA_CHANNEL_PPID_WEBRTC_BINARY_EMPTY:
-      _channel_enqueue_task (channel, (ChannelTask) _emit_have_data, NULL,
-          NULL);
-      break;
-    case DATA_CHANNEL_PPID_WEBRTC_STRING_EMPTY:
-      _channel_enqueue_task (channel, (ChannelTask) _emit_have_string, NULL,
-          NULL);
-      break;
-    default:
-      g_set_error (error, GST_WEBRTC_ERROR,
-          GST_WEBRTC_ERROR_DATA_CHANNEL_FAILURE,
-          "Unknown SCTP PPID %u received", receive->ppid);
-      ret = GST_FLOW_ERROR;
-      break;
+  info = g_new0 (struct map_info, 1);
+  if (!gst_buffer_map (buffer, &info->map_info, GST_MAP_READ)) {
+    g_free (info);
+    g_set_error (error, GST_WEBRTC_ERROR,
+        GST_WEBRTC_ERROR_DATA_CHANNEL_FAILURE,
+        "Failed to map received buffer");
+    return GST_FLOW_ERROR;
   }
+  info->buffer = gst_buffer_ref (buffer);
+  bytes = g_bytes_new_with_free_func (info->map_info.data,
+      info->map_info.size, (GDestroyNotify) buffer_unmap_and_unref, info);
+
+  ret = _data_channel_handle_message (channel, receive->ppid, bytes, error);
+  g_bytes_unref (bytes);
 
   return ret;
 }
 
+/**
+ * webrtc_data_channel_receive:
+ * @channel: a #WebRTCDataChannel in direct mode
+ * @ppid: the payload protocol identifier of the message
+ * @data: the message
+ *
+ * Handles a message received for @channel straight from sctpdec.
+ */
+void
+webrtc_data_channel_receive (WebRTCDataChannel * channel, guint ppid,
+    GBytes * data)
+{
+  GError *error = NULL;
+
+  GST_LOG_OBJECT (channel, "Received message of size %" G_GSIZE_FORMAT
+      " with ppid %u", g_bytes_get_size (data), ppid);
+
+  if (_data_channel_handle_message (channel, ppid, data, &error) !=
+      GST_FLOW_OK) {
+    if (error)
+      _channel_store_error (channel, error);
+    _channel_enqueue_task (channel, (ChannelTask) _close_procedure, NULL, NULL);
+  }
+}
+
 static GstFlowReturn
 on_sink_preroll (GstAppSink * sink, gpointer user_data)
 {
@@ -804,8 +1062,7 @@ webrtc_data_channel_start_negotiation (WebRTCDataChannel * channel)
   GST_WEBRTC_DATA_CHANNEL_UNLOCK (channel);
   g_object_notify (G_OBJECT (&channel->parent), "buffered-amount");
 
-  if (gst_app_src_push_buffer (GST_APP_SRC (channel->appsrc),
-          buffer) == GST_FLOW_OK) {
+  if (_channel_push_buffer (channel, buffer) == GST_FLOW_OK) {
     channel->opened = TRUE;
     _channel_enqueue_task (channel, (ChannelTask) _emit_on_open, NULL, NULL);
   } else {
@@ -866,14 +1123,16 @@ webrtc_data_channel_send_data (GstWebRTCDataChannel * base_channel,
       return FALSE;
     }
 
-    buffer = gst_buffer_new_wrapped_full (GST_MEMORY_FLAG_READONLY, data, size,
-        0, size, g_bytes_ref (bytes), (GDestroyNotify) g_bytes_unref);
+    buffer = _channel_copy_to_pooled_buffer (channel, data, size);
+    if (!buffer)
+      buffer = gst_buffer_new_wrapped_full (GST_MEMORY_FLAG_READONLY, data,
+          size, 0, size, g_bytes_ref (bytes), (GDestroyNotify) g_bytes_unref);
     ppid = DATA_CHANNEL_PPID_WEBRTC_BINARY;
   }
 
   _get_sctp_reliability (channel, &reliability, &rel_param);
-  gst_sctp_buffer_add_send_meta (buffer, ppid, channel->parent.ordered,
-      reliability, rel_param);
+  _buffer_set_send_meta (buffer, ppid, channel->parent.ordered, reliability,
+      rel_param);
 
   GST_LOG_OBJECT (channel, "Sending data using buffer %" GST_PTR_FORMAT,
       buffer);
@@ -890,7 +1149,7 @@ webrtc_data_channel_send_data (GstWebRTCDataChannel * base_channel,
   }
   GST_WEBRTC_DATA_CHANNEL_UNLOCK (channel);
 
-  ret = gst_app_src_push_buffer (GST_APP_SRC (channel->appsrc), buffer);
+  ret = _channel_push_buffer (channel, buffer);
   if (ret == GST_FLOW_OK) {
     g_object_notify (G_OBJECT (&channel->parent), "buffered-amount");
   } else {
@@ -939,16 +1198,19 @@ webrtc_data_channel_send_string (GstWebRTCDataChannel * base_channel,
       return FALSE;
     }
 
-    str_copy = g_strdup (str);
-    buffer =
-        gst_buffer_new_wrapped_full (GST_MEMORY_FLAG_READONLY, str_copy,
-        size, 0, size, str_copy, g_free);
+    buffer = _channel_copy_to_pooled_buffer (channel, str, size);
+    if (!buffer) {
+      str_copy = g_strdup (str);
+      buffer =
+          gst_buffer_new_wrapped_full (GST_MEMORY_FLAG_READONLY, str_copy,
+          size, 0, size, str_copy, g_free);
+    }
     ppid = DATA_CHANNEL_PPID_WEBRTC_STRING;
   }
 
   _get_sctp_reliability (channel, &reliability, &rel_param);
-  gst_sctp_buffer_add_send_meta (buffer, ppid, channel->parent.ordered,
-      reliability, rel_param);
+  _buffer_set_send_meta (buffer, ppid, channel->parent.ordered, reliability,
+      rel_param);
 
   GST_TRACE_OBJECT (channel, "Sending string using buffer %" GST_PTR_FORMAT,
       buffer);
@@ -965,7 +1227,7 @@ webrtc_data_channel_send_string (GstWebRTCDataChannel * base_channel,
   }
   GST_WEBRTC_DATA_CHANNEL_UNLOCK (channel);
 
-  ret = gst_app_src_push_buffer (GST_APP_SRC (channel->appsrc), buffer);
+  ret = _channel_push_buffer (channel, buffer);
   if (ret == GST_FLOW_OK) {
     g_object_notify (G_OBJECT (&channel->parent), "buffered-amount");
   } else {
@@ -1029,18 +1291,10 @@ _on_sctp_notify_state (GObject * sctp_transport, GParamSpec * pspec,
   g_object_unref (channel);
 }
 
-static void
-_emit_low_threshold (WebRTCDataChannel * channel, gpointer user_data)
-{
-  gst_webrtc_data_channel_on_buffered_amount_low (GST_WEBRTC_DATA_CHANNEL
-      (channel));
-}
-
 static GstPadProbeReturn
 on_appsrc_data (GstPad * pad, GstPadProbeInfo * info, gpointer user_data)
 {
   WebRTCDataChannel *channel = user_data;
-  guint64 prev_amount;
   guint64 size = 0;
 
   if (GST_PAD_PROBE_INFO_TYPE (info) & (GST_PAD_PROBE_TYPE_BUFFER)) {
@@ -1061,25 +1315,7 @@ on_appsrc_data (GstPad * pad, GstPadProbeInfo * info, gpointer user_data)
     }
   }
 
-  if (size > 0) {
-    GST_WEBRTC_DATA_CHANNEL_LOCK (channel);
-    prev_amount = channel->parent.buffered_amount;
-    channel->parent.buffered_amount -= size;
-    GST_TRACE_OBJECT (channel, "checking low-threshold: prev %"
-        G_GUINT64_FORMAT " low-threshold %" G_GUINT64_FORMAT " buffered %"
-        G_GUINT64_FORMAT, prev_amount,
-        channel->parent.buffered_amount_low_threshold,
-        channel->parent.buffered_amount);
-    if (prev_amount >= channel->parent.buffered_amount_low_threshold
-        && channel->parent.buffered_amount <=
-        channel->parent.buffered_amount_low_threshold) {
-      _channel_enqueue_task (channel, (ChannelTask) _emit_low_threshold, NULL,
-          NULL);
-    }
-
-    GST_WEBRTC_DATA_CHANNEL_UNLOCK (channel);
-    g_object_notify (G_OBJECT (&channel->parent), "buffered-amount");
-  }
+  _channel_sent_bytes (channel, size);
 
   return GST_PAD_PROBE_OK;
 }
@@ -1096,6 +1332,10 @@ gst_webrtc_data_channel_constructed (GObject * object)
   channel = WEBRTC_DATA_CHANNEL (object);
   GST_DEBUG ("New channel %p constructed", channel);
 
+  /* Messages go straight through the SCTP transport */
+  if (channel->direct)
+    return;
+
   caps = gst_caps_new_any ();
 
   channel->appsrc = gst_element_factory_make ("appsrc", NULL);
@@ -1148,12 +1388,50 @@ gst_webrtc_data_channel_finalize (GObject * object)
 
   g_clear_object (&channel->appsrc);
   g_clear_object (&channel->appsink);
+  g_clear_object (&channel->sctp_pad);
+
+  while (!gst_queue_array_is_empty (channel->pending_messages))
+    _pending_message_clear (gst_queue_array_pop_head_struct
+        (channel->pending_messages));
+  gst_queue_array_free (channel->pending_messages);
 
   g_weak_ref_clear (&channel->webrtcbin_weak);
 
   G_OBJECT_CLASS (parent_class)->finalize (object);
 }
 
+static void
+gst_webrtc_data_channel_set_property (GObject * object, guint prop_id,
+    const GValue * value, GParamSpec * pspec)
+{
+  WebRTCDataChannel *channel = WEBRTC_DATA_CHANNEL (object);
+
+  switch (prop_id) {
+    case PROP_DIRECT:
+      channel->direct = g_value_get_boolean (value);
+      break;
+    default:
+      G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
+      break;
+  }
+}
+
+static void
+gst_webrtc_data_channel_get_property (GObject * object, guint prop_id,
+    GValue * value, GParamSpec * pspec)
+{
+  WebRTCDataChannel *channel = WEBRTC_DATA_CHANNEL (object);
+
+  switch (prop_id) {
+    case PROP_DIRECT:
+      g_value_set_boolean (value, channel->direct);
+      break;
+    default:
+      G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
+      break;
+  }
+}
+
 static void
 webrtc_data_channel_class_init (WebRTCDataChannelClass * klass)
 {
@@ -1161,6 +1439,8 @@ webrtc_data_channel_class_init (WebRTCDataChannelClass * klass)
   GstWebRTCDataChannelClass *channel_class =
       (GstWebRTCDataChannelClass *) klass;
 
+  gobject_class->set_property = gst_webrtc_data_channel_set_property;
+  gobject_class->get_property = gst_webrtc_data_channel_get_property;
   gobject_class->constructed = gst_webrtc_data_channel_constructed;
   gobject_class->dispose = gst_webrtc_data_channel_dispose;
   gobject_class->finalize = gst_webrtc_data_channel_finalize;
@@ -1168,6 +1448,14 @@ webrtc_data_channel_class_init (WebRTCDataChannelClass * klass)
   channel_class->send_data = webrtc_data_channel_send_data;
   channel_class->send_string = webrtc_data_channel_send_string;
   channel_class->close = webrtc_data_channel_close;
+
+  g_object_class_install_property (gobject_class,
+      PROP_DIRECT,
+      g_param_spec_boolean ("direct", "Direct",
+          "Send and receive through the SCTP transport directly instead of "
+          "through an appsrc and appsink", FALSE,
+          G_PARAM_READWRITE | G_PARAM_CONSTRUCT_ONLY |
+          G_PARAM_STATIC_STRINGS));
 }
 
 static void
@@ -1178,6 +1466,9 @@ webrtc_data_channel_init (WebRTCDataChannel * channel)
   G_UNLOCK (outstanding_channels_lock);
 
   g_weak_ref_init (&channel->webrtcbin_weak, NULL);
+
+  channel->pending_messages =
+      gst_queue_array_new_for_struct (sizeof (PendingMessage), 4);
 }
 
 static void
@@ -1218,9 +1509,25 @@ webrtc_data_channel_link_to_sctp (WebRTCDataChannel * channel,
 
       _data_channel_set_sctp_transport (channel, sctp_transport);
       pad_name = g_strdup_printf ("sink_%u", id);
-      if (!gst_element_link_pads (channel->src_bin, "src",
-              channel->sctp_transport->sctpenc, pad_name))
+      if (channel->direct) {
+        GstPad *sctp_pad;
+
+        /* The pad only configures the stream, messages are sent with
+         * sctpenc's send-buffer-list action signal */
+        sctp_pad =
+            gst_element_request_pad_simple (sctp_transport->sctpenc, pad_name);
+        if (sctp_pad) {
+          webrtc_sctp_transport_add_channel (sctp_transport, id, channel);
+          GST_WEBRTC_DATA_CHANNEL_LOCK (channel);
+          channel->sctp_pad = sctp_pad;
+          GST_WEBRTC_DATA_CHANNEL_UNLOCK (channel);
+        } else {
+          g_warn_if_reached ();
+        }
+      } else if (!gst_element_link_pads (channel->src_bin, "src",
+              channel->sctp_transport->sctpenc, pad_name)) {
         g_warn_if_reached ();
+      }
       g_free (pad_name);
 
       _on_sctp_notify_state_unlocked (G_OBJECT (sctp_transport), channel);
@@ -57,6 +57,14 @@ struct _WebRTCDataChannel
   GError                           *stored_error;
   gboolean                          peer_closed;
 
+  /* direct mode: no appsrc/appsink, messages go through the transport */
+  gboolean                          direct;
+  /* protected by the channel lock */
+  GstPad                           *sctp_pad;
+  /* received messages waiting for emission in direct mode, protected by the
+   * channel lock */
+  GstQueueArray                    *pending_messages;
+
   gpointer                          _padding[GST_PADDING];
 };
 
@@ -72,6 +80,11 @@ G_GNUC_INTERNAL
 void    webrtc_data_channel_link_to_sctp (WebRTCDataChannel                 *channel,
                                           WebRTCSCTPTransport               *sctp_transport);
 
+G_GNUC_INTERNAL
+void    webrtc_data_channel_receive (WebRTCDataChannel                      *channel,
+                                     guint                                   ppid,
+                                     GBytes                                 *data);
+
 G_GNUC_INTERNAL
 void    webrtc_data_channel_set_webrtcbin (WebRTCDataChannel                *channel,
                                            GstWebRTCBin                     *webrtcbin);
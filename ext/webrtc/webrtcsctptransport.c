@@ -47,6 +47,19 @@ enum
 
 static guint webrtc_sctp_transport_signals[LAST_SIGNAL] = { 0 };
 
+/* Messages up to this size are copied into buffers from a pool in direct
+ * mode instead of allocating a buffer for each */
+#define MESSAGE_POOL_BUFFER_SIZE 1200
+
+typedef struct
+{
+  guint stream_id;
+  GstBuffer *buffer;
+  gsize size;
+  WebRTCSCTPTransportSentFunc func;
+  gpointer user_data;
+} SendItem;
+
 #define webrtc_sctp_transport_parent_class parent_class
 G_DEFINE_TYPE_WITH_CODE (WebRTCSCTPTransport, webrtc_sctp_transport,
     GST_TYPE_WEBRTC_SCTP_TRANSPORT,
@@ -119,6 +132,14 @@ _on_sctp_dec_pad_removed (GstElement * sctpdec, GstPad * pad,
       GUINT_TO_POINTER (stream_id), NULL);
 }
 
+static void
+_on_sctp_dec_stream_reset (GstElement * sctpdec, guint stream_id,
+    WebRTCSCTPTransport * sctp)
+{
+  _sctp_enqueue_task (sctp, (SCTPTask) _emit_stream_reset,
+      GUINT_TO_POINTER (stream_id), NULL);
+}
+
 static void
 _on_sctp_association_established (GstElement * sctpenc, gboolean established,
     WebRTCSCTPTransport * sctp)
@@ -148,6 +169,290 @@ webrtc_sctp_transport_set_priority (WebRTCSCTPTransport * sctp,
   gst_object_unref (pad);
 }
 
+/* Sends one run of consecutive messages for the same stream with a single
+ * action signal and reports the result for each of them */
+static void
+_send_items (WebRTCSCTPTransport * sctp, SendItem * items, guint n_items,
+    gboolean more)
+{
+  GstBufferList *list;
+  GstFlowReturn ret;
+  guint i;
+
+  list = gst_buffer_list_new_sized (n_items);
+  for (i = 0; i < n_items; i++)
+    gst_buffer_list_add (list, items[i].buffer);
+
+  GST_LOG_OBJECT (sctp, "Sending %u messages on stream %u", n_items,
+      items[0].stream_id);
+
+  g_signal_emit_by_name (sctp->sctpenc, "send-buffer-list", items[0].stream_id,
+      list, more, &ret);
+  gst_buffer_list_unref (list);
+
+  for (i = 0; i < n_items; i++) {
+    if (items[i].func)
+      items[i].func (sctp, ret, items[i].size, items[i].user_data);
+  }
+}
+
+static gpointer
+_send_thread_func (WebRTCSCTPTransport * sctp)
+{
+  GArray *batch;
+
+  batch = g_array_sized_new (FALSE, FALSE, sizeof (SendItem), 16);
+
+  g_mutex_lock (&sctp->send_lock);
+  while (sctp->send_running) {
+    SendItem *items;
+    guint i, n, start, last;
+
+    if (gst_queue_array_is_empty (sctp->send_queue)) {
+      g_cond_wait (&sctp->send_cond, &sctp->send_lock);
+      continue;
+    }
+
+    /* Take everything queued so far and let the channels queue more while
+     * it is sent */
+    n = gst_queue_array_get_length (sctp->send_queue);
+    g_array_set_size (batch, n);
+    items = (SendItem *) batch->data;
+    for (i = 0; i < n; i++)
+      items[i] = *(SendItem *) gst_queue_array_pop_head_struct (sctp->send_queue);
+    g_mutex_unlock (&sctp->send_lock);
+
+    /* Bundling stops with the last message that has a buffer */
+    for (last = n; last > 0 && !items[last - 1].buffer; last--);
+
+    /* A message without buffer only asks for its callback once everything
+     * before it has been sent */
+    for (start = 0, i = 0; i < n; i++) {
+      if (items[i].buffer && i + 1 < n && items[i + 1].buffer
+          && items[i + 1].stream_id == items[i].stream_id)
+        continue;
+
+      if (items[i].buffer) {
+        _send_items (sctp, &items[start], i + 1 - start, i + 1 < last);
+      } else if (items[i].func) {
+        items[i].func (sctp, GST_FLOW_OK, 0, items[i].user_data);
+      }
+      start = i + 1;
+    }
+
+    g_mutex_lock (&sctp->send_lock);
+  }
+  g_mutex_unlock (&sctp->send_lock);
+
+  g_array_free (batch, TRUE);
+
+  return NULL;
+}
+
+/**
+ * webrtc_sctp_transport_stop_sending:
+ * @sctp: a #WebRTCSCTPTransport
+ *
+ * Stops the sender thread of direct mode. Messages that were not sent yet
+ * and messages queued afterwards are reported as %GST_FLOW_FLUSHING.
+ */
+void
+webrtc_sctp_transport_stop_sending (WebRTCSCTPTransport * sctp)
+{
+  GThread *thread;
+  GstQueueArray *queue;
+
+  g_mutex_lock (&sctp->send_lock);
+  sctp->send_stopped = TRUE;
+  sctp->send_running = FALSE;
+  thread = sctp->send_thread;
+  sctp->send_thread = NULL;
+  g_cond_signal (&sctp->send_cond);
+  g_mutex_unlock (&sctp->send_lock);
+
+  if (thread)
+    g_thread_join (thread);
+
+  g_mutex_lock (&sctp->send_lock);
+  queue = sctp->send_queue;
+  sctp->send_queue = gst_queue_array_new_for_struct (sizeof (SendItem), 16);
+  g_mutex_unlock (&sctp->send_lock);
+
+  /* Anything left over might hold a reference to a channel */
+  while (!gst_queue_array_is_empty (queue)) {
+    SendItem *item = gst_queue_array_pop_head_struct (queue);
+
+    gst_clear_buffer (&item->buffer);
+    if (item->func)
+      item->func (sctp, GST_FLOW_FLUSHING, item->size, item->user_data);
+  }
+  gst_queue_array_free (queue);
+}
+
+/**
+ * webrtc_sctp_transport_set_direct:
+ * @sctp: a #WebRTCSCTPTransport
+ *
+ * Switches @sctp to direct mode, where sctpdec emits the received messages
+ * as signals and data channels send through a sender thread of the
+ * transport instead of through their own appsrc and appsink. sctpenc then
+ * also pushes its packets from the worker pool shared by all SCTP elements.
+ * Must be called before the SCTP elements start.
+ */
+void
+webrtc_sctp_transport_set_direct (WebRTCSCTPTransport * sctp)
+{
+  GstStructure *config;
+
+  if (sctp->direct)
+    return;
+
+  sctp->direct = TRUE;
+
+  g_object_set (sctp->sctpdec, "emit-messages", TRUE, NULL);
+  g_object_set (sctp->sctpenc, "shared-worker", TRUE, NULL);
+  g_signal_connect (sctp->sctpdec, "stream-reset",
+      G_CALLBACK (_on_sctp_dec_stream_reset), sctp);
+
+  sctp->message_pool = gst_buffer_pool_new ();
+  config = gst_buffer_pool_get_config (sctp->message_pool);
+  gst_buffer_pool_config_set_params (config, NULL, MESSAGE_POOL_BUFFER_SIZE, 0,
+      0);
+  gst_buffer_pool_set_config (sctp->message_pool, config);
+  gst_buffer_pool_set_active (sctp->message_pool, TRUE);
+}
+
+/**
+ * webrtc_sctp_transport_acquire_buffer:
+ * @sctp: a #WebRTCSCTPTransport
+ * @size: the size of the message
+ *
+ * Returns: (transfer full) (nullable): a buffer of @size bytes from the
+ *     message pool, or %NULL if @size is too large for it or @sctp is not in
+ *     direct mode
+ */
+GstBuffer *
+webrtc_sctp_transport_acquire_buffer (WebRTCSCTPTransport * sctp, gsize size)
+{
+  GstBuffer *buffer = NULL;
+
+  if (!sctp->message_pool || size > MESSAGE_POOL_BUFFER_SIZE)
+    return NULL;
+
+  if (gst_buffer_pool_acquire_buffer (sctp->message_pool, &buffer,
+          NULL) != GST_FLOW_OK)
+    return NULL;
+
+  gst_buffer_set_size (buffer, size);
+
+  return buffer;
+}
+
+/**
+ * webrtc_sctp_transport_send:
+ * @sctp: a #WebRTCSCTPTransport in direct mode
+ * @stream_id: the SCTP stream to send on
+ * @buffer: (transfer full) (nullable): the message
+ * @func: (nullable): called from the sender thread once @buffer was sent
+ * @user_data: data for @func
+ *
+ * Queues @buffer for sending on @stream_id. Consecutive messages for the same
+ * stream are sent together and all messages that are queued at once are
+ * bundled into as few packets as possible. Without @buffer, @func is called
+ * once everything queued before has been sent.
+ */
+void
+webrtc_sctp_transport_send (WebRTCSCTPTransport * sctp, guint stream_id,
+    GstBuffer * buffer, WebRTCSCTPTransportSentFunc func, gpointer user_data)
+{
+  SendItem item = { stream_id, buffer, 0, func, user_data };
+
+  g_return_if_fail (sctp->direct);
+
+  if (buffer)
+    item.size = gst_buffer_get_size (buffer);
+
+  g_mutex_lock (&sctp->send_lock);
+  if (sctp->send_stopped) {
+    g_mutex_unlock (&sctp->send_lock);
+    gst_clear_buffer (&buffer);
+    if (func)
+      func (sctp, GST_FLOW_FLUSHING, item.size, user_data);
+    return;
+  }
+  if (!sctp->send_thread) {
+    sctp->send_running = TRUE;
+    sctp->send_thread = g_thread_new ("webrtc-sctp-send",
+        (GThreadFunc) _send_thread_func, sctp);
+  }
+  gst_queue_array_push_tail_struct (sctp->send_queue, &item);
+  if (gst_queue_array_get_length (sctp->send_queue) == 1)
+    g_cond_signal (&sctp->send_cond);
+  g_mutex_unlock (&sctp->send_lock);
+}
+
+/**
+ * webrtc_sctp_transport_add_channel:
+ * @sctp: a #WebRTCSCTPTransport
+ * @stream_id: the SCTP stream of @channel
+ * @channel: a #WebRTCDataChannel
+ *
+ * Registers @channel for quick lookup of incoming messages. Only a weak
+ * reference to @channel is kept.
+ */
+void
+webrtc_sctp_transport_add_channel (WebRTCSCTPTransport * sctp,
+    guint stream_id, gpointer channel)
+{
+  GWeakRef *ref = g_new0 (GWeakRef, 1);
+
+  g_weak_ref_init (ref, channel);
+
+  GST_OBJECT_LOCK (sctp);
+  g_hash_table_insert (sctp->channels, GUINT_TO_POINTER (stream_id), ref);
+  GST_OBJECT_UNLOCK (sctp);
+}
+
+void
+webrtc_sctp_transport_remove_channel (WebRTCSCTPTransport * sctp,
+    guint stream_id)
+{
+  GST_OBJECT_LOCK (sctp);
+  g_hash_table_remove (sctp->channels, GUINT_TO_POINTER (stream_id));
+  GST_OBJECT_UNLOCK (sctp);
+}
+
+/**
+ * webrtc_sctp_transport_get_channel:
+ * @sctp: a #WebRTCSCTPTransport
+ * @stream_id: an SCTP stream
+ *
+ * Returns: (transfer full) (nullable): the #WebRTCDataChannel registered for
+ *     @stream_id
+ */
+gpointer
+webrtc_sctp_transport_get_channel (WebRTCSCTPTransport * sctp,
+    guint stream_id)
+{
+  GWeakRef *ref;
+  gpointer channel = NULL;
+
+  GST_OBJECT_LOCK (sctp);
+  ref = g_hash_table_lookup (sctp->channels, GUINT_TO_POINTER (stream_id));
+  if (ref)
+    channel = g_weak_ref_get (ref);
+  GST_OBJECT_UNLOCK (sctp);
+
+  return channel;
+}
+
+static void
+_free_channel_ref (GWeakRef * ref)
+{
+  g_weak_ref_clear (ref);
+  g_free (ref);
+}
+
 static void
 webrtc_sctp_transport_get_property (GObject * object, guint prop_id,
     GValue * value, GParamSpec * pspec)
@@ -178,6 +483,18 @@ webrtc_sctp_transport_finalize (GObject * object)
 {
   WebRTCSCTPTransport *sctp = WEBRTC_SCTP_TRANSPORT (object);
 
+  webrtc_sctp_transport_stop_sending (sctp);
+  gst_queue_array_free (sctp->send_queue);
+  g_mutex_clear (&sctp->send_lock);
+  g_cond_clear (&sctp->send_cond);
+
+  if (sctp->message_pool) {
+    gst_buffer_pool_set_active (sctp->message_pool, FALSE);
+    gst_object_unref (sctp->message_pool);
+  }
+
+  g_hash_table_unref (sctp->channels);
+
   g_signal_handlers_disconnect_by_data (sctp->sctpdec, sctp);
   g_signal_handlers_disconnect_by_data (sctp->sctpenc, sctp);
 
@@ -240,8 +557,13 @@ webrtc_sctp_transport_class_init (WebRTCSCTPTransportClass * klass)
 }
 
 static void
-webrtc_sctp_transport_init (WebRTCSCTPTransport * nice)
+webrtc_sctp_transport_init (WebRTCSCTPTransport * sctp)
 {
+  g_mutex_init (&sctp->send_lock);
+  g_cond_init (&sctp->send_cond);
+  sctp->send_queue = gst_queue_array_new_for_struct (sizeof (SendItem), 16);
+  sctp->channels = g_hash_table_new_full (NULL, NULL, NULL,
+      (GDestroyNotify) _free_channel_ref);
 }
 
 WebRTCSCTPTransport *
@@ -21,6 +21,7 @@
 #define __WEBRTC_SCTP_TRANSPORT_H__
 
 #include <gst/gst.h>
+#include <gst/base/gstqueuearray.h>
 #include <gst/webrtc/webrtc.h>
 #include <gst/webrtc/sctptransport.h>
 #include "fwd.h"
@@ -56,6 +57,22 @@ struct _WebRTCSCTPTransport
   GstElement                   *sctpenc;
 
   GstWebRTCBin                 *webrtcbin;
+
+  /* direct mode: channels send through the sender thread and receive
+   * straight from sctpdec instead of going through appsrc/appsink */
+  gboolean                      direct;
+  GstBufferPool                *message_pool;
+
+  GMutex                        send_lock;
+  GCond                         send_cond;
+  GstQueueArray                *send_queue;
+  GThread                      *send_thread;
+  gboolean                      send_running;
+  gboolean                      send_stopped;
+
+  /* stream id -> GWeakRef to the WebRTCDataChannel, protected by the
+   * object lock */
+  GHashTable                   *channels;
 };
 
 struct _WebRTCSCTPTransportClass
@@ -63,8 +80,43 @@ struct _WebRTCSCTPTransportClass
   GstWebRTCSCTPTransportClass   parent_class;
 };
 
+typedef void (*WebRTCSCTPTransportSentFunc) (WebRTCSCTPTransport * sctp,
+                                             GstFlowReturn ret,
+                                             gsize size,
+                                             gpointer user_data);
+
 WebRTCSCTPTransport *           webrtc_sctp_transport_new               (void);
 
+void
+webrtc_sctp_transport_set_direct (WebRTCSCTPTransport *sctp);
+
+GstBuffer *
+webrtc_sctp_transport_acquire_buffer (WebRTCSCTPTransport *sctp,
+                                      gsize size);
+
+void
+webrtc_sctp_transport_send (WebRTCSCTPTransport *sctp,
+                            guint stream_id,
+                            GstBuffer *buffer,
+                            WebRTCSCTPTransportSentFunc func,
+                            gpointer user_data);
+
+void
+webrtc_sctp_transport_stop_sending (WebRTCSCTPTransport *sctp);
+
+void
+webrtc_sctp_transport_add_channel (WebRTCSCTPTransport *sctp,
+                                   guint stream_id,
+                                   gpointer channel);
+
+void
+webrtc_sctp_transport_remove_channel (WebRTCSCTPTransport *sctp,
+                                      guint stream_id);
+
+gpointer
+webrtc_sctp_transport_get_channel (WebRTCSCTPTransport *sctp,
+                                   guint stream_id);
+
 void
 webrtc_sctp_transport_set_priority (WebRTCSCTPTransport *sctp,
                                     GstWebRTCPriorityType priority);
@@ -121,6 +121,7 @@ that the demux object and its streams are not changed by anybody else.
 #include "gstadaptivedemux.h"
 #include <glib/gi18n-lib.h>
 #include <gst/base/gstadapter.h>
+#include <string.h>
 
 GST_DEBUG_CATEGORY (adaptivedemux_debug);
 #define GST_CAT_DEFAULT adaptivedemux_debug
@@ -131,6 +132,9 @@ GST_DEBUG_CATEGORY (adaptivedemux_debug);
 #define DEFAULT_BITRATE_LIMIT 0.8f
 #define SRC_QUEUE_MAX_BYTES 20 * 1024 * 1024    /* For safety. Large enough to hold a segment. */
 #define NUM_LOOKBACK_FRAGMENTS 3
+#define DEFAULT_PREFETCH_FRAGMENTS 0
+#define MAX_PREFETCH_FRAGMENTS 16
+#define PREFETCH_MAX_BYTES 64 * 1024 * 1024     /* Per stream, for completed prefetches */
 
 #define GST_MANIFEST_GET_LOCK(d) (&(GST_ADAPTIVE_DEMUX_CAST(d)->priv->manifest_lock))
 #define GST_MANIFEST_LOCK(d) G_STMT_START { \
@@ -157,6 +161,7 @@ enum
   PROP_0,
   PROP_CONNECTION_SPEED,
   PROP_BITRATE_LIMIT,
+  PROP_PREFETCH_FRAGMENTS,
   PROP_LAST
 };
 
@@ -207,8 +212,34 @@ struct _GstAdaptiveDemuxPrivate
   GMutex segment_lock;
 
   GstClockTime qos_earliest_time;
+
+  /* number of upcoming fragments to download ahead of time,
+   * protected by manifest_lock */
+  guint prefetch_fragments;
+  GThreadPool *prefetch_pool;   /* MT safe */
 };
 
+/* An upcoming fragment being downloaded by one of the prefetch_pool threads.
+ * Owned by the stream's prefetch_queue, or by the downloading thread once
+ * it has been dropped from the queue while still running */
+typedef struct _GstAdaptiveDemuxPrefetch
+{
+  GstAdaptiveDemuxStream *stream;
+  GstUriDownloader *downloader;
+
+  gchar *uri;
+  gint64 range_start;
+  gint64 range_end;
+
+  /* protected by the stream's fragment_download_lock */
+  gboolean done;
+  gboolean dropped;
+  GstBuffer *buffer;
+  GError *error;
+  GstClockTime download_start;
+  GstClockTime download_stop;
+} GstAdaptiveDemuxPrefetch;
+
 typedef struct _GstAdaptiveDemuxTimer
 {
   gint ref_count;
@@ -306,6 +337,10 @@ static gboolean gst_adaptive_demux_clock_callback (GstClock * clock,
 static gboolean
 gst_adaptive_demux_requires_periodical_playlist_update_default (GstAdaptiveDemux
     * demux);
+static void gst_adaptive_demux_prefetch_func (GstAdaptiveDemuxPrefetch *
+    prefetch, GstAdaptiveDemux * demux);
+static void gst_adaptive_demux_stream_clear_prefetch (GstAdaptiveDemuxStream *
+    stream);
 
 /* we can't use G_DEFINE_ABSTRACT_TYPE because we need the klass in the _init
  * method to get to the padtemplates */
@@ -363,6 +398,9 @@ gst_adaptive_demux_set_property (GObject * object, guint prop_id,
     case PROP_BITRATE_LIMIT:
       demux->bitrate_limit = g_value_get_float (value);
       break;
+    case PROP_PREFETCH_FRAGMENTS:
+      demux->priv->prefetch_fragments = g_value_get_uint (value);
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
       break;
@@ -387,6 +425,9 @@ gst_adaptive_demux_get_property (GObject * object, guint prop_id,
     case PROP_BITRATE_LIMIT:
       g_value_set_float (value, demux->bitrate_limit);
       break;
+    case PROP_PREFETCH_FRAGMENTS:
+      g_value_set_uint (value, demux->priv->prefetch_fragments);
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
       break;
@@ -432,6 +473,24 @@ gst_adaptive_demux_class_init (GstAdaptiveDemuxClass * klass)
           0, 1, DEFAULT_BITRATE_LIMIT,
           G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
 
+  /**
+   * GstAdaptiveDemux:prefetch-fragments:
+   *
+   * Number of upcoming fragments of each stream to download in parallel
+   * with the current one. Prefetched fragments are kept in memory and
+   * pushed in order once playback reaches them, which hides the request
+   * latency of short fragments on high round-trip time links. Only used
+   * if the subclass can predict upcoming fragments.
+   *
+   * Since: 1.24
+   */
+  g_object_class_install_property (gobject_class, PROP_PREFETCH_FRAGMENTS,
+      g_param_spec_uint ("prefetch-fragments", "Prefetch fragments",
+          "Number of upcoming fragments to download in parallel "
+          "(0 = download one fragment at a time)", 0, MAX_PREFETCH_FRAGMENTS,
+          DEFAULT_PREFETCH_FRAGMENTS,
+          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
   gstelement_class->change_state = gst_adaptive_demux_change_state;
 
   gstbin_class->handle_message = gst_adaptive_demux_handle_message;
@@ -522,6 +581,11 @@ gst_adaptive_demux_init (GstAdaptiveDemux * demux,
   /* Properties */
   demux->bitrate_limit = DEFAULT_BITRATE_LIMIT;
   demux->connection_speed = DEFAULT_CONNECTION_SPEED;
+  demux->priv->prefetch_fragments = DEFAULT_PREFETCH_FRAGMENTS;
+
+  demux->priv->prefetch_pool =
+      g_thread_pool_new ((GFunc) gst_adaptive_demux_prefetch_func, demux, -1,
+      FALSE, NULL);
 
   gst_element_add_pad (GST_ELEMENT (demux), demux->sinkpad);
 }
@@ -537,6 +601,9 @@ gst_adaptive_demux_finalize (GObject * object)
   g_object_unref (priv->input_adapter);
   g_object_unref (demux->downloader);
 
+  /* All prefetches were cancelled when the streams were freed */
+  g_thread_pool_free (priv->prefetch_pool, FALSE, TRUE);
+
   g_mutex_clear (&priv->updates_timed_lock);
   g_cond_clear (&priv->updates_timed_cond);
   g_mutex_clear (&demux->priv->manifest_update_lock);
@@ -1339,6 +1406,8 @@ gst_adaptive_demux_stream_new (GstAdaptiveDemux * demux, GstPad * pad)
   gst_segment_init (&stream->segment, GST_FORMAT_TIME);
   g_cond_init (&stream->fragment_download_cond);
   g_mutex_init (&stream->fragment_download_lock);
+  g_queue_init (&stream->prefetch_queue);
+  g_cond_init (&stream->prefetch_cond);
 
   demux->next_streams = g_list_append (demux->next_streams, stream);
 
@@ -1436,6 +1505,14 @@ gst_adaptive_demux_stream_free (GstAdaptiveDemuxStream * stream)
     GST_MANIFEST_LOCK (demux);
   }
 
+  /* Wait for the prefetch threads to let go of the stream */
+  g_mutex_lock (&stream->fragment_download_lock);
+  gst_adaptive_demux_stream_clear_prefetch (stream);
+  while (stream->prefetch_running > 0)
+    g_cond_wait (&stream->prefetch_cond, &stream->fragment_download_lock);
+  g_mutex_unlock (&stream->fragment_download_lock);
+
+  g_cond_clear (&stream->prefetch_cond);
   g_cond_clear (&stream->fragment_download_cond);
   g_mutex_clear (&stream->fragment_download_lock);
   g_free (stream->fragment_bitrates);
@@ -2144,6 +2221,8 @@ gst_adaptive_demux_stop_tasks (GstAdaptiveDemux * demux, gboolean stop_updates)
       stream->cancelled = TRUE;
       gst_task_stop (stream->download_task);
       g_cond_signal (&stream->fragment_download_cond);
+      /* Prefetched data is useless after a seek or a restart */
+      gst_adaptive_demux_stream_clear_prefetch (stream);
       g_mutex_unlock (&stream->fragment_download_lock);
     }
     list_to_process = demux->prepared_streams;
@@ -2578,31 +2657,16 @@ gst_adaptive_demux_requires_periodical_playlist_update_default (GstAdaptiveDemux
   return TRUE;
 }
 
+/* must be called with manifest_lock taken.
+ * Handles a buffer of the current fragment, either coming from the source
+ * element or from a prefetched download */
 static GstFlowReturn
-_src_chain (GstPad * pad, GstObject * parent, GstBuffer * buffer)
+gst_adaptive_demux_stream_chain_buffer (GstAdaptiveDemux * demux,
+    GstAdaptiveDemuxStream * stream, GstBuffer * buffer)
 {
-  GstAdaptiveDemuxStream *stream;
-  GstAdaptiveDemux *demux;
-  GstAdaptiveDemuxClass *klass;
+  GstAdaptiveDemuxClass *klass = GST_ADAPTIVE_DEMUX_GET_CLASS (demux);
   GstFlowReturn ret = GST_FLOW_OK;
 
-  demux = GST_ADAPTIVE_DEMUX_CAST (parent);
-  stream = gst_pad_get_element_private (pad);
-  klass = GST_ADAPTIVE_DEMUX_GET_CLASS (demux);
-
-  GST_MANIFEST_LOCK (demux);
-
-  /* do not make any changes if the stream is cancelled */
-  g_mutex_lock (&stream->fragment_download_lock);
-  if (G_UNLIKELY (stream->cancelled)) {
-    g_mutex_unlock (&stream->fragment_download_lock);
-    gst_buffer_unref (buffer);
-    ret = stream->last_ret = GST_FLOW_FLUSHING;
-    GST_MANIFEST_UNLOCK (demux);
-    return ret;
-  }
-  g_mutex_unlock (&stream->fragment_download_lock);
-
   /* starting_fragment is set to TRUE at the beginning of
    * _stream_download_fragment()
    * /!\ If there is a header/index being downloaded, then this will
@@ -2695,7 +2759,6 @@ _src_chain (GstPad * pad, GstObject * parent, GstBuffer * buffer)
     g_mutex_lock (&stream->fragment_download_lock);
     if (G_UNLIKELY (stream->cancelled)) {
       g_mutex_unlock (&stream->fragment_download_lock);
-      GST_MANIFEST_UNLOCK (demux);
       return ret;
     }
     g_mutex_unlock (&stream->fragment_download_lock);
@@ -2734,6 +2797,33 @@ _src_chain (GstPad * pad, GstObject * parent, GstBuffer * buffer)
   }
 
 error:
+  return ret;
+}
+
+static GstFlowReturn
+_src_chain (GstPad * pad, GstObject * parent, GstBuffer * buffer)
+{
+  GstAdaptiveDemuxStream *stream;
+  GstAdaptiveDemux *demux;
+  GstFlowReturn ret;
+
+  demux = GST_ADAPTIVE_DEMUX_CAST (parent);
+  stream = gst_pad_get_element_private (pad);
+
+  GST_MANIFEST_LOCK (demux);
+
+  /* do not make any changes if the stream is cancelled */
+  g_mutex_lock (&stream->fragment_download_lock);
+  if (G_UNLIKELY (stream->cancelled)) {
+    g_mutex_unlock (&stream->fragment_download_lock);
+    gst_buffer_unref (buffer);
+    ret = stream->last_ret = GST_FLOW_FLUSHING;
+    GST_MANIFEST_UNLOCK (demux);
+    return ret;
+  }
+  g_mutex_unlock (&stream->fragment_download_lock);
+
+  ret = gst_adaptive_demux_stream_chain_buffer (demux, stream, buffer);
 
   GST_MANIFEST_UNLOCK (demux);
 
@@ -3385,6 +3475,306 @@ gst_adaptive_demux_stream_download_header_fragment (GstAdaptiveDemuxStream *
   return ret;
 }
 
+static void
+gst_adaptive_demux_prefetch_free (GstAdaptiveDemuxPrefetch * prefetch)
+{
+  gst_object_unref (prefetch->downloader);
+  g_free (prefetch->uri);
+  if (prefetch->buffer)
+    gst_buffer_unref (prefetch->buffer);
+  g_clear_error (&prefetch->error);
+  g_free (prefetch);
+}
+
+static gboolean
+gst_adaptive_demux_prefetch_matches (GstAdaptiveDemuxPrefetch * prefetch,
+    const gchar * uri, gint64 range_start, gint64 range_end)
+{
+  return g_strcmp0 (prefetch->uri, uri) == 0
+      && prefetch->range_start == range_start
+      && prefetch->range_end == range_end;
+}
+
+/* Runs in a prefetch_pool thread, only takes the fragment_download_lock */
+static void
+gst_adaptive_demux_prefetch_func (GstAdaptiveDemuxPrefetch * prefetch,
+    GstAdaptiveDemux * demux)
+{
+  GstAdaptiveDemuxStream *stream = prefetch->stream;
+  GstFragment *download;
+  GstBuffer *buffer = NULL;
+  GError *err = NULL;
+  GstClockTime now;
+  gboolean dropped;
+
+  GST_DEBUG_OBJECT (stream->pad, "Prefetching %s, range:%" G_GINT64_FORMAT
+      " - %" G_GINT64_FORMAT, prefetch->uri, prefetch->range_start,
+      prefetch->range_end);
+
+  download = gst_uri_downloader_fetch_uri_with_range (prefetch->downloader,
+      prefetch->uri, NULL, FALSE, FALSE, TRUE, prefetch->range_start,
+      prefetch->range_end, &err);
+  if (download) {
+    buffer = gst_fragment_get_buffer (download);
+    g_object_unref (download);
+  }
+  now = gst_adaptive_demux_get_monotonic_time (demux);
+
+  g_mutex_lock (&stream->fragment_download_lock);
+  prefetch->done = TRUE;
+  prefetch->buffer = buffer;
+  prefetch->error = err;
+  prefetch->download_stop = now;
+
+  if (buffer)
+    stream->prefetch_bytes += gst_buffer_get_size (buffer);
+  if (--stream->prefetch_running == 0)
+    stream->prefetch_busy_time += now - stream->prefetch_busy_start;
+
+  GST_DEBUG_OBJECT (stream->pad, "Prefetch of %s done: %" G_GSIZE_FORMAT
+      " bytes%s", prefetch->uri, buffer ? gst_buffer_get_size (buffer) : 0,
+      prefetch->dropped ? " (dropped)" : "");
+
+  /* Once it was dropped from the queue, nobody else references it */
+  dropped = prefetch->dropped;
+  g_cond_broadcast (&stream->prefetch_cond);
+  g_mutex_unlock (&stream->fragment_download_lock);
+
+  if (dropped)
+    gst_adaptive_demux_prefetch_free (prefetch);
+}
+
+/* must be called with fragment_download_lock taken, once @prefetch is not
+ * in the stream's prefetch_queue anymore */
+static void
+gst_adaptive_demux_stream_drop_prefetch (GstAdaptiveDemuxStream * stream,
+    GstAdaptiveDemuxPrefetch * prefetch)
+{
+  if (prefetch->done) {
+    gst_adaptive_demux_prefetch_free (prefetch);
+  } else {
+    /* The downloading thread will free it when it returns */
+    prefetch->dropped = TRUE;
+    gst_uri_downloader_cancel (prefetch->downloader);
+  }
+}
+
+/* must be called with fragment_download_lock taken */
+static void
+gst_adaptive_demux_stream_clear_prefetch (GstAdaptiveDemuxStream * stream)
+{
+  GstAdaptiveDemuxPrefetch *prefetch;
+
+  while ((prefetch = g_queue_pop_head (&stream->prefetch_queue)))
+    gst_adaptive_demux_stream_drop_prefetch (stream, prefetch);
+
+  g_cond_broadcast (&stream->prefetch_cond);
+}
+
+/* must be called with manifest_lock taken.
+ * Starts downloading the fragments following the current one, up to
+ * prefetch-fragments of them, and drops the prefetches that are not going
+ * to be used anymore, e.g. after a bitrate switch */
+static void
+gst_adaptive_demux_stream_update_prefetch (GstAdaptiveDemux * demux,
+    GstAdaptiveDemuxStream * stream)
+{
+  GstAdaptiveDemuxClass *klass = GST_ADAPTIVE_DEMUX_GET_CLASS (demux);
+  GstAdaptiveDemuxStreamFragment upcoming[MAX_PREFETCH_FRAGMENTS];
+  GQueue queue = G_QUEUE_INIT;
+  GstAdaptiveDemuxPrefetch *prefetch;
+  guint64 cached_bytes = 0;
+  guint n_upcoming = 0, i;
+  GList *l;
+
+  if (klass->stream_peek_fragment_info) {
+    while (n_upcoming < demux->priv->prefetch_fragments) {
+      GstAdaptiveDemuxStreamFragment *f = &upcoming[n_upcoming];
+
+      memset (f, 0, sizeof (*f));
+      f->range_end = -1;
+      if (klass->stream_peek_fragment_info (stream, n_upcoming + 1,
+              f) != GST_FLOW_OK || f->uri == NULL) {
+        gst_adaptive_demux_stream_fragment_clear (f);
+        break;
+      }
+      n_upcoming++;
+    }
+  }
+
+  g_mutex_lock (&stream->fragment_download_lock);
+  if (G_UNLIKELY (stream->cancelled))
+    goto done;
+
+  /* Rebuild the queue in playback order, starting with the current
+   * fragment if it was prefetched already */
+  for (i = 0; i <= n_upcoming; i++) {
+    GstAdaptiveDemuxStreamFragment *f =
+        i == 0 ? &stream->fragment : &upcoming[i - 1];
+
+    prefetch = NULL;
+    for (l = stream->prefetch_queue.head; l; l = l->next) {
+      if (gst_adaptive_demux_prefetch_matches (l->data, f->uri,
+              f->range_start, f->range_end)) {
+        prefetch = l->data;
+        g_queue_delete_link (&stream->prefetch_queue, l);
+        break;
+      }
+    }
+
+    if (prefetch == NULL && i > 0 && cached_bytes < PREFETCH_MAX_BYTES) {
+      prefetch = g_new0 (GstAdaptiveDemuxPrefetch, 1);
+      prefetch->stream = stream;
+      prefetch->downloader = gst_uri_downloader_new ();
+      gst_uri_downloader_set_parent (prefetch->downloader,
+          GST_ELEMENT_CAST (demux));
+      prefetch->uri = g_strdup (f->uri);
+      prefetch->range_start = f->range_start;
+      prefetch->range_end = f->range_end;
+      prefetch->download_start = gst_adaptive_demux_get_monotonic_time (demux);
+
+      if (stream->prefetch_running++ == 0)
+        stream->prefetch_busy_start = prefetch->download_start;
+
+      g_thread_pool_push (demux->priv->prefetch_pool, prefetch, NULL);
+    }
+
+    if (prefetch) {
+      if (prefetch->buffer)
+        cached_bytes += gst_buffer_get_size (prefetch->buffer);
+      g_queue_push_tail (&queue, prefetch);
+    }
+  }
+
+  /* Whatever is left is not going to be played */
+  gst_adaptive_demux_stream_clear_prefetch (stream);
+  stream->prefetch_queue = queue;
+
+done:
+  g_mutex_unlock (&stream->fragment_download_lock);
+
+  for (i = 0; i < n_upcoming; i++)
+    gst_adaptive_demux_stream_fragment_clear (&upcoming[i]);
+}
+
+/* must be called with manifest_lock taken.
+ * Can temporarily release manifest_lock
+ *
+ * Returns the prefetch of the current fragment once it is complete, or NULL
+ * if the fragment was not prefetched or the stream got cancelled */
+static GstAdaptiveDemuxPrefetch *
+gst_adaptive_demux_stream_take_prefetch (GstAdaptiveDemux * demux,
+    GstAdaptiveDemuxStream * stream)
+{
+  GstAdaptiveDemuxPrefetch *prefetch = NULL;
+  GList *l;
+
+  g_mutex_lock (&stream->fragment_download_lock);
+  for (l = stream->prefetch_queue.head; l; l = l->next) {
+    if (gst_adaptive_demux_prefetch_matches (l->data, stream->fragment.uri,
+            stream->fragment.range_start, stream->fragment.range_end)) {
+      prefetch = l->data;
+      break;
+    }
+  }
+
+  if (prefetch && !prefetch->done) {
+    GST_DEBUG_OBJECT (stream->pad, "Waiting for prefetch of %s",
+        prefetch->uri);
+
+    g_mutex_unlock (&stream->fragment_download_lock);
+    GST_MANIFEST_UNLOCK (demux);
+
+    /* Prefetches are only dropped behind our back if we get cancelled */
+    g_mutex_lock (&stream->fragment_download_lock);
+    while (!stream->cancelled && !prefetch->done)
+      g_cond_wait (&stream->prefetch_cond, &stream->fragment_download_lock);
+    g_mutex_unlock (&stream->fragment_download_lock);
+
+    GST_MANIFEST_LOCK (demux);
+    g_mutex_lock (&stream->fragment_download_lock);
+  }
+
+  if (G_UNLIKELY (stream->cancelled))
+    prefetch = NULL;
+  else if (prefetch)
+    g_queue_remove (&stream->prefetch_queue, prefetch);
+  g_mutex_unlock (&stream->fragment_download_lock);
+
+  return prefetch;
+}
+
+/* must be called with manifest_lock taken.
+ * Pushes a prefetched fragment as if it had been downloaded by the source
+ * element */
+static GstFlowReturn
+gst_adaptive_demux_stream_push_prefetch (GstAdaptiveDemux * demux,
+    GstAdaptiveDemuxStream * stream, GstAdaptiveDemuxPrefetch * prefetch)
+{
+  GstBuffer *buffer = prefetch->buffer;
+  GstClockTime now, busy_time;
+  guint64 size, bytes;
+  GstFlowReturn ret;
+
+  prefetch->buffer = NULL;
+  size = gst_buffer_get_size (buffer);
+
+  /* The bitrate estimation is fed with the throughput of all the parallel
+   * prefetch downloads since the last fragment, not with the speed of
+   * this single download */
+  now = gst_adaptive_demux_get_monotonic_time (demux);
+  g_mutex_lock (&stream->fragment_download_lock);
+  busy_time = stream->prefetch_busy_time;
+  if (stream->prefetch_running > 0) {
+    busy_time += now - stream->prefetch_busy_start;
+    stream->prefetch_busy_start = now;
+  }
+  bytes = stream->prefetch_bytes;
+  stream->prefetch_busy_time = 0;
+  stream->prefetch_bytes = 0;
+  stream->download_finished = FALSE;
+  g_mutex_unlock (&stream->fragment_download_lock);
+
+  stream->download_start_time = GST_TIME_AS_USECONDS (prefetch->download_start);
+  stream->last_download_time =
+      prefetch->download_stop - prefetch->download_start;
+  stream->fragment_bytes_downloaded = size;
+  if (bytes > 0 && busy_time > 0)
+    stream->last_bitrate =
+        gst_util_uint64_scale (bytes, 8 * GST_SECOND, busy_time);
+  else if (stream->last_download_time > 0)
+    stream->last_bitrate = gst_util_uint64_scale (size, 8 * GST_SECOND,
+        stream->last_download_time);
+
+  GST_DEBUG_OBJECT (stream->pad, "Pushing prefetched fragment %s of size %"
+      G_GUINT64_FORMAT ", aggregate bitrate %" G_GUINT64_FORMAT " bps",
+      prefetch->uri, size, stream->last_bitrate);
+
+  /* Same as what _src_chain() does for the first buffer of a fragment */
+  if (stream->fragment.bitrate == 0 &&
+      GST_CLOCK_TIME_IS_VALID (stream->fragment.duration) &&
+      stream->fragment.duration != 0) {
+    stream->fragment.bitrate = MIN (G_MAXUINT, gst_util_uint64_scale (size,
+            8 * GST_SECOND, stream->fragment.duration));
+  }
+  if (stream->fragment.bitrate)
+    stream->bitrate_changed = TRUE;
+  stream->downloading_first_buffer = FALSE;
+
+  ret = gst_adaptive_demux_stream_chain_buffer (demux, stream, buffer);
+  if (ret == GST_FLOW_OK)
+    gst_adaptive_demux_eos_handling (stream);
+
+  g_mutex_lock (&stream->fragment_download_lock);
+  if (G_UNLIKELY (stream->cancelled)) {
+    g_mutex_unlock (&stream->fragment_download_lock);
+    return stream->last_ret = GST_FLOW_FLUSHING;
+  }
+  g_mutex_unlock (&stream->fragment_download_lock);
+
+  return stream->last_ret;
+}
+
 /* must be called with manifest_lock taken.
  * Can temporarily release manifest_lock
  */
@@ -3503,11 +3893,28 @@ again:
         chunk_end = MIN (chunk_end, range_end);
     }
   } else {
-    ret =
-        gst_adaptive_demux_stream_download_uri (demux, stream, url,
-        stream->fragment.range_start, stream->fragment.range_end, &http_status);
-    GST_DEBUG_OBJECT (stream->pad, "Fragment download result: %d (%d) %s",
-        stream->last_ret, http_status, gst_flow_get_name (stream->last_ret));
+    GstAdaptiveDemuxPrefetch *prefetch;
+
+    prefetch = gst_adaptive_demux_stream_take_prefetch (demux, stream);
+    if (prefetch && prefetch->buffer) {
+      ret = gst_adaptive_demux_stream_push_prefetch (demux, stream, prefetch);
+      gst_adaptive_demux_prefetch_free (prefetch);
+      GST_DEBUG_OBJECT (stream->pad, "Prefetched fragment result: %d %s",
+          stream->last_ret, gst_flow_get_name (stream->last_ret));
+    } else {
+      if (prefetch) {
+        GST_DEBUG_OBJECT (stream->pad, "Prefetch of %s failed (%s), "
+            "downloading it again", prefetch->uri,
+            prefetch->error ? prefetch->error->message : "no data");
+        gst_adaptive_demux_prefetch_free (prefetch);
+      }
+      ret =
+          gst_adaptive_demux_stream_download_uri (demux, stream, url,
+          stream->fragment.range_start, stream->fragment.range_end,
+          &http_status);
+      GST_DEBUG_OBJECT (stream->pad, "Fragment download result: %d (%d) %s",
+          stream->last_ret, http_status, gst_flow_get_name (stream->last_ret));
+    }
   }
   if (ret == GST_FLOW_OK)
     goto beach;
@@ -3821,6 +4228,8 @@ gst_adaptive_demux_stream_download_loop (GstAdaptiveDemuxStream * stream)
 
     stream->last_ret = GST_FLOW_OK;
 
+    gst_adaptive_demux_stream_update_prefetch (demux, stream);
+
     next_download = gst_adaptive_demux_get_monotonic_time (demux);
     ret = gst_adaptive_demux_stream_download_fragment (stream);
 
@@ -195,6 +195,16 @@ struct _GstAdaptiveDemuxStream
   gboolean eos;
 
   gboolean do_block; /* TRUE if stream should block on preroll */
+
+  /* upcoming fragments being fetched ahead of time, see the
+   * #GstAdaptiveDemux:prefetch-fragments property.
+   * All protected by fragment_download_lock */
+  GQueue prefetch_queue;
+  GCond prefetch_cond;
+  guint prefetch_running;
+  guint64 prefetch_bytes;
+  GstClockTime prefetch_busy_time;
+  GstClockTime prefetch_busy_start;
 };
 
 /**
@@ -482,6 +492,25 @@ struct _GstAdaptiveDemuxClass
    * Return: %TRUE if the playlist needs to be refreshed periodically by the demuxer.
    */
   gboolean (*requires_periodical_playlist_update) (GstAdaptiveDemux * demux);
+
+  /**
+   * stream_peek_fragment_info:
+   * @stream: #GstAdaptiveDemuxStream
+   * @n: the position of the fragment to look at, 1 being the one following
+   *     the current fragment
+   * @fragment: #GstAdaptiveDemuxStreamFragment to fill
+   *
+   * Optional. Fills the uri, byte range, timestamp and duration of
+   * @fragment with the information about the @n-th fragment after the
+   * current one, without changing the position of @stream. Used to
+   * download upcoming fragments ahead of time.
+   *
+   * Returns: #GST_FLOW_OK in success, #GST_FLOW_EOS if there is no such
+   *          fragment or it can't be predicted.
+   *
+   * Since: 1.24
+   */
+  GstFlowReturn (*stream_peek_fragment_info) (GstAdaptiveDemuxStream * stream, guint n, GstAdaptiveDemuxStreamFragment * fragment);
 };
 
 GST_ADAPTIVE_DEMUX_API
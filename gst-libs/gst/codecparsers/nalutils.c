@@ -73,12 +73,41 @@ nal_reader_init (NalReader * nr, const guint8 * data, guint size)
 
   nr->byte = 0;
   nr->bits_in_cache = 0;
-  /* fill with something other than 0 to detect emulation prevention bytes */
   nr->first_byte = 0xff;
-  nr->epb_cache = 0xff;
+  nr->next_epb = 0;
   nr->cache = 0xff;
 }
 
+/* Number of bytes searched for emulation prevention bytes at once. Bounded
+ * so that reading a slice header doesn't scan the whole slice */
+#define NAL_READER_EPB_SCAN_SIZE 256
+
+/* Returns the position of the first emulation_prevention_three_byte at or
+ * after @pos, or the end of the searched window if there is none in it */
+static guint
+nal_reader_find_epb (const guint8 * data, guint size, guint pos)
+{
+  guint end = pos + MIN (size - pos, NAL_READER_EPB_SCAN_SIZE);
+  const guint8 *p;
+
+  /* An emulation_prevention_three_byte always follows two zero bytes, look
+   * for the 0x03 bytes first with memchr(), which is vectorized on all
+   * common platforms */
+  pos = MAX (pos, 2);
+  while (pos < end) {
+    p = memchr (data + pos, 0x03, end - pos);
+    if (p == NULL)
+      break;
+
+    pos = p - data;
+    if (data[pos - 1] == 0x00 && data[pos - 2] == 0x00)
+      return pos;
+    pos++;
+  }
+
+  return end;
+}
+
 gboolean
 nal_reader_read (NalReader * nr, guint nbits)
 {
@@ -95,14 +124,19 @@ nal_reader_read (NalReader * nr, guint nbits)
     if (G_UNLIKELY (nr->byte >= nr->size))
       return FALSE;
 
-    byte = nr->data[nr->byte++];
-    nr->epb_cache = (nr->epb_cache << 8) | byte;
-
-    /* check if the byte is a emulation_prevention_three_byte */
-    if ((nr->epb_cache & 0xffffff) == 0x3) {
-      nr->n_epb++;
-      goto next_byte;
+    /* the bytes before next_epb are known not to be
+     * emulation_prevention_three_bytes */
+    if (G_UNLIKELY (nr->byte == nr->next_epb)) {
+      nr->next_epb = nal_reader_find_epb (nr->data, nr->size, nr->byte);
+      if (nr->next_epb == nr->byte) {
+        nr->n_epb++;
+        nr->byte++;
+        nr->next_epb = nr->byte;
+        goto next_byte;
+      }
     }
+
+    byte = nr->data[nr->byte++];
     nr->cache = (nr->cache << 8) | nr->first_byte;
     nr->first_byte = byte;
     nr->bits_in_cache += 8;
@@ -295,17 +329,6 @@ nal_reader_has_more_data (NalReader * nr)
 
 /***********  end of nal parser ***************/
 
-gint
-scan_for_start_codes (const guint8 * data, guint size)
-{
-  GstByteReader br;
-  gst_byte_reader_init (&br, data, size);
-
-  /* NALU not empty, so we can at least expect 1 (even 2) bytes following sc */
-  return gst_byte_reader_masked_scan_uint32 (&br, 0xffffff00, 0x00000100,
-      0, size);
-}
-
 void
 nal_writer_init (NalWriter * nw, guint nal_prefix_size, gboolean packetized)
 {
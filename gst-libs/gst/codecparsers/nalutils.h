@@ -40,6 +40,8 @@
 #include <gst/base/gstbitwriter.h>
 #include <string.h>
 
+#include "parserutils.h"
+
 guint ceil_log2 (guint32 v);
 
 typedef struct
@@ -51,7 +53,7 @@ typedef struct
   guint byte;                   /* Byte position */
   guint bits_in_cache;          /* bitpos in the cache of next bit */
   guint8 first_byte;
-  guint32 epb_cache;            /* cache 3 bytes to check emulation prevention bytes */
+  guint next_epb;               /* Position of the next byte that needs to be checked for emulation prevention */
   guint64 cache;                /* cached bytes */
 } NalReader;
 
@@ -110,6 +112,13 @@ gboolean nal_reader_get_ue (NalReader * nr, guint32 * val);
 G_GNUC_INTERNAL
 gboolean nal_reader_get_se (NalReader * nr, gint32 * val);
 
+/* parserutils.h reads from a GstBitReader, the NAL parsers from a NalReader */
+#undef CHECK_ALLOWED
+#undef READ_UINT8
+#undef READ_UINT16
+#undef READ_UINT32
+#undef READ_UINT64
+
 #define CHECK_ALLOWED_MAX_WITH_DEBUG(dbg, val, max) { \
   if (val > max) { \
     GST_WARNING ("value for '" dbg "' greater than max. value: %d, max %d", \
@@ -193,9 +202,6 @@ gboolean nal_reader_get_se (NalReader * nr, gint32 * val);
   val = tmp; \
 }
 
-G_GNUC_INTERNAL
-gint scan_for_start_codes (const guint8 * data, guint size);
-
 G_GNUC_INTERNAL
 void nal_writer_init (NalWriter * nw, guint nal_prefix_size, gboolean packetized);
 
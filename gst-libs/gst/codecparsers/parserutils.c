@@ -24,6 +24,8 @@
 
 #include "parserutils.h"
 
+#include <string.h>
+
 gboolean
 decode_vlc (GstBitReader * br, guint * res, const VLCTable * table,
     guint length)
@@ -58,3 +60,34 @@ failed:
     return FALSE;
   }
 }
+
+/* Returns the offset of the first 0x000001 start code prefix in @data that
+ * is followed by at least one more byte, or -1 if there is none */
+gint
+scan_for_start_codes (const guint8 * data, guint size)
+{
+  const guint8 *p, *end;
+
+  /* we can't find the pattern with less than 4 bytes */
+  if (G_UNLIKELY (size < 4))
+    return -1;
+
+  /* Look for the 0x01 bytes first, they are rare in coded data and
+   * memchr() is vectorized on all common platforms, so this goes through
+   * the data 16 or 32 bytes at a time instead of byte by byte */
+  p = data + 2;
+  end = data + size - 1;
+  while (p < end) {
+    p = memchr (p, 0x01, end - p);
+    if (p == NULL)
+      break;
+
+    if (p[-1] == 0x00 && p[-2] == 0x00)
+      return p - 2 - data;
+
+    /* p[0] is not 0x00, so the next 0x01 of a start code is at p + 3 */
+    p += 3;
+  }
+
+  return -1;
+}
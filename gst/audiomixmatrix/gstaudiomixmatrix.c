@@ -115,7 +115,8 @@ GST_STATIC_PAD_TEMPLATE ("src",
     GST_PAD_SRC,
     GST_PAD_ALWAYS,
     GST_STATIC_CAPS
-    ("audio/x-raw, channels = [1, max], layout = (string) interleaved, format = (string) {"
+    ("audio/x-raw, channels = [1, max], "
+        "layout = (string) { interleaved, non-interleaved }, format = (string) {"
         GST_AUDIO_NE (F32) "," GST_AUDIO_NE (F64) "," GST_AUDIO_NE (S16) ","
         GST_AUDIO_NE (S32) "}")
     );
@@ -125,7 +126,8 @@ GST_STATIC_PAD_TEMPLATE ("sink",
     GST_PAD_SINK,
     GST_PAD_ALWAYS,
     GST_STATIC_CAPS
-    ("audio/x-raw, channels = [1, max], layout = (string) interleaved, format = (string) {"
+    ("audio/x-raw, channels = [1, max], "
+        "layout = (string) { interleaved, non-interleaved }, format = (string) {"
         GST_AUDIO_NE (F32) "," GST_AUDIO_NE (F64) "," GST_AUDIO_NE (S16) ","
         GST_AUDIO_NE (S32) "}")
     );
@@ -147,6 +149,8 @@ static GstCaps *gst_audio_mix_matrix_fixate_caps (GstBaseTransform * trans,
     GstPadDirection direction, GstCaps * caps, GstCaps * othercaps);
 static GstStateChangeReturn gst_audio_mix_matrix_change_state (GstElement *
     element, GstStateChange transition);
+static void gst_audio_mix_matrix_clear_taps (GstAudioMixMatrix * self);
+static void gst_audio_mix_matrix_prepare (GstAudioMixMatrix * self);
 
 G_DEFINE_TYPE (GstAudioMixMatrix, gst_audio_mix_matrix,
     GST_TYPE_BASE_TRANSFORM);
@@ -174,11 +178,11 @@ gst_audio_mix_matrix_class_init (GstAudioMixMatrixClass * klass)
   g_object_class_install_property (gobject_class, PROP_IN_CHANNELS,
       g_param_spec_uint ("in-channels", "Input audio channels",
           "How many audio channels we have on the input side",
-          0, 64, 0, G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+          0, 256, 0, G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
   g_object_class_install_property (gobject_class, PROP_OUT_CHANNELS,
       g_param_spec_uint ("out-channels", "Output audio channels",
           "How many audio channels we have on the output side",
-          0, 64, 0, G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+          0, 256, 0, G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
   g_object_class_install_property (gobject_class, PROP_MATRIX,
       gst_param_spec_array ("matrix",
           "Input/output channel matrix",
@@ -232,6 +236,9 @@ gst_audio_mix_matrix_init (GstAudioMixMatrix * self)
   self->s16_conv_matrix = NULL;
   self->s32_conv_matrix = NULL;
   self->mode = GST_AUDIO_MIX_MATRIX_MODE_MANUAL;
+  self->format = GST_AUDIO_FORMAT_UNKNOWN;
+  gst_audio_info_init (&self->in_info);
+  gst_audio_info_init (&self->out_info);
 }
 
 static void
@@ -244,6 +251,8 @@ gst_audio_mix_matrix_dispose (GObject * object)
     self->matrix = NULL;
   }
 
+  gst_audio_mix_matrix_clear_taps (self);
+
   G_OBJECT_CLASS (gst_audio_mix_matrix_parent_class)->dispose (object);
 }
 
@@ -328,6 +337,20 @@ gst_audio_mix_matrix_set_property (GObject * object, guint prop_id,
       }
       gst_audio_mix_matrix_convert_s16_matrix (self);
       gst_audio_mix_matrix_convert_s32_matrix (self);
+
+      /* Matrix update while negotiated */
+      if (self->format != GST_AUDIO_FORMAT_UNKNOWN &&
+          GST_AUDIO_INFO_CHANNELS (&self->in_info) == self->in_channels &&
+          GST_AUDIO_INFO_CHANNELS (&self->out_info) == self->out_channels) {
+        gboolean passthrough;
+
+        GST_OBJECT_LOCK (self);
+        gst_audio_mix_matrix_prepare (self);
+        passthrough = self->kernel == GST_AUDIO_MIX_MATRIX_KERNEL_IDENTITY;
+        GST_OBJECT_UNLOCK (self);
+        gst_base_transform_set_passthrough (GST_BASE_TRANSFORM (self),
+            passthrough);
+      }
       break;
     }
     case PROP_CHANNEL_MASK:
@@ -408,132 +431,355 @@ gst_audio_mix_matrix_change_state (GstElement * element,
       g_free (self->s32_conv_matrix);
       self->s32_conv_matrix = NULL;
     }
+
+    GST_OBJECT_LOCK (self);
+    gst_audio_mix_matrix_clear_taps (self);
+    self->format = GST_AUDIO_FORMAT_UNKNOWN;
+    gst_audio_info_init (&self->in_info);
+    gst_audio_info_init (&self->out_info);
+    GST_OBJECT_UNLOCK (self);
   }
 
   return s;
 }
 
 
-static GstFlowReturn
-gst_audio_mix_matrix_transform (GstBaseTransform * vfilter,
-    GstBuffer * inbuf, GstBuffer * outbuf)
+/* Number of samples processed at once, small enough for the deinterleaved
+ * input channels and the accumulator to stay in cache */
+#define BLOCK_SIZE 256
+
+#ifdef _MSC_VER
+#define restrict __restrict
+#endif
+
+#define CONVERT_FLOAT(v) (v)
+#define CONVERT_INT(v) ((v) >> shift)
+
+/* Multiply-accumulate over a whole block. The fixed length and the restrict
+ * pointers allow the compiler to vectorize these loops without any runtime
+ * checks. */
+#define DEFINE_MAC_FUNCS(fmt, type, acctype, coeftype)                        \
+static inline void                                                            \
+gst_audio_mix_matrix_mul_##fmt (acctype * restrict acc,                       \
+    const type * restrict src, coeftype coef)                                 \
+{                                                                             \
+  guint s;                                                                    \
+                                                                              \
+  for (s = 0; s < BLOCK_SIZE; s++)                                            \
+    acc[s] = (acctype) (src[s] * coef);                                       \
+}                                                                             \
+                                                                              \
+static inline void                                                            \
+gst_audio_mix_matrix_mac_##fmt (acctype * restrict acc,                       \
+    const type * restrict src, coeftype coef)                                 \
+{                                                                             \
+  guint s;                                                                    \
+                                                                              \
+  for (s = 0; s < BLOCK_SIZE; s++)                                            \
+    acc[s] += (acctype) (src[s] * coef);                                      \
+}
+
+/* Mixes blocks of samples. The used input channels are first copied into
+ * contiguous planes, unless the input is planar already, then every output
+ * channel is accumulated from its non-zero coefficients only. */
+#define DEFINE_MIX_FUNC(fmt, type, acctype, coeftype, convert)                \
+DEFINE_MAC_FUNCS (fmt, type, acctype, coeftype)                               \
+                                                                              \
+static void                                                                   \
+gst_audio_mix_matrix_mix_##fmt (GstAudioMixMatrix * self,                     \
+    GstAudioBuffer * inbuf, GstAudioBuffer * outbuf)                          \
+{                                                                             \
+  const coeftype *coefs = self->taps_coef;                                    \
+  const type **planes = (const type **) self->in_planes;                      \
+  type *scratch = self->scratch;                                              \
+  acctype *acc = (acctype *) (scratch + self->n_used_in * BLOCK_SIZE);        \
+  guint in_channels = self->in_channels;                                      \
+  guint out_channels = self->out_channels;                                    \
+  gboolean in_planar =                                                        \
+      GST_AUDIO_INFO_LAYOUT (&inbuf->info) == GST_AUDIO_LAYOUT_NON_INTERLEAVED;\
+  gboolean out_planar =                                                       \
+      GST_AUDIO_INFO_LAYOUT (&outbuf->info) == GST_AUDIO_LAYOUT_NON_INTERLEAVED;\
+  guint in_stride = in_planar ? 1 : in_channels;                              \
+  guint out_stride = out_planar ? 1 : out_channels;                           \
+  gint shift = self->shift_bytes;                                             \
+  gsize start;                                                                \
+  guint i, o, t, s;                                                           \
+                                                                              \
+  (void) shift;                                                               \
+                                                                              \
+  for (start = 0; start < inbuf->n_samples; start += BLOCK_SIZE) {            \
+    guint n = MIN (BLOCK_SIZE, inbuf->n_samples - start);                     \
+                                                                              \
+    for (i = 0; i < self->n_used_in; i++) {                                   \
+      guint c = self->used_in[i];                                             \
+      const type *src = in_planar ? (const type *) inbuf->planes[c] + start : \
+          (const type *) inbuf->planes[0] + start * in_channels + c;          \
+                                                                              \
+      /* The last block is always copied so that whole blocks can be read */  \
+      if (in_planar && n == BLOCK_SIZE) {                                     \
+        planes[c] = src;                                                      \
+      } else {                                                                \
+        type *dest = scratch + i * BLOCK_SIZE;                                \
+                                                                              \
+        for (s = 0; s < n; s++)                                               \
+          dest[s] = src[s * in_stride];                                       \
+        planes[c] = dest;                                                     \
+      }                                                                       \
+    }                                                                         \
+                                                                              \
+    for (o = 0; o < out_channels; o++) {                                      \
+      guint first = self->taps_offset[o], last = self->taps_offset[o + 1];    \
+      type *dest = out_planar ? (type *) outbuf->planes[o] + start :          \
+          (type *) outbuf->planes[0] + start * out_channels + o;              \
+                                                                              \
+      if (first == last) {                                                    \
+        for (s = 0; s < n; s++)                                               \
+          dest[s * out_stride] = 0;                                           \
+        continue;                                                             \
+      }                                                                       \
+                                                                              \
+      gst_audio_mix_matrix_mul_##fmt (acc, planes[self->taps_in[first]],      \
+          coefs[first]);                                                      \
+      for (t = first + 1; t < last; t++)                                      \
+        gst_audio_mix_matrix_mac_##fmt (acc, planes[self->taps_in[t]],        \
+            coefs[t]);                                                        \
+                                                                              \
+      for (s = 0; s < n; s++)                                                 \
+        dest[s * out_stride] = (type) convert (acc[s]);                       \
+    }                                                                         \
+  }                                                                           \
+}
+
+DEFINE_MIX_FUNC (f32, gfloat, gfloat, gfloat, CONVERT_FLOAT)
+DEFINE_MIX_FUNC (f64, gdouble, gdouble, gdouble, CONVERT_FLOAT)
+DEFINE_MIX_FUNC (s16, gint16, gint32, gint32, CONVERT_INT)
+DEFINE_MIX_FUNC (s32, gint32, gint64, gint64, CONVERT_INT)
+
+/* For matrices where every output channel is a copy of at most one input
+ * channel */
+#define DEFINE_PERMUTE_FUNC(fmt, type)                                        \
+static void                                                                   \
+gst_audio_mix_matrix_permute_##fmt (GstAudioMixMatrix * self,                 \
+    GstAudioBuffer * inbuf, GstAudioBuffer * outbuf)                          \
+{                                                                             \
+  gboolean in_planar =                                                        \
+      GST_AUDIO_INFO_LAYOUT (&inbuf->info) == GST_AUDIO_LAYOUT_NON_INTERLEAVED;\
+  gboolean out_planar =                                                       \
+      GST_AUDIO_INFO_LAYOUT (&outbuf->info) == GST_AUDIO_LAYOUT_NON_INTERLEAVED;\
+  guint in_stride = in_planar ? 1 : self->in_channels;                        \
+  guint out_stride = out_planar ? 1 : self->out_channels;                     \
+  gsize n = inbuf->n_samples, s;                                              \
+  guint o;                                                                    \
+                                                                              \
+  for (o = 0; o < self->out_channels; o++) {                                  \
+    type *dest = out_planar ? (type *) outbuf->planes[o] :                    \
+        (type *) outbuf->planes[0] + o;                                       \
+                                                                              \
+    if (self->taps_offset[o] == self->taps_offset[o + 1]) {                   \
+      for (s = 0; s < n; s++)                                                 \
+        dest[s * out_stride] = 0;                                             \
+    } else {                                                                  \
+      guint c = self->taps_in[self->taps_offset[o]];                          \
+      const type *src = in_planar ? (const type *) inbuf->planes[c] :         \
+          (const type *) inbuf->planes[0] + c;                                \
+                                                                              \
+      for (s = 0; s < n; s++)                                                 \
+        dest[s * out_stride] = src[s * in_stride];                            \
+    }                                                                         \
+  }                                                                           \
+}
+
+DEFINE_PERMUTE_FUNC (f32, gfloat)
+DEFINE_PERMUTE_FUNC (f64, gdouble)
+DEFINE_PERMUTE_FUNC (s16, gint16)
+DEFINE_PERMUTE_FUNC (s32, gint32)
+
+static void
+gst_audio_mix_matrix_clear_taps (GstAudioMixMatrix * self)
 {
-  GstMapInfo inmap, outmap;
-  GstAudioMixMatrix *self = GST_AUDIO_MIX_MATRIX (vfilter);
-  gint in, out, sample;
-  guint inchannels = self->in_channels;
-  guint outchannels = self->out_channels;
-  gdouble *matrix = self->matrix;
+  g_clear_pointer (&self->taps_offset, g_free);
+  g_clear_pointer (&self->taps_in, g_free);
+  g_clear_pointer (&self->taps_coef, g_free);
+  g_clear_pointer (&self->used_in, g_free);
+  g_clear_pointer (&self->in_planes, g_free);
+  g_clear_pointer (&self->scratch, g_free);
+  self->n_used_in = 0;
+  self->kernel = GST_AUDIO_MIX_MATRIX_KERNEL_NONE;
+  self->mix_func = NULL;
+}
 
-  if (!gst_buffer_map (inbuf, &inmap, GST_MAP_READ)) {
-    return GST_FLOW_ERROR;
+/* Picks the kernel for the current matrix and format: only the non-zero
+ * coefficients of every output channel are kept, and matrices that only copy
+ * or reorder channels don't need any arithmetic. Call with the object lock
+ * held. */
+static void
+gst_audio_mix_matrix_prepare (GstAudioMixMatrix * self)
+{
+  guint in_channels = self->in_channels;
+  guint out_channels = self->out_channels;
+  guint in, out, n_taps = 0;
+  gboolean permute = TRUE, identity = in_channels == out_channels;
+  gsize bps, acc_size;
+  gboolean *used;
+
+  gst_audio_mix_matrix_clear_taps (self);
+
+  if (!self->matrix || self->format == GST_AUDIO_FORMAT_UNKNOWN)
+    return;
+
+  switch (self->format) {
+    case GST_AUDIO_FORMAT_F32:
+      bps = acc_size = sizeof (gfloat);
+      break;
+    case GST_AUDIO_FORMAT_F64:
+      bps = acc_size = sizeof (gdouble);
+      break;
+    case GST_AUDIO_FORMAT_S16:
+      /* Also sets the shift for this format */
+      gst_audio_mix_matrix_convert_s16_matrix (self);
+      bps = sizeof (gint16);
+      acc_size = sizeof (gint32);
+      break;
+    case GST_AUDIO_FORMAT_S32:
+      gst_audio_mix_matrix_convert_s32_matrix (self);
+      bps = sizeof (gint32);
+      acc_size = sizeof (gint64);
+      break;
+    default:
+      return;
   }
-  if (!gst_buffer_map (outbuf, &outmap, GST_MAP_WRITE)) {
-    gst_buffer_unmap (inbuf, &inmap);
-    return GST_FLOW_ERROR;
+
+  self->taps_offset = g_new (guint, out_channels + 1);
+  self->taps_in = g_new (guint, in_channels * out_channels);
+  self->taps_coef = g_malloc (in_channels * out_channels * acc_size);
+  used = g_new0 (gboolean, in_channels);
+
+  for (out = 0; out < out_channels; out++) {
+    guint first = n_taps;
+
+    self->taps_offset[out] = n_taps;
+
+    for (in = 0; in < in_channels; in++) {
+      guint idx = out * in_channels + in;
+
+      /* Coefficients that are zero after conversion don't contribute */
+      switch (self->format) {
+        case GST_AUDIO_FORMAT_F32:
+          if ((gfloat) self->matrix[idx] == 0)
+            continue;
+          ((gfloat *) self->taps_coef)[n_taps] = self->matrix[idx];
+          break;
+        case GST_AUDIO_FORMAT_F64:
+          if (self->matrix[idx] == 0)
+            continue;
+          ((gdouble *) self->taps_coef)[n_taps] = self->matrix[idx];
+          break;
+        case GST_AUDIO_FORMAT_S16:
+          if (self->s16_conv_matrix[idx] == 0)
+            continue;
+          ((gint32 *) self->taps_coef)[n_taps] = self->s16_conv_matrix[idx];
+          break;
+        case GST_AUDIO_FORMAT_S32:
+          if (self->s32_conv_matrix[idx] == 0)
+            continue;
+          ((gint64 *) self->taps_coef)[n_taps] = self->s32_conv_matrix[idx];
+          break;
+        default:
+          g_assert_not_reached ();
+      }
+
+      self->taps_in[n_taps++] = in;
+      used[in] = TRUE;
+    }
+
+    if (n_taps - first > 1 || (n_taps - first == 1
+            && self->matrix[out * in_channels + self->taps_in[first]] != 1.0))
+      permute = FALSE;
+    if (n_taps - first != 1 || self->taps_in[first] != out)
+      identity = FALSE;
+  }
+  self->taps_offset[out_channels] = n_taps;
+
+  self->used_in = g_new (guint, in_channels);
+  for (in = 0; in < in_channels; in++) {
+    if (used[in])
+      self->used_in[self->n_used_in++] = in;
+  }
+  g_free (used);
+
+  if (identity && GST_AUDIO_INFO_LAYOUT (&self->in_info) ==
+      GST_AUDIO_INFO_LAYOUT (&self->out_info)) {
+    self->kernel = GST_AUDIO_MIX_MATRIX_KERNEL_IDENTITY;
+  } else if (permute) {
+    self->kernel = GST_AUDIO_MIX_MATRIX_KERNEL_PERMUTE;
+  } else {
+    self->kernel = GST_AUDIO_MIX_MATRIX_KERNEL_MIX;
+    self->in_planes = g_new0 (gconstpointer, in_channels);
+    self->scratch = g_malloc0 (self->n_used_in * BLOCK_SIZE * bps +
+        BLOCK_SIZE * acc_size);
   }
 
   switch (self->format) {
-    case GST_AUDIO_FORMAT_F32LE:
-    case GST_AUDIO_FORMAT_F32BE:{
-      const gfloat *inarray;
-      gfloat *outarray;
-      guint n_samples = outmap.size / (sizeof (gfloat) * outchannels);
-
-      inarray = (gfloat *) inmap.data;
-      outarray = (gfloat *) outmap.data;
-
-      for (sample = 0; sample < n_samples; sample++) {
-        for (out = 0; out < outchannels; out++) {
-          gfloat outval = 0;
-          for (in = 0; in < inchannels; in++) {
-            outval +=
-                inarray[sample * inchannels +
-                in] * matrix[out * inchannels + in];
-          }
-          outarray[sample * outchannels + out] = outval;
-        }
-      }
+    case GST_AUDIO_FORMAT_F32:
+      self->mix_func = permute ? gst_audio_mix_matrix_permute_f32 :
+          gst_audio_mix_matrix_mix_f32;
       break;
-    }
-    case GST_AUDIO_FORMAT_F64LE:
-    case GST_AUDIO_FORMAT_F64BE:{
-      const gdouble *inarray;
-      gdouble *outarray;
-      guint n_samples = outmap.size / (sizeof (gdouble) * outchannels);
-
-      inarray = (gdouble *) inmap.data;
-      outarray = (gdouble *) outmap.data;
-
-      for (sample = 0; sample < n_samples; sample++) {
-        for (out = 0; out < outchannels; out++) {
-          gdouble outval = 0;
-          for (in = 0; in < inchannels; in++) {
-            outval +=
-                inarray[sample * inchannels +
-                in] * matrix[out * inchannels + in];
-          }
-          outarray[sample * outchannels + out] = outval;
-        }
-      }
+    case GST_AUDIO_FORMAT_F64:
+      self->mix_func = permute ? gst_audio_mix_matrix_permute_f64 :
+          gst_audio_mix_matrix_mix_f64;
       break;
-    }
-    case GST_AUDIO_FORMAT_S16LE:
-    case GST_AUDIO_FORMAT_S16BE:{
-      const gint16 *inarray;
-      gint16 *outarray;
-      guint n_samples = outmap.size / (sizeof (gint16) * outchannels);
-      guint n = self->shift_bytes;
-      gint32 *conv_matrix = self->s16_conv_matrix;
-
-      inarray = (gint16 *) inmap.data;
-      outarray = (gint16 *) outmap.data;
-
-      for (sample = 0; sample < n_samples; sample++) {
-        for (out = 0; out < outchannels; out++) {
-          gint32 outval = 0;
-          for (in = 0; in < inchannels; in++) {
-            outval += (gint32) (inarray[sample * inchannels + in] *
-                conv_matrix[out * inchannels + in]);
-          }
-          outarray[sample * outchannels + out] = (gint16) (outval >> n);
-        }
-      }
+    case GST_AUDIO_FORMAT_S16:
+      self->mix_func = permute ? gst_audio_mix_matrix_permute_s16 :
+          gst_audio_mix_matrix_mix_s16;
       break;
-    }
-    case GST_AUDIO_FORMAT_S32LE:
-    case GST_AUDIO_FORMAT_S32BE:{
-      const gint32 *inarray;
-      gint32 *outarray;
-      guint n_samples = outmap.size / (sizeof (gint32) * outchannels);
-      guint n = self->shift_bytes;
-      gint64 *conv_matrix = self->s32_conv_matrix;
-
-      inarray = (gint32 *) inmap.data;
-      outarray = (gint32 *) outmap.data;
-
-      for (sample = 0; sample < n_samples; sample++) {
-        for (out = 0; out < outchannels; out++) {
-          gint64 outval = 0;
-          for (in = 0; in < inchannels; in++) {
-            outval += (gint64) (inarray[sample * inchannels + in] *
-                conv_matrix[out * inchannels + in]);
-          }
-          outarray[sample * outchannels + out] = (gint32) (outval >> n);
-        }
-      }
+    case GST_AUDIO_FORMAT_S32:
+      self->mix_func = permute ? gst_audio_mix_matrix_permute_s32 :
+          gst_audio_mix_matrix_mix_s32;
       break;
-    }
     default:
-      gst_buffer_unmap (inbuf, &inmap);
-      gst_buffer_unmap (outbuf, &outmap);
-      return GST_FLOW_NOT_SUPPORTED;
+      g_assert_not_reached ();
+  }
 
+  GST_DEBUG_OBJECT (self, "Using %s kernel, %u of %u coefficients non-zero",
+      self->kernel == GST_AUDIO_MIX_MATRIX_KERNEL_IDENTITY ? "identity" :
+      self->kernel == GST_AUDIO_MIX_MATRIX_KERNEL_PERMUTE ? "permute" : "mix",
+      n_taps, in_channels * out_channels);
+}
+
+static GstFlowReturn
+gst_audio_mix_matrix_transform (GstBaseTransform * vfilter,
+    GstBuffer * inbuf, GstBuffer * outbuf)
+{
+  GstAudioMixMatrix *self = GST_AUDIO_MIX_MATRIX (vfilter);
+  GstAudioBuffer inabuf, outabuf;
+  GstFlowReturn ret = GST_FLOW_OK;
+
+  if (GST_AUDIO_INFO_LAYOUT (&self->out_info) ==
+      GST_AUDIO_LAYOUT_NON_INTERLEAVED && !gst_buffer_get_audio_meta (outbuf)) {
+    gst_buffer_add_audio_meta (outbuf, &self->out_info,
+        gst_buffer_get_size (outbuf) / GST_AUDIO_INFO_BPF (&self->out_info),
+        NULL);
+  }
+
+  if (!gst_audio_buffer_map (&inabuf, &self->in_info, inbuf, GST_MAP_READ))
+    return GST_FLOW_ERROR;
+  if (!gst_audio_buffer_map (&outabuf, &self->out_info, outbuf,
+          GST_MAP_WRITE)) {
+    gst_audio_buffer_unmap (&inabuf);
+    return GST_FLOW_ERROR;
   }
 
-  gst_buffer_unmap (inbuf, &inmap);
-  gst_buffer_unmap (outbuf, &outmap);
-  return GST_FLOW_OK;
+  GST_OBJECT_LOCK (self);
+  if (self->mix_func && outabuf.n_samples == inabuf.n_samples)
+    self->mix_func (self, &inabuf, &outabuf);
+  else
+    ret = GST_FLOW_NOT_SUPPORTED;
+  GST_OBJECT_UNLOCK (self);
+
+  gst_audio_buffer_unmap (&inabuf);
+  gst_audio_buffer_unmap (&outabuf);
+
+  return ret;
 }
 
 static gboolean
@@ -556,6 +802,7 @@ gst_audio_mix_matrix_set_caps (GstBaseTransform * trans, GstCaps * incaps,
 {
   GstAudioMixMatrix *self = GST_AUDIO_MIX_MATRIX (trans);
   GstAudioInfo info, out_info;
+  gboolean passthrough;
 
   if (!gst_audio_info_from_caps (&info, incaps))
     return FALSE;
@@ -571,6 +818,7 @@ gst_audio_mix_matrix_set_caps (GstBaseTransform * trans, GstCaps * incaps,
     self->in_channels = info.channels;
     self->out_channels = out_info.channels;
 
+    g_free (self->matrix);
     self->matrix = g_new (gdouble, self->in_channels * self->out_channels);
 
     for (out = 0; out < self->out_channels; out++) {
@@ -586,20 +834,15 @@ gst_audio_mix_matrix_set_caps (GstBaseTransform * trans, GstCaps * incaps,
     return FALSE;
   }
 
-  switch (self->format) {
-    case GST_AUDIO_FORMAT_S16LE:
-    case GST_AUDIO_FORMAT_S16BE:{
-      gst_audio_mix_matrix_convert_s16_matrix (self);
-      break;
-    }
-    case GST_AUDIO_FORMAT_S32LE:
-    case GST_AUDIO_FORMAT_S32BE:{
-      gst_audio_mix_matrix_convert_s32_matrix (self);
-      break;
-    }
-    default:
-      break;
-  }
+  GST_OBJECT_LOCK (self);
+  self->in_info = info;
+  self->out_info = out_info;
+  gst_audio_mix_matrix_prepare (self);
+  passthrough = self->kernel == GST_AUDIO_MIX_MATRIX_KERNEL_IDENTITY;
+  GST_OBJECT_UNLOCK (self);
+
+  gst_base_transform_set_passthrough (trans, passthrough);
+
   return TRUE;
 }
 
@@ -43,6 +43,17 @@ typedef enum _GstAudioMixMatrixMode
   GST_AUDIO_MIX_MATRIX_MODE_FIRST_CHANNELS = 1
 } GstAudioMixMatrixMode;
 
+typedef enum
+{
+  GST_AUDIO_MIX_MATRIX_KERNEL_NONE,
+  GST_AUDIO_MIX_MATRIX_KERNEL_MIX,
+  GST_AUDIO_MIX_MATRIX_KERNEL_PERMUTE,
+  GST_AUDIO_MIX_MATRIX_KERNEL_IDENTITY
+} GstAudioMixMatrixKernel;
+
+typedef void (*GstAudioMixMatrixFunc) (GstAudioMixMatrix * self,
+    GstAudioBuffer * inbuf, GstAudioBuffer * outbuf);
+
 /**
  * GstAudioMixMatrix:
  *
@@ -63,6 +74,23 @@ struct _GstAudioMixMatrix
   gint shift_bytes;
 
   GstAudioFormat format;
+  GstAudioInfo in_info;
+  GstAudioInfo out_info;
+
+  /* Prepared from the matrix by gst_audio_mix_matrix_prepare(), protected
+   * by the object lock */
+  GstAudioMixMatrixKernel kernel;
+  GstAudioMixMatrixFunc mix_func;
+  /* Non-zero coefficients of output channel o are taps
+   * taps_offset[o] .. taps_offset[o + 1] - 1 */
+  guint *taps_offset;
+  guint *taps_in;
+  gpointer taps_coef;
+  /* Input channels used by at least one tap */
+  guint n_used_in;
+  guint *used_in;
+  gconstpointer *in_planes;
+  gpointer scratch;
 };
 
 struct _GstAudioMixMatrixClass
@@ -26,6 +26,11 @@
  * @title: bayer2rgb
  *
  * Decodes raw camera bayer (fourcc BA81) to RGB.
+ *
+ * Besides 8 bit bayer, 10, 12, 14 and 16 bit samples in 16 bit words
+ * (formats like `bggr10le`) and MIPI CSI-2 packed 10 and 12 bit samples
+ * (`bggr10p`, `bggr12p`) are accepted since 1.24. Those can also be output
+ * as 16 bit per component RGB.
  */
 
 /*
@@ -100,6 +105,79 @@ enum
   GST_BAYER_2_RGB_FORMAT_RGGB
 };
 
+/* How the samples of a row are stored */
+typedef enum
+{
+  GST_BAYER_2_RGB_PACKING_8,
+  GST_BAYER_2_RGB_PACKING_16LE,
+  GST_BAYER_2_RGB_PACKING_16BE,
+  /* MIPI CSI-2 RAW10: 4 samples in 5 bytes, the low bits in the last one */
+  GST_BAYER_2_RGB_PACKING_10P,
+  /* MIPI CSI-2 RAW12: 2 samples in 3 bytes, the low bits in the last one */
+  GST_BAYER_2_RGB_PACKING_12P
+} GstBayer2RGBPacking;
+
+typedef struct
+{
+  const gchar *suffix;
+  gint bits;
+  GstBayer2RGBPacking packing;
+} GstBayer2RGBDepth;
+
+/* The format names are the bayer order followed by one of these */
+static const GstBayer2RGBDepth bayer_depths[] = {
+  {"", 8, GST_BAYER_2_RGB_PACKING_8},
+  {"10le", 10, GST_BAYER_2_RGB_PACKING_16LE},
+  {"10be", 10, GST_BAYER_2_RGB_PACKING_16BE},
+  {"12le", 12, GST_BAYER_2_RGB_PACKING_16LE},
+  {"12be", 12, GST_BAYER_2_RGB_PACKING_16BE},
+  {"14le", 14, GST_BAYER_2_RGB_PACKING_16LE},
+  {"14be", 14, GST_BAYER_2_RGB_PACKING_16BE},
+  {"16le", 16, GST_BAYER_2_RGB_PACKING_16LE},
+  {"16be", 16, GST_BAYER_2_RGB_PACKING_16BE},
+  {"10p", 10, GST_BAYER_2_RGB_PACKING_10P},
+  {"12p", 12, GST_BAYER_2_RGB_PACKING_12P},
+};
+
+static const gchar *bayer_orders[] = { "bggr", "gbrg", "grbg", "rggb" };
+
+/**
+ * GstBayer2RGBMethod:
+ * @GST_BAYER_2_RGB_METHOD_BILINEAR: Bilinear interpolation
+ * @GST_BAYER_2_RGB_METHOD_MALVAR_HE_CUTLER: Gradient corrected bilinear
+ *     interpolation, from "High-quality linear interpolation for demosaicing
+ *     of Bayer-patterned color images" by Malvar, He and Cutler
+ *
+ * Since: 1.24
+ */
+typedef enum
+{
+  GST_BAYER_2_RGB_METHOD_BILINEAR,
+  GST_BAYER_2_RGB_METHOD_MALVAR_HE_CUTLER
+} GstBayer2RGBMethod;
+
+#define GST_TYPE_BAYER_2_RGB_METHOD (gst_bayer2rgb_method_get_type ())
+static GType
+gst_bayer2rgb_method_get_type (void)
+{
+  static GType method_type = 0;
+
+  static const GEnumValue method_types[] = {
+    {GST_BAYER_2_RGB_METHOD_BILINEAR, "Bilinear", "bilinear"},
+    {GST_BAYER_2_RGB_METHOD_MALVAR_HE_CUTLER, "Malvar-He-Cutler",
+        "malvar-he-cutler"},
+    {0, NULL, NULL}
+  };
+
+  if (!method_type) {
+    method_type = g_enum_register_static ("GstBayer2RGBMethod", method_types);
+  }
+  return method_type;
+}
+
+#define DEFAULT_METHOD GST_BAYER_2_RGB_METHOD_BILINEAR
+#define DEFAULT_N_THREADS 1
+
 
 #define GST_TYPE_BAYER2RGB            (gst_bayer2rgb_get_type())
 #define GST_BAYER2RGB(obj)            (G_TYPE_CHECK_INSTANCE_CAST((obj),GST_TYPE_BAYER2RGB,GstBayer2RGB))
@@ -112,6 +190,22 @@ typedef struct _GstBayer2RGBClass GstBayer2RGBClass;
 
 typedef void (*GstBayer2RGBProcessFunc) (GstBayer2RGB *, guint8 *, guint);
 
+/* Rows [y0, y1) of the output, converted by one thread */
+typedef struct
+{
+  GstBayer2RGB *bayer2rgb;
+  guint8 *dest;
+  int dest_stride;
+  const guint8 *src;
+  int src_stride;
+  int y0, y1;
+  GstBayer2RGBMethod method;
+
+  /* kept across frames, see gst_bayer2rgb_slice_get_scratch() */
+  gpointer scratch;
+  gsize scratch_size;
+} GstBayer2RGBSlice;
+
 struct _GstBayer2RGB
 {
   GstBaseTransform basetransform;
@@ -123,7 +217,21 @@ struct _GstBayer2RGB
   int r_off;                    /* offset for red */
   int g_off;                    /* offset for green */
   int b_off;                    /* offset for blue */
+  int a_off;                    /* offset for alpha or padding */
   int format;
+  const GstBayer2RGBDepth *depth;
+  int out_bpc;                  /* bytes per output component */
+
+  /* properties */
+  GstBayer2RGBMethod method;
+  guint n_threads;
+
+  GThreadPool *pool;
+  GMutex slices_lock;
+  GCond slices_cond;
+  GstBayer2RGBSlice *slices;
+  int n_slices;
+  int slices_pending;
 };
 
 struct _GstBayer2RGBClass
@@ -132,14 +240,14 @@ struct _GstBayer2RGBClass
 };
 
 #define	SRC_CAPS                                 \
-  GST_VIDEO_CAPS_MAKE ("{ RGBx, xRGB, BGRx, xBGR, RGBA, ARGB, BGRA, ABGR }")
-
-#define SINK_CAPS "video/x-bayer,format=(string){bggr,grbg,gbrg,rggb}," \
-  "width=(int)[1,MAX],height=(int)[1,MAX],framerate=(fraction)[0/1,MAX]"
+  GST_VIDEO_CAPS_MAKE ("{ RGBx, xRGB, BGRx, xBGR, RGBA, ARGB, BGRA, ABGR, " \
+      "RGBA64_LE, ARGB64_LE, BGRA64_LE, ABGR64_LE }")
 
 enum
 {
-  PROP_0
+  PROP_0,
+  PROP_METHOD,
+  PROP_N_THREADS
 };
 
 GType gst_bayer2rgb_get_type (void);
@@ -163,6 +271,73 @@ static GstCaps *gst_bayer2rgb_transform_caps (GstBaseTransform * base,
     GstPadDirection direction, GstCaps * caps, GstCaps * filter);
 static gboolean gst_bayer2rgb_get_unit_size (GstBaseTransform * base,
     GstCaps * caps, gsize * size);
+static gboolean gst_bayer2rgb_stop (GstBaseTransform * base);
+static void gst_bayer2rgb_finalize (GObject * object);
+
+static GstCaps *
+gst_bayer2rgb_sink_caps (void)
+{
+  GString *s = g_string_new ("video/x-bayer,format=(string){");
+  GstCaps *caps;
+  guint i, j;
+
+  for (i = 0; i < G_N_ELEMENTS (bayer_depths); i++) {
+    for (j = 0; j < G_N_ELEMENTS (bayer_orders); j++) {
+      g_string_append_printf (s, "%s%s%s", i || j ? "," : "",
+          bayer_orders[j], bayer_depths[i].suffix);
+    }
+  }
+  g_string_append (s, "},width=(int)[1,MAX],height=(int)[1,MAX],"
+      "framerate=(fraction)[0/1,MAX]");
+
+  caps = gst_caps_from_string (s->str);
+  g_string_free (s, TRUE);
+
+  return caps;
+}
+
+/* Bytes per row of bayer samples, before padding. Packed rows always end
+ * with a complete group, the low bits of a partial one are still in its
+ * last byte. */
+static gsize
+gst_bayer2rgb_row_size (const GstBayer2RGBDepth * depth, int width)
+{
+  switch (depth->packing) {
+    case GST_BAYER_2_RGB_PACKING_8:
+      return width;
+    case GST_BAYER_2_RGB_PACKING_10P:
+      return ((gsize) width + 3) / 4 * 5;
+    case GST_BAYER_2_RGB_PACKING_12P:
+      return ((gsize) width + 1) / 2 * 3;
+    default:
+      return (gsize) width * 2;
+  }
+}
+
+static const GstBayer2RGBDepth *
+gst_bayer2rgb_parse_format (const gchar * format, int *order)
+{
+  guint i;
+
+  if (!format || strlen (format) < 4)
+    return NULL;
+
+  for (i = 0; i < G_N_ELEMENTS (bayer_orders); i++) {
+    if (strncmp (format, bayer_orders[i], 4) == 0)
+      break;
+  }
+  if (i == G_N_ELEMENTS (bayer_orders))
+    return NULL;
+  /* the order of bayer_orders matches the GST_BAYER_2_RGB_FORMAT_* */
+  *order = i;
+
+  for (i = 0; i < G_N_ELEMENTS (bayer_depths); i++) {
+    if (strcmp (format + 4, bayer_depths[i].suffix) == 0)
+      return &bayer_depths[i];
+  }
+
+  return NULL;
+}
 
 
 static void
@@ -176,6 +351,33 @@ gst_bayer2rgb_class_init (GstBayer2RGBClass * klass)
 
   gobject_class->set_property = gst_bayer2rgb_set_property;
   gobject_class->get_property = gst_bayer2rgb_get_property;
+  gobject_class->finalize = gst_bayer2rgb_finalize;
+
+  /**
+   * GstBayer2RGB:method:
+   *
+   * Interpolation used to reconstruct the missing components.
+   *
+   * Since: 1.24
+   */
+  g_object_class_install_property (gobject_class, PROP_METHOD,
+      g_param_spec_enum ("method", "Method", "Demosaicing method",
+          GST_TYPE_BAYER_2_RGB_METHOD, DEFAULT_METHOD,
+          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
+  /**
+   * GstBayer2RGB:n-threads:
+   *
+   * Maximum number of threads to convert each frame with, 0 for the number
+   * of processors.
+   *
+   * Since: 1.24
+   */
+  g_object_class_install_property (gobject_class, PROP_N_THREADS,
+      g_param_spec_uint ("n-threads", "Threads",
+          "Maximum number of threads to use (0 = number of processors)", 0,
+          G_MAXINT, DEFAULT_N_THREADS,
+          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
 
   gst_element_class_set_static_metadata (gstelement_class,
       "Bayer to RGB decoder for cameras", "Filter/Converter/Video",
@@ -187,7 +389,7 @@ gst_bayer2rgb_class_init (GstBayer2RGBClass * klass)
           gst_caps_from_string (SRC_CAPS)));
   gst_element_class_add_pad_template (gstelement_class,
       gst_pad_template_new ("sink", GST_PAD_SINK, GST_PAD_ALWAYS,
-          gst_caps_from_string (SINK_CAPS)));
+          gst_bayer2rgb_sink_caps ()));
 
   GST_BASE_TRANSFORM_CLASS (klass)->transform_caps =
       GST_DEBUG_FUNCPTR (gst_bayer2rgb_transform_caps);
@@ -197,25 +399,83 @@ gst_bayer2rgb_class_init (GstBayer2RGBClass * klass)
       GST_DEBUG_FUNCPTR (gst_bayer2rgb_set_caps);
   GST_BASE_TRANSFORM_CLASS (klass)->transform =
       GST_DEBUG_FUNCPTR (gst_bayer2rgb_transform);
+  GST_BASE_TRANSFORM_CLASS (klass)->stop =
+      GST_DEBUG_FUNCPTR (gst_bayer2rgb_stop);
 
   GST_DEBUG_CATEGORY_INIT (gst_bayer2rgb_debug, "bayer2rgb", 0,
       "bayer2rgb element");
+
+  gst_type_mark_as_plugin_api (GST_TYPE_BAYER_2_RGB_METHOD, 0);
 }
 
 static void
 gst_bayer2rgb_init (GstBayer2RGB * filter)
 {
   gst_bayer2rgb_reset (filter);
+  filter->method = DEFAULT_METHOD;
+  filter->n_threads = DEFAULT_N_THREADS;
+  g_mutex_init (&filter->slices_lock);
+  g_cond_init (&filter->slices_cond);
   gst_base_transform_set_in_place (GST_BASE_TRANSFORM (filter), TRUE);
 }
 
-/* No properties are implemented, so only a warning is produced */
+static void
+gst_bayer2rgb_free_slices (GstBayer2RGB * filter)
+{
+  int i;
+
+  for (i = 0; i < filter->n_slices; i++)
+    g_free (filter->slices[i].scratch);
+  g_free (filter->slices);
+  filter->slices = NULL;
+  filter->n_slices = 0;
+}
+
+static void
+gst_bayer2rgb_finalize (GObject * object)
+{
+  GstBayer2RGB *filter = GST_BAYER2RGB (object);
+
+  if (filter->pool)
+    g_thread_pool_free (filter->pool, FALSE, TRUE);
+  gst_bayer2rgb_free_slices (filter);
+  g_mutex_clear (&filter->slices_lock);
+  g_cond_clear (&filter->slices_cond);
+
+  G_OBJECT_CLASS (parent_class)->finalize (object);
+}
+
+static gboolean
+gst_bayer2rgb_stop (GstBaseTransform * base)
+{
+  GstBayer2RGB *filter = GST_BAYER2RGB (base);
+
+  if (filter->pool) {
+    g_thread_pool_free (filter->pool, FALSE, TRUE);
+    filter->pool = NULL;
+  }
+  gst_bayer2rgb_free_slices (filter);
+
+  return TRUE;
+}
+
 static void
 gst_bayer2rgb_set_property (GObject * object, guint prop_id,
     const GValue * value, GParamSpec * pspec)
 {
+  GstBayer2RGB *filter = GST_BAYER2RGB (object);
 
   switch (prop_id) {
+    case PROP_METHOD:
+      GST_OBJECT_LOCK (filter);
+      filter->method = g_value_get_enum (value);
+      GST_OBJECT_UNLOCK (filter);
+      break;
+    case PROP_N_THREADS:
+      GST_OBJECT_LOCK (filter);
+      filter->n_threads = g_value_get_uint (value);
+      GST_OBJECT_UNLOCK (filter);
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
       break;
@@ -226,8 +486,19 @@ static void
 gst_bayer2rgb_get_property (GObject * object, guint prop_id,
     GValue * value, GParamSpec * pspec)
 {
+  GstBayer2RGB *filter = GST_BAYER2RGB (object);
 
   switch (prop_id) {
+    case PROP_METHOD:
+      GST_OBJECT_LOCK (filter);
+      g_value_set_enum (value, filter->method);
+      GST_OBJECT_UNLOCK (filter);
+      break;
+    case PROP_N_THREADS:
+      GST_OBJECT_LOCK (filter);
+      g_value_set_uint (value, filter->n_threads);
+      GST_OBJECT_UNLOCK (filter);
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
       break;
@@ -252,23 +523,19 @@ gst_bayer2rgb_set_caps (GstBaseTransform * base, GstCaps * incaps,
   gst_structure_get_int (structure, "height", &bayer2rgb->height);
 
   format = gst_structure_get_string (structure, "format");
-  if (g_str_equal (format, "bggr")) {
-    bayer2rgb->format = GST_BAYER_2_RGB_FORMAT_BGGR;
-  } else if (g_str_equal (format, "gbrg")) {
-    bayer2rgb->format = GST_BAYER_2_RGB_FORMAT_GBRG;
-  } else if (g_str_equal (format, "grbg")) {
-    bayer2rgb->format = GST_BAYER_2_RGB_FORMAT_GRBG;
-  } else if (g_str_equal (format, "rggb")) {
-    bayer2rgb->format = GST_BAYER_2_RGB_FORMAT_RGGB;
-  } else {
+  bayer2rgb->depth = gst_bayer2rgb_parse_format (format, &bayer2rgb->format);
+  if (!bayer2rgb->depth)
     return FALSE;
-  }
 
   /* To cater for different RGB formats, we need to set params for later */
   gst_video_info_from_caps (&info, outcaps);
   bayer2rgb->r_off = GST_VIDEO_INFO_COMP_OFFSET (&info, 0);
   bayer2rgb->g_off = GST_VIDEO_INFO_COMP_OFFSET (&info, 1);
   bayer2rgb->b_off = GST_VIDEO_INFO_COMP_OFFSET (&info, 2);
+  bayer2rgb->out_bpc = GST_VIDEO_INFO_COMP_DEPTH (&info, 0) > 8 ? 2 : 1;
+  /* alpha, or padding, is in whatever component is left */
+  bayer2rgb->a_off = 6 * bayer2rgb->out_bpc - bayer2rgb->r_off -
+      bayer2rgb->g_off - bayer2rgb->b_off;
 
   bayer2rgb->info = info;
 
@@ -337,11 +604,23 @@ gst_bayer2rgb_get_unit_size (GstBaseTransform * base, GstCaps * caps,
     name = gst_structure_get_name (structure);
     /* Our name must be either video/x-bayer video/x-raw */
     if (strcmp (name, "video/x-raw")) {
-      *size = GST_ROUND_UP_4 (width) * height;
+      const GstBayer2RGBDepth *depth;
+      int order;
+
+      depth = gst_bayer2rgb_parse_format (gst_structure_get_string (structure,
+              "format"), &order);
+      if (!depth)
+        depth = &bayer_depths[0];
+      *size = GST_ROUND_UP_4 (gst_bayer2rgb_row_size (depth, width)) * height;
       return TRUE;
     } else {
-      /* For output, calculate according to format (always 32 bits) */
-      *size = width * height * 4;
+      GstVideoInfo info;
+
+      /* For output, calculate according to format (32 or 64 bits) */
+      if (!gst_video_info_from_caps (&info, caps))
+        *size = width * height * 4;
+      else
+        *size = GST_VIDEO_INFO_SIZE (&info);
       return TRUE;
     }
 
@@ -380,15 +659,35 @@ gst_bayer2rgb_split_and_upsample_horiz (guint8 * dest0, guint8 * dest1,
   }
 }
 
+/* Returns @size bytes of memory for the slice to work in. They are kept with
+ * the slice, so that they are only allocated for the first frames, and
+ * start zeroed as the blocks of the generic path are computed past the end
+ * of the rows. */
+static gpointer
+gst_bayer2rgb_slice_get_scratch (GstBayer2RGBSlice * slice, gsize size)
+{
+  if (slice->scratch_size < size) {
+    g_free (slice->scratch);
+    slice->scratch = g_malloc0 (size);
+    slice->scratch_size = size;
+  }
+
+  return slice->scratch;
+}
+
 typedef void (*process_func) (guint8 * d0, const guint8 * s0, const guint8 * s1,
     const guint8 * s2, const guint8 * s3, const guint8 * s4, const guint8 * s5,
     int n);
 
+/* Converts rows [y0, y1) of 8 bit bayer with the bilinear ORC kernels */
 static void
-gst_bayer2rgb_process (GstBayer2RGB * bayer2rgb, uint8_t * dest,
-    int dest_stride, uint8_t * src, int src_stride)
+gst_bayer2rgb_process_orc (GstBayer2RGBSlice * slice)
 {
-  int j;
+  GstBayer2RGB *bayer2rgb = slice->bayer2rgb;
+  const guint8 *src = slice->src;
+  guint8 *dest = slice->dest;
+  int src_stride = slice->src_stride, dest_stride = slice->dest_stride;
+  int j, prev, next;
   guint8 *tmp;
   process_func merge[2] = { NULL, NULL };
   int r_off, g_off, b_off;
@@ -426,32 +725,435 @@ gst_bayer2rgb_process (GstBayer2RGB * bayer2rgb, uint8_t * dest,
     merge[1] = tmp;
   }
 
-  tmp = g_malloc (2 * 4 * bayer2rgb->width);
+  tmp = gst_bayer2rgb_slice_get_scratch (slice, 2 * 4 * bayer2rgb->width);
 #define LINE(x) (tmp + ((x)&7) * bayer2rgb->width)
 
-  gst_bayer2rgb_split_and_upsample_horiz (LINE (3 * 2 + 0), LINE (3 * 2 + 1),
-      src + 1 * src_stride, bayer2rgb->width);
-  j = 0;
+  /* the rows above the first and below the last one are mirrored */
+  j = slice->y0;
+  prev = j > 0 ? j - 1 : MIN (1, bayer2rgb->height - 1);
+  gst_bayer2rgb_split_and_upsample_horiz (LINE (j * 2 - 2), LINE (j * 2 - 1),
+      src + prev * src_stride, bayer2rgb->width);
   gst_bayer2rgb_split_and_upsample_horiz (LINE (j * 2 + 0), LINE (j * 2 + 1),
       src + j * src_stride, bayer2rgb->width);
 
-  for (j = 0; j < bayer2rgb->height; j++) {
-    if (j < bayer2rgb->height - 1) {
-      gst_bayer2rgb_split_and_upsample_horiz (LINE ((j + 1) * 2 + 0),
-          LINE ((j + 1) * 2 + 1), src + (j + 1) * src_stride, bayer2rgb->width);
-    }
+  for (j = slice->y0; j < slice->y1; j++) {
+    next = j < bayer2rgb->height - 1 ? j + 1 : MAX (j - 1, 0);
+    gst_bayer2rgb_split_and_upsample_horiz (LINE ((j + 1) * 2 + 0),
+        LINE ((j + 1) * 2 + 1), src + next * src_stride, bayer2rgb->width);
 
     merge[j & 1] (dest + j * dest_stride,
         LINE (j * 2 - 2), LINE (j * 2 - 1),
         LINE (j * 2 + 0), LINE (j * 2 + 1),
         LINE (j * 2 + 2), LINE (j * 2 + 3), bayer2rgb->width >> 1);
   }
+#undef LINE
+}
+
+#ifdef _MSC_VER
+#define restrict __restrict
+#endif
 
-  g_free (tmp);
+/* Unpacks a row of samples into @dest, leaving 2 mirrored samples on each
+ * side so that the 5x5 kernels don't need special cases at the edges */
+static void
+gst_bayer2rgb_unpack_row (const GstBayer2RGBDepth * depth,
+    guint16 * restrict dest, const guint8 * restrict src, int width)
+{
+  guint16 *d = dest + 2;
+  int i;
+
+  switch (depth->packing) {
+    case GST_BAYER_2_RGB_PACKING_8:
+      for (i = 0; i < width; i++)
+        d[i] = src[i];
+      break;
+    case GST_BAYER_2_RGB_PACKING_16LE:
+      for (i = 0; i < width; i++)
+        d[i] = GST_READ_UINT16_LE (src + 2 * i) & ((1 << depth->bits) - 1);
+      break;
+    case GST_BAYER_2_RGB_PACKING_16BE:
+      for (i = 0; i < width; i++)
+        d[i] = GST_READ_UINT16_BE (src + 2 * i) & ((1 << depth->bits) - 1);
+      break;
+    case GST_BAYER_2_RGB_PACKING_10P:
+      for (i = 0; i < width; i++) {
+        const guint8 *group = src + (i / 4) * 5;
+        d[i] = (group[i % 4] << 2) | ((group[4] >> (2 * (i % 4))) & 0x3);
+      }
+      break;
+    case GST_BAYER_2_RGB_PACKING_12P:
+      for (i = 0; i < width; i++) {
+        const guint8 *group = src + (i / 2) * 3;
+        d[i] = (group[i % 2] << 4) | ((group[2] >> (4 * (i % 2))) & 0xf);
+      }
+      break;
+  }
+
+  for (i = 1; i <= 2; i++) {
+    d[-i] = d[MIN (i, width - 1)];
+    d[width - 1 + i] = d[MAX (width - 1 - i, 0)];
+  }
+}
+
+/* Unpacks a row and splits it into the planes of its even and odd columns.
+ * Both keep a mirrored sample on each side, at index -1 and past the end. */
+static void
+gst_bayer2rgb_split_row (const GstBayer2RGBDepth * depth,
+    guint16 * restrict even, guint16 * restrict odd, guint16 * restrict tmp,
+    const guint8 * restrict src, int width)
+{
+  const guint16 *d = tmp + 2;
+  int i;
+
+  gst_bayer2rgb_unpack_row (depth, tmp, src, width);
+
+  for (i = -1; 2 * i <= width + 1; i++)
+    even[i] = d[2 * i];
+  for (i = -1; 2 * i + 1 <= width + 1; i++)
+    odd[i] = d[2 * i + 1];
+}
+
+/* Number of sites of one column parity interpolated at once. The rows are
+ * processed in whole blocks, so that these loops have a fixed length and,
+ * together with the restrict pointers, vectorize without runtime checks. */
+#define BLOCK_SIZE 64
+
+/* Neighbourhood of the sites of one column parity in 5 rows, row 2 being the
+ * current one: @s are their samples, @l and @r the samples of the columns on
+ * their left and right, s0 to s4 etc. their rows */
+#define C    (s2[i])
+#define HSUM (l2[i] + r2[i])
+#define VSUM (s1[i] + s3[i])
+#define DIAG (l1[i] + r1[i] + l3[i] + r3[i])
+#define H2   (s2[i - 1] + s2[i + 1])
+#define V2   (s0[i] + s4[i])
+
+/* The red/blue sites output green to @g and the other colour to @o, the
+ * green sites the colour of their horizontal neighbours to @h and the one
+ * of their vertical neighbours to @v */
+static inline void
+bilinear_rb (const guint16 * const *s, const guint16 * const *l,
+    const guint16 * const *r, guint16 * restrict g, guint16 * restrict o,
+    int max)
+{
+  const guint16 *restrict s1 = s[1], *restrict s3 = s[3];
+  const guint16 *restrict l1 = l[1], *restrict l2 = l[2], *restrict l3 = l[3];
+  const guint16 *restrict r1 = r[1], *restrict r2 = r[2], *restrict r3 = r[3];
+  int i;
+
+  for (i = 0; i < BLOCK_SIZE; i++) {
+    g[i] = (HSUM + VSUM + 2) >> 2;
+    o[i] = (DIAG + 2) >> 2;
+  }
 }
 
+static inline void
+bilinear_g (const guint16 * const *s, const guint16 * const *l,
+    const guint16 * const *r, guint16 * restrict h, guint16 * restrict v,
+    int max)
+{
+  const guint16 *restrict s1 = s[1], *restrict s3 = s[3];
+  const guint16 *restrict l2 = l[2], *restrict r2 = r[2];
+  int i;
 
+  for (i = 0; i < BLOCK_SIZE; i++) {
+    h[i] = (HSUM + 1) >> 1;
+    v[i] = (VSUM + 1) >> 1;
+  }
+}
 
+/* Malvar-He-Cutler kernels, all scaled to a sum of 16 */
+#define MHC_NEIGHBOURHOOD \
+  const guint16 *restrict s0 = s[0], *restrict s1 = s[1]; \
+  const guint16 *restrict s2 = s[2], *restrict s3 = s[3]; \
+  const guint16 *restrict s4 = s[4]; \
+  const guint16 *restrict l1 = l[1], *restrict l2 = l[2], *restrict l3 = l[3]; \
+  const guint16 *restrict r1 = r[1], *restrict r2 = r[2], *restrict r3 = r[3]
+
+static inline void
+mhc_rb (const guint16 * const *s, const guint16 * const *l,
+    const guint16 * const *r, guint16 * restrict g, guint16 * restrict o,
+    int max)
+{
+  MHC_NEIGHBOURHOOD;
+  int i;
+
+  for (i = 0; i < BLOCK_SIZE; i++) {
+    int gi = (8 * C + 4 * (HSUM + VSUM) - 2 * (H2 + V2) + 8) >> 4;
+    int oi = (12 * C + 4 * DIAG - 3 * (H2 + V2) + 8) >> 4;
+
+    g[i] = CLAMP (gi, 0, max);
+    o[i] = CLAMP (oi, 0, max);
+  }
+}
+
+static inline void
+mhc_g (const guint16 * const *s, const guint16 * const *l,
+    const guint16 * const *r, guint16 * restrict h, guint16 * restrict v,
+    int max)
+{
+  MHC_NEIGHBOURHOOD;
+  int i;
+
+  for (i = 0; i < BLOCK_SIZE; i++) {
+    int hi = (10 * C + 8 * HSUM - 2 * (H2 + DIAG) + V2 + 8) >> 4;
+    int vi = (10 * C + 8 * VSUM - 2 * (V2 + DIAG) + H2 + 8) >> 4;
+
+    h[i] = CLAMP (hi, 0, max);
+    v[i] = CLAMP (vi, 0, max);
+  }
+}
+
+#undef MHC_NEIGHBOURHOOD
+#undef C
+#undef HSUM
+#undef VSUM
+#undef DIAG
+#undef H2
+#undef V2
+
+/* Interpolates the missing components of @n sites of each column parity of
+ * a row, @n being a multiple of BLOCK_SIZE. @rows are the even and odd
+ * column planes of the 5 rows around it and @p_rb the parity of its red/blue
+ * sites, whose green and other colour go to @rb[0] and @rb[1]. The colour
+ * of the horizontal and vertical neighbours of its green sites go to @g[0]
+ * and @g[1]. */
+#define DEFINE_DEMOSAIC_ROW(method) \
+static void \
+demosaic_row_##method (const guint16 * rows[2][5], int p_rb, \
+    guint16 ** rb, guint16 ** g, int n, int max) \
+{ \
+  const guint16 *s[5], *l[5], *r[5]; \
+  int i, k, p; \
+  \
+  for (i = 0; i < n; i += BLOCK_SIZE) { \
+    for (p = 0; p < 2; p++) { \
+      /* column 2i + p is between 2i + p - 1 and 2i + p + 1, which are \
+       * sites i - 1 and i of the odd plane or i and i + 1 of the even one */ \
+      for (k = 0; k < 5; k++) { \
+        s[k] = rows[p][k] + i; \
+        l[k] = rows[1 - p][k] + i - (p == 0); \
+        r[k] = l[k] + 1; \
+      } \
+      if (p == p_rb) \
+        method##_rb (s, l, r, rb[0] + i, rb[1] + i, max); \
+      else \
+        method##_g (s, l, r, g[0] + i, g[1] + i, max); \
+    } \
+  } \
+}
+
+DEFINE_DEMOSAIC_ROW (bilinear)
+DEFINE_DEMOSAIC_ROW (mhc)
+
+/* Interleaves the component planes @comp of the even and odd columns of a
+ * row, in R, G, B order, into @dest */
+static void
+gst_bayer2rgb_store_row (GstBayer2RGB * bayer2rgb, guint8 * dest,
+    const guint16 * comp[2][3], int bits)
+{
+  int r_off = bayer2rgb->r_off, g_off = bayer2rgb->g_off;
+  int b_off = bayer2rgb->b_off, a_off = bayer2rgb->a_off;
+  int bpp = 4 * bayer2rgb->out_bpc;
+  int i, p, x;
+
+  for (p = 0; p < 2; p++) {
+    const guint16 *restrict r = comp[p][0];
+    const guint16 *restrict g = comp[p][1];
+    const guint16 *restrict b = comp[p][2];
+    guint8 *restrict d = dest + p * bpp;
+
+    if (bayer2rgb->out_bpc == 1) {
+      int shift = bits - 8;
+
+      for (i = 0, x = p; x < bayer2rgb->width; i++, x += 2, d += 2 * bpp) {
+        d[r_off] = r[i] >> shift;
+        d[g_off] = g[i] >> shift;
+        d[b_off] = b[i] >> shift;
+        d[a_off] = 0xff;
+      }
+    } else {
+      /* replicate the high bits in the low ones to use the full range */
+      int shift = 16 - bits, rshift = bits - shift;
+
+#define SCALE(v) (((v) << shift) | ((v) >> rshift))
+      for (i = 0, x = p; x < bayer2rgb->width; i++, x += 2, d += 2 * bpp) {
+        GST_WRITE_UINT16_LE (d + r_off, SCALE (r[i]));
+        GST_WRITE_UINT16_LE (d + g_off, SCALE (g[i]));
+        GST_WRITE_UINT16_LE (d + b_off, SCALE (b[i]));
+        GST_WRITE_UINT16_LE (d + a_off, 0xffff);
+      }
+#undef SCALE
+    }
+  }
+}
+
+/* Converts rows [y0, y1) of any depth with any method */
+static void
+gst_bayer2rgb_process_generic (GstBayer2RGBSlice * slice)
+{
+  GstBayer2RGB *bayer2rgb = slice->bayer2rgb;
+  const GstBayer2RGBDepth *depth = bayer2rgb->depth;
+  int width = bayer2rgb->width, height = bayer2rgb->height;
+  int max = (1 << depth->bits) - 1;
+  /* sites of each column parity, rounded up to whole blocks */
+  int n = GST_ROUND_UP_N ((width + 1) / 2, BLOCK_SIZE);
+  int plane = n + 2;
+  /* offset of the first sample in the BGGR pattern */
+  int x_off = (bayer2rgb->format == GST_BAYER_2_RGB_FORMAT_GBRG ||
+      bayer2rgb->format == GST_BAYER_2_RGB_FORMAT_RGGB) ? 1 : 0;
+  int y_off = (bayer2rgb->format == GST_BAYER_2_RGB_FORMAT_GRBG ||
+      bayer2rgb->format == GST_BAYER_2_RGB_FORMAT_RGGB) ? 1 : 0;
+  guint16 *ring, *tmp, *rb[2], *g[2];
+  const guint16 *rows[2][5], *comp[2][3];
+  int j, k;
+
+  /* ring of the planes of the 5 unpacked rows around the current one, the
+   * unpacked row being split and the interpolated components */
+  ring = gst_bayer2rgb_slice_get_scratch (slice,
+      (10 * plane + width + 4 + 4 * n) * sizeof (guint16));
+  tmp = ring + 10 * plane;
+  rb[0] = tmp + width + 4;
+  rb[1] = rb[0] + n;
+  g[0] = rb[1] + n;
+  g[1] = g[0] + n;
+
+#define PLANE(y, p) (ring + ((((y) + 5) % 5) * 2 + (p)) * plane + 1)
+#define SRC_ROW(y) (slice->src + CLAMP ((y) < 0 ? -(y) : (y) >= height ? \
+      2 * (height - 1) - (y) : (y), 0, height - 1) * slice->src_stride)
+
+  for (k = slice->y0 - 2; k < slice->y0 + 2; k++)
+    gst_bayer2rgb_split_row (depth, PLANE (k, 0), PLANE (k, 1), tmp,
+        SRC_ROW (k), width);
+
+  for (j = slice->y0; j < slice->y1; j++) {
+    gboolean blue_row = ((j + y_off) & 1) == 0;
+    /* blue samples are on even columns of the BGGR pattern, red on odd */
+    int p_rb = (x_off + (blue_row ? 0 : 1)) & 1;
+    int c0 = blue_row ? 2 : 0, c1 = 2 - c0;
+
+    gst_bayer2rgb_split_row (depth, PLANE (j + 2, 0), PLANE (j + 2, 1), tmp,
+        SRC_ROW (j + 2), width);
+    for (k = 0; k < 5; k++) {
+      rows[0][k] = PLANE (j - 2 + k, 0);
+      rows[1][k] = PLANE (j - 2 + k, 1);
+    }
+
+    if (slice->method == GST_BAYER_2_RGB_METHOD_MALVAR_HE_CUTLER)
+      demosaic_row_mhc (rows, p_rb, rb, g, n, max);
+    else
+      demosaic_row_bilinear (rows, p_rb, rb, g, n, max);
+
+    /* the red/blue sites have a sample of colour c0, the green sites
+     * horizontal neighbours of that colour */
+    comp[p_rb][c0] = rows[p_rb][2];
+    comp[p_rb][1] = rb[0];
+    comp[p_rb][c1] = rb[1];
+    comp[1 - p_rb][1] = rows[1 - p_rb][2];
+    comp[1 - p_rb][c0] = g[0];
+    comp[1 - p_rb][c1] = g[1];
+
+    gst_bayer2rgb_store_row (bayer2rgb, slice->dest + j * slice->dest_stride,
+        comp, depth->bits);
+  }
+#undef PLANE
+#undef SRC_ROW
+}
+
+static void
+gst_bayer2rgb_process_slice (GstBayer2RGBSlice * slice)
+{
+  GstBayer2RGB *bayer2rgb = slice->bayer2rgb;
+
+  /* the ORC kernels only handle 8 bit in and out, and need 4 pixels in
+   * whole pairs of columns */
+  if (slice->method == GST_BAYER_2_RGB_METHOD_BILINEAR
+      && bayer2rgb->depth->bits == 8 && bayer2rgb->out_bpc == 1
+      && bayer2rgb->width >= 4 && (bayer2rgb->width & 1) == 0)
+    gst_bayer2rgb_process_orc (slice);
+  else
+    gst_bayer2rgb_process_generic (slice);
+}
+
+static void
+gst_bayer2rgb_slice_func (gpointer data, gpointer user_data)
+{
+  GstBayer2RGB *bayer2rgb = user_data;
+
+  gst_bayer2rgb_process_slice (data);
+
+  g_mutex_lock (&bayer2rgb->slices_lock);
+  if (--bayer2rgb->slices_pending == 0)
+    g_cond_signal (&bayer2rgb->slices_cond);
+  g_mutex_unlock (&bayer2rgb->slices_lock);
+}
+
+static void
+gst_bayer2rgb_process (GstBayer2RGB * bayer2rgb, uint8_t * dest,
+    int dest_stride, const uint8_t * src, int src_stride)
+{
+  GstBayer2RGBMethod method;
+  guint n_threads;
+  int n_slices, i;
+
+  GST_OBJECT_LOCK (bayer2rgb);
+  method = bayer2rgb->method;
+  n_threads = bayer2rgb->n_threads;
+  GST_OBJECT_UNLOCK (bayer2rgb);
+
+  if (n_threads == 0)
+    n_threads = g_get_num_processors ();
+  /* the rows of a slice start on a pair of rows */
+  n_slices = CLAMP (n_threads, 1, MAX (bayer2rgb->height / 2, 1));
+
+  if (bayer2rgb->n_slices != n_slices) {
+    gst_bayer2rgb_free_slices (bayer2rgb);
+    bayer2rgb->slices = g_new0 (GstBayer2RGBSlice, n_slices);
+    bayer2rgb->n_slices = n_slices;
+  }
+
+  for (i = 0; i < n_slices; i++) {
+    GstBayer2RGBSlice *slice = &bayer2rgb->slices[i];
+
+    slice->bayer2rgb = bayer2rgb;
+    slice->dest = dest;
+    slice->dest_stride = dest_stride;
+    slice->src = src;
+    slice->src_stride = src_stride;
+    slice->y0 = bayer2rgb->height / 2 * i / n_slices * 2;
+    slice->y1 = i == n_slices - 1 ? bayer2rgb->height :
+        bayer2rgb->height / 2 * (i + 1) / n_slices * 2;
+    slice->method = method;
+  }
+
+  if (n_slices > 1) {
+    if (!bayer2rgb->pool) {
+      bayer2rgb->pool = g_thread_pool_new (gst_bayer2rgb_slice_func,
+          bayer2rgb, n_slices - 1, FALSE, NULL);
+    } else if (g_thread_pool_get_max_threads (bayer2rgb->pool) !=
+        n_slices - 1) {
+      g_thread_pool_set_max_threads (bayer2rgb->pool, n_slices - 1, NULL);
+    }
+  }
+
+  if (n_slices == 1 || !bayer2rgb->pool) {
+    for (i = 0; i < n_slices; i++)
+      gst_bayer2rgb_process_slice (&bayer2rgb->slices[i]);
+    return;
+  }
+
+  /* the last slices go to the pool, the first is converted here */
+  bayer2rgb->slices_pending = n_slices - 1;
+  for (i = 1; i < n_slices; i++)
+    g_thread_pool_push (bayer2rgb->pool, &bayer2rgb->slices[i], NULL);
+
+  gst_bayer2rgb_process_slice (&bayer2rgb->slices[0]);
+
+  g_mutex_lock (&bayer2rgb->slices_lock);
+  while (bayer2rgb->slices_pending > 0)
+    g_cond_wait (&bayer2rgb->slices_cond, &bayer2rgb->slices_lock);
+  g_mutex_unlock (&bayer2rgb->slices_lock);
+}
 
 static GstFlowReturn
 gst_bayer2rgb_transform (GstBaseTransform * base, GstBuffer * inbuf,
@@ -474,7 +1176,8 @@ gst_bayer2rgb_transform (GstBaseTransform * base, GstBuffer * inbuf,
 
   output = GST_VIDEO_FRAME_PLANE_DATA (&frame, 0);
   gst_bayer2rgb_process (filter, output, frame.info.stride[0],
-      map.data, GST_ROUND_UP_4 (filter->width));
+      map.data, GST_ROUND_UP_4 (gst_bayer2rgb_row_size (filter->depth,
+              filter->width)));
 
   gst_video_frame_unmap (&frame);
   gst_buffer_unmap (inbuf, &map);
@@ -75,6 +75,8 @@ static gboolean gst_gaussianblur_set_info (GstVideoFilter * filter,
     GstVideoInfo * out_info);
 static GstFlowReturn gst_gaussianblur_transform_frame (GstVideoFilter * vfilter,
     GstVideoFrame * in_frame, GstVideoFrame * out_frame);
+static gboolean gst_gaussianblur_stop (GstBaseTransform * trans);
+static void gst_gaussianblur_job_func (gpointer data, gpointer user_data);
 
 static void gst_gaussianblur_set_property (GObject * object,
     guint prop_id, const GValue * value, GParamSpec * pspec);
@@ -90,7 +92,8 @@ GST_DEBUG_CATEGORY_STATIC (gst_gauss_blur_debug);
 #define CAPS_STR_RGB GST_VIDEO_CAPS_MAKE ("{  xBGR, xRGB }")
 #endif
 
-#define CAPS_STR GST_VIDEO_CAPS_MAKE ("AYUV")
+#define CAPS_STR GST_VIDEO_CAPS_MAKE ("{ AYUV, I420, YV12, Y41B, Y42B, " \
+    "Y444, NV12, NV21, GRAY8 }")
 
 /* The capabilities of the inputs and outputs. */
 static GstStaticPadTemplate gst_gaussianblur_sink_template =
@@ -110,12 +113,55 @@ GST_STATIC_PAD_TEMPLATE ("src",
 enum
 {
   PROP_0,
-  PROP_SIGMA
+  PROP_SIGMA,
+  PROP_METHOD,
+  PROP_N_THREADS
 };
 
-static gboolean make_gaussian_kernel (GstGaussianBlur * gb, float sigma);
-static void gaussian_smooth (GstGaussianBlur * gb, guint8 * image,
-    guint8 * out_image);
+/* Rows [y0, y1) of one plane, blurred by one thread */
+struct _GstGaussianBlurJob
+{
+  gint plane;
+  const guint8 *src;
+  gint src_stride;
+  guint8 *dest;
+  gint dest_stride;
+  /* samples per row and bytes per pixel */
+  gint n, pstride;
+  gint height;
+  gint y0, y1;
+  const GstGaussianBlurKernel *kx, *ky;
+  gboolean box;
+  /* kept across frames, see job_get_scratch() */
+  gpointer scratch;
+  gsize scratch_size;
+};
+
+#define GST_TYPE_GAUSSIAN_BLUR_METHOD (gst_gaussian_blur_method_get_type ())
+static GType
+gst_gaussian_blur_method_get_type (void)
+{
+  static GType method_type = 0;
+
+  static const GEnumValue method_types[] = {
+    {GST_GAUSSIAN_BLUR_METHOD_GAUSSIAN, "Gaussian kernel", "gaussian"},
+    {GST_GAUSSIAN_BLUR_METHOD_BOX, "Three box blurs", "box"},
+    {GST_GAUSSIAN_BLUR_METHOD_AUTO, "Box blurs for large sigma", "auto"},
+    {0, NULL, NULL}
+  };
+
+  if (!method_type) {
+    method_type = g_enum_register_static ("GstGaussianBlurMethod",
+        method_types);
+  }
+  return method_type;
+}
+
+static void make_gaussian_kernel (GstGaussianBlurKernel * kernel,
+    float sigma);
+static void make_box_kernel (GstGaussianBlurKernel * kernel, float sigma);
+static void gaussian_smooth (GstGaussianBlurJob * job);
+static void box_smooth (GstGaussianBlurJob * job);
 
 #define gst_gaussianblur_parent_class parent_class
 G_DEFINE_TYPE (GstGaussianBlur, gst_gaussianblur, GST_TYPE_VIDEO_FILTER);
@@ -124,6 +170,23 @@ GST_ELEMENT_REGISTER_DEFINE_WITH_CODE (gaussianblur, "gaussianblur",
     GST_DEBUG_CATEGORY_INIT (gst_gauss_blur_debug, "gaussianblur", 0,
         "Gaussian Blur video effect"));
 #define DEFAULT_SIGMA 1.2
+#define DEFAULT_METHOD GST_GAUSSIAN_BLUR_METHOD_GAUSSIAN
+#define DEFAULT_N_THREADS 1
+
+/* Sigma from which the auto method uses box blurs */
+#define BOX_SIGMA 3.0
+
+/* Fractional bits of the gaussian coefficients and of the horizontally
+ * blurred rows */
+#define COEF_BITS 12
+#define TMP_BITS 6
+
+/* Fractional bits of the box blurred rows */
+#define BOX_BITS 4
+
+#ifdef _MSC_VER
+#define restrict __restrict
+#endif
 
 /* Initialize the gaussianblur's class. */
 static void
@@ -131,6 +194,7 @@ gst_gaussianblur_class_init (GstGaussianBlurClass * klass)
 {
   GObjectClass *gobject_class = (GObjectClass *) klass;
   GstElementClass *gstelement_class = (GstElementClass *) klass;
+  GstBaseTransformClass *trans_class = (GstBaseTransformClass *) klass;
   GstVideoFilterClass *vfilter_class = (GstVideoFilterClass *) klass;
 
   gst_element_class_set_static_metadata (gstelement_class,
@@ -154,9 +218,113 @@ gst_gaussianblur_class_init (GstGaussianBlurClass * klass)
           -20.0, 20.0, DEFAULT_SIGMA,
           G_PARAM_READWRITE | GST_PARAM_CONTROLLABLE | G_PARAM_STATIC_STRINGS));
 
+  /**
+   * GstGaussianBlur:method:
+   *
+   * How the blur is computed. Box blurs are only used for blurring,
+   * sharpening always uses the gaussian kernel.
+   *
+   * Since: 1.24
+   */
+  g_object_class_install_property (gobject_class, PROP_METHOD,
+      g_param_spec_enum ("method", "Method",
+          "Blur method", GST_TYPE_GAUSSIAN_BLUR_METHOD, DEFAULT_METHOD,
+          G_PARAM_READWRITE | GST_PARAM_CONTROLLABLE | G_PARAM_STATIC_STRINGS));
+
+  /**
+   * GstGaussianBlur:n-threads:
+   *
+   * Maximum number of threads to blur each frame with, 0 for the number of
+   * processors.
+   *
+   * Since: 1.24
+   */
+  g_object_class_install_property (gobject_class, PROP_N_THREADS,
+      g_param_spec_uint ("n-threads", "Threads",
+          "Maximum number of threads to use (0 = number of processors)", 0,
+          G_MAXINT, DEFAULT_N_THREADS,
+          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
+  trans_class->stop = GST_DEBUG_FUNCPTR (gst_gaussianblur_stop);
   vfilter_class->transform_frame =
       GST_DEBUG_FUNCPTR (gst_gaussianblur_transform_frame);
   vfilter_class->set_info = GST_DEBUG_FUNCPTR (gst_gaussianblur_set_info);
+
+  gst_type_mark_as_plugin_api (GST_TYPE_GAUSSIAN_BLUR_METHOD, 0);
+}
+
+static void
+clear_jobs (GstGaussianBlur * gb)
+{
+  gint i;
+
+  for (i = 0; i < gb->n_jobs; i++)
+    g_free (gb->jobs[i].scratch);
+  g_free (gb->jobs);
+  gb->jobs = NULL;
+  gb->n_jobs = 0;
+}
+
+/* Splits every plane in horizontal slices, no more than it has rows, and
+ * prepares a job for each of them so that only the frame pointers are left
+ * to set per frame */
+static void
+setup_jobs (GstGaussianBlur * gb, const GstVideoInfo * info, guint n_threads)
+{
+  const GstVideoFormatInfo *finfo = info->finfo;
+  gint n_planes = GST_VIDEO_INFO_N_PLANES (info);
+  gint n_slices[GST_VIDEO_MAX_PLANES];
+  gint max_slices = 1, n_jobs = 0, plane, slice, i;
+
+  gb->jobs_n_threads = n_threads;
+  if (n_threads == 0)
+    n_threads = g_get_num_processors ();
+
+  for (plane = 0; plane < n_planes; plane++) {
+    gint comp[GST_VIDEO_MAX_COMPONENTS];
+    gint height;
+
+    gst_video_format_info_component (finfo, plane, comp);
+    height = GST_VIDEO_INFO_COMP_HEIGHT (info, comp[0]);
+    n_slices[plane] = CLAMP ((gint) n_threads, 1, MAX (height, 1));
+    max_slices = MAX (max_slices, n_slices[plane]);
+    n_jobs += n_slices[plane];
+  }
+
+  clear_jobs (gb);
+  gb->n_jobs = n_jobs;
+  gb->jobs = g_new0 (GstGaussianBlurJob, n_jobs);
+
+  for (plane = 0, i = 0; plane < n_planes; plane++) {
+    gint comp[GST_VIDEO_MAX_COMPONENTS];
+    gint height;
+
+    gst_video_format_info_component (finfo, plane, comp);
+    height = GST_VIDEO_INFO_COMP_HEIGHT (info, comp[0]);
+
+    for (slice = 0; slice < n_slices[plane]; slice++, i++) {
+      GstGaussianBlurJob *job = &gb->jobs[i];
+
+      job->plane = plane;
+      job->pstride = GST_VIDEO_INFO_COMP_PSTRIDE (info, comp[0]);
+      job->n = GST_VIDEO_INFO_COMP_WIDTH (info, comp[0]) * job->pstride;
+      job->height = height;
+      job->y0 = height * slice / n_slices[plane];
+      job->y1 = height * (slice + 1) / n_slices[plane];
+      job->kx = &gb->kernels[GST_VIDEO_FORMAT_INFO_W_SUB (finfo, comp[0])];
+      job->ky = &gb->kernels[GST_VIDEO_FORMAT_INFO_H_SUB (finfo, comp[0])];
+    }
+  }
+
+  if (max_slices > 1) {
+    if (!gb->pool) {
+      gb->pool = g_thread_pool_new (gst_gaussianblur_job_func, gb,
+          max_slices - 1, FALSE, NULL);
+    } else if (g_thread_pool_get_max_threads (gb->pool) != max_slices - 1) {
+      g_thread_pool_set_max_threads (gb->pool, max_slices - 1, NULL);
+    }
+  }
+  gb->use_pool = max_slices > 1 && gb->pool;
 }
 
 static gboolean
@@ -164,16 +332,17 @@ gst_gaussianblur_set_info (GstVideoFilter * filter, GstCaps * incaps,
     GstVideoInfo * in_info, GstCaps * outcaps, GstVideoInfo * out_info)
 {
   GstGaussianBlur *gb = GST_GAUSSIANBLUR (filter);
-  guint32 n_elems;
+  guint n_threads;
+
+  GST_DEBUG_OBJECT (gb, "Blurring %s %dx%d",
+      GST_VIDEO_INFO_NAME (in_info), GST_VIDEO_INFO_WIDTH (in_info),
+      GST_VIDEO_INFO_HEIGHT (in_info));
 
-  gb->width = GST_VIDEO_INFO_WIDTH (in_info);
-  gb->height = GST_VIDEO_INFO_HEIGHT (in_info);
+  GST_OBJECT_LOCK (gb);
+  n_threads = gb->n_threads;
+  GST_OBJECT_UNLOCK (gb);
 
-  /* get stride */
-  gb->stride = GST_VIDEO_INFO_COMP_STRIDE (in_info, 0);
-  n_elems = gb->stride * gb->height;
-  g_free (gb->tempim);
-  gb->tempim = g_malloc (sizeof (gfloat) * n_elems);
+  setup_jobs (gb, in_info, n_threads);
 
   return TRUE;
 }
@@ -183,6 +352,38 @@ gst_gaussianblur_init (GstGaussianBlur * gb)
 {
   gb->sigma = (gfloat) DEFAULT_SIGMA;
   gb->cur_sigma = -1.0;
+  gb->cur_method = (GstGaussianBlurMethod) - 1;
+  gb->method = DEFAULT_METHOD;
+  gb->n_threads = DEFAULT_N_THREADS;
+  g_mutex_init (&gb->jobs_lock);
+  g_cond_init (&gb->jobs_cond);
+}
+
+static void
+clear_kernels (GstGaussianBlur * gb)
+{
+  gint i;
+
+  for (i = 0; i < G_N_ELEMENTS (gb->kernels); i++) {
+    g_free (gb->kernels[i].coef);
+    memset (&gb->kernels[i], 0, sizeof (GstGaussianBlurKernel));
+  }
+}
+
+static gboolean
+gst_gaussianblur_stop (GstBaseTransform * trans)
+{
+  GstGaussianBlur *gb = GST_GAUSSIANBLUR (trans);
+
+  if (gb->pool) {
+    g_thread_pool_free (gb->pool, FALSE, TRUE);
+    gb->pool = NULL;
+  }
+
+  clear_jobs (gb);
+  gb->use_pool = FALSE;
+
+  return TRUE;
 }
 
 static void
@@ -190,18 +391,72 @@ gst_gaussianblur_finalize (GObject * object)
 {
   GstGaussianBlur *gb = GST_GAUSSIANBLUR (object);
 
-  g_free (gb->tempim);
-  gb->tempim = NULL;
+  if (gb->pool)
+    g_thread_pool_free (gb->pool, FALSE, TRUE);
+  clear_jobs (gb);
+  clear_kernels (gb);
+  g_mutex_clear (&gb->jobs_lock);
+  g_cond_clear (&gb->jobs_cond);
 
-  g_free (gb->smoothedim);
-  gb->smoothedim = NULL;
+  G_OBJECT_CLASS (parent_class)->finalize (object);
+}
 
-  g_free (gb->kernel);
-  gb->kernel = NULL;
-  g_free (gb->kernel_sum);
-  gb->kernel_sum = NULL;
+static void
+run_job (GstGaussianBlurJob * job)
+{
+  if (job->box)
+    box_smooth (job);
+  else
+    gaussian_smooth (job);
+}
 
-  G_OBJECT_CLASS (parent_class)->finalize (object);
+static void
+gst_gaussianblur_job_func (gpointer data, gpointer user_data)
+{
+  GstGaussianBlur *gb = user_data;
+
+  run_job (data);
+
+  g_mutex_lock (&gb->jobs_lock);
+  if (--gb->jobs_pending == 0)
+    g_cond_signal (&gb->jobs_cond);
+  g_mutex_unlock (&gb->jobs_lock);
+}
+
+/* Blurs the slices prepared by setup_jobs() on the pool threads, the first
+ * slice of the first plane on the streaming thread */
+static void
+run_jobs (GstGaussianBlur * gb, GstVideoFrame * in_frame,
+    GstVideoFrame * out_frame)
+{
+  gint i;
+
+  for (i = 0; i < gb->n_jobs; i++) {
+    GstGaussianBlurJob *job = &gb->jobs[i];
+
+    job->src = GST_VIDEO_FRAME_PLANE_DATA (in_frame, job->plane);
+    job->src_stride = GST_VIDEO_FRAME_PLANE_STRIDE (in_frame, job->plane);
+    job->dest = GST_VIDEO_FRAME_PLANE_DATA (out_frame, job->plane);
+    job->dest_stride = GST_VIDEO_FRAME_PLANE_STRIDE (out_frame, job->plane);
+    job->box = gb->box;
+  }
+
+  if (!gb->use_pool) {
+    for (i = 0; i < gb->n_jobs; i++)
+      run_job (&gb->jobs[i]);
+    return;
+  }
+
+  gb->jobs_pending = gb->n_jobs - 1;
+  for (i = 1; i < gb->n_jobs; i++)
+    g_thread_pool_push (gb->pool, &gb->jobs[i], NULL);
+
+  run_job (&gb->jobs[0]);
+
+  g_mutex_lock (&gb->jobs_lock);
+  while (gb->jobs_pending > 0)
+    g_cond_wait (&gb->jobs_cond, &gb->jobs_lock);
+  g_mutex_unlock (&gb->jobs_lock);
 }
 
 static GstFlowReturn
@@ -212,7 +467,8 @@ gst_gaussianblur_transform_frame (GstVideoFilter * vfilter,
   GstClockTime timestamp;
   gint64 stream_time;
   gfloat sigma;
-  guint8 *src, *dest;
+  GstGaussianBlurMethod method;
+  guint n_threads;
 
   /* GstController: update the properties */
   timestamp = GST_BUFFER_TIMESTAMP (in_frame->buffer);
@@ -228,198 +484,374 @@ gst_gaussianblur_transform_frame (GstVideoFilter * vfilter,
 
   GST_OBJECT_LOCK (filter);
   sigma = filter->sigma;
+  method = filter->method;
+  n_threads = filter->n_threads;
   GST_OBJECT_UNLOCK (filter);
 
-  if (filter->cur_sigma != sigma) {
-    g_free (filter->kernel);
-    filter->kernel = NULL;
-    g_free (filter->kernel_sum);
-    filter->kernel_sum = NULL;
+  if (filter->cur_sigma != sigma || filter->cur_method != method) {
+    gint i;
+
+    clear_kernels (filter);
     filter->cur_sigma = sigma;
-  }
-  if (filter->kernel == NULL &&
-      !make_gaussian_kernel (filter, filter->cur_sigma)) {
-    GST_ELEMENT_ERROR (filter, RESOURCE, NO_SPACE_LEFT, ("Out of memory"),
-        ("Failed to allocation gaussian kernel"));
-    return GST_FLOW_ERROR;
+    filter->cur_method = method;
+    filter->box = sigma > 0 && (method == GST_GAUSSIAN_BLUR_METHOD_BOX
+        || (method == GST_GAUSSIAN_BLUR_METHOD_AUTO && sigma >= BOX_SIGMA));
+
+    /* the chroma planes are blurred in their own, subsampled, pixels */
+    for (i = 0; i < G_N_ELEMENTS (filter->kernels); i++) {
+      if (filter->box)
+        make_box_kernel (&filter->kernels[i], sigma / (1 << i));
+      else
+        make_gaussian_kernel (&filter->kernels[i], sigma / (1 << i));
+    }
+
+    GST_DEBUG_OBJECT (filter, "Sigma %f, %s blur of radius %d", sigma,
+        filter->box ? "box" : "gaussian", filter->kernels[0].radius);
   }
 
   /*
    * Perform gaussian smoothing on the image using the input standard
    * deviation.
    */
-  src = GST_VIDEO_FRAME_COMP_DATA (in_frame, 0);
-  dest = GST_VIDEO_FRAME_COMP_DATA (out_frame, 0);
-  gst_video_frame_copy (out_frame, in_frame);
-  if (filter->sigma != 0.0)
-    gaussian_smooth (filter, src, dest);
+  if (sigma == 0.0) {
+    gst_video_frame_copy (out_frame, in_frame);
+  } else {
+    if (n_threads != filter->jobs_n_threads)
+      setup_jobs (filter, &vfilter->in_info, n_threads);
+    run_jobs (filter, in_frame, out_frame);
+  }
 
   return GST_FLOW_OK;
 }
 
+/* Number of samples blurred at once by the gaussian kernel, small enough for
+ * the accumulator to stay in cache */
+#define BLOCK_SIZE 256
+
+/* The inner loops work on blocks of samples, the same for every format as
+ * neighbouring pixels are pstride samples apart. The rows are padded to
+ * whole blocks, and the fixed length and the restrict pointers let the
+ * compiler vectorise these loops without any runtime checks. */
+static inline void
+mac_block_u8 (gint32 * restrict acc, const guint8 * restrict in, gint coef)
+{
+  gint x;
+
+  for (x = 0; x < BLOCK_SIZE; x++)
+    acc[x] += coef * in[x];
+}
+
+static inline void
+mac_block_s16 (gint32 * restrict acc, const gint16 * restrict in, gint coef)
+{
+  gint x;
+
+  for (x = 0; x < BLOCK_SIZE; x++)
+    acc[x] += coef * in[x];
+}
+
+/* Rounds a block blurred in both directions to 8 bits */
+static inline void
+store_block (guint8 * restrict out, const gint32 * restrict acc)
+{
+  gint x;
+
+  for (x = 0; x < BLOCK_SIZE; x++) {
+    gint v = (acc[x] + (1 << (COEF_BITS + TMP_BITS - 1))) >>
+        (COEF_BITS + TMP_BITS);
+    out[x] = CLAMP (v, 0, 255);
+  }
+}
+
+/* Returns @size bytes of memory for the job to work in. It is kept with the
+ * job, so that it is only allocated for the first frames, and starts zeroed
+ * as the blocks past the end of the rows are blurred too */
+static gpointer
+job_get_scratch (GstGaussianBlurJob * job, gsize size)
+{
+  if (job->scratch_size < size) {
+    g_free (job->scratch);
+    job->scratch = g_malloc0 (size);
+    job->scratch_size = size;
+  }
+
+  return job->scratch;
+}
+
+/* Blurs one row in the x direction into the @n_blocks blocks of @out, with
+ * TMP_BITS fractional bits. The pixels outside of the row repeat the edge
+ * pixels. */
 static void
-blur_row_x (GstGaussianBlur * gb, guint8 * in_row, gfloat * out_row)
+blur_row_x (const GstGaussianBlurKernel * kernel, const guint8 * in_row,
+    guint8 * padded, gint32 * restrict acc, gint16 * restrict out, gint n,
+    gint n_blocks, gint pstride)
 {
-  int c, cc, center;
-  float dot[4], sum;
-  int k, kmin, kmax;
-
-  center = gb->windowsize / 2;
-
-  for (c = 0; c < gb->width; c++) {
-    /* Calculate min */
-    cc = center - c;
-    kmin = MAX (0, cc);
-    cc = kmin - cc;
-    /* Calc max */
-    kmax = MIN (gb->windowsize, gb->width - cc);
-    cc *= 4;
-
-    dot[0] = dot[1] = dot[2] = dot[3] = 0.0;
-    /* Calculate sum for range */
-    sum = gb->kernel_sum[kmax - 1];
-    sum -= kmin ? gb->kernel_sum[kmin - 1] : 0.0;
-
-    for (k = kmin; k < kmax; k++) {
-      float coeff = gb->kernel[k];
-      dot[0] += (float) in_row[cc++] * coeff;
-      dot[1] += (float) in_row[cc++] * coeff;
-      dot[2] += (float) in_row[cc++] * coeff;
-      dot[3] += (float) in_row[cc++] * coeff;
-    }
+  gint r = kernel->radius, b, k, x;
 
-    out_row[c * 4] = dot[0] / sum;
-    out_row[c * 4 + 1] = dot[1] / sum;
-    out_row[c * 4 + 2] = dot[2] / sum;
-    out_row[c * 4 + 3] = dot[3] / sum;
+  memcpy (padded + r * pstride, in_row, n);
+  for (k = 0; k < r; k++) {
+    memcpy (padded + k * pstride, in_row, pstride);
+    memcpy (padded + r * pstride + n + k * pstride, in_row + n - pstride,
+        pstride);
+  }
+
+  for (b = 0; b < n_blocks; b++, padded += BLOCK_SIZE, out += BLOCK_SIZE) {
+    memset (acc, 0, BLOCK_SIZE * sizeof (gint32));
+    for (k = 0; k <= 2 * r; k++)
+      mac_block_u8 (acc, padded + k * pstride, kernel->coef[k]);
+
+    for (x = 0; x < BLOCK_SIZE; x++)
+      out[x] = (acc[x] + (1 << (COEF_BITS - TMP_BITS - 1))) >>
+          (COEF_BITS - TMP_BITS);
   }
 }
 
 static void
-gaussian_smooth (GstGaussianBlur * gb, guint8 * image, guint8 * out_image)
+gaussian_smooth (GstGaussianBlurJob * job)
 {
-  int r, c, rr, center;
-  float dot[4], sum;
-  int k, kmin, kmax;
-  guint8 *in_row = image;
-  float *tmp_out_row = gb->tempim;
-  float *tmp_in_pos;
-  gint y_avail = 0;
-  guint8 *out_row;
-
-  /* Apply the gaussian kernel */
-  center = gb->windowsize / 2;
-
-  /* Blur in the y - direction. */
-  for (r = 0; r < gb->height; r++) {
-    /* Calculate input row range */
-    rr = center - r;
-    kmin = MAX (0, rr);
-    rr = kmin - rr;
-    /* Calc max */
-    kmax = MIN (gb->windowsize, gb->height - rr);
-
-    /* Precalculate sum for range */
-    sum = gb->kernel_sum[kmax - 1];
-    sum -= kmin ? gb->kernel_sum[kmin - 1] : 0.0;
+  const GstGaussianBlurKernel *ky = job->ky;
+  gint n = job->n, ry = ky->radius, window = 2 * ry + 1;
+  gint n_blocks = (n + BLOCK_SIZE - 1) / BLOCK_SIZE;
+  gint stride = n_blocks * BLOCK_SIZE;
+  gint y, b, k, next;
+  guint8 *padded, *block;
+  gint32 *acc;
+  gint16 *rows;
+
+  acc = job_get_scratch (job, BLOCK_SIZE * sizeof (gint32) + window * stride *
+      sizeof (gint16) + stride + 2 * job->kx->radius * job->pstride +
+      BLOCK_SIZE);
+  /* ring of the last window rows blurred in the x direction */
+  rows = (gint16 *) (acc + BLOCK_SIZE);
+  padded = (guint8 *) (rows + window * stride);
+  /* the last block of a row only partly goes to the output */
+  block = padded + stride + 2 * job->kx->radius * job->pstride;
+
+  next = MAX (job->y0 - ry, 0);
+  for (y = job->y0; y < job->y1; y++) {
+    guint8 *out_row = job->dest + y * job->dest_stride;
 
     /* Blur more input rows (x direction blur) */
-    while (y_avail <= (r + center) && y_avail < gb->height) {
-      blur_row_x (gb, in_row, tmp_out_row);
-      in_row += gb->stride;
-      tmp_out_row += gb->stride;
-      y_avail++;
+    for (; next <= MIN (y + ry, job->height - 1); next++) {
+      blur_row_x (job->kx, job->src + next * job->src_stride, padded, acc,
+          rows + (next % window) * stride, n, n_blocks, job->pstride);
     }
 
-    tmp_in_pos = gb->tempim + (rr * gb->stride);
-    out_row = out_image + r * gb->stride;
+    /* Blur in the y - direction. */
+    for (b = 0; b < n_blocks; b++) {
+      gint offset = b * BLOCK_SIZE;
 
-    for (c = 0; c < gb->width; c++) {
-      float *tmp = tmp_in_pos;
+      memset (acc, 0, BLOCK_SIZE * sizeof (gint32));
+      for (k = 0; k < window; k++) {
+        gint row = CLAMP (y + k - ry, 0, job->height - 1);
 
-      dot[0] = dot[1] = dot[2] = dot[3] = 0.0;
-      for (k = kmin; k < kmax; k++, tmp += gb->stride) {
-        float kern = gb->kernel[k];
-        dot[0] += tmp[0] * kern;
-        dot[1] += tmp[1] * kern;
-        dot[2] += tmp[2] * kern;
-        dot[3] += tmp[3] * kern;
+        mac_block_s16 (acc, rows + (row % window) * stride + offset,
+            ky->coef[k]);
       }
 
-      *out_row++ = (guint8) CLAMP ((dot[0] / sum + 0.5), 0, 255);
-      *out_row++ = (guint8) CLAMP ((dot[1] / sum + 0.5), 0, 255);
-      *out_row++ = (guint8) CLAMP ((dot[2] / sum + 0.5), 0, 255);
-      *out_row++ = (guint8) CLAMP ((dot[3] / sum + 0.5), 0, 255);
+      store_block (block, acc);
+      memcpy (out_row + offset, block, MIN (BLOCK_SIZE, n - offset));
+    }
+  }
+}
+
+/* One box blur of radius @r over the @n samples of a row, in place */
+static void
+box_blur_row (guint16 * row, guint16 * tmp, gint n, gint pstride, gint r)
+{
+  gint w = n / pstride, c, x;
+  guint inv = (65536 + r) / (2 * r + 1);
+
+  if (r == 0)
+    return;
+
+  memcpy (tmp, row, n * sizeof (guint16));
+  for (c = 0; c < pstride; c++) {
+    const guint16 *in = tmp + c;
+    guint sum = 0;
+
+    for (x = -r; x <= r; x++)
+      sum += in[CLAMP (x, 0, w - 1) * pstride];
+
+    for (x = 0; x < w; x++) {
+      row[x * pstride + c] = (sum * inv + 32768) >> 16;
+      sum += in[MIN (x + r + 1, w - 1) * pstride];
+      sum -= in[MAX (x - r, 0) * pstride];
+    }
+  }
+}
+
+/* One box blur of radius @r over the columns, producing rows [y0, y1) of
+ * @out from @in, which holds the rows from @in_y0 on. With @dest set the
+ * result is written there as 8 bits instead. @sum holds @n column sums. */
+static void
+box_blur_columns (const guint16 * in, gint in_y0, guint16 * out, gint y0,
+    gint y1, gint n, gint height, gint r, guint8 * dest, gint dest_stride,
+    guint * sum)
+{
+  guint inv = (65536 + r) / (2 * r + 1);
+  gint x, y;
+
+  memset (sum, 0, n * sizeof (guint));
+
+  for (y = y0 - r; y <= y0 + r; y++) {
+    const guint16 *row = in + (CLAMP (y, 0, height - 1) - in_y0) * n;
+
+    for (x = 0; x < n; x++)
+      sum[x] += row[x];
+  }
+
+  for (y = y0; y < y1; y++) {
+    const guint16 *add, *sub;
+
+    if (dest) {
+      guint8 *out_row = dest + y * dest_stride;
 
-      tmp_in_pos += 4;
+      for (x = 0; x < n; x++) {
+        guint v = (sum[x] * inv + (1 << (15 + BOX_BITS))) >> (16 + BOX_BITS);
+        out_row[x] = MIN (v, 255);
+      }
+    } else {
+      guint16 *out_row = out + (y - y0) * n;
+
+      for (x = 0; x < n; x++)
+        out_row[x] = (sum[x] * inv + 32768) >> 16;
     }
+
+    if (y + 1 == y1)
+      break;
+
+    add = in + (MIN (y + r + 1, height - 1) - in_y0) * n;
+    sub = in + (MAX (y - r, 0) - in_y0) * n;
+    for (x = 0; x < n; x++)
+      sum[x] += add[x] - sub[x];
+  }
+}
+
+/* Three successive box blurs in each direction. The rows of the slice
+ * plus the ones the vertical blurs need around it are first blurred
+ * horizontally, then each vertical blur reads the rows of the previous
+ * one, on fewer rows every time. */
+static void
+box_smooth (GstGaussianBlurJob * job)
+{
+  const GstGaussianBlurKernel *kx = job->kx, *ky = job->ky;
+  gint n = job->n, y, x, i, r;
+  gint in_y0, in_y1;
+  guint16 *bufs[2], *tmp;
+  guint *sum;
+
+  in_y0 = MAX (job->y0 - ky->radius, 0);
+  in_y1 = MIN (job->y1 + ky->radius, job->height);
+
+  sum = job_get_scratch (job, n * sizeof (guint) +
+      (2 * (in_y1 - in_y0) + 1) * n * sizeof (guint16));
+  bufs[0] = (guint16 *) (sum + n);
+  bufs[1] = bufs[0] + (in_y1 - in_y0) * n;
+  tmp = bufs[1] + (in_y1 - in_y0) * n;
+
+  for (y = in_y0; y < in_y1; y++) {
+    const guint8 *in_row = job->src + y * job->src_stride;
+    guint16 *row = bufs[0] + (y - in_y0) * n;
+
+    for (x = 0; x < n; x++)
+      row[x] = in_row[x] << BOX_BITS;
+    for (i = 0; i < 3; i++)
+      box_blur_row (row, tmp, n, job->pstride, kx->box_radius[i]);
+  }
+
+  r = ky->radius;
+  for (i = 0; i < 3; i++) {
+    gint out_y0, out_y1;
+
+    r -= ky->box_radius[i];
+    out_y0 = MAX (job->y0 - r, 0);
+    out_y1 = MIN (job->y1 + r, job->height);
+
+    box_blur_columns (bufs[i % 2], in_y0, bufs[(i + 1) % 2], out_y0, out_y1,
+        n, job->height, ky->box_radius[i], i == 2 ? job->dest : NULL,
+        job->dest_stride, sum);
+    in_y0 = out_y0;
   }
 }
 
 /*
  * Create a one dimensional gaussian kernel.
  */
-static gboolean
-make_gaussian_kernel (GstGaussianBlur * gb, float sigma)
+static void
+make_gaussian_kernel (GstGaussianBlurKernel * kernel, float sigma)
 {
-  int i, center, left, right;
-  float sum, sum2;
+  int i, center, left, right, windowsize;
+  float sum, *fkernel;
+  gint isum;
   const float fe = -0.5 / (sigma * sigma);
   const float dx = 1.0 / (sigma * sqrt (2 * G_PI));
 
   center = ceil (2.5 * fabs (sigma));
-  gb->windowsize = (int) (1 + 2 * center);
+  windowsize = (int) (1 + 2 * center);
 
-  gb->kernel = g_new (float, gb->windowsize);
-  gb->kernel_sum = g_new (float, gb->windowsize);
-  if (gb->kernel == NULL || gb->kernel_sum == NULL)
-    return FALSE;
+  kernel->radius = center;
+  kernel->coef = g_new (gint16, windowsize);
 
-  if (gb->windowsize == 1) {
-    gb->kernel[0] = 1.0;
-    gb->kernel_sum[0] = 1.0;
-    return TRUE;
+  if (windowsize == 1) {
+    kernel->coef[0] = 1 << COEF_BITS;
+    return;
   }
 
+  fkernel = g_new (float, windowsize);
+
   /* Center co-efficient */
-  sum = gb->kernel[center] = dx;
+  sum = fkernel[center] = dx;
 
   /* Other coefficients */
   left = center - 1;
   right = center + 1;
   for (i = 1; i <= center; i++, left--, right++) {
     float fx = dx * pow (G_E, fe * i * i);
-    gb->kernel[right] = gb->kernel[left] = fx;
+    fkernel[right] = fkernel[left] = fx;
     sum += 2 * fx;
   }
 
   if (sigma < 0) {
     sum = -sum;
-    gb->kernel[center] += 2.0 * sum;
+    fkernel[center] += 2.0 * sum;
   }
 
-  for (i = 0; i < gb->windowsize; i++)
-    gb->kernel[i] /= sum;
-
-  sum2 = 0.0;
-  for (i = 0; i < gb->windowsize; i++) {
-    sum2 += gb->kernel[i];
-    gb->kernel_sum[i] = sum2;
+  /* Quantize, putting the rounding error in the center so that the
+   * coefficients add up to exactly 1 */
+  isum = 0;
+  for (i = 0; i < windowsize; i++) {
+    kernel->coef[i] = (gint16) floor (fkernel[i] / sum * (1 << COEF_BITS)
+        + 0.5);
+    isum += kernel->coef[i];
   }
+  kernel->coef[center] += (1 << COEF_BITS) - isum;
 
-#if 0
-  g_print ("Sigma %f: ", sigma);
-  for (i = 0; i < gb->windowsize; i++)
-    g_print ("%f ", gb->kernel[i]);
-  g_print ("\n");
-  g_print ("sums: ");
-  for (i = 0; i < gb->windowsize; i++)
-    g_print ("%f ", gb->kernel_sum[i]);
-  g_print ("\n");
-  g_print ("sum %f sum2 %f\n", sum, sum2);
-#endif
+  g_free (fkernel);
+}
 
-  return TRUE;
+/*
+ * Create three box blurs that together approximate a gaussian, with
+ * widths as in "Fast Almost-Gaussian Filtering" by Peter Kovesi.
+ */
+static void
+make_box_kernel (GstGaussianBlurKernel * kernel, float sigma)
+{
+  gdouble w_ideal = sqrt (4.0 * sigma * sigma + 1.0);
+  gint wl, wu, m, i;
+
+  wl = (gint) floor (w_ideal);
+  if (wl % 2 == 0)
+    wl--;
+  wu = wl + 2;
+  m = (gint) floor ((12.0 * sigma * sigma - 3 * wl * wl - 12 * wl - 9) /
+      (-4.0 * wl - 4) + 0.5);
+
+  kernel->radius = 0;
+  for (i = 0; i < 3; i++) {
+    kernel->box_radius[i] = ((i < m ? wl : wu) - 1) / 2;
+    kernel->radius += kernel->box_radius[i];
+  }
 }
 
 static void
@@ -433,6 +865,16 @@ gst_gaussianblur_set_property (GObject * object,
       gb->sigma = g_value_get_double (value);
       GST_OBJECT_UNLOCK (object);
       break;
+    case PROP_METHOD:
+      GST_OBJECT_LOCK (object);
+      gb->method = g_value_get_enum (value);
+      GST_OBJECT_UNLOCK (object);
+      break;
+    case PROP_N_THREADS:
+      GST_OBJECT_LOCK (object);
+      gb->n_threads = g_value_get_uint (value);
+      GST_OBJECT_UNLOCK (object);
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
       break;
@@ -450,6 +892,16 @@ gst_gaussianblur_get_property (GObject * object,
       g_value_set_double (value, gb->sigma);
       GST_OBJECT_UNLOCK (gb);
       break;
+    case PROP_METHOD:
+      GST_OBJECT_LOCK (gb);
+      g_value_set_enum (value, gb->method);
+      GST_OBJECT_UNLOCK (gb);
+      break;
+    case PROP_N_THREADS:
+      GST_OBJECT_LOCK (gb);
+      g_value_set_uint (value, gb->n_threads);
+      GST_OBJECT_UNLOCK (gb);
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
       break;
@@ -60,19 +60,55 @@ G_BEGIN_DECLS
 
 typedef struct _GstGaussianBlur GstGaussianBlur;
 typedef struct _GstGaussianBlurClass GstGaussianBlurClass;
+typedef struct _GstGaussianBlurKernel GstGaussianBlurKernel;
+typedef struct _GstGaussianBlurJob GstGaussianBlurJob;
+
+/**
+ * GstGaussianBlurMethod:
+ * @GST_GAUSSIAN_BLUR_METHOD_GAUSSIAN: Convolve with the gaussian kernel
+ * @GST_GAUSSIAN_BLUR_METHOD_BOX: Approximate the gaussian with three
+ *     successive box blurs, whose cost does not depend on sigma
+ * @GST_GAUSSIAN_BLUR_METHOD_AUTO: Use box blurs for large sigma
+ *
+ * Since: 1.24
+ */
+typedef enum
+{
+  GST_GAUSSIAN_BLUR_METHOD_GAUSSIAN,
+  GST_GAUSSIAN_BLUR_METHOD_BOX,
+  GST_GAUSSIAN_BLUR_METHOD_AUTO
+} GstGaussianBlurMethod;
+
+/* One dimensional filter, either a gaussian kernel with coefficients in
+ * 1/4096 or the radii of three successive box blurs */
+struct _GstGaussianBlurKernel
+{
+  gint radius;
+  gint16 *coef;
+  gint box_radius[3];
+};
 
 struct _GstGaussianBlur
 {
   GstVideoFilter videofilter;
-  gint width, height, stride;
 
   float cur_sigma, sigma;
-  int windowsize;
+  GstGaussianBlurMethod cur_method, method;
+  guint n_threads;
+
+  /* for sigma scaled down by the 1 << i subsampling of the planes */
+  GstGaussianBlurKernel kernels[3];
+  gboolean box;
 
-  float *kernel;
-  float *kernel_sum;
-  float *tempim;
-  gint16 *smoothedim;
+  /* the slices of the negotiated format, laid out for jobs_n_threads */
+  GThreadPool *pool;
+  gboolean use_pool;
+  GMutex jobs_lock;
+  GCond jobs_cond;
+  GstGaussianBlurJob *jobs;
+  gint n_jobs;
+  guint jobs_n_threads;
+  gint jobs_pending;
 };
 
 struct _GstGaussianBlurClass
@@ -133,8 +133,7 @@ G_STMT_START {							\
 #define CRC_INIT   0xFFFF
 
 static guint16 gst_dp_crc (const guint8 * buffer, guint length);
-static guint16 gst_dp_crc_from_memory_maps (const GstMapInfo * maps,
-    guint n_maps);
+static gboolean gst_dp_crc_from_buffer (GstBuffer * buffer, guint16 * crc);
 
 /* payloading functions */
 
@@ -156,31 +155,12 @@ gst_dp_payload_buffer (GstBuffer * buffer, GstDPHeaderFlag flags)
   /* version, flags, type */
   GST_DP_INIT_HEADER (h, GST_DP_VERSION_1_0, flags, GST_DP_PAYLOAD_BUFFER);
 
-  if ((flags & GST_DP_HEADER_FLAG_CRC_PAYLOAD)) {
-    GstMapInfo *maps;
-    guint n_maps, i;
-
-    buffer_size = 0;
-
-    n_maps = gst_buffer_n_memory (buffer);
-    if (n_maps > 0) {
-      maps = g_newa (GstMapInfo, n_maps);
-
-      for (i = 0; i < n_maps; ++i) {
-        GstMemory *mem;
-
-        mem = gst_buffer_peek_memory (buffer, i);
-        gst_memory_map (mem, &maps[i], GST_MAP_READ);
-        buffer_size += maps[i].size;
-      }
-
-      crc = gst_dp_crc_from_memory_maps (maps, n_maps);
-
-      for (i = 0; i < n_maps; ++i)
-        gst_memory_unmap (maps[i].memory, &maps[i]);
-    }
-  } else {
-    buffer_size = gst_buffer_get_size (buffer);
+  buffer_size = gst_buffer_get_size (buffer);
+  if ((flags & GST_DP_HEADER_FLAG_CRC_PAYLOAD)
+      && !gst_dp_crc_from_buffer (buffer, &crc)) {
+    gst_memory_unmap (mem, &map);
+    gst_memory_unref (mem);
+    return NULL;
   }
 
   /* buffer properties */
@@ -365,6 +345,54 @@ static const guint16 gst_dp_crc_table[256] = {
   0x6e17, 0x7e36, 0x4e55, 0x5e74, 0x2e93, 0x3eb2, 0x0ed1, 0x1ef0
 };
 
+/* Slice-by-8 tables: gst_dp_crc_tables[k][b] is the CRC register after
+ * feeding byte b followed by k zero bytes into a zeroed register, so that
+ * eight bytes can be folded in with eight independent lookups */
+static guint16 gst_dp_crc_tables[8][256];
+
+static void
+gst_dp_crc_init_tables (void)
+{
+  static gsize tables_init = 0;
+
+  if (g_once_init_enter (&tables_init)) {
+    guint i, k;
+
+    for (i = 0; i < 256; i++) {
+      guint16 crc = gst_dp_crc_table[i];
+
+      gst_dp_crc_tables[0][i] = crc;
+      for (k = 1; k < 8; k++) {
+        crc = (guint16) ((crc << 8) ^ gst_dp_crc_table[crc >> 8]);
+        gst_dp_crc_tables[k][i] = crc;
+      }
+    }
+    g_once_init_leave (&tables_init, 1);
+  }
+}
+
+/* feeds @length bytes into @crc_register */
+static guint16
+gst_dp_crc_update (guint16 crc_register, const guint8 * buffer, gsize length)
+{
+  guint16 (*t)[256] = gst_dp_crc_tables;
+
+  /* the register only mixes with the first two bytes of every eight, the
+   * others are independent of it */
+  for (; length >= 8; length -= 8, buffer += 8) {
+    crc_register = t[7][(crc_register >> 8) ^ buffer[0]] ^
+        t[6][(crc_register & 0xff) ^ buffer[1]] ^
+        t[5][buffer[2]] ^ t[4][buffer[3]] ^ t[3][buffer[4]] ^
+        t[2][buffer[5]] ^ t[1][buffer[6]] ^ t[0][buffer[7]];
+  }
+
+  for (; length--;) {
+    crc_register = (guint16) ((crc_register << 8) ^
+        gst_dp_crc_table[((crc_register >> 8) & 0x00ff) ^ *buffer++]);
+  }
+  return crc_register;
+}
+
 /**
  * gst_dp_crc:
  * @buffer: array of bytes
@@ -379,18 +407,17 @@ static const guint16 gst_dp_crc_table[256] = {
 static guint16
 gst_dp_crc (const guint8 * buffer, guint length)
 {
-  guint16 crc_register = CRC_INIT;
+  guint16 crc_register;
 
   if (length == 0)
     return 0;
 
   g_assert (buffer != NULL);
 
+  gst_dp_crc_init_tables ();
+
   /* calc CRC */
-  for (; length--;) {
-    crc_register = (guint16) ((crc_register << 8) ^
-        gst_dp_crc_table[((crc_register >> 8) & 0x00ff) ^ *buffer++]);
-  }
+  crc_register = gst_dp_crc_update (CRC_INIT, buffer, length);
   return (0xffff ^ crc_register);
 }
 
@@ -405,17 +432,12 @@ gst_dp_crc_from_memory_maps (const GstMapInfo * maps, guint n_maps)
 
   g_assert (maps != NULL);
 
+  gst_dp_crc_init_tables ();
+
   /* calc CRC */
   while (n_maps > 0) {
-    guint8 *buffer = maps->data;
-    gsize length = maps->size;
-
-    total_length += length;
-
-    while (length-- > 0) {
-      crc_register = (guint16) ((crc_register << 8) ^
-          gst_dp_crc_table[((crc_register >> 8) & 0x00ff) ^ *buffer++]);
-    }
+    total_length += maps->size;
+    crc_register = gst_dp_crc_update (crc_register, maps->data, maps->size);
     --n_maps;
     ++maps;
   }
@@ -426,6 +448,37 @@ gst_dp_crc_from_memory_maps (const GstMapInfo * maps, guint n_maps)
   return (0xffff ^ crc_register);
 }
 
+/* CRC over all memories of @buffer without merging them */
+static gboolean
+gst_dp_crc_from_buffer (GstBuffer * buffer, guint16 * crc)
+{
+  GstMapInfo *maps;
+  guint n_maps, i;
+
+  *crc = 0;
+  n_maps = gst_buffer_n_memory (buffer);
+  if (n_maps == 0)
+    return TRUE;
+
+  maps = g_newa (GstMapInfo, n_maps);
+  for (i = 0; i < n_maps; ++i) {
+    if (!gst_memory_map (gst_buffer_peek_memory (buffer, i), &maps[i],
+            GST_MAP_READ)) {
+      GST_WARNING ("could not map memory %u of buffer %p", i, buffer);
+      while (i--)
+        gst_memory_unmap (maps[i].memory, &maps[i]);
+      return FALSE;
+    }
+  }
+
+  *crc = gst_dp_crc_from_memory_maps (maps, n_maps);
+
+  for (i = 0; i < n_maps; ++i)
+    gst_memory_unmap (maps[i].memory, &maps[i]);
+
+  return TRUE;
+}
+
 /**
  * gst_dp_init:
  *
@@ -475,6 +528,17 @@ gst_dp_header_payload_type (const guint8 * header)
 
 /*** DEPACKETIZING FUNCTIONS ***/
 
+static void
+gst_dp_buffer_set_header_fields (GstBuffer * buffer, const guint8 * header)
+{
+  GST_BUFFER_TIMESTAMP (buffer) = GST_DP_HEADER_TIMESTAMP (header);
+  GST_BUFFER_DTS (buffer) = GST_DP_HEADER_DTS (header);
+  GST_BUFFER_DURATION (buffer) = GST_DP_HEADER_DURATION (header);
+  GST_BUFFER_OFFSET (buffer) = GST_DP_HEADER_OFFSET (header);
+  GST_BUFFER_OFFSET_END (buffer) = GST_DP_HEADER_OFFSET_END (header);
+  GST_BUFFER_FLAGS (buffer) = GST_DP_HEADER_BUFFER_FLAGS (header);
+}
+
 /**
  * gst_dp_buffer_from_header:
  * @header_length: the length of the packet header
@@ -508,12 +572,46 @@ gst_dp_buffer_from_header (guint header_length, const guint8 * header,
       gst_buffer_new_allocate (allocator,
       (guint) GST_DP_HEADER_PAYLOAD_LENGTH (header), allocation_params);
 
-  GST_BUFFER_TIMESTAMP (buffer) = GST_DP_HEADER_TIMESTAMP (header);
-  GST_BUFFER_DTS (buffer) = GST_DP_HEADER_DTS (header);
-  GST_BUFFER_DURATION (buffer) = GST_DP_HEADER_DURATION (header);
-  GST_BUFFER_OFFSET (buffer) = GST_DP_HEADER_OFFSET (header);
-  GST_BUFFER_OFFSET_END (buffer) = GST_DP_HEADER_OFFSET_END (header);
-  GST_BUFFER_FLAGS (buffer) = GST_DP_HEADER_BUFFER_FLAGS (header);
+  gst_dp_buffer_set_header_fields (buffer, header);
+
+  return buffer;
+}
+
+/**
+ * gst_dp_buffer_from_header_and_payload:
+ * @header_length: the length of the packet header
+ * @header: the byte array of the packet header
+ * @payload: (transfer full): the packet payload
+ *
+ * Creates a newly allocated #GstBuffer from the given header, sharing the
+ * memory of @payload instead of copying it.
+ *
+ * This function does not check the arguments passed to it, use
+ * gst_dp_validate_header() and gst_dp_validate_payload_buffer() first if
+ * the header and payload data are unchecked.
+ *
+ * Returns: A #GstBuffer if the buffer was successfully created, or NULL.
+ */
+GstBuffer *
+gst_dp_buffer_from_header_and_payload (guint header_length,
+    const guint8 * header, GstBuffer * payload)
+{
+  GstBuffer *buffer;
+
+  g_return_val_if_fail (header != NULL, NULL);
+  g_return_val_if_fail (header_length >= GST_DP_HEADER_LENGTH, NULL);
+  g_return_val_if_fail (GST_DP_HEADER_PAYLOAD_TYPE (header) ==
+      GST_DP_PAYLOAD_BUFFER, NULL);
+  g_return_val_if_fail (GST_IS_BUFFER (payload), NULL);
+
+  /* only the memory, the payload may carry the metadata of the buffer it
+   * was received in */
+  buffer = gst_buffer_copy_region (payload, GST_BUFFER_COPY_MEMORY, 0, -1);
+  gst_buffer_unref (payload);
+  if (!buffer)
+    return NULL;
+
+  gst_dp_buffer_set_header_fields (buffer, header);
 
   return buffer;
 }
@@ -754,6 +852,49 @@ crc_error:
   }
 }
 
+/**
+ * gst_dp_validate_payload_buffer:
+ * @header_length: the length of the packet header
+ * @header: the byte array of the packet header
+ * @payload: the packet payload
+ *
+ * Validates the given packet payload using the given packet header
+ * by checking the CRC checksum, like gst_dp_validate_payload() but without
+ * merging the memories of @payload.
+ *
+ * Returns: %TRUE if the CRC matches, or no CRC checksum is present.
+ */
+gboolean
+gst_dp_validate_payload_buffer (guint header_length, const guint8 * header,
+    GstBuffer * payload)
+{
+  guint16 crc_read, crc_calculated;
+
+  g_return_val_if_fail (header != NULL, FALSE);
+  g_return_val_if_fail (header_length >= GST_DP_HEADER_LENGTH, FALSE);
+  g_return_val_if_fail (GST_IS_BUFFER (payload), FALSE);
+
+  if (!(GST_DP_HEADER_FLAGS (header) & GST_DP_HEADER_FLAG_CRC_PAYLOAD))
+    return TRUE;
+
+  crc_read = GST_DP_HEADER_CRC_PAYLOAD (header);
+  if (!gst_dp_crc_from_buffer (payload, &crc_calculated))
+    return FALSE;
+  if (crc_read != crc_calculated)
+    goto crc_error;
+
+  GST_LOG ("payload crc validation: %02x", crc_read);
+  return TRUE;
+
+  /* ERRORS */
+crc_error:
+  {
+    GST_WARNING ("payload crc mismatch: read %02x, calculated %02x", crc_read,
+        crc_calculated);
+    return FALSE;
+  }
+}
+
 /**
  * gst_dp_validate_packet:
  * @header_length: the length of the packet header
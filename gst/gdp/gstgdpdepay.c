@@ -25,6 +25,10 @@
  * This element depayloads GStreamer Data Protocol buffers back to deserialized
  * buffers and events.
  *
+ * Buffer payloads are pushed as sub-buffers of the incoming data, unless
+ * downstream asks for another allocator or for an alignment that they don't
+ * have, in which case they are copied.
+ *
  * |[
  * gst-launch-1.0 -v -m filesrc location=test.gdp ! gdpdepay ! xvimagesink
  * ]| This pipeline plays back a serialized video stream as created in the
@@ -262,13 +266,46 @@ gst_gdp_depay_src_event (GstPad * pad, GstObject * parent, GstEvent * event)
   return res;
 }
 
+/* The payload can be pushed without copying it if its memory is what
+ * downstream would get from the allocator it asked for */
+static gboolean
+gst_gdp_depay_can_share_payload (GstGDPDepay * this, GstBuffer * payload)
+{
+  gsize align = this->allocation_params.align;
+  guint i, n;
+
+  if (this->allocator && g_strcmp0 (this->allocator->mem_type,
+          GST_ALLOCATOR_SYSMEM) != 0)
+    return FALSE;
+
+  if (align == 0)
+    return TRUE;
+
+  n = gst_buffer_n_memory (payload);
+  for (i = 0; i < n; i++) {
+    GstMapInfo map;
+    gboolean aligned;
+
+    if (!gst_memory_map (gst_buffer_peek_memory (payload, i), &map,
+            GST_MAP_READ))
+      return FALSE;
+    aligned = ((guintptr) map.data & align) == 0;
+    gst_memory_unmap (map.memory, &map);
+
+    if (!aligned)
+      return FALSE;
+  }
+
+  return TRUE;
+}
+
 static GstFlowReturn
 gst_gdp_depay_chain (GstPad * pad, GstObject * parent, GstBuffer * buffer)
 {
   GstGDPDepay *this;
   GstFlowReturn ret = GST_FLOW_OK;
   GstCaps *caps;
-  GstBuffer *buf;
+  GstBuffer *buf, *payload;
   GstEvent *event;
   guint available;
 
@@ -343,7 +380,9 @@ gst_gdp_depay_chain (GstPad * pad, GstObject * parent, GstBuffer * buffer)
           goto wrong_type;
         }
 
-        if (this->payload_length) {
+        /* buffer payloads are validated without merging them */
+        if (this->payload_length
+            && this->payload_type != GST_DP_PAYLOAD_BUFFER) {
           const guint8 *data;
           gboolean res;
 
@@ -365,22 +404,37 @@ gst_gdp_depay_chain (GstPad * pad, GstObject * parent, GstBuffer * buffer)
           goto no_caps;
 
         GST_LOG_OBJECT (this, "reading GDP buffer from adapter");
-        buf =
-            gst_dp_buffer_from_header (GST_DP_HEADER_LENGTH, this->header,
-            this->allocator, &this->allocation_params);
-        if (!buf)
-          goto buffer_failed;
 
-        /* now take the payload if there is any */
-        if (this->payload_length > 0) {
-          GstMapInfo map;
+        /* take the payload as sub-buffers of the incoming data */
+        if (this->payload_length > 0)
+          payload = gst_adapter_take_buffer_fast (this->adapter,
+              this->payload_length);
+        else
+          payload = gst_buffer_new ();
 
-          gst_buffer_map (buf, &map, GST_MAP_WRITE);
-          gst_adapter_copy (this->adapter, map.data, 0, this->payload_length);
-          gst_buffer_unmap (buf, &map);
+        if (!gst_dp_validate_payload_buffer (GST_DP_HEADER_LENGTH,
+                this->header, payload)) {
+          gst_buffer_unref (payload);
+          goto payload_validate_error;
+        }
 
-          gst_adapter_flush (this->adapter, this->payload_length);
+        if (gst_gdp_depay_can_share_payload (this, payload)) {
+          buf = gst_dp_buffer_from_header_and_payload (GST_DP_HEADER_LENGTH,
+              this->header, payload);
+        } else {
+          buf = gst_dp_buffer_from_header (GST_DP_HEADER_LENGTH, this->header,
+              this->allocator, &this->allocation_params);
+          if (buf && this->payload_length > 0) {
+            GstMapInfo map;
+
+            gst_buffer_map (buf, &map, GST_MAP_WRITE);
+            gst_buffer_extract (payload, 0, map.data, this->payload_length);
+            gst_buffer_unmap (buf, &map);
+          }
+          gst_buffer_unref (payload);
         }
+        if (!buf)
+          goto buffer_failed;
 
         if (GST_BUFFER_TIMESTAMP (buf) > -this->ts_offset)
           GST_BUFFER_TIMESTAMP (buf) += this->ts_offset;
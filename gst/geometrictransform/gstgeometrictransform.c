@@ -24,6 +24,7 @@
 #include "gstgeometrictransform.h"
 #include "geometricmath.h"
 #include <string.h>
+#include <math.h>
 
 GST_DEBUG_CATEGORY_STATIC (geometric_transform_debug);
 #define GST_CAT_DEFAULT geometric_transform_debug
@@ -49,7 +50,9 @@ static GstVideoFilterClass *parent_class = NULL;
 enum
 {
   PROP_0,
-  PROP_OFF_EDGE_PIXELS
+  PROP_OFF_EDGE_PIXELS,
+  PROP_INTERPOLATION,
+  PROP_N_THREADS
 };
 
 #define GST_GT_OFF_EDGES_PIXELS_METHOD_TYPE ( \
@@ -74,23 +77,115 @@ gst_geometric_transform_off_edges_pixels_method_get_type (void)
   return method_type;
 }
 
+#define GST_GT_INTERPOLATION_METHOD_TYPE ( \
+    gst_geometric_transform_interpolation_method_get_type())
+static GType
+gst_geometric_transform_interpolation_method_get_type (void)
+{
+  static GType method_type = 0;
+
+  static const GEnumValue method_types[] = {
+    {GST_GT_INTERPOLATION_NEAREST, "Nearest neighbour", "nearest"},
+    {GST_GT_INTERPOLATION_BILINEAR, "Bilinear", "bilinear"},
+    {0, NULL, NULL}
+  };
+
+  if (!method_type) {
+    method_type =
+        g_enum_register_static ("GstGeometricTransformInterpolationMethod",
+        method_types);
+  }
+  return method_type;
+}
+
 #define DEFAULT_OFF_EDGE_PIXELS GST_GT_OFF_EDGES_PIXELS_IGNORE
+#define DEFAULT_INTERPOLATION GST_GT_INTERPOLATION_NEAREST
+#define DEFAULT_N_THREADS 1
+
+/* The map and the output are traversed in tiles so that the source pixels
+ * of neighbouring output pixels, which are usually close to each other in
+ * both directions, are still in the cache when they are needed again */
+#define TILE_WIDTH 64
+#define TILE_HEIGHT 16
+
+#define INVALID_ENTRY G_MAXUINT16
+
+static void
+gst_geometric_transform_set_entry (GstGeometricTransform * gt,
+    GstGeometricTransformMapEntry * entry, gdouble in_x, gdouble in_y)
+{
+  /* operate on out of edge pixels */
+  switch (gt->off_edge_pixels) {
+    case GST_GT_OFF_EDGES_PIXELS_CLAMP:
+      in_x = CLAMP (in_x, 0, gt->width - 1);
+      in_y = CLAMP (in_y, 0, gt->height - 1);
+      break;
+
+    case GST_GT_OFF_EDGES_PIXELS_WRAP:
+      in_x = gst_gm_mod_float (in_x, gt->width);
+      in_y = gst_gm_mod_float (in_y, gt->height);
+      if (in_x < 0)
+        in_x += gt->width;
+      if (in_y < 0)
+        in_y += gt->height;
+      break;
+
+    default:
+      break;
+  }
+
+  /* the pixel is valid if its position truncates to one inside the frame */
+  if (!(in_x > -1.0 && in_x < gt->width && in_y > -1.0 && in_y < gt->height)) {
+    entry->x = entry->y = INVALID_ENTRY;
+    entry->fx = entry->fy = 0;
+    return;
+  }
+
+  if (gt->interpolation == GST_GT_INTERPOLATION_BILINEAR) {
+    gdouble fl_x, fl_y;
+    gint x, y, fx, fy;
+
+    in_x = CLAMP (in_x, 0, gt->width - 1);
+    in_y = CLAMP (in_y, 0, gt->height - 1);
+    fl_x = floor (in_x);
+    fl_y = floor (in_y);
+    x = (gint) fl_x;
+    y = (gint) fl_y;
+    fx = (gint) ((in_x - fl_x) * 256 + 0.5);
+    fy = (gint) ((in_y - fl_y) * 256 + 0.5);
+    if (fx == 256) {
+      x++;
+      fx = 0;
+    }
+    if (fy == 256) {
+      y++;
+      fy = 0;
+    }
+    /* x and y can only be the last column/row if the weight is 0, so the
+     * right/bottom neighbours are never read from outside the frame */
+    entry->x = x;
+    entry->y = y;
+    entry->fx = fx;
+    entry->fy = fy;
+  } else {
+    entry->x = (gint) in_x;
+    entry->y = (gint) in_y;
+    entry->fx = entry->fy = 0;
+  }
+}
 
 /* must be called with the object lock */
 static gboolean
 gst_geometric_transform_generate_map (GstGeometricTransform * gt)
 {
-  gint x, y;
+  gint x, y, x0, y0;
   gdouble in_x, in_y;
   gboolean ret = TRUE;
   GstGeometricTransformClass *klass;
-  gdouble *ptr;
-
-  GST_INFO_OBJECT (gt, "Generating new transform map");
+  GstGeometricTransformMapEntry *ptr;
 
-  /* cleanup old map */
-  g_free (gt->map);
-  gt->map = NULL;
+  if (gt->precalc_map)
+    GST_INFO_OBJECT (gt, "Generating new transform map");
 
   klass = GST_GEOMETRIC_TRANSFORM_GET_CLASS (gt);
 
@@ -98,22 +193,32 @@ gst_geometric_transform_generate_map (GstGeometricTransform * gt)
   g_return_val_if_fail (klass->map_func, FALSE);
 
   /*
-   * (x,y) pairs of the inverse mapping
+   * Source positions of the inverse mapping, stored in the order the
+   * output is rendered in: rows of TILE_HEIGHT lines, each split into tiles
+   * of TILE_WIDTH pixels that are stored line by line.
    */
-  gt->map = g_malloc0 (sizeof (gdouble) * gt->width * gt->height * 2);
+  gt->map = g_renew (GstGeometricTransformMapEntry, gt->map,
+      gt->width * gt->height);
   ptr = gt->map;
 
-  for (y = 0; y < gt->height; y++) {
-    for (x = 0; x < gt->width; x++) {
-      if (!klass->map_func (gt, x, y, &in_x, &in_y)) {
-        /* child should have warned */
-        ret = FALSE;
-        goto end;
-      }
+  for (y0 = 0; y0 < gt->height; y0 += TILE_HEIGHT) {
+    gint y1 = MIN (y0 + TILE_HEIGHT, gt->height);
+
+    for (x0 = 0; x0 < gt->width; x0 += TILE_WIDTH) {
+      gint x1 = MIN (x0 + TILE_WIDTH, gt->width);
+
+      for (y = y0; y < y1; y++) {
+        for (x = x0; x < x1; x++) {
+          if (!klass->map_func (gt, x, y, &in_x, &in_y)) {
+            /* child should have warned */
+            ret = FALSE;
+            goto end;
+          }
 
-      ptr[0] = in_x;
-      ptr[1] = in_y;
-      ptr += 2;
+          gst_geometric_transform_set_entry (gt, ptr, in_x, in_y);
+          ptr++;
+        }
+      }
     }
   }
 
@@ -140,14 +245,30 @@ gst_geometric_transform_set_info (GstVideoFilter * vfilter, GstCaps * incaps,
   gt = GST_GEOMETRIC_TRANSFORM_CAST (vfilter);
   klass = GST_GEOMETRIC_TRANSFORM_GET_CLASS (gt);
 
+  /* the map stores positions as 16 bits with one value reserved */
+  if (in_info->width >= INVALID_ENTRY || in_info->height >= INVALID_ENTRY) {
+    GST_ERROR_OBJECT (gt, "Unsupported size %dx%d", in_info->width,
+        in_info->height);
+    return FALSE;
+  }
+
   old_width = gt->width;
   old_height = gt->height;
 
   gt->width = in_info->width;
   gt->height = in_info->height;
+  gt->format = GST_VIDEO_INFO_FORMAT (in_info);
   gt->row_stride = in_info->stride[0];
   gt->pixel_stride = GST_VIDEO_INFO_COMP_PSTRIDE (in_info, 0);
 
+  /* in AYUV black is not just all zeros:
+   * 0x10 is black for Y,
+   * 0x80 is black for Cr and Cb */
+  if (gt->format == GST_VIDEO_FORMAT_AYUV)
+    GST_WRITE_UINT32_BE (gt->black, 0xff108080);
+  else
+    memset (gt->black, 0, sizeof (gt->black));
+
   /* regenerate the map */
   GST_OBJECT_LOCK (gt);
   if (gt->map == NULL || old_width == 0 || old_height == 0
@@ -164,48 +285,252 @@ gst_geometric_transform_set_info (GstVideoFilter * vfilter, GstCaps * incaps,
   return ret;
 }
 
+/* Renders @n output pixels from the map entries, writing black for the
+ * entries that are off the edges */
+typedef void (*GstGeometricTransformRenderFunc) (GstGeometricTransform * gt,
+    const GstGeometricTransformMapEntry * map, const guint8 * in,
+    gint in_stride, guint8 * out, gint n);
+
+#define DEFINE_RENDER_NEAREST(pstride) \
+static void \
+render_nearest_##pstride (GstGeometricTransform * gt, \
+    const GstGeometricTransformMapEntry * map, const guint8 * in, \
+    gint in_stride, guint8 * out, gint n) \
+{ \
+  gint i; \
+  \
+  for (i = 0; i < n; i++, out += pstride) { \
+    if (map[i].x == INVALID_ENTRY) { \
+      memcpy (out, gt->black, pstride); \
+      continue; \
+    } \
+    memcpy (out, in + map[i].y * in_stride + map[i].x * pstride, pstride); \
+  } \
+}
+
+DEFINE_RENDER_NEAREST (1)
+DEFINE_RENDER_NEAREST (2)
+DEFINE_RENDER_NEAREST (3)
+DEFINE_RENDER_NEAREST (4)
+
+/* Interpolates all four 8 bit components of a pixel at once, two at a time
+ * in the 16 bit halves of a 32 bit word.
+ *
+ * There's no SIMD version of this: every output pixel reads four input
+ * pixels at positions taken from the map, and these scattered loads are
+ * what the renderer spends its time on, not the six multiplies here. SSE2
+ * and NEON have no gather loads, the AVX2 ones aren't faster than scalar
+ * loads for 4 byte elements, and ORC can't express them, so a vector kernel
+ * would have to load the pixels one by one anyway and only save a few
+ * arithmetic instructions. */
+static inline guint32
+lerp_4x8 (guint32 a, guint32 b, guint w)
+{
+  guint32 rb, ag;
+
+  rb = ((a & 0x00ff00ff) * (256 - w) + (b & 0x00ff00ff) * w + 0x00800080) >> 8;
+  ag = (((a >> 8) & 0x00ff00ff) * (256 - w) + ((b >> 8) & 0x00ff00ff) * w +
+      0x00800080) >> 8;
+
+  return (rb & 0x00ff00ff) | ((ag & 0x00ff00ff) << 8);
+}
+
 static void
-gst_geometric_transform_do_map (GstGeometricTransform * gt, guint8 * in_data,
-    guint8 * out_data, gint x, gint y, gdouble in_x, gdouble in_y)
+render_bilinear_4 (GstGeometricTransform * gt,
+    const GstGeometricTransformMapEntry * map, const guint8 * in,
+    gint in_stride, guint8 * out, gint n)
 {
-  gint in_offset;
-  gint out_offset;
+  gint i;
 
-  out_offset = y * gt->row_stride + x * gt->pixel_stride;
+  for (i = 0; i < n; i++, out += 4) {
+    const guint8 *s0, *s1;
+    guint32 p00, p01, p10, p11, p;
+    gint dx, dy;
 
-  /* operate on out of edge pixels */
-  switch (gt->off_edge_pixels) {
-    case GST_GT_OFF_EDGES_PIXELS_CLAMP:
-      in_x = CLAMP (in_x, 0, gt->width - 1);
-      in_y = CLAMP (in_y, 0, gt->height - 1);
-      break;
+    if (map[i].x == INVALID_ENTRY) {
+      memcpy (out, gt->black, 4);
+      continue;
+    }
 
-    case GST_GT_OFF_EDGES_PIXELS_WRAP:
-      in_x = gst_gm_mod_float (in_x, gt->width);
-      in_y = gst_gm_mod_float (in_y, gt->height);
-      if (in_x < 0)
-        in_x += gt->width;
-      if (in_y < 0)
-        in_y += gt->height;
-      break;
+    dx = map[i].fx ? 4 : 0;
+    dy = map[i].fy ? in_stride : 0;
+    s0 = in + map[i].y * in_stride + map[i].x * 4;
+    s1 = s0 + dy;
+    memcpy (&p00, s0, 4);
+    memcpy (&p01, s0 + dx, 4);
+    memcpy (&p10, s1, 4);
+    memcpy (&p11, s1 + dx, 4);
+
+    p = lerp_4x8 (lerp_4x8 (p00, p01, map[i].fx), lerp_4x8 (p10, p11,
+            map[i].fx), map[i].fy);
+    memcpy (out, &p, 4);
+  }
+}
+
+#define DEFINE_RENDER_BILINEAR(name,pstride,ncomps,type,read,write) \
+static void \
+render_bilinear_##name (GstGeometricTransform * gt, \
+    const GstGeometricTransformMapEntry * map, const guint8 * in, \
+    gint in_stride, guint8 * out, gint n) \
+{ \
+  gint i, c; \
+  \
+  for (i = 0; i < n; i++, out += pstride) { \
+    const guint8 *s0, *s1; \
+    guint fx, fy, dx, dy; \
+    \
+    if (map[i].x == INVALID_ENTRY) { \
+      memcpy (out, gt->black, pstride); \
+      continue; \
+    } \
+    \
+    fx = map[i].fx; \
+    fy = map[i].fy; \
+    dx = fx ? pstride : 0; \
+    dy = fy ? in_stride : 0; \
+    s0 = in + map[i].y * in_stride + map[i].x * pstride; \
+    s1 = s0 + dy; \
+    for (c = 0; c < ncomps; c++) { \
+      const guint o = c * sizeof (type); \
+      guint64 top, bottom; \
+      \
+      top = read (s0 + o) * (256 - fx) + read (s0 + dx + o) * fx; \
+      bottom = read (s1 + o) * (256 - fx) + read (s1 + dx + o) * fx; \
+      write (out + o, (type) ((top * (256 - fy) + bottom * fy + 32768) >> 16)); \
+    } \
+  } \
+}
+
+#define READ_UINT8(p) (*(p))
+#define WRITE_UINT8(p,v) (*(p) = (v))
+
+DEFINE_RENDER_BILINEAR (1, 1, 1, guint8, READ_UINT8, WRITE_UINT8)
+DEFINE_RENDER_BILINEAR (3, 3, 3, guint8, READ_UINT8, WRITE_UINT8)
+DEFINE_RENDER_BILINEAR (16le, 2, 1, guint16, GST_READ_UINT16_LE,
+    GST_WRITE_UINT16_LE)
+DEFINE_RENDER_BILINEAR (16be, 2, 1, guint16, GST_READ_UINT16_BE,
+    GST_WRITE_UINT16_BE)
+
+static GstGeometricTransformRenderFunc
+gst_geometric_transform_get_render_func (GstGeometricTransform * gt)
+{
+  if (gt->interpolation == GST_GT_INTERPOLATION_BILINEAR) {
+    switch (gt->format) {
+      case GST_VIDEO_FORMAT_GRAY8:
+        return render_bilinear_1;
+      case GST_VIDEO_FORMAT_GRAY16_LE:
+        return render_bilinear_16le;
+      case GST_VIDEO_FORMAT_GRAY16_BE:
+        return render_bilinear_16be;
+      case GST_VIDEO_FORMAT_RGB:
+      case GST_VIDEO_FORMAT_BGR:
+        return render_bilinear_3;
+      default:
+        return render_bilinear_4;
+    }
+  }
 
+  switch (gt->pixel_stride) {
+    case 1:
+      return render_nearest_1;
+    case 2:
+      return render_nearest_2;
+    case 3:
+      return render_nearest_3;
     default:
-      break;
+      return render_nearest_4;
   }
+}
+
+/* Renders the rows of tiles of slice @slice of the current frame */
+static void
+gst_geometric_transform_render_slice (GstGeometricTransform * gt, gint slice)
+{
+  GstGeometricTransformRenderFunc render;
+  const GstGeometricTransformMapEntry *map;
+  gint n_tile_rows, x0, y0, y_start, y_end, y;
+
+  render = gst_geometric_transform_get_render_func (gt);
+
+  n_tile_rows = (gt->height + TILE_HEIGHT - 1) / TILE_HEIGHT;
+  y_start = n_tile_rows * slice / gt->n_slices * TILE_HEIGHT;
+  y_end = MIN (n_tile_rows * (slice + 1) / gt->n_slices * TILE_HEIGHT,
+      gt->height);
 
-  {
-    gint trunc_x = (gint) in_x;
-    gint trunc_y = (gint) in_y;
-    /* only set the values if the values are valid */
-    if (trunc_x >= 0 && trunc_x < gt->width && trunc_y >= 0 &&
-        trunc_y < gt->height) {
-      in_offset = trunc_y * gt->row_stride + trunc_x * gt->pixel_stride;
+  map = gt->map + y_start * gt->width;
+  for (y0 = y_start; y0 < y_end; y0 += TILE_HEIGHT) {
+    gint y1 = MIN (y0 + TILE_HEIGHT, gt->height);
 
-      memcpy (out_data + out_offset, in_data + in_offset, gt->pixel_stride);
+    for (x0 = 0; x0 < gt->width; x0 += TILE_WIDTH) {
+      gint w = MIN (TILE_WIDTH, gt->width - x0);
+
+      for (y = y0; y < y1; y++) {
+        render (gt, map, gt->slice_in, gt->slice_in_stride,
+            gt->slice_out + y * gt->slice_out_stride + x0 * gt->pixel_stride,
+            w);
+        map += w;
+      }
     }
   }
 }
 
+static void
+gst_geometric_transform_slice_func (gpointer data, gpointer user_data)
+{
+  GstGeometricTransform *gt = user_data;
+
+  gst_geometric_transform_render_slice (gt, GPOINTER_TO_INT (data));
+
+  g_mutex_lock (&gt->slice_lock);
+  if (--gt->slices_pending == 0)
+    g_cond_signal (&gt->slice_cond);
+  g_mutex_unlock (&gt->slice_lock);
+}
+
+/* must be called with the object lock */
+static void
+gst_geometric_transform_render (GstGeometricTransform * gt,
+    GstVideoFrame * in_frame, GstVideoFrame * out_frame)
+{
+  gint n_threads, i;
+
+  gt->slice_in = GST_VIDEO_FRAME_PLANE_DATA (in_frame, 0);
+  gt->slice_in_stride = GST_VIDEO_FRAME_PLANE_STRIDE (in_frame, 0);
+  gt->slice_out = GST_VIDEO_FRAME_PLANE_DATA (out_frame, 0);
+  gt->slice_out_stride = GST_VIDEO_FRAME_PLANE_STRIDE (out_frame, 0);
+
+  n_threads = gt->n_threads ? gt->n_threads : g_get_num_processors ();
+  gt->n_slices = CLAMP (n_threads, 1,
+      (gt->height + TILE_HEIGHT - 1) / TILE_HEIGHT);
+
+  if (gt->n_slices > 1) {
+    if (!gt->pool) {
+      gt->pool = g_thread_pool_new (gst_geometric_transform_slice_func, gt,
+          gt->n_slices - 1, FALSE, NULL);
+    } else if (g_thread_pool_get_max_threads (gt->pool) != gt->n_slices - 1) {
+      g_thread_pool_set_max_threads (gt->pool, gt->n_slices - 1, NULL);
+    }
+  }
+
+  if (gt->n_slices == 1 || !gt->pool) {
+    gt->n_slices = 1;
+    gst_geometric_transform_render_slice (gt, 0);
+    return;
+  }
+
+  /* the last slices go to the pool, the first is rendered here */
+  gt->slices_pending = gt->n_slices - 1;
+  for (i = 1; i < gt->n_slices; i++)
+    g_thread_pool_push (gt->pool, GINT_TO_POINTER (i), NULL);
+
+  gst_geometric_transform_render_slice (gt, 0);
+
+  g_mutex_lock (&gt->slice_lock);
+  while (gt->slices_pending > 0)
+    g_cond_wait (&gt->slice_cond, &gt->slice_lock);
+  g_mutex_unlock (&gt->slice_lock);
+}
+
 static void
 gst_geometric_transform_before_transform (GstBaseTransform * trans,
     GstBuffer * outbuf)
@@ -229,64 +554,39 @@ gst_geometric_transform_transform_frame (GstVideoFilter * vfilter,
 {
   GstGeometricTransform *gt;
   GstGeometricTransformClass *klass;
-  gint x, y, i;
   GstFlowReturn ret = GST_FLOW_OK;
-  gdouble *ptr;
-  guint8 *in_data;
-  guint8 *out_data;
 
   gt = GST_GEOMETRIC_TRANSFORM_CAST (vfilter);
   klass = GST_GEOMETRIC_TRANSFORM_GET_CLASS (gt);
 
-  in_data = GST_VIDEO_FRAME_PLANE_DATA (in_frame, 0);
-  out_data = GST_VIDEO_FRAME_PLANE_DATA (out_frame, 0);
-
-  if (GST_VIDEO_FRAME_FORMAT (out_frame) == GST_VIDEO_FORMAT_AYUV) {
-    /* in AYUV black is not just all zeros:
-     * 0x10 is black for Y,
-     * 0x80 is black for Cr and Cb */
-    for (i = 0; i < out_frame->map[0].size; i += 4)
-      GST_WRITE_UINT32_BE (out_data + i, 0xff108080);
-  } else {
-    memset (out_data, 0, out_frame->map[0].size);
-  }
-
   GST_OBJECT_LOCK (gt);
   if (gt->precalc_map) {
     if (gt->needs_remap) {
       if (klass->prepare_func)
         if (!klass->prepare_func (gt)) {
-          ret = FALSE;
+          ret = GST_FLOW_ERROR;
           goto end;
         }
       gst_geometric_transform_generate_map (gt);
     }
-    g_return_val_if_fail (gt->map, GST_FLOW_ERROR);
-    ptr = gt->map;
-    for (y = 0; y < gt->height; y++) {
-      for (x = 0; x < gt->width; x++) {
-        /* do the mapping */
-        gst_geometric_transform_do_map (gt, in_data, out_data, x, y, ptr[0],
-            ptr[1]);
-        ptr += 2;
-      }
-    }
   } else {
-    for (y = 0; y < gt->height; y++) {
-      for (x = 0; x < gt->width; x++) {
-        gdouble in_x, in_y;
-
-        if (klass->map_func (gt, x, y, &in_x, &in_y)) {
-          gst_geometric_transform_do_map (gt, in_data, out_data, x, y, in_x,
-              in_y);
-        } else {
-          GST_WARNING_OBJECT (gt, "Failed to do mapping for %d %d", x, y);
-          ret = GST_FLOW_ERROR;
-          goto end;
-        }
-      }
+    /* the mapping changes on every frame */
+    if (!gst_geometric_transform_generate_map (gt)) {
+      GST_WARNING_OBJECT (gt, "Failed to do mapping");
+      ret = GST_FLOW_ERROR;
+      goto end;
     }
   }
+
+  if (!gt->map) {
+    GST_ERROR_OBJECT (gt, "No transform map");
+    ret = GST_FLOW_ERROR;
+    goto end;
+  }
+
+  /* pixels off the edges are written black by the renderer */
+  gst_geometric_transform_render (gt, in_frame, out_frame);
+
 end:
   GST_OBJECT_UNLOCK (gt);
   return ret;
@@ -304,6 +604,18 @@ gst_geometric_transform_set_property (GObject * object, guint prop_id,
     case PROP_OFF_EDGE_PIXELS:
       GST_OBJECT_LOCK (gt);
       gt->off_edge_pixels = g_value_get_enum (value);
+      gst_geometric_transform_set_need_remap (gt);
+      GST_OBJECT_UNLOCK (gt);
+      break;
+    case PROP_INTERPOLATION:
+      GST_OBJECT_LOCK (gt);
+      gt->interpolation = g_value_get_enum (value);
+      gst_geometric_transform_set_need_remap (gt);
+      GST_OBJECT_UNLOCK (gt);
+      break;
+    case PROP_N_THREADS:
+      GST_OBJECT_LOCK (gt);
+      gt->n_threads = g_value_get_uint (value);
       GST_OBJECT_UNLOCK (gt);
       break;
     default:
@@ -324,6 +636,12 @@ gst_geometric_transform_get_property (GObject * object, guint prop_id,
     case PROP_OFF_EDGE_PIXELS:
       g_value_set_enum (value, gt->off_edge_pixels);
       break;
+    case PROP_INTERPOLATION:
+      g_value_set_enum (value, gt->interpolation);
+      break;
+    case PROP_N_THREADS:
+      g_value_set_uint (value, gt->n_threads);
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
       break;
@@ -344,9 +662,28 @@ gst_geometric_transform_stop (GstBaseTransform * trans)
   g_free (gt->map);
   gt->map = NULL;
 
+  if (gt->pool) {
+    g_thread_pool_free (gt->pool, FALSE, TRUE);
+    gt->pool = NULL;
+  }
+
   return TRUE;
 }
 
+static void
+gst_geometric_transform_finalize (GObject * object)
+{
+  GstGeometricTransform *gt = GST_GEOMETRIC_TRANSFORM_CAST (object);
+
+  g_free (gt->map);
+  if (gt->pool)
+    g_thread_pool_free (gt->pool, FALSE, TRUE);
+  g_mutex_clear (&gt->slice_lock);
+  g_cond_clear (&gt->slice_cond);
+
+  G_OBJECT_CLASS (parent_class)->finalize (object);
+}
+
 static void
 gst_geometric_transform_base_init (gpointer g_class)
 {
@@ -373,6 +710,7 @@ gst_geometric_transform_class_init (gpointer klass, gpointer class_data)
 
   obj_class->set_property = gst_geometric_transform_set_property;
   obj_class->get_property = gst_geometric_transform_get_property;
+  obj_class->finalize = gst_geometric_transform_finalize;
 
   trans_class->stop = GST_DEBUG_FUNCPTR (gst_geometric_transform_stop);
   trans_class->before_transform =
@@ -389,7 +727,35 @@ gst_geometric_transform_class_init (gpointer klass, gpointer class_data)
           GST_GT_OFF_EDGES_PIXELS_METHOD_TYPE, DEFAULT_OFF_EDGE_PIXELS,
           GST_PARAM_CONTROLLABLE | G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
 
+  /**
+   * GstGeometricTransform:interpolation:
+   *
+   * How the input is sampled at the mapped positions.
+   *
+   * Since: 1.24
+   */
+  g_object_class_install_property (obj_class, PROP_INTERPOLATION,
+      g_param_spec_enum ("interpolation", "Interpolation",
+          "Interpolation method", GST_GT_INTERPOLATION_METHOD_TYPE,
+          DEFAULT_INTERPOLATION,
+          GST_PARAM_CONTROLLABLE | G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
+  /**
+   * GstGeometricTransform:n-threads:
+   *
+   * Maximum number of threads to render each frame with, 0 for the number
+   * of processors.
+   *
+   * Since: 1.24
+   */
+  g_object_class_install_property (obj_class, PROP_N_THREADS,
+      g_param_spec_uint ("n-threads", "Threads",
+          "Maximum number of threads to use (0 = number of processors)", 0,
+          G_MAXINT, DEFAULT_N_THREADS,
+          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
   gst_type_mark_as_plugin_api (GST_GT_OFF_EDGES_PIXELS_METHOD_TYPE, 0);
+  gst_type_mark_as_plugin_api (GST_GT_INTERPOLATION_METHOD_TYPE, 0);
   gst_type_mark_as_plugin_api (GST_TYPE_GEOMETRIC_TRANSFORM, 0);
 }
 
@@ -399,6 +765,10 @@ gst_geometric_transform_init (GTypeInstance * instance, gpointer g_class)
   GstGeometricTransform *gt = GST_GEOMETRIC_TRANSFORM_CAST (instance);
 
   gt->off_edge_pixels = DEFAULT_OFF_EDGE_PIXELS;
+  gt->interpolation = DEFAULT_INTERPOLATION;
+  gt->n_threads = DEFAULT_N_THREADS;
+  g_mutex_init (&gt->slice_lock);
+  g_cond_init (&gt->slice_cond);
   gt->precalc_map = TRUE;
   gt->needs_remap = TRUE;
 }
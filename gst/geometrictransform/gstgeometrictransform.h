@@ -46,8 +46,29 @@ enum
   GST_GT_OFF_EDGES_PIXELS_WRAP
 };
 
+enum
+{
+  GST_GT_INTERPOLATION_NEAREST = 0,
+  GST_GT_INTERPOLATION_BILINEAR
+};
+
 typedef struct _GstGeometricTransform GstGeometricTransform;
 typedef struct _GstGeometricTransformClass GstGeometricTransformClass;
+typedef struct _GstGeometricTransformMapEntry GstGeometricTransformMapEntry;
+
+/*
+ * GstGeometricTransformMapEntry:
+ *
+ * Source position of one output pixel in the precalculated map. @x and @y
+ * are the top-left pixel of the 2x2 neighbourhood, @fx and @fy the weights
+ * in 1/256 of the right and bottom neighbours (always 0 for nearest
+ * neighbour interpolation, and for the last column and row). Pixels that
+ * map off the edges have @x set to G_MAXUINT16.
+ */
+struct _GstGeometricTransformMapEntry {
+  guint16 x, y;
+  guint8 fx, fy;
+};
 
 /**
  * GstGeometricTransformMapFunc:
@@ -99,8 +120,23 @@ struct _GstGeometricTransform {
 
   /* properties */
   gint off_edge_pixels;
-
-  gdouble *map;
+  gint interpolation;
+  guint n_threads;
+
+  /* in tile order, see gst_geometric_transform_generate_map() */
+  GstGeometricTransformMapEntry *map;
+  guint8 black[4];
+
+  /* slices of the current frame rendered by the pool threads */
+  GThreadPool *pool;
+  GMutex slice_lock;
+  GCond slice_cond;
+  gint n_slices;
+  gint slices_pending;
+  const guint8 *slice_in;
+  gint slice_in_stride;
+  guint8 *slice_out;
+  gint slice_out_stride;
 };
 
 struct _GstGeometricTransformClass {
@@ -73,10 +73,12 @@ static gboolean gst_inter_audio_sink_query (GstBaseSink * sink,
 enum
 {
   PROP_0,
-  PROP_CHANNEL
+  PROP_CHANNEL,
+  PROP_FAN_OUT_DEPTH
 };
 
 #define DEFAULT_CHANNEL ("default")
+#define DEFAULT_FAN_OUT_DEPTH 0
 
 /* pad templates */
 static GstStaticPadTemplate gst_inter_audio_sink_sink_template =
@@ -126,12 +128,40 @@ gst_inter_audio_sink_class_init (GstInterAudioSinkClass * klass)
       g_param_spec_string ("channel", "Channel",
           "Channel name to match inter src and sink elements",
           DEFAULT_CHANNEL, G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
+  /**
+   * GstInterAudioSink:fan-out-depth:
+   *
+   * Number of buffers kept on the channel for the interaudiosrc elements
+   * reading from it. With a non-zero value, buffers are passed on without
+   * copying and every reader consumes them independently, with its own
+   * #GstInterAudioSrc:buffer-time and #GstInterAudioSrc:period-time. A
+   * reader that falls behind by more than this many buffers skips ahead,
+   * which is counted in its #GstInterAudioSrc:overruns property.
+   *
+   * With 0, all readers take their data from a single shared buffer. The
+   * first sink started on a channel with a non-zero value switches the
+   * channel to fan-out mode with that depth for as long as the channel
+   * exists. Sinks started later on that channel with a different value,
+   * including 0, still write to the same buffers with the original depth and
+   * post a warning message.
+   *
+   * Since: 1.24
+   */
+  g_object_class_install_property (gobject_class, PROP_FAN_OUT_DEPTH,
+      g_param_spec_uint ("fan-out-depth", "Fan-out depth",
+          "Number of buffers kept for independent readers "
+          "(0 = all readers share a single buffer)", 0, G_MAXUINT16,
+          DEFAULT_FAN_OUT_DEPTH,
+          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS |
+          GST_PARAM_MUTABLE_READY));
 }
 
 static void
 gst_inter_audio_sink_init (GstInterAudioSink * interaudiosink)
 {
   interaudiosink->channel = g_strdup (DEFAULT_CHANNEL);
+  interaudiosink->fan_out_depth = DEFAULT_FAN_OUT_DEPTH;
   interaudiosink->input_adapter = gst_adapter_new ();
 }
 
@@ -146,6 +176,9 @@ gst_inter_audio_sink_set_property (GObject * object, guint property_id,
       g_free (interaudiosink->channel);
       interaudiosink->channel = g_value_dup_string (value);
       break;
+    case PROP_FAN_OUT_DEPTH:
+      interaudiosink->fan_out_depth = g_value_get_uint (value);
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, property_id, pspec);
       break;
@@ -162,6 +195,9 @@ gst_inter_audio_sink_get_property (GObject * object, guint property_id,
     case PROP_CHANNEL:
       g_value_set_string (value, interaudiosink->channel);
       break;
+    case PROP_FAN_OUT_DEPTH:
+      g_value_set_uint (value, interaudiosink->fan_out_depth);
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, property_id, pspec);
       break;
@@ -208,8 +244,28 @@ gst_inter_audio_sink_start (GstBaseSink * sink)
   GST_DEBUG_OBJECT (interaudiosink, "start");
 
   interaudiosink->surface = gst_inter_surface_get (interaudiosink->channel);
+
+  if (interaudiosink->fan_out_depth > 0)
+    interaudiosink->ring =
+        gst_inter_surface_ensure_ring (interaudiosink->surface,
+        &interaudiosink->surface->audio_ring, interaudiosink->fan_out_depth);
+  else
+    interaudiosink->ring =
+        g_atomic_pointer_get (&interaudiosink->surface->audio_ring);
+
+  /* The depth is fixed by the first sink that switched the channel to
+   * fan-out mode, we keep writing to its ring */
+  if (interaudiosink->ring
+      && interaudiosink->ring->depth != interaudiosink->fan_out_depth) {
+    GST_ELEMENT_WARNING (interaudiosink, RESOURCE, SETTINGS, (NULL),
+        ("Channel '%s' is in fan-out mode with a depth of %u buffers, "
+            "ignoring fan-out-depth %u", interaudiosink->channel,
+            interaudiosink->ring->depth, interaudiosink->fan_out_depth));
+  }
+
   g_mutex_lock (&interaudiosink->surface->mutex);
   memset (&interaudiosink->surface->audio_info, 0, sizeof (GstAudioInfo));
+  g_atomic_int_inc (&interaudiosink->surface->audio_info_cookie);
 
   /* We want to write latency-time before syncing has happened */
   /* FIXME: The other side can change this value when it starts */
@@ -230,8 +286,10 @@ gst_inter_audio_sink_stop (GstBaseSink * sink)
   g_mutex_lock (&interaudiosink->surface->mutex);
   gst_adapter_clear (interaudiosink->surface->audio_adapter);
   memset (&interaudiosink->surface->audio_info, 0, sizeof (GstAudioInfo));
+  g_atomic_int_inc (&interaudiosink->surface->audio_info_cookie);
   g_mutex_unlock (&interaudiosink->surface->mutex);
 
+  interaudiosink->ring = NULL;
   gst_inter_surface_unref (interaudiosink->surface);
   interaudiosink->surface = NULL;
 
@@ -256,6 +314,7 @@ gst_inter_audio_sink_set_caps (GstBaseSink * sink, GstCaps * caps)
   interaudiosink->info = info;
   /* TODO: Ideally we would drain the source here */
   gst_adapter_clear (interaudiosink->surface->audio_adapter);
+  g_atomic_int_inc (&interaudiosink->surface->audio_info_cookie);
   g_mutex_unlock (&interaudiosink->surface->mutex);
 
   return TRUE;
@@ -299,6 +358,22 @@ gst_inter_audio_sink_render (GstBaseSink * sink, GstBuffer * buffer)
       gst_buffer_get_size (buffer));
   bpf = interaudiosink->info.bpf;
 
+  if (interaudiosink->ring) {
+    GstAudioMeta *audio_meta = gst_buffer_get_audio_meta (buffer);
+
+    /* Readers collect the data themselves, share the memory with them */
+    if (audio_meta != NULL) {
+      tmp = gst_buffer_copy (buffer);
+      gst_buffer_remove_meta (tmp, GST_META_CAST (gst_buffer_get_audio_meta
+              (tmp)));
+    } else {
+      tmp = gst_buffer_ref (buffer);
+    }
+    gst_inter_surface_ring_push (interaudiosink->ring, tmp);
+
+    return GST_FLOW_OK;
+  }
+
   g_mutex_lock (&interaudiosink->surface->mutex);
 
   buffer_time = interaudiosink->surface->audio_buffer_time;
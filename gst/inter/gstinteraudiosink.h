@@ -39,7 +39,9 @@ struct _GstInterAudioSink
   GstBaseSink base_interaudiosink;
 
   GstInterSurface *surface;
+  GstInterSurfaceRing *ring;
   char *channel;
+  guint fan_out_depth;
 
   GstAdapter *input_adapter;
   GstAudioInfo info;
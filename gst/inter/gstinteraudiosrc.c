@@ -77,7 +77,9 @@ enum
   PROP_CHANNEL,
   PROP_BUFFER_TIME,
   PROP_LATENCY_TIME,
-  PROP_PERIOD_TIME
+  PROP_PERIOD_TIME,
+  PROP_OVERRUNS,
+  PROP_UNDERRUNS
 };
 
 #define DEFAULT_CHANNEL ("default")
@@ -150,6 +152,35 @@ gst_inter_audio_src_class_init (GstInterAudioSrcClass * klass)
           "The minimum amount of data to read in each iteration",
           1, G_MAXUINT64, DEFAULT_AUDIO_PERIOD_TIME,
           G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
+  /**
+   * GstInterAudioSrc:overruns:
+   *
+   * Number of times this element dropped data because it fell behind by
+   * more than #GstInterAudioSink:fan-out-depth buffers or more than
+   * #GstInterAudioSrc:buffer-time. Only counted when the channel is in
+   * fan-out mode.
+   *
+   * Since: 1.24
+   */
+  g_object_class_install_property (gobject_class, PROP_OVERRUNS,
+      g_param_spec_uint64 ("overruns", "Overruns",
+          "Number of times data was dropped because the reader fell behind",
+          0, G_MAXUINT64, 0, G_PARAM_READABLE | G_PARAM_STATIC_STRINGS));
+
+  /**
+   * GstInterAudioSrc:underruns:
+   *
+   * Number of periods that had to be completed with silence because not
+   * enough data was available. Only counted when the channel is in fan-out
+   * mode.
+   *
+   * Since: 1.24
+   */
+  g_object_class_install_property (gobject_class, PROP_UNDERRUNS,
+      g_param_spec_uint64 ("underruns", "Underruns",
+          "Number of periods completed with silence",
+          0, G_MAXUINT64, 0, G_PARAM_READABLE | G_PARAM_STATIC_STRINGS));
 }
 
 static void
@@ -163,6 +194,7 @@ gst_inter_audio_src_init (GstInterAudioSrc * interaudiosrc)
   interaudiosrc->buffer_time = DEFAULT_AUDIO_BUFFER_TIME;
   interaudiosrc->latency_time = DEFAULT_AUDIO_LATENCY_TIME;
   interaudiosrc->period_time = DEFAULT_AUDIO_PERIOD_TIME;
+  interaudiosrc->ring_adapter = gst_adapter_new ();
 }
 
 void
@@ -210,6 +242,16 @@ gst_inter_audio_src_get_property (GObject * object, guint property_id,
     case PROP_PERIOD_TIME:
       g_value_set_uint64 (value, interaudiosrc->period_time);
       break;
+    case PROP_OVERRUNS:
+      GST_OBJECT_LOCK (interaudiosrc);
+      g_value_set_uint64 (value, interaudiosrc->overruns);
+      GST_OBJECT_UNLOCK (interaudiosrc);
+      break;
+    case PROP_UNDERRUNS:
+      GST_OBJECT_LOCK (interaudiosrc);
+      g_value_set_uint64 (value, interaudiosrc->underruns);
+      GST_OBJECT_UNLOCK (interaudiosrc);
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, property_id, pspec);
       break;
@@ -223,6 +265,7 @@ gst_inter_audio_src_finalize (GObject * object)
 
   /* clean up object here */
   g_free (interaudiosrc->channel);
+  gst_object_unref (interaudiosrc->ring_adapter);
 
   G_OBJECT_CLASS (gst_inter_audio_src_parent_class)->finalize (object);
 }
@@ -284,8 +327,16 @@ gst_inter_audio_src_start (GstBaseSrc * src)
   interaudiosrc->surface = gst_inter_surface_get (interaudiosrc->channel);
   interaudiosrc->timestamp_offset = 0;
   interaudiosrc->n_samples = 0;
+  interaudiosrc->ring = NULL;
+
+  GST_OBJECT_LOCK (interaudiosrc);
+  interaudiosrc->overruns = 0;
+  interaudiosrc->underruns = 0;
+  GST_OBJECT_UNLOCK (interaudiosrc);
 
   g_mutex_lock (&interaudiosrc->surface->mutex);
+  interaudiosrc->surface_info = interaudiosrc->surface->audio_info;
+  interaudiosrc->info_cookie = interaudiosrc->surface->audio_info_cookie;
   interaudiosrc->surface->audio_buffer_time = interaudiosrc->buffer_time;
   interaudiosrc->surface->audio_latency_time = interaudiosrc->latency_time;
   interaudiosrc->surface->audio_period_time = interaudiosrc->period_time;
@@ -303,6 +354,8 @@ gst_inter_audio_src_stop (GstBaseSrc * src)
 
   gst_inter_surface_unref (interaudiosrc->surface);
   interaudiosrc->surface = NULL;
+  interaudiosrc->ring = NULL;
+  gst_adapter_clear (interaudiosrc->ring_adapter);
 
   return TRUE;
 }
@@ -332,6 +385,82 @@ gst_inter_audio_src_get_times (GstBaseSrc * src, GstBuffer * buffer,
   }
 }
 
+/* Returns the caps to negotiate if @surface_info differs from the
+ * negotiated audio info */
+static GstCaps *
+gst_inter_audio_src_check_surface_info (GstInterAudioSrc * interaudiosrc,
+    const GstAudioInfo * surface_info)
+{
+  GstCaps *caps = NULL;
+
+  if (surface_info->finfo) {
+    if (!gst_audio_info_is_equal (surface_info, &interaudiosrc->info)) {
+      caps = gst_audio_info_to_caps (surface_info);
+      interaudiosrc->timestamp_offset +=
+          gst_util_uint64_scale (interaudiosrc->n_samples, GST_SECOND,
+          interaudiosrc->info.rate);
+      interaudiosrc->n_samples = 0;
+    }
+  }
+
+  return caps;
+}
+
+/* Fan-out mode: collects everything the sink wrote since the last call
+ * with our own cursor, and takes up to one period from it */
+static GstBuffer *
+gst_inter_audio_src_read_ring (GstInterAudioSrc * interaudiosrc,
+    GstInterSurfaceRing * ring, guint64 period_samples, guint * n_samples)
+{
+  GstBuffer *buffer;
+  guint64 overruns = 0, buffer_samples;
+  guint bpf = interaudiosrc->surface_info.bpf;
+  guint n = 0;
+
+  if (interaudiosrc->ring != ring) {
+    interaudiosrc->ring = ring;
+    interaudiosrc->ring_cursor = gst_inter_surface_ring_get_write_seq (ring);
+    gst_adapter_clear (interaudiosrc->ring_adapter);
+  }
+
+  while ((buffer = gst_inter_surface_ring_pop (ring,
+              &interaudiosrc->ring_cursor, &overruns)))
+    gst_adapter_push (interaudiosrc->ring_adapter, buffer);
+
+  if (bpf > 0) {
+    buffer_samples = gst_util_uint64_scale (interaudiosrc->buffer_time,
+        interaudiosrc->info.rate, GST_SECOND);
+
+    /* Don't fall behind the sink by more than buffer-time */
+    n = gst_adapter_available (interaudiosrc->ring_adapter) / bpf;
+    if (n > buffer_samples) {
+      GST_DEBUG_OBJECT (interaudiosrc, "flushing %" G_GUINT64_FORMAT
+          " samples", n - buffer_samples);
+      gst_adapter_flush (interaudiosrc->ring_adapter,
+          (n - buffer_samples) * bpf);
+      n = buffer_samples;
+      overruns++;
+    }
+  } else {
+    gst_adapter_clear (interaudiosrc->ring_adapter);
+  }
+
+  GST_OBJECT_LOCK (interaudiosrc);
+  interaudiosrc->overruns += overruns;
+  if (n < period_samples)
+    interaudiosrc->underruns++;
+  GST_OBJECT_UNLOCK (interaudiosrc);
+
+  if (n > period_samples)
+    n = period_samples;
+  *n_samples = n;
+
+  if (n == 0)
+    return NULL;
+
+  return gst_adapter_take_buffer (interaudiosrc->ring_adapter, n * bpf);
+}
+
 static GstFlowReturn
 gst_inter_audio_src_create (GstBaseSrc * src, guint64 offset, guint size,
     GstBuffer ** buf)
@@ -339,6 +468,7 @@ gst_inter_audio_src_create (GstBaseSrc * src, guint64 offset, guint size,
   GstInterAudioSrc *interaudiosrc = GST_INTER_AUDIO_SRC (src);
   GstCaps *caps;
   GstBuffer *buffer;
+  GstInterSurfaceRing *ring;
   guint n, bpf;
   guint64 period_time;
   guint64 period_samples;
@@ -348,38 +478,57 @@ gst_inter_audio_src_create (GstBaseSrc * src, guint64 offset, guint size,
   buffer = NULL;
   caps = NULL;
 
-  g_mutex_lock (&interaudiosrc->surface->mutex);
-  if (interaudiosrc->surface->audio_info.finfo) {
-    if (!gst_audio_info_is_equal (&interaudiosrc->surface->audio_info,
-            &interaudiosrc->info)) {
-      caps = gst_audio_info_to_caps (&interaudiosrc->surface->audio_info);
-      interaudiosrc->timestamp_offset +=
-          gst_util_uint64_scale (interaudiosrc->n_samples, GST_SECOND,
-          interaudiosrc->info.rate);
-      interaudiosrc->n_samples = 0;
+  ring = g_atomic_pointer_get (&interaudiosrc->surface->audio_ring);
+  if (ring) {
+    gint cookie = g_atomic_int_get (&interaudiosrc->surface->audio_info_cookie);
+
+    /* Fan-out mode, we only need the lock to update our copy of the audio
+     * info when it changed. It's compared with the negotiated one on every
+     * period, which also catches a renegotiation on our side */
+    if (cookie != interaudiosrc->info_cookie) {
+      g_mutex_lock (&interaudiosrc->surface->mutex);
+      interaudiosrc->surface_info = interaudiosrc->surface->audio_info;
+      interaudiosrc->info_cookie = interaudiosrc->surface->audio_info_cookie;
+      g_mutex_unlock (&interaudiosrc->surface->mutex);
     }
-  }
-
-  bpf = interaudiosrc->surface->audio_info.bpf;
-  period_time = interaudiosrc->surface->audio_period_time;
-  period_samples =
-      gst_util_uint64_scale (period_time, interaudiosrc->info.rate, GST_SECOND);
+    caps = gst_inter_audio_src_check_surface_info (interaudiosrc,
+        &interaudiosrc->surface_info);
 
-  if (bpf > 0)
-    n = gst_adapter_available (interaudiosrc->surface->audio_adapter) / bpf;
-  else
-    n = 0;
+    period_samples = gst_util_uint64_scale (interaudiosrc->period_time,
+        interaudiosrc->info.rate, GST_SECOND);
 
-  if (n > period_samples)
-    n = period_samples;
-  if (n > 0) {
-    buffer = gst_adapter_take_buffer (interaudiosrc->surface->audio_adapter,
-        n * bpf);
+    buffer = gst_inter_audio_src_read_ring (interaudiosrc, ring,
+        period_samples, &n);
+    if (buffer == NULL) {
+      buffer = gst_buffer_new ();
+      GST_BUFFER_FLAG_SET (buffer, GST_BUFFER_FLAG_GAP);
+    }
   } else {
-    buffer = gst_buffer_new ();
-    GST_BUFFER_FLAG_SET (buffer, GST_BUFFER_FLAG_GAP);
+    g_mutex_lock (&interaudiosrc->surface->mutex);
+    caps = gst_inter_audio_src_check_surface_info (interaudiosrc,
+        &interaudiosrc->surface->audio_info);
+
+    bpf = interaudiosrc->surface->audio_info.bpf;
+    period_time = interaudiosrc->surface->audio_period_time;
+    period_samples = gst_util_uint64_scale (period_time,
+        interaudiosrc->info.rate, GST_SECOND);
+
+    if (bpf > 0)
+      n = gst_adapter_available (interaudiosrc->surface->audio_adapter) / bpf;
+    else
+      n = 0;
+
+    if (n > period_samples)
+      n = period_samples;
+    if (n > 0) {
+      buffer = gst_adapter_take_buffer (interaudiosrc->surface->audio_adapter,
+          n * bpf);
+    } else {
+      buffer = gst_buffer_new ();
+      GST_BUFFER_FLAG_SET (buffer, GST_BUFFER_FLAG_GAP);
+    }
+    g_mutex_unlock (&interaudiosrc->surface->mutex);
   }
-  g_mutex_unlock (&interaudiosrc->surface->mutex);
 
   if (caps) {
     gboolean ret = gst_base_src_set_caps (src, caps);
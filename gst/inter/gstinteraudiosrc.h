@@ -46,6 +46,16 @@ struct _GstInterAudioSrc
   GstClockTime timestamp_offset;
   GstAudioInfo info;
   guint64 buffer_time, latency_time, period_time;
+
+  /* fan-out mode */
+  GstInterSurfaceRing *ring;
+  guint ring_cursor;
+  GstAdapter *ring_adapter;
+  /* audio info of the surface as of info_cookie */
+  GstAudioInfo surface_info;
+  gint info_cookie;
+  guint64 overruns;
+  guint64 underruns;
 };
 
 struct _GstInterAudioSrcClass
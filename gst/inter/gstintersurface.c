@@ -28,6 +28,20 @@
 static GList *list;
 static GMutex mutex;
 
+static void
+gst_inter_surface_ring_free (GstInterSurfaceRing * ring)
+{
+  guint i;
+
+  if (!ring)
+    return;
+
+  for (i = 0; i < ring->depth; i++)
+    gst_buffer_replace (&ring->slots[i].buffer, NULL);
+  g_free (ring->slots);
+  g_free (ring);
+}
+
 GstInterSurface *
 gst_inter_surface_get (const char *name)
 {
@@ -78,6 +92,8 @@ gst_inter_surface_unref (GstInterSurface * surface)
     }
 
     g_mutex_clear (&surface->mutex);
+    gst_inter_surface_ring_free (surface->video_ring);
+    gst_inter_surface_ring_free (surface->audio_ring);
     gst_buffer_replace (&surface->video_buffer, NULL);
     gst_buffer_replace (&surface->sub_buffer, NULL);
     gst_object_unref (surface->audio_adapter);
@@ -86,3 +102,89 @@ gst_inter_surface_unref (GstInterSurface * surface)
   }
   g_mutex_unlock (&mutex);
 }
+
+/* Returns the ring stored in @ring, creating it with @depth slots if there
+ * is none yet. The ring stays valid until @surface is destroyed */
+GstInterSurfaceRing *
+gst_inter_surface_ensure_ring (GstInterSurface * surface,
+    GstInterSurfaceRing ** ring, guint depth)
+{
+  GstInterSurfaceRing *ret;
+
+  g_return_val_if_fail (depth > 0, NULL);
+
+  g_mutex_lock (&surface->mutex);
+  ret = *ring;
+  if (ret == NULL) {
+    ret = g_new0 (GstInterSurfaceRing, 1);
+    ret->depth = depth;
+    ret->slots = g_malloc0_n (depth, sizeof (*ret->slots));
+    g_atomic_pointer_set (ring, ret);
+  }
+  g_mutex_unlock (&surface->mutex);
+
+  return ret;
+}
+
+guint
+gst_inter_surface_ring_get_write_seq (GstInterSurfaceRing * ring)
+{
+  return (guint) g_atomic_int_get (&ring->write_seq);
+}
+
+/* Must only be called by a single writer, takes ownership of @buffer */
+void
+gst_inter_surface_ring_push (GstInterSurfaceRing * ring, GstBuffer * buffer)
+{
+  guint seq = gst_inter_surface_ring_get_write_seq (ring);
+  GstBuffer *old;
+
+  g_bit_lock (&ring->slots[seq % ring->depth].lock, 0);
+  old = ring->slots[seq % ring->depth].buffer;
+  ring->slots[seq % ring->depth].buffer = buffer;
+  ring->slots[seq % ring->depth].seq = seq;
+  g_bit_unlock (&ring->slots[seq % ring->depth].lock, 0);
+
+  g_atomic_int_set (&ring->write_seq, seq + 1);
+
+  if (old)
+    gst_buffer_unref (old);
+}
+
+/* Returns the buffer at @cursor and advances it, or %NULL if the reader
+ * has consumed everything. If the writer already overwrote the position
+ * at @cursor, the cursor skips ahead to the oldest available buffer and
+ * the number of lost buffers is added to @overruns */
+GstBuffer *
+gst_inter_surface_ring_pop (GstInterSurfaceRing * ring, guint * cursor,
+    guint64 * overruns)
+{
+  GstBuffer *buffer = NULL;
+
+  while (buffer == NULL) {
+    guint write_seq = gst_inter_surface_ring_get_write_seq (ring);
+    guint idx;
+
+    if (write_seq == *cursor)
+      return NULL;
+
+    if (write_seq - *cursor > ring->depth) {
+      *overruns += write_seq - *cursor - ring->depth;
+      *cursor = write_seq - ring->depth;
+    }
+
+    idx = *cursor % ring->depth;
+    g_bit_lock (&ring->slots[idx].lock, 0);
+    if (ring->slots[idx].seq == *cursor && ring->slots[idx].buffer)
+      buffer = gst_buffer_ref (ring->slots[idx].buffer);
+    g_bit_unlock (&ring->slots[idx].lock, 0);
+
+    if (buffer == NULL) {
+      /* Overwritten while we were looking, try again from the oldest */
+      *overruns += 1;
+    }
+    *cursor += 1;
+  }
+
+  return buffer;
+}
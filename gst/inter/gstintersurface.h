@@ -27,6 +27,24 @@
 G_BEGIN_DECLS
 
 typedef struct _GstInterSurface GstInterSurface;
+typedef struct _GstInterSurfaceRing GstInterSurfaceRing;
+
+/* Ring of the last buffers written by a sink, shared by any number of
+ * readers that each keep their own cursor into it. There's a single
+ * writer, and readers never block each other */
+struct _GstInterSurfaceRing
+{
+  guint depth;
+  /* sequence number of the next buffer to be written, atomic */
+  guint write_seq;
+  struct {
+    /* bit lock protecting the slot, only held while swapping or
+     * referencing the buffer */
+    gint lock;
+    guint seq;
+    GstBuffer *buffer;
+  } *slots;
+};
 
 struct _GstInterSurface
 {
@@ -48,6 +66,16 @@ struct _GstInterSurface
   GstBuffer *video_buffer;
   GstBuffer *sub_buffer;
   GstAdapter *audio_adapter;
+
+  /* fan-out mode, created by the sinks on demand and kept until the
+   * surface is destroyed. Accessed atomically */
+  GstInterSurfaceRing *video_ring;
+  GstInterSurfaceRing *audio_ring;
+
+  /* incremented whenever the video/audio info changes, so that readers
+   * only need to take the mutex when something changed */
+  gint video_info_cookie;
+  gint audio_info_cookie;
 };
 
 #define DEFAULT_AUDIO_BUFFER_TIME  (GST_SECOND)
@@ -58,6 +86,14 @@ struct _GstInterSurface
 GstInterSurface * gst_inter_surface_get (const char *name);
 void gst_inter_surface_unref (GstInterSurface *surface);
 
+GstInterSurfaceRing * gst_inter_surface_ensure_ring (GstInterSurface *surface,
+    GstInterSurfaceRing **ring, guint depth);
+guint gst_inter_surface_ring_get_write_seq (GstInterSurfaceRing *ring);
+void gst_inter_surface_ring_push (GstInterSurfaceRing *ring,
+    GstBuffer *buffer);
+GstBuffer * gst_inter_surface_ring_pop (GstInterSurfaceRing *ring,
+    guint *cursor, guint64 *overruns);
+
 
 G_END_DECLS
 
@@ -66,10 +66,12 @@ static GstFlowReturn gst_inter_video_sink_show_frame (GstVideoSink * sink,
 enum
 {
   PROP_0,
-  PROP_CHANNEL
+  PROP_CHANNEL,
+  PROP_FAN_OUT_DEPTH
 };
 
 #define DEFAULT_CHANNEL ("default")
+#define DEFAULT_FAN_OUT_DEPTH 0
 
 /* pad templates */
 static GstStaticPadTemplate gst_inter_video_sink_sink_template =
@@ -120,12 +122,40 @@ gst_inter_video_sink_class_init (GstInterVideoSinkClass * klass)
       g_param_spec_string ("channel", "Channel",
           "Channel name to match inter src and sink elements",
           DEFAULT_CHANNEL, G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
+  /**
+   * GstInterVideoSink:fan-out-depth:
+   *
+   * Number of frames kept on the channel for the intervideosrc elements
+   * reading from it. With a non-zero value, every reader consumes the
+   * frames independently at its own pace, without contending with the
+   * other readers. A reader that falls behind by more than this many
+   * frames skips ahead, which is counted in its #GstInterVideoSrc:overruns
+   * property.
+   *
+   * With 0, all readers share the last written frame. The first sink
+   * started on a channel with a non-zero value switches the channel to
+   * fan-out mode with that depth for as long as the channel exists. Sinks
+   * started later on that channel with a different value, including 0,
+   * still write to the same frames with the original depth and post a
+   * warning message.
+   *
+   * Since: 1.24
+   */
+  g_object_class_install_property (gobject_class, PROP_FAN_OUT_DEPTH,
+      g_param_spec_uint ("fan-out-depth", "Fan-out depth",
+          "Number of frames kept for independent readers "
+          "(0 = all readers share the last frame)", 0, G_MAXUINT16,
+          DEFAULT_FAN_OUT_DEPTH,
+          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS |
+          GST_PARAM_MUTABLE_READY));
 }
 
 static void
 gst_inter_video_sink_init (GstInterVideoSink * intervideosink)
 {
   intervideosink->channel = g_strdup (DEFAULT_CHANNEL);
+  intervideosink->fan_out_depth = DEFAULT_FAN_OUT_DEPTH;
 }
 
 void
@@ -139,6 +169,9 @@ gst_inter_video_sink_set_property (GObject * object, guint property_id,
       g_free (intervideosink->channel);
       intervideosink->channel = g_value_dup_string (value);
       break;
+    case PROP_FAN_OUT_DEPTH:
+      intervideosink->fan_out_depth = g_value_get_uint (value);
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, property_id, pspec);
       break;
@@ -155,6 +188,9 @@ gst_inter_video_sink_get_property (GObject * object, guint property_id,
     case PROP_CHANNEL:
       g_value_set_string (value, intervideosink->channel);
       break;
+    case PROP_FAN_OUT_DEPTH:
+      g_value_set_uint (value, intervideosink->fan_out_depth);
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, property_id, pspec);
       break;
@@ -199,8 +235,28 @@ gst_inter_video_sink_start (GstBaseSink * sink)
   GstInterVideoSink *intervideosink = GST_INTER_VIDEO_SINK (sink);
 
   intervideosink->surface = gst_inter_surface_get (intervideosink->channel);
+
+  if (intervideosink->fan_out_depth > 0)
+    intervideosink->ring =
+        gst_inter_surface_ensure_ring (intervideosink->surface,
+        &intervideosink->surface->video_ring, intervideosink->fan_out_depth);
+  else
+    intervideosink->ring =
+        g_atomic_pointer_get (&intervideosink->surface->video_ring);
+
+  /* The depth is fixed by the first sink that switched the channel to
+   * fan-out mode, we keep writing to its ring */
+  if (intervideosink->ring
+      && intervideosink->ring->depth != intervideosink->fan_out_depth) {
+    GST_ELEMENT_WARNING (intervideosink, RESOURCE, SETTINGS, (NULL),
+        ("Channel '%s' is in fan-out mode with a depth of %u frames, "
+            "ignoring fan-out-depth %u", intervideosink->channel,
+            intervideosink->ring->depth, intervideosink->fan_out_depth));
+  }
+
   g_mutex_lock (&intervideosink->surface->mutex);
   memset (&intervideosink->surface->video_info, 0, sizeof (GstVideoInfo));
+  g_atomic_int_inc (&intervideosink->surface->video_info_cookie);
   g_mutex_unlock (&intervideosink->surface->mutex);
 
   return TRUE;
@@ -217,8 +273,10 @@ gst_inter_video_sink_stop (GstBaseSink * sink)
   }
   intervideosink->surface->video_buffer = NULL;
   memset (&intervideosink->surface->video_info, 0, sizeof (GstVideoInfo));
+  g_atomic_int_inc (&intervideosink->surface->video_info_cookie);
   g_mutex_unlock (&intervideosink->surface->mutex);
 
+  intervideosink->ring = NULL;
   gst_inter_surface_unref (intervideosink->surface);
   intervideosink->surface = NULL;
 
@@ -239,6 +297,7 @@ gst_inter_video_sink_set_caps (GstBaseSink * sink, GstCaps * caps)
   g_mutex_lock (&intervideosink->surface->mutex);
   intervideosink->surface->video_info = info;
   intervideosink->info = info;
+  g_atomic_int_inc (&intervideosink->surface->video_info_cookie);
   g_mutex_unlock (&intervideosink->surface->mutex);
 
   return TRUE;
@@ -252,6 +311,11 @@ gst_inter_video_sink_show_frame (GstVideoSink * sink, GstBuffer * buffer)
   GST_DEBUG_OBJECT (intervideosink, "render ts %" GST_TIME_FORMAT,
       GST_TIME_ARGS (GST_BUFFER_PTS (buffer)));
 
+  if (intervideosink->ring) {
+    gst_inter_surface_ring_push (intervideosink->ring, gst_buffer_ref (buffer));
+    return GST_FLOW_OK;
+  }
+
   g_mutex_lock (&intervideosink->surface->mutex);
   if (intervideosink->surface->video_buffer) {
     gst_buffer_unref (intervideosink->surface->video_buffer);
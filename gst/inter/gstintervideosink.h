@@ -39,7 +39,9 @@ struct _GstInterVideoSink
   GstVideoSink videosink;
 
   GstInterSurface *surface;
+  GstInterSurfaceRing *ring;
   char *channel;
+  guint fan_out_depth;
 
   GstVideoInfo info;
 };
@@ -71,7 +71,9 @@ enum
 {
   PROP_0,
   PROP_CHANNEL,
-  PROP_TIMEOUT
+  PROP_TIMEOUT,
+  PROP_OVERRUNS,
+  PROP_UNDERRUNS
 };
 
 #define DEFAULT_CHANNEL ("default")
@@ -132,6 +134,34 @@ gst_inter_video_src_class_init (GstInterVideoSrcClass * klass)
           "Timeout after which to start outputting black frames",
           0, G_MAXUINT64, DEFAULT_TIMEOUT,
           G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
+  /**
+   * GstInterVideoSrc:overruns:
+   *
+   * Number of frames this element missed because it fell behind by more
+   * than #GstInterVideoSink:fan-out-depth frames. Only counted when the
+   * channel is in fan-out mode.
+   *
+   * Since: 1.24
+   */
+  g_object_class_install_property (gobject_class, PROP_OVERRUNS,
+      g_param_spec_uint64 ("overruns", "Overruns",
+          "Number of frames skipped because the reader fell behind",
+          0, G_MAXUINT64, 0, G_PARAM_READABLE | G_PARAM_STATIC_STRINGS));
+
+  /**
+   * GstInterVideoSrc:underruns:
+   *
+   * Number of times this element had to repeat a frame or output a black
+   * frame because no new frame was available. Only counted when the
+   * channel is in fan-out mode.
+   *
+   * Since: 1.24
+   */
+  g_object_class_install_property (gobject_class, PROP_UNDERRUNS,
+      g_param_spec_uint64 ("underruns", "Underruns",
+          "Number of times no new frame was available",
+          0, G_MAXUINT64, 0, G_PARAM_READABLE | G_PARAM_STATIC_STRINGS));
 }
 
 static void
@@ -177,6 +207,16 @@ gst_inter_video_src_get_property (GObject * object, guint property_id,
     case PROP_TIMEOUT:
       g_value_set_uint64 (value, intervideosrc->timeout);
       break;
+    case PROP_OVERRUNS:
+      GST_OBJECT_LOCK (intervideosrc);
+      g_value_set_uint64 (value, intervideosrc->overruns);
+      GST_OBJECT_UNLOCK (intervideosrc);
+      break;
+    case PROP_UNDERRUNS:
+      GST_OBJECT_LOCK (intervideosrc);
+      g_value_set_uint64 (value, intervideosrc->underruns);
+      GST_OBJECT_UNLOCK (intervideosrc);
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, property_id, pspec);
       break;
@@ -278,6 +318,18 @@ gst_inter_video_src_start (GstBaseSrc * src)
   intervideosrc->surface = gst_inter_surface_get (intervideosrc->channel);
   intervideosrc->timestamp_offset = 0;
   intervideosrc->n_frames = 0;
+  intervideosrc->ring = NULL;
+  intervideosrc->ring_buffer_count = 0;
+
+  g_mutex_lock (&intervideosrc->surface->mutex);
+  intervideosrc->surface_info = intervideosrc->surface->video_info;
+  intervideosrc->info_cookie = intervideosrc->surface->video_info_cookie;
+  g_mutex_unlock (&intervideosrc->surface->mutex);
+
+  GST_OBJECT_LOCK (intervideosrc);
+  intervideosrc->overruns = 0;
+  intervideosrc->underruns = 0;
+  GST_OBJECT_UNLOCK (intervideosrc);
 
   return TRUE;
 }
@@ -291,6 +343,8 @@ gst_inter_video_src_stop (GstBaseSrc * src)
 
   gst_inter_surface_unref (intervideosrc->surface);
   intervideosrc->surface = NULL;
+  intervideosrc->ring = NULL;
+  gst_buffer_replace (&intervideosrc->ring_buffer, NULL);
   gst_buffer_replace (&intervideosrc->black_frame, NULL);
 
   return TRUE;
@@ -321,28 +375,16 @@ gst_inter_video_src_get_times (GstBaseSrc * src, GstBuffer * buffer,
   }
 }
 
-static GstFlowReturn
-gst_inter_video_src_create (GstBaseSrc * src, guint64 offset, guint size,
-    GstBuffer ** buf)
+/* Returns the caps to negotiate if @surface_info differs from the
+ * negotiated video info */
+static GstCaps *
+gst_inter_video_src_check_surface_info (GstInterVideoSrc * intervideosrc,
+    const GstVideoInfo * surface_info)
 {
-  GstInterVideoSrc *intervideosrc = GST_INTER_VIDEO_SRC (src);
-  GstCaps *caps;
-  GstBuffer *buffer;
-  guint64 frames;
-  gboolean is_gap = FALSE;
+  GstCaps *caps = NULL;
 
-  GST_DEBUG_OBJECT (intervideosrc, "create");
-
-  caps = NULL;
-  buffer = NULL;
-
-  frames = gst_util_uint64_scale_ceil (intervideosrc->timeout,
-      GST_VIDEO_INFO_FPS_N (&intervideosrc->info),
-      GST_VIDEO_INFO_FPS_D (&intervideosrc->info) * GST_SECOND);
-
-  g_mutex_lock (&intervideosrc->surface->mutex);
-  if (intervideosrc->surface->video_info.finfo) {
-    GstVideoInfo tmp_info = intervideosrc->surface->video_info;
+  if (surface_info->finfo) {
+    GstVideoInfo tmp_info = *surface_info;
 
     /* We negotiate the framerate ourselves */
     tmp_info.fps_n = intervideosrc->info.fps_n;
@@ -362,25 +404,127 @@ gst_inter_video_src_create (GstBaseSrc * src, guint64 offset, guint size,
     }
   }
 
-  if (intervideosrc->surface->video_buffer) {
-    /* We have a buffer to push */
-    buffer = gst_buffer_ref (intervideosrc->surface->video_buffer);
+  return caps;
+}
+
+/* Fan-out mode: takes the next frame from the ring with our own cursor,
+ * and otherwise repeats the last one like the shared mode does */
+static GstBuffer *
+gst_inter_video_src_read_ring (GstInterVideoSrc * intervideosrc,
+    GstInterSurfaceRing * ring, guint64 frames, gboolean * is_gap)
+{
+  GstBuffer *buffer = NULL, *next;
+  guint64 overruns = 0;
+
+  if (intervideosrc->ring != ring) {
+    guint write_seq = gst_inter_surface_ring_get_write_seq (ring);
+
+    /* Start with the most recent frame */
+    intervideosrc->ring = ring;
+    intervideosrc->ring_cursor = write_seq > 0 ? write_seq - 1 : 0;
+  }
+
+  next = gst_inter_surface_ring_pop (ring, &intervideosrc->ring_cursor,
+      &overruns);
+
+  GST_OBJECT_LOCK (intervideosrc);
+  intervideosrc->overruns += overruns;
+  if (!next)
+    intervideosrc->underruns++;
+  GST_OBJECT_UNLOCK (intervideosrc);
+
+  if (overruns)
+    GST_DEBUG_OBJECT (intervideosrc, "skipped %" G_GUINT64_FORMAT " frames",
+        overruns);
+
+  if (next) {
+    gst_buffer_replace (&intervideosrc->ring_buffer, NULL);
+    intervideosrc->ring_buffer = next;
+    intervideosrc->ring_buffer_count = 0;
+  }
+
+  if (intervideosrc->ring_buffer) {
+    buffer = gst_buffer_ref (intervideosrc->ring_buffer);
 
     /* Can only be true if timeout > 0 */
-    if (intervideosrc->surface->video_buffer_count == frames) {
-      gst_buffer_unref (intervideosrc->surface->video_buffer);
-      intervideosrc->surface->video_buffer = NULL;
-    }
+    if (intervideosrc->ring_buffer_count == frames)
+      gst_buffer_replace (&intervideosrc->ring_buffer, NULL);
   }
 
-  if (intervideosrc->surface->video_buffer_count != 0 &&
-      intervideosrc->surface->video_buffer_count != (frames + 1)) {
+  if (intervideosrc->ring_buffer_count != 0 &&
+      intervideosrc->ring_buffer_count != (frames + 1)) {
     /* This is a repeat of the stored buffer or of a black frame */
-    is_gap = TRUE;
+    *is_gap = TRUE;
   }
 
-  intervideosrc->surface->video_buffer_count++;
-  g_mutex_unlock (&intervideosrc->surface->mutex);
+  intervideosrc->ring_buffer_count++;
+
+  return buffer;
+}
+
+static GstFlowReturn
+gst_inter_video_src_create (GstBaseSrc * src, guint64 offset, guint size,
+    GstBuffer ** buf)
+{
+  GstInterVideoSrc *intervideosrc = GST_INTER_VIDEO_SRC (src);
+  GstCaps *caps;
+  GstBuffer *buffer;
+  GstInterSurfaceRing *ring;
+  guint64 frames;
+  gboolean is_gap = FALSE;
+
+  GST_DEBUG_OBJECT (intervideosrc, "create");
+
+  caps = NULL;
+  buffer = NULL;
+
+  frames = gst_util_uint64_scale_ceil (intervideosrc->timeout,
+      GST_VIDEO_INFO_FPS_N (&intervideosrc->info),
+      GST_VIDEO_INFO_FPS_D (&intervideosrc->info) * GST_SECOND);
+
+  ring = g_atomic_pointer_get (&intervideosrc->surface->video_ring);
+  if (ring) {
+    gint cookie = g_atomic_int_get (&intervideosrc->surface->video_info_cookie);
+
+    /* Fan-out mode, we only need the lock to update our copy of the video
+     * info when it changed. It's compared with the negotiated one on every
+     * frame, which also catches a renegotiation on our side */
+    if (cookie != intervideosrc->info_cookie) {
+      g_mutex_lock (&intervideosrc->surface->mutex);
+      intervideosrc->surface_info = intervideosrc->surface->video_info;
+      intervideosrc->info_cookie = intervideosrc->surface->video_info_cookie;
+      g_mutex_unlock (&intervideosrc->surface->mutex);
+    }
+    caps = gst_inter_video_src_check_surface_info (intervideosrc,
+        &intervideosrc->surface_info);
+
+    buffer = gst_inter_video_src_read_ring (intervideosrc, ring, frames,
+        &is_gap);
+  } else {
+    g_mutex_lock (&intervideosrc->surface->mutex);
+    caps = gst_inter_video_src_check_surface_info (intervideosrc,
+        &intervideosrc->surface->video_info);
+
+    if (intervideosrc->surface->video_buffer) {
+      /* We have a buffer to push */
+      buffer = gst_buffer_ref (intervideosrc->surface->video_buffer);
+
+      /* Can only be true if timeout > 0 */
+      if (intervideosrc->surface->video_buffer_count == frames) {
+        gst_buffer_unref (intervideosrc->surface->video_buffer);
+        intervideosrc->surface->video_buffer = NULL;
+      }
+    }
+
+    if (intervideosrc->surface->video_buffer_count != 0 &&
+        intervideosrc->surface->video_buffer_count != (frames + 1)) {
+      /* This is a repeat of the stored buffer or of a black frame */
+      is_gap = TRUE;
+    }
+
+    intervideosrc->surface->video_buffer_count++;
+    g_mutex_unlock (&intervideosrc->surface->mutex);
+  }
 
   if (caps) {
     gboolean ret;
@@ -48,6 +48,17 @@ struct _GstInterVideoSrc
   GstBuffer *black_frame;
   int n_frames;
   GstClockTime timestamp_offset;
+
+  /* fan-out mode */
+  GstInterSurfaceRing *ring;
+  guint ring_cursor;
+  GstBuffer *ring_buffer;
+  guint64 ring_buffer_count;
+  /* video info of the surface as of info_cookie */
+  GstVideoInfo surface_info;
+  gint info_cookie;
+  guint64 overruns;
+  guint64 underruns;
 };
 
 struct _GstInterVideoSrcClass
@@ -1496,6 +1496,48 @@ mpegts_base_sink_query (GstPad * pad, GstObject * parent, GstQuery * query)
   return GST_MPEGTS_BASE_GET_CLASS (base)->sink_query (base, query);
 }
 
+static GstFlowReturn
+mpegts_base_process_packet (MpegTSBase * base, MpegTSPacketizerPacket * packet)
+{
+  GstFlowReturn res = GST_FLOW_OK;
+  MpegTSBaseClass *klass = GST_MPEGTS_BASE_GET_CLASS (base);
+
+  if (klass->inspect_packet)
+    klass->inspect_packet (base, packet);
+
+  /* If it's a known PES, push it */
+  if (MPEGTS_BIT_IS_SET (base->is_pes, packet->pid)) {
+    /* push the packet downstream */
+    if (base->push_data)
+      res = klass->push (base, packet, NULL);
+  } else if (packet->payload
+      && MPEGTS_BIT_IS_SET (base->known_psi, packet->pid)) {
+    /* base PSI data */
+    GList *others, *tmp;
+    GstMpegtsSection *section;
+
+    section = mpegts_packetizer_push_section (base->packetizer, packet,
+        &others);
+    if (section)
+      mpegts_base_handle_psi (base, section);
+    if (G_UNLIKELY (others)) {
+      for (tmp = others; tmp; tmp = tmp->next)
+        mpegts_base_handle_psi (base, (GstMpegtsSection *) tmp->data);
+      g_list_free (others);
+    }
+
+    /* we need to push section packet downstream */
+    if (base->push_section)
+      res = klass->push (base, packet, section);
+
+  } else if (base->push_unknown) {
+    res = klass->push (base, packet, NULL);
+  } else if (packet->payload && packet->pid != 0x1fff)
+    GST_LOG ("PID 0x%04x Saw packet on a pid we don't handle", packet->pid);
+
+  return res;
+}
+
 static GstFlowReturn
 mpegts_base_chain (GstPad * pad, GstObject * parent, GstBuffer * buf)
 {
@@ -1503,7 +1545,8 @@ mpegts_base_chain (GstPad * pad, GstObject * parent, GstBuffer * buf)
   MpegTSBase *base;
   MpegTSPacketizerPacketReturn pret;
   MpegTSPacketizer2 *packetizer;
-  MpegTSPacketizerPacket packet;
+  MpegTSPacketizerPacket packets[MPEGTS_PACKET_BATCH_SIZE];
+  guint i, n_packets;
   MpegTSBaseClass *klass;
 
   base = GST_MPEGTS_BASE (parent);
@@ -1536,7 +1579,8 @@ mpegts_base_chain (GstPad * pad, GstObject * parent, GstBuffer * buf)
   mpegts_packetizer_push (base->packetizer, buf);
 
   while (res == GST_FLOW_OK) {
-    pret = mpegts_packetizer_next_packet (base->packetizer, &packet);
+    pret = mpegts_packetizer_next_packets (base->packetizer, packets,
+        G_N_ELEMENTS (packets), &n_packets);
 
     /* If we don't have enough data, return */
     if (G_UNLIKELY (pret == PACKET_NEED_MORE))
@@ -1545,43 +1589,20 @@ mpegts_base_chain (GstPad * pad, GstObject * parent, GstBuffer * buf)
     if (G_UNLIKELY (pret == PACKET_BAD)) {
       /* bad header, skip the packet */
       GST_DEBUG_OBJECT (base, "bad packet, skipping");
-      goto next;
+      mpegts_packetizer_clear_packets (base->packetizer, 1);
+      continue;
     }
 
-    if (klass->inspect_packet)
-      klass->inspect_packet (base, &packet);
-
-    /* If it's a known PES, push it */
-    if (MPEGTS_BIT_IS_SET (base->is_pes, packet.pid)) {
-      /* push the packet downstream */
-      if (base->push_data)
-        res = klass->push (base, &packet, NULL);
-    } else if (packet.payload
-        && MPEGTS_BIT_IS_SET (base->known_psi, packet.pid)) {
-      /* base PSI data */
-      GList *others, *tmp;
-      GstMpegtsSection *section;
-
-      section = mpegts_packetizer_push_section (packetizer, &packet, &others);
-      if (section)
-        mpegts_base_handle_psi (base, section);
-      if (G_UNLIKELY (others)) {
-        for (tmp = others; tmp; tmp = tmp->next)
-          mpegts_base_handle_psi (base, (GstMpegtsSection *) tmp->data);
-        g_list_free (others);
-      }
-
-      /* we need to push section packet downstream */
-      if (base->push_section)
-        res = klass->push (base, &packet, section);
+    for (i = 0; i < n_packets && res == GST_FLOW_OK; i++) {
+      res = mpegts_base_process_packet (base, &packets[i]);
 
-    } else if (base->push_unknown) {
-      res = klass->push (base, &packet, NULL);
-    } else if (packet.payload && packet.pid != 0x1fff)
-      GST_LOG ("PID 0x%04x Saw packet on a pid we don't handle", packet.pid);
+      /* Processing the packet might have flushed the packetizer, in which
+       * case the rest of the batch is gone */
+      if (G_UNLIKELY (packetizer->map_data == NULL))
+        break;
+    }
 
-  next:
-    mpegts_packetizer_clear_packet (base->packetizer, &packet);
+    mpegts_packetizer_clear_packets (base->packetizer, i);
   }
 
   if (res == GST_FLOW_OK && klass->input_done)
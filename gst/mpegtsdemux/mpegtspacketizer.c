@@ -137,21 +137,18 @@ mpegts_packetizer_get_current_time (MpegTSPacketizer2 * packetizer,
       pcr_pid);
 }
 
+#define SUBTABLE_KEY(table_id, subtable_extension) \
+  GUINT_TO_POINTER (((guint) (table_id) << 16) | (subtable_extension))
+
 static inline MpegTSPacketizerStreamSubtable *
-find_subtable (GSList * subtables, guint8 table_id, guint16 subtable_extension)
+find_subtable (GHashTable * subtables, guint8 table_id,
+    guint16 subtable_extension)
 {
-  GSList *tmp;
-
-  /* FIXME: Make this an array ! */
-  for (tmp = subtables; tmp; tmp = tmp->next) {
-    MpegTSPacketizerStreamSubtable *sub =
-        (MpegTSPacketizerStreamSubtable *) tmp->data;
-    if (sub->table_id == table_id
-        && sub->subtable_extension == subtable_extension)
-      return sub;
-  }
+  if (subtables == NULL)
+    return NULL;
 
-  return NULL;
+  return g_hash_table_lookup (subtables,
+      SUBTABLE_KEY (table_id, subtable_extension));
 }
 
 static gboolean
@@ -202,7 +199,6 @@ mpegts_packetizer_stream_new (guint16 pid)
 
   stream = (MpegTSPacketizerStream *) g_new0 (MpegTSPacketizerStream, 1);
   stream->continuity_counter = CONTINUITY_UNSET;
-  stream->subtables = NULL;
   stream->table_id = TABLE_ID_UNSET;
   stream->pid = pid;
   return stream;
@@ -230,9 +226,8 @@ static void
 mpegts_packetizer_stream_free (MpegTSPacketizerStream * stream)
 {
   mpegts_packetizer_clear_section (stream);
-  g_slist_foreach (stream->subtables,
-      (GFunc) mpegts_packetizer_stream_subtable_free, NULL);
-  g_slist_free (stream->subtables);
+  if (stream->subtables)
+    g_hash_table_unref (stream->subtables);
   g_free (stream);
 }
 
@@ -263,6 +258,7 @@ mpegts_packetizer_init (MpegTSPacketizer2 * packetizer)
   packetizer->map_data = NULL;
   packetizer->map_size = 0;
   packetizer->map_offset = 0;
+  packetizer->map_buffer = NULL;
   packetizer->need_sync = FALSE;
 
   memset (packetizer->pcrtablelut, 0xff, 0x2000);
@@ -295,6 +291,7 @@ mpegts_packetizer_dispose (GObject * object)
       g_free (packetizer->streams);
     }
 
+    gst_buffer_replace (&packetizer->map_buffer, NULL);
     gst_adapter_clear (packetizer->adapter);
     g_object_unref (packetizer->adapter);
     g_mutex_clear (&packetizer->group_lock);
@@ -533,7 +530,15 @@ mpegts_packetizer_parse_section_header (MpegTSPacketizer2 * packetizer,
         stream->subtable_extension, stream->last_section_number);
     subtable->version_number = stream->version_number;
 
-    stream->subtables = g_slist_prepend (stream->subtables, subtable);
+    /* Some PIDs (EIT) can carry thousands of subtables, we don't want to
+     * walk through them for each section */
+    if (stream->subtables == NULL)
+      stream->subtables = g_hash_table_new_full (g_direct_hash,
+          g_direct_equal, NULL,
+          (GDestroyNotify) mpegts_packetizer_stream_subtable_free);
+    g_hash_table_insert (stream->subtables,
+        SUBTABLE_KEY (subtable->table_id, subtable->subtable_extension),
+        subtable);
   }
 
   GST_MEMDUMP ("Full section data", stream->section_data,
@@ -595,6 +600,7 @@ mpegts_packetizer_clear (MpegTSPacketizer2 * packetizer)
   packetizer->map_data = NULL;
   packetizer->map_size = 0;
   packetizer->map_offset = 0;
+  gst_buffer_replace (&packetizer->map_buffer, NULL);
   packetizer->last_in_time = GST_CLOCK_TIME_NONE;
   packetizer->last_pts = GST_CLOCK_TIME_NONE;
   packetizer->last_dts = GST_CLOCK_TIME_NONE;
@@ -637,6 +643,7 @@ mpegts_packetizer_flush (MpegTSPacketizer2 * packetizer, gboolean hard)
   packetizer->map_data = NULL;
   packetizer->map_size = 0;
   packetizer->map_offset = 0;
+  gst_buffer_replace (&packetizer->map_buffer, NULL);
   packetizer->last_in_time = GST_CLOCK_TIME_NONE;
   packetizer->last_pts = GST_CLOCK_TIME_NONE;
   packetizer->last_dts = GST_CLOCK_TIME_NONE;
@@ -716,12 +723,22 @@ mpegts_packetizer_flush_bytes (MpegTSPacketizer2 * packetizer, gsize size)
   packetizer->map_data = NULL;
   packetizer->map_size = 0;
   packetizer->map_offset = 0;
+  gst_buffer_replace (&packetizer->map_buffer, NULL);
 }
 
+/* Makes sure at least size bytes are mapped.
+ *
+ * If contiguous is TRUE, only the data that can be mapped without copying is
+ * mapped (as long as that is at least size bytes). This avoids having the
+ * adapter merge the whole pending input into a new allocation each time an
+ * input buffer ends in the middle of a packet, only the packet straddling the
+ * buffer boundary is then copied. Callers that need to look at everything
+ * that is available (sync search) must pass FALSE. */
 static gboolean
-mpegts_packetizer_map (MpegTSPacketizer2 * packetizer, gsize size)
+mpegts_packetizer_map (MpegTSPacketizer2 * packetizer, gsize size,
+    gboolean contiguous)
 {
-  gsize available;
+  gsize available, available_fast;
 
   if (packetizer->map_size - packetizer->map_offset >= size)
     return TRUE;
@@ -732,6 +749,11 @@ mpegts_packetizer_map (MpegTSPacketizer2 * packetizer, gsize size)
   if (available < size)
     return FALSE;
 
+  if (contiguous) {
+    available_fast = gst_adapter_available_fast (packetizer->adapter);
+    available = available_fast >= size ? available_fast : size;
+  }
+
   packetizer->map_data =
       (guint8 *) gst_adapter_map (packetizer->adapter, available);
   if (!packetizer->map_data)
@@ -740,16 +762,81 @@ mpegts_packetizer_map (MpegTSPacketizer2 * packetizer, gsize size)
   packetizer->map_size = available;
   packetizer->map_offset = 0;
 
+  /* Keep the input memory around so that payloads can be shared with
+   * mpegts_packetizer_share_data() instead of being copied */
+  if (contiguous && available_fast >= size) {
+    GstBuffer *buffer;
+    GstMapInfo info;
+
+    buffer = gst_adapter_get_buffer_fast (packetizer->adapter, available);
+    if (buffer && gst_buffer_n_memory (buffer) == 1 &&
+        !GST_MEMORY_FLAG_IS_SET (gst_buffer_peek_memory (buffer, 0),
+            GST_MEMORY_FLAG_NO_SHARE) &&
+        gst_memory_map (gst_buffer_peek_memory (buffer, 0), &info,
+            GST_MAP_READ)) {
+      /* The adapter mapped that same memory, unless it had data assembled
+       * from a previous map */
+      if (info.data == packetizer->map_data && info.size == available)
+        packetizer->map_buffer = gst_buffer_ref (buffer);
+      gst_memory_unmap (gst_buffer_peek_memory (buffer, 0), &info);
+    }
+    if (buffer)
+      gst_buffer_unref (buffer);
+  }
+
   GST_LOG ("mapped %" G_GSIZE_FORMAT " bytes from adapter", available);
 
   return TRUE;
 }
 
+/* Returns a memory holding the size bytes at data, which must be located
+ * in the packets currently being processed (or anywhere else, for instance
+ * a reassembled PES header, in which case they are copied). When the data
+ * was mapped from an input buffer without copying, the returned memory
+ * shares it instead of copying it. */
+GstMemory *
+mpegts_packetizer_share_data (MpegTSPacketizer2 * packetizer,
+    const guint8 * data, gsize size)
+{
+  GstMemory *mem = NULL;
+  guint8 *copy;
+
+  if (packetizer->map_buffer && data >= packetizer->map_data &&
+      data + size <= packetizer->map_data + packetizer->map_size) {
+    mem = gst_memory_share (gst_buffer_peek_memory (packetizer->map_buffer,
+            0), data - packetizer->map_data, size);
+  }
+
+  if (mem == NULL) {
+    copy = g_memdup2 (data, size);
+    mem = gst_memory_new_wrapped (0, copy, size, 0, size, copy, g_free);
+  }
+
+  return mem;
+}
+
+/* Returns the position of the first sync byte in data[start..end[, or end if
+ * there is none. memchr() is vectorized in all the C libraries we care about,
+ * which makes this considerably faster than testing every byte when the
+ * stream is garbled or we are looking for the initial sync */
+static inline gsize
+mpegts_find_sync_byte (const guint8 * data, gsize start, gsize end)
+{
+  const guint8 *sync;
+
+  if (start >= end)
+    return end;
+
+  sync = memchr (data + start, PACKET_SYNC_BYTE, end - start);
+
+  return sync ? sync - data : end;
+}
+
 static gboolean
 mpegts_try_discover_packet_size (MpegTSPacketizer2 * packetizer)
 {
   guint8 *data;
-  gsize size, i, j;
+  gsize size, limit, i, j;
 
   static const guint psizes[] = {
     MPEGTS_NORMAL_PACKETSIZE,
@@ -758,16 +845,19 @@ mpegts_try_discover_packet_size (MpegTSPacketizer2 * packetizer)
     MPEGTS_ATSC_PACKETSIZE
   };
 
-  if (!mpegts_packetizer_map (packetizer, 4 * MPEGTS_MAX_PACKETSIZE))
+  if (!mpegts_packetizer_map (packetizer, 4 * MPEGTS_MAX_PACKETSIZE, FALSE))
     return FALSE;
 
   size = packetizer->map_size - packetizer->map_offset;
   data = packetizer->map_data + packetizer->map_offset;
 
-  for (i = 0; i + 3 * MPEGTS_MAX_PACKETSIZE < size; i++) {
+  limit = size - 3 * MPEGTS_MAX_PACKETSIZE;
+
+  for (i = 0; i < limit; i++) {
     /* find a sync byte */
-    if (data[i] != PACKET_SYNC_BYTE)
-      continue;
+    i = mpegts_find_sync_byte (data, i, limit);
+    if (i == limit)
+      break;
 
     /* check for 4 consecutive sync bytes with each possible packet size */
     for (j = 0; j < G_N_ELEMENTS (psizes); j++) {
@@ -807,11 +897,11 @@ mpegts_packetizer_sync (MpegTSPacketizer2 * packetizer)
   gboolean found = FALSE;
   guint8 *data;
   guint packet_size;
-  gsize size, sync_offset, i;
+  gsize size, sync_offset, limit, i;
 
   packet_size = packetizer->packet_size;
 
-  if (!mpegts_packetizer_map (packetizer, 3 * packet_size))
+  if (!mpegts_packetizer_map (packetizer, 3 * packet_size, FALSE))
     return FALSE;
 
   size = packetizer->map_size - packetizer->map_offset;
@@ -822,9 +912,14 @@ mpegts_packetizer_sync (MpegTSPacketizer2 * packetizer)
   else
     sync_offset = 0;
 
-  for (i = sync_offset; i + 2 * packet_size < size; i++) {
-    if (data[i] == PACKET_SYNC_BYTE &&
-        data[i + packet_size] == PACKET_SYNC_BYTE &&
+  limit = size - 2 * packet_size;
+
+  for (i = sync_offset; i < limit; i++) {
+    i = mpegts_find_sync_byte (data, i, limit);
+    if (i == limit)
+      break;
+
+    if (data[i + packet_size] == PACKET_SYNC_BYTE &&
         data[i + 2 * packet_size] == PACKET_SYNC_BYTE) {
       found = TRUE;
       break;
@@ -867,7 +962,7 @@ mpegts_packetizer_next_packet (MpegTSPacketizer2 * packetizer,
       packetizer->need_sync = FALSE;
     }
 
-    if (!mpegts_packetizer_map (packetizer, packet_size))
+    if (!mpegts_packetizer_map (packetizer, packet_size, TRUE))
       return PACKET_NEED_MORE;
 
     packet_data = &packetizer->map_data[packetizer->map_offset + sync_offset];
@@ -892,6 +987,113 @@ mpegts_packetizer_next_packet (MpegTSPacketizer2 * packetizer,
   }
 }
 
+/* Whether the packet at data carries a PCR in its adaptation field. Parsing
+ * such a packet records the PCR observation, which must not happen before the
+ * packets preceding it have been processed */
+static inline gboolean
+mpegts_packetizer_packet_has_pcr (const guint8 * data)
+{
+  return FLAGS_HAS_AFC (data[3]) && data[4] > 0
+      && (data[5] & MPEGTS_AFC_PCR_FLAG);
+}
+
+/*
+ * Batched variant of mpegts_packetizer_next_packet(). Parses as many
+ * consecutive packets as are available in the currently mapped region (up to
+ * max_packets) so callers can iterate over them without going through the
+ * adapter and sync checks for every single packet.
+ *
+ * Only the first packet of a batch may carry a PCR, so that PCR observations
+ * are recorded in the same order relative to the processing of the other
+ * packets as with mpegts_packetizer_next_packet(). A batch also stops before
+ * any packet that lost sync or fails to parse.
+ *
+ * The return value is the status of the first packet: if it is PACKET_BAD,
+ * n_packets is 1 and that packet should be skipped, if it is
+ * PACKET_NEED_MORE, n_packets is 0.
+ *
+ * Processed packets must be released with mpegts_packetizer_clear_packets().
+ */
+MpegTSPacketizerPacketReturn
+mpegts_packetizer_next_packets (MpegTSPacketizer2 * packetizer,
+    MpegTSPacketizerPacket * packets, guint max_packets, guint * n_packets)
+{
+  MpegTSPacketizerPacketReturn ret;
+  MpegTSPacketizerPacket *packet;
+  guint8 *packet_data;
+  guint packet_size;
+  gsize sync_offset, available;
+  guint64 offset;
+  guint i;
+
+  g_return_val_if_fail (max_packets > 0, PACKET_NEED_MORE);
+
+  *n_packets = 0;
+
+  ret = mpegts_packetizer_next_packet (packetizer, &packets[0]);
+  if (ret == PACKET_NEED_MORE)
+    return ret;
+
+  /* mpegts_packetizer_next_packet() already accounted for the first packet,
+   * the following ones are accounted for in mpegts_packetizer_clear_packets()
+   * so that unprocessed packets can be handed out again */
+  *n_packets = 1;
+  if (ret == PACKET_BAD)
+    return ret;
+
+  packet_size = packetizer->packet_size;
+  sync_offset = packet_size == MPEGTS_M2TS_PACKETSIZE ? 4 : 0;
+  available = (packetizer->map_size - packetizer->map_offset) / packet_size;
+  offset = packetizer->offset;
+
+  max_packets = MIN (max_packets, available);
+
+  for (i = 1; i < max_packets; i++) {
+    packet = &packets[i];
+    packet_data = &packetizer->map_data[packetizer->map_offset +
+        i * packet_size + sync_offset];
+
+    if (G_UNLIKELY (*packet_data != PACKET_SYNC_BYTE))
+      break;
+
+    if (mpegts_packetizer_packet_has_pcr (packet_data))
+      break;
+
+    packet->data_start = packet_data;
+    packet->data_end = packet->data_start + 188;
+    packet->offset = offset;
+
+    if (mpegts_packetizer_parse_packet (packetizer, packet) != PACKET_OK)
+      break;
+
+    offset += packet_size;
+  }
+
+  *n_packets = i;
+
+  return PACKET_OK;
+}
+
+/* Releases the first n_packets packets of the last batch returned by
+ * mpegts_packetizer_next_packets(). The remaining ones will be returned again
+ * by the next call */
+void
+mpegts_packetizer_clear_packets (MpegTSPacketizer2 * packetizer,
+    guint n_packets)
+{
+  guint packet_size = packetizer->packet_size;
+
+  /* The packetizer might have been flushed while processing the packets */
+  if (packetizer->map_data == NULL || n_packets == 0)
+    return;
+
+  packetizer->map_offset += n_packets * packet_size;
+  packetizer->offset += (n_packets - 1) * packet_size;
+
+  if (packetizer->map_size - packetizer->map_offset < packet_size)
+    mpegts_packetizer_flush_bytes (packetizer, packetizer->map_offset);
+}
+
 MpegTSPacketizerPacketReturn
 mpegts_packetizer_process_next_packet (MpegTSPacketizer2 * packetizer)
 {
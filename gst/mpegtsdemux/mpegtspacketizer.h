@@ -50,6 +50,9 @@
 
 #define MAX_WINDOW 512
 
+/* Maximum number of packets handed out by mpegts_packetizer_next_packets() */
+#define MPEGTS_PACKET_BATCH_SIZE 64
+
 G_BEGIN_DECLS
 
 #define GST_TYPE_MPEGTS_PACKETIZER \
@@ -85,7 +88,9 @@ typedef struct
   guint8  section_number;
   guint8  last_section_number;
 
-  GSList *subtables;
+  /* MpegTSPacketizerStreamSubtable indexed by table_id and subtable_extension
+   * (allocated on demand) */
+  GHashTable *subtables;
 
   /* Upstream offset of the data contained in the section */
   guint64 offset;
@@ -267,6 +272,8 @@ struct _MpegTSPacketizer2 {
   guint8 *map_data;
   gsize map_offset;
   gsize map_size;
+  /* Input buffer holding map_data, if it was mapped without copying */
+  GstBuffer *map_buffer;
   gboolean need_sync;
 
   /* Reference offset */
@@ -353,9 +360,16 @@ G_GNUC_INTERNAL gboolean mpegts_packetizer_has_packets (MpegTSPacketizer2 *packe
 G_GNUC_INTERNAL MpegTSPacketizerPacketReturn mpegts_packetizer_next_packet (MpegTSPacketizer2 *packetizer,
   MpegTSPacketizerPacket *packet);
 G_GNUC_INTERNAL MpegTSPacketizerPacketReturn
+mpegts_packetizer_next_packets (MpegTSPacketizer2 *packetizer,
+  MpegTSPacketizerPacket *packets, guint max_packets, guint *n_packets);
+G_GNUC_INTERNAL MpegTSPacketizerPacketReturn
 mpegts_packetizer_process_next_packet(MpegTSPacketizer2 * packetizer);
 G_GNUC_INTERNAL void mpegts_packetizer_clear_packet (MpegTSPacketizer2 *packetizer,
 				     MpegTSPacketizerPacket *packet);
+G_GNUC_INTERNAL void mpegts_packetizer_clear_packets (MpegTSPacketizer2 *packetizer,
+				     guint n_packets);
+G_GNUC_INTERNAL GstMemory *mpegts_packetizer_share_data (MpegTSPacketizer2 *packetizer,
+				     const guint8 *data, gsize size);
 G_GNUC_INTERNAL void mpegts_packetizer_remove_stream(MpegTSPacketizer2 *packetizer,
   gint16 pid);
 
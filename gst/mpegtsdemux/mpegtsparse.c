@@ -30,6 +30,8 @@
 #include <stdlib.h>
 #include <string.h>
 
+#include <gst/base/gstdataqueue.h>
+
 #include "mpegtsbase.h"
 #include "mpegtsparse.h"
 #include "gstmpegdesc.h"
@@ -37,6 +39,8 @@
 /* latency in mseconds is maximum 100 ms between PCR */
 #define TS_LATENCY 100
 
+#define DEFAULT_PROGRAM_QUEUE_SIZE 0
+
 #define TABLE_ID_UNSET 0xFF
 #define RUNNING_STATUS_RUNNING 4
 #define SYNC_BYTE 0x47
@@ -67,6 +71,16 @@ struct _MpegTSParsePad
   GstFlowReturn flow_return;
 
   MpegTSParse2Adapter ts_adapter;
+
+  /* Queue feeding the pad's own streaming thread, only used if the
+   * program-queue-size property was set when the pad was requested */
+  GstDataQueue *queue;
+  guint queue_size;
+  /* Last flow return of the pad's streaming thread */
+  GstFlowReturn queue_flow_return;
+  /* Number of buffers dropped because the queue was full, protected by the
+   * object lock of the element */
+  guint64 dropped;
 };
 
 static GstStaticPadTemplate src_template =
@@ -89,6 +103,8 @@ enum
   PROP_PCR_PID,
   PROP_ALIGNMENT,
   PROP_SPLIT_ON_RAI,
+  PROP_PROGRAM_QUEUE_SIZE,
+  PROP_STATS,
   /* FILL ME */
 };
 
@@ -122,6 +138,11 @@ static void mpegts_parse_release_pad (GstElement * element, GstPad * pad);
 static gboolean mpegts_parse_src_pad_query (GstPad * pad, GstObject * parent,
     GstQuery * query);
 static gboolean push_event (MpegTSBase * base, GstEvent * event);
+static GstStructure *mpegts_parse_create_stats (MpegTSParse2 * parse);
+static GstFlowReturn mpegts_parse_pad_push (MpegTSParse2 * parse,
+    GstPad * pad, GstBuffer * buffer);
+static gboolean mpegts_parse_pad_push_event (MpegTSParse2 * parse,
+    GstPad * pad, GstEvent * event);
 
 #define mpegts_parse_parent_class parent_class
 G_DEFINE_TYPE (MpegTSParse2, mpegts_parse, GST_TYPE_MPEGTS_BASE);
@@ -183,6 +204,43 @@ mpegts_parse_class_init (MpegTSParse2Class * klass)
           "so that RAI packets are at the start of a new buffer", FALSE,
           G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
 
+  /**
+   * tsparse:program-queue-size:
+   *
+   * Maximum number of buffers queued for each program pad. If not 0, program
+   * pads requested afterwards push from their own streaming thread, fed by a
+   * queue of that size. When a queue is full, buffers for that program are
+   * dropped instead of blocking the other programs.
+   *
+   * Since: 1.24
+   */
+  g_object_class_install_property (gobject_class, PROP_PROGRAM_QUEUE_SIZE,
+      g_param_spec_uint ("program-queue-size", "Program queue size",
+          "Maximum number of buffers queued for each program pad requested "
+          "afterwards, which then push from their own thread (0 = disabled)",
+          0, G_MAXUINT, DEFAULT_PROGRAM_QUEUE_SIZE,
+          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
+  /**
+   * tsparse:stats:
+   *
+   * Statistics of the program pads. Contains a "programs" array with one
+   * structure per program pad, with the following fields:
+   *
+   * * "program-number" (gint): the program number of the pad
+   * * "queue-level" (guint): number of buffers currently queued
+   * * "queue-size" (guint): maximum number of queued buffers (0 if the pad
+   *   doesn't have its own thread)
+   * * "dropped" (guint64): number of buffers dropped because the queue was
+   *   full
+   *
+   * Since: 1.24
+   */
+  g_object_class_install_property (gobject_class, PROP_STATS,
+      g_param_spec_boxed ("stats", "Statistics",
+          "Program pads statistics", GST_TYPE_STRUCTURE,
+          G_PARAM_READABLE | G_PARAM_STATIC_STRINGS));
+
   element_class = GST_ELEMENT_CLASS (klass);
   element_class->pad_removed = mpegts_parse_pad_removed;
   element_class->request_new_pad = mpegts_parse_request_new_pad;
@@ -238,6 +296,7 @@ mpegts_parse_init (MpegTSParse2 * parse)
   parse->is_eos = FALSE;
   parse->header = 0;
   parse->split_on_rai = FALSE;
+  parse->program_queue_size = DEFAULT_PROGRAM_QUEUE_SIZE;
 }
 
 static void
@@ -313,6 +372,11 @@ mpegts_parse_set_property (GObject * object, guint prop_id,
     case PROP_SPLIT_ON_RAI:
       parse->split_on_rai = g_value_get_boolean (value);
       break;
+    case PROP_PROGRAM_QUEUE_SIZE:
+      GST_OBJECT_LOCK (parse);
+      parse->program_queue_size = g_value_get_uint (value);
+      GST_OBJECT_UNLOCK (parse);
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
   }
@@ -340,6 +404,14 @@ mpegts_parse_get_property (GObject * object, guint prop_id,
     case PROP_SPLIT_ON_RAI:
       g_value_set_boolean (value, parse->split_on_rai);
       break;
+    case PROP_PROGRAM_QUEUE_SIZE:
+      GST_OBJECT_LOCK (parse);
+      g_value_set_uint (value, parse->program_queue_size);
+      GST_OBJECT_UNLOCK (parse);
+      break;
+    case PROP_STATS:
+      g_value_take_boxed (value, mpegts_parse_create_stats (parse));
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
   }
@@ -476,7 +548,7 @@ push_event (MpegTSBase * base, GstEvent * event)
     GstPad *pad = (GstPad *) tmp->data;
     if (pad) {
       gst_event_ref (event);
-      gst_pad_push_event (pad, event);
+      mpegts_parse_pad_push_event (parse, pad, event);
     }
   }
 
@@ -485,11 +557,78 @@ push_event (MpegTSBase * base, GstEvent * event)
   return TRUE;
 }
 
+static void
+data_queue_item_free (GstDataQueueItem * item)
+{
+  if (item->object)
+    gst_mini_object_unref (item->object);
+  g_free (item);
+}
+
+static gboolean
+data_queue_check_full_cb (GstDataQueue * queue, guint visible, guint bytes,
+    guint64 time, gpointer user_data)
+{
+  MpegTSParsePad *tspad = user_data;
+
+  return visible >= tspad->queue_size;
+}
+
+static void
+mpegts_parse_tspad_loop (MpegTSParsePad * tspad)
+{
+  GstDataQueueItem *item;
+  GstFlowReturn ret;
+
+  if (!gst_data_queue_pop (tspad->queue, &item)) {
+    GST_DEBUG_OBJECT (tspad->pad, "flushing, pausing task");
+    gst_pad_pause_task (tspad->pad);
+    return;
+  }
+
+  if (GST_IS_BUFFER (item->object)) {
+    ret = gst_pad_push (tspad->pad, GST_BUFFER (item->object));
+    item->object = NULL;
+
+    if (G_UNLIKELY (ret != GST_FLOW_OK))
+      GST_LOG_OBJECT (tspad->pad, "pushing returned %s",
+          gst_flow_get_name (ret));
+    g_atomic_int_set (&tspad->queue_flow_return, ret);
+  } else {
+    gst_pad_push_event (tspad->pad, GST_EVENT (item->object));
+    item->object = NULL;
+  }
+
+  item->destroy (item);
+}
+
+static gboolean
+mpegts_parse_tspad_activate_mode (GstPad * pad, GstObject * parent,
+    GstPadMode mode, gboolean active)
+{
+  MpegTSParsePad *tspad = (MpegTSParsePad *) gst_pad_get_element_private (pad);
+
+  if (mode != GST_PAD_MODE_PUSH)
+    return FALSE;
+
+  if (active) {
+    g_atomic_int_set (&tspad->queue_flow_return, GST_FLOW_OK);
+    gst_data_queue_set_flushing (tspad->queue, FALSE);
+    return gst_pad_start_task (pad,
+        (GstTaskFunction) mpegts_parse_tspad_loop, tspad, NULL);
+  }
+
+  gst_data_queue_set_flushing (tspad->queue, TRUE);
+  gst_data_queue_flush (tspad->queue);
+  return gst_pad_stop_task (pad);
+}
+
 static MpegTSParsePad *
 mpegts_parse_create_tspad (MpegTSParse2 * parse, const gchar * pad_name)
 {
   GstPad *pad;
   MpegTSParsePad *tspad;
+  guint queue_size;
 
   pad = gst_pad_new_from_static_template (&program_template, pad_name);
   gst_pad_set_query_function (pad,
@@ -505,18 +644,157 @@ mpegts_parse_create_tspad (MpegTSParse2 * parse, const gchar * pad_name)
   tspad->ts_adapter.adapter = gst_adapter_new ();
   tspad->ts_adapter.packets_in_adapter = 0;
   tspad->ts_adapter.first_is_keyframe = TRUE;
+
+  GST_OBJECT_LOCK (parse);
+  queue_size = parse->program_queue_size;
+  GST_OBJECT_UNLOCK (parse);
+
+  if (queue_size > 0) {
+    GST_DEBUG_OBJECT (parse, "pad %s pushes from its own thread, queue size %u",
+        pad_name, queue_size);
+    tspad->queue_size = queue_size;
+    tspad->queue =
+        gst_data_queue_new (data_queue_check_full_cb, NULL, NULL, tspad);
+    gst_data_queue_set_flushing (tspad->queue, TRUE);
+    gst_pad_set_activatemode_function (pad,
+        GST_DEBUG_FUNCPTR (mpegts_parse_tspad_activate_mode));
+  }
+
   gst_pad_set_element_private (pad, tspad);
   gst_flow_combiner_add_pad (parse->flowcombiner, pad);
 
   return tspad;
 }
 
+static GstFlowReturn
+mpegts_parse_pad_push (MpegTSParse2 * parse, GstPad * pad, GstBuffer * buffer)
+{
+  MpegTSParsePad *tspad = (MpegTSParsePad *) gst_pad_get_element_private (pad);
+  GstDataQueueItem *item;
+
+  if (tspad == NULL || tspad->queue == NULL)
+    return gst_pad_push (pad, buffer);
+
+  if (gst_data_queue_is_full (tspad->queue)) {
+    guint64 dropped;
+
+    GST_OBJECT_LOCK (parse);
+    dropped = ++tspad->dropped;
+    GST_OBJECT_UNLOCK (parse);
+
+    GST_LOG_OBJECT (pad, "queue full, dropping buffer (%" G_GUINT64_FORMAT
+        " dropped)", dropped);
+    gst_buffer_unref (buffer);
+    return g_atomic_int_get (&tspad->queue_flow_return);
+  }
+
+  item = g_new0 (GstDataQueueItem, 1);
+  item->object = GST_MINI_OBJECT (buffer);
+  item->size = gst_buffer_get_size (buffer);
+  item->visible = TRUE;
+  item->destroy = (GDestroyNotify) data_queue_item_free;
+
+  if (!gst_data_queue_push (tspad->queue, item)) {
+    item->destroy (item);
+    return GST_FLOW_FLUSHING;
+  }
+
+  return g_atomic_int_get (&tspad->queue_flow_return);
+}
+
+static gboolean
+mpegts_parse_pad_push_event (MpegTSParse2 * parse, GstPad * pad,
+    GstEvent * event)
+{
+  MpegTSParsePad *tspad = (MpegTSParsePad *) gst_pad_get_element_private (pad);
+  GstDataQueueItem *item;
+  gboolean res;
+
+  if (tspad == NULL || tspad->queue == NULL)
+    return gst_pad_push_event (pad, event);
+
+  switch (GST_EVENT_TYPE (event)) {
+    case GST_EVENT_FLUSH_START:
+      res = gst_pad_push_event (pad, event);
+      gst_data_queue_set_flushing (tspad->queue, TRUE);
+      gst_pad_pause_task (pad);
+      return res;
+    case GST_EVENT_FLUSH_STOP:
+      gst_data_queue_flush (tspad->queue);
+      res = gst_pad_push_event (pad, event);
+      g_atomic_int_set (&tspad->queue_flow_return, GST_FLOW_OK);
+      gst_data_queue_set_flushing (tspad->queue, FALSE);
+      gst_pad_start_task (pad, (GstTaskFunction) mpegts_parse_tspad_loop,
+          tspad, NULL);
+      return res;
+    default:
+      break;
+  }
+
+  if (!GST_EVENT_IS_SERIALIZED (event))
+    return gst_pad_push_event (pad, event);
+
+  /* Serialized events go through the queue to keep them ordered with the
+   * buffers, and are never dropped */
+  item = g_new0 (GstDataQueueItem, 1);
+  item->object = GST_MINI_OBJECT (event);
+  item->visible = FALSE;
+  item->destroy = (GDestroyNotify) data_queue_item_free;
+
+  if (!gst_data_queue_push_force (tspad->queue, item)) {
+    item->destroy (item);
+    return FALSE;
+  }
+
+  return TRUE;
+}
+
+static GstStructure *
+mpegts_parse_create_stats (MpegTSParse2 * parse)
+{
+  GstStructure *s;
+  GValue programs = G_VALUE_INIT;
+  GList *tmp;
+
+  g_value_init (&programs, GST_TYPE_ARRAY);
+
+  GST_OBJECT_LOCK (parse);
+  for (tmp = parse->srcpads; tmp; tmp = tmp->next) {
+    MpegTSParsePad *tspad = gst_pad_get_element_private ((GstPad *) tmp->data);
+    GstDataQueueSize level = { 0, };
+    GValue v = G_VALUE_INIT;
+
+    if (tspad->queue)
+      gst_data_queue_get_level (tspad->queue, &level);
+
+    g_value_init (&v, GST_TYPE_STRUCTURE);
+    g_value_take_boxed (&v, gst_structure_new ("program",
+            "program-number", G_TYPE_INT, tspad->program_number,
+            "queue-level", G_TYPE_UINT, level.visible,
+            "queue-size", G_TYPE_UINT, tspad->queue_size,
+            "dropped", G_TYPE_UINT64, tspad->dropped, NULL));
+    gst_value_array_append_and_take_value (&programs, &v);
+  }
+  GST_OBJECT_UNLOCK (parse);
+
+  s = gst_structure_new_empty ("application/x-tsparse-stats");
+  gst_structure_take_value (s, "programs", &programs);
+
+  return s;
+}
+
 static void
 mpegts_parse_destroy_tspad (MpegTSParse2 * parse, MpegTSParsePad * tspad)
 {
   gst_adapter_clear (tspad->ts_adapter.adapter);
   g_object_unref (tspad->ts_adapter.adapter);
 
+  if (tspad->queue) {
+    gst_data_queue_set_flushing (tspad->queue, TRUE);
+    gst_data_queue_flush (tspad->queue);
+    g_object_unref (tspad->queue);
+  }
+
   /* free the wrapper */
   g_free (tspad);
 }
@@ -599,7 +877,7 @@ mpegts_parse_request_new_pad (GstElement * element, GstPadTemplate * template,
   if (parse->have_group_id)
     gst_event_set_group_id (event, parse->group_id);
 
-  gst_pad_push_event (pad, event);
+  mpegts_parse_pad_push_event (parse, pad, event);
   g_free (stream_id);
 
   gst_element_add_pad (element, pad);
@@ -660,7 +938,7 @@ empty_adapter_into_pad (MpegTSParse2 * parse, MpegTSParse2Adapter * ts_adapter,
     GST_BUFFER_DTS (buf) = dts;
     if (!ts_adapter->first_is_keyframe)
       gst_buffer_set_flags (buf, GST_BUFFER_FLAG_DELTA_UNIT);
-    ret = gst_pad_push (pad, buf);
+    ret = mpegts_parse_pad_push (parse, pad, buf);
   }
 
   return ret;
@@ -674,7 +952,7 @@ enqueue_and_maybe_push_buffer (MpegTSParse2 * parse, GstPad * pad,
 
   if (buffer != NULL) {
     if (parse->alignment == 1) {
-      ret = gst_pad_push (pad, buffer);
+      ret = mpegts_parse_pad_push (parse, pad, buffer);
       ret = gst_flow_combiner_update_flow (parse->flowcombiner, ret);
     } else {
       if (!GST_BUFFER_FLAG_IS_SET (buffer, GST_BUFFER_FLAG_DELTA_UNIT)
@@ -758,7 +1036,7 @@ mpegts_parse_tspad_push (MpegTSParse2 * parse, MpegTSParsePad * tspad,
     if (packet->pid == bp->pmt_pid || bp->streams == NULL
         || bp->streams[packet->pid]) {
       /* push if there's no filter or if the pid is in the filter */
-      ret = gst_pad_push (tspad->pad, gst_buffer_ref (buf));
+      ret = mpegts_parse_pad_push (parse, tspad->pad, gst_buffer_ref (buf));
       ret = gst_flow_combiner_update_flow (parse->flowcombiner, ret);
     }
   }
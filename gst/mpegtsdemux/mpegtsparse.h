@@ -88,6 +88,9 @@ struct _MpegTSParse2 {
   gboolean split_on_rai;
   gboolean is_eos;
   guint32 header;
+
+  /* Size of the per program pad queues (0 = push from the input thread) */
+  guint program_queue_size;
 };
 
 struct _MpegTSParse2Class {
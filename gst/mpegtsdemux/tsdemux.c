@@ -74,6 +74,7 @@
 
 /* latency in msecs */
 #define DEFAULT_LATENCY (700)
+#define DEFAULT_ZERO_COPY_PES FALSE
 
 /* Limit PES packet collection to a maximum of 32MB
  * which is more than large enough to support an H264 frame at
@@ -187,6 +188,19 @@ struct _TSDemuxStream
   /* Size of ->data */
   guint allocated_size;
 
+  /* Whether the current PES payload is collected as memories shared with
+   * the input instead of being copied into ->data */
+  gboolean slice_data;
+  /* Full buffers of shared memories */
+  GstBufferList *slices;
+  /* Buffer being filled with shared memories */
+  GstBuffer *slice_buf;
+
+  /* Whether downstream requires physically contiguous memory (in which case
+   * the payload is never shared), and whether it was queried */
+  gboolean needs_contiguous;
+  gboolean allocation_queried;
+
   /* Current PTS/DTS for this stream (in running time) */
   GstClockTime pts;
   GstClockTime dts;
@@ -302,6 +316,7 @@ enum
   PROP_EMIT_STATS,
   PROP_LATENCY,
   PROP_SEND_SCTE35_EVENTS,
+  PROP_ZERO_COPY_PES,
   /* FILL ME */
 };
 
@@ -435,6 +450,26 @@ gst_ts_demux_class_init (GstTSDemuxClass * klass)
           G_MAXINT, DEFAULT_LATENCY,
           G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
 
+  /**
+   * tsdemux:zero-copy-pes:
+   *
+   * Whether the PES payload of MPEG-1/2, H.264 and H.265 video streams
+   * should be output in memories shared with the input instead of being
+   * copied into a single buffer.
+   *
+   * A PES is then pushed as a buffer list, as a buffer can hold at most 16
+   * memories, with the timestamps and flags on its first buffer only.
+   * Downstream elements have to handle such lists. The payload is still
+   * copied when downstream requires physically contiguous memory.
+   *
+   * Since: 1.24
+   */
+  g_object_class_install_property (gobject_class, PROP_ZERO_COPY_PES,
+      g_param_spec_boolean ("zero-copy-pes", "Zero-copy PES",
+          "Output the PES payload of video streams in memories shared with "
+          "the input, as buffer lists", DEFAULT_ZERO_COPY_PES,
+          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
   element_class = GST_ELEMENT_CLASS (klass);
   gst_element_class_add_pad_template (element_class,
       gst_static_pad_template_get (&video_template));
@@ -512,6 +547,7 @@ gst_ts_demux_init (GstTSDemux * demux)
   demux->requested_program_number = -1;
   demux->program_number = -1;
   demux->latency = DEFAULT_LATENCY;
+  demux->zero_copy_pes = DEFAULT_ZERO_COPY_PES;
   gst_ts_demux_reset (base);
 
   g_mutex_init (&demux->lock);
@@ -539,6 +575,9 @@ gst_ts_demux_set_property (GObject * object, guint prop_id,
     case PROP_LATENCY:
       demux->latency = g_value_get_int (value);
       break;
+    case PROP_ZERO_COPY_PES:
+      demux->zero_copy_pes = g_value_get_boolean (value);
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
   }
@@ -563,6 +602,9 @@ gst_ts_demux_get_property (GObject * object, guint prop_id,
     case PROP_LATENCY:
       g_value_set_int (value, demux->latency);
       break;
+    case PROP_ZERO_COPY_PES:
+      g_value_set_boolean (value, demux->zero_copy_pes);
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
   }
@@ -2134,14 +2176,26 @@ activate_pad_for_stream (GstTSDemux * tsdemux, TSDemuxStream * stream)
   }
 }
 
+/* Drops the PES payload collected so far */
+static void
+gst_ts_demux_stream_clear_data (TSDemuxStream * stream)
+{
+  g_free (stream->data);
+  stream->data = NULL;
+  if (stream->slices) {
+    gst_buffer_list_unref (stream->slices);
+    stream->slices = NULL;
+  }
+  gst_buffer_replace (&stream->slice_buf, NULL);
+}
+
 static void
 gst_ts_demux_stream_flush (TSDemuxStream * stream, GstTSDemux * tsdemux,
     gboolean hard)
 {
   GST_DEBUG ("flushing stream %p", stream);
 
-  g_free (stream->data);
-  stream->data = NULL;
+  gst_ts_demux_stream_clear_data (stream);
   g_free (stream->pending_header_data);
   stream->pending_header_data = NULL;
   stream->pending_header_size = 0;
@@ -2596,6 +2650,102 @@ check_pending_buffers (GstTSDemux * demux)
   return TRUE;
 }
 
+/* Whether the PES payload of the stream can be output as is, in memories
+ * shared with the input. This is only done when enabled with the
+ * zero-copy-pes property, and unless the payload needs to be parsed before
+ * being output or downstream requires contiguous memory. */
+static gboolean
+gst_ts_demux_stream_can_slice (GstTSDemux * demux, TSDemuxStream * stream)
+{
+  GstCaps *caps;
+  GstQuery *query;
+  GstAllocationParams params;
+  guint i, n;
+
+  if (!demux->zero_copy_pes)
+    return FALSE;
+
+  switch (stream->stream.stream_type) {
+    case GST_MPEGTS_STREAM_TYPE_VIDEO_MPEG1:
+    case GST_MPEGTS_STREAM_TYPE_VIDEO_MPEG2:
+    case GST_MPEGTS_STREAM_TYPE_VIDEO_H264:
+    case GST_MPEGTS_STREAM_TYPE_VIDEO_HEVC:
+      break;
+    default:
+      return FALSE;
+  }
+
+  /* Looking for a keyframe after a seek needs the payload in ->data. And
+   * don't query downstream before the sticky events were sent, only the
+   * first PES is copied. */
+  if (stream->needs_keyframe || stream->need_newsegment || !stream->pad)
+    return FALSE;
+
+  if (gst_pad_check_reconfigure (stream->pad) || !stream->allocation_queried) {
+    caps = gst_pad_get_current_caps (stream->pad);
+    if (!caps)
+      return FALSE;
+
+    query = gst_query_new_allocation (caps, FALSE);
+    if (gst_pad_peer_query (stream->pad, query)) {
+      stream->needs_contiguous = FALSE;
+      n = gst_query_get_n_allocation_params (query);
+      for (i = 0; i < n; i++) {
+        gst_query_parse_nth_allocation_param (query, i, NULL, &params);
+        if (params.flags & GST_MEMORY_FLAG_PHYSICALLY_CONTIGUOUS)
+          stream->needs_contiguous = TRUE;
+      }
+      stream->allocation_queried = TRUE;
+      GST_DEBUG_OBJECT (stream->pad, "downstream %s contiguous memory",
+          stream->needs_contiguous ? "requires" : "doesn't require");
+    }
+    gst_query_unref (query);
+    gst_caps_unref (caps);
+  }
+
+  return !stream->needs_contiguous;
+}
+
+/* Appends size bytes at data to the sliced PES payload */
+static void
+gst_ts_demux_stream_add_slice (GstTSDemux * demux, TSDemuxStream * stream,
+    guint8 * data, guint size)
+{
+  if (size == 0)
+    return;
+
+  /* Appending more memories than a buffer can hold would merge them */
+  if (stream->slice_buf &&
+      gst_buffer_n_memory (stream->slice_buf) == gst_buffer_get_max_memory ()) {
+    if (!stream->slices)
+      stream->slices = gst_buffer_list_new ();
+    gst_buffer_list_add (stream->slices, stream->slice_buf);
+    stream->slice_buf = NULL;
+  }
+  if (!stream->slice_buf)
+    stream->slice_buf = gst_buffer_new ();
+
+  gst_buffer_append_memory (stream->slice_buf,
+      mpegts_packetizer_share_data (MPEG_TS_BASE_PACKETIZER (demux), data,
+          size));
+  stream->current_size += size;
+}
+
+/* Hands out the sliced PES payload as a list of buffers */
+static GstBufferList *
+gst_ts_demux_stream_take_slices (TSDemuxStream * stream)
+{
+  GstBufferList *list = stream->slices;
+
+  if (!list)
+    list = gst_buffer_list_new_sized (1);
+  gst_buffer_list_add (list, stream->slice_buf);
+  stream->slices = NULL;
+  stream->slice_buf = NULL;
+
+  return list;
+}
+
 static void
 gst_ts_demux_parse_pes_header (GstTSDemux * demux, TSDemuxStream * stream,
     guint8 * data, guint32 length, guint64 bufferoffset)
@@ -2671,16 +2821,22 @@ gst_ts_demux_parse_pes_header (GstTSDemux * demux, TSDemuxStream * stream,
   data += header.header_size;
   length -= header.header_size;
 
-  /* Create the output buffer */
-  if (stream->expected_size)
-    stream->allocated_size = MAX (stream->expected_size, length);
-  else
-    stream->allocated_size = MAX (8192, length);
+  g_assert (stream->data == NULL && stream->slice_buf == NULL);
+  stream->current_size = 0;
+  stream->slice_data = gst_ts_demux_stream_can_slice (demux, stream);
+  if (stream->slice_data) {
+    gst_ts_demux_stream_add_slice (demux, stream, data, length);
+  } else {
+    /* Create the output buffer */
+    if (stream->expected_size)
+      stream->allocated_size = MAX (stream->expected_size, length);
+    else
+      stream->allocated_size = MAX (8192, length);
 
-  g_assert (stream->data == NULL);
-  stream->data = g_malloc (stream->allocated_size);
-  memcpy (stream->data, data, length);
-  stream->current_size = length;
+    stream->data = g_malloc (stream->allocated_size);
+    memcpy (stream->data, data, length);
+    stream->current_size = length;
+  }
 
   stream->state = PENDING_PACKET_BUFFER;
 
@@ -2730,10 +2886,7 @@ gst_ts_demux_queue_data (GstTSDemux * demux, TSDemuxStream * stream,
       if (packet->payload_unit_start_indicator) {
         /* A mismatch is fatal, except if this is the beginning of a new
          * frame (from which we can recover) */
-        if (G_UNLIKELY (stream->data)) {
-          g_free (stream->data);
-          stream->data = NULL;
-        }
+        gst_ts_demux_stream_clear_data (stream);
         if (G_UNLIKELY (stream->pending_header_data)) {
           g_free (stream->pending_header_data);
           stream->pending_header_data = NULL;
@@ -2778,6 +2931,10 @@ gst_ts_demux_queue_data (GstTSDemux * demux, TSDemuxStream * stream,
     case PENDING_PACKET_BUFFER:
     {
       GST_LOG_OBJECT (demux, "BUFFER: appending data");
+      if (stream->slice_data) {
+        gst_ts_demux_stream_add_slice (demux, stream, data, size);
+        break;
+      }
       if (G_UNLIKELY (stream->current_size + size > stream->allocated_size)) {
         GST_LOG_OBJECT (demux, "resizing buffer");
         do {
@@ -2792,10 +2949,7 @@ gst_ts_demux_queue_data (GstTSDemux * demux, TSDemuxStream * stream,
     case PENDING_PACKET_DISCONT:
     {
       GST_LOG_OBJECT (demux, "DISCONT: not storing/pushing");
-      if (G_UNLIKELY (stream->data)) {
-        g_free (stream->data);
-        stream->data = NULL;
-      }
+      gst_ts_demux_stream_clear_data (stream);
       if (G_UNLIKELY (stream->pending_header_data)) {
         g_free (stream->pending_header_data);
         stream->pending_header_data = NULL;
@@ -3334,7 +3488,7 @@ gst_ts_demux_push_pending_data (GstTSDemux * demux, TSDemuxStream * stream,
       "stream:%p, pid:0x%04x stream_type:%d state:%d", stream, bs->pid,
       bs->stream_type, stream->state);
 
-  if (G_UNLIKELY (stream->data == NULL)) {
+  if (G_UNLIKELY (stream->data == NULL && stream->slice_buf == NULL)) {
     GST_LOG_OBJECT (stream->pad, "stream->data == NULL");
     goto beach;
   }
@@ -3351,7 +3505,7 @@ gst_ts_demux_push_pending_data (GstTSDemux * demux, TSDemuxStream * stream,
 
   if (G_UNLIKELY (demux->program == NULL)) {
     GST_LOG_OBJECT (demux, "No program");
-    g_free (stream->data);
+    gst_ts_demux_stream_clear_data (stream);
     goto beach;
   }
 
@@ -3406,9 +3560,7 @@ gst_ts_demux_push_pending_data (GstTSDemux * demux, TSDemuxStream * stream,
         GST_DEBUG_OBJECT (cand->pad, "Clearing stream");
         cand->continuity_counter = CONTINUITY_UNSET;
         cand->state = PENDING_PACKET_EMPTY;
-        if (cand->data)
-          g_free (cand->data);
-        cand->data = NULL;
+        gst_ts_demux_stream_clear_data (cand);
         cand->allocated_size = 0;
         cand->current_size = 0;
       }
@@ -3443,6 +3595,13 @@ gst_ts_demux_push_pending_data (GstTSDemux * demux, TSDemuxStream * stream,
         res = GST_FLOW_ERROR;
         goto beach;
       }
+    } else if (stream->slice_buf) {
+      buffer_list = gst_ts_demux_stream_take_slices (stream);
+      if (gst_buffer_list_length (buffer_list) == 1) {
+        buffer = gst_buffer_ref (gst_buffer_list_get (buffer_list, 0));
+        gst_buffer_list_unref (buffer_list);
+        buffer_list = NULL;
+      }
     } else {
       buffer = gst_buffer_new_wrapped (stream->data, stream->current_size);
     }
@@ -3602,6 +3761,8 @@ beach:
       stream->expected_size -= stream->current_size;
   }
   stream->data = NULL;
+  if (G_UNLIKELY (stream->slice_buf))
+    gst_ts_demux_stream_clear_data (stream);
   stream->allocated_size = 0;
   stream->current_size = 0;
 
@@ -78,6 +78,7 @@ struct _GstTSDemux
   gboolean emit_statistics;
   gboolean send_scte35_events;
   gint latency; /* latency in ms */
+  gboolean zero_copy_pes;
 
   /*< private >*/
   gint program_generation; /* Incremented each time we switch program 0..15 */
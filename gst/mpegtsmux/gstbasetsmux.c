@@ -117,6 +117,8 @@ gst_base_ts_mux_pad_reset (GstBaseTsMuxPad * pad)
     g_free (pad->language);
     pad->language = NULL;
   }
+
+  pad->max_bitrate = 0;
 }
 
 /* GstAggregatorPad implementation */
@@ -302,6 +304,70 @@ steal_si_section (GstMpegtsSectionType * type, TsMuxSection * section,
   return TRUE;
 }
 
+static void
+gst_base_ts_mux_clear_pool (GstBufferPool ** pool)
+{
+  if (*pool) {
+    gst_buffer_pool_set_active (*pool, FALSE);
+    gst_object_unref (*pool);
+    *pool = NULL;
+  }
+}
+
+/* Acquire a buffer of @size bytes from @pool, (re)creating the pool
+ * whenever the requested size changes. Falls back to a plain allocation
+ * if the pool can't be used for some reason. */
+static GstBuffer *
+gst_base_ts_mux_acquire_buffer (GstBaseTsMux * mux, GstBufferPool ** pool,
+    gsize * pool_size, gsize size)
+{
+  GstBuffer *buf = NULL;
+
+  if (*pool && *pool_size != size)
+    gst_base_ts_mux_clear_pool (pool);
+
+  if (*pool == NULL) {
+    GstStructure *config;
+
+    *pool = gst_buffer_pool_new ();
+    *pool_size = size;
+
+    config = gst_buffer_pool_get_config (*pool);
+    gst_buffer_pool_config_set_params (config, NULL, size, 0, 0);
+
+    if (!gst_buffer_pool_set_config (*pool, config) ||
+        !gst_buffer_pool_set_active (*pool, TRUE)) {
+      GST_WARNING_OBJECT (mux, "Failed to set up buffer pool of size %"
+          G_GSIZE_FORMAT, size);
+      gst_object_unref (*pool);
+      *pool = NULL;
+    }
+  }
+
+  if (*pool == NULL
+      || gst_buffer_pool_acquire_buffer (*pool, &buf, NULL) != GST_FLOW_OK)
+    buf = gst_buffer_new_and_alloc (size);
+
+  return buf;
+}
+
+/* Forgets about the packet handed out to be written in place into the
+ * output buffer, returns whether it is still in use */
+static gboolean
+gst_base_ts_mux_drop_out_slot (GstBaseTsMux * mux)
+{
+  gboolean in_use;
+
+  if (mux->out_slot == NULL)
+    return FALSE;
+
+  in_use = GST_MINI_OBJECT_REFCOUNT_VALUE (mux->out_slot) > 1;
+  gst_memory_unref (mux->out_slot);
+  mux->out_slot = NULL;
+
+  return in_use;
+}
+
 /* Must be called with mux->lock held */
 static void
 gst_base_ts_mux_reset (GstBaseTsMux * mux, gboolean alloc)
@@ -342,7 +408,21 @@ gst_base_ts_mux_reset (GstBaseTsMux * mux, gboolean alloc)
     gst_buffer_unref (buf);
 
   gst_event_replace (&mux->force_key_unit_event, NULL);
-  gst_buffer_replace (&mux->out_buffer, NULL);
+  if (mux->out_buffer) {
+    /* a pending packet may still write into it, don't recycle it */
+    if (gst_base_ts_mux_drop_out_slot (mux))
+      GST_BUFFER_FLAG_SET (mux->out_buffer, GST_BUFFER_FLAG_TAG_MEMORY);
+    gst_buffer_unmap (mux->out_buffer, &mux->out_map);
+    gst_buffer_replace (&mux->out_buffer, NULL);
+  }
+  mux->out_in_place = TRUE;
+  mux->out_offset = 0;
+  if (mux->out_list) {
+    gst_buffer_list_unref (mux->out_list);
+    mux->out_list = NULL;
+  }
+  gst_base_ts_mux_clear_pool (&mux->packet_pool);
+  gst_base_ts_mux_clear_pool (&mux->out_pool);
 
   GST_OBJECT_LOCK (mux);
 
@@ -378,6 +458,120 @@ release_buffer_cb (guint8 * data, void *user_data)
   stream_data_free ((StreamData *) user_data);
 }
 
+typedef struct
+{
+  const gchar *level;
+  guint max_br;
+  guint max_br_high_tier;
+} VideoLevelLimits;
+
+/* MaxBR in units of 1000 bits/s, H.264 table A-1 */
+static const VideoLevelLimits h264_levels[] = {
+  {"1", 64}, {"1b", 128}, {"1.1", 192}, {"1.2", 384}, {"1.3", 768},
+  {"2", 2000}, {"2.1", 4000}, {"2.2", 4000}, {"3", 10000}, {"3.1", 14000},
+  {"3.2", 20000}, {"4", 20000}, {"4.1", 50000}, {"4.2", 50000},
+  {"5", 135000}, {"5.1", 240000}, {"5.2", 240000}, {"6", 240000},
+  {"6.1", 480000}, {"6.2", 800000},
+};
+
+/* MaxBR of the main and high tiers in units of 1000 bits/s, H.265 table
+ * A.8 */
+static const VideoLevelLimits h265_levels[] = {
+  {"1", 128, 0}, {"2", 1500, 0}, {"2.1", 3000, 0}, {"3", 6000, 0},
+  {"3.1", 10000, 0}, {"4", 12000, 30000}, {"4.1", 20000, 50000},
+  {"5", 25000, 100000}, {"5.1", 40000, 160000}, {"5.2", 60000, 240000},
+  {"6", 60000, 240000}, {"6.1", 120000, 480000}, {"6.2", 240000, 800000},
+};
+
+/* Maximum bit rate in units of 1000 bits/s of the main profile, and of the
+ * high profile as high tier, MPEG-2 table 8-13 */
+static const VideoLevelLimits mpeg2_levels[] = {
+  {"low", 4000, 4000}, {"main", 15000, 20000}, {"high-1440", 60000, 80000},
+  {"high", 80000, 100000},
+};
+
+static const VideoLevelLimits *
+find_video_level (const VideoLevelLimits * levels, guint n_levels,
+    const gchar * level)
+{
+  guint i;
+
+  for (i = 0; i < n_levels; i++) {
+    if (g_str_equal (levels[i].level, level))
+      return &levels[i];
+  }
+
+  return NULL;
+}
+
+/* Rmax of the T-STD of a MPEG-2, H.264 or H.265 video stream in bits per
+ * second, from the profile and level in its caps, or 0 if they are unknown.
+ * For H.264 and H.265, it is MaxBR scaled by the cpbBrNalFactor of the
+ * profile. Unknown profiles get the lowest factor: underestimating Rmax
+ * only costs more stuffing, while overestimating it would overflow the
+ * decoder's transport buffer. */
+static guint64
+gst_base_ts_mux_get_video_max_bitrate (GstStructure * s, guint st)
+{
+  const gchar *profile = gst_structure_get_string (s, "profile");
+  const gchar *level = gst_structure_get_string (s, "level");
+  const gchar *tier;
+  const VideoLevelLimits *limits;
+  guint factor;
+
+  if (!level)
+    return 0;
+
+  switch (st) {
+    case TSMUX_ST_VIDEO_H264:
+      limits = find_video_level (h264_levels, G_N_ELEMENTS (h264_levels),
+          level);
+      if (!limits)
+        return 0;
+
+      factor = 1200;
+      if (profile) {
+        if (g_str_has_prefix (profile, "high-4:") ||
+            g_str_equal (profile, "cavlc-4:4:4-intra"))
+          factor = 4800;
+        else if (g_str_has_prefix (profile, "high-10") ||
+            g_str_equal (profile, "progressive-high-10"))
+          factor = 3600;
+        else if (g_str_equal (profile, "high") ||
+            g_str_equal (profile, "progressive-high") ||
+            g_str_equal (profile, "constrained-high"))
+          factor = 1500;
+      }
+
+      return (guint64) limits->max_br * factor;
+    case TSMUX_ST_VIDEO_HEVC:
+      limits = find_video_level (h265_levels, G_N_ELEMENTS (h265_levels),
+          level);
+      if (!limits)
+        return 0;
+
+      tier = gst_structure_get_string (s, "tier");
+      if (tier && g_str_equal (tier, "high") && limits->max_br_high_tier)
+        return (guint64) limits->max_br_high_tier * 1100;
+
+      return (guint64) limits->max_br * 1100;
+    case TSMUX_ST_VIDEO_MPEG2:
+      limits = find_video_level (mpeg2_levels, G_N_ELEMENTS (mpeg2_levels),
+          level);
+      if (!limits)
+        return 0;
+
+      if (profile && g_str_equal (profile, "4:2:2"))
+        return g_str_has_prefix (level, "high") ? 300000000 : 50000000;
+      if (profile && g_str_equal (profile, "high"))
+        return (guint64) limits->max_br_high_tier * 1000;
+
+      return (guint64) limits->max_br * 1000;
+    default:
+      return 0;
+  }
+}
+
 /* Must be called with mux->lock held */
 static GstFlowReturn
 gst_base_ts_mux_create_or_update_stream (GstBaseTsMux * mux,
@@ -731,6 +925,15 @@ gst_base_ts_mux_create_or_update_stream (GstBaseTsMux * mux,
   ts_pad->stream->max_bitrate = max_rate;
   ts_pad->stream->profile_and_level = profile | main_level;
 
+  /* Rmax of the video T-STD, the maximum bitrate from the tags if any */
+  if (ts_pad->max_bitrate)
+    ts_pad->stream->tstd_max_bitrate = ts_pad->max_bitrate;
+  else if (max_rate)
+    ts_pad->stream->tstd_max_bitrate = max_rate;
+  else
+    ts_pad->stream->tstd_max_bitrate =
+        gst_base_ts_mux_get_video_max_bitrate (s, st);
+
   ts_pad->stream->opus_channel_config_code = opus_channel_config_code;
 
   tsmux_stream_set_buffer_release_func (ts_pad->stream, release_buffer_cb);
@@ -931,7 +1134,8 @@ new_packet_common_init (GstBaseTsMux * mux, GstBuffer * buf, guint8 * data,
         hbuf = gst_buffer_new_and_alloc (len);
         gst_buffer_fill (hbuf, 0, data, len);
       } else {
-        hbuf = gst_buffer_copy (buf);
+        /* the packet may be written in place into the output buffer */
+        hbuf = gst_buffer_copy_deep (buf);
       }
       GST_LOG_OBJECT (mux,
           "Collecting packet with pid 0x%04x into streamheaders", pid);
@@ -958,115 +1162,284 @@ new_packet_common_init (GstBaseTsMux * mux, GstBuffer * buf, guint8 * data,
   }
 }
 
-static GstFlowReturn
-gst_base_ts_mux_push_packets (GstBaseTsMux * mux, gboolean force)
+static gint
+gst_base_ts_mux_get_alignment (GstBaseTsMux * mux)
 {
-  GstBufferList *buffer_list;
   gint align = mux->alignment;
-  gint av, packet_size;
-
-  packet_size = mux->packet_size;
 
   if (align < 0)
     align = mux->automatic_alignment;
 
-  av = gst_adapter_available (mux->out_adapter);
-  GST_LOG_OBJECT (mux, "align %d, av %d", align, av);
+  return align;
+}
 
-  if (av == 0)
-    return GST_FLOW_OK;
+static void
+gst_base_ts_mux_queue_out_buffer (GstBaseTsMux * mux)
+{
+  gst_buffer_unmap (mux->out_buffer, &mux->out_map);
 
-  /* no alignment, just push all available data */
-  if (align == 0) {
-    buffer_list = gst_adapter_take_buffer_list (mux->out_adapter, av);
-    return gst_aggregator_finish_buffer_list (GST_AGGREGATOR (mux),
-        buffer_list);
+  if (mux->out_list == NULL)
+    mux->out_list = gst_buffer_list_new ();
+
+  gst_buffer_list_add (mux->out_list, mux->out_buffer);
+  mux->out_buffer = NULL;
+  mux->out_offset = 0;
+}
+
+static void
+gst_base_ts_mux_start_out_buffer (GstBaseTsMux * mux, gsize size)
+{
+  mux->out_buffer = gst_base_ts_mux_acquire_buffer (mux, &mux->out_pool,
+      &mux->out_pool_size, size);
+  gst_buffer_map (mux->out_buffer, &mux->out_map, GST_MAP_WRITE);
+  mux->out_offset = 0;
+}
+
+/* Called when packets are output while the one handed out to be written in
+ * place is still pending, which would overwrite it. The pending packet
+ * keeps the current output buffer and the output continues in a copy of it.
+ * The packets are not output in the order they were allocated in, so stop
+ * writing them in place. */
+static void
+gst_base_ts_mux_release_out_slot (GstBaseTsMux * mux)
+{
+  GstBuffer *old_buffer;
+  GstMapInfo old_map;
+  gsize offset;
+
+  if (!gst_base_ts_mux_drop_out_slot (mux))
+    return;
+
+  GST_DEBUG_OBJECT (mux, "packets are output out of order, no longer "
+      "writing them in place");
+  mux->out_in_place = FALSE;
+
+  old_buffer = mux->out_buffer;
+  old_map = mux->out_map;
+  offset = mux->out_offset;
+
+  gst_base_ts_mux_start_out_buffer (mux, old_map.size);
+  gst_buffer_copy_into (mux->out_buffer, old_buffer,
+      GST_BUFFER_COPY_FLAGS | GST_BUFFER_COPY_TIMESTAMPS, 0, 0);
+  memcpy (mux->out_map.data, old_map.data, offset);
+  mux->out_offset = offset;
+
+  gst_buffer_unmap (old_buffer, &old_map);
+  /* the pending packet still writes into it, don't recycle it */
+  GST_BUFFER_FLAG_SET (old_buffer, GST_BUFFER_FLAG_TAG_MEMORY);
+  gst_buffer_unref (old_buffer);
+}
+
+/* Hands the output gathered for an alignment over to the adapter, after
+ * the alignment was changed to 0 */
+static void
+gst_base_ts_mux_flush_out_buffers (GstBaseTsMux * mux)
+{
+  guint i, len;
+
+  if (mux->out_list) {
+    len = gst_buffer_list_length (mux->out_list);
+    for (i = 0; i < len; i++)
+      gst_adapter_push (mux->out_adapter,
+          gst_buffer_ref (gst_buffer_list_get (mux->out_list, i)));
+
+    gst_buffer_list_unref (mux->out_list);
+    mux->out_list = NULL;
   }
 
-  align *= packet_size;
+  if (mux->out_buffer == NULL)
+    return;
+
+  /* a pending packet may still write into it, don't recycle it */
+  if (gst_base_ts_mux_drop_out_slot (mux))
+    GST_BUFFER_FLAG_SET (mux->out_buffer, GST_BUFFER_FLAG_TAG_MEMORY);
+  gst_buffer_unmap (mux->out_buffer, &mux->out_map);
 
-  if (!force && align > av)
+  if (mux->out_offset > 0) {
+    gst_buffer_set_size (mux->out_buffer, mux->out_offset);
+    gst_adapter_push (mux->out_adapter, mux->out_buffer);
+  } else {
+    gst_buffer_unref (mux->out_buffer);
+  }
+  mux->out_buffer = NULL;
+  mux->out_offset = 0;
+}
+
+/* Queues the output gathered in the adapter ahead of the aligned output,
+ * after the alignment was changed from 0 */
+static void
+gst_base_ts_mux_flush_adapter (GstBaseTsMux * mux)
+{
+  GstBufferList *list;
+  guint i, len;
+  gsize av = gst_adapter_available (mux->out_adapter);
+
+  if (av == 0)
+    return;
+
+  list = gst_adapter_take_buffer_list (mux->out_adapter, av);
+  if (mux->out_list == NULL)
+    mux->out_list = gst_buffer_list_new ();
+
+  len = gst_buffer_list_length (list);
+  for (i = 0; i < len; i++)
+    gst_buffer_list_add (mux->out_list,
+        gst_buffer_ref (gst_buffer_list_get (list, i)));
+
+  gst_buffer_list_unref (list);
+}
+
+static GstFlowReturn
+gst_base_ts_mux_collect_packet (GstBaseTsMux * mux, GstBuffer * buf)
+{
+  gint align = gst_base_ts_mux_get_alignment (mux);
+  gsize size = gst_buffer_get_size (buf);
+  GstMapInfo map;
+  gboolean in_place;
+
+  GST_LOG_OBJECT (mux, "collecting packet size %" G_GSIZE_FORMAT, size);
+
+  if (align == 0) {
+    gst_base_ts_mux_flush_out_buffers (mux);
+    gst_adapter_push (mux->out_adapter, buf);
     return GST_FLOW_OK;
+  }
 
-  buffer_list = gst_buffer_list_new_sized ((av / align) + 1);
+  gst_base_ts_mux_flush_adapter (mux);
 
-  GST_LOG_OBJECT (mux, "aligning to %d bytes", align);
-  while (align <= av) {
-    GstBuffer *buf;
-    GstClockTime pts;
+  if (!gst_buffer_map (buf, &map, GST_MAP_READ)) {
+    GST_ERROR_OBJECT (mux, "Failed to map packet");
+    gst_buffer_unref (buf);
+    mux->last_flow_ret = GST_FLOW_ERROR;
+    return GST_FLOW_ERROR;
+  }
 
-    pts = gst_adapter_prev_pts (mux->out_adapter, NULL);
-    buf = gst_adapter_take_buffer (mux->out_adapter, align);
+  /* Packets are written straight into a pooled buffer of the aligned size,
+   * in place if allocated there by gst_base_ts_mux_new_out_slot(), or
+   * copied instead of being gathered in an adapter otherwise */
+  in_place = mux->out_buffer != NULL
+      && map.data == mux->out_map.data + mux->out_offset;
+  if (in_place)
+    gst_base_ts_mux_drop_out_slot (mux);
+  else
+    gst_base_ts_mux_release_out_slot (mux);
 
-    GST_BUFFER_PTS (buf) = pts;
+  if (mux->out_buffer == NULL)
+    gst_base_ts_mux_start_out_buffer (mux, align * mux->packet_size);
 
-    gst_buffer_list_add (buffer_list, buf);
-    av -= align;
+  if (mux->out_offset + size > mux->out_map.size) {
+    GST_ERROR_OBJECT (mux, "Packet of %" G_GSIZE_FORMAT " bytes doesn't fit "
+        "into the %" G_GSIZE_FORMAT " bytes left in the output buffer", size,
+        mux->out_map.size - mux->out_offset);
+    gst_buffer_unmap (buf, &map);
+    gst_buffer_unref (buf);
+    mux->last_flow_ret = GST_FLOW_ERROR;
+    return GST_FLOW_ERROR;
   }
 
-  if (av > 0 && force) {
-    GstBuffer *buf;
-    GstClockTime pts;
-    guint8 *data;
-    guint32 header;
-    gint dummy;
-    GstMapInfo map;
+  if (mux->out_offset == 0)
+    gst_buffer_copy_into (mux->out_buffer, buf,
+        GST_BUFFER_COPY_FLAGS | GST_BUFFER_COPY_TIMESTAMPS, 0, 0);
+  if (!in_place)
+    memcpy (mux->out_map.data + mux->out_offset, map.data, size);
+  mux->out_offset += size;
 
-    GST_LOG_OBJECT (mux, "handling %d leftover bytes", av);
+  gst_buffer_unmap (buf, &map);
+  gst_buffer_unref (buf);
 
-    pts = gst_adapter_prev_pts (mux->out_adapter, NULL);
-    buf = gst_buffer_new_and_alloc (align);
+  if (mux->out_offset + mux->packet_size > mux->out_map.size)
+    gst_base_ts_mux_queue_out_buffer (mux);
 
-    GST_BUFFER_PTS (buf) = pts;
+  return GST_FLOW_OK;
+}
 
-    gst_buffer_map (buf, &map, GST_MAP_READ);
-    data = map.data;
+/* Pads the partially filled output buffer up to the alignment with null
+ * packets */
+static void
+gst_base_ts_mux_finish_out_buffer (GstBaseTsMux * mux)
+{
+  gsize packet_size = mux->packet_size;
+  guint8 *data;
+  guint32 header;
+  gint dummy;
 
-    gst_adapter_copy (mux->out_adapter, data, 0, av);
-    gst_adapter_clear (mux->out_adapter);
+  GST_LOG_OBJECT (mux, "handling %" G_GSIZE_FORMAT " leftover bytes",
+      mux->out_offset);
 
-    data += av;
-    header = GST_READ_UINT32_BE (data - packet_size);
+  data = mux->out_map.data + mux->out_offset;
+  header = GST_READ_UINT32_BE (data - packet_size);
 
-    dummy = (map.size - av) / packet_size;
-    GST_LOG_OBJECT (mux, "adding %d null packets", dummy);
+  dummy = (mux->out_map.size - mux->out_offset) / packet_size;
+  GST_LOG_OBJECT (mux, "adding %d null packets", dummy);
 
-    for (; dummy > 0; dummy--) {
-      gint offset;
+  for (; dummy > 0; dummy--) {
+    gint offset;
 
-      if (packet_size > GST_BASE_TS_MUX_NORMAL_PACKET_LENGTH) {
-        GST_WRITE_UINT32_BE (data, header);
-        /* simply increase header a bit and never mind too much */
-        header++;
-        offset = 4;
-      } else {
-        offset = 0;
-      }
-      GST_WRITE_UINT8 (data + offset, TSMUX_SYNC_BYTE);
-      /* null packet PID */
-      GST_WRITE_UINT16_BE (data + offset + 1, 0x1FFF);
-      /* no adaptation field exists | continuity counter undefined */
-      GST_WRITE_UINT8 (data + offset + 3, 0x10);
-      /* payload */
-      memset (data + offset + 4, 0, GST_BASE_TS_MUX_NORMAL_PACKET_LENGTH - 4);
-      data += packet_size;
+    if (packet_size > GST_BASE_TS_MUX_NORMAL_PACKET_LENGTH) {
+      GST_WRITE_UINT32_BE (data, header);
+      /* simply increase header a bit and never mind too much */
+      header++;
+      offset = 4;
+    } else {
+      offset = 0;
     }
-
-    gst_buffer_unmap (buf, &map);
-    gst_buffer_list_add (buffer_list, buf);
+    GST_WRITE_UINT8 (data + offset, TSMUX_SYNC_BYTE);
+    /* null packet PID */
+    GST_WRITE_UINT16_BE (data + offset + 1, 0x1FFF);
+    /* no adaptation field exists | continuity counter undefined */
+    GST_WRITE_UINT8 (data + offset + 3, 0x10);
+    /* payload */
+    memset (data + offset + 4, 0, GST_BASE_TS_MUX_NORMAL_PACKET_LENGTH - 4);
+    data += packet_size;
   }
 
-  return gst_aggregator_finish_buffer_list (GST_AGGREGATOR (mux), buffer_list);
+  mux->out_offset = mux->out_map.size;
 }
 
 static GstFlowReturn
-gst_base_ts_mux_collect_packet (GstBaseTsMux * mux, GstBuffer * buf)
+gst_base_ts_mux_push_packets (GstBaseTsMux * mux, gboolean force)
 {
-  GST_LOG_OBJECT (mux, "collecting packet size %" G_GSIZE_FORMAT,
-      gst_buffer_get_size (buf));
-  gst_adapter_push (mux->out_adapter, buf);
+  GstBufferList *buffer_list;
+  gint align = gst_base_ts_mux_get_alignment (mux);
 
-  return GST_FLOW_OK;
+  /* no alignment, just push all available data */
+  if (align == 0) {
+    gint av;
+
+    gst_base_ts_mux_flush_out_buffers (mux);
+    av = gst_adapter_available (mux->out_adapter);
+
+    GST_LOG_OBJECT (mux, "align %d, av %d", align, av);
+
+    if (av == 0)
+      return GST_FLOW_OK;
+
+    buffer_list = gst_adapter_take_buffer_list (mux->out_adapter, av);
+    return gst_aggregator_finish_buffer_list (GST_AGGREGATOR (mux),
+        buffer_list);
+  }
+
+  /* aligned output was written directly into the output buffers by
+   * gst_base_ts_mux_collect_packet(), only the last one may be partial */
+  gst_base_ts_mux_flush_adapter (mux);
+  if (force && mux->out_buffer) {
+    gst_base_ts_mux_release_out_slot (mux);
+    if (mux->out_offset > 0) {
+      gst_base_ts_mux_finish_out_buffer (mux);
+      gst_base_ts_mux_queue_out_buffer (mux);
+    }
+  }
+
+  if (mux->out_list == NULL)
+    return GST_FLOW_OK;
+
+  buffer_list = mux->out_list;
+  mux->out_list = NULL;
+
+  GST_LOG_OBJECT (mux, "pushing %u aligned buffers",
+      gst_buffer_list_length (buffer_list));
+
+  return gst_aggregator_finish_buffer_list (GST_AGGREGATOR (mux), buffer_list);
 }
 
 static GstEvent *
@@ -1377,6 +1750,7 @@ gst_base_ts_mux_aggregate_buffer (GstBaseTsMux * mux,
   /* ERRORS */
 write_fail:
   {
+    g_mutex_unlock (&mux->lock);
     return mux->last_flow_ret;
   }
 }
@@ -2053,6 +2427,7 @@ gst_base_ts_mux_sink_event (GstAggregator * agg, GstAggregatorPad * agg_pad,
     case GST_EVENT_TAG:{
       GstTagList *list;
       gchar *lang = NULL;
+      guint max_bitrate;
 
       GST_DEBUG_OBJECT (mux, "received tag event");
       gst_event_parse_tag (event, &list);
@@ -2074,6 +2449,18 @@ gst_base_ts_mux_sink_event (GstAggregator * agg, GstAggregatorPad * agg_pad,
         g_free (lang);
       }
 
+      if (gst_tag_list_get_uint (list, GST_TAG_MAXIMUM_BITRATE, &max_bitrate)
+          && max_bitrate) {
+        GST_DEBUG_OBJECT (ts_pad, "Setting maximum bitrate to %u",
+            max_bitrate);
+
+        g_mutex_lock (&mux->lock);
+        ts_pad->max_bitrate = max_bitrate;
+        if (ts_pad->stream)
+          ts_pad->stream->tstd_max_bitrate = max_bitrate;
+        g_mutex_unlock (&mux->lock);
+      }
+
       /* handled this, don't want collectpads to forward it downstream */
       res = TRUE;
       forward = gst_tag_list_get_scope (list) == GST_TAG_SCOPE_GLOBAL;
@@ -2622,24 +3009,74 @@ gst_base_ts_mux_default_create_ts_mux (GstBaseTsMux * mux)
   return tsmux;
 }
 
+typedef struct
+{
+  GstMemory *mem;
+  GstMapInfo map;
+} GstBaseTsMuxSlot;
+
 static void
-gst_base_ts_mux_default_allocate_packet (GstBaseTsMux * mux,
-    GstBuffer ** buffer)
+gst_base_ts_mux_slot_free (GstBaseTsMuxSlot * slot)
+{
+  gst_memory_unmap (slot->mem, &slot->map);
+  gst_memory_unref (slot->mem);
+  g_free (slot);
+}
+
+/* Returns a packet whose memory is the next packet of the aligned output
+ * buffer, for TsMux to write it in place, or NULL if it has to be copied
+ * there. Only one such packet is pending at a time, it keeps the memory of
+ * the output buffer mapped. */
+static GstBuffer *
+gst_base_ts_mux_new_out_slot (GstBaseTsMux * mux)
 {
+  gint align = gst_base_ts_mux_get_alignment (mux);
+  GstBaseTsMuxSlot *slot;
   GstBuffer *buf;
 
-  buf = gst_buffer_new_and_alloc (mux->packet_size);
+  if (align == 0 || !mux->out_in_place || mux->out_slot != NULL)
+    return NULL;
+
+  if (mux->out_buffer == NULL)
+    gst_base_ts_mux_start_out_buffer (mux, align * mux->packet_size);
+
+  if (gst_buffer_n_memory (mux->out_buffer) != 1
+      || mux->out_offset + mux->packet_size > mux->out_map.size)
+    return NULL;
 
-  *buffer = buf;
+  slot = g_new (GstBaseTsMuxSlot, 1);
+  slot->mem = gst_buffer_get_memory (mux->out_buffer, 0);
+  if (!gst_memory_map (slot->mem, &slot->map, GST_MAP_WRITE)) {
+    gst_memory_unref (slot->mem);
+    g_free (slot);
+    return NULL;
+  }
+
+  mux->out_slot = gst_memory_new_wrapped (0,
+      mux->out_map.data + mux->out_offset, mux->packet_size, 0,
+      mux->packet_size, slot, (GDestroyNotify) gst_base_ts_mux_slot_free);
+
+  buf = gst_buffer_new ();
+  gst_buffer_append_memory (buf, gst_memory_ref (mux->out_slot));
+
+  return buf;
+}
+
+static void
+gst_base_ts_mux_default_allocate_packet (GstBaseTsMux * mux,
+    GstBuffer ** buffer)
+{
+  *buffer = gst_base_ts_mux_new_out_slot (mux);
+  if (*buffer == NULL)
+    *buffer = gst_base_ts_mux_acquire_buffer (mux, &mux->packet_pool,
+        &mux->packet_pool_size, mux->packet_size);
 }
 
 static gboolean
 gst_base_ts_mux_default_output_packet (GstBaseTsMux * mux, GstBuffer * buffer,
     gint64 new_pcr)
 {
-  gst_base_ts_mux_collect_packet (mux, buffer);
-
-  return TRUE;
+  return gst_base_ts_mux_collect_packet (mux, buffer) == GST_FLOW_OK;
 }
 
 /* Subclass API */
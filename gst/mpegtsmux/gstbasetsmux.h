@@ -128,6 +128,8 @@ struct _GstBaseTsMuxPad
   TsMuxProgram *prog;
 
   gchar *language;
+  /* maximum bitrate from the tags, 0 if unknown */
+  guint max_bitrate;
 };
 
 struct _GstBaseTsMuxPadClass
@@ -186,6 +188,18 @@ struct GstBaseTsMux {
   /* output buffer aggregation */
   GstAdapter *out_adapter;
   GstBuffer *out_buffer;
+  GstMapInfo out_map;
+  gsize out_offset;
+  GstBufferList *out_list;
+  /* the packet handed out to be written in place at out_offset */
+  GstMemory *out_slot;
+  gboolean out_in_place;
+
+  /* recycled packet and aligned output buffers */
+  GstBufferPool *packet_pool;
+  gsize packet_pool_size;
+  GstBufferPool *out_pool;
+  gsize out_pool_size;
   GstClockTimeDiff output_ts_offset;
 
   /* protects the tsmux object, the programs hash table, and pad streams */
@@ -201,7 +215,10 @@ struct GstBaseTsMux {
  *                 @media_type (eg. video/x-h264).
  * @allocate_packet: Optional.
  *                 Called when the underlying #TsMux object needs a packet
- *                 to write into.
+ *                 to write into. With an alignment, the default
+ *                 implementation writes the packet in place into the output
+ *                 buffer as long as packets are output in the order they
+ *                 were allocated in.
  * @output_packet: Optional.
  *                 Called when the underlying #TsMux object has a packet
  *                 ready to output.
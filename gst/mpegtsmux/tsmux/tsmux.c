@@ -105,6 +105,7 @@ static gint64 get_next_pcr (TsMux * mux, gint64 cur_ts);
 static gint64 get_current_pcr (TsMux * mux, gint64 cur_ts);
 static gint64 write_new_pcr (TsMux * mux, TsMuxStream * stream, gint64 cur_pcr,
     gint64 next_pcr);
+static void tstd_add_packet (TsMux * mux, TsMuxStream * stream);
 static gboolean tsmux_write_ts_header (TsMux * mux, guint8 * buf,
     TsMuxPacketInfo * pi, guint stream_avail, guint * payload_len_out,
     guint * payload_offset_out);
@@ -657,6 +658,7 @@ tsmux_program_add_stream (TsMuxProgram * program, TsMuxStream * stream)
   }
 
   g_ptr_array_insert (streams, array_index, stream);
+  stream->program = program;
   program->pmt_changed = TRUE;
 }
 
@@ -793,6 +795,8 @@ tsmux_program_remove_stream (TsMuxProgram * program, TsMuxStream * stream)
     g_warn_if_reached ();
     return FALSE;
   }
+  if (stream->program == program)
+    stream->program = NULL;
 
   return streams->len == 0;
 }
@@ -887,6 +891,7 @@ tsmux_packet_out (TsMux * mux, GstBuffer * buf, gint64 pcr)
           stream->pi.flags &= TSMUX_PACKET_FLAG_PES_FULL_HEADER;
           if (!tsmux_packet_out (mux, pcr_buf, new_pcr))
             goto error;
+          tstd_add_packet (mux, stream);
         }
       }
     }
@@ -1466,85 +1471,175 @@ rewrite_si (TsMux * mux, gint64 cur_ts)
   return TRUE;
 }
 
+/* Leak rate of the T-STD transport buffer of @stream in bits per second,
+ * or 0 if it is unknown and the buffer should not be modelled */
+static guint64
+tstd_get_leak_rate (TsMuxStream * stream)
+{
+  if (stream->is_audio)
+    return TSMUX_TSTD_AUDIO_RX;
+
+  /* Rx = 1.2 * Rmax for video, Rmax is signalled or derived from the
+   * profile and level by the caller */
+  if (stream->is_video_stream && stream->tstd_max_bitrate)
+    return gst_util_uint64_scale_int (stream->tstd_max_bitrate, 6, 5);
+
+  return 0;
+}
+
+/* Leak the transport buffer of @stream up to the current multiplex
+ * position */
+static void
+tstd_update (TsMux * mux, TsMuxStream * stream)
+{
+  guint64 delta = mux->n_bytes - stream->tb_pos;
+  guint64 rate = tstd_get_leak_rate (stream);
+
+  /* A long gap at a high video leak rate would overflow, the buffer is
+   * empty by then anyway */
+  if (delta >= G_MAXUINT64 / rate || delta * rate >= stream->tb_level)
+    stream->tb_level = 0;
+  else
+    stream->tb_level -= delta * rate;
+  stream->tb_pos = mux->n_bytes;
+}
+
+/* Account a packet of @stream that was just written to the multiplex */
+static void
+tstd_add_packet (TsMux * mux, TsMuxStream * stream)
+{
+  if (!mux->bitrate || !tstd_get_leak_rate (stream))
+    return;
+
+  /* The packet entered the buffer at the multiplex rate while it was
+   * leaking, so the fullness at the end of the packet is exact */
+  tstd_update (mux, stream);
+  stream->tb_level += TSMUX_PACKET_LENGTH * mux->bitrate;
+
+  if (stream->tb_level > TSMUX_TSTD_TB_SIZE * mux->bitrate) {
+    GST_WARNING ("T-STD transport buffer overflow on PID 0x%04x",
+        stream->pi.pid);
+  }
+}
+
+/* Write a single stuffing packet: a PCR-only packet on @pcr_stream if one
+ * is due, or a null packet otherwise */
 static gboolean
-pad_stream (TsMux * mux, TsMuxStream * stream, gint64 cur_ts)
+write_stuffing_packet (TsMux * mux, TsMuxStream * pcr_stream, gint64 cur_ts)
 {
-  guint64 bitrate;
   GstBuffer *buf = NULL;
   GstMapInfo map;
-  gboolean ret = TRUE;
+  gint64 new_pcr = -1;
+
+  if (!tsmux_get_buffer (mux, &buf))
+    return FALSE;
+
+  if (!gst_buffer_map (buf, &map, GST_MAP_WRITE)) {
+    gst_buffer_unref (buf);
+    return FALSE;
+  }
+
+  if (pcr_stream)
+    new_pcr = write_new_pcr (mux, pcr_stream, get_current_pcr (mux, cur_ts),
+        get_next_pcr (mux, cur_ts));
+
+  if (new_pcr != -1) {
+    GST_LOG ("Writing PCR-only packet on PID 0x%04x", pcr_stream->pi.pid);
+    tsmux_write_ts_header (mux, map.data, &pcr_stream->pi, 0, NULL, NULL);
+    pcr_stream->pi.flags &= TSMUX_PACKET_FLAG_PES_FULL_HEADER;
+  } else {
+    GST_LOG ("Writing null stuffing packet");
+    if (!rewrite_si (mux, cur_ts)) {
+      gst_buffer_unmap (buf, &map);
+      gst_buffer_unref (buf);
+      return FALSE;
+    }
+    tsmux_write_null_ts_header (map.data);
+    memset (map.data + TSMUX_HEADER_LENGTH, 0xFF, TSMUX_PAYLOAD_LENGTH);
+  }
+
+  gst_buffer_unmap (buf, &map);
+
+  if (!tsmux_packet_out (mux, buf, new_pcr))
+    return FALSE;
+
+  if (new_pcr != -1)
+    tstd_add_packet (mux, pcr_stream);
+
+  return TRUE;
+}
+
+/* In CBR mode, stuff the multiplex until the transport buffer of @stream
+ * has room for another packet. The stuffing carries the PCR of the
+ * program of @stream when it's due, so a long wait doesn't starve the
+ * decoder of clock references */
+static gboolean
+tstd_wait_for_space (TsMux * mux, TsMuxStream * stream, gint64 cur_ts)
+{
+  TsMuxStream *pcr_stream;
+
+  if (!mux->bitrate || !tstd_get_leak_rate (stream))
+    return TRUE;
+
+  /* Stuffing needs a transport clock */
+  if (mux->first_pcr_ts == G_MININT64)
+    return TRUE;
+
+  pcr_stream = stream->program ? stream->program->pcr_stream : NULL;
+
+  tstd_update (mux, stream);
+  while (stream->tb_level + TSMUX_PACKET_LENGTH * mux->bitrate >
+      TSMUX_TSTD_TB_SIZE * mux->bitrate) {
+    GST_LOG ("Transport buffer of PID 0x%04x is full, stuffing",
+        stream->pi.pid);
+    if (!write_stuffing_packet (mux, pcr_stream, cur_ts))
+      return FALSE;
+    tstd_update (mux, stream);
+  }
+
+  return TRUE;
+}
+
+static gboolean
+pad_stream (TsMux * mux, TsMuxStream * stream, gint64 cur_ts)
+{
   GstClockTimeDiff diff;
-  guint64 start_n_bytes;
+  guint64 start_n_bytes, target_bytes;
 
   if (!mux->bitrate)
-    goto done;
+    return TRUE;
 
   if (!GST_CLOCK_STIME_IS_VALID (cur_ts))
-    goto done;
+    return TRUE;
 
   if (!GST_CLOCK_STIME_IS_VALID (stream->first_ts))
     stream->first_ts = cur_ts;
 
   diff = GST_CLOCK_DIFF (stream->first_ts, cur_ts);
-  if (diff == 0)
-    goto done;
-
-  ret = FALSE;
-  start_n_bytes = mux->n_bytes;
-  do {
-    GST_LOG ("Transport stream bitrate: %" G_GUINT64_FORMAT " over %"
-        G_GUINT64_FORMAT " bytes, duration %" GST_TIME_FORMAT,
-        gst_util_uint64_scale (mux->n_bytes * 8, TSMUX_CLOCK_FREQ, diff),
-        mux->n_bytes, GST_TIME_ARGS (diff * GST_SECOND / TSMUX_CLOCK_FREQ));
-
-    /* calculate what the overall bitrate will be if we add 1 more packet */
-    bitrate =
-        gst_util_uint64_scale ((mux->n_bytes + TSMUX_PACKET_LENGTH) * 8,
-        TSMUX_CLOCK_FREQ, diff);
-
-    if (bitrate <= mux->bitrate) {
-      gint64 new_pcr;
-
-      if (!tsmux_get_buffer (mux, &buf))
-        goto done;
-
-      if (!gst_buffer_map (buf, &map, GST_MAP_WRITE)) {
-        gst_buffer_unref (buf);
-        goto done;
-      }
+  if (diff <= 0)
+    return TRUE;
 
-      new_pcr = write_new_pcr (mux, stream, get_current_pcr (mux, cur_ts),
-          get_next_pcr (mux, cur_ts));
-      if (new_pcr != -1) {
-        GST_LOG ("Writing PCR-only packet on PID 0x%04x", stream->pi.pid);
-        tsmux_write_ts_header (mux, map.data, &stream->pi, 0, NULL, NULL);
-      } else {
-        GST_LOG ("Writing null stuffing packet");
-        if (!rewrite_si (mux, cur_ts)) {
-          gst_buffer_unmap (buf, &map);
-          gst_buffer_unref (buf);
-          goto done;
-        }
-        tsmux_write_null_ts_header (map.data);
-        memset (map.data + TSMUX_HEADER_LENGTH, 0xFF, TSMUX_PAYLOAD_LENGTH);
-      }
+  /* Number of bytes the transport clock has to have advanced by, stuff
+   * for as long as another packet still fits in there */
+  target_bytes = gst_util_uint64_scale (diff, mux->bitrate,
+      8 * TSMUX_CLOCK_FREQ);
 
-      gst_buffer_unmap (buf, &map);
+  GST_LOG ("Transport stream at %" G_GUINT64_FORMAT " bytes, target %"
+      G_GUINT64_FORMAT " bytes at duration %" GST_TIME_FORMAT,
+      mux->n_bytes, target_bytes,
+      GST_TIME_ARGS (diff * GST_SECOND / TSMUX_CLOCK_FREQ));
 
-      stream->pi.flags &= TSMUX_PACKET_FLAG_PES_FULL_HEADER;
-      if (!tsmux_packet_out (mux, buf, new_pcr))
-        goto done;
-    }
-  } while (bitrate < mux->bitrate);
+  start_n_bytes = mux->n_bytes;
+  while (mux->n_bytes + TSMUX_PACKET_LENGTH <= target_bytes) {
+    if (!write_stuffing_packet (mux, stream, cur_ts))
+      return FALSE;
+  }
 
   if (mux->n_bytes != start_n_bytes) {
     GST_LOG ("Finished padding the mux");
   }
 
-  ret = TRUE;
-
-done:
-  return ret;
+  return TRUE;
 }
 
 /**
@@ -1563,25 +1658,31 @@ tsmux_write_stream_packet (TsMux * mux, TsMuxStream * stream)
   TsMuxPacketInfo *pi = &stream->pi;
   gboolean res;
   gint64 new_pcr = -1;
+  gint64 cur_ts;
   GstBuffer *buf = NULL;
   GstMapInfo map;
 
   g_return_val_if_fail (mux != NULL, FALSE);
   g_return_val_if_fail (stream != NULL, FALSE);
 
-  if (tsmux_stream_is_pcr (stream)) {
-    gint64 cur_ts = CLOCK_BASE;
-    if (tsmux_stream_get_dts (stream) != G_MININT64)
-      cur_ts += tsmux_stream_get_dts (stream);
-    else
-      cur_ts += tsmux_stream_get_pts (stream);
+  cur_ts = CLOCK_BASE;
+  if (tsmux_stream_get_dts (stream) != G_MININT64)
+    cur_ts += tsmux_stream_get_dts (stream);
+  else
+    cur_ts += tsmux_stream_get_pts (stream);
 
+  if (tsmux_stream_is_pcr (stream)) {
     if (!rewrite_si (mux, cur_ts))
       goto fail;
 
     if (!pad_stream (mux, stream, cur_ts))
       goto fail;
+  }
 
+  if (!tstd_wait_for_space (mux, stream, cur_ts))
+    goto fail;
+
+  if (tsmux_stream_is_pcr (stream)) {
     new_pcr =
         write_new_pcr (mux, stream, get_current_pcr (mux, cur_ts),
         get_next_pcr (mux, cur_ts));
@@ -1594,6 +1695,22 @@ tsmux_write_stream_packet (TsMux * mux, TsMuxStream * stream)
       stream->dts += CLOCK_BASE;
     if (stream->pts != G_MININT64)
       stream->pts += CLOCK_BASE;
+
+    /* In CBR mode the transport clock is known, check that the PES still
+     * arrives in time for decoding */
+    if (mux->bitrate && mux->first_pcr_ts != G_MININT64) {
+      gint64 decode_ts = stream->dts != G_MININT64 ? stream->dts : stream->pts;
+
+      if (decode_ts != G_MININT64) {
+        gint64 cur_pcr = get_current_pcr (mux, decode_ts);
+
+        if (cur_pcr > decode_ts * 300) {
+          GST_WARNING ("PES on PID 0x%04x delivered %f ms after its decode "
+              "time, bitrate too low?", pi->pid,
+              (double) (cur_pcr - decode_ts * 300) / 27000.0);
+        }
+      }
+    }
   }
   pi->stream_avail = tsmux_stream_bytes_avail (stream);
 
@@ -1615,6 +1732,8 @@ tsmux_write_stream_packet (TsMux * mux, TsMuxStream * stream)
 
   GST_DEBUG ("Writing PES of size %d", (int) gst_buffer_get_size (buf));
   res = tsmux_packet_out (mux, buf, new_pcr);
+  if (res)
+    tstd_add_packet (mux, stream);
 
   /* Reset all dynamic flags */
   stream->pi.flags &= TSMUX_PACKET_FLAG_PES_FULL_HEADER;
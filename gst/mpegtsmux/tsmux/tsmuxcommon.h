@@ -112,6 +112,11 @@ G_BEGIN_DECLS
 /* Bitrate (bits per second) */
 #define TSMUX_DEFAULT_BITRATE      0
 
+/* T-STD transport buffer size in bytes (ISO/IEC 13818-1 2.4.2.3) */
+#define TSMUX_TSTD_TB_SIZE 512
+/* T-STD transport buffer leak rate for audio streams (bits per second) */
+#define TSMUX_TSTD_AUDIO_RX 2000000
+
 typedef struct TsMuxPacketInfo TsMuxPacketInfo;
 typedef struct TsMuxProgram TsMuxProgram;
 typedef struct TsMuxStream TsMuxStream;
@@ -196,6 +196,18 @@ struct TsMuxStream {
   /* Next time PCR should be written */
   gint64 next_pcr;
 
+  /* program this stream was added to */
+  TsMuxProgram *program;
+
+  /* Rmax of the video T-STD in bits per second, 0 if unknown */
+  guint64 tstd_max_bitrate;
+
+  /* T-STD transport buffer model in CBR mode: fullness in bytes scaled
+   * by the multiplex bitrate, and the multiplex byte position it was last
+   * updated at */
+  guint64 tb_level;
+  guint64 tb_pos;
+
   /* audio parameters for stream
    * (used in stream descriptor) */
   gint audio_sampling;
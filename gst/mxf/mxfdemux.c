@@ -55,6 +55,9 @@
 #include "mxfessence.h"
 
 #include <string.h>
+#include <glib/gstdio.h>
+#include <gst/base/gstbytereader.h>
+#include <gst/base/gstbytewriter.h>
 
 static GstStaticPadTemplate mxf_sink_template = GST_STATIC_PAD_TEMPLATE ("sink",
     GST_PAD_SINK,
@@ -92,6 +95,11 @@ static gboolean find_entry_for_offset (GstMXFDemux * demux,
     GstMXFDemuxEssenceTrack * etrack, guint64 offset,
     GstMXFDemuxIndex * retentry);
 
+static gboolean gst_mxf_demux_load_index_cache (GstMXFDemux * demux);
+static void gst_mxf_demux_save_index_cache (GstMXFDemux * demux);
+static void gst_mxf_demux_adopt_cached_offsets (GstMXFDemux * demux,
+    GstMXFDemuxEssenceTrack * etrack);
+
 GType gst_mxf_demux_pad_get_type (void);
 G_DEFINE_TYPE (GstMXFDemuxPad, gst_mxf_demux_pad, GST_TYPE_PAD);
 
@@ -130,7 +138,8 @@ enum
   PROP_0,
   PROP_PACKAGE,
   PROP_MAX_DRIFT,
-  PROP_STRUCTURE
+  PROP_STRUCTURE,
+  PROP_INDEX_CACHE_DIR
 };
 
 static gboolean gst_mxf_demux_sink_event (GstPad * pad, GstObject * parent,
@@ -186,6 +195,23 @@ gst_mxf_demux_essence_track_free (GstMXFDemuxEssenceTrack * t)
   g_free (t);
 }
 
+/* Track offsets loaded from the index cache, until the track they belong to
+ * is created */
+typedef struct
+{
+  guint32 body_sid;
+  guint32 track_number;
+  GArray *offsets;
+} GstMXFDemuxCachedOffsets;
+
+static void
+gst_mxf_demux_cached_offsets_free (GstMXFDemuxCachedOffsets * c)
+{
+  if (c->offsets)
+    g_array_free (c->offsets, TRUE);
+  g_free (c);
+}
+
 static void
 gst_mxf_demux_reset_mxf_state (GstMXFDemux * demux)
 {
@@ -313,6 +339,13 @@ gst_mxf_demux_reset (GstMXFDemux * demux)
 
   demux->index_table_segments_collected = FALSE;
 
+  g_free (demux->index_cache_path);
+  demux->index_cache_path = NULL;
+  demux->index_cache_n_entries = 0;
+  g_list_free_full (demux->cached_track_offsets,
+      (GDestroyNotify) gst_mxf_demux_cached_offsets_free);
+  demux->cached_track_offsets = NULL;
+
   gst_mxf_demux_reset_mxf_state (demux);
   gst_mxf_demux_reset_metadata (demux);
 
@@ -901,6 +934,7 @@ gst_mxf_demux_update_essence_tracks (GstMXFDemux * demux)
         etrack =
             g_ptr_array_index (demux->essence_tracks,
             demux->essence_tracks->len - 1);
+        gst_mxf_demux_adopt_cached_offsets (demux, etrack);
         new = TRUE;
       }
 
@@ -3502,6 +3536,526 @@ gst_mxf_demux_consume_klv (GstMXFDemux * demux, GstMXFKLV * klv)
     demux->offset += klv->data_offset + klv->length;
 }
 
+/* Index cache
+ *
+ * In pull mode the RIP, all partition packs and the index table segments
+ * they point to are read before seeking is accurate, and the track offsets
+ * of files without index tables are only discovered while playing. For
+ * large files on network storage this takes a long time, so all of it can
+ * be stored in a sidecar file in the index-cache-dir, named after the path,
+ * size and modification time of the file.
+ *
+ * All values are little-endian:
+ *   magic "GSTMXFIX", version (u32), file size (u64), mtime (i64),
+ *   run-in (u64), footer partition pack offset (u64)
+ *   RIP: count (u32), then body_sid (u32) and offset (u64) per entry
+ *   partitions: count (u32), then per partition type (u8), closed (u8),
+ *     complete (u8), kag_size (u32), this/prev/footer partition (u64),
+ *     header/index byte count (u64), index_sid (u32), body_offset (u64),
+ *     body_sid (u32) and essence container offset (u64)
+ *   index table segments: count (u32), then per segment its size (u32) and
+ *     its KLV as stored in MXF files
+ *   track offsets: count (u32), then per track body_sid (u32), track_number
+ *     (u32), number of entries (u32) and per entry offset, pts, dts,
+ *     duration, size (u64) and keyframe (u8)
+ */
+#define INDEX_CACHE_MAGIC "GSTMXFIX"
+#define INDEX_CACHE_VERSION 1
+#define INDEX_CACHE_PARTITION_SIZE (3 + 4 + 8 * 5 + 4 + 8 + 4 + 8)
+#define INDEX_CACHE_ENTRY_SIZE (8 * 5 + 1)
+
+/* Figures out the sidecar path for the file upstream, if any */
+static gboolean
+gst_mxf_demux_index_cache_setup (GstMXFDemux * demux)
+{
+  GstQuery *query;
+  gchar *uri = NULL, *filename, *key, *checksum, *name;
+  GStatBuf st;
+
+  g_free (demux->index_cache_path);
+  demux->index_cache_path = NULL;
+
+  if (!demux->index_cache_dir)
+    return FALSE;
+
+  query = gst_query_new_uri ();
+  if (gst_pad_peer_query (demux->sinkpad, query))
+    gst_query_parse_uri (query, &uri);
+  gst_query_unref (query);
+
+  if (!uri) {
+    GST_DEBUG_OBJECT (demux, "Upstream has no URI, not caching the index");
+    return FALSE;
+  }
+
+  filename = g_filename_from_uri (uri, NULL, NULL);
+  if (!filename || g_stat (filename, &st) != 0) {
+    GST_DEBUG_OBJECT (demux, "Not caching the index of non-local file %s", uri);
+    g_free (filename);
+    g_free (uri);
+    return FALSE;
+  }
+  g_free (uri);
+
+  demux->index_cache_file_size = st.st_size;
+  demux->index_cache_file_mtime = st.st_mtime;
+
+  key = g_strdup_printf ("%s:%" G_GUINT64_FORMAT ":%" G_GINT64_FORMAT,
+      filename, demux->index_cache_file_size, demux->index_cache_file_mtime);
+  checksum = g_compute_checksum_for_string (G_CHECKSUM_SHA1, key, -1);
+  name = g_strconcat (checksum, ".mxfindex", NULL);
+  demux->index_cache_path =
+      g_build_filename (demux->index_cache_dir, name, NULL);
+
+  GST_DEBUG_OBJECT (demux, "Index cache of %s is %s", filename,
+      demux->index_cache_path);
+
+  g_free (name);
+  g_free (checksum);
+  g_free (key);
+  g_free (filename);
+
+  return TRUE;
+}
+
+static gboolean
+gst_mxf_demux_parse_index_cache (GstMXFDemux * demux, GstByteReader * reader)
+{
+  const guint8 *magic;
+  guint32 version, n, i, j;
+  guint64 cached_size, run_in, footer_partition_pack_offset;
+  gint64 cached_mtime;
+  GArray *rip = NULL;
+  GList *partitions = NULL, *segments = NULL, *tracks = NULL;
+  guint n_entries = 0;
+
+  if (!gst_byte_reader_get_data (reader, 8, &magic)
+      || memcmp (magic, INDEX_CACHE_MAGIC, 8) != 0
+      || !gst_byte_reader_get_uint32_le (reader, &version)
+      || version != INDEX_CACHE_VERSION)
+    return FALSE;
+
+  if (!gst_byte_reader_get_uint64_le (reader, &cached_size)
+      || !gst_byte_reader_get_int64_le (reader, &cached_mtime)
+      || !gst_byte_reader_get_uint64_le (reader, &run_in)
+      || !gst_byte_reader_get_uint64_le (reader, &footer_partition_pack_offset))
+    return FALSE;
+
+  if (cached_size != demux->index_cache_file_size
+      || cached_mtime != demux->index_cache_file_mtime
+      || run_in != demux->run_in) {
+    GST_DEBUG_OBJECT (demux, "Index cache is for a different file");
+    return FALSE;
+  }
+
+  /* Random index pack */
+  if (!gst_byte_reader_get_uint32_le (reader, &n)
+      || gst_byte_reader_get_remaining (reader) < (guint64) n * 12)
+    goto error;
+
+  if (n > 0) {
+    rip = g_array_sized_new (FALSE, FALSE, sizeof (MXFRandomIndexPackEntry), n);
+    g_array_set_size (rip, n);
+    for (i = 0; i < n; i++) {
+      MXFRandomIndexPackEntry *e =
+          &g_array_index (rip, MXFRandomIndexPackEntry, i);
+
+      e->body_sid = gst_byte_reader_get_uint32_le_unchecked (reader);
+      e->offset = gst_byte_reader_get_uint64_le_unchecked (reader);
+    }
+  }
+
+  /* Partitions, to be parsed again when they're reached but good enough to
+   * locate essence until then */
+  if (!gst_byte_reader_get_uint32_le (reader, &n)
+      || gst_byte_reader_get_remaining (reader) <
+      (guint64) n * INDEX_CACHE_PARTITION_SIZE)
+    goto error;
+
+  for (i = 0; i < n; i++) {
+    GstMXFDemuxPartition *p = g_new0 (GstMXFDemuxPartition, 1);
+
+    p->partition.type = gst_byte_reader_get_uint8_unchecked (reader);
+    p->partition.closed = gst_byte_reader_get_uint8_unchecked (reader);
+    p->partition.complete = gst_byte_reader_get_uint8_unchecked (reader);
+    p->partition.kag_size = gst_byte_reader_get_uint32_le_unchecked (reader);
+    p->partition.this_partition =
+        gst_byte_reader_get_uint64_le_unchecked (reader);
+    p->partition.prev_partition =
+        gst_byte_reader_get_uint64_le_unchecked (reader);
+    p->partition.footer_partition =
+        gst_byte_reader_get_uint64_le_unchecked (reader);
+    p->partition.header_byte_count =
+        gst_byte_reader_get_uint64_le_unchecked (reader);
+    p->partition.index_byte_count =
+        gst_byte_reader_get_uint64_le_unchecked (reader);
+    p->partition.index_sid = gst_byte_reader_get_uint32_le_unchecked (reader);
+    p->partition.body_offset = gst_byte_reader_get_uint64_le_unchecked (reader);
+    p->partition.body_sid = gst_byte_reader_get_uint32_le_unchecked (reader);
+    p->essence_container_offset =
+        gst_byte_reader_get_uint64_le_unchecked (reader);
+
+    partitions = g_list_prepend (partitions, p);
+  }
+  partitions = g_list_sort (partitions,
+      (GCompareFunc) gst_mxf_demux_partition_compare);
+  n_entries += n;
+
+  /* Index table segments */
+  if (!gst_byte_reader_get_uint32_le (reader, &n))
+    goto error;
+
+  for (i = 0; i < n; i++) {
+    MXFIndexTableSegment *segment;
+    const guint8 *data;
+    guint32 size, header_size;
+
+    if (!gst_byte_reader_get_uint32_le (reader, &size)
+        || size < 17 || !gst_byte_reader_get_data (reader, size, &data)
+        || !mxf_is_index_table_segment ((const MXFUL *) data))
+      goto error;
+
+    /* Key and BER length */
+    header_size = 17;
+    if (data[16] & 0x80)
+      header_size += data[16] & 0x7f;
+    if (header_size > size)
+      goto error;
+
+    segment = g_new0 (MXFIndexTableSegment, 1);
+    if (!mxf_index_table_segment_parse ((const MXFUL *) data, segment,
+            data + header_size, size - header_size)) {
+      g_free (segment);
+      goto error;
+    }
+    segments = g_list_prepend (segments, segment);
+  }
+  segments = g_list_sort (segments,
+      (GCompareFunc) compare_index_table_segment);
+  n_entries += n;
+
+  /* Track offsets */
+  if (!gst_byte_reader_get_uint32_le (reader, &n))
+    goto error;
+
+  for (i = 0; i < n; i++) {
+    GstMXFDemuxCachedOffsets *c;
+    guint32 body_sid, track_number, n_offsets;
+
+    if (!gst_byte_reader_get_uint32_le (reader, &body_sid)
+        || !gst_byte_reader_get_uint32_le (reader, &track_number)
+        || !gst_byte_reader_get_uint32_le (reader, &n_offsets)
+        || gst_byte_reader_get_remaining (reader) <
+        (guint64) n_offsets * INDEX_CACHE_ENTRY_SIZE)
+      goto error;
+
+    c = g_new0 (GstMXFDemuxCachedOffsets, 1);
+    c->body_sid = body_sid;
+    c->track_number = track_number;
+    c->offsets = g_array_sized_new (FALSE, TRUE, sizeof (GstMXFDemuxIndex),
+        n_offsets);
+    g_array_set_size (c->offsets, n_offsets);
+    for (j = 0; j < n_offsets; j++) {
+      GstMXFDemuxIndex *e = &g_array_index (c->offsets, GstMXFDemuxIndex, j);
+
+      e->offset = gst_byte_reader_get_uint64_le_unchecked (reader);
+      e->pts = gst_byte_reader_get_uint64_le_unchecked (reader);
+      e->dts = gst_byte_reader_get_uint64_le_unchecked (reader);
+      e->duration = gst_byte_reader_get_uint64_le_unchecked (reader);
+      e->size = gst_byte_reader_get_uint64_le_unchecked (reader);
+      e->keyframe = gst_byte_reader_get_uint8_unchecked (reader);
+      e->initialized = TRUE;
+    }
+    tracks = g_list_prepend (tracks, c);
+    n_entries += n_offsets;
+  }
+
+  GST_DEBUG_OBJECT (demux, "Loaded %u partitions, %u index table segments "
+      "and %u track offset tables from the index cache",
+      g_list_length (partitions), g_list_length (segments),
+      g_list_length (tracks));
+
+  demux->partitions = partitions;
+  demux->footer_partition_pack_offset = footer_partition_pack_offset;
+
+  /* Collect without the RIP, which would make it read all partitions
+   * headers again */
+  demux->pending_index_table_segments = segments;
+  collect_index_table_segments (demux);
+  demux->index_table_segments_collected = TRUE;
+  demux->random_index_pack = rip;
+
+  demux->cached_track_offsets = tracks;
+  demux->index_cache_n_entries = n_entries;
+
+  return TRUE;
+
+error:
+  if (rip)
+    g_array_free (rip, TRUE);
+  g_list_free_full (partitions, (GDestroyNotify) gst_mxf_demux_partition_free);
+  for (; segments; segments = g_list_delete_link (segments, segments)) {
+    mxf_index_table_segment_reset (segments->data);
+    g_free (segments->data);
+  }
+  g_list_free_full (tracks, (GDestroyNotify) gst_mxf_demux_cached_offsets_free);
+
+  GST_WARNING_OBJECT (demux, "Ignoring corrupted index cache %s",
+      demux->index_cache_path);
+
+  return FALSE;
+}
+
+/* Loads the partitions, index table segments and track offsets of the file
+ * from the cache. Returns FALSE if they have to be read from the file */
+static gboolean
+gst_mxf_demux_load_index_cache (GstMXFDemux * demux)
+{
+  GMappedFile *file;
+  GstByteReader reader;
+  GError *err = NULL;
+  gboolean ret;
+
+  /* Only before anything was read from the file */
+  if (demux->partitions || demux->random_index_pack)
+    return FALSE;
+
+  if (!gst_mxf_demux_index_cache_setup (demux))
+    return FALSE;
+
+  file = g_mapped_file_new (demux->index_cache_path, FALSE, &err);
+  if (!file) {
+    GST_DEBUG_OBJECT (demux, "No index cache: %s", err->message);
+    g_clear_error (&err);
+    return FALSE;
+  }
+
+  gst_byte_reader_init (&reader,
+      (const guint8 *) g_mapped_file_get_contents (file),
+      g_mapped_file_get_length (file));
+  ret = gst_mxf_demux_parse_index_cache (demux, &reader);
+  g_mapped_file_unref (file);
+
+  return ret;
+}
+
+static void
+gst_mxf_demux_adopt_cached_offsets (GstMXFDemux * demux,
+    GstMXFDemuxEssenceTrack * etrack)
+{
+  GList *l;
+
+  for (l = demux->cached_track_offsets; l; l = l->next) {
+    GstMXFDemuxCachedOffsets *c = l->data;
+
+    if (c->body_sid != etrack->body_sid
+        || c->track_number != etrack->track_number)
+      continue;
+
+    if (!etrack->offsets) {
+      GST_DEBUG_OBJECT (demux, "Using %u cached offsets for track 0x%08x",
+          c->offsets->len, etrack->track_number);
+      etrack->offsets = c->offsets;
+      c->offsets = NULL;
+    }
+
+    gst_mxf_demux_cached_offsets_free (c);
+    demux->cached_track_offsets =
+        g_list_delete_link (demux->cached_track_offsets, l);
+    break;
+  }
+}
+
+static void
+gst_mxf_demux_write_track_offsets (GstByteWriter * bw, guint32 body_sid,
+    guint32 track_number, GArray * offsets)
+{
+  guint i;
+
+  gst_byte_writer_put_uint32_le (bw, body_sid);
+  gst_byte_writer_put_uint32_le (bw, track_number);
+  gst_byte_writer_put_uint32_le (bw, offsets->len);
+  gst_byte_writer_ensure_free_space (bw,
+      offsets->len * INDEX_CACHE_ENTRY_SIZE);
+  for (i = 0; i < offsets->len; i++) {
+    GstMXFDemuxIndex *e = &g_array_index (offsets, GstMXFDemuxIndex, i);
+
+    gst_byte_writer_put_uint64_le_unchecked (bw, e->offset);
+    gst_byte_writer_put_uint64_le_unchecked (bw, e->pts);
+    gst_byte_writer_put_uint64_le_unchecked (bw, e->dts);
+    gst_byte_writer_put_uint64_le_unchecked (bw, e->duration);
+    gst_byte_writer_put_uint64_le_unchecked (bw, e->size);
+    gst_byte_writer_put_uint8_unchecked (bw, e->keyframe);
+  }
+}
+
+/* Writes everything we know about the file to the cache, unless nothing was
+ * discovered since it was loaded or last written */
+static void
+gst_mxf_demux_save_index_cache (GstMXFDemux * demux)
+{
+  GstByteWriter bw;
+  GList *l;
+  guint i, n, n_segments = 0, n_tracks = 0, n_entries;
+  guint64 file_size = demux->index_cache_file_size;
+  gint64 file_mtime = demux->index_cache_file_mtime;
+  gchar *dirname;
+  GError *err = NULL;
+  guint size;
+  guint8 *data;
+
+  if (!demux->index_cache_path)
+    return;
+
+  n_entries = g_list_length (demux->partitions);
+  for (l = demux->index_tables; l; l = l->next) {
+    GstMXFDemuxIndexTable *t = l->data;
+
+    n_segments += t->segments->len;
+  }
+  n_entries += n_segments;
+  for (i = 0; i < demux->essence_tracks->len; i++) {
+    GstMXFDemuxEssenceTrack *etrack =
+        g_ptr_array_index (demux->essence_tracks, i);
+
+    if (etrack->offsets && etrack->offsets->len) {
+      n_entries += etrack->offsets->len;
+      n_tracks++;
+    }
+  }
+  for (l = demux->cached_track_offsets; l; l = l->next) {
+    GstMXFDemuxCachedOffsets *c = l->data;
+
+    n_entries += c->offsets->len;
+    n_tracks++;
+  }
+
+  if (n_entries == demux->index_cache_n_entries) {
+    GST_LOG_OBJECT (demux, "Index cache is up to date");
+    return;
+  }
+
+  /* Make sure the file didn't change while we were reading it */
+  if (!gst_mxf_demux_index_cache_setup (demux)
+      || file_size != demux->index_cache_file_size
+      || file_mtime != demux->index_cache_file_mtime) {
+    GST_DEBUG_OBJECT (demux, "File changed, not caching its index");
+    return;
+  }
+
+  gst_byte_writer_init_with_size (&bw, 4096, FALSE);
+
+  gst_byte_writer_put_data (&bw, (const guint8 *) INDEX_CACHE_MAGIC, 8);
+  gst_byte_writer_put_uint32_le (&bw, INDEX_CACHE_VERSION);
+  gst_byte_writer_put_uint64_le (&bw, file_size);
+  gst_byte_writer_put_int64_le (&bw, file_mtime);
+  gst_byte_writer_put_uint64_le (&bw, demux->run_in);
+  gst_byte_writer_put_uint64_le (&bw, demux->footer_partition_pack_offset);
+
+  n = demux->random_index_pack ? demux->random_index_pack->len : 0;
+  gst_byte_writer_put_uint32_le (&bw, n);
+  for (i = 0; i < n; i++) {
+    MXFRandomIndexPackEntry *e =
+        &g_array_index (demux->random_index_pack, MXFRandomIndexPackEntry, i);
+
+    gst_byte_writer_put_uint32_le (&bw, e->body_sid);
+    gst_byte_writer_put_uint64_le (&bw, e->offset);
+  }
+
+  gst_byte_writer_put_uint32_le (&bw, g_list_length (demux->partitions));
+  for (l = demux->partitions; l; l = l->next) {
+    GstMXFDemuxPartition *p = l->data;
+    guint64 essence_container_offset = p->essence_container_offset;
+
+    /* Store the offset of the KLV for clip wrapped essence, it gets updated
+     * again once the track is known */
+    if (p->single_track
+        && p->single_track->wrapping != MXF_ESSENCE_WRAPPING_FRAME_WRAPPING
+        && essence_container_offset >= p->clip_klv.data_offset)
+      essence_container_offset -= p->clip_klv.data_offset;
+
+    gst_byte_writer_put_uint8 (&bw, p->partition.type);
+    gst_byte_writer_put_uint8 (&bw, p->partition.closed);
+    gst_byte_writer_put_uint8 (&bw, p->partition.complete);
+    gst_byte_writer_put_uint32_le (&bw, p->partition.kag_size);
+    gst_byte_writer_put_uint64_le (&bw, p->partition.this_partition);
+    gst_byte_writer_put_uint64_le (&bw, p->partition.prev_partition);
+    gst_byte_writer_put_uint64_le (&bw, p->partition.footer_partition);
+    gst_byte_writer_put_uint64_le (&bw, p->partition.header_byte_count);
+    gst_byte_writer_put_uint64_le (&bw, p->partition.index_byte_count);
+    gst_byte_writer_put_uint32_le (&bw, p->partition.index_sid);
+    gst_byte_writer_put_uint64_le (&bw, p->partition.body_offset);
+    gst_byte_writer_put_uint32_le (&bw, p->partition.body_sid);
+    gst_byte_writer_put_uint64_le (&bw, essence_container_offset);
+  }
+
+  gst_byte_writer_put_uint32_le (&bw, n_segments);
+  for (l = demux->index_tables; l; l = l->next) {
+    GstMXFDemuxIndexTable *t = l->data;
+
+    for (i = 0; i < t->segments->len; i++) {
+      MXFIndexTableSegment *s =
+          &g_array_index (t->segments, MXFIndexTableSegment, i);
+      GstBuffer *buffer;
+      GstMapInfo map;
+
+      /* Same limits as mxf_index_table_segment_to_buffer(), the local set
+       * lengths are 16 bit */
+      if (s->n_delta_entries * 6 >= G_MAXUINT16
+          || s->n_index_entries * (11 + 4 * s->slice_count +
+              8 * s->pos_table_count) >= G_MAXUINT16) {
+        GST_WARNING_OBJECT (demux, "Can't cache oversized index table segment");
+        goto oversized;
+      }
+
+      buffer = mxf_index_table_segment_to_buffer (s);
+      gst_buffer_map (buffer, &map, GST_MAP_READ);
+      gst_byte_writer_put_uint32_le (&bw, map.size);
+      gst_byte_writer_put_data (&bw, map.data, map.size);
+      gst_buffer_unmap (buffer, &map);
+      gst_buffer_unref (buffer);
+    }
+  }
+
+  gst_byte_writer_put_uint32_le (&bw, n_tracks);
+  for (i = 0; i < demux->essence_tracks->len; i++) {
+    GstMXFDemuxEssenceTrack *etrack =
+        g_ptr_array_index (demux->essence_tracks, i);
+
+    if (etrack->offsets && etrack->offsets->len)
+      gst_mxf_demux_write_track_offsets (&bw, etrack->body_sid,
+          etrack->track_number, etrack->offsets);
+  }
+  for (l = demux->cached_track_offsets; l; l = l->next) {
+    GstMXFDemuxCachedOffsets *c = l->data;
+
+    gst_mxf_demux_write_track_offsets (&bw, c->body_sid, c->track_number,
+        c->offsets);
+  }
+
+  dirname = g_path_get_dirname (demux->index_cache_path);
+  g_mkdir_with_parents (dirname, 0755);
+  g_free (dirname);
+
+  size = gst_byte_writer_get_pos (&bw);
+  data = gst_byte_writer_reset_and_get_data (&bw);
+  if (g_file_set_contents (demux->index_cache_path, (const gchar *) data, size,
+          &err)) {
+    GST_DEBUG_OBJECT (demux, "Wrote %u bytes of index cache to %s", size,
+        demux->index_cache_path);
+    demux->index_cache_n_entries = n_entries;
+  } else {
+    GST_WARNING_OBJECT (demux, "Failed to write index cache: %s",
+        err->message);
+    g_clear_error (&err);
+  }
+  g_free (data);
+  return;
+
+oversized:
+  gst_byte_writer_reset (&bw);
+}
+
 static void
 gst_mxf_demux_pull_random_index_pack (GstMXFDemux * demux)
 {
@@ -4318,8 +4872,12 @@ gst_mxf_demux_loop (GstPad * pad)
       goto pause;
     }
 
-    /* Grab the RIP at the end of the file (if present) */
-    gst_mxf_demux_pull_random_index_pack (demux);
+    /* Grab the RIP at the end of the file (if present) and the partitions
+     * and index table segments it points to, unless they're cached */
+    if (!gst_mxf_demux_load_index_cache (demux)) {
+      gst_mxf_demux_pull_random_index_pack (demux);
+      gst_mxf_demux_save_index_cache (demux);
+    }
   }
 
   /* Now actually do something */
@@ -5868,6 +6426,7 @@ gst_mxf_demux_change_state (GstElement * element, GstStateChange transition)
 
   switch (transition) {
     case GST_STATE_CHANGE_PAUSED_TO_READY:
+      gst_mxf_demux_save_index_cache (demux);
       gst_mxf_demux_reset (demux);
       break;
     default:
@@ -5891,6 +6450,10 @@ gst_mxf_demux_set_property (GObject * object, guint prop_id,
     case PROP_MAX_DRIFT:
       demux->max_drift = g_value_get_uint64 (value);
       break;
+    case PROP_INDEX_CACHE_DIR:
+      g_free (demux->index_cache_dir);
+      demux->index_cache_dir = g_value_dup_string (value);
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
       break;
@@ -5929,6 +6492,9 @@ gst_mxf_demux_get_property (GObject * object, guint prop_id,
       g_rw_lock_reader_unlock (&demux->metadata_lock);
       break;
     }
+    case PROP_INDEX_CACHE_DIR:
+      g_value_set_string (value, demux->index_cache_dir);
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
       break;
@@ -5961,6 +6527,8 @@ gst_mxf_demux_finalize (GObject * object)
   demux->current_package_string = NULL;
   g_free (demux->requested_package_string);
   demux->requested_package_string = NULL;
+  g_free (demux->index_cache_dir);
+  demux->index_cache_dir = NULL;
 
   g_ptr_array_free (demux->src, TRUE);
   demux->src = NULL;
@@ -6004,6 +6572,20 @@ gst_mxf_demux_class_init (GstMXFDemuxClass * klass)
           "Structural metadata of the MXF file",
           GST_TYPE_STRUCTURE, G_PARAM_READABLE | G_PARAM_STATIC_STRINGS));
 
+  /**
+   * GstMXFDemux:index-cache-dir:
+   *
+   * Directory in which the partition table and index of every file opened
+   * in pull mode are cached. Subsequent opens of the same, unmodified file
+   * then don't need to read all partitions before being able to seek.
+   *
+   * Since: 1.24
+   */
+  g_object_class_install_property (gobject_class, PROP_INDEX_CACHE_DIR,
+      g_param_spec_string ("index-cache-dir", "Index cache directory",
+          "Directory to cache file indexes in (NULL = disabled)", NULL,
+          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
   gstelement_class->change_state =
       GST_DEBUG_FUNCPTR (gst_mxf_demux_change_state);
   gstelement_class->query = GST_DEBUG_FUNCPTR (gst_mxf_demux_query);
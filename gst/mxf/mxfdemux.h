@@ -290,9 +290,17 @@ struct _GstMXFDemux
 
   GstTagList *tags;
 
+  /* Index cache, see gst_mxf_demux_load_index_cache() */
+  gchar *index_cache_path;
+  guint64 index_cache_file_size;
+  gint64 index_cache_file_mtime;
+  guint index_cache_n_entries;
+  GList *cached_track_offsets;
+
   /* Properties */
   gchar *requested_package_string;
   GstClockTime max_drift;
+  gchar *index_cache_dir;
 
   /* Quirks */
   gboolean temporal_order_misuse;
@@ -66,6 +66,11 @@ enum
   PROP_MAX_KBPS,
   PROP_MAX_BUCKET_SIZE,
   PROP_ALLOW_REORDERING,
+  PROP_LINK_KBPS,
+  PROP_LINK_QUEUE_SIZE,
+  PROP_BURST_ENTER_PROBABILITY,
+  PROP_BURST_EXIT_PROBABILITY,
+  PROP_BURST_DROP_PROBABILITY,
 };
 
 /* these numbers are nothing but wild guesses and don't reflect any reality */
@@ -79,6 +84,11 @@ enum
 #define DEFAULT_MAX_KBPS -1
 #define DEFAULT_MAX_BUCKET_SIZE -1
 #define DEFAULT_ALLOW_REORDERING TRUE
+#define DEFAULT_LINK_KBPS -1
+#define DEFAULT_LINK_QUEUE_SIZE -1
+#define DEFAULT_BURST_ENTER_PROBABILITY 0.0
+#define DEFAULT_BURST_EXIT_PROBABILITY 0.5
+#define DEFAULT_BURST_DROP_PROBABILITY 1.0
 
 static GstStaticPadTemplate gst_net_sim_sink_template =
 GST_STATIC_PAD_TEMPLATE ("sink",
@@ -96,57 +106,217 @@ G_DEFINE_TYPE (GstNetSim, gst_net_sim, GST_TYPE_ELEMENT);
 GST_ELEMENT_REGISTER_DEFINE (netsim, "netsim",
     GST_RANK_MARGINAL, GST_TYPE_NET_SIM);
 
-static gboolean
-gst_net_sim_source_dispatch (GSource * source,
-    GSourceFunc callback, gpointer user_data)
+typedef struct
+{
+  GstClockTime time;
+  /* keeps packets due at the same time in order */
+  guint64 seqnum;
+  /* a buffer or a serialized event */
+  GstMiniObject *obj;
+} NetSimPacket;
+
+#define PACKET_IS_BEFORE(a, b) ((a)->time < (b)->time || \
+    ((a)->time == (b)->time && (a)->seqnum < (b)->seqnum))
+
+static void
+net_sim_packets_push (GArray * packets, const NetSimPacket * packet)
 {
-  callback (user_data);
-  return FALSE;
+  NetSimPacket *p, tmp;
+  guint i, parent;
+
+  g_array_append_vals (packets, packet, 1);
+  p = (NetSimPacket *) packets->data;
+
+  for (i = packets->len - 1; i > 0; i = parent) {
+    parent = (i - 1) / 2;
+    if (!PACKET_IS_BEFORE (&p[i], &p[parent]))
+      break;
+    tmp = p[i];
+    p[i] = p[parent];
+    p[parent] = tmp;
+  }
 }
 
-GSourceFuncs gst_net_sim_source_funcs = {
-  NULL,                         /* prepare */
-  NULL,                         /* check */
-  gst_net_sim_source_dispatch,
-  NULL                          /* finalize */
-};
+static void
+net_sim_packets_pop (GArray * packets, NetSimPacket * packet)
+{
+  NetSimPacket *p = (NetSimPacket *) packets->data, tmp;
+  guint i, child, n;
+
+  *packet = p[0];
+  n = packets->len - 1;
+  p[0] = p[n];
+  g_array_set_size (packets, n);
+
+  for (i = 0; (child = 2 * i + 1) < n; i = child) {
+    if (child + 1 < n && PACKET_IS_BEFORE (&p[child + 1], &p[child]))
+      child++;
+    if (!PACKET_IS_BEFORE (&p[child], &p[i]))
+      break;
+    tmp = p[i];
+    p[i] = p[child];
+    p[child] = tmp;
+  }
+}
 
 static void
-gst_net_sim_loop (GstNetSim * netsim)
+net_sim_packets_clear (GArray * packets)
+{
+  guint i;
+
+  for (i = 0; i < packets->len; i++)
+    gst_mini_object_unref (g_array_index (packets, NetSimPacket, i).obj);
+  g_array_set_size (packets, 0);
+}
+
+/* Called with loop_mutex, once the task doesn't push anymore */
+static void
+gst_net_sim_reset (GstNetSim * netsim)
 {
-  GMainLoop *loop;
+  net_sim_packets_clear (netsim->packets);
+  netsim->link_busy_until = 0;
+  netsim->last_ready_time = 0;
+  netsim->latest_time = 0;
+  netsim->n_events = 0;
+  netsim->event_time = 0;
+  netsim->n_pushing = 0;
+}
 
-  GST_TRACE_OBJECT (netsim, "TASK: begin");
+/* The pipeline clock, or the system clock until we have one */
+static GstClock *
+gst_net_sim_get_clock (GstNetSim * netsim)
+{
+  GstClock *clock = gst_element_get_clock (GST_ELEMENT_CAST (netsim));
+
+  if (clock == NULL)
+    clock = gst_system_clock_obtain ();
+  return clock;
+}
+
+/* Pushes the packets that are due from the srcpad task, or waits on the
+ * clock for the next one */
+static void
+gst_net_sim_loop (GstNetSim * netsim)
+{
+  GQueue due = G_QUEUE_INIT;
+  NetSimPacket packet;
+  GstClock *clock;
+  GstClockID id;
+  GstClockTime now;
+  GstMiniObject *obj;
+  GstFlowReturn ret = GST_FLOW_OK;
+  guint n_events = 0, n_buffers = 0;
 
   g_mutex_lock (&netsim->loop_mutex);
-  loop = g_main_loop_ref (netsim->main_loop);
-  netsim->running = TRUE;
-  GST_TRACE_OBJECT (netsim, "TASK: signal start");
-  g_cond_signal (&netsim->start_cond);
+  while (netsim->running && g_queue_is_empty (&due)) {
+    if (netsim->packets->len == 0) {
+      g_cond_wait (&netsim->cond, &netsim->loop_mutex);
+      continue;
+    }
+
+    clock = gst_net_sim_get_clock (netsim);
+    now = gst_clock_get_time (clock);
+
+    while (netsim->packets->len > 0 &&
+        g_array_index (netsim->packets, NetSimPacket, 0).time <= now) {
+      net_sim_packets_pop (netsim->packets, &packet);
+      g_queue_push_tail (&due, packet.obj);
+    }
+    netsim->n_pushing = due.length;
+
+    if (g_queue_is_empty (&due)) {
+      /* woken up early if an earlier packet comes in */
+      id = gst_clock_new_single_shot_id (clock,
+          g_array_index (netsim->packets, NetSimPacket, 0).time);
+      netsim->clock_id = id;
+      g_mutex_unlock (&netsim->loop_mutex);
+      gst_clock_id_wait (id, NULL);
+      g_mutex_lock (&netsim->loop_mutex);
+      netsim->clock_id = NULL;
+      gst_clock_id_unref (id);
+    }
+    gst_object_unref (clock);
+  }
+
+  if (!netsim->running) {
+    GST_TRACE_OBJECT (netsim, "TASK: pause");
+    gst_pad_pause_task (netsim->srcpad);
+  }
   g_mutex_unlock (&netsim->loop_mutex);
 
-  GST_TRACE_OBJECT (netsim, "TASK: run");
-  g_main_loop_run (loop);
-  g_main_loop_unref (loop);
+  GST_LOG_OBJECT (netsim, "Pushing %u delayed packets", due.length);
+  while ((obj = g_queue_pop_head (&due))) {
+    if (GST_IS_EVENT (obj)) {
+      gst_pad_push_event (netsim->srcpad, GST_EVENT_CAST (obj));
+      n_events++;
+    } else {
+      ret = gst_pad_push (netsim->srcpad, GST_BUFFER_CAST (obj));
+      n_buffers++;
+    }
+  }
+
+  if (n_events > 0 || n_buffers > 0) {
+    g_mutex_lock (&netsim->loop_mutex);
+    netsim->n_pushing = 0;
+    netsim->n_events -= n_events;
+    if (n_buffers > 0)
+      netsim->last_ret = ret;
+    g_mutex_unlock (&netsim->loop_mutex);
+  }
+}
+
+/* Called with loop_mutex, wakes up the task if the packet is the next one
+ * to push */
+static void
+gst_net_sim_queue_packet (GstNetSim * netsim, GstClockTime time,
+    GstMiniObject * obj)
+{
+  NetSimPacket packet;
+
+  packet.time = time;
+  packet.seqnum = netsim->packet_seqnum++;
+  packet.obj = obj;
+  net_sim_packets_push (netsim->packets, &packet);
+  netsim->latest_time = MAX (netsim->latest_time, time);
+
+  /* the task waits for a later packet, wake it up to wait for this one */
+  if (g_array_index (netsim->packets, NetSimPacket, 0).seqnum ==
+      packet.seqnum && netsim->clock_id)
+    gst_clock_id_unschedule (netsim->clock_id);
+  g_cond_signal (&netsim->cond);
+}
+
+static gboolean
+gst_net_sim_start_task (GstNetSim * netsim)
+{
+  gboolean result;
 
   g_mutex_lock (&netsim->loop_mutex);
-  GST_TRACE_OBJECT (netsim, "TASK: pause");
-  gst_pad_pause_task (netsim->srcpad);
-  netsim->running = FALSE;
-  GST_TRACE_OBJECT (netsim, "TASK: signal end");
-  g_cond_signal (&netsim->start_cond);
+  netsim->running = TRUE;
+  netsim->last_ret = GST_FLOW_OK;
   g_mutex_unlock (&netsim->loop_mutex);
-  GST_TRACE_OBJECT (netsim, "TASK: end");
+
+  GST_TRACE_OBJECT (netsim, "Starting task on srcpad");
+  result = gst_pad_start_task (netsim->srcpad,
+      (GstTaskFunction) gst_net_sim_loop, netsim, NULL);
+  if (!result) {
+    g_mutex_lock (&netsim->loop_mutex);
+    netsim->running = FALSE;
+    g_mutex_unlock (&netsim->loop_mutex);
+  }
+
+  return result;
 }
 
-static gboolean
-_main_loop_quit_and_remove_source (gpointer user_data)
+static void
+gst_net_sim_stop_running (GstNetSim * netsim)
 {
-  GMainLoop *main_loop = user_data;
-  GST_DEBUG ("MAINLOOP: Quit %p", main_loop);
-  g_main_loop_quit (main_loop);
-  g_assert (!g_main_loop_is_running (main_loop));
-  return FALSE;                 /* Remove source */
+  g_mutex_lock (&netsim->loop_mutex);
+  netsim->running = FALSE;
+  if (netsim->clock_id)
+    gst_clock_id_unschedule (netsim->clock_id);
+  g_cond_signal (&netsim->cond);
+  g_mutex_unlock (&netsim->loop_mutex);
 }
 
 static gboolean
@@ -154,90 +324,75 @@ gst_net_sim_src_activatemode (GstPad * pad, GstObject * parent,
     GstPadMode mode, gboolean active)
 {
   GstNetSim *netsim = GST_NET_SIM (parent);
-  gboolean result = FALSE;
+  gboolean result = TRUE;
 
-  g_mutex_lock (&netsim->loop_mutex);
   if (active) {
-    if (netsim->main_loop == NULL) {
-      GMainContext *main_context = g_main_context_new ();
-      netsim->main_loop = g_main_loop_new (main_context, FALSE);
-      g_main_context_unref (main_context);
-
-      GST_TRACE_OBJECT (netsim, "ACT: Starting task on srcpad");
-      result = gst_pad_start_task (netsim->srcpad,
-          (GstTaskFunction) gst_net_sim_loop, netsim, NULL);
-
-      GST_TRACE_OBJECT (netsim, "ACT: Wait for task to start");
-      g_assert (!netsim->running);
-      while (!netsim->running)
-        g_cond_wait (&netsim->start_cond, &netsim->loop_mutex);
-      GST_TRACE_OBJECT (netsim, "ACT: Task on srcpad started");
-    }
+    result = gst_net_sim_start_task (netsim);
   } else {
-    if (netsim->main_loop != NULL) {
-      GSource *source;
-      guint id;
-
-      /* Adds an Idle Source which quits the main loop from within.
-       * This removes the possibility for run/quit race conditions. */
-      GST_TRACE_OBJECT (netsim, "DEACT: Stopping main loop on deactivate");
-      source = g_idle_source_new ();
-      g_source_set_callback (source, _main_loop_quit_and_remove_source,
-          g_main_loop_ref (netsim->main_loop),
-          (GDestroyNotify) g_main_loop_unref);
-      id = g_source_attach (source,
-          g_main_loop_get_context (netsim->main_loop));
-      g_source_unref (source);
-      g_assert_cmpuint (id, >, 0);
-      g_main_loop_unref (netsim->main_loop);
-      netsim->main_loop = NULL;
-
-      GST_TRACE_OBJECT (netsim, "DEACT: Wait for mainloop and task to pause");
-      g_assert (netsim->running);
-      while (netsim->running)
-        g_cond_wait (&netsim->start_cond, &netsim->loop_mutex);
-
-      GST_TRACE_OBJECT (netsim, "DEACT: Stopping task on srcpad");
-      result = gst_pad_stop_task (netsim->srcpad);
-      GST_TRACE_OBJECT (netsim, "DEACT: Mainloop and GstTask stopped");
-    }
+    gst_net_sim_stop_running (netsim);
+
+    GST_TRACE_OBJECT (netsim, "DEACT: Stopping task on srcpad");
+    result = gst_pad_stop_task (netsim->srcpad);
+
+    /* the task is gone, nothing pushes these anymore */
+    g_mutex_lock (&netsim->loop_mutex);
+    gst_net_sim_reset (netsim);
+    g_mutex_unlock (&netsim->loop_mutex);
+    GST_TRACE_OBJECT (netsim, "DEACT: Task stopped");
   }
-  g_mutex_unlock (&netsim->loop_mutex);
 
   return result;
 }
 
-typedef struct
-{
-  GstPad *pad;
-  GstBuffer *buf;
-} PushBufferCtx;
-
-static inline PushBufferCtx *
-push_buffer_ctx_new (GstPad * pad, GstBuffer * buf)
+static GstClockTime
+rebase_time (GstClockTime time, GstClockTimeDiff offset)
 {
-  PushBufferCtx *ctx = g_slice_new (PushBufferCtx);
-  ctx->pad = gst_object_ref (pad);
-  ctx->buf = gst_buffer_ref (buf);
-  return ctx;
+  if (offset < 0 && time < (GstClockTime) - offset)
+    return 0;
+  return time + offset;
 }
 
-static inline void
-push_buffer_ctx_free (PushBufferCtx * ctx)
+/* Moves the packets waiting for the old clock to the same distance from
+ * now on the new one */
+static gboolean
+gst_net_sim_set_clock (GstElement * element, GstClock * clock)
 {
-  if (G_LIKELY (ctx != NULL)) {
-    gst_buffer_unref (ctx->buf);
-    gst_object_unref (ctx->pad);
-    g_slice_free (PushBufferCtx, ctx);
+  GstNetSim *netsim = GST_NET_SIM (element);
+  GstClock *old_clock, *new_clock;
+  GstClockTimeDiff offset;
+  gboolean ret;
+  guint i;
+
+  g_mutex_lock (&netsim->loop_mutex);
+  old_clock = gst_net_sim_get_clock (netsim);
+  ret = GST_ELEMENT_CLASS (gst_net_sim_parent_class)->set_clock (element,
+      clock);
+  new_clock = gst_net_sim_get_clock (netsim);
+
+  if (old_clock != new_clock) {
+    offset = GST_CLOCK_DIFF (gst_clock_get_time (old_clock),
+        gst_clock_get_time (new_clock));
+    GST_DEBUG_OBJECT (netsim, "Clock changed, moving %u packets by %"
+        GST_STIME_FORMAT, netsim->packets->len, GST_STIME_ARGS (offset));
+
+    /* the same offset for all keeps the heap ordered */
+    for (i = 0; i < netsim->packets->len; i++) {
+      NetSimPacket *packet = &g_array_index (netsim->packets, NetSimPacket, i);
+      packet->time = rebase_time (packet->time, offset);
+    }
+    netsim->link_busy_until = rebase_time (netsim->link_busy_until, offset);
+    netsim->last_ready_time = rebase_time (netsim->last_ready_time, offset);
+    netsim->latest_time = rebase_time (netsim->latest_time, offset);
+    netsim->event_time = rebase_time (netsim->event_time, offset);
+    if (netsim->clock_id)
+      gst_clock_id_unschedule (netsim->clock_id);
   }
-}
+  g_mutex_unlock (&netsim->loop_mutex);
 
-static gboolean
-push_buffer_ctx_push (PushBufferCtx * ctx)
-{
-  GST_DEBUG_OBJECT (ctx->pad, "Pushing buffer now");
-  gst_pad_push (ctx->pad, gst_buffer_ref (ctx->buf));
-  return FALSE;
+  gst_object_unref (old_clock);
+  gst_object_unref (new_clock);
+
+  return ret;
 }
 
 static gint
@@ -328,65 +483,176 @@ get_random_value_gamma (GRand * rand_seed, gint32 low, gint32 high,
   return round (x + low);
 }
 
+static gint
+gst_net_sim_get_delay (GstNetSim * netsim)
+{
+  gint delay;
+
+  switch (netsim->delay_distribution) {
+    case DISTRIBUTION_UNIFORM:
+      delay = get_random_value_uniform (netsim->rand_seed, netsim->min_delay,
+          netsim->max_delay);
+      break;
+    case DISTRIBUTION_NORMAL:
+      delay = get_random_value_normal (netsim->rand_seed, netsim->min_delay,
+          netsim->max_delay, &netsim->delay_state);
+      break;
+    case DISTRIBUTION_GAMMA:
+      delay = get_random_value_gamma (netsim->rand_seed, netsim->min_delay,
+          netsim->max_delay, &netsim->delay_state);
+      break;
+    default:
+      g_assert_not_reached ();
+      break;
+  }
+
+  return MAX (delay, 0);
+}
+
+/* Sends the buffer over the simulated link: it waits behind the bytes
+ * already queued, takes the time its size needs at link-kbps, and is
+ * tail-dropped when the queue is full. Returns the time it has been sent
+ * at, or GST_CLOCK_TIME_NONE when dropped. */
+static GstClockTime
+gst_net_sim_link_send (GstNetSim * netsim, GstBuffer * buf, GstClockTime now)
+{
+  guint64 bits_per_sec = (guint64) netsim->link_kbps * 1000;
+  gsize size = gst_buffer_get_size (buf);
+  GstClockTime start;
+  guint64 queued;
+
+  start = MAX (now, netsim->link_busy_until);
+  queued = gst_util_uint64_scale (start - now, bits_per_sec, 8 * GST_SECOND);
+
+  if (netsim->link_queue_size >= 0 &&
+      queued + size > (guint64) netsim->link_queue_size) {
+    GST_DEBUG_OBJECT (netsim, "Link queue full (%" G_GUINT64_FORMAT
+        " bytes queued), dropping packet of %" G_GSIZE_FORMAT " bytes",
+        queued, size);
+    return GST_CLOCK_TIME_NONE;
+  }
+
+  netsim->link_busy_until = start +
+      gst_util_uint64_scale (size * 8, GST_SECOND, bits_per_sec);
+  GST_LOG_OBJECT (netsim, "Packet of %" G_GSIZE_FORMAT " bytes sent at %"
+      GST_TIME_FORMAT, size, GST_TIME_ARGS (netsim->link_busy_until));
+
+  return netsim->link_busy_until;
+}
+
 static GstFlowReturn
 gst_net_sim_delay_buffer (GstNetSim * netsim, GstBuffer * buf)
 {
-  GstFlowReturn ret = GST_FLOW_OK;
+  GstClock *clock;
+  GstClockTime now, ready_time;
+  GstFlowReturn ret;
+  gboolean delayed, running;
 
   g_mutex_lock (&netsim->loop_mutex);
-  if (netsim->main_loop != NULL && netsim->delay_probability > 0 &&
-      g_rand_double (netsim->rand_seed) < netsim->delay_probability) {
-    gint delay;
-    PushBufferCtx *ctx;
-    GSource *source;
-    gint64 ready_time, now_time;
-
-    switch (netsim->delay_distribution) {
-      case DISTRIBUTION_UNIFORM:
-        delay = get_random_value_uniform (netsim->rand_seed, netsim->min_delay,
-            netsim->max_delay);
-        break;
-      case DISTRIBUTION_NORMAL:
-        delay = get_random_value_normal (netsim->rand_seed, netsim->min_delay,
-            netsim->max_delay, &netsim->delay_state);
-        break;
-      case DISTRIBUTION_GAMMA:
-        delay = get_random_value_gamma (netsim->rand_seed, netsim->min_delay,
-            netsim->max_delay, &netsim->delay_state);
-        break;
-      default:
-        g_assert_not_reached ();
-        break;
+  delayed = netsim->delay_probability > 0 &&
+      g_rand_double (netsim->rand_seed) < netsim->delay_probability;
+
+  /* packets that aren't delayed still wait for the events before them */
+  running = netsim->running;
+  if (!running || (!delayed && netsim->link_kbps <= 0
+          && netsim->n_events == 0)) {
+    g_mutex_unlock (&netsim->loop_mutex);
+    ret = gst_pad_push (netsim->srcpad, gst_buffer_ref (buf));
+    if (running) {
+      g_mutex_lock (&netsim->loop_mutex);
+      netsim->last_ret = ret;
+      g_mutex_unlock (&netsim->loop_mutex);
     }
+    return ret;
+  }
+
+  clock = gst_net_sim_get_clock (netsim);
+  now = gst_clock_get_time (clock);
+  gst_object_unref (clock);
 
-    if (delay < 0)
-      delay = 0;
+  ready_time = now;
+  if (netsim->link_kbps > 0) {
+    ready_time = gst_net_sim_link_send (netsim, buf, now);
+    if (ready_time == GST_CLOCK_TIME_NONE)
+      goto done;
+  }
 
-    ctx = push_buffer_ctx_new (netsim->srcpad, buf);
+  if (delayed)
+    ready_time += gst_net_sim_get_delay (netsim) * GST_MSECOND;
+  if (netsim->n_events > 0)
+    ready_time = MAX (ready_time, netsim->event_time);
 
-    source = g_source_new (&gst_net_sim_source_funcs, sizeof (GSource));
-    now_time = g_get_monotonic_time ();
-    ready_time = now_time + delay * 1000;
-    if (!netsim->allow_reordering && ready_time < netsim->last_ready_time)
-      ready_time = netsim->last_ready_time + 1;
+  /* packets with the same time go out in the order they came in */
+  if (!netsim->allow_reordering && ready_time < netsim->last_ready_time)
+    ready_time = netsim->last_ready_time;
+  netsim->last_ready_time = ready_time;
 
-    netsim->last_ready_time = ready_time;
-    GST_DEBUG_OBJECT (netsim, "Delaying packet by %" G_GINT64_FORMAT "ms",
-        (ready_time - now_time) / 1000);
+  GST_DEBUG_OBJECT (netsim, "Delaying packet by %" GST_TIME_FORMAT
+      " (%u packets waiting)", GST_TIME_ARGS (ready_time - now),
+      netsim->packets->len);
 
-    g_source_set_ready_time (source, ready_time);
-    g_source_set_callback (source, (GSourceFunc) push_buffer_ctx_push,
-        ctx, (GDestroyNotify) push_buffer_ctx_free);
-    g_source_attach (source, g_main_loop_get_context (netsim->main_loop));
-    g_source_unref (source);
-  } else {
-    ret = gst_pad_push (netsim->srcpad, gst_buffer_ref (buf));
-  }
+  gst_net_sim_queue_packet (netsim, ready_time,
+      GST_MINI_OBJECT_CAST (gst_buffer_ref (buf)));
+
+done:
+  /* what downstream returned for the packets pushed so far */
+  ret = netsim->last_ret;
   g_mutex_unlock (&netsim->loop_mutex);
 
   return ret;
 }
 
+static gboolean
+gst_net_sim_sink_event (GstPad * pad, GstObject * parent, GstEvent * event)
+{
+  GstNetSim *netsim = GST_NET_SIM (parent);
+  gboolean ret = TRUE;
+
+  switch (GST_EVENT_TYPE (event)) {
+    case GST_EVENT_FLUSH_START:
+      gst_net_sim_stop_running (netsim);
+      ret = gst_pad_push_event (netsim->srcpad, event);
+
+      /* the packets in flight are lost */
+      gst_pad_pause_task (netsim->srcpad);
+      g_mutex_lock (&netsim->loop_mutex);
+      GST_DEBUG_OBJECT (netsim, "Flushing %u packets", netsim->packets->len);
+      gst_net_sim_reset (netsim);
+      g_mutex_unlock (&netsim->loop_mutex);
+      break;
+    case GST_EVENT_FLUSH_STOP:
+      ret = gst_pad_push_event (netsim->srcpad, event);
+      if (gst_pad_is_active (netsim->srcpad))
+        gst_net_sim_start_task (netsim);
+      break;
+    default:
+      if (!GST_EVENT_IS_SERIALIZED (event)) {
+        ret = gst_pad_event_default (pad, parent, event);
+        break;
+      }
+
+      /* serialized events go out after the packets that came before them */
+      g_mutex_lock (&netsim->loop_mutex);
+      if (!netsim->running || (netsim->packets->len == 0 &&
+              netsim->n_pushing == 0)) {
+        g_mutex_unlock (&netsim->loop_mutex);
+        ret = gst_pad_event_default (pad, parent, event);
+        break;
+      }
+
+      GST_DEBUG_OBJECT (netsim, "Queueing %" GST_PTR_FORMAT " behind %u "
+          "packets", event, netsim->packets->len + netsim->n_pushing);
+      netsim->n_events++;
+      netsim->event_time = netsim->latest_time;
+      gst_net_sim_queue_packet (netsim, netsim->event_time,
+          GST_MINI_OBJECT_CAST (event));
+      g_mutex_unlock (&netsim->loop_mutex);
+      break;
+  }
+
+  return ret;
+}
+
 static gint
 gst_net_sim_get_tokens (GstNetSim * netsim)
 {
@@ -475,17 +741,34 @@ gst_net_sim_chain (GstPad * pad, GstObject * parent, GstBuffer * buf)
 {
   GstNetSim *netsim = GST_NET_SIM (parent);
   GstFlowReturn ret = GST_FLOW_OK;
+  gfloat drop_probability;
 
   if (!gst_net_sim_token_bucket (netsim, buf))
     goto done;
 
+  /* Gilbert-Elliott: the loss rate depends on whether the link is in a
+   * burst, which it enters and leaves after every packet */
+  drop_probability = netsim->in_burst ? netsim->burst_drop_probability :
+      netsim->drop_probability;
+  if (netsim->burst_enter_probability > 0) {
+    gfloat p = netsim->in_burst ? netsim->burst_exit_probability :
+        netsim->burst_enter_probability;
+
+    if (g_rand_double (netsim->rand_seed) < (gdouble) p) {
+      netsim->in_burst = !netsim->in_burst;
+      GST_LOG_OBJECT (netsim, "%s loss burst",
+          netsim->in_burst ? "Entering" : "Leaving");
+    }
+  } else {
+    netsim->in_burst = FALSE;
+  }
+
   if (netsim->drop_packets > 0) {
     netsim->drop_packets--;
     GST_DEBUG_OBJECT (netsim, "Dropping packet (%d left)",
         netsim->drop_packets);
-  } else if (netsim->drop_probability > 0
-      && g_rand_double (netsim->rand_seed) <
-      (gdouble) netsim->drop_probability) {
+  } else if (drop_probability > 0
+      && g_rand_double (netsim->rand_seed) < (gdouble) drop_probability) {
     GST_DEBUG_OBJECT (netsim, "Dropping packet");
   } else if (netsim->duplicate_probability > 0 &&
       g_rand_double (netsim->rand_seed) <
@@ -542,6 +825,21 @@ gst_net_sim_set_property (GObject * object,
     case PROP_ALLOW_REORDERING:
       netsim->allow_reordering = g_value_get_boolean (value);
       break;
+    case PROP_LINK_KBPS:
+      netsim->link_kbps = g_value_get_int (value);
+      break;
+    case PROP_LINK_QUEUE_SIZE:
+      netsim->link_queue_size = g_value_get_int (value);
+      break;
+    case PROP_BURST_ENTER_PROBABILITY:
+      netsim->burst_enter_probability = g_value_get_float (value);
+      break;
+    case PROP_BURST_EXIT_PROBABILITY:
+      netsim->burst_exit_probability = g_value_get_float (value);
+      break;
+    case PROP_BURST_DROP_PROBABILITY:
+      netsim->burst_drop_probability = g_value_get_float (value);
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
       break;
@@ -585,6 +883,21 @@ gst_net_sim_get_property (GObject * object,
     case PROP_ALLOW_REORDERING:
       g_value_set_boolean (value, netsim->allow_reordering);
       break;
+    case PROP_LINK_KBPS:
+      g_value_set_int (value, netsim->link_kbps);
+      break;
+    case PROP_LINK_QUEUE_SIZE:
+      g_value_set_int (value, netsim->link_queue_size);
+      break;
+    case PROP_BURST_ENTER_PROBABILITY:
+      g_value_set_float (value, netsim->burst_enter_probability);
+      break;
+    case PROP_BURST_EXIT_PROBABILITY:
+      g_value_set_float (value, netsim->burst_exit_probability);
+      break;
+    case PROP_BURST_DROP_PROBABILITY:
+      g_value_set_float (value, netsim->burst_drop_probability);
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
       break;
@@ -604,16 +917,18 @@ gst_net_sim_init (GstNetSim * netsim)
   gst_element_add_pad (GST_ELEMENT (netsim), netsim->sinkpad);
 
   g_mutex_init (&netsim->loop_mutex);
-  g_cond_init (&netsim->start_cond);
+  g_cond_init (&netsim->cond);
   netsim->rand_seed = g_rand_new ();
-  netsim->main_loop = NULL;
   netsim->prev_time = GST_CLOCK_TIME_NONE;
+  netsim->packets = g_array_new (FALSE, FALSE, sizeof (NetSimPacket));
 
   GST_OBJECT_FLAG_SET (netsim->sinkpad,
       GST_PAD_FLAG_PROXY_CAPS | GST_PAD_FLAG_PROXY_ALLOCATION);
 
   gst_pad_set_chain_function (netsim->sinkpad,
       GST_DEBUG_FUNCPTR (gst_net_sim_chain));
+  gst_pad_set_event_function (netsim->sinkpad,
+      GST_DEBUG_FUNCPTR (gst_net_sim_sink_event));
   gst_pad_set_activatemode_function (netsim->srcpad,
       GST_DEBUG_FUNCPTR (gst_net_sim_src_activatemode));
 }
@@ -623,23 +938,15 @@ gst_net_sim_finalize (GObject * object)
 {
   GstNetSim *netsim = GST_NET_SIM (object);
 
+  net_sim_packets_clear (netsim->packets);
+  g_array_free (netsim->packets, TRUE);
   g_rand_free (netsim->rand_seed);
   g_mutex_clear (&netsim->loop_mutex);
-  g_cond_clear (&netsim->start_cond);
+  g_cond_clear (&netsim->cond);
 
   G_OBJECT_CLASS (gst_net_sim_parent_class)->finalize (object);
 }
 
-static void
-gst_net_sim_dispose (GObject * object)
-{
-  GstNetSim *netsim = GST_NET_SIM (object);
-
-  g_assert (netsim->main_loop == NULL);
-
-  G_OBJECT_CLASS (gst_net_sim_parent_class)->dispose (object);
-}
-
 static void
 gst_net_sim_class_init (GstNetSimClass * klass)
 {
@@ -659,12 +966,13 @@ gst_net_sim_class_init (GstNetSimClass * klass)
       "Philippe Kalaf <philippe.kalaf@collabora.co.uk>, "
       "Havard Graff <havard@pexip.com>");
 
-  gobject_class->dispose = GST_DEBUG_FUNCPTR (gst_net_sim_dispose);
   gobject_class->finalize = GST_DEBUG_FUNCPTR (gst_net_sim_finalize);
 
   gobject_class->set_property = gst_net_sim_set_property;
   gobject_class->get_property = gst_net_sim_get_property;
 
+  gstelement_class->set_clock = GST_DEBUG_FUNCPTR (gst_net_sim_set_clock);
+
   g_object_class_install_property (gobject_class, PROP_MIN_DELAY,
       g_param_spec_int ("min-delay", "Minimum delay (ms)",
           "The minimum delay in ms to apply to buffers",
@@ -757,6 +1065,81 @@ gst_net_sim_class_init (GstNetSimClass * klass)
           DEFAULT_ALLOW_REORDERING,
           G_PARAM_READWRITE | G_PARAM_CONSTRUCT | G_PARAM_STATIC_STRINGS));
 
+  /**
+   * GstNetSim:link-kbps:
+   *
+   * The capacity of the simulated link in kilobits per second. When set,
+   * every packet takes the time its size needs at this rate to be sent, and
+   * waits for the packets before it, so bursts build up queueing delay
+   * instead of being dropped like with "max-kbps". Also see the
+   * "link-queue-size" property.
+   *
+   * Since: 1.24
+   */
+  g_object_class_install_property (gobject_class, PROP_LINK_KBPS,
+      g_param_spec_int ("link-kbps", "Link Kbps",
+          "The capacity of the link in kilobits per second "
+          "(-1 = unlimited)", -1, G_MAXINT, DEFAULT_LINK_KBPS,
+          G_PARAM_READWRITE | G_PARAM_CONSTRUCT | G_PARAM_STATIC_STRINGS));
+
+  /**
+   * GstNetSim:link-queue-size:
+   *
+   * The number of bytes that can wait to be sent on the link. Packets that
+   * don't fit anymore are dropped. Only used with "link-kbps".
+   *
+   * Since: 1.24
+   */
+  g_object_class_install_property (gobject_class, PROP_LINK_QUEUE_SIZE,
+      g_param_spec_int ("link-queue-size", "Link Queue Size (bytes)",
+          "The number of bytes that can wait to be sent on the link "
+          "(-1 = unlimited)", -1, G_MAXINT, DEFAULT_LINK_QUEUE_SIZE,
+          G_PARAM_READWRITE | G_PARAM_CONSTRUCT | G_PARAM_STATIC_STRINGS));
+
+  /**
+   * GstNetSim:burst-enter-probability:
+   *
+   * The probability to enter a loss burst after a packet, following the
+   * Gilbert-Elliott model. Outside of bursts, packets are dropped with
+   * "drop-probability", inside with "burst-drop-probability". 0 disables
+   * bursts.
+   *
+   * Since: 1.24
+   */
+  g_object_class_install_property (gobject_class,
+      PROP_BURST_ENTER_PROBABILITY,
+      g_param_spec_float ("burst-enter-probability",
+          "Burst Enter Probability",
+          "The probability to enter a loss burst after a packet",
+          0.0, 1.0, DEFAULT_BURST_ENTER_PROBABILITY,
+          G_PARAM_READWRITE | G_PARAM_CONSTRUCT | G_PARAM_STATIC_STRINGS));
+
+  /**
+   * GstNetSim:burst-exit-probability:
+   *
+   * The probability to leave a loss burst after a packet.
+   *
+   * Since: 1.24
+   */
+  g_object_class_install_property (gobject_class, PROP_BURST_EXIT_PROBABILITY,
+      g_param_spec_float ("burst-exit-probability", "Burst Exit Probability",
+          "The probability to leave a loss burst after a packet",
+          0.0, 1.0, DEFAULT_BURST_EXIT_PROBABILITY,
+          G_PARAM_READWRITE | G_PARAM_CONSTRUCT | G_PARAM_STATIC_STRINGS));
+
+  /**
+   * GstNetSim:burst-drop-probability:
+   *
+   * The probability a buffer is dropped during a loss burst.
+   *
+   * Since: 1.24
+   */
+  g_object_class_install_property (gobject_class, PROP_BURST_DROP_PROBABILITY,
+      g_param_spec_float ("burst-drop-probability", "Burst Drop Probability",
+          "The probability a buffer is dropped during a loss burst",
+          0.0, 1.0, DEFAULT_BURST_DROP_PROBABILITY,
+          G_PARAM_READWRITE | G_PARAM_CONSTRUCT | G_PARAM_STATIC_STRINGS));
+
   GST_DEBUG_CATEGORY_INIT (netsim_debug, "netsim", 0, "Network simulator");
 
   gst_type_mark_as_plugin_api (distribution_get_type (), 0);
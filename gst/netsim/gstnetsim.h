@@ -68,14 +68,32 @@ struct _GstNetSim
   GstPad *srcpad;
 
   GMutex loop_mutex;
-  GCond start_cond;
-  GMainLoop *main_loop;
+  GCond cond;
   gboolean running;
   GRand *rand_seed;
   gsize bucket_size;
   GstClockTime prev_time;
   NormalDistributionState delay_state;
-  gint64 last_ready_time;
+  GstClockTime last_ready_time;
+
+  /* packets and serialized events waiting to be pushed, a min-heap on
+   * their clock time */
+  GArray *packets;
+  guint64 packet_seqnum;
+  GstClockID clock_id;
+  /* latest time in packets, events are queued behind it */
+  GstClockTime latest_time;
+  /* events in packets or being pushed, and the time of the last one, that
+   * later packets must not overtake */
+  guint n_events;
+  GstClockTime event_time;
+  /* taken out of packets by the task and not pushed yet */
+  guint n_pushing;
+  GstFlowReturn last_ret;
+
+  /* link model */
+  GstClockTime link_busy_until;
+  gboolean in_burst;
 
   /* properties */
   gint min_delay;
@@ -88,6 +106,11 @@ struct _GstNetSim
   gint max_kbps;
   gint max_bucket_size;
   gboolean allow_reordering;
+  gint link_kbps;
+  gint link_queue_size;
+  gfloat burst_enter_probability;
+  gfloat burst_exit_probability;
+  gfloat burst_drop_probability;
 };
 
 struct _GstNetSimClass
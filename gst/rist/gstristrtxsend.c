@@ -30,6 +30,10 @@
  * This elements replies to custom events 'GstRTPRetransmissionRequest' and
  * when available sends in RIST form the lost packet. This element is intented
  * to be used by ristsink element.
+ *
+ * The request may carry an optional "count" field, in which case the "count"
+ * packets starting at "seqnum" are retransmitted together as a buffer list,
+ * which is how RIST range NACKs are forwarded by ristsink.
  */
 
 #ifdef HAVE_CONFIG_H
@@ -48,6 +52,12 @@ GST_DEBUG_CATEGORY_STATIC (gst_rist_rtx_send_debug);
 #define DEFAULT_MAX_SIZE_TIME    0
 #define DEFAULT_MAX_SIZE_PACKETS 100
 
+/* Bounds of the per-SSRC history ring, in seqnums. It grows as needed to
+ * hold all the seqnums from the oldest to the newest packet kept, including
+ * the ones that were never received. */
+#define MIN_HISTORY_SIZE 128
+#define MAX_HISTORY_SIZE (1 << 18)
+
 enum
 {
   PROP_0,
@@ -55,6 +65,9 @@ enum
   PROP_MAX_SIZE_PACKETS,
   PROP_NUM_RTX_REQUESTS,
   PROP_NUM_RTX_PACKETS,
+  PROP_NUM_RTX_HITS,
+  PROP_NUM_RTX_MISSES,
+  PROP_NUM_RTX_LATE,
 };
 
 static GstStaticPadTemplate src_factory = GST_STATIC_PAD_TEMPLATE ("src",
@@ -92,6 +105,9 @@ struct _GstRistRtxSend
   /* statistics */
   guint num_rtx_requests;
   guint num_rtx_packets;
+  guint num_rtx_hits;
+  guint num_rtx_misses;
+  guint num_rtx_late;
 };
 
 static gboolean gst_rist_rtx_send_queue_check_full (GstDataQueue * queue,
@@ -132,21 +148,23 @@ typedef struct
   GstBuffer *buffer;
 } BufferQueueItem;
 
-static void
-buffer_queue_item_free (BufferQueueItem * item)
-{
-  gst_buffer_unref (item->buffer);
-  g_slice_free (BufferQueueItem, item);
-}
-
 typedef struct
 {
   guint32 rtx_ssrc;
   guint16 seqnum_base, next_seqnum;
   gint clock_rate;
 
-  /* history of rtp packets */
-  GSequence *queue;
+  /* history of rtp packets, a ring indexed by extseqnum & (queue_size - 1).
+   * It holds the packets from first_extseqnum to first_extseqnum +
+   * queue_len - 1, the slots of the ones that were never received are
+   * empty and so are all the slots outside of that window. The first and
+   * last packets of the window are always present. */
+  BufferQueueItem *queue;
+  guint queue_size;
+  guint32 first_extseqnum;
+  guint32 queue_len;
+  /* number of packets in the window */
+  guint n_packets;
   guint32 max_extseqnum;
 
   /* current rtcp app seqnum extension */
@@ -161,7 +179,6 @@ ssrc_rtx_data_new (guint32 rtx_ssrc)
 
   data->rtx_ssrc = rtx_ssrc;
   data->next_seqnum = data->seqnum_base = g_random_int_range (0, G_MAXUINT16);
-  data->queue = g_sequence_new ((GDestroyNotify) buffer_queue_item_free);
   data->max_extseqnum = -1;
 
   return data;
@@ -170,10 +187,67 @@ ssrc_rtx_data_new (guint32 rtx_ssrc)
 static void
 ssrc_rtx_data_free (SSRCRtxData * data)
 {
-  g_sequence_free (data->queue);
+  guint i;
+
+  for (i = 0; i < data->queue_size; i++)
+    gst_clear_buffer (&data->queue[i].buffer);
+  g_free (data->queue);
   g_slice_free (SSRCRtxData, data);
 }
 
+static inline BufferQueueItem *
+ssrc_rtx_data_get_item (SSRCRtxData * data, guint32 extseqnum)
+{
+  return &data->queue[extseqnum & (data->queue_size - 1)];
+}
+
+static BufferQueueItem *
+ssrc_rtx_data_lookup (SSRCRtxData * data, guint32 extseqnum)
+{
+  BufferQueueItem *item;
+
+  if (extseqnum - data->first_extseqnum >= data->queue_len)
+    return NULL;
+
+  item = ssrc_rtx_data_get_item (data, extseqnum);
+
+  return item->buffer ? item : NULL;
+}
+
+/* Drops the oldest packet and moves the start of the window to the next
+ * one that was received */
+static void
+ssrc_rtx_data_pop_oldest (SSRCRtxData * data)
+{
+  gst_clear_buffer (&ssrc_rtx_data_get_item (data,
+          data->first_extseqnum)->buffer);
+  data->n_packets--;
+
+  do {
+    data->first_extseqnum++;
+    data->queue_len--;
+  } while (data->queue_len > 0
+      && !ssrc_rtx_data_get_item (data, data->first_extseqnum)->buffer);
+}
+
+static void
+ssrc_rtx_data_grow (SSRCRtxData * data, guint size)
+{
+  BufferQueueItem *old_queue = data->queue;
+  guint old_size = data->queue_size;
+  guint i;
+
+  data->queue = g_new0 (BufferQueueItem, size);
+  data->queue_size = size;
+
+  for (i = 0; i < old_size; i++) {
+    if (old_queue[i].buffer)
+      *ssrc_rtx_data_get_item (data, old_queue[i].extseqnum) = old_queue[i];
+  }
+
+  g_free (old_queue);
+}
+
 static void
 gst_rist_rtx_send_class_init (GstRistRtxSendClass * klass)
 {
@@ -208,6 +282,44 @@ gst_rist_rtx_send_class_init (GstRistRtxSendClass * klass)
           " Number of retransmission packets sent", 0, G_MAXUINT,
           0, G_PARAM_READABLE | G_PARAM_STATIC_STRINGS));
 
+  /**
+   * GstRistRtxSend:num-rtx-hits:
+   *
+   * Number of requested packets that were found in the history.
+   *
+   * Since: 1.24
+   */
+  g_object_class_install_property (gobject_class, PROP_NUM_RTX_HITS,
+      g_param_spec_uint ("num-rtx-hits", "Num RTX Hits",
+          "Number of requested packets found in the history", 0, G_MAXUINT,
+          0, G_PARAM_READABLE | G_PARAM_STATIC_STRINGS));
+
+  /**
+   * GstRistRtxSend:num-rtx-misses:
+   *
+   * Number of requested packets that were never received or that were not
+   * transmitted yet.
+   *
+   * Since: 1.24
+   */
+  g_object_class_install_property (gobject_class, PROP_NUM_RTX_MISSES,
+      g_param_spec_uint ("num-rtx-misses", "Num RTX Misses",
+          "Number of requested packets that were never received", 0, G_MAXUINT,
+          0, G_PARAM_READABLE | G_PARAM_STATIC_STRINGS));
+
+  /**
+   * GstRistRtxSend:num-rtx-late:
+   *
+   * Number of requested packets that had already been removed from the
+   * history.
+   *
+   * Since: 1.24
+   */
+  g_object_class_install_property (gobject_class, PROP_NUM_RTX_LATE,
+      g_param_spec_uint ("num-rtx-late", "Num RTX Late",
+          "Number of requested packets already removed from the history", 0,
+          G_MAXUINT, 0, G_PARAM_READABLE | G_PARAM_STATIC_STRINGS));
+
   gst_element_class_add_static_pad_template (gstelement_class, &src_factory);
   gst_element_class_add_static_pad_template (gstelement_class, &sink_factory);
 
@@ -229,6 +341,9 @@ gst_rist_rtx_send_reset (GstRistRtxSend * rtx)
   g_hash_table_remove_all (rtx->rtx_ssrcs);
   rtx->num_rtx_requests = 0;
   rtx->num_rtx_packets = 0;
+  rtx->num_rtx_hits = 0;
+  rtx->num_rtx_misses = 0;
+  rtx->num_rtx_late = 0;
   GST_OBJECT_UNLOCK (rtx);
 }
 
@@ -369,16 +484,6 @@ gst_rtp_rist_buffer_new (GstRistRtxSend * rtx, GstBuffer * buffer, guint32 ssrc)
   return buffer;
 }
 
-static gint
-buffer_queue_items_cmp (BufferQueueItem * a, BufferQueueItem * b,
-    gpointer user_data)
-{
-  /* gst_rtp_buffer_compare_seqnum returns the opposite of what we want,
-   * it returns negative when seqnum1 > seqnum2 and we want negative
-   * when b > a, i.e. a is smaller, so it comes first in the sequence */
-  return a->extseqnum - b->extseqnum;
-}
-
 static gboolean
 gst_rist_rtx_send_src_event (GstPad * pad, GstObject * parent, GstEvent * event)
 {
@@ -393,7 +498,8 @@ gst_rist_rtx_send_src_event (GstPad * pad, GstObject * parent, GstEvent * event)
       if (gst_structure_has_name (s, "GstRTPRetransmissionRequest")) {
         guint seqnum = 0;
         guint ssrc = 0;
-        GstBuffer *rtx_buf = NULL;
+        guint count = 1;
+        GstBufferList *history_bufs = NULL;
 
         /* retrieve seqnum of the packet that need to be retransmitted */
         if (!gst_structure_get_uint (s, "seqnum", &seqnum))
@@ -403,64 +509,79 @@ gst_rist_rtx_send_src_event (GstPad * pad, GstObject * parent, GstEvent * event)
         if (!gst_structure_get_uint (s, "ssrc", &ssrc))
           ssrc = -1;
 
-        GST_DEBUG_OBJECT (rtx, "got rtx request for seqnum: %u, ssrc: %X",
-            seqnum, ssrc);
+        /* range requests, the number of consecutive packets wanted */
+        if (!gst_structure_get_uint (s, "count", &count) || count == 0)
+          count = 1;
+        count = MIN (count, G_MAXUINT16 + 1);
+
+        GST_DEBUG_OBJECT (rtx, "got rtx request for seqnum: %u (count %u), "
+            "ssrc: %X", seqnum, count, ssrc);
 
         GST_OBJECT_LOCK (rtx);
         /* check if request is for us */
         if (g_hash_table_contains (rtx->ssrc_data, GUINT_TO_POINTER (ssrc))) {
           SSRCRtxData *data;
-          GSequenceIter *iter;
-          BufferQueueItem search_item;
           guint32 extseqnum;
+          guint i;
 
           /* update statistics */
-          ++rtx->num_rtx_requests;
+          rtx->num_rtx_requests += count;
 
           data = gst_rist_rtx_send_get_ssrc_data (rtx, ssrc);
 
-
           if (data->has_seqnum_ext) {
-            extseqnum = data->seqnum_ext << 16 | seqnum;
+            extseqnum = data->seqnum_ext << 16 | (seqnum & 0xFFFF);
           } else {
             guint32 max_extseqnum = data->max_extseqnum;
             extseqnum = gst_rist_rtp_ext_seq (&max_extseqnum, seqnum);
           }
 
-          search_item.extseqnum = extseqnum;
-          iter = g_sequence_lookup (data->queue, &search_item,
-              (GCompareDataFunc) buffer_queue_items_cmp, NULL);
-          if (iter) {
-            BufferQueueItem *item = g_sequence_get (iter);
-            GST_LOG_OBJECT (rtx, "found %u (%u:%u)", item->extseqnum,
-                item->extseqnum >> 16, item->extseqnum & 0xFFFF);
-            rtx_buf = gst_rtp_rist_buffer_new (rtx, item->buffer, ssrc);
-          }
-#ifndef GST_DISABLE_DEBUG
-          else {
-            BufferQueueItem *item = NULL;
+          /* Only take references here, the copies are made once the lock
+           * is released so that the streaming thread isn't blocked */
+          history_bufs = gst_buffer_list_new_sized (MIN (count, 64));
 
-            iter = g_sequence_get_begin_iter (data->queue);
-            if (!g_sequence_iter_is_end (iter))
-              item = g_sequence_get (iter);
+          for (i = 0; i < count; i++, extseqnum++) {
+            BufferQueueItem *item = ssrc_rtx_data_lookup (data, extseqnum);
 
-            if (item && extseqnum < item->extseqnum) {
+            if (item) {
+              GST_LOG_OBJECT (rtx, "found %u (%u:%u)", item->extseqnum,
+                  item->extseqnum >> 16, item->extseqnum & 0xFFFF);
+              gst_buffer_list_add (history_bufs, gst_buffer_ref (item->buffer));
+              ++rtx->num_rtx_hits;
+            } else if (data->queue_len > 0
+                && (gint32) (extseqnum - data->first_extseqnum) < 0) {
               GST_DEBUG_OBJECT (rtx, "requested seqnum %u has already been "
                   "removed from the rtx queue; the first available is %u",
-                  seqnum, item->extseqnum);
+                  extseqnum & 0xFFFF, data->first_extseqnum);
+              ++rtx->num_rtx_late;
             } else {
               GST_WARNING_OBJECT (rtx, "requested seqnum %u has not been "
                   "transmitted yet in the original stream; either the remote end "
                   "is not configured correctly, or the source is too slow",
-                  seqnum);
+                  extseqnum & 0xFFFF);
+              ++rtx->num_rtx_misses;
             }
-#endif
           }
         }
         GST_OBJECT_UNLOCK (rtx);
 
-        if (rtx_buf)
-          gst_rist_rtx_send_push_out (rtx, rtx_buf);
+        if (history_bufs) {
+          guint i, len = gst_buffer_list_length (history_bufs);
+
+          if (len == 1) {
+            gst_rist_rtx_send_push_out (rtx, gst_rtp_rist_buffer_new (rtx,
+                    gst_buffer_list_get (history_bufs, 0), ssrc));
+          } else if (len > 1) {
+            GstBufferList *rtx_list = gst_buffer_list_new_sized (len);
+
+            for (i = 0; i < len; i++)
+              gst_buffer_list_add (rtx_list, gst_rtp_rist_buffer_new (rtx,
+                      gst_buffer_list_get (history_bufs, i), ssrc));
+            gst_rist_rtx_send_push_out (rtx, rtx_list);
+          }
+
+          gst_buffer_list_unref (history_bufs);
+        }
 
         gst_event_unref (event);
         return TRUE;
@@ -553,14 +674,13 @@ gst_rist_rtx_send_get_ts_diff (SSRCRtxData * data)
   BufferQueueItem *high_buf, *low_buf;
   guint32 result;
 
-  high_buf =
-      g_sequence_get (g_sequence_iter_prev (g_sequence_get_end_iter
-          (data->queue)));
-  low_buf = g_sequence_get (g_sequence_get_begin_iter (data->queue));
-
-  if (!high_buf || !low_buf || high_buf == low_buf)
+  if (data->queue_len < 2 || data->clock_rate <= 0)
     return 0;
 
+  high_buf = ssrc_rtx_data_get_item (data,
+      data->first_extseqnum + data->queue_len - 1);
+  low_buf = ssrc_rtx_data_get_item (data, data->first_extseqnum);
+
   high_ts = high_buf->timestamp;
   low_ts = low_buf->timestamp;
 
@@ -575,12 +695,74 @@ gst_rist_rtx_send_get_ts_diff (SSRCRtxData * data)
   return (guint32) gst_util_uint64_scale_int (result, 1000, data->clock_rate);
 }
 
+/* Must be called with lock */
+static void
+gst_rist_rtx_send_store (GstRistRtxSend * rtx, SSRCRtxData * data,
+    guint32 extseqnum, guint32 rtptime, GstBuffer * buffer)
+{
+  BufferQueueItem *item;
+  guint32 span;
+
+  if (data->queue_len > 0
+      && (gint32) (extseqnum - data->first_extseqnum) < 0) {
+    GST_LOG_OBJECT (rtx, "not keeping %u, older than the history",
+        extseqnum & 0xFFFF);
+    return;
+  }
+
+  span = data->queue_len > 0 ? extseqnum - data->first_extseqnum + 1 : 1;
+
+  if (span > data->queue_len) {
+    /* New last packet, make room for it in the ring */
+    if (span > data->queue_size && data->queue_size < MAX_HISTORY_SIZE) {
+      guint size = MAX (data->queue_size, MIN_HISTORY_SIZE);
+
+      while (size < span && size < MAX_HISTORY_SIZE)
+        size <<= 1;
+
+      if (size != data->queue_size) {
+        GST_DEBUG_OBJECT (rtx, "growing history of ssrc %X to %u packets",
+            data->rtx_ssrc - 1, size);
+        ssrc_rtx_data_grow (data, size);
+      }
+    }
+
+    while (data->queue_len > 0 && span > data->queue_size) {
+      ssrc_rtx_data_pop_oldest (data);
+      span = data->queue_len > 0 ? extseqnum - data->first_extseqnum + 1 : 1;
+    }
+
+    if (data->queue_len == 0)
+      data->first_extseqnum = extseqnum;
+    data->queue_len = span;
+  }
+
+  item = ssrc_rtx_data_get_item (data, extseqnum);
+  if (!item->buffer)
+    data->n_packets++;
+  item->extseqnum = extseqnum;
+  item->timestamp = rtptime;
+  gst_buffer_replace (&item->buffer, buffer);
+
+  /* remove oldest packets from history if they are too many, the seqnums
+   * that were never received don't count */
+  if (rtx->max_size_packets) {
+    while (data->n_packets > rtx->max_size_packets)
+      ssrc_rtx_data_pop_oldest (data);
+  }
+
+  /* remove oldest packets from history if they are too old */
+  if (rtx->max_size_time) {
+    while (gst_rist_rtx_send_get_ts_diff (data) > rtx->max_size_time)
+      ssrc_rtx_data_pop_oldest (data);
+  }
+}
+
 /* Must be called with lock */
 static void
 process_buffer (GstRistRtxSend * rtx, GstBuffer * buffer)
 {
   GstRTPBuffer rtp = GST_RTP_BUFFER_INIT;
-  BufferQueueItem *item;
   SSRCRtxData *data;
   guint16 seqnum;
   guint32 ssrc, rtptime;
@@ -616,21 +798,7 @@ process_buffer (GstRistRtxSend * rtx, GstBuffer * buffer)
     extseqnum = gst_rist_rtp_ext_seq (&data->max_extseqnum, seqnum);
 
   /* add current rtp buffer to queue history */
-  item = g_slice_new0 (BufferQueueItem);
-  item->extseqnum = extseqnum;
-  item->timestamp = rtptime;
-  item->buffer = gst_buffer_ref (buffer);
-  g_sequence_append (data->queue, item);
-
-  /* remove oldest packets from history if they are too many */
-  if (rtx->max_size_packets) {
-    while (g_sequence_get_length (data->queue) > rtx->max_size_packets)
-      g_sequence_remove (g_sequence_get_begin_iter (data->queue));
-  }
-  if (rtx->max_size_time) {
-    while (gst_rist_rtx_send_get_ts_diff (data) > rtx->max_size_time)
-      g_sequence_remove (g_sequence_get_begin_iter (data->queue));
-  }
+  gst_rist_rtx_send_store (rtx, data, extseqnum, rtptime, buffer);
 }
 
 static GstFlowReturn
@@ -685,6 +853,14 @@ gst_rist_rtx_send_src_loop (GstRistRtxSend * rtx)
       GST_OBJECT_UNLOCK (rtx);
 
       gst_pad_push (rtx->srcpad, GST_BUFFER (data->object));
+    } else if (GST_IS_BUFFER_LIST (data->object)) {
+      GstBufferList *list = GST_BUFFER_LIST (data->object);
+
+      GST_OBJECT_LOCK (rtx);
+      rtx->num_rtx_packets += gst_buffer_list_length (list);
+      GST_OBJECT_UNLOCK (rtx);
+
+      gst_pad_push_list (rtx->srcpad, list);
     } else if (GST_IS_EVENT (data->object)) {
       gst_pad_push_event (rtx->srcpad, GST_EVENT (data->object));
 
@@ -757,6 +933,21 @@ gst_rist_rtx_send_get_property (GObject * object,
       g_value_set_uint (value, rtx->num_rtx_packets);
       GST_OBJECT_UNLOCK (rtx);
       break;
+    case PROP_NUM_RTX_HITS:
+      GST_OBJECT_LOCK (rtx);
+      g_value_set_uint (value, rtx->num_rtx_hits);
+      GST_OBJECT_UNLOCK (rtx);
+      break;
+    case PROP_NUM_RTX_MISSES:
+      GST_OBJECT_LOCK (rtx);
+      g_value_set_uint (value, rtx->num_rtx_misses);
+      GST_OBJECT_UNLOCK (rtx);
+      break;
+    case PROP_NUM_RTX_LATE:
+      GST_OBJECT_LOCK (rtx);
+      g_value_set_uint (value, rtx->num_rtx_late);
+      GST_OBJECT_UNLOCK (rtx);
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
       break;
@@ -30,6 +30,7 @@
 
 void rtmp2_element_init (GstPlugin * plugin);
 
+GST_ELEMENT_REGISTER_DECLARE (rtmp2serversrc);
 GST_ELEMENT_REGISTER_DECLARE (rtmp2sink);
 GST_ELEMENT_REGISTER_DECLARE (rtmp2src);
 
@@ -0,0 +1,1405 @@
+/* GStreamer
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin Street, Suite 500,
+ * Boston, MA 02110-1335, USA.
+ */
+/**
+ * SECTION:element-rtmp2serversrc
+ *
+ * The rtmp2serversrc element listens for RTMP connections and receives the
+ * streams that encoders publish to it. Every published stream key gets its
+ * own "src_<stream key>" pad carrying FLV, which is removed again after EOS
+ * when the stream is unpublished or the publisher disconnects.
+ *
+ * All connections are serviced from a single thread; every pad pushes from
+ * its own streaming thread so that a slow branch does not hold up the other
+ * publishers. Publishers cannot be slowed down without stalling the others,
+ * so once #GstRtmp2ServerSrc:max-size-bytes are waiting for a slow branch,
+ * audio is dropped and video until the next keyframe. Codec headers and
+ * metadata are always kept.
+ *
+ * <refsect2>
+ * <title>Example launch line</title>
+ * |[
+ * gst-launch-1.0 rtmp2serversrc port=1935 application=live name=s \
+ *     s.src_cam1 ! flvdemux ! decodebin ! autovideosink
+ * ]|
+ * Accepts streams published to rtmp://host/live/ and plays the one
+ * published as "cam1", e.g. by
+ * |[
+ * gst-launch-1.0 videotestsrc is-live=true ! x264enc ! flvmux streamable=true \
+ *     ! rtmp2sink location=rtmp://127.0.0.1/live/cam1
+ * ]|
+ * </refsect2>
+ *
+ * Since: 1.24
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include "gstrtmp2elements.h"
+#include "gstrtmp2serversrc.h"
+
+#include "rtmp/amf.h"
+#include "rtmp/rtmpconnection.h"
+#include "rtmp/rtmphandshake.h"
+#include "rtmp/rtmpmessage.h"
+
+#include <string.h>
+
+GST_DEBUG_CATEGORY_STATIC (gst_rtmp2_server_src_debug_category);
+#define GST_CAT_DEFAULT gst_rtmp2_server_src_debug_category
+
+#define GST_RTMP2_SERVER_SRC(obj)   (G_TYPE_CHECK_INSTANCE_CAST((obj),GST_TYPE_RTMP2_SERVER_SRC,GstRtmp2ServerSrc))
+#define GST_IS_RTMP2_SERVER_SRC(obj)   (G_TYPE_CHECK_INSTANCE_TYPE((obj),GST_TYPE_RTMP2_SERVER_SRC))
+
+typedef struct _Client Client;
+typedef struct _ServerStream ServerStream;
+
+typedef struct
+{
+  GstElement parent_instance;
+
+  /* properties */
+  gchar *host;
+  gint port;
+  gint current_port;
+  gchar *application;
+  guint max_size_bytes;
+
+  /* Protects the streams and their queues. If both self->lock and
+   * OBJECT_LOCK are needed, self->lock must be taken first */
+  GMutex lock;
+
+  GstTask *task;
+  GRecMutex task_lock;
+
+  GMainLoop *loop;
+  GMainContext *context;
+
+  GCancellable *cancellable;
+  GSocketService *service;
+
+  /* only touched from the loop thread */
+  GList *clients;
+
+  /* stream key -> ServerStream */
+  GHashTable *streams;
+
+  /* protected by lock */
+  guint64 messages_queued;
+  guint64 messages_dropped;
+} GstRtmp2ServerSrc;
+
+typedef struct
+{
+  GstElementClass parent_class;
+} GstRtmp2ServerSrcClass;
+
+/* One publishing connection, only used from the loop thread */
+struct _Client
+{
+  GstRtmp2ServerSrc *self;
+  GSocketConnection *socket_connection;
+  GstRtmpConnection *connection;
+  gchar *peer;
+
+  gboolean connected;
+  guint32 next_stream_id;
+
+  /* ServerStreams published on this connection */
+  GList *streams;
+};
+
+struct _ServerStream
+{
+  GstRtmp2ServerSrc *self;
+  gchar *key;
+  GstPad *pad;
+
+  /* only touched from the loop thread */
+  Client *client;
+  guint32 stream_id;
+  gboolean sent_header;
+  gboolean dropping_video;
+
+  /* only touched from the pad task */
+  gboolean sent_events;
+
+  /* protected by self->lock */
+  GCond cond;
+  GQueue queue;
+  gsize queued_bytes;
+  gboolean discont;
+  gboolean eos;
+  gboolean flushing;
+  GstFlowReturn flow;
+};
+
+/* GObject virtual functions */
+static void gst_rtmp2_server_src_set_property (GObject * object,
+    guint property_id, const GValue * value, GParamSpec * pspec);
+static void gst_rtmp2_server_src_get_property (GObject * object,
+    guint property_id, GValue * value, GParamSpec * pspec);
+static void gst_rtmp2_server_src_finalize (GObject * object);
+
+/* GstElement virtual functions */
+static GstStateChangeReturn gst_rtmp2_server_src_change_state (GstElement *
+    element, GstStateChange transition);
+
+/* Internal API */
+static gboolean gst_rtmp2_server_src_start (GstRtmp2ServerSrc * self);
+static void gst_rtmp2_server_src_stop (GstRtmp2ServerSrc * self);
+static void gst_rtmp2_server_src_task_func (gpointer user_data);
+static gboolean on_incoming (GSocketService * service,
+    GSocketConnection * connection, GObject * source_object,
+    gpointer user_data);
+static void handshake_done (GObject * source, GAsyncResult * result,
+    gpointer user_data);
+static void client_close (Client * client);
+static void server_stream_unpublish (ServerStream * stream);
+
+enum
+{
+  PROP_0,
+  PROP_HOST,
+  PROP_PORT,
+  PROP_CURRENT_PORT,
+  PROP_APPLICATION,
+  PROP_MAX_SIZE_BYTES,
+  PROP_STATS,
+};
+
+#define DEFAULT_HOST "0.0.0.0"
+#define DEFAULT_PORT 1935
+#define DEFAULT_MAX_SIZE_BYTES (4 * 1024 * 1024)
+
+/* pad templates */
+
+static GstStaticPadTemplate gst_rtmp2_server_src_src_template =
+GST_STATIC_PAD_TEMPLATE ("src_%s",
+    GST_PAD_SRC,
+    GST_PAD_SOMETIMES,
+    GST_STATIC_CAPS ("video/x-flv")
+    );
+
+/* class initialization */
+
+G_DEFINE_TYPE (GstRtmp2ServerSrc, gst_rtmp2_server_src, GST_TYPE_ELEMENT);
+GST_ELEMENT_REGISTER_DEFINE_WITH_CODE (rtmp2serversrc, "rtmp2serversrc",
+    GST_RANK_NONE, GST_TYPE_RTMP2_SERVER_SRC, rtmp2_element_init (plugin));
+
+static void
+gst_rtmp2_server_src_class_init (GstRtmp2ServerSrcClass * klass)
+{
+  GObjectClass *gobject_class = G_OBJECT_CLASS (klass);
+  GstElementClass *element_class = GST_ELEMENT_CLASS (klass);
+
+  gst_element_class_add_static_pad_template (element_class,
+      &gst_rtmp2_server_src_src_template);
+
+  gst_element_class_set_static_metadata (element_class,
+      "RTMP server source element", "Source/Network",
+      "Receives the RTMP streams published to it",
+      "Make.TV, Inc. <info@make.tv>");
+
+  gobject_class->set_property = gst_rtmp2_server_src_set_property;
+  gobject_class->get_property = gst_rtmp2_server_src_get_property;
+  gobject_class->finalize = gst_rtmp2_server_src_finalize;
+  element_class->change_state =
+      GST_DEBUG_FUNCPTR (gst_rtmp2_server_src_change_state);
+
+  g_object_class_install_property (gobject_class, PROP_HOST,
+      g_param_spec_string ("host", "Host", "Address to listen on",
+          DEFAULT_HOST, G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
+  g_object_class_install_property (gobject_class, PROP_PORT,
+      g_param_spec_int ("port", "Port",
+          "Port to listen on (0 = random available port)",
+          0, 65535, DEFAULT_PORT, G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
+  g_object_class_install_property (gobject_class, PROP_CURRENT_PORT,
+      g_param_spec_int ("current-port", "Current port",
+          "The port the server is listening on (0 = not listening)",
+          0, 65535, 0, G_PARAM_READABLE | G_PARAM_STATIC_STRINGS));
+
+  g_object_class_install_property (gobject_class, PROP_APPLICATION,
+      g_param_spec_string ("application", "Application",
+          "Only accept connections to this application "
+          "(NULL = any application)", NULL,
+          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
+  g_object_class_install_property (gobject_class, PROP_MAX_SIZE_BYTES,
+      g_param_spec_uint ("max-size-bytes", "Max size bytes",
+          "Bytes waiting on a stream pad before messages are dropped "
+          "(0 = unlimited)", 0, G_MAXUINT, DEFAULT_MAX_SIZE_BYTES,
+          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
+  g_object_class_install_property (gobject_class, PROP_STATS,
+      g_param_spec_boxed ("stats", "Stats", "Retrieve a statistics structure",
+          GST_TYPE_STRUCTURE, G_PARAM_READABLE | G_PARAM_STATIC_STRINGS));
+
+  GST_DEBUG_CATEGORY_INIT (gst_rtmp2_server_src_debug_category,
+      "rtmp2serversrc", 0, "debug category for rtmp2serversrc element");
+}
+
+static void
+server_stream_free (gpointer ptr)
+{
+  ServerStream *stream = ptr;
+
+  g_queue_clear_full (&stream->queue, (GDestroyNotify) gst_buffer_unref);
+  g_cond_clear (&stream->cond);
+  gst_object_unref (stream->pad);
+  g_free (stream->key);
+  g_slice_free (ServerStream, stream);
+}
+
+static void
+gst_rtmp2_server_src_init (GstRtmp2ServerSrc * self)
+{
+  self->host = g_strdup (DEFAULT_HOST);
+  self->port = DEFAULT_PORT;
+  self->max_size_bytes = DEFAULT_MAX_SIZE_BYTES;
+
+  g_mutex_init (&self->lock);
+  self->streams = g_hash_table_new (g_str_hash, g_str_equal);
+
+  self->task = gst_task_new (gst_rtmp2_server_src_task_func, self, NULL);
+  g_rec_mutex_init (&self->task_lock);
+  gst_task_set_lock (self->task, &self->task_lock);
+
+  GST_OBJECT_FLAG_SET (self, GST_ELEMENT_FLAG_SOURCE);
+}
+
+static void
+gst_rtmp2_server_src_set_property (GObject * object, guint property_id,
+    const GValue * value, GParamSpec * pspec)
+{
+  GstRtmp2ServerSrc *self = GST_RTMP2_SERVER_SRC (object);
+
+  switch (property_id) {
+    case PROP_HOST:
+      GST_OBJECT_LOCK (self);
+      g_free (self->host);
+      self->host = g_value_dup_string (value);
+      GST_OBJECT_UNLOCK (self);
+      break;
+    case PROP_PORT:
+      GST_OBJECT_LOCK (self);
+      self->port = g_value_get_int (value);
+      GST_OBJECT_UNLOCK (self);
+      break;
+    case PROP_APPLICATION:
+      GST_OBJECT_LOCK (self);
+      g_free (self->application);
+      self->application = g_value_dup_string (value);
+      GST_OBJECT_UNLOCK (self);
+      break;
+    case PROP_MAX_SIZE_BYTES:
+      GST_OBJECT_LOCK (self);
+      self->max_size_bytes = g_value_get_uint (value);
+      GST_OBJECT_UNLOCK (self);
+      break;
+    default:
+      G_OBJECT_WARN_INVALID_PROPERTY_ID (object, property_id, pspec);
+      break;
+  }
+}
+
+static void
+gst_rtmp2_server_src_get_property (GObject * object, guint property_id,
+    GValue * value, GParamSpec * pspec)
+{
+  GstRtmp2ServerSrc *self = GST_RTMP2_SERVER_SRC (object);
+
+  switch (property_id) {
+    case PROP_HOST:
+      GST_OBJECT_LOCK (self);
+      g_value_set_string (value, self->host);
+      GST_OBJECT_UNLOCK (self);
+      break;
+    case PROP_PORT:
+      GST_OBJECT_LOCK (self);
+      g_value_set_int (value, self->port);
+      GST_OBJECT_UNLOCK (self);
+      break;
+    case PROP_CURRENT_PORT:
+      GST_OBJECT_LOCK (self);
+      g_value_set_int (value, self->current_port);
+      GST_OBJECT_UNLOCK (self);
+      break;
+    case PROP_APPLICATION:
+      GST_OBJECT_LOCK (self);
+      g_value_set_string (value, self->application);
+      GST_OBJECT_UNLOCK (self);
+      break;
+    case PROP_MAX_SIZE_BYTES:
+      GST_OBJECT_LOCK (self);
+      g_value_set_uint (value, self->max_size_bytes);
+      GST_OBJECT_UNLOCK (self);
+      break;
+    case PROP_STATS:
+      g_mutex_lock (&self->lock);
+      g_value_take_boxed (value, gst_structure_new ("GstRtmp2ServerSrcStats",
+              "messages-queued", G_TYPE_UINT64, self->messages_queued,
+              "messages-dropped", G_TYPE_UINT64, self->messages_dropped,
+              NULL));
+      g_mutex_unlock (&self->lock);
+      break;
+    default:
+      G_OBJECT_WARN_INVALID_PROPERTY_ID (object, property_id, pspec);
+      break;
+  }
+}
+
+static void
+gst_rtmp2_server_src_finalize (GObject * object)
+{
+  GstRtmp2ServerSrc *self = GST_RTMP2_SERVER_SRC (object);
+
+  g_clear_object (&self->cancellable);
+  g_clear_object (&self->service);
+
+  g_clear_object (&self->task);
+  g_rec_mutex_clear (&self->task_lock);
+
+  g_hash_table_unref (self->streams);
+  g_mutex_clear (&self->lock);
+
+  g_free (self->host);
+  g_free (self->application);
+
+  G_OBJECT_CLASS (gst_rtmp2_server_src_parent_class)->finalize (object);
+}
+
+static GstStateChangeReturn
+gst_rtmp2_server_src_change_state (GstElement * element,
+    GstStateChange transition)
+{
+  GstRtmp2ServerSrc *self = GST_RTMP2_SERVER_SRC (element);
+  GstStateChangeReturn ret;
+
+  switch (transition) {
+    case GST_STATE_CHANGE_READY_TO_PAUSED:
+      if (!gst_rtmp2_server_src_start (self))
+        return GST_STATE_CHANGE_FAILURE;
+      break;
+    case GST_STATE_CHANGE_PAUSED_TO_READY:
+      /* Wakes up and removes the pads before their tasks get stopped */
+      gst_rtmp2_server_src_stop (self);
+      break;
+    default:
+      break;
+  }
+
+  ret = GST_ELEMENT_CLASS (gst_rtmp2_server_src_parent_class)->change_state
+      (element, transition);
+  if (ret == GST_STATE_CHANGE_FAILURE)
+    return ret;
+
+  switch (transition) {
+    case GST_STATE_CHANGE_READY_TO_PAUSED:
+    case GST_STATE_CHANGE_PLAYING_TO_PAUSED:
+      ret = GST_STATE_CHANGE_NO_PREROLL;
+      break;
+    default:
+      break;
+  }
+
+  return ret;
+}
+
+/* Binds the socket right away so that errors fail the state change and
+ * current-port is known once we are PAUSED. Accepting only starts in the
+ * loop thread, where the service attaches its sources. */
+static gboolean
+gst_rtmp2_server_src_start (GstRtmp2ServerSrc * self)
+{
+  GInetAddress *inet_address;
+  GSocketAddress *address, *effective_address = NULL;
+  GError *error = NULL;
+  gchar *host;
+  gint port;
+  gboolean ret;
+
+  GST_OBJECT_LOCK (self);
+  host = g_strdup (self->host);
+  port = self->port;
+  GST_OBJECT_UNLOCK (self);
+
+  inet_address = g_inet_address_new_from_string (host);
+  if (!inet_address) {
+    GST_ELEMENT_ERROR (self, RESOURCE, SETTINGS,
+        ("Invalid address to listen on: %s", host), (NULL));
+    g_free (host);
+    return FALSE;
+  }
+
+  address = g_inet_socket_address_new (inet_address, port);
+  g_object_unref (inet_address);
+
+  g_clear_object (&self->service);
+  self->service = g_socket_service_new ();
+  g_socket_service_stop (self->service);
+
+  ret = g_socket_listener_add_address (G_SOCKET_LISTENER (self->service),
+      address, G_SOCKET_TYPE_STREAM, G_SOCKET_PROTOCOL_TCP, NULL,
+      &effective_address, &error);
+  g_object_unref (address);
+
+  if (!ret) {
+    GST_ELEMENT_ERROR (self, RESOURCE, OPEN_READ,
+        ("Failed to listen on %s:%d: %s", host, port, error->message), (NULL));
+    g_clear_error (&error);
+    g_clear_object (&self->service);
+    g_free (host);
+    return FALSE;
+  }
+
+  port = g_inet_socket_address_get_port (G_INET_SOCKET_ADDRESS
+      (effective_address));
+  g_object_unref (effective_address);
+
+  GST_INFO_OBJECT (self, "Listening on %s:%d", host, port);
+  g_free (host);
+
+  GST_OBJECT_LOCK (self);
+  self->current_port = port;
+  GST_OBJECT_UNLOCK (self);
+
+  g_signal_connect (self->service, "incoming", G_CALLBACK (on_incoming), self);
+
+  g_clear_object (&self->cancellable);
+  self->cancellable = g_cancellable_new ();
+
+  g_mutex_lock (&self->lock);
+  self->messages_queued = 0;
+  self->messages_dropped = 0;
+  g_mutex_unlock (&self->lock);
+
+  gst_task_start (self->task);
+
+  return TRUE;
+}
+
+static gboolean
+quit_invoker (gpointer user_data)
+{
+  g_main_loop_quit (user_data);
+  return G_SOURCE_REMOVE;
+}
+
+static void
+gst_rtmp2_server_src_stop (GstRtmp2ServerSrc * self)
+{
+  GHashTableIter iter;
+  ServerStream *stream;
+  GList *streams = NULL, *l;
+
+  GST_DEBUG_OBJECT (self, "stop");
+
+  g_mutex_lock (&self->lock);
+  gst_task_stop (self->task);
+
+  if (self->cancellable) {
+    GST_DEBUG_OBJECT (self, "Cancelling");
+    g_cancellable_cancel (self->cancellable);
+  }
+
+  if (self->loop) {
+    GST_DEBUG_OBJECT (self, "Stopping loop");
+    g_main_context_invoke_full (self->context, G_PRIORITY_DEFAULT_IDLE,
+        quit_invoker, g_main_loop_ref (self->loop),
+        (GDestroyNotify) g_main_loop_unref);
+  }
+
+  g_hash_table_iter_init (&iter, self->streams);
+  while (g_hash_table_iter_next (&iter, NULL, (gpointer *) & stream)) {
+    stream->flushing = TRUE;
+    g_cond_signal (&stream->cond);
+  }
+  g_mutex_unlock (&self->lock);
+
+  gst_task_join (self->task);
+
+  /* The loop is gone, nothing else touches the streams anymore */
+  g_mutex_lock (&self->lock);
+  g_hash_table_iter_init (&iter, self->streams);
+  while (g_hash_table_iter_next (&iter, NULL, (gpointer *) & stream)) {
+    streams = g_list_prepend (streams, stream);
+    g_hash_table_iter_steal (&iter);
+  }
+  g_mutex_unlock (&self->lock);
+
+  for (l = streams; l; l = l->next) {
+    stream = l->data;
+    gst_element_remove_pad (GST_ELEMENT (self), stream->pad);
+    server_stream_free (stream);
+  }
+  g_list_free (streams);
+
+  if (self->service) {
+    g_socket_listener_close (G_SOCKET_LISTENER (self->service));
+    g_signal_handlers_disconnect_by_data (self->service, self);
+    g_clear_object (&self->service);
+  }
+
+  GST_OBJECT_LOCK (self);
+  self->current_port = 0;
+  GST_OBJECT_UNLOCK (self);
+}
+
+/* Mainloop task */
+static void
+gst_rtmp2_server_src_task_func (gpointer user_data)
+{
+  GstRtmp2ServerSrc *self = GST_RTMP2_SERVER_SRC (user_data);
+  GMainContext *context;
+  GMainLoop *loop;
+  GList *l, *next;
+
+  GST_DEBUG_OBJECT (self, "gst_rtmp2_server_src_task starting");
+  g_mutex_lock (&self->lock);
+
+  context = self->context = g_main_context_new ();
+  g_main_context_push_thread_default (context);
+  loop = self->loop = g_main_loop_new (context, TRUE);
+
+  if (g_cancellable_is_cancelled (self->cancellable)) {
+    g_main_loop_quit (loop);
+  } else {
+    g_socket_service_start (self->service);
+  }
+
+  /* Run loop */
+  g_mutex_unlock (&self->lock);
+  g_main_loop_run (loop);
+
+  g_socket_service_stop (self->service);
+
+  /* Clients still in the handshake are closed by its cancellation */
+  for (l = self->clients; l; l = next) {
+    Client *client = l->data;
+
+    next = l->next;
+    if (client->connection)
+      client_close (client);
+  }
+
+  g_mutex_lock (&self->lock);
+  g_clear_pointer (&self->loop, g_main_loop_unref);
+
+  /* Run loop cleanup */
+  g_mutex_unlock (&self->lock);
+  while (g_main_context_pending (context)) {
+    GST_DEBUG_OBJECT (self, "iterating main context to clean up");
+    g_main_context_iteration (context, FALSE);
+  }
+  g_main_context_pop_thread_default (context);
+  g_mutex_lock (&self->lock);
+
+  g_clear_pointer (&self->context, g_main_context_unref);
+
+  g_mutex_unlock (&self->lock);
+
+  /* The task only runs once per start */
+  gst_task_stop (self->task);
+
+  GST_DEBUG_OBJECT (self, "gst_rtmp2_server_src_task exiting");
+}
+
+/* Streams */
+
+static gboolean
+server_stream_src_query (GstPad * pad, GstObject * parent, GstQuery * query)
+{
+  switch (GST_QUERY_TYPE (query)) {
+    case GST_QUERY_LATENCY:
+      gst_query_set_latency (query, TRUE, 0, GST_CLOCK_TIME_NONE);
+      return TRUE;
+    case GST_QUERY_SCHEDULING:
+      gst_query_set_scheduling (query,
+          GST_SCHEDULING_FLAG_SEQUENTIAL |
+          GST_SCHEDULING_FLAG_BANDWIDTH_LIMITED, 1, -1, 0);
+      gst_query_add_scheduling_mode (query, GST_PAD_MODE_PUSH);
+      return TRUE;
+    default:
+      return gst_pad_query_default (pad, parent, query);
+  }
+}
+
+static gboolean
+remove_stream_cb (gpointer user_data)
+{
+  ServerStream *stream = user_data;
+  GstRtmp2ServerSrc *self = stream->self;
+
+  g_mutex_lock (&self->lock);
+  if (g_hash_table_lookup (self->streams, stream->key) != stream) {
+    /* Already removed by stop() */
+    g_mutex_unlock (&self->lock);
+    return G_SOURCE_REMOVE;
+  }
+  g_hash_table_steal (self->streams, stream->key);
+  g_mutex_unlock (&self->lock);
+
+  GST_INFO_OBJECT (self, "Removing stream '%s'", stream->key);
+
+  if (stream->client) {
+    stream->client->streams = g_list_remove (stream->client->streams, stream);
+    stream->client = NULL;
+  }
+
+  /* Stops the pad task */
+  gst_element_remove_pad (GST_ELEMENT (self), stream->pad);
+  server_stream_free (stream);
+
+  return G_SOURCE_REMOVE;
+}
+
+/* Called with self->lock, from any thread */
+static void
+server_stream_schedule_removal (ServerStream * stream)
+{
+  GstRtmp2ServerSrc *self = stream->self;
+  GSource *source;
+
+  if (!self->context)
+    return;
+
+  source = g_idle_source_new ();
+  g_source_set_callback (source, remove_stream_cb, stream, NULL);
+  g_source_attach (source, self->context);
+  g_source_unref (source);
+}
+
+static void
+server_stream_loop (gpointer user_data)
+{
+  ServerStream *stream = user_data;
+  GstRtmp2ServerSrc *self = stream->self;
+  GstBuffer *buffer;
+  GstFlowReturn ret;
+
+  g_mutex_lock (&self->lock);
+  while (g_queue_is_empty (&stream->queue) && !stream->eos &&
+      !stream->flushing) {
+    g_cond_wait (&stream->cond, &self->lock);
+  }
+
+  if (stream->flushing) {
+    g_mutex_unlock (&self->lock);
+    gst_pad_pause_task (stream->pad);
+    return;
+  }
+
+  buffer = g_queue_pop_head (&stream->queue);
+  if (buffer)
+    stream->queued_bytes -= gst_buffer_get_size (buffer);
+  g_mutex_unlock (&self->lock);
+
+  if (!stream->sent_events) {
+    gchar *stream_id;
+    GstCaps *caps;
+    GstSegment segment;
+
+    stream_id = gst_pad_create_stream_id (stream->pad, GST_ELEMENT (self),
+        stream->key);
+    gst_pad_push_event (stream->pad, gst_event_new_stream_start (stream_id));
+    g_free (stream_id);
+
+    caps = gst_pad_get_pad_template_caps (stream->pad);
+    gst_pad_push_event (stream->pad, gst_event_new_caps (caps));
+    gst_caps_unref (caps);
+
+    gst_segment_init (&segment, GST_FORMAT_TIME);
+    gst_pad_push_event (stream->pad, gst_event_new_segment (&segment));
+
+    stream->sent_events = TRUE;
+  }
+
+  if (!buffer) {
+    GST_INFO_OBJECT (stream->pad, "Stream '%s' ended", stream->key);
+    gst_pad_push_event (stream->pad, gst_event_new_eos ());
+    ret = GST_FLOW_EOS;
+    goto pause;
+  }
+
+  ret = gst_pad_push (stream->pad, buffer);
+  if (ret == GST_FLOW_OK)
+    return;
+
+  GST_INFO_OBJECT (stream->pad, "Stream '%s' pausing, reason %s", stream->key,
+      gst_flow_get_name (ret));
+
+  if (ret == GST_FLOW_NOT_NEGOTIATED || ret < GST_FLOW_EOS) {
+    GST_ELEMENT_FLOW_ERROR (self, ret);
+    gst_pad_push_event (stream->pad, gst_event_new_eos ());
+  }
+
+pause:
+  gst_pad_pause_task (stream->pad);
+
+  g_mutex_lock (&self->lock);
+  stream->flow = ret;
+  g_queue_clear_full (&stream->queue, (GDestroyNotify) gst_buffer_unref);
+  stream->queued_bytes = 0;
+
+  /* Once unpublished, nothing else will arrive for this stream */
+  if (stream->eos && !stream->flushing)
+    server_stream_schedule_removal (stream);
+  g_mutex_unlock (&self->lock);
+}
+
+static const gchar *
+amf_peek_string (const GstAmfNode * node)
+{
+  if (!node)
+    return NULL;
+
+  switch (gst_amf_node_get_type (node)) {
+    case GST_AMF_TYPE_STRING:
+    case GST_AMF_TYPE_LONG_STRING:
+      return gst_amf_node_peek_string (node, NULL);
+    default:
+      return NULL;
+  }
+}
+
+/* Takes the stream key from a publish argument, without query */
+static gchar *
+stream_key_from_name (const gchar * name)
+{
+  const gchar *query;
+
+  if (!name)
+    return NULL;
+
+  query = strchr (name, '?');
+  return query ? g_strndup (name, query - name) : g_strdup (name);
+}
+
+static ServerStream *
+server_stream_new (GstRtmp2ServerSrc * self, Client * client,
+    const gchar * key, guint32 stream_id)
+{
+  ServerStream *stream = g_slice_new0 (ServerStream);
+  gchar *name;
+
+  stream->self = self;
+  stream->key = g_strdup (key);
+  stream->client = client;
+  stream->stream_id = stream_id;
+  stream->flow = GST_FLOW_OK;
+  g_cond_init (&stream->cond);
+  g_queue_init (&stream->queue);
+
+  name = g_strdup_printf ("src_%s", key);
+  stream->pad = gst_pad_new_from_static_template
+      (&gst_rtmp2_server_src_src_template, name);
+  g_free (name);
+
+  gst_object_ref_sink (stream->pad);
+  gst_pad_use_fixed_caps (stream->pad);
+  gst_pad_set_query_function (stream->pad, server_stream_src_query);
+
+  return stream;
+}
+
+/* Called from the loop thread */
+static void
+server_stream_unpublish (ServerStream * stream)
+{
+  GstRtmp2ServerSrc *self = stream->self;
+  Client *client = stream->client;
+
+  GST_INFO_OBJECT (self, "Stream '%s' unpublished", stream->key);
+
+  if (client) {
+    client->streams = g_list_remove (client->streams, stream);
+    stream->client = NULL;
+  }
+
+  g_mutex_lock (&self->lock);
+  stream->eos = TRUE;
+  g_cond_signal (&stream->cond);
+
+  /* Without a running pad task nobody else removes it */
+  if (stream->flow != GST_FLOW_OK && !stream->flushing)
+    server_stream_schedule_removal (stream);
+  g_mutex_unlock (&self->lock);
+}
+
+/* Whether the message can be dropped when the queue is full. Without codec
+ * headers nothing can be decoded, and video can only resume after dropping
+ * with a keyframe. */
+static gboolean
+message_is_droppable (ServerStream * stream, GstBuffer * message,
+    GstRtmpMeta * meta, gboolean full)
+{
+  guint8 data[2] = { 0, };
+
+  /* The first tag carries the FLV header */
+  if (!stream->sent_header)
+    return FALSE;
+
+  gst_buffer_extract (message, 0, data, sizeof data);
+
+  switch (meta->type) {
+    case GST_RTMP_MESSAGE_TYPE_AUDIO:
+      /* AAC sequence header */
+      if ((data[0] >> 4) == 10 && data[1] == 0)
+        return FALSE;
+      return full;
+
+    case GST_RTMP_MESSAGE_TYPE_VIDEO:{
+      gboolean keyframe = (data[0] >> 4) == 1;
+
+      /* AVC sequence header */
+      if ((data[0] & 0x0f) == 7 && data[1] == 0)
+        return FALSE;
+
+      if (full || (stream->dropping_video && !keyframe)) {
+        stream->dropping_video = TRUE;
+        return TRUE;
+      }
+      stream->dropping_video = FALSE;
+      return FALSE;
+    }
+
+    default:
+      return FALSE;
+  }
+}
+
+static GstBuffer *
+message_to_flv_tag (ServerStream * stream, GstBuffer * message,
+    GstRtmpMeta * meta)
+{
+  static const guint8 flv_header_data[] = {
+    0x46, 0x4c, 0x56, 0x01, 0x05, 0x00, 0x00, 0x00,
+    0x09, 0x00, 0x00, 0x00, 0x00,
+  };
+
+  /* AMF0 string "@setDataFrame" */
+  static const guint8 set_data_frame[] = {
+    0x02, 0x00, 0x0d, '@', 's', 'e', 't', 'D', 'a', 't', 'a', 'F', 'r', 'a',
+    'm', 'e',
+  };
+
+  GstBuffer *buffer;
+  gsize offset = 0, size;
+  guint32 timestamp = 0;
+
+  /* Publishers wrap their metadata in @setDataFrame, which is not part of
+   * what is recorded into FLV */
+  if (meta->type == GST_RTMP_MESSAGE_TYPE_DATA_AMF0 &&
+      gst_buffer_memcmp (message, 0, set_data_frame,
+          sizeof set_data_frame) == 0) {
+    offset = sizeof set_data_frame;
+  }
+
+  size = gst_buffer_get_size (message) - offset;
+
+  if (GST_BUFFER_DTS_IS_VALID (message)) {
+    timestamp = GST_BUFFER_DTS (message) / GST_MSECOND;
+  }
+
+  buffer = gst_buffer_copy_region (message, GST_BUFFER_COPY_MEMORY, offset,
+      size);
+
+  {
+    guint8 *tag_header = g_malloc (11);
+    GstMemory *memory =
+        gst_memory_new_wrapped (0, tag_header, 11, 0, 11, tag_header, g_free);
+    GST_WRITE_UINT8 (tag_header, meta->type);
+    GST_WRITE_UINT24_BE (tag_header + 1, size);
+    GST_WRITE_UINT24_BE (tag_header + 4, timestamp);
+    GST_WRITE_UINT8 (tag_header + 7, timestamp >> 24);
+    GST_WRITE_UINT24_BE (tag_header + 8, 0);
+    gst_buffer_prepend_memory (buffer, memory);
+  }
+
+  {
+    guint8 *tag_footer = g_malloc (4);
+    GstMemory *memory =
+        gst_memory_new_wrapped (0, tag_footer, 4, 0, 4, tag_footer, g_free);
+    GST_WRITE_UINT32_BE (tag_footer, size + 11);
+    gst_buffer_append_memory (buffer, memory);
+  }
+
+  if (!stream->sent_header) {
+    GstMemory *memory = gst_memory_new_wrapped (GST_MEMORY_FLAG_READONLY,
+        (guint8 *) flv_header_data, sizeof flv_header_data, 0,
+        sizeof flv_header_data, NULL, NULL);
+    gst_buffer_prepend_memory (buffer, memory);
+    stream->sent_header = TRUE;
+  }
+
+  GST_BUFFER_DTS (buffer) = GST_BUFFER_DTS (message);
+
+  return buffer;
+}
+
+/* Clients */
+
+static void
+client_free (Client * client)
+{
+  g_clear_object (&client->socket_connection);
+  g_free (client->peer);
+  g_slice_free (Client, client);
+}
+
+static void
+client_close (Client * client)
+{
+  GstRtmp2ServerSrc *self = client->self;
+
+  GST_INFO_OBJECT (self, "Closing connection from %s", client->peer);
+
+  while (client->streams) {
+    server_stream_unpublish (client->streams->data);
+  }
+
+  self->clients = g_list_remove (self->clients, client);
+
+  if (client->connection) {
+    g_signal_handlers_disconnect_by_data (client->connection, client);
+    gst_rtmp_connection_set_input_handler (client->connection, NULL, NULL,
+        NULL);
+    gst_rtmp_connection_set_command_handler (client->connection, NULL, NULL,
+        NULL);
+    g_clear_pointer (&client->connection, gst_rtmp_connection_close_and_unref);
+  } else if (client->socket_connection) {
+    g_io_stream_close_async (G_IO_STREAM (client->socket_connection),
+        G_PRIORITY_DEFAULT, NULL, NULL, NULL);
+  }
+
+  client_free (client);
+}
+
+static gboolean
+on_incoming (GSocketService * service, GSocketConnection * connection,
+    GObject * source_object, gpointer user_data)
+{
+  GstRtmp2ServerSrc *self = GST_RTMP2_SERVER_SRC (user_data);
+  GSocketAddress *address;
+  Client *client;
+
+  client = g_slice_new0 (Client);
+  client->self = self;
+  client->socket_connection = g_object_ref (connection);
+  client->next_stream_id = 1;
+
+  address = g_socket_connection_get_remote_address (connection, NULL);
+  if (address && G_IS_INET_SOCKET_ADDRESS (address)) {
+    GInetSocketAddress *inet = G_INET_SOCKET_ADDRESS (address);
+    gchar *host = g_inet_address_to_string
+        (g_inet_socket_address_get_address (inet));
+    client->peer = g_strdup_printf ("%s:%u", host,
+        g_inet_socket_address_get_port (inet));
+    g_free (host);
+  } else {
+    client->peer = g_strdup ("unknown peer");
+  }
+  g_clear_object (&address);
+
+  GST_INFO_OBJECT (self, "Incoming connection from %s", client->peer);
+
+  self->clients = g_list_prepend (self->clients, client);
+
+  gst_rtmp_server_handshake (G_IO_STREAM (connection), FALSE,
+      self->cancellable, handshake_done, client);
+
+  return TRUE;
+}
+
+static void
+connection_error (GstRtmpConnection * connection, const GError * error,
+    Client * client)
+{
+  GST_INFO_OBJECT (client->self, "Connection from %s closed: %s",
+      client->peer, error->message);
+  client_close (client);
+}
+
+static void
+got_message (GstRtmpConnection * connection, GstBuffer * buffer,
+    gpointer user_data)
+{
+  Client *client = user_data;
+  GstRtmp2ServerSrc *self = client->self;
+  GstRtmpMeta *meta = gst_buffer_get_rtmp_meta (buffer);
+  ServerStream *stream = NULL;
+  GstBuffer *tag;
+  guint max_size_bytes;
+  gboolean full;
+  GList *l;
+
+  g_return_if_fail (meta);
+
+  switch (meta->type) {
+    case GST_RTMP_MESSAGE_TYPE_VIDEO:
+    case GST_RTMP_MESSAGE_TYPE_AUDIO:
+    case GST_RTMP_MESSAGE_TYPE_DATA_AMF0:
+      break;
+
+    default:
+      GST_DEBUG_OBJECT (self, "Ignoring %s message, wrong type",
+          gst_rtmp_message_type_get_nick (meta->type));
+      return;
+  }
+
+  for (l = client->streams; l; l = l->next) {
+    ServerStream *s = l->data;
+
+    if (s->stream_id == meta->mstream) {
+      stream = s;
+      break;
+    }
+  }
+
+  if (!stream) {
+    GST_DEBUG_OBJECT (self, "Ignoring %s message for unpublished stream %"
+        G_GUINT32_FORMAT, gst_rtmp_message_type_get_nick (meta->type),
+        meta->mstream);
+    return;
+  }
+
+  GST_OBJECT_LOCK (self);
+  max_size_bytes = self->max_size_bytes;
+  GST_OBJECT_UNLOCK (self);
+
+  g_mutex_lock (&self->lock);
+  if (stream->flow != GST_FLOW_OK || stream->flushing) {
+    g_mutex_unlock (&self->lock);
+    return;
+  }
+
+  full = max_size_bytes > 0 && stream->queued_bytes >= max_size_bytes;
+  if (message_is_droppable (stream, buffer, meta, full)) {
+    if (!stream->discont)
+      GST_WARNING_OBJECT (stream->pad, "Stream '%s' is not keeping up (%"
+          G_GSIZE_FORMAT " bytes queued), dropping messages", stream->key,
+          stream->queued_bytes);
+    stream->discont = TRUE;
+    self->messages_dropped++;
+    g_mutex_unlock (&self->lock);
+    return;
+  }
+
+  tag = message_to_flv_tag (stream, buffer, meta);
+  if (stream->discont) {
+    GST_BUFFER_FLAG_SET (tag, GST_BUFFER_FLAG_DISCONT);
+    stream->discont = FALSE;
+  }
+
+  stream->queued_bytes += gst_buffer_get_size (tag);
+  self->messages_queued++;
+  g_queue_push_tail (&stream->queue, tag);
+  g_cond_signal (&stream->cond);
+  g_mutex_unlock (&self->lock);
+}
+
+static void
+send_status (GstRtmpConnection * connection, guint32 stream_id,
+    const gchar * level, const gchar * code, const gchar * description)
+{
+  GstAmfNode *command_object, *info;
+
+  command_object = gst_amf_node_new_null ();
+  info = gst_amf_node_new_object ();
+  gst_amf_node_append_field_string (info, "level", level, -1);
+  gst_amf_node_append_field_string (info, "code", code, -1);
+  gst_amf_node_append_field_string (info, "description", description, -1);
+
+  gst_rtmp_connection_send_command (connection, NULL, NULL, stream_id,
+      "onStatus", command_object, info, NULL);
+
+  gst_amf_node_free (info);
+  gst_amf_node_free (command_object);
+}
+
+static void
+handle_connect (Client * client, gdouble transaction_id, GPtrArray * args)
+{
+  GstRtmp2ServerSrc *self = client->self;
+  GstRtmpConnection *connection = client->connection;
+  const GstAmfNode *node;
+  GstAmfNode *properties, *info;
+  const gchar *app = NULL;
+  gchar *application;
+  gboolean accept;
+
+  if (args->len > 0) {
+    node = g_ptr_array_index (args, 0);
+    if (gst_amf_node_get_type (node) == GST_AMF_TYPE_OBJECT)
+      app = amf_peek_string (gst_amf_node_get_field (node, "app"));
+  }
+
+  GST_OBJECT_LOCK (self);
+  application = g_strdup (self->application);
+  GST_OBJECT_UNLOCK (self);
+
+  if (application && app) {
+    const gchar *query = strchr (app, '?');
+    gsize len = query ? query - app : strlen (app);
+
+    accept = strlen (application) == len && strncmp (app, application, len)
+        == 0;
+  } else {
+    accept = application == NULL;
+  }
+  g_free (application);
+
+  info = gst_amf_node_new_object ();
+
+  if (!accept) {
+    GST_WARNING_OBJECT (self, "Rejecting %s connecting to application '%s'",
+        client->peer, GST_STR_NULL (app));
+
+    gst_amf_node_append_field_string (info, "level", "error", -1);
+    gst_amf_node_append_field_string (info, "code",
+        "NetConnection.Connect.Rejected", -1);
+    gst_amf_node_append_field_string (info, "description",
+        "Unknown application", -1);
+
+    properties = gst_amf_node_new_null ();
+    gst_rtmp_connection_send_response (connection, 0, transaction_id,
+        "_error", properties, info, NULL);
+    goto out;
+  }
+
+  GST_INFO_OBJECT (self, "%s connected to application '%s'", client->peer,
+      GST_STR_NULL (app));
+  client->connected = TRUE;
+
+  gst_rtmp_connection_request_window_size (connection,
+      GST_RTMP_DEFAULT_WINDOW_ACK_SIZE);
+
+  {
+    GstRtmpProtocolControl pc = {
+      .type = GST_RTMP_MESSAGE_TYPE_SET_PEER_BANDWIDTH,
+      .param = GST_RTMP_DEFAULT_WINDOW_ACK_SIZE,
+      .param2 = 2,              /* dynamic */
+    };
+
+    gst_rtmp_connection_queue_message (connection,
+        gst_rtmp_message_new_protocol_control (&pc));
+  }
+
+  properties = gst_amf_node_new_object ();
+  gst_amf_node_append_field_string (properties, "fmsVer", "FMS/3,0,1,123",
+      -1);
+  gst_amf_node_append_field_number (properties, "capabilities", 31);
+
+  gst_amf_node_append_field_string (info, "level", "status", -1);
+  gst_amf_node_append_field_string (info, "code",
+      "NetConnection.Connect.Success", -1);
+  gst_amf_node_append_field_string (info, "description",
+      "Connection succeeded.", -1);
+  gst_amf_node_append_field_number (info, "objectEncoding", 0);
+
+  gst_rtmp_connection_send_response (connection, 0, transaction_id,
+      "_result", properties, info, NULL);
+
+out:
+  gst_amf_node_free (properties);
+  gst_amf_node_free (info);
+}
+
+static void
+handle_publish (Client * client, guint32 stream_id, GPtrArray * args)
+{
+  GstRtmp2ServerSrc *self = client->self;
+  GstRtmpConnection *connection = client->connection;
+  ServerStream *stream;
+  const gchar *name = NULL;
+  gchar *key, *description;
+
+  if (args->len > 1) {
+    name = amf_peek_string (g_ptr_array_index (args, 1));
+  }
+
+  key = stream_key_from_name (name);
+
+  if (stream_id == 0 || !key || !key[0]) {
+    GST_WARNING_OBJECT (self, "%s tried to publish without a stream name",
+        client->peer);
+    send_status (connection, stream_id, "error", "NetStream.Publish.BadName",
+        "Invalid stream name");
+    goto out;
+  }
+
+  g_mutex_lock (&self->lock);
+  if (g_hash_table_contains (self->streams, key)) {
+    g_mutex_unlock (&self->lock);
+    GST_WARNING_OBJECT (self, "%s tried to publish '%s', which is already "
+        "being published", client->peer, key);
+    description = g_strdup_printf ("%s is already being published", key);
+    send_status (connection, stream_id, "error", "NetStream.Publish.BadName",
+        description);
+    g_free (description);
+    goto out;
+  }
+
+  stream = server_stream_new (self, client, key, stream_id);
+  g_hash_table_insert (self->streams, stream->key, stream);
+  g_mutex_unlock (&self->lock);
+
+  client->streams = g_list_prepend (client->streams, stream);
+
+  GST_INFO_OBJECT (self, "%s started publishing '%s' on stream %"
+      G_GUINT32_FORMAT, client->peer, key, stream_id);
+
+  gst_pad_set_active (stream->pad, TRUE);
+  gst_pad_start_task (stream->pad, server_stream_loop, stream, NULL);
+  gst_element_add_pad (GST_ELEMENT (self), stream->pad);
+
+  {
+    GstRtmpUserControl uc = {
+      .type = GST_RTMP_USER_CONTROL_TYPE_STREAM_BEGIN,
+      .param = stream_id,
+    };
+
+    gst_rtmp_connection_queue_message (connection,
+        gst_rtmp_message_new_user_control (&uc));
+  }
+
+  description = g_strdup_printf ("%s is now published.", key);
+  send_status (connection, stream_id, "status", "NetStream.Publish.Start",
+      description);
+  g_free (description);
+
+out:
+  g_free (key);
+}
+
+/* FCUnpublish and closeStream name the stream, deleteStream gives its ID;
+ * accept either for all of them */
+static void
+handle_unpublish (Client * client, guint32 stream_id, GPtrArray * args)
+{
+  const GstAmfNode *node = args->len > 1 ? g_ptr_array_index (args, 1) : NULL;
+  gchar *key = NULL;
+  GList *l;
+
+  if (node && gst_amf_node_get_type (node) == GST_AMF_TYPE_NUMBER) {
+    stream_id = gst_amf_node_get_number (node);
+  } else {
+    key = stream_key_from_name (amf_peek_string (node));
+  }
+
+  for (l = client->streams; l; l = l->next) {
+    ServerStream *stream = l->data;
+
+    if (key ? g_str_equal (stream->key, key) : stream->stream_id == stream_id) {
+      server_stream_unpublish (stream);
+      break;
+    }
+  }
+
+  g_free (key);
+}
+
+static void
+client_command (GstRtmpConnection * connection, guint32 stream_id,
+    const gchar * command_name, gdouble transaction_id, GPtrArray * args,
+    gpointer user_data)
+{
+  Client *client = user_data;
+  GstRtmp2ServerSrc *self = client->self;
+  GstAmfNode *null_node;
+
+  GST_DEBUG_OBJECT (self, "%s sent '%s' on stream %" G_GUINT32_FORMAT,
+      client->peer, command_name, stream_id);
+
+  if (g_strcmp0 (command_name, "connect") == 0) {
+    handle_connect (client, transaction_id, args);
+    return;
+  }
+
+  if (!client->connected) {
+    GST_WARNING_OBJECT (self, "%s sent '%s' before connecting", client->peer,
+        command_name);
+    return;
+  }
+
+  null_node = gst_amf_node_new_null ();
+
+  if (g_strcmp0 (command_name, "createStream") == 0) {
+    GstAmfNode *id = gst_amf_node_new_number (client->next_stream_id++);
+
+    gst_rtmp_connection_send_response (connection, 0, transaction_id,
+        "_result", null_node, id, NULL);
+    gst_amf_node_free (id);
+  } else if (g_strcmp0 (command_name, "publish") == 0) {
+    handle_publish (client, stream_id, args);
+  } else if (g_strcmp0 (command_name, "FCUnpublish") == 0 ||
+      g_strcmp0 (command_name, "closeStream") == 0 ||
+      g_strcmp0 (command_name, "deleteStream") == 0) {
+    handle_unpublish (client, stream_id, args);
+  } else if (g_strcmp0 (command_name, "releaseStream") == 0 ||
+      g_strcmp0 (command_name, "FCPublish") == 0) {
+    /* Nothing to do, streams go away on unpublish */
+    if (transaction_id != 0)
+      gst_rtmp_connection_send_response (connection, 0, transaction_id,
+          "_result", null_node, NULL);
+  } else {
+    GST_FIXME_OBJECT (self, "Unhandled command '%s' from %s", command_name,
+        client->peer);
+    if (transaction_id != 0)
+      gst_rtmp_connection_send_response (connection, 0, transaction_id,
+          "_error", null_node, NULL);
+  }
+
+  gst_amf_node_free (null_node);
+}
+
+static void
+handshake_done (GObject * source, GAsyncResult * result, gpointer user_data)
+{
+  GIOStream *stream = G_IO_STREAM (source);
+  Client *client = user_data;
+  GstRtmp2ServerSrc *self = client->self;
+  GError *error = NULL;
+
+  if (!gst_rtmp_server_handshake_finish (stream, result, &error)) {
+    if (g_error_matches (error, G_IO_ERROR, G_IO_ERROR_CANCELLED)) {
+      GST_DEBUG_OBJECT (self, "Handshake with %s cancelled", client->peer);
+    } else {
+      GST_WARNING_OBJECT (self, "Handshake with %s failed: %s", client->peer,
+          error->message);
+    }
+    g_error_free (error);
+    client_close (client);
+    return;
+  }
+
+  client->connection = gst_rtmp_connection_new (client->socket_connection,
+      self->cancellable);
+  g_clear_object (&client->socket_connection);
+
+  gst_rtmp_connection_set_input_handler (client->connection, got_message,
+      client, NULL);
+  gst_rtmp_connection_set_command_handler (client->connection,
+      client_command, client, NULL);
+  g_signal_connect (client->connection, "error",
+      G_CALLBACK (connection_error), client);
+}
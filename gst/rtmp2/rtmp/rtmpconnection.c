@@ -74,6 +74,10 @@ struct _GstRtmpConnection
   gpointer output_handler_user_data;
   GDestroyNotify output_handler_user_data_destroy;
 
+  GstRtmpConnectionCommandFunc command_handler;
+  gpointer command_handler_user_data;
+  GDestroyNotify command_handler_user_data_destroy;
+
   gboolean writing;
 
   /* Protects the values below during concurrent access.
@@ -284,6 +288,7 @@ gst_rtmp_connection_dispose (GObject * object)
   g_cancellable_cancel (rtmpconnection->cancellable);
   gst_rtmp_connection_set_input_handler (rtmpconnection, NULL, NULL, NULL);
   gst_rtmp_connection_set_output_handler (rtmpconnection, NULL, NULL, NULL);
+  gst_rtmp_connection_set_command_handler (rtmpconnection, NULL, NULL, NULL);
   gst_rtmp_connection_set_cancellable (rtmpconnection, NULL);
 
   G_OBJECT_CLASS (gst_rtmp_connection_parent_class)->dispose (object);
@@ -457,6 +462,23 @@ gst_rtmp_connection_set_output_handler (GstRtmpConnection * sc,
   sc->output_handler_user_data_destroy = user_data_destroy;
 }
 
+/* Called for commands that are neither responses nor expected with
+ * gst_rtmp_connection_expect_command(), which is how a server learns about
+ * the requests of its peer */
+void
+gst_rtmp_connection_set_command_handler (GstRtmpConnection * sc,
+    GstRtmpConnectionCommandFunc callback, gpointer user_data,
+    GDestroyNotify user_data_destroy)
+{
+  if (sc->command_handler_user_data_destroy) {
+    sc->command_handler_user_data_destroy (sc->command_handler_user_data);
+  }
+
+  sc->command_handler = callback;
+  sc->command_handler_user_data = user_data;
+  sc->command_handler_user_data_destroy = user_data_destroy;
+}
+
 static gboolean
 gst_rtmp_connection_input_ready (GInputStream * is, gpointer user_data)
 {
@@ -670,26 +692,28 @@ static void
 gst_rtmp_connection_do_read (GstRtmpConnection * sc)
 {
   GByteArray *input_bytes = sc->input_bytes;
-  gsize needed_bytes = 1;
+  gsize needed_bytes = 1, offset = 0;
 
+  /* Parse all complete chunks first and drop the consumed input once at the
+   * end, instead of moving the rest of the input down after every chunk */
   while (1) {
     GstRtmpChunkStream *cstream;
     guint32 chunk_stream_id, header_size, next_size;
+    const guint8 *input = input_bytes->data + offset;
+    gsize len = input_bytes->len - offset;
     guint8 *data;
 
-    chunk_stream_id = gst_rtmp_chunk_stream_parse_id (input_bytes->data,
-        input_bytes->len);
+    chunk_stream_id = gst_rtmp_chunk_stream_parse_id (input, len);
 
     if (!chunk_stream_id) {
-      needed_bytes = input_bytes->len + 1;
+      needed_bytes = len + 1;
       break;
     }
 
     cstream = gst_rtmp_chunk_streams_get (sc->input_streams, chunk_stream_id);
-    header_size = gst_rtmp_chunk_stream_parse_header (cstream,
-        input_bytes->data, input_bytes->len);
+    header_size = gst_rtmp_chunk_stream_parse_header (cstream, input, len);
 
-    if (input_bytes->len < header_size) {
+    if (len < header_size) {
       needed_bytes = header_size;
       break;
     }
@@ -697,13 +721,13 @@ gst_rtmp_connection_do_read (GstRtmpConnection * sc)
     next_size = gst_rtmp_chunk_stream_parse_payload (cstream,
         sc->in_chunk_size, &data);
 
-    if (input_bytes->len < header_size + next_size) {
+    if (len < header_size + next_size) {
       needed_bytes = header_size + next_size;
       break;
     }
 
-    memcpy (data, input_bytes->data + header_size, next_size);
-    gst_rtmp_connection_take_input_bytes (sc, header_size + next_size, NULL);
+    memcpy (data, input + header_size, next_size);
+    offset += header_size + next_size;
 
     next_size = gst_rtmp_chunk_stream_wrote_payload (cstream,
         sc->in_chunk_size);
@@ -715,6 +739,7 @@ gst_rtmp_connection_do_read (GstRtmpConnection * sc)
     }
   }
 
+  gst_rtmp_connection_take_input_bytes (sc, offset, NULL);
   gst_rtmp_connection_start_read (sc, needed_bytes);
 }
 
@@ -1035,7 +1060,12 @@ gst_rtmp_connection_handle_cm (GstRtmpConnection * sc, GstBuffer * buffer)
     return;
   }
 
-  if (!isfinite (transaction_id) || transaction_id < 0 ||
+  /* With a command handler, the requests of the peer are numbered by the
+   * peer and have nothing to do with our transactions */
+  if (sc->command_handler && !is_command_response (command_name)) {
+    GST_LOG_OBJECT (sc, "Peer sent request \"%s\" with transaction ID %.0f",
+        GST_STR_NULL (command_name), transaction_id);
+  } else if (!isfinite (transaction_id) || transaction_id < 0 ||
       transaction_id > G_MAXUINT) {
     GST_WARNING_OBJECT (sc,
         "Server sent command \"%s\" with extreme transaction ID %.0f",
@@ -1077,7 +1107,7 @@ gst_rtmp_connection_handle_cm (GstRtmpConnection * sc, GstBuffer * buffer)
   } else {
     GList *l;
 
-    if (transaction_id != 0) {
+    if (transaction_id != 0 && !sc->command_handler) {
       GST_FIXME_OBJECT (sc, "Server sent command \"%s\" expecting reply",
           GST_STR_NULL (command_name));
     }
@@ -1100,6 +1130,13 @@ gst_rtmp_connection_handle_cm (GstRtmpConnection * sc, GstBuffer * buffer)
       g_list_free_full (l, expected_command_free);
       break;
     }
+
+    if (!l && sc->command_handler) {
+      GST_LOG_OBJECT (sc, "calling command handler %s",
+          GST_DEBUG_FUNCPTR_NAME (sc->command_handler));
+      sc->command_handler (sc, meta->mstream, command_name, transaction_id,
+          args, sc->command_handler_user_data);
+    }
   }
 
   g_free (command_name);
@@ -1180,6 +1217,40 @@ gst_rtmp_connection_send_command (GstRtmpConnection * connection,
   return transaction_id;
 }
 
+void
+gst_rtmp_connection_send_response (GstRtmpConnection * connection,
+    guint32 stream_id, gdouble transaction_id, const gchar * command_name,
+    const GstAmfNode * argument, ...)
+{
+  GstBuffer *buffer;
+  va_list ap;
+  GBytes *payload;
+  guint8 *data;
+  gsize size;
+
+  g_return_if_fail (GST_IS_RTMP_CONNECTION (connection));
+  g_return_if_fail (is_command_response (command_name));
+
+  if (connection->thread != g_thread_self ()) {
+    GST_ERROR_OBJECT (connection, "Called from wrong thread");
+  }
+
+  GST_DEBUG_OBJECT (connection,
+      "Sending response '%s' to transaction %.0f on stream id %"
+      G_GUINT32_FORMAT, command_name, transaction_id, stream_id);
+
+  va_start (ap, argument);
+  payload = gst_amf_serialize_command_valist (transaction_id,
+      command_name, argument, ap);
+  va_end (ap);
+
+  data = g_bytes_unref_to_data (payload, &size);
+  buffer = gst_rtmp_message_new_wrapped (GST_RTMP_MESSAGE_TYPE_COMMAND_AMF0,
+      3, stream_id, data, size);
+
+  gst_rtmp_connection_queue_message (connection, buffer);
+}
+
 void
 gst_rtmp_connection_expect_command (GstRtmpConnection * connection,
     GstRtmpCommandCallback response_command, gpointer user_data,
@@ -48,6 +48,10 @@ typedef void (*GstRtmpConnectionMessageFunc)
 
 typedef void (*GstRtmpCommandCallback) (const gchar * command_name,
     GPtrArray * arguments, gpointer user_data);
+typedef void (*GstRtmpConnectionCommandFunc)
+    (GstRtmpConnection * connection, guint32 stream_id,
+    const gchar * command_name, gdouble transaction_id, GPtrArray * arguments,
+    gpointer user_data);
 
 GType gst_rtmp_connection_get_type (void);
 
@@ -66,6 +70,10 @@ void gst_rtmp_connection_set_output_handler (GstRtmpConnection * connection,
     GstRtmpConnectionFunc callback, gpointer user_data,
     GDestroyNotify user_data_destroy);
 
+void gst_rtmp_connection_set_command_handler (GstRtmpConnection * connection,
+    GstRtmpConnectionCommandFunc callback, gpointer user_data,
+    GDestroyNotify user_data_destroy);
+
 void gst_rtmp_connection_queue_bytes (GstRtmpConnection *self,
     GBytes * bytes);
 void gst_rtmp_connection_queue_message (GstRtmpConnection * connection,
@@ -77,6 +85,10 @@ guint gst_rtmp_connection_send_command (GstRtmpConnection * connection,
     guint32 stream_id, const gchar * command_name, const GstAmfNode * argument,
     ...) G_GNUC_NULL_TERMINATED;
 
+void gst_rtmp_connection_send_response (GstRtmpConnection * connection,
+    guint32 stream_id, gdouble transaction_id, const gchar * command_name,
+    const GstAmfNode * argument, ...) G_GNUC_NULL_TERMINATED;
+
 void gst_rtmp_connection_expect_command (GstRtmpConnection * connection,
     GstRtmpCommandCallback response_command, gpointer user_data,
     guint32 stream_id, const gchar * command_name);
@@ -38,12 +38,32 @@
 #include <gst/gstprotection.h>
 #include "gstipcpipelinecomm.h"
 
+#ifdef HAVE_MEMFD_CREATE
+#  include <poll.h>
+#  include <sys/socket.h>
+#  include <sys/stat.h>
+#  include <gst/allocators/gstfdmemory.h>
+#  include "gstipcpipelinememfdallocator.h"
+#  ifdef SCM_RIGHTS
+#    define HAVE_FD_PASSING 1
+#  endif
+#endif
+
 GST_DEBUG_CATEGORY_STATIC (gst_ipc_pipeline_comm_debug);
 #define GST_CAT_DEFAULT gst_ipc_pipeline_comm_debug
 
 #define DEFAULT_ACK_TIME (10 * G_TIME_SPAN_SECOND)
 
+/* Buffers smaller than this are cheaper to write to the socket than to copy
+ * into a memfd */
+#define MEMFD_MIN_COPY_SIZE (64 * 1024)
+/* Maximum number of fds received along with a single read */
+#define MAX_RECEIVED_FDS 16
+/* The fd of the slot is attached to the FD_BUFFER chunk */
+#define SLOT_FLAG_NEW_FD 1
+
 GQuark QUARK_ID;
+static GQuark QUARK_SLOT;
 
 typedef enum
 {
@@ -72,6 +92,49 @@ typedef struct
   GCond cond;
 } CommRequest;
 
+/* Sender side: the memfd slots assigned to memories sent on a connection,
+ * and the slots the peer can forget because their memory is gone. The
+ * memories refer to it from their qdata, so this can outlive the comm. */
+struct _GstIpcPipelineCommSlots
+{
+  gint refcount;
+  GMutex lock;
+  guint32 next_id;
+  GArray *dropped;
+};
+
+typedef struct
+{
+  GstIpcPipelineCommSlots *slots;
+  guint32 id;
+} CommSlot;
+
+/* Receiver side: a memfd received from the peer, mapped once */
+typedef struct
+{
+  gint refcount;
+  GstMemory *mem;
+  GstMapInfo map;
+} CommMappedSlot;
+
+/* Receiver side: sends a release for buffer @id when the memory wrapping
+ * part of @slot is freed */
+typedef struct
+{
+  GstIpcPipelineComm *comm;
+  GstElement *element;
+  CommMappedSlot *slot;
+  guint32 id;
+  guint generation;
+} CommRelease;
+
+/* Sender side: a buffer whose ACK was not waited for yet */
+typedef struct
+{
+  guint32 id;
+  GHashTable *waiting_ids;
+} CommInFlight;
+
 static const gchar *comm_request_ret_get_name (CommRequestType type,
     guint32 ret);
 static guint32 comm_request_ret_get_failure_value (CommRequestType type);
@@ -135,6 +198,95 @@ comm_request_free (CommRequest * req)
   g_free (req);
 }
 
+static void
+comm_in_flight_free (CommInFlight * in_flight)
+{
+  g_hash_table_remove (in_flight->waiting_ids,
+      GINT_TO_POINTER (in_flight->id));
+  g_hash_table_unref (in_flight->waiting_ids);
+  g_free (in_flight);
+}
+
+static GstIpcPipelineCommSlots *
+comm_slots_new (void)
+{
+  GstIpcPipelineCommSlots *slots;
+
+  slots = g_new0 (GstIpcPipelineCommSlots, 1);
+  slots->refcount = 1;
+  g_mutex_init (&slots->lock);
+  slots->dropped = g_array_new (FALSE, FALSE, sizeof (guint32));
+
+  return slots;
+}
+
+static void
+comm_slots_unref (GstIpcPipelineCommSlots * slots)
+{
+  if (!g_atomic_int_dec_and_test (&slots->refcount))
+    return;
+
+  g_array_unref (slots->dropped);
+  g_mutex_clear (&slots->lock);
+  g_free (slots);
+}
+
+static CommSlot *
+comm_slot_new (GstIpcPipelineCommSlots * slots)
+{
+  CommSlot *slot;
+
+  slot = g_new (CommSlot, 1);
+  g_atomic_int_inc (&slots->refcount);
+  slot->slots = slots;
+  g_mutex_lock (&slots->lock);
+  slot->id = ++slots->next_id;
+  g_mutex_unlock (&slots->lock);
+
+  return slot;
+}
+
+/* Called from any thread when the memory the slot was assigned to is freed,
+ * the peer is told to unmap it along with the next FD_BUFFER */
+static void
+comm_slot_free (CommSlot * slot)
+{
+  g_mutex_lock (&slot->slots->lock);
+  g_array_append_val (slot->slots->dropped, slot->id);
+  g_mutex_unlock (&slot->slots->lock);
+  comm_slots_unref (slot->slots);
+  g_free (slot);
+}
+
+#ifdef HAVE_FD_PASSING
+static CommMappedSlot *
+comm_mapped_slot_ref (CommMappedSlot * slot)
+{
+  g_atomic_int_inc (&slot->refcount);
+  return slot;
+}
+#endif
+
+static void
+comm_mapped_slot_unref (CommMappedSlot * slot)
+{
+  if (!g_atomic_int_dec_and_test (&slot->refcount))
+    return;
+
+  gst_memory_unmap (slot->mem, &slot->map);
+  gst_memory_unref (slot->mem);
+  g_free (slot);
+}
+
+static void
+close_received_fds (GstIpcPipelineComm * comm)
+{
+#ifdef HAVE_FD_PASSING
+  while (!g_queue_is_empty (&comm->received_fds))
+    close (GPOINTER_TO_INT (g_queue_pop_head (&comm->received_fds)));
+#endif
+}
+
 static const gchar *
 comm_request_ret_get_name (CommRequestType type, guint32 ret)
 {
@@ -193,6 +345,10 @@ gst_ipc_pipeline_comm_data_type_get_name (GstIpcPipelineCommDataType type)
       return "MESSAGE";
     case GST_IPC_PIPELINE_COMM_DATA_TYPE_GERROR_MESSAGE:
       return "GERROR_MESSAGE";
+    case GST_IPC_PIPELINE_COMM_DATA_TYPE_FD_BUFFER:
+      return "FD_BUFFER";
+    case GST_IPC_PIPELINE_COMM_DATA_TYPE_RELEASE:
+      return "RELEASE";
     default:
       return "UNKNOWN";
   }
@@ -219,6 +375,23 @@ gst_ipc_pipeline_comm_sync_fd (GstIpcPipelineComm * comm, guint32 id,
   return !comm_error;
 }
 
+#ifdef HAVE_FD_PASSING
+/* Waits until fdout can be written to without blocking, when it is non
+ * blocking. Errors are left to the next write. */
+static void
+wait_fdout_writable (GstIpcPipelineComm * comm)
+{
+  struct pollfd pfd;
+  int ret;
+
+  pfd.fd = comm->fdout;
+  pfd.events = POLLOUT;
+  do {
+    ret = poll (&pfd, 1, -1);
+  } while (ret < 0 && errno == EINTR);
+}
+#endif
+
 static gboolean
 write_to_fd_raw (GstIpcPipelineComm * comm, const void *data, size_t size)
 {
@@ -246,8 +419,13 @@ write_to_fd_raw (GstIpcPipelineComm * comm, const void *data, size_t size)
     ssize_t written =
         write (comm->fdout, (const unsigned char *) data + offset, size);
     if (written < 0) {
-      if (errno == EAGAIN || errno == EINTR)
+      if (errno == EAGAIN || errno == EINTR) {
+#ifdef HAVE_FD_PASSING
+        if (errno == EAGAIN)
+          wait_fdout_writable (comm);
+#endif
         continue;
+      }
       GST_ERROR_OBJECT (comm->element, "Failed to write to fd: %s",
           strerror (errno));
       ret = FALSE;
@@ -519,6 +697,299 @@ typedef struct
   guint64 flags;
 } CommBufferMetadata;
 
+/* Registers the ACK of buffer @id to be waited for later, so that more
+ * buffers can be sent meanwhile */
+static void
+gst_ipc_pipeline_comm_add_in_flight (GstIpcPipelineComm * comm, guint32 id)
+{
+  CommInFlight *in_flight;
+
+  in_flight = g_new (CommInFlight, 1);
+  in_flight->id = id;
+  in_flight->waiting_ids = g_hash_table_ref (comm->waiting_ids);
+  g_hash_table_insert (in_flight->waiting_ids, GINT_TO_POINTER (id),
+      comm_request_new (id, COMM_REQUEST_TYPE_BUFFER, NULL));
+  g_queue_push_tail (&comm->in_flight, in_flight);
+}
+
+/* Waits for the ACKs of the oldest buffers in flight until at most
+ * @max_in_flight are left, keeping the first error in comm->in_flight_ret.
+ * Must be called with comm->mutex held. */
+static void
+gst_ipc_pipeline_comm_wait_in_flight (GstIpcPipelineComm * comm,
+    guint max_in_flight)
+{
+  while (g_queue_get_length (&comm->in_flight) > max_in_flight) {
+    CommInFlight *in_flight = g_queue_pop_head (&comm->in_flight);
+    guint32 ret = GST_FLOW_COMM_ERROR;
+    CommRequest *req;
+
+    req = g_hash_table_lookup (in_flight->waiting_ids,
+        GINT_TO_POINTER (in_flight->id));
+    if (req)
+      ret = comm_request_wait (comm, req, ACK_TYPE_BLOCKING);
+    if (ret != GST_FLOW_OK && comm->in_flight_ret == GST_FLOW_OK)
+      comm->in_flight_ret = ret;
+    comm_in_flight_free (in_flight);
+  }
+}
+
+#ifdef HAVE_FD_PASSING
+typedef enum
+{
+  FD_BUFFER_WRITTEN,
+  FD_BUFFER_UNSUPPORTED,
+  FD_BUFFER_WRITE_FAILED,
+} FdBufferResult;
+
+static GstAllocator *
+ensure_memfd_allocator (GstIpcPipelineComm * comm)
+{
+  if (!comm->memfd_allocator) {
+    comm->memfd_allocator =
+        gst_object_ref_sink (g_object_new
+        (GST_TYPE_IPC_PIPELINE_MEMFD_ALLOCATOR, NULL));
+  }
+  return comm->memfd_allocator;
+}
+
+static gboolean
+fdout_can_pass_fds (GstIpcPipelineComm * comm)
+{
+  struct sockaddr_storage addr;
+  socklen_t len = sizeof (addr);
+
+  if (getsockname (comm->fdout, (struct sockaddr *) &addr, &len) < 0
+      || addr.ss_family != AF_UNIX) {
+    GST_WARNING_OBJECT (comm->element, "fdout %d is not a UNIX socket, "
+        "buffers will be copied through it", comm->fdout);
+    return FALSE;
+  }
+  return TRUE;
+}
+
+/* Like write_byte_writer_to_fd(), passing @fd along with the data */
+static gboolean
+write_byte_writer_with_fd_to_fd (GstIpcPipelineComm * comm,
+    GstByteWriter * bw, int fd)
+{
+  union
+  {
+    struct cmsghdr hdr;
+    char buf[CMSG_SPACE (sizeof (int))];
+  } control;
+  struct msghdr msg = { 0 };
+  struct cmsghdr *cmsg;
+  struct iovec iov;
+  guint8 *data;
+  ssize_t written;
+  gboolean ret;
+  guint size;
+
+  size = gst_byte_writer_get_size (bw);
+  data = gst_byte_writer_reset_and_get_data (bw);
+  if (!data)
+    return FALSE;
+
+  iov.iov_base = data;
+  iov.iov_len = size;
+  msg.msg_iov = &iov;
+  msg.msg_iovlen = 1;
+  memset (&control, 0, sizeof (control));
+  msg.msg_control = control.buf;
+  msg.msg_controllen = sizeof (control.buf);
+  cmsg = CMSG_FIRSTHDR (&msg);
+  cmsg->cmsg_level = SOL_SOCKET;
+  cmsg->cmsg_type = SCM_RIGHTS;
+  cmsg->cmsg_len = CMSG_LEN (sizeof (int));
+  memcpy (CMSG_DATA (cmsg), &fd, sizeof (int));
+
+  GST_TRACE_OBJECT (comm->element, "Writing %u bytes and fd %d to fdout",
+      size, fd);
+  while ((written = sendmsg (comm->fdout, &msg, 0)) < 0) {
+    if (errno == EAGAIN)
+      wait_fdout_writable (comm);
+    else if (errno != EINTR)
+      break;
+  }
+
+  if (written < 0) {
+    GST_ERROR_OBJECT (comm->element, "Failed to write to fd: %s",
+        strerror (errno));
+    ret = FALSE;
+  } else {
+    /* the fd went along with the first bytes, the rest is plain data */
+    ret = write_to_fd_raw (comm, data + written, size - written);
+  }
+  g_free (data);
+  return ret;
+}
+
+/* Returns a buffer with the contents of @buffer in a single fd memory:
+ * @buffer itself if it already is one, or a copy in a memfd of our own
+ * pool. Returns NULL if @buffer is better written to the socket. */
+static GstBuffer *
+gst_ipc_pipeline_comm_get_fd_buffer (GstIpcPipelineComm * comm,
+    GstBuffer * buffer)
+{
+  GstBuffer *fdbuf = NULL;
+  GstStructure *config;
+  GstMapInfo map;
+  gsize size;
+
+  /* The peer only maps memfds sealed against resizing, like those of our
+   * allocator, other fd memory (dmabuf, ...) is copied */
+  if (gst_buffer_n_memory (buffer) == 1
+      && gst_is_fd_memory (gst_buffer_peek_memory (buffer, 0))
+      && gst_ipc_pipeline_memfd_is_sealed (gst_fd_memory_get_fd
+          (gst_buffer_peek_memory (buffer, 0))))
+    return gst_buffer_ref (buffer);
+
+  size = gst_buffer_get_size (buffer);
+  if (size < MEMFD_MIN_COPY_SIZE)
+    return NULL;
+
+  if (!comm->memfd_pool || size > comm->memfd_pool_size) {
+    if (comm->memfd_pool) {
+      gst_buffer_pool_set_active (comm->memfd_pool, FALSE);
+      gst_object_unref (comm->memfd_pool);
+    }
+
+    GST_DEBUG_OBJECT (comm->element, "Creating memfd pool of %"
+        G_GSIZE_FORMAT " byte buffers", size);
+    comm->memfd_pool = gst_buffer_pool_new ();
+    comm->memfd_pool_size = size;
+    config = gst_buffer_pool_get_config (comm->memfd_pool);
+    gst_buffer_pool_config_set_params (config, NULL, size, 0, 0);
+    gst_buffer_pool_config_set_allocator (config,
+        ensure_memfd_allocator (comm), NULL);
+    if (!gst_buffer_pool_set_config (comm->memfd_pool, config)
+        || !gst_buffer_pool_set_active (comm->memfd_pool, TRUE)) {
+      GST_WARNING_OBJECT (comm->element, "Failed to set up memfd pool");
+      gst_clear_object (&comm->memfd_pool);
+      return NULL;
+    }
+  }
+
+  if (gst_buffer_pool_acquire_buffer (comm->memfd_pool, &fdbuf,
+          NULL) != GST_FLOW_OK)
+    return NULL;
+
+  if (!gst_buffer_map (fdbuf, &map, GST_MAP_WRITE)) {
+    gst_buffer_unref (fdbuf);
+    return NULL;
+  }
+  gst_buffer_extract (buffer, 0, map.data, size);
+  gst_buffer_unmap (fdbuf, &map);
+  gst_buffer_set_size (fdbuf, size);
+
+  return fdbuf;
+}
+
+/* Writes an FD_BUFFER chunk for @buffer up to the meta list, passing the
+ * memfd of its memory along the first time it is sent. The buffer is then
+ * held until the peer releases it. */
+static FdBufferResult
+gst_ipc_pipeline_comm_write_fd_buffer_header (GstIpcPipelineComm * comm,
+    GstBuffer * buffer, const CommBufferMetadata * meta, guint32 meta_size)
+{
+  const unsigned char payload_type =
+      GST_IPC_PIPELINE_COMM_DATA_TYPE_FD_BUFFER;
+  FdBufferResult res = FD_BUFFER_WRITE_FAILED;
+  GstMemory *mem, *root;
+  GstBuffer *fdbuf;
+  CommSlot *slot;
+  GArray *dropped;
+  GstByteWriter bw;
+  guint32 flags = 0, size, n;
+
+  if (comm->fd_passing_failed)
+    return FD_BUFFER_UNSUPPORTED;
+
+  fdbuf = gst_ipc_pipeline_comm_get_fd_buffer (comm, buffer);
+  if (!fdbuf)
+    return FD_BUFFER_UNSUPPORTED;
+
+  mem = gst_buffer_peek_memory (fdbuf, 0);
+  root = mem->parent ? mem->parent : mem;
+
+  /* The slot identifies the memfd to the peer for as long as the memory
+   * lives, a recycled buffer does not need to pass it again */
+  slot = gst_mini_object_get_qdata (GST_MINI_OBJECT_CAST (root), QUARK_SLOT);
+  if (!slot || slot->slots != comm->slots) {
+    if (!fdout_can_pass_fds (comm)) {
+      comm->fd_passing_failed = TRUE;
+      gst_buffer_unref (fdbuf);
+      return FD_BUFFER_UNSUPPORTED;
+    }
+    slot = comm_slot_new (comm->slots);
+    gst_mini_object_set_qdata (GST_MINI_OBJECT_CAST (root), QUARK_SLOT, slot,
+        (GDestroyNotify) comm_slot_free);
+    flags |= SLOT_FLAG_NEW_FD;
+  }
+
+  g_mutex_lock (&comm->slots->lock);
+  dropped = comm->slots->dropped;
+  comm->slots->dropped = g_array_new (FALSE, FALSE, sizeof (guint32));
+  g_mutex_unlock (&comm->slots->lock);
+
+  GST_TRACE_OBJECT (comm->element, "Writing buffer %u in slot %u%s, "
+      "dropping %u slots", comm->send_id, slot->id,
+      (flags & SLOT_FLAG_NEW_FD) ? " with its fd" : "", dropped->len);
+
+  gst_byte_writer_init (&bw);
+  if (!gst_byte_writer_put_uint8 (&bw, payload_type))
+    goto done;
+  if (!gst_byte_writer_put_uint32_le (&bw, comm->send_id))
+    goto done;
+  size = sizeof (CommBufferMetadata) + 4 + 4 + 8 + 8 + 4 + 4 +
+      dropped->len * sizeof (guint32) + meta_size;
+  if (!gst_byte_writer_put_uint32_le (&bw, size))
+    goto done;
+  if (!gst_byte_writer_put_data (&bw, (const guint8 *) meta, sizeof (*meta)))
+    goto done;
+  if (!gst_byte_writer_put_uint32_le (&bw, slot->id))
+    goto done;
+  if (!gst_byte_writer_put_uint32_le (&bw, flags))
+    goto done;
+  if (!gst_byte_writer_put_uint64_le (&bw, root->maxsize))
+    goto done;
+  if (!gst_byte_writer_put_uint64_le (&bw, mem->offset))
+    goto done;
+  if (!gst_byte_writer_put_uint32_le (&bw, mem->size))
+    goto done;
+  if (!gst_byte_writer_put_uint32_le (&bw, dropped->len))
+    goto done;
+  for (n = 0; n < dropped->len; n++) {
+    if (!gst_byte_writer_put_uint32_le (&bw,
+            g_array_index (dropped, guint32, n)))
+      goto done;
+  }
+
+  if (flags & SLOT_FLAG_NEW_FD) {
+    if (!write_byte_writer_with_fd_to_fd (comm, &bw,
+            gst_fd_memory_get_fd (root)))
+      goto done;
+  } else {
+    if (!write_byte_writer_to_fd (comm, &bw))
+      goto done;
+  }
+
+  /* the peer maps the memory until it releases the buffer */
+  g_hash_table_insert (comm->held_buffers, GINT_TO_POINTER (comm->send_id),
+      fdbuf);
+  fdbuf = NULL;
+  res = FD_BUFFER_WRITTEN;
+
+done:
+  if (fdbuf)
+    gst_buffer_unref (fdbuf);
+  gst_byte_writer_reset (&bw);
+  g_array_unref (dropped);
+  return res;
+}
+#endif
+
 GstFlowReturn
 gst_ipc_pipeline_comm_write_buffer_to_fd (GstIpcPipelineComm * comm,
     GstBuffer * buffer)
@@ -531,8 +1002,21 @@ gst_ipc_pipeline_comm_write_buffer_to_fd (GstIpcPipelineComm * comm,
   GstFlowReturn ret;
   MetaListRepresentation repr = { comm, 0, 4, NULL };   /* starts a 4 for n_meta */
   GstByteWriter bw;
+  gboolean written = FALSE;
 
   g_mutex_lock (&comm->mutex);
+
+  /* An error returned for a buffer in flight is returned for this one
+   * instead, the peer would reject it the same way */
+  if (comm->in_flight_ret != GST_FLOW_OK) {
+    ret = comm->in_flight_ret;
+    comm->in_flight_ret = GST_FLOW_OK;
+    g_mutex_unlock (&comm->mutex);
+    GST_DEBUG_OBJECT (comm->element, "Buffer in flight returned %s",
+        gst_flow_get_name (ret));
+    return ret;
+  }
+
   ++comm->send_id;
 
   GST_TRACE_OBJECT (comm->element, "Writing buffer %u: %" GST_PTR_FORMAT,
@@ -550,29 +1034,47 @@ gst_ipc_pipeline_comm_write_buffer_to_fd (GstIpcPipelineComm * comm,
   /* work out meta size */
   gst_buffer_foreach_meta (buffer, build_meta, &repr);
 
-  if (!gst_byte_writer_put_uint8 (&bw, payload_type))
-    goto write_failed;
-  if (!gst_byte_writer_put_uint32_le (&bw, comm->send_id))
-    goto write_failed;
-  size =
-      gst_buffer_get_size (buffer) + sizeof (guint32) +
-      sizeof (CommBufferMetadata) + repr.total_bytes;
-  if (!gst_byte_writer_put_uint32_le (&bw, size))
-    goto write_failed;
-  if (!gst_byte_writer_put_data (&bw, (const guint8 *) &meta, sizeof (meta)))
-    goto write_failed;
-  size = gst_buffer_get_size (buffer);
-  if (!gst_byte_writer_put_uint32_le (&bw, size))
-    goto write_failed;
-  if (!write_byte_writer_to_fd (comm, &bw))
-    goto write_failed;
+#ifdef HAVE_FD_PASSING
+  if (comm->use_memfd) {
+    switch (gst_ipc_pipeline_comm_write_fd_buffer_header (comm, buffer, &meta,
+            repr.total_bytes)) {
+      case FD_BUFFER_WRITTEN:
+        written = TRUE;
+        break;
+      case FD_BUFFER_WRITE_FAILED:
+        goto write_failed;
+      default:
+        break;
+    }
+  }
+#endif
 
-  if (!gst_buffer_map (buffer, &map, GST_MAP_READ))
-    goto map_failed;
-  ret = write_to_fd_raw (comm, map.data, map.size);
-  gst_buffer_unmap (buffer, &map);
-  if (!ret)
-    goto write_failed;
+  if (!written) {
+    if (!gst_byte_writer_put_uint8 (&bw, payload_type))
+      goto write_failed;
+    if (!gst_byte_writer_put_uint32_le (&bw, comm->send_id))
+      goto write_failed;
+    size =
+        gst_buffer_get_size (buffer) + sizeof (guint32) +
+        sizeof (CommBufferMetadata) + repr.total_bytes;
+    if (!gst_byte_writer_put_uint32_le (&bw, size))
+      goto write_failed;
+    if (!gst_byte_writer_put_data (&bw, (const guint8 *) &meta,
+            sizeof (meta)))
+      goto write_failed;
+    size = gst_buffer_get_size (buffer);
+    if (!gst_byte_writer_put_uint32_le (&bw, size))
+      goto write_failed;
+    if (!write_byte_writer_to_fd (comm, &bw))
+      goto write_failed;
+
+    if (!gst_buffer_map (buffer, &map, GST_MAP_READ))
+      goto map_failed;
+    ret = write_to_fd_raw (comm, map.data, map.size);
+    gst_buffer_unmap (buffer, &map);
+    if (!ret)
+      goto write_failed;
+  }
 
   /* meta */
   gst_byte_writer_init (&bw);
@@ -611,10 +1113,18 @@ gst_ipc_pipeline_comm_write_buffer_to_fd (GstIpcPipelineComm * comm,
   if (!write_byte_writer_to_fd (comm, &bw))
     goto write_failed;
 
-  if (!gst_ipc_pipeline_comm_sync_fd (comm, comm->send_id, NULL, &ret32,
-          ACK_TYPE_BLOCKING, COMM_REQUEST_TYPE_BUFFER))
-    goto wait_failed;
-  ret = ret32;
+  if (comm->max_in_flight > 1) {
+    /* only wait for the ACK of the oldest buffer once the window is full */
+    gst_ipc_pipeline_comm_add_in_flight (comm, comm->send_id);
+    gst_ipc_pipeline_comm_wait_in_flight (comm, comm->max_in_flight);
+    ret = comm->in_flight_ret;
+    comm->in_flight_ret = GST_FLOW_OK;
+  } else {
+    if (!gst_ipc_pipeline_comm_sync_fd (comm, comm->send_id, NULL, &ret32,
+            ACK_TYPE_BLOCKING, COMM_REQUEST_TYPE_BUFFER))
+      goto wait_failed;
+    ret = ret32;
+  }
 
 done:
   g_mutex_unlock (&comm->mutex);
@@ -643,44 +1153,24 @@ map_failed:
   goto done;
 }
 
-static GstBuffer *
-gst_ipc_pipeline_comm_read_buffer (GstIpcPipelineComm * comm, guint32 size)
+static void
+set_buffer_metadata (GstBuffer * buffer, const CommBufferMetadata * meta)
+{
+  GST_BUFFER_PTS (buffer) = meta->pts;
+  GST_BUFFER_DTS (buffer) = meta->dts;
+  GST_BUFFER_DURATION (buffer) = meta->duration;
+  GST_BUFFER_OFFSET (buffer) = meta->offset;
+  GST_BUFFER_OFFSET_END (buffer) = meta->offset_end;
+  GST_BUFFER_FLAGS (buffer) = meta->flags;
+}
+
+static gboolean
+gst_ipc_pipeline_comm_read_buffer_meta (GstIpcPipelineComm * comm,
+    GstBuffer * buffer, guint32 size)
 {
-  GstBuffer *buffer;
-  CommBufferMetadata meta;
   guint32 n_meta, n;
   const guint8 *payload = NULL;
-  guint32 mapped_size, buffer_data_size;
-
-  /* this should not be called if we don't have enough yet */
-  g_return_val_if_fail (gst_adapter_available (comm->adapter) >= size, NULL);
-  g_return_val_if_fail (size >= sizeof (CommBufferMetadata), NULL);
-
-  mapped_size = sizeof (CommBufferMetadata) + sizeof (buffer_data_size);
-  payload = gst_adapter_map (comm->adapter, mapped_size);
-  if (!payload)
-    return NULL;
-  memcpy (&meta, payload, sizeof (CommBufferMetadata));
-  payload += sizeof (CommBufferMetadata);
-  memcpy (&buffer_data_size, payload, sizeof (buffer_data_size));
-  size -= mapped_size;
-  gst_adapter_unmap (comm->adapter);
-  gst_adapter_flush (comm->adapter, mapped_size);
-
-  if (buffer_data_size == 0) {
-    buffer = gst_buffer_new ();
-  } else {
-    buffer = gst_adapter_get_buffer (comm->adapter, buffer_data_size);
-    gst_adapter_flush (comm->adapter, buffer_data_size);
-  }
-  size -= buffer_data_size;
-
-  GST_BUFFER_PTS (buffer) = meta.pts;
-  GST_BUFFER_DTS (buffer) = meta.dts;
-  GST_BUFFER_DURATION (buffer) = meta.duration;
-  GST_BUFFER_OFFSET (buffer) = meta.offset;
-  GST_BUFFER_OFFSET_END (buffer) = meta.offset_end;
-  GST_BUFFER_FLAGS (buffer) = meta.flags;
+  guint32 mapped_size;
 
   /* If you don't call that, the GType isn't yet known at the
      g_type_from_name below */
@@ -688,10 +1178,8 @@ gst_ipc_pipeline_comm_read_buffer (GstIpcPipelineComm * comm, guint32 size)
 
   mapped_size = size;
   payload = gst_adapter_map (comm->adapter, mapped_size);
-  if (!payload) {
-    gst_buffer_unref (buffer);
-    return NULL;
-  }
+  if (!payload)
+    return FALSE;
   memcpy (&n_meta, payload, sizeof (n_meta));
   payload += sizeof (n_meta);
 
@@ -740,9 +1228,255 @@ gst_ipc_pipeline_comm_read_buffer (GstIpcPipelineComm * comm, guint32 size)
   gst_adapter_unmap (comm->adapter);
   gst_adapter_flush (comm->adapter, mapped_size);
 
+  return TRUE;
+}
+
+static GstBuffer *
+gst_ipc_pipeline_comm_read_buffer (GstIpcPipelineComm * comm, guint32 size)
+{
+  GstBuffer *buffer;
+  CommBufferMetadata meta;
+  const guint8 *payload = NULL;
+  guint32 mapped_size, buffer_data_size;
+
+  /* this should not be called if we don't have enough yet */
+  g_return_val_if_fail (gst_adapter_available (comm->adapter) >= size, NULL);
+  g_return_val_if_fail (size >= sizeof (CommBufferMetadata), NULL);
+
+  mapped_size = sizeof (CommBufferMetadata) + sizeof (buffer_data_size);
+  payload = gst_adapter_map (comm->adapter, mapped_size);
+  if (!payload)
+    return NULL;
+  memcpy (&meta, payload, sizeof (CommBufferMetadata));
+  payload += sizeof (CommBufferMetadata);
+  memcpy (&buffer_data_size, payload, sizeof (buffer_data_size));
+  size -= mapped_size;
+  gst_adapter_unmap (comm->adapter);
+  gst_adapter_flush (comm->adapter, mapped_size);
+
+  if (buffer_data_size == 0) {
+    buffer = gst_buffer_new ();
+  } else {
+    buffer = gst_adapter_get_buffer (comm->adapter, buffer_data_size);
+    gst_adapter_flush (comm->adapter, buffer_data_size);
+  }
+  size -= buffer_data_size;
+
+  set_buffer_metadata (buffer, &meta);
+
+  if (!gst_ipc_pipeline_comm_read_buffer_meta (comm, buffer, size)) {
+    gst_buffer_unref (buffer);
+    return NULL;
+  }
+
   return buffer;
 }
 
+#ifdef HAVE_FD_PASSING
+static void
+gst_ipc_pipeline_comm_write_release_to_fd (GstIpcPipelineComm * comm,
+    guint32 id, guint generation)
+{
+  const unsigned char payload_type = GST_IPC_PIPELINE_COMM_DATA_TYPE_RELEASE;
+  GstByteWriter bw;
+
+  gst_byte_writer_init (&bw);
+  g_mutex_lock (&comm->mutex);
+
+  /* the peer forgot about its buffers if the connection changed */
+  if (generation != comm->slots_generation || comm->fdout < 0)
+    goto done;
+
+  GST_TRACE_OBJECT (comm->element, "Writing release for buffer %u", id);
+  if (!gst_byte_writer_put_uint8 (&bw, payload_type))
+    goto write_failed;
+  if (!gst_byte_writer_put_uint32_le (&bw, id))
+    goto write_failed;
+  if (!gst_byte_writer_put_uint32_le (&bw, 0))
+    goto write_failed;
+
+  if (!write_byte_writer_to_fd (comm, &bw))
+    goto write_failed;
+
+done:
+  g_mutex_unlock (&comm->mutex);
+  gst_byte_writer_reset (&bw);
+  return;
+
+  /* buffers can outlive the peer, this is not worth an error */
+write_failed:
+  GST_WARNING_OBJECT (comm->element, "Failed to write release for buffer %u",
+      id);
+  goto done;
+}
+
+static void
+comm_release_free (CommRelease * release)
+{
+  gst_ipc_pipeline_comm_write_release_to_fd (release->comm, release->id,
+      release->generation);
+  comm_mapped_slot_unref (release->slot);
+  gst_object_unref (release->element);
+  g_free (release);
+}
+
+static CommMappedSlot *
+comm_mapped_slot_new (GstIpcPipelineComm * comm, int fd, guint64 size)
+{
+  CommMappedSlot *slot;
+  struct stat st;
+
+  /* If the peer could shrink the memfd, reading our mapping past its new
+   * end would raise SIGBUS */
+  if (!gst_ipc_pipeline_memfd_is_sealed (fd)) {
+    GST_ERROR_OBJECT (comm->element, "fd %d is not a sealed memfd", fd);
+    close (fd);
+    return NULL;
+  }
+  if (fstat (fd, &st) < 0 || st.st_size < 0 || (guint64) st.st_size < size) {
+    GST_ERROR_OBJECT (comm->element, "fd %d is smaller than its slot of %"
+        G_GUINT64_FORMAT " bytes", fd, size);
+    close (fd);
+    return NULL;
+  }
+
+  if (!comm->fd_allocator)
+    comm->fd_allocator = gst_fd_allocator_new ();
+
+  slot = g_new0 (CommMappedSlot, 1);
+  slot->refcount = 1;
+  slot->mem = gst_fd_allocator_alloc (comm->fd_allocator, fd, size,
+      GST_FD_MEMORY_FLAG_NONE);
+  if (!slot->mem) {
+    close (fd);
+    goto map_failed;
+  }
+  if (!gst_memory_map (slot->mem, &slot->map, GST_MAP_READ)) {
+    gst_memory_unref (slot->mem);
+    goto map_failed;
+  }
+
+  return slot;
+
+map_failed:
+  GST_ERROR_OBJECT (comm->element, "Failed to map fd %d of %" G_GUINT64_FORMAT
+      " bytes", fd, size);
+  g_free (slot);
+  return NULL;
+}
+
+static GstBuffer *
+gst_ipc_pipeline_comm_read_fd_buffer (GstIpcPipelineComm * comm, guint32 size)
+{
+  GstBuffer *buffer;
+  CommBufferMetadata meta;
+  CommMappedSlot *slot = NULL;
+  CommRelease *release;
+  GstMemory *mem;
+  const guint8 *payload = NULL;
+  guint32 mapped_size, slot_id, flags, buffer_data_size, n_dropped, n;
+  guint64 slot_size, offset;
+
+  /* this should not be called if we don't have enough yet */
+  g_return_val_if_fail (gst_adapter_available (comm->adapter) >= size, NULL);
+
+  mapped_size = sizeof (CommBufferMetadata) + 4 + 4 + 8 + 8 + 4 + 4;
+  if (size < mapped_size)
+    return NULL;
+  payload = gst_adapter_map (comm->adapter, mapped_size);
+  if (!payload)
+    return NULL;
+  memcpy (&meta, payload, sizeof (CommBufferMetadata));
+  payload += sizeof (CommBufferMetadata);
+  memcpy (&slot_id, payload, sizeof (slot_id));
+  memcpy (&flags, payload + 4, sizeof (flags));
+  memcpy (&slot_size, payload + 8, sizeof (slot_size));
+  memcpy (&offset, payload + 16, sizeof (offset));
+  memcpy (&buffer_data_size, payload + 24, sizeof (buffer_data_size));
+  memcpy (&n_dropped, payload + 28, sizeof (n_dropped));
+  size -= mapped_size;
+  gst_adapter_unmap (comm->adapter);
+  gst_adapter_flush (comm->adapter, mapped_size);
+
+  if (n_dropped > size / sizeof (guint32))
+    return NULL;
+  mapped_size = n_dropped * sizeof (guint32);
+
+  g_mutex_lock (&comm->mutex);
+
+  if (mapped_size) {
+    payload = gst_adapter_map (comm->adapter, mapped_size);
+    for (n = 0; n < n_dropped; n++) {
+      guint32 dropped_id;
+
+      memcpy (&dropped_id, payload + n * sizeof (guint32), sizeof (guint32));
+      GST_TRACE_OBJECT (comm->element, "Dropping slot %u", dropped_id);
+      g_hash_table_remove (comm->mapped_slots, GUINT_TO_POINTER (dropped_id));
+    }
+    gst_adapter_unmap (comm->adapter);
+    gst_adapter_flush (comm->adapter, mapped_size);
+    size -= mapped_size;
+  }
+
+  if (flags & SLOT_FLAG_NEW_FD) {
+    if (g_queue_is_empty (&comm->received_fds)) {
+      g_mutex_unlock (&comm->mutex);
+      GST_ERROR_OBJECT (comm->element, "No fd was received for slot %u",
+          slot_id);
+      return NULL;
+    }
+    slot = comm_mapped_slot_new (comm,
+        GPOINTER_TO_INT (g_queue_pop_head (&comm->received_fds)), slot_size);
+    if (slot) {
+      GST_DEBUG_OBJECT (comm->element, "Mapped slot %u of %" G_GUINT64_FORMAT
+          " bytes", slot_id, slot_size);
+      g_hash_table_insert (comm->mapped_slots, GUINT_TO_POINTER (slot_id),
+          slot);
+    }
+  } else {
+    slot = g_hash_table_lookup (comm->mapped_slots,
+        GUINT_TO_POINTER (slot_id));
+  }
+  if (slot)
+    comm_mapped_slot_ref (slot);
+
+  g_mutex_unlock (&comm->mutex);
+
+  if (!slot) {
+    GST_ERROR_OBJECT (comm->element, "Unknown slot %u", slot_id);
+    return NULL;
+  }
+  if (offset > slot->map.size || buffer_data_size > slot->map.size - offset) {
+    GST_ERROR_OBJECT (comm->element, "Buffer of %u bytes at %" G_GUINT64_FORMAT
+        " exceeds slot %u", buffer_data_size, offset, slot_id);
+    comm_mapped_slot_unref (slot);
+    return NULL;
+  }
+
+  /* the peer holds the buffer until our memory wrapping its memfd is freed */
+  release = g_new (CommRelease, 1);
+  release->comm = comm;
+  release->element = gst_object_ref (comm->element);
+  release->slot = slot;
+  release->id = comm->id;
+  release->generation = comm->slots_generation;
+  mem = gst_memory_new_wrapped (GST_MEMORY_FLAG_READONLY, slot->map.data,
+      slot->map.size, offset, buffer_data_size, release,
+      (GDestroyNotify) comm_release_free);
+
+  buffer = gst_buffer_new ();
+  gst_buffer_append_memory (buffer, mem);
+  set_buffer_metadata (buffer, &meta);
+
+  if (!gst_ipc_pipeline_comm_read_buffer_meta (comm, buffer, size)) {
+    gst_buffer_unref (buffer);
+    return NULL;
+  }
+
+  return buffer;
+}
+#endif
+
 static gboolean
 gst_ipc_pipeline_comm_write_sink_message_event_to_fd (GstIpcPipelineComm * comm,
     GstEvent * event)
@@ -931,6 +1665,17 @@ gst_ipc_pipeline_comm_write_event_to_fd (GstIpcPipelineComm * comm,
     return gst_ipc_pipeline_comm_write_sink_message_event_to_fd (comm, event);
 
   g_mutex_lock (&comm->mutex);
+
+  /* Buffers in flight are acknowledged before serialized events, so that
+   * their errors are not reported for the buffers of a new flush or
+   * stream */
+  if (!upstream && GST_EVENT_IS_SERIALIZED (event)) {
+    gst_ipc_pipeline_comm_wait_in_flight (comm, 0);
+    if (GST_EVENT_TYPE (event) == GST_EVENT_FLUSH_STOP
+        || GST_EVENT_TYPE (event) == GST_EVENT_STREAM_START)
+      comm->in_flight_ret = GST_FLOW_OK;
+  }
+
   ++comm->send_id;
 
   GST_TRACE_OBJECT (comm->element, "Writing event %u: %" GST_PTR_FORMAT,
@@ -1630,17 +2375,81 @@ gst_ipc_pipeline_comm_init (GstIpcPipelineComm * comm, GstElement * element)
   comm->adapter = gst_adapter_new ();
   comm->poll = gst_poll_new (TRUE);
   gst_poll_fd_init (&comm->pollFDin);
+  comm->max_in_flight = 1;
+  g_queue_init (&comm->in_flight);
+  comm->in_flight_ret = GST_FLOW_OK;
+  comm->slots = comm_slots_new ();
+  comm->held_buffers =
+      g_hash_table_new_full (g_direct_hash, g_direct_equal, NULL,
+      (GDestroyNotify) gst_buffer_unref);
+  g_queue_init (&comm->received_fds);
+  comm->mapped_slots =
+      g_hash_table_new_full (g_direct_hash, g_direct_equal, NULL,
+      (GDestroyNotify) comm_mapped_slot_unref);
 }
 
 void
 gst_ipc_pipeline_comm_clear (GstIpcPipelineComm * comm)
 {
+  g_queue_clear_full (&comm->in_flight, (GDestroyNotify) comm_in_flight_free);
   g_hash_table_destroy (comm->waiting_ids);
+  g_hash_table_destroy (comm->held_buffers);
+  g_hash_table_destroy (comm->mapped_slots);
+  close_received_fds (comm);
+  comm_slots_unref (comm->slots);
+  if (comm->memfd_pool) {
+    gst_buffer_pool_set_active (comm->memfd_pool, FALSE);
+    gst_object_unref (comm->memfd_pool);
+  }
+  gst_clear_object (&comm->memfd_allocator);
+  gst_clear_object (&comm->fd_allocator);
   gst_object_unref (comm->adapter);
   gst_poll_free (comm->poll);
   g_mutex_clear (&comm->mutex);
 }
 
+/* Forgets about the memfds passed to and received from the peer. To be
+ * called when the fds used to talk to it change, a new peer knows none. */
+void
+gst_ipc_pipeline_comm_reset_slots (GstIpcPipelineComm * comm)
+{
+  GHashTable *held_buffers;
+
+  g_mutex_lock (&comm->mutex);
+  comm_slots_unref (comm->slots);
+  comm->slots = comm_slots_new ();
+  comm->fd_passing_failed = FALSE;
+  comm->slots_generation++;
+  held_buffers = comm->held_buffers;
+  comm->held_buffers =
+      g_hash_table_new_full (g_direct_hash, g_direct_equal, NULL,
+      (GDestroyNotify) gst_buffer_unref);
+  g_hash_table_remove_all (comm->mapped_slots);
+  close_received_fds (comm);
+  g_mutex_unlock (&comm->mutex);
+
+  /* outside of the lock, this may return the buffers to their pool */
+  g_hash_table_destroy (held_buffers);
+}
+
+/* Returns an allocator of memfd backed memory that can be passed to the peer
+ * without copying, or NULL if this is not supported */
+GstAllocator *
+gst_ipc_pipeline_comm_get_memfd_allocator (GstIpcPipelineComm * comm)
+{
+#ifdef HAVE_FD_PASSING
+  GstAllocator *allocator;
+
+  g_mutex_lock (&comm->mutex);
+  allocator = gst_object_ref (ensure_memfd_allocator (comm));
+  g_mutex_unlock (&comm->mutex);
+
+  return allocator;
+#else
+  return NULL;
+#endif
+}
+
 static void
 cancel_request (gpointer key, gpointer value, gpointer user_data,
     GstFlowReturn fret)
@@ -1722,6 +2531,64 @@ gst_ipc_pipeline_comm_reply_request (GstIpcPipelineComm * comm, guint32 id,
   return TRUE;
 }
 
+#ifdef HAVE_FD_PASSING
+/* Like read(), queueing the fds passed along with the data */
+static ssize_t
+read_with_fds (GstIpcPipelineComm * comm, int fd, void *data, size_t size)
+{
+  union
+  {
+    struct cmsghdr hdr;
+    char buf[CMSG_SPACE (sizeof (int) * MAX_RECEIVED_FDS)];
+  } control;
+  struct msghdr msg = { 0 };
+  struct cmsghdr *cmsg;
+  struct iovec iov;
+  int flags = 0;
+  ssize_t sz;
+
+  iov.iov_base = data;
+  iov.iov_len = size;
+  msg.msg_iov = &iov;
+  msg.msg_iovlen = 1;
+  msg.msg_control = control.buf;
+  msg.msg_controllen = sizeof (control.buf);
+#ifdef MSG_CMSG_CLOEXEC
+  flags |= MSG_CMSG_CLOEXEC;
+#endif
+
+  sz = recvmsg (fd, &msg, flags);
+  /* pipes can't pass fds */
+  if (sz < 0 && errno == ENOTSOCK)
+    return read (fd, data, size);
+  if (sz <= 0)
+    return sz;
+
+  if (msg.msg_flags & MSG_CTRUNC)
+    GST_ERROR_OBJECT (comm->element, "Received too many fds, some were lost");
+
+  for (cmsg = CMSG_FIRSTHDR (&msg); cmsg; cmsg = CMSG_NXTHDR (&msg, cmsg)) {
+    guint n, n_fds;
+
+    if (cmsg->cmsg_level != SOL_SOCKET || cmsg->cmsg_type != SCM_RIGHTS)
+      continue;
+
+    n_fds = (cmsg->cmsg_len - CMSG_LEN (0)) / sizeof (int);
+    g_mutex_lock (&comm->mutex);
+    for (n = 0; n < n_fds; n++) {
+      int received;
+
+      memcpy (&received, CMSG_DATA (cmsg) + n * sizeof (int), sizeof (int));
+      GST_TRACE_OBJECT (comm->element, "Received fd %d", received);
+      g_queue_push_tail (&comm->received_fds, GINT_TO_POINTER (received));
+    }
+    g_mutex_unlock (&comm->mutex);
+  }
+
+  return sz;
+}
+#endif
+
 static gint
 update_adapter (GstIpcPipelineComm * comm)
 {
@@ -1778,6 +2645,8 @@ again:
         errno = last_error;
       }
     }
+#elif defined (HAVE_FD_PASSING)
+    sz = read_with_fds (comm, comm->pollFDin.fd, map.data, map.size);
 #else
     sz = read (comm->pollFDin.fd, map.data, map.size);
 #endif
@@ -1845,6 +2714,10 @@ read_many (GstIpcPipelineComm * comm)
           case GST_IPC_PIPELINE_COMM_DATA_TYPE_STATE_LOST:
           case GST_IPC_PIPELINE_COMM_DATA_TYPE_MESSAGE:
           case GST_IPC_PIPELINE_COMM_DATA_TYPE_GERROR_MESSAGE:
+#ifdef HAVE_FD_PASSING
+          case GST_IPC_PIPELINE_COMM_DATA_TYPE_FD_BUFFER:
+#endif
+          case GST_IPC_PIPELINE_COMM_DATA_TYPE_RELEASE:
             GST_TRACE_OBJECT (comm->element, "switching to state %s",
                 gst_ipc_pipeline_comm_data_type_get_name (type));
             comm->state = type;
@@ -1909,6 +2782,7 @@ read_many (GstIpcPipelineComm * comm)
         break;
       }
       case GST_IPC_PIPELINE_COMM_DATA_TYPE_BUFFER:
+      case GST_IPC_PIPELINE_COMM_DATA_TYPE_FD_BUFFER:
       {
         GstBuffer *buf;
 
@@ -1916,7 +2790,13 @@ read_many (GstIpcPipelineComm * comm)
         if (available < comm->payload_length)
           goto done;
 
-        buf = gst_ipc_pipeline_comm_read_buffer (comm, comm->payload_length);
+#ifdef HAVE_FD_PASSING
+        if (comm->state == GST_IPC_PIPELINE_COMM_DATA_TYPE_FD_BUFFER)
+          buf = gst_ipc_pipeline_comm_read_fd_buffer (comm,
+              comm->payload_length);
+        else
+#endif
+          buf = gst_ipc_pipeline_comm_read_buffer (comm, comm->payload_length);
         if (!buf)
           goto buffer_failed;
 
@@ -1940,6 +2820,33 @@ read_many (GstIpcPipelineComm * comm)
         comm->state = GST_IPC_PIPELINE_COMM_STATE_TYPE;
         break;
       }
+      case GST_IPC_PIPELINE_COMM_DATA_TYPE_RELEASE:
+      {
+        GstBuffer *buf = NULL;
+
+        available = gst_adapter_available (comm->adapter);
+        if (available < comm->payload_length)
+          goto done;
+
+        gst_adapter_flush (comm->adapter, comm->payload_length);
+
+        g_mutex_lock (&comm->mutex);
+        if (!g_hash_table_steal_extended (comm->held_buffers,
+                GINT_TO_POINTER (comm->id), NULL, (gpointer *) & buf))
+          GST_WARNING_OBJECT (comm->element,
+              "Got release for unknown buffer %u", comm->id);
+        g_mutex_unlock (&comm->mutex);
+
+        GST_TRACE_OBJECT (comm->element, "Peer released buffer %u", comm->id);
+
+        /* outside of the lock, this may return the buffer to its pool */
+        if (buf)
+          gst_buffer_unref (buf);
+
+        GST_TRACE_OBJECT (comm->element, "switching to state TYPE");
+        comm->state = GST_IPC_PIPELINE_COMM_STATE_TYPE;
+        break;
+      }
       case GST_IPC_PIPELINE_COMM_DATA_TYPE_EVENT:
       {
         GstEvent *event;
@@ -2352,6 +3259,7 @@ gst_ipc_pipeline_comm_plugin_init (void)
     GST_DEBUG_CATEGORY_INIT (gst_ipc_pipeline_comm_debug, "ipcpipelinecomm", 0,
         "ipc pipeline comm");
     QUARK_ID = g_quark_from_static_string ("ipcpipeline-id");
+    QUARK_SLOT = g_quark_from_static_string ("ipcpipeline-slot");
     REGISTER_SERIALIZATION_NO_COMPARE (gst_event_get_type (), event);
     g_once_init_leave (&once, (gsize) 1);
   }
@@ -51,8 +51,12 @@ typedef enum {
   GST_IPC_PIPELINE_COMM_DATA_TYPE_STATE_LOST,
   GST_IPC_PIPELINE_COMM_DATA_TYPE_MESSAGE,
   GST_IPC_PIPELINE_COMM_DATA_TYPE_GERROR_MESSAGE,
+  GST_IPC_PIPELINE_COMM_DATA_TYPE_FD_BUFFER,
+  GST_IPC_PIPELINE_COMM_DATA_TYPE_RELEASE,
 } GstIpcPipelineCommDataType;
 
+typedef struct _GstIpcPipelineCommSlots GstIpcPipelineCommSlots;
+
 typedef struct
 {
   GstElement *element;
@@ -76,6 +80,29 @@ typedef struct
   guint read_chunk_size;
   GstClockTime ack_time;
 
+  /* sender side: buffers whose ACK has not been waited for yet, and the
+   * first error one of them returned, to be reported by the next buffer */
+  guint max_in_flight;
+  GQueue in_flight;
+  GstFlowReturn in_flight_ret;
+
+  /* sender side of the memfd transport: the memfd slots known to the peer,
+   * and the buffers it still maps, by buffer id */
+  gboolean use_memfd;
+  gboolean fd_passing_failed;
+  GstIpcPipelineCommSlots *slots;
+  GHashTable *held_buffers;
+  GstAllocator *memfd_allocator;
+  GstBufferPool *memfd_pool;
+  gsize memfd_pool_size;
+
+  /* receiver side of the memfd transport: fds received but not used yet,
+   * and the mapped slots by slot id */
+  GQueue received_fds;
+  GHashTable *mapped_slots;
+  GstAllocator *fd_allocator;
+  guint slots_generation;
+
   void (*on_buffer) (guint32, GstBuffer *, gpointer);
   void (*on_event) (guint32, GstEvent *, gboolean, gpointer);
   void (*on_query) (guint32, GstQuery *, gboolean, gpointer);
@@ -92,6 +119,9 @@ void gst_ipc_pipeline_comm_init (GstIpcPipelineComm *comm, GstElement *e);
 void gst_ipc_pipeline_comm_clear (GstIpcPipelineComm *comm);
 void gst_ipc_pipeline_comm_cancel (GstIpcPipelineComm * comm,
     gboolean flushing);
+void gst_ipc_pipeline_comm_reset_slots (GstIpcPipelineComm * comm);
+GstAllocator * gst_ipc_pipeline_comm_get_memfd_allocator (
+    GstIpcPipelineComm * comm);
 
 void gst_ipc_pipeline_comm_write_flow_ack_to_fd (GstIpcPipelineComm * comm,
     guint32 id, GstFlowReturn ret);
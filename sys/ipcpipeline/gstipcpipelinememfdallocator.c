@@ -0,0 +1,120 @@
+/* GStreamer
+ *
+ * gstipcpipelinememfdallocator.c:
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin St, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+/* Allocates GstFdMemory backed by anonymous memfds, which ipcpipelinesink
+ * can pass to ipcpipelinesrc instead of copying their contents through the
+ * socket. The memfds are sealed against resizing, so that the receiver can
+ * map them without the sender being able to truncate them under it. */
+
+#ifdef HAVE_CONFIG_H
+#  include "config.h"
+#endif
+
+#ifdef HAVE_MEMFD_CREATE
+
+#ifndef _GNU_SOURCE
+#  define _GNU_SOURCE           /* for memfd_create() */
+#endif
+#include <errno.h>
+#include <fcntl.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+#include "gstipcpipelinememfdallocator.h"
+
+GST_DEBUG_CATEGORY_STATIC (gst_ipc_pipeline_memfd_allocator_debug);
+#define GST_CAT_DEFAULT gst_ipc_pipeline_memfd_allocator_debug
+
+#define MEMFD_SEALS (F_SEAL_SHRINK | F_SEAL_GROW)
+
+G_DEFINE_TYPE_WITH_CODE (GstIpcPipelineMemfdAllocator,
+    gst_ipc_pipeline_memfd_allocator, GST_TYPE_FD_ALLOCATOR,
+    GST_DEBUG_CATEGORY_INIT (gst_ipc_pipeline_memfd_allocator_debug,
+        "ipcpipelinememfd", 0, "ipcpipeline memfd allocator"));
+
+static GstMemory *
+gst_ipc_pipeline_memfd_allocator_alloc (GstAllocator * allocator, gsize size,
+    GstAllocationParams * params)
+{
+  GstMemory *mem;
+  gsize maxsize;
+  int fd;
+
+  /* the mapping is page aligned, so only the prefix and padding matter */
+  maxsize = params->prefix + size + params->padding;
+
+  fd = memfd_create ("gst-ipcpipeline", MFD_CLOEXEC | MFD_ALLOW_SEALING);
+  if (fd < 0) {
+    GST_ERROR_OBJECT (allocator, "memfd_create failed: %s", strerror (errno));
+    return NULL;
+  }
+
+  if (ftruncate (fd, maxsize) < 0) {
+    GST_ERROR_OBJECT (allocator, "ftruncate failed: %s", strerror (errno));
+    close (fd);
+    return NULL;
+  }
+
+  if (fcntl (fd, F_ADD_SEALS, MEMFD_SEALS) < 0) {
+    GST_ERROR_OBJECT (allocator, "Sealing failed: %s", strerror (errno));
+    close (fd);
+    return NULL;
+  }
+
+  mem = gst_fd_allocator_alloc (allocator, fd, maxsize,
+      GST_FD_MEMORY_FLAG_KEEP_MAPPED);
+  if (G_UNLIKELY (!mem)) {
+    GST_ERROR_OBJECT (allocator, "GstFdMemory allocation failed");
+    close (fd);
+    return NULL;
+  }
+
+  gst_memory_resize (mem, params->prefix, size);
+
+  return mem;
+}
+
+/* Whether @fd is a memfd whose size can no longer change */
+gboolean
+gst_ipc_pipeline_memfd_is_sealed (int fd)
+{
+  int seals = fcntl (fd, F_GET_SEALS);
+
+  return seals >= 0 && (seals & MEMFD_SEALS) == MEMFD_SEALS;
+}
+
+static void
+gst_ipc_pipeline_memfd_allocator_class_init (GstIpcPipelineMemfdAllocatorClass
+    * klass)
+{
+  GstAllocatorClass *alloc_class = (GstAllocatorClass *) klass;
+
+  alloc_class->alloc =
+      GST_DEBUG_FUNCPTR (gst_ipc_pipeline_memfd_allocator_alloc);
+}
+
+static void
+gst_ipc_pipeline_memfd_allocator_init (GstIpcPipelineMemfdAllocator * self)
+{
+  GST_OBJECT_FLAG_UNSET (self, GST_ALLOCATOR_FLAG_CUSTOM_ALLOC);
+}
+
+#endif /* HAVE_MEMFD_CREATE */
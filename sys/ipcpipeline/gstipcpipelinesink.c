@@ -66,7 +66,17 @@
  * GError are serialized differently).
  *
  * Buffers are transported by writing their content directly on the socket.
- * More efficient ways for memory sharing could be implemented in the future.
+ * With #GstIpcPipelineSink:use-memfd, buffers are instead passed in memfd
+ * backed memory, which is proposed to upstream elements in the ALLOCATION
+ * query. The memfd of each memory is passed to ipcpipelinesrc only once over
+ * the UNIX socket, and the buffer is kept until ipcpipelinesrc releases it,
+ * so that upstream buffer pools can recycle it. Buffers in other memory are
+ * copied into memfds of a pool of ipcpipelinesink, unless they are small.
+ *
+ * By default, the sender waits for the flow return of each buffer before
+ * sending the next one. With #GstIpcPipelineSink:max-in-flight, more buffers
+ * are sent before waiting, and a non-OK flow return is returned by the first
+ * buffer sent after it was received instead.
  */
 
 #ifdef HAVE_CONFIG_H
@@ -99,11 +109,15 @@ enum
   PROP_FDOUT,
   PROP_READ_CHUNK_SIZE,
   PROP_ACK_TIME,
+  PROP_MAX_IN_FLIGHT,
+  PROP_USE_MEMFD,
 };
 
 
 #define DEFAULT_READ_CHUNK_SIZE 4096
 #define DEFAULT_ACK_TIME (10 * G_TIME_SPAN_SECOND)
+#define DEFAULT_MAX_IN_FLIGHT 1
+#define DEFAULT_USE_MEMFD FALSE
 
 #define _do_init \
     GST_DEBUG_CATEGORY_INIT (gst_ipc_pipeline_sink_debug, "ipcpipelinesink", 0, "ipcpipelinesink element");
@@ -179,6 +193,38 @@ gst_ipc_pipeline_sink_class_init (GstIpcPipelineSinkClass * klass)
           0, G_MAXUINT64, DEFAULT_ACK_TIME,
           G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
 
+  /**
+   * GstIpcPipelineSink:max-in-flight:
+   *
+   * Maximum number of buffers sent before waiting for the flow return of the
+   * oldest one. With 1, each buffer waits for its own flow return.
+   *
+   * Since: 1.24
+   */
+  g_object_class_install_property (gobject_class, PROP_MAX_IN_FLIGHT,
+      g_param_spec_uint ("max-in-flight", "Max in flight",
+          "Maximum number of buffers sent before waiting for a flow return",
+          1, G_MAXUINT16, DEFAULT_MAX_IN_FLIGHT,
+          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS |
+          GST_PARAM_MUTABLE_READY));
+
+  /**
+   * GstIpcPipelineSink:use-memfd:
+   *
+   * Pass buffers to ipcpipelinesrc in memfd backed memory instead of copying
+   * them through the socket. This needs fdout to be a UNIX socket and an
+   * ipcpipelinesrc that supports it, buffers are copied through the socket
+   * otherwise.
+   *
+   * Since: 1.24
+   */
+  g_object_class_install_property (gobject_class, PROP_USE_MEMFD,
+      g_param_spec_boolean ("use-memfd", "Use memfd",
+          "Pass buffers in memfd backed memory instead of copying them",
+          DEFAULT_USE_MEMFD,
+          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS |
+          GST_PARAM_MUTABLE_READY));
+
   gst_ipc_pipeline_sink_signals[SIGNAL_DISCONNECT] =
       g_signal_new ("disconnect",
       G_TYPE_FROM_CLASS (klass),
@@ -216,6 +262,8 @@ gst_ipc_pipeline_sink_init (GstIpcPipelineSink * sink)
   sink->comm.ack_time = DEFAULT_ACK_TIME;
   sink->comm.fdin = -1;
   sink->comm.fdout = -1;
+  sink->comm.max_in_flight = DEFAULT_MAX_IN_FLIGHT;
+  sink->comm.use_memfd = DEFAULT_USE_MEMFD;
   sink->threads = g_thread_pool_new (pusher, sink, -1, FALSE, NULL);
   gst_ipc_pipeline_sink_start_reader_thread (sink);
 
@@ -265,9 +313,11 @@ gst_ipc_pipeline_sink_set_property (GObject * object, guint prop_id,
   switch (prop_id) {
     case PROP_FDIN:
       sink->comm.fdin = g_value_get_int (value);
+      gst_ipc_pipeline_comm_reset_slots (&sink->comm);
       break;
     case PROP_FDOUT:
       sink->comm.fdout = g_value_get_int (value);
+      gst_ipc_pipeline_comm_reset_slots (&sink->comm);
       break;
     case PROP_READ_CHUNK_SIZE:
       sink->comm.read_chunk_size = g_value_get_uint (value);
@@ -275,6 +325,12 @@ gst_ipc_pipeline_sink_set_property (GObject * object, guint prop_id,
     case PROP_ACK_TIME:
       sink->comm.ack_time = g_value_get_uint64 (value);
       break;
+    case PROP_MAX_IN_FLIGHT:
+      sink->comm.max_in_flight = g_value_get_uint (value);
+      break;
+    case PROP_USE_MEMFD:
+      sink->comm.use_memfd = g_value_get_boolean (value);
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
       break;
@@ -300,6 +356,12 @@ gst_ipc_pipeline_sink_get_property (GObject * object, guint prop_id,
     case PROP_ACK_TIME:
       g_value_set_uint64 (value, sink->comm.ack_time);
       break;
+    case PROP_MAX_IN_FLIGHT:
+      g_value_set_uint (value, sink->comm.max_in_flight);
+      break;
+    case PROP_USE_MEMFD:
+      g_value_set_boolean (value, sink->comm.use_memfd);
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
       break;
@@ -348,8 +410,23 @@ gst_ipc_pipeline_sink_query (GstPad * pad, GstObject * parent, GstQuery * query)
 
   switch (GST_QUERY_TYPE (query)) {
     case GST_QUERY_ALLOCATION:
-      GST_DEBUG_OBJECT (sink, "Rejecting ALLOCATION query");
-      return FALSE;
+    {
+      GstAllocator *allocator = NULL;
+
+      /* the query can't be answered by the peer, but memfds can be passed
+       * to it */
+      if (sink->comm.use_memfd)
+        allocator = gst_ipc_pipeline_comm_get_memfd_allocator (&sink->comm);
+      if (!allocator) {
+        GST_DEBUG_OBJECT (sink, "Rejecting ALLOCATION query");
+        return FALSE;
+      }
+
+      GST_DEBUG_OBJECT (sink, "Proposing memfd allocator");
+      gst_query_add_allocation_param (query, allocator, NULL);
+      gst_object_unref (allocator);
+      return TRUE;
+    }
     case GST_QUERY_CAPS:
     {
       /* caps queries occur even while linking the pipeline.
@@ -581,6 +658,7 @@ gst_ipc_pipeline_sink_disconnect (GstIpcPipelineSink * sink)
   sink->comm.fdin = -1;
   sink->comm.fdout = -1;
   gst_ipc_pipeline_comm_cancel (&sink->comm, FALSE);
+  gst_ipc_pipeline_comm_reset_slots (&sink->comm);
   gst_ipc_pipeline_sink_start_reader_thread (sink);
 }
 
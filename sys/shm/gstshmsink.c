@@ -58,17 +58,21 @@ enum
   PROP_PERMS,
   PROP_SHM_SIZE,
   PROP_WAIT_FOR_CONNECTION,
-  PROP_BUFFER_TIME
+  PROP_BUFFER_TIME,
+  PROP_RING_SIZE
 };
 
 struct GstShmClient
 {
   ShmClient *client;
   GstPollFD pollfd;
+  /* only used if the client has a ring */
+  GstPollFD eventpollfd;
 };
 
 #define DEFAULT_SIZE ( 64 * 1024 * 1024 )
 #define DEFAULT_WAIT_FOR_CONNECTION (TRUE)
+#define DEFAULT_RING_SIZE 0
 /* Default is user read/write, group read */
 #define DEFAULT_PERMS ( S_IRUSR | S_IWUSR | S_IRGRP )
 
@@ -357,6 +361,7 @@ gst_shm_sink_init (GstShmSink * self)
   self->unlock = FALSE;
   self->wait_for_connection = DEFAULT_WAIT_FOR_CONNECTION;
   self->perms = DEFAULT_PERMS;
+  self->ring_size = DEFAULT_RING_SIZE;
 
   gst_allocation_params_init (&self->params);
 }
@@ -419,6 +424,28 @@ gst_shm_sink_class_init (GstShmSinkClass * klass)
           -1, G_MAXINT64, -1,
           G_PARAM_CONSTRUCT | G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
 
+  /**
+   * GstShmSink:ring-size:
+   *
+   * Number of buffer descriptors in the ring shared with each client. With
+   * a non-zero value, buffers and their release notifications are passed
+   * through shared memory and the control socket is only used to set up
+   * the connection, which avoids a few syscalls per buffer and client. The
+   * clients must support this, which is the case for shmsrc since 1.24.
+   *
+   * The value is rounded up to a power of two and applies to clients that
+   * connect after it is set. Only supported on platforms with eventfd.
+   *
+   * Since: 1.24
+   */
+  g_object_class_install_property (gobject_class, PROP_RING_SIZE,
+      g_param_spec_uint ("ring-size",
+          "Ring size",
+          "Number of buffers in the ring shared with each client "
+          "(0 = use the control socket)",
+          0, 65536, DEFAULT_RING_SIZE,
+          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
   signals[SIGNAL_CLIENT_CONNECTED] = g_signal_new ("client-connected",
       GST_TYPE_SHM_SINK, G_SIGNAL_RUN_LAST, 0, NULL, NULL, NULL,
       G_TYPE_NONE, 1, G_TYPE_INT);
@@ -507,6 +534,16 @@ gst_shm_sink_set_property (GObject * object, guint prop_id,
       GST_OBJECT_UNLOCK (object);
       g_cond_broadcast (&self->cond);
       break;
+    case PROP_RING_SIZE:
+      GST_OBJECT_LOCK (object);
+      self->ring_size = g_value_get_uint (value);
+      if (self->pipe)
+        ret = sp_writer_set_ring_size (self->pipe, self->ring_size);
+      GST_OBJECT_UNLOCK (object);
+      if (ret < 0)
+        GST_WARNING_OBJECT (object, "Rings are not supported on this "
+            "platform, using the control socket");
+      break;
     default:
       break;
   }
@@ -536,6 +573,9 @@ gst_shm_sink_get_property (GObject * object, guint prop_id,
     case PROP_BUFFER_TIME:
       g_value_set_int64 (value, self->buffer_time);
       break;
+    case PROP_RING_SIZE:
+      g_value_set_uint (value, self->ring_size);
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
       break;
@@ -572,6 +612,9 @@ gst_shm_sink_start (GstBaseSink * bsink)
   }
 
   sp_set_data (self->pipe, self);
+  if (sp_writer_set_ring_size (self->pipe, self->ring_size) < 0)
+    GST_WARNING_OBJECT (self, "Rings are not supported on this platform, "
+        "using the control socket");
   g_free (self->socket_path);
   self->socket_path = g_strdup (sp_writer_get_path (self->pipe));
 
@@ -780,6 +823,21 @@ gst_shm_sink_render (GstBaseSink * bsink, GstBuffer * buf)
     sendbuf = gst_buffer_ref (buf);
   }
 
+  /* Wait until the ring of every client has space for the descriptor */
+  while (!sp_writer_can_send (self->pipe)) {
+    g_cond_wait (&self->cond, GST_OBJECT_GET_LOCK (self));
+    if (self->unlock) {
+      GST_OBJECT_UNLOCK (self);
+      ret = gst_base_sink_wait_preroll (bsink);
+      if (ret == GST_FLOW_OK) {
+        GST_OBJECT_LOCK (self);
+      } else {
+        gst_buffer_unref (sendbuf);
+        return ret;
+      }
+    }
+  }
+
   if (!gst_buffer_map (sendbuf, &map, GST_MAP_READ)) {
     GST_ELEMENT_ERROR (self, STREAM, FAILED,
         (NULL), ("Failed to map data into send buffer"));
@@ -883,6 +941,13 @@ pollthread_func (gpointer data)
       gclient->pollfd.fd = sp_writer_get_client_fd (client);
       gst_poll_add_fd (self->poll, &gclient->pollfd);
       gst_poll_fd_ctl_read (self->poll, &gclient->pollfd, TRUE);
+      gst_poll_fd_init (&gclient->eventpollfd);
+      gclient->eventpollfd.fd = sp_writer_get_client_event_fd (client);
+      if (gclient->eventpollfd.fd >= 0) {
+        GST_DEBUG_OBJECT (self, "Client %d uses a ring", gclient->pollfd.fd);
+        gst_poll_add_fd (self->poll, &gclient->eventpollfd);
+        gst_poll_fd_ctl_read (self->poll, &gclient->eventpollfd, TRUE);
+      }
       self->clients = g_list_prepend (self->clients, gclient);
       g_signal_emit (self, signals[SIGNAL_CLIENT_CONNECTED], 0,
           gclient->pollfd.fd);
@@ -927,6 +992,33 @@ pollthread_func (gpointer data)
         if (rv == 0)
           gst_buffer_unref (tag);
       }
+
+      if (gclient->eventpollfd.fd >= 0) {
+        GSList *list = NULL;
+        int rv;
+
+        if (gst_poll_fd_can_read (self->poll, &gclient->eventpollfd))
+          sp_writer_clear_client_event (gclient->client);
+
+        /* Always check the ring, the client only signals us when we said
+         * we were going to sleep */
+        GST_OBJECT_LOCK (self);
+        do {
+          gpointer tag = NULL;
+
+          rv = sp_writer_recv_ring (self->pipe, gclient->client, &tag);
+          if (rv == 0)
+            list = g_slist_prepend (list, tag);
+        } while (rv == 0 || rv == 1);
+        GST_OBJECT_UNLOCK (self);
+        g_slist_free_full (list, (GDestroyNotify) gst_buffer_unref);
+
+        if (rv < 0) {
+          GST_WARNING_OBJECT (self, "One client has ring error,"
+              " closing (retval: %d)", rv);
+          goto close_client;
+        }
+      }
       continue;
     close_client:
       {
@@ -939,6 +1031,8 @@ pollthread_func (gpointer data)
       }
 
       gst_poll_remove_fd (self->poll, &gclient->pollfd);
+      if (gclient->eventpollfd.fd >= 0)
+        gst_poll_remove_fd (self->poll, &gclient->eventpollfd);
       self->clients = g_list_remove (self->clients, gclient);
 
       g_signal_emit (self, signals[SIGNAL_CLIENT_DISCONNECTED], 0,
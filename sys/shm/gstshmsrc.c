@@ -153,6 +153,7 @@ gst_shm_src_init (GstShmSrc * self)
 {
   self->poll = gst_poll_new (TRUE);
   gst_poll_fd_init (&self->pollfd);
+  gst_poll_fd_init (&self->eventpollfd);
 }
 
 static void
@@ -260,6 +261,7 @@ gst_shm_src_start_reading (GstShmSrc * self)
   self->pollfd.fd = sp_get_fd (self->pipe->pipe);
   gst_poll_add_fd (self->poll, &self->pollfd);
   gst_poll_fd_ctl_read (self->poll, &self->pollfd, TRUE);
+  gst_poll_fd_init (&self->eventpollfd);
 
   return TRUE;
 }
@@ -341,6 +343,20 @@ gst_shm_src_create (GstPushSrc * psrc, GstBuffer ** outbuf)
   GST_OBJECT_UNLOCK (self);
 
   do {
+    /* With a ring, only wait once it is empty */
+    if (self->eventpollfd.fd >= 0) {
+      GST_OBJECT_LOCK (self);
+      rv = sp_client_recv_ring (pipe->pipe, &buf);
+      GST_OBJECT_UNLOCK (self);
+      if (rv < 0) {
+        GST_ELEMENT_ERROR (self, RESOURCE, READ, ("Failed to read from shmsrc"),
+            ("Error reading from ring: %d", rv));
+        goto error;
+      }
+      if (buf != NULL)
+        break;
+    }
+
     if (gst_poll_wait (self->poll, GST_CLOCK_TIME_NONE) < 0) {
       if (errno == EBUSY)
         goto flushing;
@@ -364,6 +380,10 @@ gst_shm_src_create (GstPushSrc * psrc, GstBuffer ** outbuf)
       goto error;
     }
 
+    if (self->eventpollfd.fd >= 0 &&
+        gst_poll_fd_can_read (self->poll, &self->eventpollfd))
+      sp_client_clear_event (pipe->pipe);
+
     if (gst_poll_fd_can_read (self->poll, &self->pollfd)) {
       buf = NULL;
       GST_LOG_OBJECT (self, "Reading from pipe");
@@ -375,6 +395,13 @@ gst_shm_src_create (GstPushSrc * psrc, GstBuffer ** outbuf)
             ("Error reading control data: %d", rv));
         goto error;
       }
+
+      if (self->eventpollfd.fd < 0 && sp_client_get_event_fd (pipe->pipe) >= 0) {
+        GST_DEBUG_OBJECT (self, "Receiving buffers through a ring");
+        self->eventpollfd.fd = sp_client_get_event_fd (pipe->pipe);
+        gst_poll_add_fd (self->poll, &self->eventpollfd);
+        gst_poll_fd_ctl_read (self->poll, &self->eventpollfd, TRUE);
+      }
     }
   } while (buf == NULL);
 
@@ -472,6 +499,9 @@ gst_shm_pipe_dec (GstShmPipe * pipe)
 
   gst_poll_remove_fd (pipe->src->poll, &pipe->src->pollfd);
   gst_poll_fd_init (&pipe->src->pollfd);
+  if (pipe->src->eventpollfd.fd >= 0)
+    gst_poll_remove_fd (pipe->src->poll, &pipe->src->eventpollfd);
+  gst_poll_fd_init (&pipe->src->eventpollfd);
 
   GST_OBJECT_UNLOCK (pipe->src);
 
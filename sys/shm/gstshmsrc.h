@@ -52,6 +52,8 @@ struct _GstShmSrc
   GstShmPipe *pipe;
   GstPoll *poll;
   GstPollFD pollfd;
+  /* set once the sink switched us to a ring */
+  GstPollFD eventpollfd;
 
 
   GstFlowReturn flow_return;
@@ -47,6 +47,10 @@
 #include <sys/mman.h>
 #include <assert.h>
 
+#ifdef HAVE_SYS_EVENTFD_H
+#include <sys/eventfd.h>
+#endif
+
 #include "shmalloc.h"
 
 /*
@@ -67,9 +71,23 @@
  * type 4: ack buffer
  * offset
  *
+ * type 5: new ring
+ * Ring area length
+ * Number of entries in each direction
+ * Passes the ring area and two eventfds as SCM_RIGHTS
+ *
  * Type 4 goes from the client to the server
  * The rest are from the server to the client
  * The client should never write in the SHM
+ *
+ * If the writer has a ring size set, it sends a type 5 packet right
+ * after the initial type 1 packet. From then on, types 2 and 3 go through
+ * the ring area instead of the socket, and type 4 goes through the ring
+ * in the other direction (or over the socket if that ring is full). The
+ * ring area is the only shared memory the client writes to. Each side
+ * only signals the other one's eventfd if it announced it was about to
+ * sleep, so busy pipelines exchange buffers without any syscall. The
+ * socket is still used for type 1 packets and to detect disconnection.
  */
 
 
@@ -80,10 +98,12 @@ enum
   COMMAND_NEW_SHM_AREA = 1,
   COMMAND_CLOSE_SHM_AREA = 2,
   COMMAND_NEW_BUFFER = 3,
-  COMMAND_ACK_BUFFER = 4
+  COMMAND_ACK_BUFFER = 4,
+  COMMAND_NEW_RING = 5
 };
 
 typedef struct _ShmArea ShmArea;
+typedef struct _ShmRing ShmRing;
 
 struct _ShmArea
 {
@@ -104,6 +124,64 @@ struct _ShmArea
   ShmArea *next;
 };
 
+#ifdef HAVE_SYS_EVENTFD_H
+
+#define SHM_RING_MAGIC 0x53524e47
+#define SHM_RING_CACHELINE 64
+#define SHM_RING_MAX_ENTRIES 65536
+
+typedef struct
+{
+  uint32_t type;
+  int32_t area_id;
+  uint64_t offset;
+  uint64_t size;
+} ShmRingEntry;
+
+/* One single producer, single consumer ring. The indexes are free-running
+ * and only ever written by one side, each side on its own cache line */
+typedef struct
+{
+  uint32_t head;
+  /* set by the consumer before sleeping on its eventfd */
+  uint32_t consumer_waiting;
+  char pad1[SHM_RING_CACHELINE - 2 * sizeof (uint32_t)];
+
+  uint32_t tail;
+  /* set by the producer before waiting for space */
+  uint32_t producer_waiting;
+  char pad2[SHM_RING_CACHELINE - 2 * sizeof (uint32_t)];
+} ShmRingIndex;
+
+typedef struct
+{
+  uint32_t magic;
+  uint32_t n_entries;
+  char pad[SHM_RING_CACHELINE - 2 * sizeof (uint32_t)];
+
+  ShmRingIndex to_client;
+  ShmRingIndex to_writer;
+  /* Followed by n_entries entries to the client, then n_entries entries to
+   * the writer */
+} ShmRingHeader;
+
+#endif
+
+struct _ShmRing
+{
+#ifdef HAVE_SYS_EVENTFD_H
+  ShmRingHeader *header;
+  ShmRingEntry *to_client_entries;
+  ShmRingEntry *to_writer_entries;
+  size_t len;
+#endif
+
+  /* signalled when there are new entries for the client */
+  int client_fd;
+  /* signalled when there are new entries or free space for the writer */
+  int writer_fd;
+};
+
 struct _ShmBuffer
 {
   int use_count;
@@ -141,12 +219,22 @@ struct _ShmPipe
   ShmClient *clients;
 
   mode_t perms;
+
+  /* writer: number of ring entries for new clients, 0 to use the socket */
+  unsigned int ring_size;
+  /* client: ring received from the writer, if any */
+  ShmRing *ring;
 };
 
 struct _ShmClient
 {
   int fd;
 
+  ShmRing *ring;
+  /* Areas whose close did not fit in the ring yet, oldest first */
+  int *pending_closes;
+  int n_pending_closes;
+
   ShmClient *next;
 };
 
@@ -179,6 +267,11 @@ struct CommandBuffer
     {
       unsigned long offset;
     } ack_buffer;
+    struct
+    {
+      size_t size;
+      unsigned int n_entries;
+    } new_ring;
   } payload;
 };
 
@@ -187,6 +280,7 @@ static void sp_close_shm (ShmArea * area);
 static int sp_shmbuf_dec (ShmPipe * self, ShmBuffer * buf,
     ShmBuffer * prev_buf, ShmClient * client, void **tag);
 static void sp_shm_area_dec (ShmPipe * self, ShmArea * area);
+static void sp_ring_free (ShmRing * ring);
 
 
 
@@ -445,6 +539,11 @@ sp_writer_close (ShmPipe * self, sp_buffer_free_callback callback,
   while (self->clients)
     sp_writer_close_client (self, self->clients, callback, user_data);
 
+  if (self->ring) {
+    sp_ring_free (self->ring);
+    self->ring = NULL;
+  }
+
   sp_dec (self);
 }
 
@@ -484,6 +583,313 @@ send_command (int fd, struct CommandBuffer *cb, unsigned short int type,
   return 1;
 }
 
+#ifdef HAVE_SYS_EVENTFD_H
+
+static int
+send_command_fds (int fd, struct CommandBuffer *cb, unsigned short int type,
+    int area_id, const int *fds, int n_fds)
+{
+  struct msghdr msg = { 0 };
+  struct iovec iov;
+  union
+  {
+    struct cmsghdr hdr;
+    char buf[CMSG_SPACE (sizeof (int) * 3)];
+  } cmsgbuf;
+  struct cmsghdr *cmsg;
+
+  assert (n_fds > 0 && n_fds <= 3);
+
+  cb->type = type;
+  cb->area_id = area_id;
+
+  iov.iov_base = cb;
+  iov.iov_len = sizeof (struct CommandBuffer);
+  msg.msg_iov = &iov;
+  msg.msg_iovlen = 1;
+
+  memset (&cmsgbuf, 0, sizeof (cmsgbuf));
+  msg.msg_control = cmsgbuf.buf;
+  msg.msg_controllen = CMSG_SPACE (sizeof (int) * n_fds);
+
+  cmsg = CMSG_FIRSTHDR (&msg);
+  cmsg->cmsg_level = SOL_SOCKET;
+  cmsg->cmsg_type = SCM_RIGHTS;
+  cmsg->cmsg_len = CMSG_LEN (sizeof (int) * n_fds);
+  memcpy (CMSG_DATA (cmsg), fds, sizeof (int) * n_fds);
+
+  if (sendmsg (fd, &msg, MSG_NOSIGNAL) != sizeof (struct CommandBuffer))
+    return 0;
+
+  return 1;
+}
+
+/* Adds @entry to the ring, returns 0 if the ring is full. Only one thread
+ * may push to a given ring at any time */
+static int
+sp_ring_push (ShmRingIndex * idx, ShmRingEntry * entries,
+    uint32_t n_entries, const ShmRingEntry * entry, int wake_fd)
+{
+  uint32_t head = __atomic_load_n (&idx->head, __ATOMIC_RELAXED);
+  uint32_t tail = __atomic_load_n (&idx->tail, __ATOMIC_ACQUIRE);
+
+  if (head - tail >= n_entries)
+    return 0;
+
+  entries[head & (n_entries - 1)] = *entry;
+  __atomic_store_n (&idx->head, head + 1, __ATOMIC_RELEASE);
+
+  /* Pairs with the fence in sp_ring_prepare_wait(): either the consumer
+   * sees the new head, or we see that it is going to sleep */
+  __atomic_thread_fence (__ATOMIC_SEQ_CST);
+  if (__atomic_load_n (&idx->consumer_waiting, __ATOMIC_RELAXED) &&
+      __atomic_exchange_n (&idx->consumer_waiting, 0, __ATOMIC_ACQ_REL))
+    eventfd_write (wake_fd, 1);
+
+  return 1;
+}
+
+/* Takes the oldest entry of the ring, returns 0 if it is empty and -1 if
+ * the other side corrupted the indexes */
+static int
+sp_ring_pop (ShmRingIndex * idx, ShmRingEntry * entries,
+    uint32_t n_entries, ShmRingEntry * entry, int wake_fd)
+{
+  uint32_t tail = __atomic_load_n (&idx->tail, __ATOMIC_RELAXED);
+  uint32_t head = __atomic_load_n (&idx->head, __ATOMIC_ACQUIRE);
+
+  if (head == tail)
+    return 0;
+  if (head - tail > n_entries)
+    return -1;
+
+  *entry = entries[tail & (n_entries - 1)];
+  __atomic_store_n (&idx->tail, tail + 1, __ATOMIC_RELEASE);
+
+  __atomic_thread_fence (__ATOMIC_SEQ_CST);
+  if (__atomic_load_n (&idx->producer_waiting, __ATOMIC_RELAXED) &&
+      __atomic_exchange_n (&idx->producer_waiting, 0, __ATOMIC_ACQ_REL))
+    eventfd_write (wake_fd, 1);
+
+  return 1;
+}
+
+/* Called by the consumer once the ring is empty. Returns 1 if it may now
+ * sleep on its eventfd, 0 if new entries arrived in the meantime */
+static int
+sp_ring_prepare_wait (ShmRingIndex * idx)
+{
+  __atomic_store_n (&idx->consumer_waiting, 1, __ATOMIC_RELAXED);
+  __atomic_thread_fence (__ATOMIC_SEQ_CST);
+
+  if (__atomic_load_n (&idx->head, __ATOMIC_ACQUIRE) !=
+      __atomic_load_n (&idx->tail, __ATOMIC_RELAXED)) {
+    __atomic_store_n (&idx->consumer_waiting, 0, __ATOMIC_RELAXED);
+    return 0;
+  }
+
+  return 1;
+}
+
+/* Called by the producer, returns 1 if there is space for one more entry.
+ * Otherwise the consumer will signal the producer's eventfd as soon as it
+ * frees an entry */
+static int
+sp_ring_prepare_push (ShmRingIndex * idx, uint32_t n_entries)
+{
+  uint32_t head = __atomic_load_n (&idx->head, __ATOMIC_RELAXED);
+
+  if (head - __atomic_load_n (&idx->tail, __ATOMIC_ACQUIRE) < n_entries)
+    return 1;
+
+  __atomic_store_n (&idx->producer_waiting, 1, __ATOMIC_RELAXED);
+  __atomic_thread_fence (__ATOMIC_SEQ_CST);
+
+  if (head - __atomic_load_n (&idx->tail, __ATOMIC_ACQUIRE) < n_entries) {
+    __atomic_store_n (&idx->producer_waiting, 0, __ATOMIC_RELAXED);
+    return 1;
+  }
+
+  return 0;
+}
+
+static size_t
+sp_ring_get_size (unsigned int n_entries)
+{
+  return sizeof (ShmRingHeader) + 2 * n_entries * sizeof (ShmRingEntry);
+}
+
+static ShmRing *
+sp_ring_map (int shm_fd, size_t len, unsigned int n_entries)
+{
+  ShmRing *ring = spalloc_new (ShmRing);
+
+  memset (ring, 0, sizeof (ShmRing));
+  ring->client_fd = -1;
+  ring->writer_fd = -1;
+  ring->len = len;
+
+  ring->header = mmap (NULL, len, PROT_READ | PROT_WRITE, MAP_SHARED,
+      shm_fd, 0);
+  if (ring->header == MAP_FAILED) {
+    ring->header = NULL;
+    sp_ring_free (ring);
+    return NULL;
+  }
+
+  ring->to_client_entries = (ShmRingEntry *) (ring->header + 1);
+  ring->to_writer_entries = ring->to_client_entries + n_entries;
+
+  return ring;
+}
+
+/* Creates the ring for a new client, @shm_fd is the fd to pass to the
+ * client, the caller must close it */
+static ShmRing *
+sp_ring_new (unsigned int n_entries, int *shm_fd)
+{
+  ShmRing *ring;
+  char tmppath[32];
+  size_t len = sp_ring_get_size (n_entries);
+  int fd;
+  int i = 0;
+
+  do {
+    snprintf (tmppath, sizeof (tmppath), "/shmring.%5d.%5d", getpid (), i++);
+    fd = shm_open (tmppath, O_RDWR | O_CREAT | O_EXCL, S_IRUSR | S_IWUSR);
+  } while (fd < 0 && errno == EEXIST);
+
+  if (fd < 0)
+    return NULL;
+
+  /* Only ever shared by passing the fd */
+  shm_unlink (tmppath);
+
+  if (ftruncate (fd, len) < 0) {
+    close (fd);
+    return NULL;
+  }
+
+  ring = sp_ring_map (fd, len, n_entries);
+  if (!ring) {
+    close (fd);
+    return NULL;
+  }
+
+  ring->header->magic = SHM_RING_MAGIC;
+  ring->header->n_entries = n_entries;
+
+  ring->client_fd = eventfd (0, EFD_NONBLOCK | EFD_CLOEXEC);
+  ring->writer_fd = eventfd (0, EFD_NONBLOCK | EFD_CLOEXEC);
+  if (ring->client_fd < 0 || ring->writer_fd < 0) {
+    close (fd);
+    sp_ring_free (ring);
+    return NULL;
+  }
+
+  *shm_fd = fd;
+
+  return ring;
+}
+
+/* Maps the ring received from the writer, takes ownership of the fds */
+static ShmRing *
+sp_ring_open (const int *fds, size_t len, unsigned int n_entries)
+{
+  ShmRing *ring = NULL;
+  struct stat st;
+
+  if (n_entries == 0 || (n_entries & (n_entries - 1)) != 0 ||
+      n_entries > SHM_RING_MAX_ENTRIES || len != sp_ring_get_size (n_entries))
+    goto done;
+
+  if (fstat (fds[0], &st) < 0 || (size_t) st.st_size < len)
+    goto done;
+
+  ring = sp_ring_map (fds[0], len, n_entries);
+  if (!ring)
+    goto done;
+
+  if (ring->header->magic != SHM_RING_MAGIC ||
+      ring->header->n_entries != n_entries) {
+    sp_ring_free (ring);
+    ring = NULL;
+    goto done;
+  }
+
+  ring->client_fd = fds[1];
+  ring->writer_fd = fds[2];
+
+done:
+  close (fds[0]);
+  if (!ring) {
+    close (fds[1]);
+    close (fds[2]);
+  }
+  return ring;
+}
+
+static int
+sp_ring_send (ShmRing * ring, int type, int area_id, unsigned long offset,
+    unsigned long size)
+{
+  ShmRingEntry entry;
+
+  entry.type = type;
+  entry.area_id = area_id;
+  entry.offset = offset;
+  entry.size = size;
+
+  return sp_ring_push (&ring->header->to_client, ring->to_client_entries,
+      ring->header->n_entries, &entry, ring->client_fd);
+}
+
+#else
+
+static int
+sp_ring_send (ShmRing * ring, int type, int area_id, unsigned long offset,
+    unsigned long size)
+{
+  return 0;
+}
+
+#endif
+
+static void
+sp_ring_free (ShmRing * ring)
+{
+#ifdef HAVE_SYS_EVENTFD_H
+  if (ring->header)
+    munmap (ring->header, ring->len);
+#endif
+  if (ring->client_fd >= 0)
+    close (ring->client_fd);
+  if (ring->writer_fd >= 0)
+    close (ring->writer_fd);
+
+  spalloc_free (ShmRing, ring);
+}
+
+/* Puts the closes that did not fit in the ring of @client before in it.
+ * Returns 0 if some still don't fit */
+static int
+sp_writer_flush_closes (ShmClient * client)
+{
+  int i;
+
+  for (i = 0; i < client->n_pending_closes; i++) {
+    if (!sp_ring_send (client->ring, COMMAND_CLOSE_SHM_AREA,
+            client->pending_closes[i], 0, 0))
+      break;
+  }
+
+  client->n_pending_closes -= i;
+  memmove (client->pending_closes, client->pending_closes + i,
+      client->n_pending_closes * sizeof (int));
+
+  return client->n_pending_closes == 0;
+}
+
 int
 sp_writer_resize (ShmPipe * self, size_t size)
 {
@@ -510,9 +916,26 @@ sp_writer_resize (ShmPipe * self, size_t size)
   for (client = self->clients; client; client = client->next) {
     struct CommandBuffer cb = { 0 };
 
-    if (!send_command (client->fd, &cb, COMMAND_CLOSE_SHM_AREA,
-            old_current->id))
+    /* With a ring, the close must be ordered with the buffers that are
+     * still queued for the old area. If the ring is full, it is queued
+     * once there is space, before the next buffer. The new area must be
+     * announced anyway */
+    if (client->ring) {
+      if (!sp_writer_flush_closes (client) ||
+          !sp_ring_send (client->ring, COMMAND_CLOSE_SHM_AREA,
+              old_current->id, 0, 0)) {
+        int *closes = realloc (client->pending_closes,
+            (client->n_pending_closes + 1) * sizeof (int));
+
+        if (!closes)
+          continue;
+        closes[client->n_pending_closes++] = old_current->id;
+        client->pending_closes = closes;
+      }
+    } else if (!send_command (client->fd, &cb, COMMAND_CLOSE_SHM_AREA,
+            old_current->id)) {
       continue;
+    }
 
     cb.payload.new_shm_area.size = newarea->shm_area_len;
     cb.payload.new_shm_area.path_size = pathlen;
@@ -614,10 +1037,18 @@ sp_writer_send_buf (ShmPipe * self, char *buf, size_t size, void *tag)
 
   for (client = self->clients; client; client = client->next) {
     struct CommandBuffer cb = { 0 };
-    cb.payload.buffer.offset = offset;
-    cb.payload.buffer.size = bsize;
-    if (!send_command (client->fd, &cb, COMMAND_NEW_BUFFER, self->shm_area->id))
-      continue;
+
+    if (client->ring) {
+      if (!sp_writer_flush_closes (client) ||
+          !sp_ring_send (client->ring, COMMAND_NEW_BUFFER, area->id, offset,
+              bsize))
+        continue;
+    } else {
+      cb.payload.buffer.offset = offset;
+      cb.payload.buffer.size = bsize;
+      if (!send_command (client->fd, &cb, COMMAND_NEW_BUFFER, area->id))
+        continue;
+    }
     sb->clients[i++] = client->fd;
     c++;
   }
@@ -651,6 +1082,72 @@ recv_command (int fd, struct CommandBuffer *cb)
   }
 }
 
+static void
+close_fds (const int *fds, int n_fds)
+{
+  int i;
+
+  for (i = 0; i < n_fds; i++)
+    close (fds[i]);
+}
+
+/* Like recv_command(), but also receives up to *@n_fds file descriptors
+ * passed with SCM_RIGHTS, *@n_fds is set to the number received */
+static int
+recv_command_fds (int fd, struct CommandBuffer *cb, int *fds, int *n_fds)
+{
+  struct msghdr msg = { 0 };
+  struct iovec iov;
+  union
+  {
+    struct cmsghdr hdr;
+    char buf[CMSG_SPACE (sizeof (int) * 3)];
+  } cmsgbuf;
+  struct cmsghdr *cmsg;
+  int max_fds = *n_fds;
+  int flags = MSG_DONTWAIT;
+  ssize_t retval;
+
+#ifdef MSG_CMSG_CLOEXEC
+  flags |= MSG_CMSG_CLOEXEC;
+#endif
+
+  *n_fds = 0;
+
+  iov.iov_base = cb;
+  iov.iov_len = sizeof (struct CommandBuffer);
+  msg.msg_iov = &iov;
+  msg.msg_iovlen = 1;
+  msg.msg_control = cmsgbuf.buf;
+  msg.msg_controllen = sizeof (cmsgbuf.buf);
+
+  retval = recvmsg (fd, &msg, flags);
+  if (retval < 0)
+    return 0;
+
+  for (cmsg = CMSG_FIRSTHDR (&msg); cmsg; cmsg = CMSG_NXTHDR (&msg, cmsg)) {
+    if (cmsg->cmsg_level == SOL_SOCKET && cmsg->cmsg_type == SCM_RIGHTS) {
+      int *data = (int *) CMSG_DATA (cmsg);
+      int i, n = (cmsg->cmsg_len - CMSG_LEN (0)) / sizeof (int);
+
+      for (i = 0; i < n; i++) {
+        if (*n_fds < max_fds)
+          fds[(*n_fds)++] = data[i];
+        else
+          close (data[i]);
+      }
+    }
+  }
+
+  if (retval != sizeof (struct CommandBuffer)) {
+    close_fds (fds, *n_fds);
+    *n_fds = 0;
+    return 0;
+  }
+
+  return 1;
+}
+
 long int
 sp_client_recv (ShmPipe * self, char **buf)
 {
@@ -659,10 +1156,17 @@ sp_client_recv (ShmPipe * self, char **buf)
   ShmArea *area;
   struct CommandBuffer cb;
   int retval;
+  int fds[3];
+  int n_fds = 3;
 
-  if (!recv_command (self->main_socket, &cb))
+  if (!recv_command_fds (self->main_socket, &cb, fds, &n_fds))
     return -1;
 
+  if (cb.type != COMMAND_NEW_RING) {
+    close_fds (fds, n_fds);
+    n_fds = 0;
+  }
+
   switch (cb.type) {
     case COMMAND_NEW_SHM_AREA:
       assert (cb.payload.new_shm_area.path_size > 0);
@@ -708,6 +1212,23 @@ sp_client_recv (ShmPipe * self, char **buf)
       }
       return -23;
 
+    case COMMAND_NEW_RING:
+#ifdef HAVE_SYS_EVENTFD_H
+      if (n_fds != 3 || self->ring) {
+        close_fds (fds, n_fds);
+        return -5;
+      }
+
+      self->ring = sp_ring_open (fds, cb.payload.new_ring.size,
+          cb.payload.new_ring.n_entries);
+      if (!self->ring)
+        return -6;
+      break;
+#else
+      close_fds (fds, n_fds);
+      return -99;
+#endif
+
     default:
       return -99;
   }
@@ -715,10 +1236,102 @@ sp_client_recv (ShmPipe * self, char **buf)
   return 0;
 }
 
+#ifdef HAVE_SYS_EVENTFD_H
+static ShmArea *
+sp_client_find_area (ShmPipe * self, int area_id)
+{
+  ShmArea *area;
+
+  for (area = self->shm_area; area; area = area->next) {
+    if (area->id == area_id)
+      return area;
+  }
+
+  return NULL;
+}
+#endif
+
+/* Returns the size of the next buffer in the ring and sets @buf, or 0 if
+ * the ring is empty, in which case the caller should wait until the fd
+ * returned by sp_client_get_event_fd() is readable. Negative on error */
+long int
+sp_client_recv_ring (ShmPipe * self, char **buf)
+{
+#ifdef HAVE_SYS_EVENTFD_H
+  ShmRing *ring = self->ring;
+  ShmRingEntry entry;
+  ShmArea *area;
+  int ret;
+
+  assert (ring);
+
+  for (;;) {
+    ret = sp_ring_pop (&ring->header->to_client, ring->to_client_entries,
+        ring->header->n_entries, &entry, ring->writer_fd);
+    if (ret < 0)
+      return -1;
+
+    if (ret == 0) {
+      if (sp_ring_prepare_wait (&ring->header->to_client))
+        return 0;
+      continue;
+    }
+
+    switch (entry.type) {
+      case COMMAND_CLOSE_SHM_AREA:
+        area = sp_client_find_area (self, entry.area_id);
+        if (area)
+          sp_shm_area_dec (self, area);
+        break;
+
+      case COMMAND_NEW_BUFFER:
+        area = sp_client_find_area (self, entry.area_id);
+
+        /* New areas are announced on the socket before any of their
+         * buffers are put in the ring, so it is already queued there */
+        while (!area) {
+          char *unused = NULL;
+
+          if (sp_client_recv (self, &unused) != 0)
+            return -23;
+          area = sp_client_find_area (self, entry.area_id);
+        }
+
+        if (entry.offset > area->shm_area_len ||
+            entry.size > area->shm_area_len - entry.offset)
+          return -24;
+
+        *buf = area->shm_area_buf + entry.offset;
+        sp_shm_area_inc (area);
+        return entry.size;
+
+      default:
+        return -99;
+    }
+  }
+#else
+  return -1;
+#endif
+}
+
+static int
+sp_writer_ack_buffer (ShmPipe * self, ShmClient * client, int area_id,
+    unsigned long offset, void **tag)
+{
+  ShmBuffer *buf = NULL, *prev_buf = NULL;
+
+  for (buf = self->buffers; buf; buf = buf->next) {
+    if (buf->shm_area->id == area_id && buf->offset == offset)
+      return sp_shmbuf_dec (self, buf, prev_buf, client, tag);
+    prev_buf = buf;
+  }
+
+  return -2;
+}
+
 int
 sp_writer_recv (ShmPipe * self, ShmClient * client, void **tag)
 {
-  ShmBuffer *buf = NULL, *prev_buf = NULL;
   struct CommandBuffer cb;
 
   if (!recv_command (client->fd, &cb))
@@ -726,16 +1339,8 @@ sp_writer_recv (ShmPipe * self, ShmClient * client, void **tag)
 
   switch (cb.type) {
     case COMMAND_ACK_BUFFER:
-
-      for (buf = self->buffers; buf; buf = buf->next) {
-        if (buf->shm_area->id == cb.area_id &&
-            buf->offset == cb.payload.ack_buffer.offset) {
-          return sp_shmbuf_dec (self, buf, prev_buf, client, tag);
-        }
-        prev_buf = buf;
-      }
-
-      return -2;
+      return sp_writer_ack_buffer (self, client, cb.area_id,
+          cb.payload.ack_buffer.offset, tag);
     default:
       return -99;
   }
@@ -743,11 +1348,44 @@ sp_writer_recv (ShmPipe * self, ShmClient * client, void **tag)
   return 0;
 }
 
+/* Same as sp_writer_recv() for the acks the client put in its ring.
+ * Returns 2 once the ring is empty, in which case the caller should wait
+ * until the fd returned by sp_writer_get_client_event_fd() is readable */
+int
+sp_writer_recv_ring (ShmPipe * self, ShmClient * client, void **tag)
+{
+#ifdef HAVE_SYS_EVENTFD_H
+  ShmRing *ring = client->ring;
+  ShmRingEntry entry;
+  int ret;
+
+  assert (ring);
+
+  while ((ret = sp_ring_pop (&ring->header->to_writer,
+              ring->to_writer_entries, ring->header->n_entries, &entry,
+              ring->client_fd)) == 0) {
+    if (sp_ring_prepare_wait (&ring->header->to_writer))
+      return 2;
+  }
+
+  if (ret < 0)
+    return -1;
+
+  if (entry.type != COMMAND_ACK_BUFFER)
+    return -99;
+
+  return sp_writer_ack_buffer (self, client, entry.area_id, entry.offset, tag);
+#else
+  return -1;
+#endif
+}
+
 int
 sp_client_recv_finish (ShmPipe * self, char *buf)
 {
   ShmArea *shm_area = NULL;
   unsigned long offset;
+  int area_id;
   struct CommandBuffer cb = { 0 };
 
   for (shm_area = self->shm_area; shm_area; shm_area = shm_area->next) {
@@ -759,12 +1397,24 @@ sp_client_recv_finish (ShmPipe * self, char *buf)
   assert (shm_area);
 
   offset = buf - shm_area->shm_area_buf;
+  area_id = shm_area->id;
 
   sp_shm_area_dec (self, shm_area);
 
+#ifdef HAVE_SYS_EVENTFD_H
+  if (self->ring) {
+    ShmRing *ring = self->ring;
+    ShmRingEntry entry = { COMMAND_ACK_BUFFER, area_id, offset, 0 };
+
+    /* If the writer is that far behind, the socket will do */
+    if (sp_ring_push (&ring->header->to_writer, ring->to_writer_entries,
+            ring->header->n_entries, &entry, ring->writer_fd))
+      return 1;
+  }
+#endif
+
   cb.payload.ack_buffer.offset = offset;
-  return send_command (self->main_socket, &cb, COMMAND_ACK_BUFFER,
-      self->shm_area->id);
+  return send_command (self->main_socket, &cb, COMMAND_ACK_BUFFER, area_id);
 }
 
 ShmPipe *
@@ -808,6 +1458,7 @@ ShmClient *
 sp_writer_accept_client (ShmPipe * self)
 {
   ShmClient *client = NULL;
+  ShmRing *ring = NULL;
   int fd;
   struct CommandBuffer cb = { 0 };
   int pathlen = strlen (self->shm_area->shm_area_name) + 1;
@@ -833,8 +1484,34 @@ sp_writer_accept_client (ShmPipe * self)
     goto error;
   }
 
+#ifdef HAVE_SYS_EVENTFD_H
+  if (self->ring_size > 0) {
+    int fds[3];
+
+    ring = sp_ring_new (self->ring_size, &fds[0]);
+    if (!ring) {
+      fprintf (stderr, "Creating ring failed: %s", strerror (errno));
+      goto error;
+    }
+
+    fds[1] = ring->client_fd;
+    fds[2] = ring->writer_fd;
+    cb.payload.new_ring.size = ring->len;
+    cb.payload.new_ring.n_entries = self->ring_size;
+    if (!send_command_fds (fd, &cb, COMMAND_NEW_RING, 0, fds, 3)) {
+      fprintf (stderr, "Sending new ring failed: %s", strerror (errno));
+      close (fds[0]);
+      goto error;
+    }
+    close (fds[0]);
+  }
+#endif
+
   client = spalloc_new (ShmClient);
   client->fd = fd;
+  client->ring = ring;
+  client->pending_closes = NULL;
+  client->n_pending_closes = 0;
 
   /* Prepend ot linked list */
   client->next = self->clients;
@@ -844,6 +1521,8 @@ sp_writer_accept_client (ShmPipe * self)
   return client;
 
 error:
+  if (ring)
+    sp_ring_free (ring);
   shutdown (fd, SHUT_RDWR);
   close (fd);
   return NULL;
@@ -931,6 +1610,10 @@ again:
 
   self->num_clients--;
 
+  if (client->ring)
+    sp_ring_free (client->ring);
+  free (client->pending_closes);
+
   spalloc_free (ShmClient, client);
 }
 
@@ -993,3 +1676,107 @@ sp_writer_get_max_buf_size (ShmPipe * self)
 
   return self->shm_area->shm_area_len;
 }
+
+/* Makes clients that connect from now on exchange buffers through a ring
+ * of @n_entries entries (rounded up to a power of two) instead of the
+ * socket, 0 to go back to the socket. Returns the actual number of
+ * entries, or -1 if rings are not supported on this platform */
+int
+sp_writer_set_ring_size (ShmPipe * self, unsigned int n_entries)
+{
+#ifdef HAVE_SYS_EVENTFD_H
+  unsigned int size = 1;
+
+  if (n_entries > SHM_RING_MAX_ENTRIES)
+    n_entries = SHM_RING_MAX_ENTRIES;
+
+  if (n_entries == 0) {
+    self->ring_size = 0;
+    return 0;
+  }
+
+  while (size < n_entries)
+    size <<= 1;
+  self->ring_size = size;
+
+  return size;
+#else
+  return n_entries == 0 ? 0 : -1;
+#endif
+}
+
+/* Returns 1 if sp_writer_send_buf() can queue a buffer for every client.
+ * Otherwise the event fds of the clients with a full ring will become
+ * readable once they have made space */
+int
+sp_writer_can_send (ShmPipe * self)
+{
+#ifdef HAVE_SYS_EVENTFD_H
+  ShmClient *client;
+  int ret = 1;
+
+  for (client = self->clients; client; client = client->next) {
+    ShmRingHeader *header;
+
+    if (!client->ring)
+      continue;
+
+    header = client->ring->header;
+    /* The closes that did not fit in the ring before go first */
+    while (!sp_writer_flush_closes (client)) {
+      if (!sp_ring_prepare_push (&header->to_client, header->n_entries))
+        break;
+    }
+
+    if (client->n_pending_closes > 0 ||
+        !sp_ring_prepare_push (&header->to_client, header->n_entries))
+      ret = 0;
+  }
+
+  return ret;
+#else
+  return 1;
+#endif
+}
+
+int
+sp_writer_get_client_event_fd (ShmClient * client)
+{
+  if (client->ring)
+    return client->ring->writer_fd;
+
+  return -1;
+}
+
+static void
+sp_clear_event_fd (int fd)
+{
+#ifdef HAVE_SYS_EVENTFD_H
+  eventfd_t value;
+
+  eventfd_read (fd, &value);
+#endif
+}
+
+void
+sp_writer_clear_client_event (ShmClient * client)
+{
+  if (client->ring)
+    sp_clear_event_fd (client->ring->writer_fd);
+}
+
+int
+sp_client_get_event_fd (ShmPipe * self)
+{
+  if (self->ring)
+    return self->ring->client_fd;
+
+  return -1;
+}
+
+void
+sp_client_clear_event (ShmPipe * self)
+{
+  if (self->ring)
+    sp_clear_event_fd (self->ring->client_fd);
+}
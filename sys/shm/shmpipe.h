@@ -56,6 +56,19 @@
  * buffers are no longer valid. If was valid buffer was received, the
  * client must release it with sp_client_recv_finish() when it is done
  * reading from it.
+ *
+ * If the writer calls sp_writer_set_ring_size() before accepting a
+ * client, buffers are passed through a ring in shared memory instead of
+ * the socket. Once sp_client_get_event_fd() returns a valid fd after a
+ * call to sp_client_recv(), the reader takes its buffers with
+ * sp_client_recv_ring() until it returns 0, then it select()s on both
+ * that fd and the socket, calling sp_client_clear_event() when the
+ * former is readable. On the writer side, for clients where
+ * sp_writer_get_client_event_fd() returns a valid fd, the writer also
+ * select()s on it, calls sp_writer_clear_client_event() when it is
+ * readable and then sp_writer_recv_ring() until it returns 2. If
+ * sp_writer_can_send() returns 0, the writer must wait for the event fds
+ * before sending the next buffer.
  */
 
 
@@ -108,6 +121,12 @@ int sp_writer_recv (ShmPipe * self, ShmClient * client, void ** tag);
 
 int sp_writer_pending_writes (ShmPipe * self);
 
+int sp_writer_set_ring_size (ShmPipe * self, unsigned int n_entries);
+int sp_writer_can_send (ShmPipe * self);
+int sp_writer_get_client_event_fd (ShmClient * client);
+void sp_writer_clear_client_event (ShmClient * client);
+int sp_writer_recv_ring (ShmPipe * self, ShmClient * client, void ** tag);
+
 ShmBuffer *sp_writer_get_pending_buffers (ShmPipe * self);
 ShmBuffer *sp_writer_get_next_buffer (ShmBuffer * buffer);
 void *sp_writer_buf_get_tag (ShmBuffer * buffer);
@@ -115,6 +134,9 @@ void *sp_writer_buf_get_tag (ShmBuffer * buffer);
 ShmPipe *sp_client_open (const char *path);
 long int sp_client_recv (ShmPipe * self, char **buf);
 int sp_client_recv_finish (ShmPipe * self, char *buf);
+long int sp_client_recv_ring (ShmPipe * self, char **buf);
+int sp_client_get_event_fd (ShmPipe * self);
+void sp_client_clear_event (ShmPipe * self);
 void sp_client_close (ShmPipe * self);
 
 #ifdef __cplusplus
@@ -0,0 +1,253 @@
+/* GStreamer
+ *
+ * unit test for audiomixmatrix
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin St, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#include <gst/check/gstcheck.h>
+#include <gst/check/gstharness.h>
+#include <gst/audio/audio.h>
+
+#include <math.h>
+
+/* More than one block of the mixing kernels, and not a multiple of it */
+#define N_SAMPLES 1000
+#define IN_CHANNELS 3
+#define MAX_OUT_CHANNELS 3
+
+static const struct
+{
+  GstAudioFormat format;
+  /* maximum difference to the exact result, with samples in [-1, 1] */
+  gdouble tolerance;
+} formats[] = {
+  {GST_AUDIO_FORMAT_F32, 1e-6},
+  {GST_AUDIO_FORMAT_F64, 1e-12},
+  {GST_AUDIO_FORMAT_S16, 1e-3},
+  {GST_AUDIO_FORMAT_S32, 1e-8},
+};
+
+typedef struct
+{
+  const gchar *name;
+  guint out_channels;
+  gdouble matrix[MAX_OUT_CHANNELS][IN_CHANNELS];
+  /* only copies channels, the output must be exact */
+  gboolean exact;
+} TestMatrix;
+
+static const TestMatrix matrices[] = {
+  {"mix", 2, {{0.5, -0.25, 0.25}, {0.125, 0.375, -0.5}}, FALSE},
+  {"sparse", 3, {{0.5, 0.5, 0}, {0, 0, 0}, {0, 0, -1}}, FALSE},
+  {"permute", 3, {{0, 0, 1}, {1, 0, 0}, {0, 1, 0}}, TRUE},
+  {"select", 2, {{0, 1, 0}, {0, 0, 0}}, TRUE},
+  {"identity", 3, {{1, 0, 0}, {0, 1, 0}, {0, 0, 1}}, TRUE},
+};
+
+static gsize
+sample_index (gboolean planar, guint channels, guint c, guint s)
+{
+  return planar ? c * N_SAMPLES + s : s * channels + c;
+}
+
+static gdouble
+read_sample (GstAudioFormat format, const guint8 * data, gsize idx)
+{
+  switch (format) {
+    case GST_AUDIO_FORMAT_F32:
+      return ((const gfloat *) data)[idx];
+    case GST_AUDIO_FORMAT_F64:
+      return ((const gdouble *) data)[idx];
+    case GST_AUDIO_FORMAT_S16:
+      return ((const gint16 *) data)[idx] / 32768.0;
+    case GST_AUDIO_FORMAT_S32:
+      return ((const gint32 *) data)[idx] / 2147483648.0;
+    default:
+      g_assert_not_reached ();
+      return 0;
+  }
+}
+
+static void
+write_sample (GstAudioFormat format, guint8 * data, gsize idx, gdouble v)
+{
+  switch (format) {
+    case GST_AUDIO_FORMAT_F32:
+      ((gfloat *) data)[idx] = v;
+      break;
+    case GST_AUDIO_FORMAT_F64:
+      ((gdouble *) data)[idx] = v;
+      break;
+    case GST_AUDIO_FORMAT_S16:
+      ((gint16 *) data)[idx] = lrint (v * 32767);
+      break;
+    case GST_AUDIO_FORMAT_S32:
+      ((gint32 *) data)[idx] = lrint (v * 2147483647.0);
+      break;
+    default:
+      g_assert_not_reached ();
+  }
+}
+
+static void
+set_matrix (GstElement * element, const TestMatrix * m)
+{
+  GValue v = G_VALUE_INIT;
+  guint out, in;
+
+  g_value_init (&v, GST_TYPE_ARRAY);
+  for (out = 0; out < m->out_channels; out++) {
+    GValue row = G_VALUE_INIT;
+
+    g_value_init (&row, GST_TYPE_ARRAY);
+    for (in = 0; in < IN_CHANNELS; in++) {
+      GValue itm = G_VALUE_INIT;
+
+      g_value_init (&itm, G_TYPE_DOUBLE);
+      g_value_set_double (&itm, m->matrix[out][in]);
+      gst_value_array_append_value (&row, &itm);
+      g_value_unset (&itm);
+    }
+    gst_value_array_append_value (&v, &row);
+    g_value_unset (&row);
+  }
+
+  g_object_set (element, "in-channels", IN_CHANNELS, "out-channels",
+      m->out_channels, NULL);
+  g_object_set_property (G_OBJECT (element), "matrix", &v);
+  g_value_unset (&v);
+}
+
+static gchar *
+caps_string (GstAudioFormat format, gboolean planar, guint channels)
+{
+  return g_strdup_printf ("audio/x-raw,format=%s,layout=%s,rate=48000,"
+      "channels=%u,channel-mask=(bitmask)0x0",
+      gst_audio_format_to_string (format),
+      planar ? "non-interleaved" : "interleaved", channels);
+}
+
+/* Mixes samples spread over [-0.9, 0.9] and compares the output with the
+ * mix computed in double precision */
+static void
+check_matrix (const TestMatrix * m, GstAudioFormat format, gdouble tolerance,
+    gboolean planar)
+{
+  GstHarness *h = gst_harness_new ("audiomixmatrix");
+  GstAudioInfo in_info;
+  GstBuffer *inbuf, *outbuf;
+  GstMapInfo inmap, outmap;
+  GstCaps *caps;
+  gchar *in_caps, *out_caps;
+  guint c, s, out, in;
+
+  set_matrix (h->element, m);
+  in_caps = caps_string (format, planar, IN_CHANNELS);
+  out_caps = caps_string (format, planar, m->out_channels);
+  gst_harness_set_caps_str (h, in_caps, out_caps);
+
+  caps = gst_caps_from_string (in_caps);
+  fail_unless (gst_audio_info_from_caps (&in_info, caps));
+  gst_caps_unref (caps);
+
+  inbuf = gst_buffer_new_allocate (NULL, N_SAMPLES * in_info.bpf, NULL);
+  gst_buffer_map (inbuf, &inmap, GST_MAP_WRITE);
+  for (c = 0; c < IN_CHANNELS; c++) {
+    for (s = 0; s < N_SAMPLES; s++)
+      write_sample (format, inmap.data, sample_index (planar, IN_CHANNELS, c,
+              s), 0.9 * sin (s * 0.05 + c * 2.0));
+  }
+  gst_buffer_unmap (inbuf, &inmap);
+  if (planar)
+    gst_buffer_add_audio_meta (inbuf, &in_info, N_SAMPLES, NULL);
+
+  outbuf = gst_harness_push_and_pull (h, gst_buffer_ref (inbuf));
+  fail_unless (outbuf != NULL);
+
+  gst_buffer_map (inbuf, &inmap, GST_MAP_READ);
+  gst_buffer_map (outbuf, &outmap, GST_MAP_READ);
+  fail_unless_equals_int (outmap.size,
+      N_SAMPLES * m->out_channels * GST_AUDIO_INFO_BPS (&in_info));
+
+  for (out = 0; out < m->out_channels; out++) {
+    for (s = 0; s < N_SAMPLES; s++) {
+      gdouble expected = 0, value;
+
+      for (in = 0; in < IN_CHANNELS; in++)
+        expected += m->matrix[out][in] * read_sample (format, inmap.data,
+            sample_index (planar, IN_CHANNELS, in, s));
+      value = read_sample (format, outmap.data,
+          sample_index (planar, m->out_channels, out, s));
+
+      if (m->exact ? value != expected : fabs (value - expected) > tolerance)
+        fail ("%s matrix, %s %s: sample %u of channel %u is %.12f, expected "
+            "%.12f", m->name, gst_audio_format_to_string (format),
+            planar ? "non-interleaved" : "interleaved", s, out, value,
+            expected);
+    }
+  }
+
+  gst_buffer_unmap (outbuf, &outmap);
+  gst_buffer_unmap (inbuf, &inmap);
+  gst_buffer_unref (outbuf);
+  gst_buffer_unref (inbuf);
+
+  gst_harness_teardown (h);
+  g_free (out_caps);
+  g_free (in_caps);
+}
+
+static void
+check_matrices (gboolean planar)
+{
+  guint f, m;
+
+  for (f = 0; f < G_N_ELEMENTS (formats); f++) {
+    for (m = 0; m < G_N_ELEMENTS (matrices); m++)
+      check_matrix (&matrices[m], formats[f].format, formats[f].tolerance,
+          planar);
+  }
+}
+
+GST_START_TEST (test_interleaved)
+{
+  check_matrices (FALSE);
+}
+
+GST_END_TEST;
+
+GST_START_TEST (test_non_interleaved)
+{
+  check_matrices (TRUE);
+}
+
+GST_END_TEST;
+
+static Suite *
+audiomixmatrix_suite (void)
+{
+  Suite *s = suite_create ("audiomixmatrix");
+  TCase *tc_chain = tcase_create ("general");
+
+  suite_add_tcase (s, tc_chain);
+  tcase_add_test (tc_chain, test_interleaved);
+  tcase_add_test (tc_chain, test_non_interleaved);
+
+  return s;
+}
+
+GST_CHECK_MAIN (audiomixmatrix);
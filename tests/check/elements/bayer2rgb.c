@@ -0,0 +1,496 @@
+/* GStreamer
+ *
+ * unit test for bayer2rgb
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin St, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#include <gst/check/gstcheck.h>
+#include <gst/check/gstharness.h>
+
+#define HEIGHT 4
+
+static const struct
+{
+  const gchar *suffix;
+  gint bits;
+} depths[] = {
+  {"", 8},
+  {"10le", 10},
+  {"10be", 10},
+  {"12le", 12},
+  {"12be", 12},
+  {"14le", 14},
+  {"14be", 14},
+  {"16le", 16},
+  {"16be", 16},
+  {"10p", 10},
+  {"12p", 12},
+};
+
+static const gint widths[] = { 1, 2, 3, 5, 6, 7, 9 };
+
+static const struct
+{
+  const gchar *name;
+  gint offsets[3];
+  gint bpc;
+} outputs[] = {
+  {"RGBx", {0, 1, 2}, 1},
+  {"BGRx", {2, 1, 0}, 1},
+  {"RGBA64_LE", {0, 2, 4}, 2},
+};
+
+/* Writes a row of @width @samples, packed like @suffix says, and returns
+ * its size in bytes */
+static gsize
+write_row (guint8 * row, const gchar * suffix, gint width,
+    const guint * samples)
+{
+  gsize i;
+
+  if (g_str_equal (suffix, "")) {
+    for (i = 0; i < width; i++)
+      row[i] = samples[i];
+    return width;
+  } else if (g_str_equal (suffix, "10p")) {
+    /* 4 samples in 5 bytes, the 2 low bits of each in the last one, rows
+     * end with a complete group */
+    memset (row, 0, (width + 3) / 4 * 5);
+    for (i = 0; i < width; i++) {
+      row[i / 4 * 5 + i % 4] = samples[i] >> 2;
+      row[i / 4 * 5 + 4] |= (samples[i] & 0x3) << (2 * (i % 4));
+    }
+    return (width + 3) / 4 * 5;
+  } else if (g_str_equal (suffix, "12p")) {
+    /* 2 samples in 3 bytes, the 4 low bits of each in the last one */
+    memset (row, 0, (width + 1) / 2 * 3);
+    for (i = 0; i < width; i++) {
+      row[i / 2 * 3 + i % 2] = samples[i] >> 4;
+      row[i / 2 * 3 + 2] |= (samples[i] & 0xf) << (4 * (i % 2));
+    }
+    return (width + 1) / 2 * 3;
+  }
+
+  for (i = 0; i < width; i++) {
+    if (g_str_has_suffix (suffix, "le"))
+      GST_WRITE_UINT16_LE (row + 2 * i, samples[i]);
+    else
+      GST_WRITE_UINT16_BE (row + 2 * i, samples[i]);
+  }
+  return width * 2;
+}
+
+/* Scales a component of @bits to the output depth like bayer2rgb does,
+ * replicating its high bits in the low ones of 16 bit output */
+static guint
+scale (guint v, gint bits, gint bpc)
+{
+  if (bpc == 1)
+    return v >> (bits - 8);
+
+  return (v << (16 - bits)) | (bits < 16 ? v >> (2 * bits - 16) : 0);
+}
+
+/* Converts the @width x @height @samples of format @order@suffix to @out
+ * and returns the output */
+static GstBuffer *
+convert (const gchar * method, guint n_threads, const gchar * order,
+    const gchar * suffix, gint width, gint height, const guint * samples,
+    const gchar * out)
+{
+  GstHarness *h;
+  GstBuffer *inbuf, *outbuf;
+  gchar *desc, *in_caps, *out_caps;
+  gsize stride, row_size = 0;
+  guint8 *row;
+  gint y;
+
+  desc = g_strdup_printf ("bayer2rgb method=%s n-threads=%u", method,
+      n_threads);
+  in_caps = g_strdup_printf ("video/x-bayer,format=%s%s,width=%d,"
+      "height=%d,framerate=30/1", order, suffix, width, height);
+  out_caps = g_strdup_printf ("video/x-raw,format=%s,width=%d,height=%d,"
+      "framerate=30/1", out, width, height);
+
+  h = gst_harness_new_parse (desc);
+  gst_harness_set_caps_str (h, in_caps, out_caps);
+
+  /* rows are padded to 4 bytes */
+  row = g_malloc0 (2 * width + 8);
+  stride = GST_ROUND_UP_4 (write_row (row, suffix, width, samples));
+  inbuf = gst_buffer_new_allocate (NULL, stride * height, NULL);
+  gst_buffer_memset (inbuf, 0, 0, stride * height);
+  for (y = 0; y < height; y++) {
+    row_size = write_row (row, suffix, width, samples + y * width);
+    gst_buffer_fill (inbuf, y * stride, row, row_size);
+  }
+  g_free (row);
+
+  outbuf = gst_harness_push_and_pull (h, inbuf);
+  fail_unless (outbuf != NULL);
+
+  gst_harness_teardown (h);
+  g_free (out_caps);
+  g_free (in_caps);
+  g_free (desc);
+
+  return outbuf;
+}
+
+/* A flat frame stays flat with either method, so every output pixel must
+ * be the input sample scaled to the output depth, up to the edges of odd
+ * sized frames */
+static void
+check_flat_frame (const gchar * method, guint n_threads, const gchar * suffix,
+    gint bits, gint width, gboolean out_16)
+{
+  GstBuffer *outbuf;
+  GstMapInfo map;
+  guint v = ((1 << bits) - 1) * 5 / 8, expected;
+  guint *samples;
+  gsize x, y;
+
+  expected = scale (v, bits, out_16 ? 2 : 1);
+
+  samples = g_new (guint, width * HEIGHT);
+  for (x = 0; x < width * HEIGHT; x++)
+    samples[x] = v;
+  outbuf = convert (method, n_threads, "bggr", suffix, width, HEIGHT, samples,
+      out_16 ? "RGBA64_LE" : "RGBx");
+  g_free (samples);
+
+  gst_buffer_map (outbuf, &map, GST_MAP_READ);
+  fail_unless_equals_int (map.size, width * HEIGHT * (out_16 ? 8 : 4));
+  for (y = 0; y < HEIGHT; y++) {
+    for (x = 0; x < width; x++) {
+      const guint8 *p = map.data + (y * width + x) * (out_16 ? 8 : 4);
+      guint c;
+
+      for (c = 0; c < 3; c++) {
+        guint value = out_16 ? GST_READ_UINT16_LE (p + 2 * c) : p[c];
+
+        if (value != expected)
+          fail ("bggr%s %s %u threads %dx%d to %s: pixel %" G_GSIZE_FORMAT
+              ",%" G_GSIZE_FORMAT " component %u is %u, expected %u",
+              suffix, method, n_threads, width, HEIGHT,
+              out_16 ? "RGBA64_LE" : "RGBx", x, y, c, value, expected);
+      }
+    }
+  }
+  gst_buffer_unmap (outbuf, &map);
+  gst_buffer_unref (outbuf);
+}
+
+static void
+check_depths (const gchar * method, guint n_threads)
+{
+  guint d, w;
+
+  for (d = 0; d < G_N_ELEMENTS (depths); d++) {
+    for (w = 0; w < G_N_ELEMENTS (widths); w++) {
+      check_flat_frame (method, n_threads, depths[d].suffix, depths[d].bits,
+          widths[w], TRUE);
+      if (depths[d].bits > 8)
+        check_flat_frame (method, n_threads, depths[d].suffix,
+            depths[d].bits, widths[w], FALSE);
+    }
+  }
+}
+
+GST_START_TEST (test_depths_bilinear)
+{
+  check_depths ("bilinear", 1);
+}
+
+GST_END_TEST;
+
+GST_START_TEST (test_depths_malvar_he_cutler)
+{
+  check_depths ("malvar-he-cutler", 1);
+}
+
+GST_END_TEST;
+
+GST_START_TEST (test_depths_threads)
+{
+  check_depths ("malvar-he-cutler", 3);
+}
+
+GST_END_TEST;
+
+static const gchar *orders[] = { "bggr", "gbrg", "grbg", "rggb" };
+
+/* The interpolation kernels of the reference, scaled to a sum of 16: green
+ * at the red and blue sites, the other colour at the red and blue sites,
+ * and the colour of the horizontal neighbours at the green sites. The one
+ * of the vertical neighbours uses the transpose of the latter. */
+static const gint bilinear_kernels[3][5][5] = {
+  {{0, 0, 0, 0, 0},
+        {0, 0, 4, 0, 0},
+        {0, 4, 0, 4, 0},
+        {0, 0, 4, 0, 0},
+      {0, 0, 0, 0, 0}},
+  {{0, 0, 0, 0, 0},
+        {0, 4, 0, 4, 0},
+        {0, 0, 0, 0, 0},
+        {0, 4, 0, 4, 0},
+      {0, 0, 0, 0, 0}},
+  {{0, 0, 0, 0, 0},
+        {0, 0, 0, 0, 0},
+        {0, 8, 0, 8, 0},
+        {0, 0, 0, 0, 0},
+      {0, 0, 0, 0, 0}},
+};
+
+/* Figure 2 of "High-quality linear interpolation for demosaicing of
+ * Bayer-patterned color images", scaled by 16 instead of 8 */
+static const gint mhc_kernels[3][5][5] = {
+  {{0, 0, -2, 0, 0},
+        {0, 0, 4, 0, 0},
+        {-2, 4, 8, 4, -2},
+        {0, 0, 4, 0, 0},
+      {0, 0, -2, 0, 0}},
+  {{0, 0, -3, 0, 0},
+        {0, 4, 0, 4, 0},
+        {-3, 0, 12, 0, -3},
+        {0, 4, 0, 4, 0},
+      {0, 0, -3, 0, 0}},
+  {{0, 0, 1, 0, 0},
+        {0, -2, 0, -2, 0},
+        {-2, 8, 10, 8, -2},
+        {0, -2, 0, -2, 0},
+      {0, 0, 1, 0, 0}},
+};
+
+/* The rows and columns outside of the frame mirror the ones inside */
+static gint
+mirror (gint i, gint n)
+{
+  i = i < 0 ? -i : i >= n ? 2 * (n - 1) - i : i;
+
+  return CLAMP (i, 0, n - 1);
+}
+
+static guint
+filter (const guint * samples, gint width, gint height, gint x, gint y,
+    const gint kernel[5][5], gboolean transpose, guint max)
+{
+  gint sum = 0, dx, dy;
+
+  for (dy = -2; dy <= 2; dy++) {
+    for (dx = -2; dx <= 2; dx++) {
+      gint k = transpose ? kernel[dx + 2][dy + 2] : kernel[dy + 2][dx + 2];
+
+      sum += k * samples[mirror (y + dy, height) * width +
+          mirror (x + dx, width)];
+    }
+  }
+  sum = (sum + 8) / 16;
+
+  return CLAMP (sum, 0, (gint) max);
+}
+
+/* Demosaics the pixel @x,@y of @samples in the bayer @order into @rgb */
+static void
+reference_pixel (const guint * samples, gint width, gint height,
+    const gchar * order, const gint kernels[3][5][5], guint max, gint x,
+    gint y, guint rgb[3])
+{
+  /* offset of the first sample in the BGGR pattern */
+  gint x_off = order[0] == 'r' || (order[0] == 'g' && order[1] == 'b');
+  gint y_off = order[0] == 'r' || (order[0] == 'g' && order[1] == 'r');
+  gboolean odd_col = (x + x_off) & 1, odd_row = (y + y_off) & 1;
+  guint c = samples[y * width + x];
+
+  if (odd_col == odd_row) {
+    /* blue or red site */
+    gint c0 = odd_row ? 0 : 2;
+
+    rgb[c0] = c;
+    rgb[1] = filter (samples, width, height, x, y, kernels[0], FALSE, max);
+    rgb[2 - c0] = filter (samples, width, height, x, y, kernels[1], FALSE,
+        max);
+  } else {
+    /* green site, between blue samples on the rows of blue ones */
+    gint ch = odd_row ? 0 : 2;
+
+    rgb[1] = c;
+    rgb[ch] = filter (samples, width, height, x, y, kernels[2], FALSE, max);
+    rgb[2 - ch] = filter (samples, width, height, x, y, kernels[2], TRUE,
+        max);
+  }
+}
+
+/* Converts a frame of noise and compares it with the reference. The 8 bit
+ * bilinear conversion to 8 bit output is done by the ORC kernels, which
+ * average pairs of averages and handle the last 2 columns their own way, so
+ * those are allowed to be 1 off and the last 2 columns aren't checked. */
+static void
+check_pattern (const gchar * order, const gchar * method, guint n_threads,
+    const gchar * suffix, gint bits, gint width, gint height, guint out)
+{
+  const gint (*kernels)[5][5] = g_str_equal (method, "bilinear") ?
+      bilinear_kernels : mhc_kernels;
+  gint bpc = outputs[out].bpc, tolerance = 0, x_end = width, x, y;
+  guint max = (1 << bits) - 1;
+  GstBuffer *outbuf;
+  GstMapInfo map;
+  guint *samples;
+  GRand *rand;
+
+  if (g_str_equal (method, "bilinear") && bits == 8 && bpc == 1
+      && width >= 4 && width % 2 == 0) {
+    tolerance = 1;
+    x_end = width - 2;
+  }
+
+  rand = g_rand_new_with_seed (width * 1000 + height);
+  samples = g_new (guint, width * height);
+  for (x = 0; x < width * height; x++)
+    samples[x] = g_rand_int_range (rand, 0, max + 1);
+  g_rand_free (rand);
+
+  outbuf = convert (method, n_threads, order, suffix, width, height, samples,
+      outputs[out].name);
+
+  gst_buffer_map (outbuf, &map, GST_MAP_READ);
+  fail_unless_equals_int (map.size, width * height * 4 * bpc);
+  for (y = 0; y < height; y++) {
+    for (x = 0; x < x_end; x++) {
+      const guint8 *p = map.data + (y * width + x) * 4 * bpc;
+      guint rgb[3], c;
+
+      reference_pixel (samples, width, height, order, kernels, max, x, y,
+          rgb);
+      for (c = 0; c < 3; c++) {
+        const guint8 *comp = p + outputs[out].offsets[c];
+        guint value = bpc == 2 ? GST_READ_UINT16_LE (comp) : *comp;
+        guint expected = scale (rgb[c], bits, bpc);
+
+        if (ABS ((gint) value - (gint) expected) > tolerance)
+          fail ("%s%s %s %u threads %dx%d to %s: pixel %d,%d component %u "
+              "is %u, expected %u", order, suffix, method, n_threads, width,
+              height, outputs[out].name, x, y, c, value, expected);
+      }
+    }
+  }
+  gst_buffer_unmap (outbuf, &map);
+  gst_buffer_unref (outbuf);
+  g_free (samples);
+}
+
+static void
+check_patterns (const gchar * method, guint n_threads)
+{
+  static const gint sizes[][2] = { {1, 1}, {2, 3}, {7, 5}, {12, 6}, {150, 9} };
+  guint o, d, s, out;
+
+  for (o = 0; o < G_N_ELEMENTS (orders); o++) {
+    for (d = 0; d < G_N_ELEMENTS (depths); d++) {
+      for (s = 0; s < G_N_ELEMENTS (sizes); s++) {
+        for (out = 0; out < G_N_ELEMENTS (outputs); out++) {
+          check_pattern (orders[o], method, n_threads, depths[d].suffix,
+              depths[d].bits, sizes[s][0], sizes[s][1], out);
+        }
+      }
+    }
+  }
+}
+
+GST_START_TEST (test_pattern_bilinear)
+{
+  check_patterns ("bilinear", 1);
+}
+
+GST_END_TEST;
+
+GST_START_TEST (test_pattern_malvar_he_cutler)
+{
+  check_patterns ("malvar-he-cutler", 1);
+}
+
+GST_END_TEST;
+
+GST_START_TEST (test_pattern_threads)
+{
+  check_patterns ("malvar-he-cutler", 3);
+}
+
+GST_END_TEST;
+
+/* The sample of each site is output as is, so distinct samples show where
+ * the bits of the packed formats are taken from */
+static void
+check_packed (const gchar * suffix, gint bits)
+{
+  const gint width = 6, height = 2;
+  GstBuffer *outbuf;
+  GstMapInfo map;
+  guint samples[6 * 2];
+  gint x, y;
+
+  for (x = 0; x < width * height; x++)
+    samples[x] = ((x * 0x2d5) ^ (x << (bits - 4))) & ((1 << bits) - 1);
+
+  outbuf = convert ("bilinear", 1, "bggr", suffix, width, height, samples,
+      "RGBA64_LE");
+
+  gst_buffer_map (outbuf, &map, GST_MAP_READ);
+  for (y = 0; y < height; y++) {
+    for (x = 0; x < width; x++) {
+      /* blue on even rows and columns, red on odd ones, green elsewhere */
+      guint c = x % 2 == y % 2 ? (y % 2 ? 0 : 2) : 1;
+      guint value = GST_READ_UINT16_LE (map.data + (y * width + x) * 8 +
+          2 * c);
+      guint expected = scale (samples[y * width + x], bits, 2);
+
+      if (value != expected)
+        fail ("bggr%s: sample %d,%d is %04x, expected %04x", suffix, x, y,
+            value, expected);
+    }
+  }
+  gst_buffer_unmap (outbuf, &map);
+  gst_buffer_unref (outbuf);
+}
+
+GST_START_TEST (test_packed_bit_placement)
+{
+  check_packed ("10p", 10);
+  check_packed ("12p", 12);
+}
+
+GST_END_TEST;
+
+static Suite *
+bayer2rgb_suite (void)
+{
+  Suite *s = suite_create ("bayer2rgb");
+  TCase *tc_chain = tcase_create ("general");
+
+  suite_add_tcase (s, tc_chain);
+  tcase_add_test (tc_chain, test_depths_bilinear);
+  tcase_add_test (tc_chain, test_depths_malvar_he_cutler);
+  tcase_add_test (tc_chain, test_depths_threads);
+  tcase_add_test (tc_chain, test_pattern_bilinear);
+  tcase_add_test (tc_chain, test_pattern_malvar_he_cutler);
+  tcase_add_test (tc_chain, test_pattern_threads);
+  tcase_add_test (tc_chain, test_packed_bit_placement);
+
+  return s;
+}
+
+GST_CHECK_MAIN (bayer2rgb);
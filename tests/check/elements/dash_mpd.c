@@ -5174,6 +5174,243 @@ GST_START_TEST (dash_mpdparser_segment_timeline)
 
 GST_END_TEST;
 
+/*
+ * Test that S elements continuing each other with the same duration are
+ * stored as one repeated segment, and that seeking finds the right
+ * repetition
+ *
+ */
+GST_START_TEST (dash_mpdparser_segment_timeline_runs)
+{
+  GList *adaptationSets;
+  GstMPDAdaptationSetNode *adapt_set;
+  GstActiveStream *activeStream;
+  GstMediaFragmentInfo fragment;
+  GstMediaSegment *segment;
+  GstClockTime ts;
+
+  const gchar *xml =
+      "<?xml version=\"1.0\"?>"
+      "<MPD xmlns=\"urn:mpeg:dash:schema:mpd:2011\""
+      "     profiles=\"urn:mpeg:dash:profile:isoff-main:2011\""
+      "     mediaPresentationDuration=\"P0Y0M0DT0H0M11S\">"
+      "  <Period>"
+      "    <AdaptationSet mimeType=\"video/mp4\">"
+      "      <Representation id=\"1\" bandwidth=\"250000\">"
+      "        <SegmentTemplate media=\"$Number$.mp4\" startNumber=\"1\">"
+      "          <SegmentTimeline>"
+      "            <S t=\"0\" d=\"2\"></S>"
+      "            <S d=\"2\"></S>"
+      "            <S t=\"4\" d=\"2\"></S>"
+      "            <S d=\"3\"></S>"
+      "            <S d=\"2\"></S>"
+      "          </SegmentTimeline>"
+      "        </SegmentTemplate>"
+      "      </Representation></AdaptationSet></Period></MPD>";
+
+  gboolean ret;
+  GstMPDClient *mpdclient = gst_mpd_client_new ();
+
+  ret = gst_mpd_client_parse (mpdclient, xml, (gint) strlen (xml));
+  assert_equals_int (ret, TRUE);
+
+  /* process the xml data */
+  ret =
+      gst_mpd_client_setup_media_presentation (mpdclient, GST_CLOCK_TIME_NONE,
+      -1, NULL);
+  assert_equals_int (ret, TRUE);
+
+  /* get the list of adaptation sets of the first period */
+  adaptationSets = gst_mpd_client_get_adaptation_sets (mpdclient);
+  fail_if (adaptationSets == NULL);
+
+  /* setup streaming from the first adaptation set */
+  adapt_set = (GstMPDAdaptationSetNode *) g_list_nth_data (adaptationSets, 0);
+  fail_if (adapt_set == NULL);
+  ret = gst_mpd_client_setup_streaming (mpdclient, adapt_set);
+  assert_equals_int (ret, TRUE);
+
+  activeStream = gst_mpd_client_get_active_stream_by_index (mpdclient, 0);
+  fail_if (activeStream == NULL);
+
+  /* The first 3 S elements are one run */
+  assert_equals_int (activeStream->segments->len, 3);
+  segment = g_ptr_array_index (activeStream->segments, 0);
+  assert_equals_int (segment->number, 1);
+  assert_equals_int (segment->repeat, 2);
+  segment = g_ptr_array_index (activeStream->segments, 1);
+  assert_equals_int (segment->number, 4);
+  assert_equals_uint64 (segment->start, 6 * GST_SECOND);
+  segment = g_ptr_array_index (activeStream->segments, 2);
+  assert_equals_int (segment->number, 5);
+  assert_equals_uint64 (segment->start, 9 * GST_SECOND);
+
+  /* Seek into the last repetition of the run */
+  ret = gst_mpd_client_stream_seek (mpdclient, activeStream, TRUE, 0,
+      5 * GST_SECOND, &ts);
+  assert_equals_int (ret, TRUE);
+  assert_equals_uint64 (ts, 4 * GST_SECOND);
+  ret = gst_mpd_client_get_next_fragment (mpdclient, 0, &fragment);
+  assert_equals_int (ret, TRUE);
+  assert_equals_string (fragment.uri, "/3.mp4");
+  assert_equals_uint64 (fragment.timestamp, 4 * GST_SECOND);
+  gst_mpdparser_media_fragment_info_clear (&fragment);
+
+  /* Snapping after the middle of the last repetition of the run moves to
+   * the next S element */
+  ret = gst_mpd_client_stream_seek (mpdclient, activeStream, TRUE,
+      GST_SEEK_FLAG_SNAP_AFTER, 5 * GST_SECOND, &ts);
+  assert_equals_int (ret, TRUE);
+  assert_equals_uint64 (ts, 6 * GST_SECOND);
+
+  /* Snapping after inside the run stays in it */
+  ret = gst_mpd_client_stream_seek (mpdclient, activeStream, TRUE,
+      GST_SEEK_FLAG_SNAP_AFTER, 3 * GST_SECOND, &ts);
+  assert_equals_int (ret, TRUE);
+  assert_equals_uint64 (ts, 4 * GST_SECOND);
+
+  ret = gst_mpd_client_stream_seek (mpdclient, activeStream, TRUE, 0,
+      10 * GST_SECOND, &ts);
+  assert_equals_int (ret, TRUE);
+  assert_equals_uint64 (ts, 9 * GST_SECOND);
+  ret = gst_mpd_client_get_next_fragment (mpdclient, 0, &fragment);
+  assert_equals_int (ret, TRUE);
+  assert_equals_string (fragment.uri, "/5.mp4");
+  gst_mpdparser_media_fragment_info_clear (&fragment);
+
+  /* After the end */
+  ret = gst_mpd_client_stream_seek (mpdclient, activeStream, TRUE, 0,
+      12 * GST_SECOND, &ts);
+  assert_equals_int (ret, FALSE);
+
+  gst_mpd_client_free (mpdclient);
+}
+
+GST_END_TEST;
+
+/*
+ * Test that refreshing a live MPD whose SegmentTimeline got new S elements
+ * keeps the segments of the previous version and only adds the new ones
+ *
+ */
+static GstMPDClient *
+setup_live_mpd_client (guint start_number, const gchar * timeline,
+    GstMPDClient * previous)
+{
+  GList *adaptationSets;
+  GstMPDAdaptationSetNode *adapt_set;
+  gboolean ret;
+  GstMPDClient *mpdclient = gst_mpd_client_new ();
+  gchar *xml = g_strdup_printf ("<?xml version=\"1.0\"?>"
+      "<MPD xmlns=\"urn:mpeg:dash:schema:mpd:2011\""
+      "     type=\"dynamic\""
+      "     profiles=\"urn:mpeg:dash:profile:isoff-live:2011\""
+      "     availabilityStartTime=\"2015-03-24T0:0:0\">"
+      "  <Period id=\"Period0\" start=\"P0Y0M0DT0H0M0S\">"
+      "    <AdaptationSet mimeType=\"video/mp4\">"
+      "      <Representation id=\"1\" bandwidth=\"250000\">"
+      "        <SegmentTemplate media=\"$Number$.mp4\" startNumber=\"%u\">"
+      "          <SegmentTimeline>%s</SegmentTimeline>"
+      "        </SegmentTemplate>"
+      "      </Representation></AdaptationSet></Period></MPD>",
+      start_number, timeline);
+
+  ret = gst_mpd_client_parse (mpdclient, xml, (gint) strlen (xml));
+  assert_equals_int (ret, TRUE);
+  g_free (xml);
+
+  ret =
+      gst_mpd_client_setup_media_presentation (mpdclient, GST_CLOCK_TIME_NONE,
+      -1, NULL);
+  assert_equals_int (ret, TRUE);
+
+  adaptationSets = gst_mpd_client_get_adaptation_sets (mpdclient);
+  fail_if (adaptationSets == NULL);
+  adapt_set = (GstMPDAdaptationSetNode *) g_list_nth_data (adaptationSets, 0);
+  fail_if (adapt_set == NULL);
+
+  mpdclient->previous = previous;
+  ret = gst_mpd_client_setup_streaming (mpdclient, adapt_set);
+  assert_equals_int (ret, TRUE);
+  mpdclient->previous = NULL;
+
+  return mpdclient;
+}
+
+GST_START_TEST (dash_mpdparser_segment_timeline_update)
+{
+  GstActiveStream *activeStream;
+  GstMediaSegment *segments[2];
+  GstMediaSegment *segment;
+  GstMPDClient *mpdclient, *updated;
+
+  mpdclient = setup_live_mpd_client (10,
+      "<S t=\"100\" d=\"2\" r=\"2\"></S><S d=\"3\"></S>", NULL);
+  activeStream = gst_mpd_client_get_active_stream_by_index (mpdclient, 0);
+  fail_if (activeStream == NULL);
+  assert_equals_int (activeStream->segments->len, 2);
+  segments[0] = g_ptr_array_index (activeStream->segments, 0);
+  segments[1] = g_ptr_array_index (activeStream->segments, 1);
+
+  /* An S element was appended: the known segments are kept as they are */
+  updated = setup_live_mpd_client (10,
+      "<S t=\"100\" d=\"2\" r=\"2\"></S><S d=\"3\"></S>"
+      "<S d=\"2\" r=\"1\"></S>", mpdclient);
+  activeStream = gst_mpd_client_get_active_stream_by_index (updated, 0);
+  fail_if (activeStream == NULL);
+  assert_equals_int (activeStream->segments->len, 3);
+  fail_unless (g_ptr_array_index (activeStream->segments, 0) == segments[0]);
+  fail_unless (g_ptr_array_index (activeStream->segments, 1) == segments[1]);
+  segment = g_ptr_array_index (activeStream->segments, 2);
+  assert_equals_int (segment->number, 14);
+  assert_equals_int (segment->repeat, 1);
+  assert_equals_uint64 (segment->scale_start, 109);
+  assert_equals_uint64 (segment->start, 109 * GST_SECOND);
+  gst_mpd_client_free (updated);
+
+  /* The window slid and the last S element got repeated: the segments
+   * that changed are copied, the previous version keeps its own */
+  updated = setup_live_mpd_client (11,
+      "<S t=\"102\" d=\"2\" r=\"1\"></S><S d=\"3\" r=\"1\"></S>", mpdclient);
+  activeStream = gst_mpd_client_get_active_stream_by_index (updated, 0);
+  fail_if (activeStream == NULL);
+  assert_equals_int (activeStream->segments->len, 2);
+  segment = g_ptr_array_index (activeStream->segments, 0);
+  fail_if (segment == segments[0]);
+  assert_equals_int (segment->number, 11);
+  assert_equals_int (segment->repeat, 1);
+  assert_equals_uint64 (segment->scale_start, 102);
+  assert_equals_uint64 (segment->start, 102 * GST_SECOND);
+  segment = g_ptr_array_index (activeStream->segments, 1);
+  fail_if (segment == segments[1]);
+  assert_equals_int (segment->number, 13);
+  assert_equals_int (segment->repeat, 1);
+  assert_equals_int (segments[0]->number, 10);
+  assert_equals_int (segments[0]->repeat, 2);
+  assert_equals_int (segments[1]->repeat, 0);
+  gst_mpd_client_free (updated);
+
+  /* The segments were renumbered: the list is built again */
+  updated = setup_live_mpd_client (20,
+      "<S t=\"100\" d=\"2\" r=\"2\"></S><S d=\"3\"></S>"
+      "<S d=\"2\" r=\"1\"></S>", mpdclient);
+  activeStream = gst_mpd_client_get_active_stream_by_index (updated, 0);
+  fail_if (activeStream == NULL);
+  assert_equals_int (activeStream->segments->len, 3);
+  segment = g_ptr_array_index (activeStream->segments, 0);
+  fail_if (segment == segments[0]);
+  assert_equals_int (segment->number, 20);
+
+  /* The updated list outlives the previous version */
+  gst_mpd_client_free (mpdclient);
+  segment = g_ptr_array_index (activeStream->segments, 2);
+  assert_equals_int (segment->number, 24);
+  assert_equals_uint64 (segment->start, 109 * GST_SECOND);
+  gst_mpd_client_free (updated);
+}
+
+GST_END_TEST;
+
 /*
  * Test SegmentList with multiple inherited segmentURLs
  *
@@ -6693,6 +6930,8 @@ dash_suite (void)
   tcase_add_test (tc_complexMPD, dash_mpdparser_segment_list);
   tcase_add_test (tc_complexMPD, dash_mpdparser_segment_template);
   tcase_add_test (tc_complexMPD, dash_mpdparser_segment_timeline);
+  tcase_add_test (tc_complexMPD, dash_mpdparser_segment_timeline_runs);
+  tcase_add_test (tc_complexMPD, dash_mpdparser_segment_timeline_update);
   tcase_add_test (tc_complexMPD, dash_mpdparser_multiple_inherited_segmentURL);
 
   /* tests checking the parsing of missing/incomplete attributes of xml */
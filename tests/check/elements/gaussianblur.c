@@ -0,0 +1,312 @@
+/* GStreamer
+ *
+ * unit test for gaussianblur
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin St, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#include <gst/check/gstcheck.h>
+#include <gst/check/gstharness.h>
+#include <gst/video/video.h>
+
+#include <math.h>
+
+#define WIDTH 72
+#define HEIGHT 46
+/* coefficients of the gaussian kernels are in 1/4096 */
+#define COEF_BITS 12
+
+static const GstVideoFormat formats[] = {
+  GST_VIDEO_FORMAT_AYUV, GST_VIDEO_FORMAT_I420, GST_VIDEO_FORMAT_YV12,
+  GST_VIDEO_FORMAT_Y41B, GST_VIDEO_FORMAT_Y42B, GST_VIDEO_FORMAT_Y444,
+  GST_VIDEO_FORMAT_NV12, GST_VIDEO_FORMAT_NV21, GST_VIDEO_FORMAT_GRAY8,
+};
+
+typedef struct
+{
+  gint radius;
+  gdouble *weights;
+} Kernel;
+
+/* The gaussian kernel quantised the same way as the element, the reference
+ * then only differs in how it rounds */
+static void
+gaussian_kernel (Kernel * k, gfloat sigma)
+{
+  const gfloat fe = -0.5 / (sigma * sigma);
+  const gfloat dx = 1.0 / (sigma * sqrt (2 * G_PI));
+  gint i, isum = 0, size;
+  gint16 *coef;
+  gfloat sum, *fkernel;
+
+  k->radius = ceil (2.5 * fabs (sigma));
+  size = 2 * k->radius + 1;
+  k->weights = g_new (gdouble, size);
+  if (size == 1) {
+    k->weights[0] = 1.0;
+    return;
+  }
+
+  fkernel = g_new (gfloat, size);
+  coef = g_new (gint16, size);
+  sum = fkernel[k->radius] = dx;
+  for (i = 1; i <= k->radius; i++) {
+    gfloat fx = dx * pow (G_E, fe * i * i);
+
+    fkernel[k->radius + i] = fkernel[k->radius - i] = fx;
+    sum += 2 * fx;
+  }
+
+  for (i = 0; i < size; i++) {
+    coef[i] = (gint16) floor (fkernel[i] / sum * (1 << COEF_BITS) + 0.5);
+    isum += coef[i];
+  }
+  coef[k->radius] += (1 << COEF_BITS) - isum;
+
+  for (i = 0; i < size; i++)
+    k->weights[i] = coef[i] / (gdouble) (1 << COEF_BITS);
+
+  g_free (coef);
+  g_free (fkernel);
+}
+
+/* The radii of the three box blurs approximating the gaussian */
+static void
+box_radii (gint radii[3], gfloat sigma)
+{
+  gdouble w_ideal = sqrt (4.0 * sigma * sigma + 1.0);
+  gint wl, wu, m, i;
+
+  wl = (gint) floor (w_ideal);
+  if (wl % 2 == 0)
+    wl--;
+  wu = wl + 2;
+  m = (gint) floor ((12.0 * sigma * sigma - 3 * wl * wl - 12 * wl - 9) /
+      (-4.0 * wl - 4) + 0.5);
+
+  for (i = 0; i < 3; i++)
+    radii[i] = ((i < m ? wl : wu) - 1) / 2;
+}
+
+/* Filters the @count values @step apart starting at @v, the values past the
+ * ends repeat the end values */
+static void
+filter_line (gdouble * v, gint count, gint step, gboolean box,
+    gfloat sigma)
+{
+  gdouble *in = g_new (gdouble, count);
+  gint i, j, pass;
+
+  if (box) {
+    gint radii[3];
+
+    box_radii (radii, sigma);
+    for (pass = 0; pass < 3; pass++) {
+      for (i = 0; i < count; i++)
+        in[i] = v[i * step];
+      for (i = 0; i < count; i++) {
+        gdouble sum = 0;
+
+        for (j = -radii[pass]; j <= radii[pass]; j++)
+          sum += in[CLAMP (i + j, 0, count - 1)];
+        v[i * step] = sum / (2 * radii[pass] + 1);
+      }
+    }
+  } else {
+    Kernel k;
+
+    gaussian_kernel (&k, sigma);
+    for (i = 0; i < count; i++)
+      in[i] = v[i * step];
+    for (i = 0; i < count; i++) {
+      gdouble sum = 0;
+
+      for (j = -k.radius; j <= k.radius; j++)
+        sum += k.weights[j + k.radius] * in[CLAMP (i + j, 0, count - 1)];
+      v[i * step] = sum;
+    }
+    g_free (k.weights);
+  }
+
+  g_free (in);
+}
+
+static guint8
+pattern (gint plane, gint x, gint y)
+{
+  return (x * 7 + y * 13 + ((x * y) % 17) * 5 + plane * 40) & 0xff;
+}
+
+/* Blurs every plane of @format in double precision and checks that the
+ * element's output is within one level of it everywhere */
+static void
+check_blur (GstVideoFormat format, gint width, gint height, gboolean box,
+    gfloat sigma, guint n_threads)
+{
+  GstHarness *h = gst_harness_new ("gaussianblur");
+  GstVideoInfo info;
+  GstVideoFrame in_frame, out_frame;
+  GstBuffer *inbuf, *outbuf;
+  gchar *caps;
+  gint plane;
+
+  gst_video_info_set_format (&info, format, width, height);
+  caps = g_strdup_printf ("video/x-raw,format=%s,width=%d,height=%d,"
+      "framerate=30/1", gst_video_format_to_string (format), width, height);
+  gst_harness_set_caps_str (h, caps, caps);
+  g_free (caps);
+
+  g_object_set (h->element, "sigma", (gdouble) sigma, "n-threads", n_threads,
+      NULL);
+  gst_util_set_object_arg (G_OBJECT (h->element), "method",
+      box ? "box" : "gaussian");
+
+  inbuf = gst_buffer_new_allocate (NULL, GST_VIDEO_INFO_SIZE (&info), NULL);
+  fail_unless (gst_video_frame_map (&in_frame, &info, inbuf, GST_MAP_WRITE));
+  for (plane = 0; plane < GST_VIDEO_INFO_N_PLANES (&info); plane++) {
+    guint8 *data = GST_VIDEO_FRAME_PLANE_DATA (&in_frame, plane);
+    gint stride = GST_VIDEO_FRAME_PLANE_STRIDE (&in_frame, plane);
+    gint comp[GST_VIDEO_MAX_COMPONENTS], x, y, n, ph;
+
+    gst_video_format_info_component (info.finfo, plane, comp);
+    n = GST_VIDEO_FRAME_COMP_WIDTH (&in_frame, comp[0]) *
+        GST_VIDEO_FRAME_COMP_PSTRIDE (&in_frame, comp[0]);
+    ph = GST_VIDEO_FRAME_COMP_HEIGHT (&in_frame, comp[0]);
+    for (y = 0; y < ph; y++) {
+      for (x = 0; x < n; x++)
+        data[y * stride + x] = pattern (plane, x, y);
+    }
+  }
+  gst_video_frame_unmap (&in_frame);
+
+  outbuf = gst_harness_push_and_pull (h, gst_buffer_ref (inbuf));
+  fail_unless (outbuf != NULL);
+
+  fail_unless (gst_video_frame_map (&in_frame, &info, inbuf, GST_MAP_READ));
+  fail_unless (gst_video_frame_map (&out_frame, &info, outbuf, GST_MAP_READ));
+  for (plane = 0; plane < GST_VIDEO_INFO_N_PLANES (&info); plane++) {
+    const guint8 *in = GST_VIDEO_FRAME_PLANE_DATA (&in_frame, plane);
+    const guint8 *out = GST_VIDEO_FRAME_PLANE_DATA (&out_frame, plane);
+    gint in_stride = GST_VIDEO_FRAME_PLANE_STRIDE (&in_frame, plane);
+    gint out_stride = GST_VIDEO_FRAME_PLANE_STRIDE (&out_frame, plane);
+    gint comp[GST_VIDEO_MAX_COMPONENTS], x, y, n, ph, pstride;
+    gfloat sigma_x, sigma_y;
+    gdouble *ref;
+
+    /* the chroma planes are blurred in their own, subsampled, pixels */
+    gst_video_format_info_component (info.finfo, plane, comp);
+    pstride = GST_VIDEO_FRAME_COMP_PSTRIDE (&in_frame, comp[0]);
+    n = GST_VIDEO_FRAME_COMP_WIDTH (&in_frame, comp[0]) * pstride;
+    ph = GST_VIDEO_FRAME_COMP_HEIGHT (&in_frame, comp[0]);
+    sigma_x = sigma / (1 << GST_VIDEO_FORMAT_INFO_W_SUB (info.finfo, comp[0]));
+    sigma_y = sigma / (1 << GST_VIDEO_FORMAT_INFO_H_SUB (info.finfo, comp[0]));
+
+    ref = g_new (gdouble, n * ph);
+    for (y = 0; y < ph; y++) {
+      for (x = 0; x < n; x++)
+        ref[y * n + x] = in[y * in_stride + x];
+    }
+
+    /* neighbouring pixels are pstride samples apart */
+    for (y = 0; y < ph; y++) {
+      for (x = 0; x < pstride; x++)
+        filter_line (ref + y * n + x, n / pstride, pstride, box, sigma_x);
+    }
+    for (x = 0; x < n; x++)
+      filter_line (ref + x, ph, n, box, sigma_y);
+
+    for (y = 0; y < ph; y++) {
+      for (x = 0; x < n; x++) {
+        gdouble expected = CLAMP (ref[y * n + x], 0, 255);
+        guint8 value = out[y * out_stride + x];
+
+        if (fabs (value - expected) > 1.0)
+          fail ("%s %dx%d, %s sigma %.1f, %u threads: plane %d sample %d of "
+              "row %d is %u, expected %.2f", gst_video_format_to_string
+              (format), width, height, box ? "box" : "gaussian", sigma,
+              n_threads, plane, x, y, value, expected);
+      }
+    }
+
+    g_free (ref);
+  }
+  gst_video_frame_unmap (&out_frame);
+  gst_video_frame_unmap (&in_frame);
+
+  gst_buffer_unref (outbuf);
+  gst_buffer_unref (inbuf);
+  gst_harness_teardown (h);
+}
+
+static void
+check_formats (gint width, gint height, gboolean box, gfloat sigma,
+    guint n_threads)
+{
+  guint i;
+
+  for (i = 0; i < G_N_ELEMENTS (formats); i++)
+    check_blur (formats[i], width, height, box, sigma, n_threads);
+}
+
+GST_START_TEST (test_gaussian)
+{
+  check_formats (WIDTH, HEIGHT, FALSE, 1.2, 1);
+  check_formats (WIDTH, HEIGHT, FALSE, 2.5, 1);
+}
+
+GST_END_TEST;
+
+GST_START_TEST (test_box)
+{
+  check_formats (WIDTH, HEIGHT, TRUE, 4.0, 1);
+}
+
+GST_END_TEST;
+
+GST_START_TEST (test_threads)
+{
+  check_formats (WIDTH, HEIGHT, FALSE, 1.2, 3);
+  check_formats (WIDTH, HEIGHT, TRUE, 4.0, 3);
+  check_formats (WIDTH, HEIGHT, FALSE, 1.2, 0);
+}
+
+GST_END_TEST;
+
+GST_START_TEST (test_more_threads_than_rows)
+{
+  /* The subsampled chroma planes only have two rows */
+  check_formats (WIDTH, 4, FALSE, 1.2, 8);
+  check_formats (WIDTH, 4, TRUE, 4.0, 8);
+}
+
+GST_END_TEST;
+
+static Suite *
+gaussianblur_suite (void)
+{
+  Suite *s = suite_create ("gaussianblur");
+  TCase *tc_chain = tcase_create ("general");
+
+  suite_add_tcase (s, tc_chain);
+  tcase_add_test (tc_chain, test_gaussian);
+  tcase_add_test (tc_chain, test_box);
+  tcase_add_test (tc_chain, test_threads);
+  tcase_add_test (tc_chain, test_more_threads_than_rows);
+
+  return s;
+}
+
+GST_CHECK_MAIN (gaussianblur);
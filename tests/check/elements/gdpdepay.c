@@ -277,6 +277,76 @@ GST_START_TEST (test_audio_in_one_buffer)
 
 GST_END_TEST;
 
+/* buffer payloads are pushed without copying them, and still validated */
+GST_START_TEST (test_payload_not_copied)
+{
+  GstCaps *caps;
+  GstElement *gdpdepay;
+  GstBuffer *buffer, *inbuffer, *outbuffer, *corrupted;
+  GstEvent *event;
+  GstSegment segment;
+  GstMapInfo map, outmap;
+
+  gdpdepay = setup_gdpdepay ();
+
+  fail_unless (gst_element_set_state (gdpdepay,
+          GST_STATE_PLAYING) == GST_STATE_CHANGE_SUCCESS,
+      "could not set to playing");
+
+  caps = gst_caps_new_empty_simple ("application/x-gdp");
+  gst_check_setup_events (mysrcpad, gdpdepay, caps, GST_FORMAT_BYTES);
+  gst_caps_unref (caps);
+
+  event = gst_event_new_stream_start ("s-s-id-1234");
+  inbuffer = gst_dp_payload_event (event, 0);
+  gst_event_unref (event);
+  caps = gst_caps_from_string (AUDIO_CAPS_STRING);
+  inbuffer = gst_buffer_append (inbuffer, gst_dp_payload_caps (caps, 0));
+  gst_caps_unref (caps);
+  gst_segment_init (&segment, GST_FORMAT_TIME);
+  event = gst_event_new_segment (&segment);
+  inbuffer = gst_buffer_append (inbuffer, gst_dp_payload_event (event, 0));
+  gst_event_unref (event);
+  fail_unless (gst_pad_push (mysrcpad, inbuffer) == GST_FLOW_OK);
+
+  buffer = gst_buffer_new_and_alloc (4096);
+  gst_buffer_memset (buffer, 0, 0xa5, 4096);
+  inbuffer = gst_dp_payload_buffer (buffer, GST_DP_HEADER_FLAG_CRC_PAYLOAD);
+  fail_unless (gst_pad_push (mysrcpad, inbuffer) == GST_FLOW_OK);
+
+  fail_unless_equals_int (g_list_length (buffers), 1);
+  outbuffer = (GstBuffer *) buffers->data;
+  buffers = g_list_remove (buffers, outbuffer);
+  fail_unless_equals_int (gst_buffer_get_size (outbuffer), 4096);
+  gst_buffer_map (buffer, &map, GST_MAP_READ);
+  gst_buffer_map (outbuffer, &outmap, GST_MAP_READ);
+  fail_unless (outmap.data == map.data);
+  gst_buffer_unmap (outbuffer, &outmap);
+  gst_buffer_unmap (buffer, &map);
+  gst_buffer_unref (outbuffer);
+
+  /* same header, different payload */
+  outbuffer = gst_dp_payload_buffer (buffer, GST_DP_HEADER_FLAG_CRC_PAYLOAD);
+  inbuffer = gst_buffer_copy_region (outbuffer, GST_BUFFER_COPY_MEMORY, 0,
+      GST_DP_HEADER_LENGTH);
+  gst_buffer_unref (outbuffer);
+  corrupted = gst_buffer_new_and_alloc (4096);
+  gst_buffer_memset (corrupted, 0, 0x5a, 4096);
+  inbuffer = gst_buffer_append (inbuffer, corrupted);
+  fail_unless (gst_pad_push (mysrcpad, inbuffer) == GST_FLOW_ERROR);
+  fail_unless_equals_int (g_list_length (buffers), 0);
+
+  gst_buffer_unref (buffer);
+
+  fail_unless (gst_element_set_state (gdpdepay,
+          GST_STATE_NULL) == GST_STATE_CHANGE_SUCCESS, "could not set to null");
+
+  ASSERT_OBJECT_REFCOUNT (gdpdepay, "gdpdepay", 1);
+  cleanup_gdpdepay (gdpdepay);
+}
+
+GST_END_TEST;
+
 static GstStaticPadTemplate shsinktemplate = GST_STATIC_PAD_TEMPLATE ("sink",
     GST_PAD_SINK,
     GST_PAD_ALWAYS,
@@ -409,6 +479,7 @@ gdpdepay_suite (void)
   suite_add_tcase (s, tc_chain);
   tcase_add_test (tc_chain, test_audio_per_byte);
   tcase_add_test (tc_chain, test_audio_in_one_buffer);
+  tcase_add_test (tc_chain, test_payload_not_copied);
   tcase_add_test (tc_chain, test_streamheader);
 
   return s;
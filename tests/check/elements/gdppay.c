@@ -555,6 +555,42 @@ GST_START_TEST (test_crc)
 
 GST_END_TEST;
 
+/* the slice-by-8 CRC must match the byte-wise one for any length and
+ * alignment, and over any split of the data in memories */
+GST_START_TEST (test_crc_slices)
+{
+  guint8 data[300];
+  GstBuffer *buffer;
+  guint16 crc, expected;
+  guint i, offset, length;
+
+  for (i = 0; i < sizeof (data); i++)
+    data[i] = g_random_int_range (0, 256);
+
+  for (offset = 0; offset < 8; offset++) {
+    for (length = 1; offset + length <= sizeof (data); length++) {
+      guint16 crc_register = CRC_INIT;
+
+      for (i = offset; i < offset + length; i++)
+        crc_register = (guint16) ((crc_register << 8) ^
+            gst_dp_crc_table[((crc_register >> 8) & 0x00ff) ^ data[i]]);
+      expected = 0xffff ^ crc_register;
+
+      fail_unless_equals_int (gst_dp_crc (data + offset, length), expected);
+
+      buffer = gst_buffer_new ();
+      for (i = offset; i < offset + length; i += 37)
+        gst_buffer_append_memory (buffer,
+            gst_memory_new_wrapped (GST_MEMORY_FLAG_READONLY, data,
+                sizeof (data), i, MIN (37, offset + length - i), NULL, NULL));
+      fail_unless (gst_dp_crc_from_buffer (buffer, &crc));
+      fail_unless_equals_int (crc, expected);
+      gst_buffer_unref (buffer);
+    }
+  }
+}
+
+GST_END_TEST;
 
 static Suite *
 gdppay_suite (void)
@@ -568,6 +604,7 @@ gdppay_suite (void)
   tcase_add_test (tc_chain, test_first_no_new_segment);
   tcase_add_test (tc_chain, test_streamheader);
   tcase_add_test (tc_chain, test_crc);
+  tcase_add_test (tc_chain, test_crc_slices);
 
   return s;
 }
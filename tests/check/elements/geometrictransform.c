@@ -0,0 +1,356 @@
+/* GStreamer
+ *
+ * unit test for the geometrictransform base class, through rotate
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin St, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#include <gst/check/gstcheck.h>
+#include <gst/check/gstharness.h>
+#include <gst/video/video.h>
+
+#include <math.h>
+#include <string.h>
+
+/* More than one tile of 64x16 in both directions, with partial ones */
+#define WIDTH 80
+#define HEIGHT 60
+#define ANGLE 0.3
+
+static const GstVideoFormat formats[] = {
+  GST_VIDEO_FORMAT_GRAY8, GST_VIDEO_FORMAT_GRAY16_LE,
+  GST_VIDEO_FORMAT_GRAY16_BE, GST_VIDEO_FORMAT_RGB, GST_VIDEO_FORMAT_ARGB,
+  GST_VIDEO_FORMAT_AYUV,
+};
+
+/* The mapping of rotate, computed the same way */
+static void
+rotate_map (gint x, gint y, gdouble * in_x, gdouble * in_y)
+{
+  gdouble cx = 0.5 * WIDTH, cy = 0.5 * HEIGHT;
+  gdouble xo = x - cx, yo = y - cy;
+  gdouble a = atan2 (yo, xo) + ANGLE;
+  gdouble r = sqrt (xo * xo + yo * yo);
+
+  *in_x = r * cos (a) + cx;
+  *in_y = r * sin (a) + cy;
+}
+
+static gdouble
+mod_float (gdouble a, gdouble b)
+{
+  gint n = (gint) (a / b);
+
+  a -= n * b;
+  if (a < 0)
+    return a + b;
+  return a;
+}
+
+/* Applies the off-edge policy, returns FALSE if the pixel is black */
+static gboolean
+apply_off_edge (const gchar * off_edge, gdouble * x, gdouble * y)
+{
+  if (!strcmp (off_edge, "clamp")) {
+    *x = CLAMP (*x, 0, WIDTH - 1);
+    *y = CLAMP (*y, 0, HEIGHT - 1);
+  } else if (!strcmp (off_edge, "wrap")) {
+    *x = mod_float (*x, WIDTH);
+    *y = mod_float (*y, HEIGHT);
+    if (*x < 0)
+      *x += WIDTH;
+    if (*y < 0)
+      *y += HEIGHT;
+  }
+
+  /* the positions are truncated */
+  return *x > -1.0 && *x < WIDTH && *y > -1.0 && *y < HEIGHT;
+}
+
+/* Component @c of the pixel at @p, the 16 bit formats have one component
+ * and the others one per byte */
+static guint
+read_comp (GstVideoFormat format, const guint8 * p, gint c)
+{
+  switch (format) {
+    case GST_VIDEO_FORMAT_GRAY16_LE:
+      return GST_READ_UINT16_LE (p);
+    case GST_VIDEO_FORMAT_GRAY16_BE:
+      return GST_READ_UINT16_BE (p);
+    default:
+      return p[c];
+  }
+}
+
+static GstBuffer *
+input_new (GstVideoInfo * info)
+{
+  GstBuffer *buf = gst_buffer_new_allocate (NULL, info->size, NULL);
+  GstMapInfo map;
+  gsize i;
+
+  fail_unless (gst_buffer_map (buf, &map, GST_MAP_WRITE));
+  for (i = 0; i < map.size; i++) {
+    gint x = i % info->stride[0], y = i / info->stride[0];
+
+    map.data[i] = (x * 7 + y * 13 + ((x * y) % 17) * 5) & 0xff;
+  }
+  gst_buffer_unmap (buf, &map);
+
+  return buf;
+}
+
+static GstBuffer *
+transform (GstBuffer * inbuf, GstVideoInfo * info, const gchar * off_edge,
+    const gchar * interpolation, guint n_threads)
+{
+  GstHarness *h = gst_harness_new ("rotate");
+  GstBuffer *outbuf;
+  gchar *caps;
+
+  caps = g_strdup_printf ("video/x-raw,format=%s,width=%d,height=%d,"
+      "framerate=30/1",
+      gst_video_format_to_string (GST_VIDEO_INFO_FORMAT (info)), WIDTH,
+      HEIGHT);
+  gst_harness_set_caps_str (h, caps, caps);
+  g_free (caps);
+
+  g_object_set (h->element, "angle", ANGLE, "n-threads", n_threads, NULL);
+  gst_util_set_object_arg (G_OBJECT (h->element), "off-edge-pixels", off_edge);
+  gst_util_set_object_arg (G_OBJECT (h->element), "interpolation",
+      interpolation);
+
+  outbuf = gst_harness_push_and_pull (h, gst_buffer_ref (inbuf));
+  fail_unless (outbuf != NULL);
+  gst_harness_teardown (h);
+
+  return outbuf;
+}
+
+/* Checks each output pixel against the input pixel its position truncates
+ * to, which is what the element always did */
+static void
+check_nearest (GstVideoFormat format, const gchar * off_edge)
+{
+  GstVideoInfo info;
+  GstBuffer *inbuf, *outbuf;
+  GstMapInfo in, out;
+  guint8 black[4] = { 0, };
+  gint x, y, pstride;
+
+  gst_video_info_set_format (&info, format, WIDTH, HEIGHT);
+  pstride = GST_VIDEO_INFO_COMP_PSTRIDE (&info, 0);
+  if (format == GST_VIDEO_FORMAT_AYUV)
+    GST_WRITE_UINT32_BE (black, 0xff108080);
+
+  inbuf = input_new (&info);
+  outbuf = transform (inbuf, &info, off_edge, "nearest", 1);
+
+  fail_unless (gst_buffer_map (inbuf, &in, GST_MAP_READ));
+  fail_unless (gst_buffer_map (outbuf, &out, GST_MAP_READ));
+  for (y = 0; y < HEIGHT; y++) {
+    for (x = 0; x < WIDTH; x++) {
+      const guint8 *o = out.data + y * info.stride[0] + x * pstride;
+      const guint8 *expected = black;
+      gdouble in_x, in_y;
+
+      rotate_map (x, y, &in_x, &in_y);
+      if (apply_off_edge (off_edge, &in_x, &in_y))
+        expected = in.data + (gint) in_y * info.stride[0] + (gint) in_x *
+            pstride;
+
+      if (memcmp (o, expected, pstride))
+        fail ("%s, %s: pixel %d,%d differs", gst_video_format_to_string
+            (format), off_edge, x, y);
+    }
+  }
+  gst_buffer_unmap (outbuf, &out);
+  gst_buffer_unmap (inbuf, &in);
+
+  gst_buffer_unref (outbuf);
+  gst_buffer_unref (inbuf);
+}
+
+/* Checks each output pixel against the bilinear interpolation of the input
+ * in double precision, with the weights quantised to 1/256 like the map
+ * stores them */
+static void
+check_bilinear (GstVideoFormat format, const gchar * off_edge)
+{
+  GstVideoInfo info;
+  GstBuffer *inbuf, *outbuf;
+  GstMapInfo in, out;
+  guint8 black[4] = { 0, };
+  gint x, y, c, pstride, ncomps;
+
+  gst_video_info_set_format (&info, format, WIDTH, HEIGHT);
+  pstride = GST_VIDEO_INFO_COMP_PSTRIDE (&info, 0);
+  ncomps = GST_VIDEO_FORMAT_INFO_BITS (info.finfo) > 8 ? 1 : pstride;
+  if (format == GST_VIDEO_FORMAT_AYUV)
+    GST_WRITE_UINT32_BE (black, 0xff108080);
+
+  inbuf = input_new (&info);
+  outbuf = transform (inbuf, &info, off_edge, "bilinear", 1);
+
+  fail_unless (gst_buffer_map (inbuf, &in, GST_MAP_READ));
+  fail_unless (gst_buffer_map (outbuf, &out, GST_MAP_READ));
+  for (y = 0; y < HEIGHT; y++) {
+    for (x = 0; x < WIDTH; x++) {
+      const guint8 *o = out.data + y * info.stride[0] + x * pstride;
+      const guint8 *s00, *s01, *s10, *s11;
+      gdouble in_x, in_y, fl_x, fl_y;
+      gint ix, iy, fx, fy;
+
+      rotate_map (x, y, &in_x, &in_y);
+      if (!apply_off_edge (off_edge, &in_x, &in_y)) {
+        if (memcmp (o, black, pstride))
+          fail ("%s, %s: pixel %d,%d is not black",
+              gst_video_format_to_string (format), off_edge, x, y);
+        continue;
+      }
+
+      in_x = CLAMP (in_x, 0, WIDTH - 1);
+      in_y = CLAMP (in_y, 0, HEIGHT - 1);
+      fl_x = floor (in_x);
+      fl_y = floor (in_y);
+      ix = (gint) fl_x;
+      iy = (gint) fl_y;
+      fx = (gint) ((in_x - fl_x) * 256 + 0.5);
+      fy = (gint) ((in_y - fl_y) * 256 + 0.5);
+      if (fx == 256) {
+        ix++;
+        fx = 0;
+      }
+      if (fy == 256) {
+        iy++;
+        fy = 0;
+      }
+
+      s00 = in.data + iy * info.stride[0] + ix * pstride;
+      s01 = s00 + (fx ? pstride : 0);
+      s10 = s00 + (fy ? info.stride[0] : 0);
+      s11 = s10 + (fx ? pstride : 0);
+
+      for (c = 0; c < ncomps; c++) {
+        gdouble top, bottom, expected;
+        guint value = read_comp (format, o, c);
+
+        top = read_comp (format, s00, c) * (256 - fx) +
+            read_comp (format, s01, c) * fx;
+        bottom = read_comp (format, s10, c) * (256 - fx) +
+            read_comp (format, s11, c) * fx;
+        expected = (top * (256 - fy) + bottom * fy) / 65536.0;
+
+        /* the 4 byte formats round after each direction */
+        if (fabs (value - expected) > 1.0)
+          fail ("%s, %s: component %d of pixel %d,%d is %u, expected %.2f",
+              gst_video_format_to_string (format), off_edge, c, x, y, value,
+              expected);
+      }
+    }
+  }
+  gst_buffer_unmap (outbuf, &out);
+  gst_buffer_unmap (inbuf, &in);
+
+  gst_buffer_unref (outbuf);
+  gst_buffer_unref (inbuf);
+}
+
+/* The slices rendered by the pool threads give the same output as a single
+ * thread */
+static void
+check_threads (GstVideoFormat format, const gchar * interpolation,
+    guint n_threads)
+{
+  GstVideoInfo info;
+  GstBuffer *inbuf, *single, *threaded;
+  GstMapInfo a, b;
+
+  gst_video_info_set_format (&info, format, WIDTH, HEIGHT);
+  inbuf = input_new (&info);
+  single = transform (inbuf, &info, "ignore", interpolation, 1);
+  threaded = transform (inbuf, &info, "ignore", interpolation, n_threads);
+
+  fail_unless (gst_buffer_map (single, &a, GST_MAP_READ));
+  fail_unless (gst_buffer_map (threaded, &b, GST_MAP_READ));
+  fail_unless_equals_int (a.size, b.size);
+  if (memcmp (a.data, b.data, a.size))
+    fail ("%s, %s: %u threads differ from one", gst_video_format_to_string
+        (format), interpolation, n_threads);
+  gst_buffer_unmap (threaded, &b);
+  gst_buffer_unmap (single, &a);
+
+  gst_buffer_unref (threaded);
+  gst_buffer_unref (single);
+  gst_buffer_unref (inbuf);
+}
+
+GST_START_TEST (test_nearest)
+{
+  guint i;
+
+  for (i = 0; i < G_N_ELEMENTS (formats); i++) {
+    check_nearest (formats[i], "ignore");
+    check_nearest (formats[i], "clamp");
+    check_nearest (formats[i], "wrap");
+  }
+}
+
+GST_END_TEST;
+
+GST_START_TEST (test_bilinear)
+{
+  guint i;
+
+  for (i = 0; i < G_N_ELEMENTS (formats); i++) {
+    check_bilinear (formats[i], "ignore");
+    check_bilinear (formats[i], "clamp");
+    check_bilinear (formats[i], "wrap");
+  }
+}
+
+GST_END_TEST;
+
+GST_START_TEST (test_threads)
+{
+  guint i;
+
+  for (i = 0; i < G_N_ELEMENTS (formats); i++) {
+    check_threads (formats[i], "nearest", 3);
+    check_threads (formats[i], "bilinear", 3);
+    check_threads (formats[i], "bilinear", 0);
+    /* More threads than rows of tiles */
+    check_threads (formats[i], "bilinear", 8);
+  }
+}
+
+GST_END_TEST;
+
+static Suite *
+geometrictransform_suite (void)
+{
+  Suite *s = suite_create ("geometrictransform");
+  TCase *tc_chain = tcase_create ("general");
+
+  suite_add_tcase (s, tc_chain);
+  tcase_add_test (tc_chain, test_nearest);
+  tcase_add_test (tc_chain, test_bilinear);
+  tcase_add_test (tc_chain, test_threads);
+
+  return s;
+}
+
+GST_CHECK_MAIN (geometrictransform);
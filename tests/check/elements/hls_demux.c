@@ -141,6 +141,8 @@ append_request_uri (GQuark field_id, GValue * value, gpointer user_data)
   return TRUE;
 }
 
+static GMutex requests_lock;
+
 static void
 gst_hlsdemux_test_set_input_data (const GstHlsDemuxTestCase * test_case,
     const GstHlsDemuxTestInputData * input, GstTestHTTPSrcInput * output)
@@ -158,6 +160,8 @@ gst_hlsdemux_test_set_input_data (const GstHlsDemuxTestCase * test_case,
     output->response_headers = gst_structure_new ("response-headers",
         "Content-Type", G_TYPE_STRING, "video/mp2t", NULL);
   }
+  /* fragments can be requested from several threads when prefetching */
+  g_mutex_lock (&requests_lock);
   if (gst_structure_has_field (test_case->state, "requests")) {
     GstHlsDemuxTestAppendUriContext context =
         { g_quark_from_string ("requests"), input->uri };
@@ -174,6 +178,7 @@ gst_hlsdemux_test_set_input_data (const GstHlsDemuxTestCase * test_case,
     g_value_unset (&uri_val);
     g_value_unset (&requests);
   }
+  g_mutex_unlock (&requests_lock);
 }
 
 static gboolean
@@ -348,6 +353,74 @@ GST_START_TEST (testMasterPlaylist)
 
 GST_END_TEST;
 
+static void
+testPrefetchPreTestCallback (GstAdaptiveDemuxTestEngine * engine,
+    gpointer user_data)
+{
+  g_object_set (engine->demux, "prefetch-fragments", 2, NULL);
+}
+
+/*
+ * Test that prefetching upcoming fragments neither loses nor duplicates
+ * any of them
+ *
+ */
+GST_START_TEST (testPrefetch)
+{
+  const guint segment_size = 30 * TS_PACKET_LEN;
+  const gchar *manifest =
+      "#EXTM3U \n"
+      "#EXT-X-TARGETDURATION:1\n"
+      "#EXTINF:1,Test\n" "001.ts\n"
+      "#EXTINF:1,Test\n" "002.ts\n"
+      "#EXTINF:1,Test\n" "003.ts\n"
+      "#EXTINF:1,Test\n" "004.ts\n" "#EXT-X-ENDLIST\n";
+  GstHlsDemuxTestInputData inputTestData[] = {
+    {"http://unit.test/media.m3u8", (guint8 *) manifest, 0},
+    {"http://unit.test/001.ts", NULL, segment_size},
+    {"http://unit.test/002.ts", NULL, segment_size},
+    {"http://unit.test/003.ts", NULL, segment_size},
+    {"http://unit.test/004.ts", NULL, segment_size},
+    {NULL, NULL, 0},
+  };
+  GstAdaptiveDemuxTestExpectedOutput outputTestData[] = {
+    {"src_0", 4 * segment_size, NULL},
+    {NULL, 0, NULL}
+  };
+  const GValue *requests;
+  guint i, j;
+  TESTCASE_INIT_BOILERPLATE (segment_size);
+
+  http_src_callbacks.src_start = gst_hlsdemux_test_src_start;
+  http_src_callbacks.src_create = gst_hlsdemux_test_src_create;
+  engine_callbacks.pre_test = testPrefetchPreTestCallback;
+  engine_callbacks.appsink_received_data =
+      gst_adaptive_demux_test_check_received_data;
+  engine_callbacks.appsink_eos =
+      gst_adaptive_demux_test_check_size_of_received_data;
+
+  gst_test_http_src_install_callbacks (&http_src_callbacks, &hlsTestCase);
+  gst_adaptive_demux_test_run (DEMUX_ELEMENT_NAME,
+      inputTestData[0].uri, &engine_callbacks, engineTestData);
+
+  requests = gst_structure_get_value (hlsTestCase.state, "requests");
+  fail_unless (requests != NULL);
+  for (i = 1; inputTestData[i].uri; ++i) {
+    guint count = 0;
+
+    for (j = 0; j < gst_value_array_get_size (requests); ++j) {
+      const GValue *uri = gst_value_array_get_value (requests, j);
+
+      if (strcmp (inputTestData[i].uri, g_value_get_string (uri)) == 0)
+        count++;
+    }
+    assert_equals_uint64 (count, 1);
+  }
+  TESTCASE_UNREF_BOILERPLATE;
+}
+
+GST_END_TEST;
+
 /*
  * Test seeking
  *
@@ -734,6 +807,7 @@ hls_demux_suite (void)
 
   tcase_add_test (tc_basicTest, simpleTest);
   tcase_add_test (tc_basicTest, testMasterPlaylist);
+  tcase_add_test (tc_basicTest, testPrefetch);
   tcase_add_test (tc_basicTest, testMediaPlaylistNotFound);
   tcase_add_test (tc_basicTest, testFragmentNotFound);
   tcase_add_test (tc_basicTest, testFragmentDownloadError);
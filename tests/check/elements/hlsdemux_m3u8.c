@@ -82,6 +82,19 @@ https://priv.example.com/fileSequence3003.ts\n\
 #EXTINF:8,\n\
 https://priv.example.com/fileSequence3004.ts";
 
+static const gchar *LIVE_SLIDING_PLAYLIST = "#EXTM3U\n\
+#EXT-X-TARGETDURATION:8\n\
+#EXT-X-MEDIA-SEQUENCE:2682\n\
+\n\
+#EXTINF:8,\n\
+https://priv.example.com/fileSequence2682.ts\n\
+#EXTINF:8,\n\
+https://priv.example.com/fileSequence2683.ts\n\
+#EXTINF:8,\n\
+https://priv.example.com/fileSequence2684.ts\n\
+#EXTINF:6,\n\
+https://priv.example.com/fileSequence2685.ts";
+
 static const gchar *VARIANT_PLAYLIST = "#EXTM3U \n\
 #EXT-X-STREAM-INF:PROGRAM-ID=1,BANDWIDTH=128000\n\
 http://example.com/low.m3u8\n\
@@ -714,6 +727,65 @@ GST_START_TEST (test_update_playlist)
 
 GST_END_TEST;
 
+GST_START_TEST (test_update_playlist_incremental)
+{
+  GstHLSMasterPlaylist *master;
+  GstM3U8 *pl;
+  GstM3U8MediaFile *file, *file2683;
+  GstClockTime file_start = GST_CLOCK_TIME_NONE;
+  GList *l;
+  gboolean ret;
+
+  master = load_playlist (LIVE_PLAYLIST);
+  pl = master->default_variant->m3u8;
+  assert_equals_int (pl->files_index->len, 4);
+  file2683 = GST_M3U8_MEDIA_FILE (g_list_last (pl->files)->data);
+
+  /* Files that were in the previous version are kept as they are */
+  ret = gst_m3u8_update (pl, g_strdup (LIVE_SLIDING_PLAYLIST));
+  assert_equals_int (ret, TRUE);
+  assert_equals_int (g_list_length (pl->files), 4);
+  assert_equals_int (pl->files_index->len, 4);
+  file = GST_M3U8_MEDIA_FILE (g_list_nth_data (pl->files, 1));
+  fail_unless (file == file2683);
+
+  file = GST_M3U8_MEDIA_FILE (g_list_last (pl->files)->data);
+  assert_equals_string (file->uri,
+      "https://priv.example.com/fileSequence2685.ts");
+  assert_equals_int (file->sequence, 2685);
+  assert_equals_uint64 (file->duration, 6 * GST_SECOND);
+
+  /* Lookup by position */
+  l = gst_m3u8_find_file_by_position (pl, 0, &file_start);
+  assert_equals_int (GST_M3U8_MEDIA_FILE (l->data)->sequence, 2682);
+  assert_equals_uint64 (file_start, 0);
+  l = gst_m3u8_find_file_by_position (pl, 17 * GST_SECOND, &file_start);
+  assert_equals_int (GST_M3U8_MEDIA_FILE (l->data)->sequence, 2684);
+  assert_equals_uint64 (file_start, 16 * GST_SECOND);
+  l = gst_m3u8_find_file_by_position (pl, 300 * GST_SECOND, &file_start);
+  assert_equals_int (GST_M3U8_MEDIA_FILE (l->data)->sequence, 2685);
+  assert_equals_uint64 (file_start, 24 * GST_SECOND);
+
+  /* A different URI for a known sequence number is still an error, even
+   * if it only differs before the relative part, and the new file gets its
+   * title and date */
+  ret = gst_m3u8_update (pl, g_strdup ("#EXTM3U\n"
+          "#EXT-X-TARGETDURATION:8\n"
+          "#EXT-X-MEDIA-SEQUENCE:2682\n"
+          "#EXT-X-PROGRAM-DATE-TIME:2016-07-21T12:00:00Z\n"
+          "#EXTINF:8,Moved\n" "fileSequence2682.ts\n"));
+  assert_equals_int (ret, FALSE);
+  file = GST_M3U8_MEDIA_FILE (pl->files->data);
+  assert_equals_string (file->uri, "http://localhost/fileSequence2682.ts");
+  assert_equals_string (file->title, "Moved");
+  fail_unless (file->program_dt != NULL);
+  assert_equals_int (gst_date_time_get_hour (file->program_dt), 12);
+
+  gst_hls_master_playlist_unref (master);
+}
+
+GST_END_TEST;
+
 GST_START_TEST (test_playlist_media_files)
 {
   GstHLSMasterPlaylist *master;
@@ -1495,6 +1567,7 @@ hlsdemux_suite (void)
   tcase_add_test (tc_m3u8, test_playlist_with_encryption);
   tcase_add_test (tc_m3u8, test_update_invalid_playlist);
   tcase_add_test (tc_m3u8, test_update_playlist);
+  tcase_add_test (tc_m3u8, test_update_playlist_incremental);
   tcase_add_test (tc_m3u8, test_playlist_media_files);
   tcase_add_test (tc_m3u8, test_playlist_byte_range_media_files);
   tcase_add_test (tc_m3u8, test_get_next_fragment);
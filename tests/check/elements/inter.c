@@ -0,0 +1,364 @@
+/* GStreamer
+ *
+ * unit test for the fan-out mode of the inter elements
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin St, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#include <gst/check/gstcheck.h>
+#include <gst/check/gstharness.h>
+
+#define WIDTH 16
+#define HEIGHT 16
+/* Every frame is filled with its marker, black frames are below it */
+#define MARKER 0x80
+#define BLACK -1
+
+#define AUDIO_CAPS \
+    "audio/x-raw,format=S16LE,layout=interleaved,rate=8000,channels=1"
+/* the default period-time of 25ms at 8000Hz */
+#define PERIOD_SAMPLES 200
+#define SILENCE -1
+
+#define TIMEOUT 60
+
+static GstHarness *
+inter_sink_new (const gchar * factory, const gchar * channel, guint depth,
+    GstBus * bus)
+{
+  GstElement *sink = gst_element_factory_make (factory, NULL);
+  GstHarness *h;
+
+  fail_unless (sink != NULL);
+  g_object_set (sink, "channel", channel, "fan-out-depth", depth, "sync",
+      FALSE, "async", FALSE, NULL);
+  if (bus)
+    gst_element_set_bus (sink, bus);
+
+  h = gst_harness_new_with_element (sink, "sink", NULL);
+  gst_object_unref (sink);
+  gst_harness_play (h);
+
+  return h;
+}
+
+static GstHarness *
+inter_src_new (const gchar * factory, const gchar * channel)
+{
+  GstElement *src = gst_element_factory_make (factory, NULL);
+  GstHarness *h;
+
+  fail_unless (src != NULL);
+  g_object_set (src, "channel", channel, NULL);
+
+  h = gst_harness_new_with_element (src, NULL, "src");
+  gst_object_unref (src);
+  gst_harness_use_testclock (h);
+  gst_harness_play (h);
+
+  /* The first buffer is created right away, then waits for the clock */
+  fail_unless (gst_harness_wait_for_clock_id_waits (h, 1, TIMEOUT));
+
+  return h;
+}
+
+static guint64
+get_counter (GstHarness * h, const gchar * name)
+{
+  guint64 value;
+
+  /* Let the source create the buffer it will push next */
+  fail_unless (gst_harness_wait_for_clock_id_waits (h, 1, TIMEOUT));
+  g_object_get (h->element, name, &value, NULL);
+
+  return value;
+}
+
+static void
+set_video_caps (GstHarness * h, gint width)
+{
+  gchar *caps = g_strdup_printf ("video/x-raw,format=GRAY8,width=%d,"
+      "height=%d,framerate=30/1", width, HEIGHT);
+
+  gst_harness_set_src_caps_str (h, caps);
+  g_free (caps);
+}
+
+static void
+push_frame (GstHarness * h, gint width, guint8 marker)
+{
+  GstBuffer *buf = gst_buffer_new_allocate (NULL, width * HEIGHT, NULL);
+
+  gst_buffer_memset (buf, 0, marker, width * HEIGHT);
+  fail_unless_equals_int (gst_harness_push (h, buf), GST_FLOW_OK);
+}
+
+/* Releases the frame the source is waiting to push and checks it */
+static void
+pull_frame (GstHarness * h, gint width, gint marker, gboolean gap)
+{
+  GstBuffer *buf;
+  GstMapInfo map;
+
+  fail_unless (gst_harness_crank_single_clock_wait (h));
+  buf = gst_harness_pull (h);
+  fail_unless (buf != NULL);
+
+  fail_unless (gst_buffer_map (buf, &map, GST_MAP_READ));
+  fail_unless_equals_int (map.size, width * HEIGHT);
+  if (marker == BLACK)
+    fail_unless (map.data[0] < MARKER);
+  else
+    fail_unless_equals_int (map.data[0], marker);
+  gst_buffer_unmap (buf, &map);
+
+  fail_unless_equals_int (!!GST_BUFFER_FLAG_IS_SET (buf,
+          GST_BUFFER_FLAG_GAP), gap);
+  gst_buffer_unref (buf);
+}
+
+static void
+push_samples (GstHarness * h, gint first, gint count)
+{
+  GstBuffer *buf = gst_buffer_new_allocate (NULL, count * 2, NULL);
+  GstMapInfo map;
+  gint i;
+
+  fail_unless (gst_buffer_map (buf, &map, GST_MAP_WRITE));
+  for (i = 0; i < count; i++)
+    GST_WRITE_UINT16_LE (map.data + 2 * i, first + i);
+  gst_buffer_unmap (buf, &map);
+
+  fail_unless_equals_int (gst_harness_push (h, buf), GST_FLOW_OK);
+}
+
+/* Releases the period the source is waiting to push and checks it */
+static void
+pull_period (GstHarness * h, gint first, gboolean gap)
+{
+  GstBuffer *buf;
+  GstMapInfo map;
+  gint i;
+
+  fail_unless (gst_harness_crank_single_clock_wait (h));
+  buf = gst_harness_pull (h);
+  fail_unless (buf != NULL);
+
+  fail_unless (gst_buffer_map (buf, &map, GST_MAP_READ));
+  fail_unless_equals_int (map.size, PERIOD_SAMPLES * 2);
+  for (i = 0; i < PERIOD_SAMPLES; i++) {
+    fail_unless_equals_int (GST_READ_UINT16_LE (map.data + 2 * i),
+        first == SILENCE ? 0 : first + i);
+  }
+  gst_buffer_unmap (buf, &map);
+
+  fail_unless_equals_int (!!GST_BUFFER_FLAG_IS_SET (buf,
+          GST_BUFFER_FLAG_GAP), gap);
+  gst_buffer_unref (buf);
+}
+
+GST_START_TEST (test_video_fan_out)
+{
+  GstHarness *h_sink, *h_src[2];
+  gint i, j;
+
+  h_sink = inter_sink_new ("intervideosink", "video-fan-out", 4, NULL);
+  set_video_caps (h_sink, WIDTH);
+  for (i = 0; i < G_N_ELEMENTS (h_src); i++)
+    h_src[i] = inter_src_new ("intervideosrc", "video-fan-out");
+
+  for (i = 0; i < 4; i++)
+    push_frame (h_sink, WIDTH, MARKER + i);
+
+  /* Each source gets every frame, whatever the other one read */
+  for (i = 0; i < G_N_ELEMENTS (h_src); i++) {
+    pull_frame (h_src[i], WIDTH, BLACK, FALSE);
+    for (j = 0; j < 4; j++)
+      pull_frame (h_src[i], WIDTH, MARKER + j, FALSE);
+    pull_frame (h_src[i], WIDTH, MARKER + 3, TRUE);
+
+    /* The black frame, the repeated frame and the one being created */
+    fail_unless_equals_uint64 (get_counter (h_src[i], "underruns"), 3);
+    fail_unless_equals_uint64 (get_counter (h_src[i], "overruns"), 0);
+  }
+
+  for (i = 0; i < G_N_ELEMENTS (h_src); i++)
+    gst_harness_teardown (h_src[i]);
+  gst_harness_teardown (h_sink);
+}
+
+GST_END_TEST;
+
+GST_START_TEST (test_video_overrun)
+{
+  GstHarness *h_sink, *h_src;
+  gint i;
+
+  h_sink = inter_sink_new ("intervideosink", "video-overrun", 4, NULL);
+  set_video_caps (h_sink, WIDTH);
+  h_src = inter_src_new ("intervideosrc", "video-overrun");
+
+  for (i = 0; i < 10; i++)
+    push_frame (h_sink, WIDTH, MARKER + i);
+
+  /* Only the last 4 frames are still there */
+  pull_frame (h_src, WIDTH, BLACK, FALSE);
+  for (i = 6; i < 10; i++)
+    pull_frame (h_src, WIDTH, MARKER + i, FALSE);
+
+  fail_unless_equals_uint64 (get_counter (h_src, "overruns"), 6);
+  fail_unless_equals_uint64 (get_counter (h_src, "underruns"), 2);
+
+  gst_harness_teardown (h_src);
+  gst_harness_teardown (h_sink);
+}
+
+GST_END_TEST;
+
+GST_START_TEST (test_video_late_src)
+{
+  GstHarness *h_sink, *h_src;
+  gint i;
+
+  h_sink = inter_sink_new ("intervideosink", "video-late-src", 4, NULL);
+  set_video_caps (h_sink, WIDTH);
+  for (i = 0; i < 3; i++)
+    push_frame (h_sink, WIDTH, MARKER + i);
+
+  /* A source joining late starts with the most recent frame */
+  h_src = inter_src_new ("intervideosrc", "video-late-src");
+  pull_frame (h_src, WIDTH, MARKER + 2, FALSE);
+  fail_unless_equals_uint64 (get_counter (h_src, "underruns"), 1);
+  fail_unless_equals_uint64 (get_counter (h_src, "overruns"), 0);
+
+  push_frame (h_sink, WIDTH, MARKER + 3);
+  pull_frame (h_src, WIDTH, MARKER + 2, TRUE);
+  pull_frame (h_src, WIDTH, MARKER + 3, FALSE);
+
+  gst_harness_teardown (h_src);
+  gst_harness_teardown (h_sink);
+}
+
+GST_END_TEST;
+
+GST_START_TEST (test_video_renegotiate)
+{
+  GstHarness *h_sink, *h_src;
+  GstCaps *caps;
+  gint width;
+
+  h_sink = inter_sink_new ("intervideosink", "video-renegotiate", 2, NULL);
+  set_video_caps (h_sink, WIDTH);
+  h_src = inter_src_new ("intervideosrc", "video-renegotiate");
+
+  set_video_caps (h_sink, 2 * WIDTH);
+  push_frame (h_sink, 2 * WIDTH, MARKER);
+
+  pull_frame (h_src, WIDTH, BLACK, FALSE);
+  pull_frame (h_src, 2 * WIDTH, MARKER, FALSE);
+
+  caps = gst_pad_get_current_caps (h_src->sinkpad);
+  fail_unless (caps != NULL);
+  fail_unless (gst_structure_get_int (gst_caps_get_structure (caps, 0),
+          "width", &width));
+  fail_unless_equals_int (width, 2 * WIDTH);
+  gst_caps_unref (caps);
+
+  gst_harness_teardown (h_src);
+  gst_harness_teardown (h_sink);
+}
+
+GST_END_TEST;
+
+GST_START_TEST (test_video_depth_mismatch)
+{
+  GstHarness *h_sink, *h_other;
+  GstBus *bus = gst_bus_new ();
+  GstMessage *msg;
+
+  h_sink = inter_sink_new ("intervideosink", "video-depth-mismatch", 4, NULL);
+
+  /* Later sinks keep the depth of the first one and warn if theirs differs */
+  h_other = inter_sink_new ("intervideosink", "video-depth-mismatch", 2, bus);
+  msg = gst_bus_pop_filtered (bus, GST_MESSAGE_WARNING);
+  fail_unless (msg != NULL);
+  gst_message_unref (msg);
+  gst_harness_teardown (h_other);
+
+  h_other = inter_sink_new ("intervideosink", "video-depth-mismatch", 0, bus);
+  msg = gst_bus_pop_filtered (bus, GST_MESSAGE_WARNING);
+  fail_unless (msg != NULL);
+  gst_message_unref (msg);
+  gst_harness_teardown (h_other);
+
+  h_other = inter_sink_new ("intervideosink", "video-depth-mismatch", 4, bus);
+  fail_unless (gst_bus_pop_filtered (bus, GST_MESSAGE_WARNING) == NULL);
+  gst_harness_teardown (h_other);
+
+  gst_harness_teardown (h_sink);
+  gst_object_unref (bus);
+}
+
+GST_END_TEST;
+
+GST_START_TEST (test_audio_fan_out)
+{
+  GstHarness *h_sink, *h_src[2];
+  gint i;
+
+  h_sink = inter_sink_new ("interaudiosink", "audio-fan-out", 8, NULL);
+  gst_harness_set_src_caps_str (h_sink, AUDIO_CAPS);
+  for (i = 0; i < G_N_ELEMENTS (h_src); i++)
+    h_src[i] = inter_src_new ("interaudiosrc", "audio-fan-out");
+
+  push_samples (h_sink, 0, 2 * PERIOD_SAMPLES);
+
+  /* Each source gets all the samples, whatever the other one read */
+  for (i = 0; i < G_N_ELEMENTS (h_src); i++) {
+    pull_period (h_src[i], SILENCE, TRUE);
+    pull_period (h_src[i], 0, FALSE);
+    pull_period (h_src[i], PERIOD_SAMPLES, FALSE);
+
+    /* The first period and the one being created */
+    fail_unless_equals_uint64 (get_counter (h_src[i], "underruns"), 2);
+    fail_unless_equals_uint64 (get_counter (h_src[i], "overruns"), 0);
+  }
+
+  for (i = 0; i < G_N_ELEMENTS (h_src); i++)
+    gst_harness_teardown (h_src[i]);
+  gst_harness_teardown (h_sink);
+}
+
+GST_END_TEST;
+
+static Suite *
+inter_suite (void)
+{
+  Suite *s = suite_create ("inter");
+  TCase *tc_chain = tcase_create ("general");
+
+  suite_add_tcase (s, tc_chain);
+  tcase_add_test (tc_chain, test_video_fan_out);
+  tcase_add_test (tc_chain, test_video_overrun);
+  tcase_add_test (tc_chain, test_video_late_src);
+  tcase_add_test (tc_chain, test_video_renegotiate);
+  tcase_add_test (tc_chain, test_video_depth_mismatch);
+  tcase_add_test (tc_chain, test_audio_fan_out);
+
+  return s;
+}
+
+GST_CHECK_MAIN (inter);
@@ -18,6 +18,8 @@
  * Boston, MA 02110-1301, USA.
  */
 
+#include <string.h>
+
 #include <gst/gst.h>
 #include <gst/check/gstcheck.h>
 #include <gst/check/gstharness.h>
@@ -335,6 +337,59 @@ GST_START_TEST (test_tsparse_padding)
 
 GST_END_TEST;
 
+GST_START_TEST (test_tsparse_program_queue)
+{
+  GstElement *tsparse;
+  GstHarness *h;
+  GstBuffer *buf;
+  GstStructure *stats, *program;
+  const GValue *programs;
+  GstMapInfo map;
+  guint8 *data;
+  gsize offset = 0;
+  guint64 dropped;
+
+  tsparse = gst_element_factory_make ("tsparse", NULL);
+  g_object_set (tsparse, "program-queue-size", 16, NULL);
+  h = gst_harness_new_with_element (tsparse, "sink", "program_1");
+  gst_object_unref (tsparse);
+
+  gst_harness_set_src_caps_str (h, "video/mpegts,systemstream=true");
+
+  buf =
+      gst_buffer_new_wrapped_full (GST_MEMORY_FLAG_READONLY, (guint8 *) aac_ts,
+      sizeof aac_ts, 0, sizeof aac_ts, NULL, NULL);
+  fail_unless (gst_harness_push (h, buf) == GST_FLOW_OK);
+
+  /* The program pad pushes from its own thread, wait for all the packets */
+  data = g_malloc (sizeof aac_ts);
+  while (offset < sizeof aac_ts) {
+    buf = gst_harness_pull (h);
+    fail_unless (buf != NULL);
+    gst_buffer_map (buf, &map, GST_MAP_READ);
+    fail_unless (offset + map.size <= sizeof aac_ts);
+    memcpy (data + offset, map.data, map.size);
+    offset += map.size;
+    gst_buffer_unmap (buf, &map);
+    gst_buffer_unref (buf);
+  }
+  fail_unless (memcmp (data, aac_ts, sizeof aac_ts) == 0);
+  g_free (data);
+
+  g_object_get (h->element, "stats", &stats, NULL);
+  programs = gst_structure_get_value (stats, "programs");
+  fail_unless_equals_int (gst_value_array_get_size (programs), 1);
+  program = (GstStructure *)
+      gst_value_get_structure (gst_value_array_get_value (programs, 0));
+  fail_unless (gst_structure_get_uint64 (program, "dropped", &dropped));
+  fail_unless_equals_uint64 (dropped, 0);
+  gst_structure_free (stats);
+
+  gst_harness_teardown (h);
+}
+
+GST_END_TEST;
+
 static void
 tsdemux_simple_pad_added (GstElement * tsdemux, GstPad * pad, GstHarness * h)
 {
@@ -377,6 +432,336 @@ GST_START_TEST (test_tsdemux_simple)
 
 GST_END_TEST;
 
+GST_START_TEST (test_tsdemux_unaligned_input)
+{
+  GstHarness *h = gst_harness_new_with_padnames ("tsdemux", "sink", NULL);
+  GstBuffer *buf;
+  GstCaps *caps;
+  GstSegment segment;
+  gsize i, chunk;
+
+  caps = gst_caps_from_string ("video/mpegts,systemstream=true");
+  gst_harness_push_event (h, gst_event_new_caps (caps));
+  gst_caps_unref (caps);
+
+  gst_segment_init (&segment, GST_FORMAT_BYTES);
+  gst_harness_push_event (h, gst_event_new_segment (&segment));
+
+  gst_harness_set_sink_caps_str (h,
+      "audio/mpeg,mpegversion=4,stream-format=adts");
+
+  g_signal_connect (h->element, "pad-added",
+      G_CALLBACK (tsdemux_simple_pad_added), h);
+
+  /* Input buffers ending in the middle of packets */
+  buf =
+      gst_buffer_new_wrapped_full (GST_MEMORY_FLAG_READONLY, (guint8 *) aac_ts,
+      sizeof aac_ts, 0, sizeof aac_ts, NULL, NULL);
+  for (i = 0; i < sizeof aac_ts; i += chunk) {
+    chunk = MIN (sizeof aac_ts - i, 100);
+    fail_unless (gst_harness_push (h, gst_buffer_copy_region (buf,
+                GST_BUFFER_COPY_MEMORY, i, chunk)) == GST_FLOW_OK);
+  }
+  gst_buffer_unref (buf);
+  gst_harness_push_event (h, gst_event_new_eos ());
+
+  buf = gst_harness_take_all_data_as_buffer (h);
+  gst_check_buffer_data (buf, aac_data, sizeof aac_data);
+  gst_buffer_unref (buf);
+
+  gst_harness_teardown (h);
+}
+
+GST_END_TEST;
+
+/* Push the aac_ts packets with the given packet size (188 or 192), preceded by
+ * some garbage the demuxer needs to skip to find sync */
+static void
+tsdemux_check_resync (guint packetsize)
+{
+  GstHarness *h = gst_harness_new_with_padnames ("tsdemux", "sink", NULL);
+  static const guint8 garbage[] = {
+    0x47, 0x00, 0x12, 0x47, 0x47, 0x00, 0x00, 0x01, 0xff, 0x47, 0x10, 0x00,
+    0x00, 0x47, 0x1f, 0xff, 0x00, 0x00, 0x00, 0x47, 0x55, 0xaa, 0x55
+  };
+  GstBuffer *buf;
+  GstCaps *caps;
+  GstSegment segment;
+  guint8 *data, *d;
+  gsize size, i;
+
+  size = sizeof garbage + aac_ts_packets * packetsize;
+  d = data = g_malloc0 (size);
+  memcpy (d, garbage, sizeof garbage);
+  d += sizeof garbage;
+  for (i = 0; i < aac_ts_packets; i++) {
+    /* M2TS packets are prefixed by a 4 bytes timestamp, left at 0 */
+    d += packetsize - PACKETSIZE;
+    memcpy (d, aac_ts + i * PACKETSIZE, PACKETSIZE);
+    d += PACKETSIZE;
+  }
+
+  caps = gst_caps_from_string ("video/mpegts,systemstream=true");
+  gst_harness_push_event (h, gst_event_new_caps (caps));
+  gst_caps_unref (caps);
+
+  gst_segment_init (&segment, GST_FORMAT_BYTES);
+  gst_harness_push_event (h, gst_event_new_segment (&segment));
+
+  gst_harness_set_sink_caps_str (h,
+      "audio/mpeg,mpegversion=4,stream-format=adts");
+
+  g_signal_connect (h->element, "pad-added",
+      G_CALLBACK (tsdemux_simple_pad_added), h);
+
+  buf = gst_buffer_new_wrapped (data, size);
+  fail_unless (gst_harness_push (h, buf) == GST_FLOW_OK);
+  gst_harness_push_event (h, gst_event_new_eos ());
+
+  buf = gst_harness_take_all_data_as_buffer (h);
+  gst_check_buffer_data (buf, aac_data, sizeof aac_data);
+  gst_buffer_unref (buf);
+
+  gst_harness_teardown (h);
+}
+
+GST_START_TEST (test_tsdemux_resync)
+{
+  tsdemux_check_resync (PACKETSIZE);
+}
+
+GST_END_TEST;
+
+GST_START_TEST (test_tsdemux_resync_m2ts)
+{
+  tsdemux_check_resync (192);
+}
+
+GST_END_TEST;
+
+static guint32
+ts_crc32 (const guint8 * data, gsize size)
+{
+  guint32 crc = 0xffffffff;
+  gsize i;
+  gint b;
+
+  for (i = 0; i < size; i++) {
+    crc ^= (guint32) data[i] << 24;
+    for (b = 0; b < 8; b++)
+      crc = crc & 0x80000000 ? (crc << 1) ^ 0x04c11db7 : crc << 1;
+  }
+
+  return crc;
+}
+
+/* Writes a packet carrying size bytes of payload (at most 184), the rest is
+ * filled with adaptation field stuffing */
+static guint8 *
+ts_write_packet (guint8 * p, guint16 pid, gboolean pusi, guint8 * cc,
+    const guint8 * payload, gsize size)
+{
+  gsize af_size = PACKETSIZE - 4 - size;
+
+  p[0] = 0x47;
+  p[1] = (pusi ? 0x40 : 0x00) | (pid >> 8);
+  p[2] = pid & 0xff;
+  p[3] = (af_size ? 0x30 : 0x10) | (*cc & 0xf);
+  *cc += 1;
+  if (af_size) {
+    p[4] = af_size - 1;
+    if (af_size > 1) {
+      p[5] = 0x00;
+      memset (p + 6, 0xff, af_size - 2);
+    }
+  }
+  memcpy (p + 4 + af_size, payload, size);
+
+  return p + PACKETSIZE;
+}
+
+/* Writes a packet holding the section, which gets its CRC appended */
+static guint8 *
+ts_write_section (guint8 * p, guint16 pid, const guint8 * section, gsize size)
+{
+  guint8 payload[184];
+  guint8 cc = 0;
+
+  memset (payload, 0xff, sizeof payload);
+  payload[0] = 0x00;
+  memcpy (payload + 1, section, size);
+  GST_WRITE_UINT32_BE (payload + 1 + size, ts_crc32 (section, size));
+
+  return ts_write_packet (p, pid, TRUE, &cc, payload, sizeof payload);
+}
+
+#define PES_PID 0x100
+#define PES_HEADER_SIZE 14
+
+/* Number of packets of each PES of h264_ts_new() */
+static const guint h264_pes_packets[] = { 1, 40, 1 };
+
+/* A H.264 program without PCR, made of PES that fill their packets. The
+ * payloads of all PES are returned in payload. */
+static GstBuffer *
+h264_ts_new (guint8 ** payload, gsize * payload_size)
+{
+  static const guint8 pat[] = {
+    0x00, 0xb0, 0x0d, 0x00, 0x01, 0xc1, 0x00, 0x00,
+    0x00, 0x01, 0xe0, 0x20
+  };
+  static const guint8 pmt[] = {
+    0x02, 0xb0, 0x12, 0x00, 0x01, 0xc1, 0x00, 0x00,
+    0xff, 0xff, 0xf0, 0x00, 0x1b, 0xe0 | (PES_PID >> 8), PES_PID & 0xff,
+    0xf0, 0x00
+  };
+  guint8 *data, *p, *pl, cc = 0;
+  guint8 packet[184];
+  gsize n_packets = 2, i, j, k;
+  guint64 pts;
+
+  for (i = 0; i < G_N_ELEMENTS (h264_pes_packets); i++)
+    n_packets += h264_pes_packets[i];
+
+  p = data = g_malloc (n_packets * PACKETSIZE);
+  p = ts_write_section (p, 0x0000, pat, sizeof pat);
+  p = ts_write_section (p, 0x0020, pmt, sizeof pmt);
+
+  pl = *payload = g_malloc (n_packets * 184);
+  for (i = 0; i < G_N_ELEMENTS (h264_pes_packets); i++) {
+    pts = 3003 * (i + 1);
+    packet[0] = 0x00;
+    packet[1] = 0x00;
+    packet[2] = 0x01;
+    packet[3] = 0xe0;
+    packet[4] = packet[5] = 0x00;
+    packet[6] = 0x80;
+    packet[7] = 0x80;
+    packet[8] = 0x05;
+    packet[9] = 0x21 | ((pts >> 29) & 0x0e);
+    packet[10] = (pts >> 22) & 0xff;
+    packet[11] = ((pts >> 14) & 0xfe) | 0x01;
+    packet[12] = (pts >> 7) & 0xff;
+    packet[13] = ((pts << 1) & 0xfe) | 0x01;
+
+    for (j = 0; j < h264_pes_packets[i]; j++) {
+      guint8 *start = j == 0 ? packet + PES_HEADER_SIZE : packet;
+
+      for (k = 0; start + k < packet + sizeof packet; k++) {
+        start[k] = (pl - *payload) * 7 + i;
+        *pl++ = start[k];
+      }
+      p = ts_write_packet (p, PES_PID, j == 0, &cc, packet, sizeof packet);
+    }
+  }
+  *payload_size = pl - *payload;
+
+  return gst_buffer_new_wrapped (data, n_packets * PACKETSIZE);
+}
+
+static void
+tsdemux_any_pad_added (GstElement * tsdemux, GstPad * pad, GstHarness * h)
+{
+  gst_harness_add_element_src_pad (h, pad);
+}
+
+/* Checks the output of h264_ts_new() with the zero-copy-pes property set to
+ * zero_copy, and a sink requiring contiguous memory or not */
+static void
+tsdemux_check_pes_output (gboolean zero_copy, gboolean contiguous)
+{
+  GstHarness *h = gst_harness_new_with_padnames ("tsdemux", "sink", NULL);
+  GstAllocationParams params;
+  GstBuffer *buf, *outbuf;
+  GstCaps *caps;
+  GstSegment segment;
+  GstMapInfo map;
+  guint8 *payload;
+  gsize payload_size, offset = 0, i;
+  guint n_buffers, n_expected, m;
+  gboolean sliced = zero_copy && !contiguous;
+
+  g_object_set (h->element, "zero-copy-pes", zero_copy, NULL);
+
+  caps = gst_caps_from_string ("video/mpegts,systemstream=true");
+  gst_harness_push_event (h, gst_event_new_caps (caps));
+  gst_caps_unref (caps);
+
+  gst_segment_init (&segment, GST_FORMAT_BYTES);
+  gst_harness_push_event (h, gst_event_new_segment (&segment));
+
+  if (contiguous) {
+    gst_allocation_params_init (&params);
+    params.flags = GST_MEMORY_FLAG_PHYSICALLY_CONTIGUOUS;
+    gst_harness_set_propose_allocator (h, NULL, &params);
+  }
+
+  g_signal_connect (h->element, "pad-added",
+      G_CALLBACK (tsdemux_any_pad_added), h);
+
+  buf = h264_ts_new (&payload, &payload_size);
+  fail_unless (gst_harness_push (h, buf) == GST_FLOW_OK);
+  gst_harness_push_event (h, gst_event_new_eos ());
+
+  /* Each PES is copied into a single buffer, unless zero-copy-pes is set.
+   * Then the first PES is still copied as downstream wasn't queried yet. The
+   * other ones share the input memory, in buffers of at most 16 memories,
+   * unless downstream requires contiguous memory. */
+  if (!sliced) {
+    n_expected = G_N_ELEMENTS (h264_pes_packets);
+  } else {
+    n_expected = 1;
+    for (i = 1; i < G_N_ELEMENTS (h264_pes_packets); i++)
+      n_expected += (h264_pes_packets[i] + gst_buffer_get_max_memory () - 1)
+          / gst_buffer_get_max_memory ();
+  }
+  n_buffers = gst_harness_buffers_in_queue (h);
+  fail_unless_equals_int (n_buffers, n_expected);
+
+  for (i = 0; i < n_buffers; i++) {
+    outbuf = gst_harness_pull (h);
+    if (!sliced || i == 0) {
+      fail_unless_equals_int (gst_buffer_n_memory (outbuf), 1);
+      fail_unless (gst_buffer_peek_memory (outbuf, 0)->parent == NULL);
+    } else {
+      for (m = 0; m < gst_buffer_n_memory (outbuf); m++)
+        fail_unless (gst_buffer_peek_memory (outbuf, m)->parent != NULL);
+    }
+
+    gst_buffer_map (outbuf, &map, GST_MAP_READ);
+    fail_unless (offset + map.size <= payload_size);
+    fail_unless (memcmp (map.data, payload + offset, map.size) == 0);
+    offset += map.size;
+    gst_buffer_unmap (outbuf, &map);
+    gst_buffer_unref (outbuf);
+  }
+  fail_unless_equals_int (offset, payload_size);
+
+  g_free (payload);
+  gst_harness_teardown (h);
+}
+
+GST_START_TEST (test_tsdemux_pes_copy)
+{
+  tsdemux_check_pes_output (FALSE, FALSE);
+}
+
+GST_END_TEST;
+
+GST_START_TEST (test_tsdemux_zero_copy)
+{
+  tsdemux_check_pes_output (TRUE, FALSE);
+}
+
+GST_END_TEST;
+
+GST_START_TEST (test_tsdemux_zero_copy_contiguous)
+{
+  tsdemux_check_pes_output (TRUE, TRUE);
+}
+
+GST_END_TEST;
+
 static Suite *
 mpegtsdemux_suite (void)
 {
@@ -390,10 +775,17 @@ mpegtsdemux_suite (void)
   tcase_add_test (tc, test_tsparse_align_fuse);
   tcase_add_test (tc, test_tsparse_align_split);
   tcase_add_test (tc, test_tsparse_padding);
+  tcase_add_test (tc, test_tsparse_program_queue);
 
   tc = tcase_create ("tsdemux");
   suite_add_tcase (s, tc);
   tcase_add_test (tc, test_tsdemux_simple);
+  tcase_add_test (tc, test_tsdemux_unaligned_input);
+  tcase_add_test (tc, test_tsdemux_resync);
+  tcase_add_test (tc, test_tsdemux_resync_m2ts);
+  tcase_add_test (tc, test_tsdemux_pes_copy);
+  tcase_add_test (tc, test_tsdemux_zero_copy);
+  tcase_add_test (tc, test_tsdemux_zero_copy_contiguous);
 
   return s;
 }
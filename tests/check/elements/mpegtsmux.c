@@ -19,6 +19,7 @@
  */
 
 #include <gst/check/gstcheck.h>
+#include <gst/base/gstadapter.h>
 #include <string.h>
 #include <gst/video/video.h>
 
@@ -557,6 +558,380 @@ GST_START_TEST (test_align)
 
 GST_END_TEST;
 
+static gboolean got_eos;
+
+static gboolean
+eos_event_func (GstPad * pad, GstObject * parent, GstEvent * event)
+{
+  if (GST_EVENT_TYPE (event) == GST_EVENT_EOS) {
+    g_mutex_lock (&check_mutex);
+    got_eos = TRUE;
+    g_cond_signal (&check_cond);
+    g_mutex_unlock (&check_mutex);
+  }
+
+  return gst_pad_event_default (pad, parent, event);
+}
+
+/* EOS is handled from the aggregator thread, wait for all output */
+static void
+push_eos_and_wait (void)
+{
+  GstPadEventFunction event_func = GST_PAD_EVENTFUNC (mysinkpad);
+
+  got_eos = FALSE;
+  gst_pad_set_event_function (mysinkpad, eos_event_func);
+
+  fail_unless (gst_pad_push_event (mysrcpad, gst_event_new_eos ()));
+
+  g_mutex_lock (&check_mutex);
+  while (!got_eos)
+    g_cond_wait (&check_cond, &check_mutex);
+  g_mutex_unlock (&check_mutex);
+
+  gst_pad_set_event_function (mysinkpad, event_func);
+}
+
+GST_START_TEST (test_align_eos)
+{
+  GstElement *mux;
+  gchar *padname;
+  GstCaps *caps;
+  GstBuffer *inbuffer;
+  GList *l;
+  gint i;
+
+  mux = setup_tsmux (&video_src_template, "sink_%d", &padname);
+  g_object_set (mux, "alignment", 7, NULL);
+
+  fail_unless (gst_element_set_state (mux,
+          GST_STATE_PLAYING) == GST_STATE_CHANGE_SUCCESS,
+      "could not set to playing");
+
+  caps = gst_caps_from_string (VIDEO_CAPS_STRING);
+  gst_check_setup_events (mysrcpad, mux, caps, GST_FORMAT_TIME);
+  gst_caps_unref (caps);
+
+  for (i = 0; i < 5; i++) {
+    inbuffer = gst_buffer_new_and_alloc (1000);
+    gst_buffer_memset (inbuffer, 0, 0, 1000);
+    GST_BUFFER_PTS (inbuffer) = i * 40 * GST_MSECOND;
+    fail_unless_equals_int (gst_pad_push (mysrcpad, inbuffer), GST_FLOW_OK);
+  }
+
+  push_eos_and_wait ();
+
+  /* the last, partial chunk must have been padded with null packets */
+  fail_unless (buffers != NULL);
+  for (l = buffers; l; l = l->next) {
+    GstBuffer *buf = l->data;
+    GstMapInfo map;
+    gsize offset;
+
+    fail_unless_equals_int (gst_buffer_get_size (buf), 7 * 188);
+
+    gst_buffer_map (buf, &map, GST_MAP_READ);
+    for (offset = 0; offset < map.size; offset += 188)
+      fail_unless_equals_int (map.data[offset], 0x47);
+    gst_buffer_unmap (buf, &map);
+  }
+
+  gst_check_drop_buffers ();
+  cleanup_tsmux (mux, padname);
+  g_free (padname);
+}
+
+GST_END_TEST;
+
+/* Every packet of a PID carrying payload must follow the previous one, so
+ * that no packet was lost or reordered when the alignment changed */
+static void
+check_continuity (GList * bufs)
+{
+  GstAdapter *adapter = gst_adapter_new ();
+  gint cc[0x2000];
+  const guint8 *data;
+  gsize size, offset;
+
+  for (; bufs; bufs = bufs->next)
+    gst_adapter_push (adapter, gst_buffer_ref (bufs->data));
+
+  memset (cc, -1, sizeof (cc));
+  size = gst_adapter_available (adapter);
+  fail_unless (size > 0);
+  fail_unless_equals_int (size % 188, 0);
+  data = gst_adapter_map (adapter, size);
+
+  for (offset = 0; offset < size; offset += 188) {
+    const guint8 *p = data + offset;
+    guint pid = GST_READ_UINT16_BE (p + 1) & 0x1fff;
+
+    fail_unless_equals_int (p[0], 0x47);
+    if (pid == 0x1fff || !(p[3] & 0x10))
+      continue;
+
+    if (cc[pid] >= 0)
+      fail_unless_equals_int (p[3] & 0xf, (cc[pid] + 1) & 0xf);
+    cc[pid] = p[3] & 0xf;
+  }
+
+  gst_adapter_unmap (adapter);
+  g_object_unref (adapter);
+}
+
+GST_START_TEST (test_align_change)
+{
+  GstElement *mux;
+  gchar *padname;
+  GstCaps *caps;
+  GstBuffer *inbuffer;
+  gint i;
+
+  mux = setup_tsmux (&video_src_template, "sink_%d", &padname);
+  g_object_set (mux, "alignment", 7, NULL);
+
+  fail_unless (gst_element_set_state (mux,
+          GST_STATE_PLAYING) == GST_STATE_CHANGE_SUCCESS,
+      "could not set to playing");
+
+  caps = gst_caps_from_string (VIDEO_CAPS_STRING);
+  gst_check_setup_events (mysrcpad, mux, caps, GST_FORMAT_TIME);
+  gst_caps_unref (caps);
+
+  /* The aligned output gathered so far, including the partial buffer, must
+   * come out before the output without alignment, and the other way
+   * around */
+  for (i = 0; i < 15; i++) {
+    if (i == 5)
+      g_object_set (mux, "alignment", 0, NULL);
+    else if (i == 10)
+      g_object_set (mux, "alignment", 7, NULL);
+
+    inbuffer = gst_buffer_new_and_alloc (1000);
+    gst_buffer_memset (inbuffer, 0, 0, 1000);
+    GST_BUFFER_PTS (inbuffer) = i * 40 * GST_MSECOND;
+    fail_unless_equals_int (gst_pad_push (mysrcpad, inbuffer), GST_FLOW_OK);
+  }
+
+  push_eos_and_wait ();
+
+  check_continuity (buffers);
+
+  gst_check_drop_buffers ();
+  cleanup_tsmux (mux, padname);
+  g_free (padname);
+}
+
+GST_END_TEST;
+
+#define CBR_BITRATE 10000000
+
+/* Validates the CBR output: PCR values must match the position of the
+ * packet in the stream within 500ns, and the T-STD transport buffer of the
+ * stream whose PES have @stream_id, leaking at @leak_rate bits per second,
+ * must never overflow */
+static void
+check_cbr_output (GList * bufs, guint8 stream_id, guint64 leak_rate)
+{
+  GstAdapter *adapter = gst_adapter_new ();
+  const guint8 *data;
+  gsize size, offset, first_pcr_offset = 0;
+  guint64 first_pcr = G_MAXUINT64, tb_level = 0;
+  gint es_pid = -1, n_pcr = 0;
+
+  for (; bufs; bufs = bufs->next)
+    gst_adapter_push (adapter, gst_buffer_ref (bufs->data));
+
+  size = gst_adapter_available (adapter);
+  fail_unless (size > 0);
+  fail_unless (size % 188 == 0);
+  data = gst_adapter_map (adapter, size);
+
+  for (offset = 0; offset < size; offset += 188) {
+    const guint8 *pkt = data + offset;
+    guint pid = GST_READ_UINT16_BE (pkt + 1) & 0x1FFF;
+    gboolean pusi = (pkt[1] & 0x40) != 0;
+    guint8 afc = (pkt[3] >> 4) & 0x3;
+    const guint8 *payload = pkt + 4;
+
+    fail_unless_equals_int (pkt[0], 0x47);
+
+    /* leak the transport buffer for the duration of one packet */
+    tb_level = tb_level > 188 * leak_rate ? tb_level - 188 * leak_rate : 0;
+
+    if (afc & 0x2) {
+      guint8 af_len = pkt[4];
+
+      if (af_len > 0 && (pkt[5] & 0x10)) {
+        guint64 pcr_base = ((guint64) GST_READ_UINT32_BE (pkt + 6) << 1) |
+            (pkt[10] >> 7);
+        guint64 pcr = pcr_base * 300 + (GST_READ_UINT16_BE (pkt + 10) & 0x1FF);
+
+        if (first_pcr == G_MAXUINT64) {
+          first_pcr = pcr;
+          first_pcr_offset = offset;
+        } else {
+          guint64 expected = first_pcr +
+              gst_util_uint64_scale (offset - first_pcr_offset, 8 * 27000000,
+              CBR_BITRATE);
+          gint64 jitter = (gint64) pcr - (gint64) expected;
+
+          GST_LOG ("PCR %" G_GUINT64_FORMAT " at offset %" G_GSIZE_FORMAT
+              ", jitter %" G_GINT64_FORMAT, pcr, offset, jitter);
+          /* 500ns at 27MHz */
+          fail_unless (ABS (jitter) <= 13,
+              "PCR jitter %" G_GINT64_FORMAT " too high", jitter);
+        }
+        n_pcr++;
+      }
+      payload += 1 + af_len;
+    }
+
+    if (es_pid == -1 && pusi && (afc & 0x1) &&
+        GST_READ_UINT32_BE (payload) == (0x00000100 | stream_id))
+      es_pid = pid;
+
+    if (pid == es_pid) {
+      tb_level += 188 * (guint64) CBR_BITRATE;
+      fail_unless (tb_level <= 512 * (guint64) CBR_BITRATE,
+          "transport buffer overflow at offset %" G_GSIZE_FORMAT, offset);
+    }
+  }
+
+  fail_unless (es_pid != -1);
+  fail_unless (n_pcr > 2);
+
+  gst_adapter_unmap (adapter);
+  g_object_unref (adapter);
+}
+
+static void
+check_cbr (gint alignment)
+{
+  GstElement *mux;
+  gchar *padname;
+  GstCaps *caps;
+  GstBuffer *inbuffer;
+  GList *l;
+  gint i;
+
+  mux = setup_tsmux (&audio_src_template, "sink_%d", &padname);
+  g_object_set (mux, "bitrate", (guint64) CBR_BITRATE, NULL);
+  if (alignment)
+    g_object_set (mux, "alignment", alignment, NULL);
+
+  fail_unless (gst_element_set_state (mux,
+          GST_STATE_PLAYING) == GST_STATE_CHANGE_SUCCESS,
+      "could not set to playing");
+
+  caps = gst_caps_from_string (AUDIO_CAPS_STRING);
+  gst_check_setup_events (mysrcpad, mux, caps, GST_FORMAT_TIME);
+  gst_caps_unref (caps);
+
+  /* 1 Mbit/s of audio in bursts, which would overflow the transport
+   * buffer if sent at the multiplex rate */
+  for (i = 0; i < 25; i++) {
+    inbuffer = gst_buffer_new_and_alloc (5000);
+    gst_buffer_memset (inbuffer, 0, 0, 5000);
+    GST_BUFFER_PTS (inbuffer) = i * 40 * GST_MSECOND;
+    fail_unless_equals_int (gst_pad_push (mysrcpad, inbuffer), GST_FLOW_OK);
+  }
+
+  push_eos_and_wait ();
+
+  if (alignment) {
+    /* the PCR packets are output before the packets allocated ahead of
+     * them, which can't be written in place then */
+    for (l = buffers; l; l = l->next)
+      fail_unless_equals_int (gst_buffer_get_size (l->data), alignment * 188);
+    check_continuity (buffers);
+  } else {
+    check_cbr_output (buffers, 0xC0, 2000000);
+  }
+
+  gst_check_drop_buffers ();
+  cleanup_tsmux (mux, padname);
+  g_free (padname);
+}
+
+GST_START_TEST (test_cbr)
+{
+  check_cbr (0);
+}
+
+GST_END_TEST;
+
+GST_START_TEST (test_cbr_align)
+{
+  check_cbr (7);
+}
+
+GST_END_TEST;
+
+/* Muxes 1 Mbit/s of video in bursts, whose transport buffer must leak at
+ * @leak_rate, the Rmax of the caps or of the @max_bitrate tag times 1.2 */
+static void
+check_cbr_video (const gchar * caps_str, guint max_bitrate, guint64 leak_rate)
+{
+  GstElement *mux;
+  gchar *padname;
+  GstCaps *caps;
+  GstBuffer *inbuffer;
+  gint i;
+
+  mux = setup_tsmux (&video_src_template, "sink_%d", &padname);
+  g_object_set (mux, "bitrate", (guint64) CBR_BITRATE, NULL);
+
+  fail_unless (gst_element_set_state (mux,
+          GST_STATE_PLAYING) == GST_STATE_CHANGE_SUCCESS,
+      "could not set to playing");
+
+  caps = gst_caps_from_string (caps_str);
+  gst_check_setup_events (mysrcpad, mux, caps, GST_FORMAT_TIME);
+  gst_caps_unref (caps);
+
+  if (max_bitrate) {
+    fail_unless (gst_pad_push_event (mysrcpad,
+            gst_event_new_tag (gst_tag_list_new (GST_TAG_MAXIMUM_BITRATE,
+                    max_bitrate, NULL))));
+  }
+
+  for (i = 0; i < 25; i++) {
+    inbuffer = gst_buffer_new_and_alloc (5000);
+    gst_buffer_memset (inbuffer, 0, 0, 5000);
+    GST_BUFFER_PTS (inbuffer) = i * 40 * GST_MSECOND;
+    GST_BUFFER_DTS (inbuffer) = i * 40 * GST_MSECOND;
+    fail_unless_equals_int (gst_pad_push (mysrcpad, inbuffer), GST_FLOW_OK);
+  }
+
+  push_eos_and_wait ();
+
+  check_cbr_output (buffers, 0xE0, leak_rate);
+
+  gst_check_drop_buffers ();
+  cleanup_tsmux (mux, padname);
+  g_free (padname);
+}
+
+GST_START_TEST (test_cbr_video_level)
+{
+  /* Main profile level 2: 1200 * 2000 kbit/s */
+  check_cbr_video (VIDEO_CAPS_STRING ", profile = (string) main, "
+      "level = (string) 2", 0, 2400000 * 6 / 5);
+}
+
+GST_END_TEST;
+
+GST_START_TEST (test_cbr_video_max_bitrate_tag)
+{
+  /* the tag is used over the level, and without it */
+  check_cbr_video (VIDEO_CAPS_STRING ", profile = (string) main, "
+      "level = (string) 4", 1500000, 1500000 * 6 / 5);
+  check_cbr_video (VIDEO_CAPS_STRING, 1500000, 1500000 * 6 / 5);
+}
+
+GST_END_TEST;
+
 static void
 test_keyframe_propagation_check_output (GList * bufs)
 {
@@ -598,6 +973,12 @@ mpegtsmux_suite (void)
   tcase_add_test (tc_chain, test_video);
   tcase_add_test (tc_chain, test_multiple_state_change);
   tcase_add_test (tc_chain, test_align);
+  tcase_add_test (tc_chain, test_align_eos);
+  tcase_add_test (tc_chain, test_align_change);
+  tcase_add_test (tc_chain, test_cbr);
+  tcase_add_test (tc_chain, test_cbr_align);
+  tcase_add_test (tc_chain, test_cbr_video_level);
+  tcase_add_test (tc_chain, test_cbr_video_max_bitrate_tag);
   tcase_add_test (tc_chain, test_keyframe_flag_propagation);
   tcase_add_test (tc_chain, test_reappearing_pad_while_playing);
   tcase_add_test (tc_chain, test_reappearing_pad_while_stopped);
@@ -21,6 +21,7 @@
  */
 
 #include <gst/check/gstcheck.h>
+#include <glib/gstdio.h>
 #include <string.h>
 #include "mxfdemux.h"
 
@@ -287,11 +288,255 @@ GST_START_TEST (test_push)
 
 GST_END_TEST;
 
+static void
+run_pipeline_to_eos (const gchar * desc)
+{
+  GstElement *pipeline;
+  GstMessage *msg;
+
+  pipeline = gst_parse_launch (desc, NULL);
+  fail_unless (pipeline != NULL);
+  fail_unless (gst_element_set_state (pipeline, GST_STATE_PLAYING) !=
+      GST_STATE_CHANGE_FAILURE);
+  msg = gst_bus_timed_pop_filtered (GST_ELEMENT_BUS (pipeline),
+      GST_CLOCK_TIME_NONE, GST_MESSAGE_EOS | GST_MESSAGE_ERROR);
+  fail_unless_equals_int (GST_MESSAGE_TYPE (msg), GST_MESSAGE_EOS);
+  gst_message_unref (msg);
+  gst_element_set_state (pipeline, GST_STATE_NULL);
+  gst_object_unref (pipeline);
+}
+
+/* A file of raw video without index table, whose offsets mxfdemux only
+ * discovers while playing */
+static gchar *
+create_mxf_file (const gchar * dir, const gchar * name, guint n_frames)
+{
+  gchar *location = g_build_filename (dir, name, NULL);
+  gchar *desc;
+
+  desc = g_strdup_printf ("videotestsrc num-buffers=%u ! "
+      "video/x-raw,format=(string)v308,width=64,height=48,framerate=25/1 ! "
+      "mxfmux ! filesink location=\"%s\"", n_frames, location);
+  run_pipeline_to_eos (desc);
+  g_free (desc);
+
+  return location;
+}
+
+/* Plays the file to the end, seeks to @position and returns the timestamp
+ * of the buffer mxfdemux prerolled with */
+static GstClockTime
+play_and_seek (const gchar * location, const gchar * cache_dir,
+    GstClockTime position)
+{
+  GstElement *pipeline, *demux, *sink;
+  GstSample *sample;
+  GstMessage *msg;
+  GstClockTime pts;
+  gchar *desc;
+
+  desc = g_strdup_printf ("filesrc location=\"%s\" ! mxfdemux name=demux ! "
+      "fakesink name=sink sync=false", location);
+  pipeline = gst_parse_launch (desc, NULL);
+  g_free (desc);
+  fail_unless (pipeline != NULL);
+  demux = gst_bin_get_by_name (GST_BIN (pipeline), "demux");
+  sink = gst_bin_get_by_name (GST_BIN (pipeline), "sink");
+  g_object_set (demux, "index-cache-dir", cache_dir, NULL);
+
+  fail_unless (gst_element_set_state (pipeline, GST_STATE_PLAYING) !=
+      GST_STATE_CHANGE_FAILURE);
+  msg = gst_bus_timed_pop_filtered (GST_ELEMENT_BUS (pipeline),
+      GST_CLOCK_TIME_NONE, GST_MESSAGE_EOS | GST_MESSAGE_ERROR);
+  fail_unless_equals_int (GST_MESSAGE_TYPE (msg), GST_MESSAGE_EOS);
+  gst_message_unref (msg);
+
+  fail_unless (gst_element_set_state (pipeline, GST_STATE_PAUSED) !=
+      GST_STATE_CHANGE_FAILURE);
+  fail_unless (gst_element_get_state (pipeline, NULL, NULL,
+          GST_CLOCK_TIME_NONE) == GST_STATE_CHANGE_SUCCESS);
+  fail_unless (gst_element_seek_simple (pipeline, GST_FORMAT_TIME,
+          GST_SEEK_FLAG_FLUSH, position));
+  fail_unless (gst_element_get_state (pipeline, NULL, NULL,
+          GST_CLOCK_TIME_NONE) == GST_STATE_CHANGE_SUCCESS);
+
+  g_object_get (sink, "last-sample", &sample, NULL);
+  fail_unless (sample != NULL);
+  pts = GST_BUFFER_PTS (gst_sample_get_buffer (sample));
+  gst_sample_unref (sample);
+
+  /* The index cache is written again when going back to READY */
+  gst_element_set_state (pipeline, GST_STATE_NULL);
+  gst_object_unref (sink);
+  gst_object_unref (demux);
+  gst_object_unref (pipeline);
+
+  return pts;
+}
+
+/* Returns the path of the only index cache in @dir */
+static gchar *
+get_index_cache (const gchar * dir)
+{
+  GDir *d = g_dir_open (dir, 0, NULL);
+  const gchar *name;
+  gchar *path = NULL;
+
+  fail_unless (d != NULL);
+  while ((name = g_dir_read_name (d))) {
+    fail_unless (g_str_has_suffix (name, ".mxfindex"));
+    fail_unless (path == NULL, "More than one index cache in %s", dir);
+    path = g_build_filename (dir, name, NULL);
+  }
+  g_dir_close (d);
+  fail_unless (path != NULL, "No index cache in %s", dir);
+
+  return path;
+}
+
+static void
+check_file_contents (const gchar * path, const gchar * expected,
+    gsize expected_size)
+{
+  gchar *contents;
+  gsize size;
+
+  fail_unless (g_file_get_contents (path, &contents, &size, NULL));
+  fail_unless_equals_uint64 (size, expected_size);
+  fail_unless (memcmp (contents, expected, size) == 0);
+  g_free (contents);
+}
+
+static void
+remove_dir (const gchar * dir)
+{
+  GDir *d = g_dir_open (dir, 0, NULL);
+  const gchar *name;
+
+  fail_unless (d != NULL);
+  while ((name = g_dir_read_name (d))) {
+    gchar *path = g_build_filename (dir, name, NULL);
+
+    g_remove (path);
+    g_free (path);
+  }
+  g_dir_close (d);
+  g_rmdir (dir);
+}
+
+#define SEEK_POSITION (2 * GST_SECOND + 100 * GST_MSECOND)
+
+GST_START_TEST (test_index_cache)
+{
+  gchar *dir, *cache_dir, *location, *cache, *contents;
+  GstClockTime expected;
+  guint64 file_size;
+  gint64 file_mtime;
+  GStatBuf st;
+  gsize size;
+
+  dir = g_dir_make_tmp ("mxfdemux-XXXXXX", NULL);
+  fail_unless (dir != NULL);
+  cache_dir = g_build_filename (dir, "cache", NULL);
+  location = create_mxf_file (dir, "test.mxf", 100);
+  fail_unless (g_stat (location, &st) == 0);
+
+  expected = play_and_seek (location, NULL, SEEK_POSITION);
+  fail_unless (GST_CLOCK_TIME_IS_VALID (expected));
+
+  /* The cache directory is created, and the cache identifies the file */
+  fail_unless_equals_uint64 (play_and_seek (location, cache_dir,
+          SEEK_POSITION), expected);
+  cache = get_index_cache (cache_dir);
+  fail_unless (g_file_get_contents (cache, &contents, &size, NULL));
+  fail_unless (size > 8 + 4 + 8 + 8);
+  fail_unless (memcmp (contents, "GSTMXFIX", 8) == 0);
+  fail_unless_equals_int (GST_READ_UINT32_LE (contents + 8), 1);
+  file_size = GST_READ_UINT64_LE (contents + 12);
+  file_mtime = GST_READ_UINT64_LE (contents + 20);
+  fail_unless_equals_uint64 (file_size, st.st_size);
+  fail_unless_equals_int64 (file_mtime, st.st_mtime);
+
+  /* Loading the cache gives the same result, and as nothing new is
+   * discovered the cache stays as it is */
+  fail_unless_equals_uint64 (play_and_seek (location, cache_dir,
+          SEEK_POSITION), expected);
+  check_file_contents (cache, contents, size);
+  fail_unless_equals_uint64 (play_and_seek (location, cache_dir,
+          SEEK_POSITION), expected);
+  check_file_contents (cache, contents, size);
+
+  g_free (contents);
+  g_free (cache);
+  g_free (location);
+  remove_dir (cache_dir);
+  g_free (cache_dir);
+  remove_dir (dir);
+  g_free (dir);
+}
+
+GST_END_TEST;
+
+GST_START_TEST (test_index_cache_stale)
+{
+  gchar *dir, *cache_dir, *other_cache_dir, *location, *other_location;
+  gchar *cache, *other_cache, *contents, *other_contents;
+  GstClockTime expected;
+  gsize size, other_size;
+
+  dir = g_dir_make_tmp ("mxfdemux-XXXXXX", NULL);
+  fail_unless (dir != NULL);
+  cache_dir = g_build_filename (dir, "cache", NULL);
+  other_cache_dir = g_build_filename (dir, "other-cache", NULL);
+  location = create_mxf_file (dir, "test.mxf", 100);
+  other_location = create_mxf_file (dir, "other.mxf", 60);
+
+  expected = play_and_seek (location, NULL, SEEK_POSITION);
+  fail_unless_equals_uint64 (play_and_seek (location, cache_dir,
+          SEEK_POSITION), expected);
+  cache = get_index_cache (cache_dir);
+  fail_unless (g_file_get_contents (cache, &contents, &size, NULL));
+
+  fail_unless (GST_CLOCK_TIME_IS_VALID (play_and_seek (other_location,
+              other_cache_dir, SEEK_POSITION)));
+  other_cache = get_index_cache (other_cache_dir);
+  fail_unless (g_file_get_contents (other_cache, &other_contents, &other_size,
+          NULL));
+
+  /* The cache of another file is not used, and replaced */
+  fail_unless (g_file_set_contents (cache, other_contents, other_size, NULL));
+  fail_unless_equals_uint64 (play_and_seek (location, cache_dir,
+          SEEK_POSITION), expected);
+  check_file_contents (cache, contents, size);
+
+  /* Nor is a truncated one */
+  fail_unless (g_file_set_contents (cache, contents, size / 2, NULL));
+  fail_unless_equals_uint64 (play_and_seek (location, cache_dir,
+          SEEK_POSITION), expected);
+  check_file_contents (cache, contents, size);
+
+  g_free (other_contents);
+  g_free (contents);
+  g_free (other_cache);
+  g_free (cache);
+  g_free (other_location);
+  g_free (location);
+  remove_dir (other_cache_dir);
+  remove_dir (cache_dir);
+  g_free (other_cache_dir);
+  g_free (cache_dir);
+  remove_dir (dir);
+  g_free (dir);
+}
+
+GST_END_TEST;
+
 static Suite *
 mxfdemux_suite (void)
 {
   Suite *s = suite_create ("mxfdemux");
   TCase *tc_chain = tcase_create ("general");
+  TCase *tc_index_cache = tcase_create ("index-cache");
 
   /* FIXME: remove again once ported */
   if (!gst_registry_check_feature_version (gst_registry_get (), "mxfdemux", 1,
@@ -303,6 +548,11 @@ mxfdemux_suite (void)
   tcase_add_test (tc_chain, test_pull);
   tcase_add_test (tc_chain, test_push);
 
+  suite_add_tcase (s, tc_index_cache);
+  tcase_set_timeout (tc_index_cache, 180);
+  tcase_add_test (tc_index_cache, test_index_cache);
+  tcase_add_test (tc_index_cache, test_index_cache_stale);
+
   return s;
 }
 
@@ -1,5 +1,6 @@
 #include <gst/check/gstharness.h>
 #include <gst/check/gstcheck.h>
+#include <gst/check/gsttestclock.h>
 
 GST_START_TEST (netsim_stress)
 {
@@ -51,6 +52,183 @@ GST_START_TEST (netsim_stress_delayed)
 
 GST_END_TEST;
 
+static void
+push_buffers (GstHarness * h, guint n, gsize size)
+{
+  guint i;
+
+  for (i = 0; i < n; i++)
+    fail_unless_equals_int (GST_FLOW_OK,
+        gst_harness_push (h, gst_harness_create_buffer (h, size)));
+}
+
+static void
+crank_and_check_time (GstHarness * h, GstClockTime expected)
+{
+  GstTestClock *testclock = gst_harness_get_testclock (h);
+  GstBuffer *buf;
+
+  fail_unless (gst_harness_crank_single_clock_wait (h));
+  fail_unless_equals_uint64 (expected,
+      gst_clock_get_time (GST_CLOCK (testclock)));
+  buf = gst_harness_pull (h);
+  fail_unless (buf != NULL);
+  gst_buffer_unref (buf);
+
+  gst_object_unref (testclock);
+}
+
+GST_START_TEST (netsim_link_serialization)
+{
+  GstHarness *h = gst_harness_new_parse ("netsim link-kbps=8");
+
+  gst_harness_use_testclock (h);
+  gst_harness_set_src_caps_str (h, "mycaps");
+
+  /* 100 bytes take 100ms at 8 kbps, and the second waits for the first */
+  push_buffers (h, 2, 100);
+  fail_unless_equals_int (0, gst_harness_buffers_received (h));
+
+  crank_and_check_time (h, 100 * GST_MSECOND);
+  crank_and_check_time (h, 200 * GST_MSECOND);
+  fail_unless_equals_int (2, gst_harness_buffers_received (h));
+
+  gst_harness_teardown (h);
+}
+
+GST_END_TEST;
+
+GST_START_TEST (netsim_link_queue_drop)
+{
+  GstHarness *h =
+      gst_harness_new_parse ("netsim link-kbps=8 link-queue-size=150");
+
+  gst_harness_use_testclock (h);
+  gst_harness_set_src_caps_str (h, "mycaps");
+
+  /* the second packet doesn't fit behind the first one */
+  push_buffers (h, 2, 100);
+
+  crank_and_check_time (h, 100 * GST_MSECOND);
+  fail_if (gst_harness_try_pull (h));
+
+  /* the queue drained, so there is room again */
+  push_buffers (h, 1, 100);
+  crank_and_check_time (h, 200 * GST_MSECOND);
+  fail_unless_equals_int (2, gst_harness_buffers_received (h));
+
+  gst_harness_teardown (h);
+}
+
+GST_END_TEST;
+
+GST_START_TEST (netsim_burst_loss)
+{
+  GstHarness *h = gst_harness_new_parse ("netsim burst-enter-probability=1.0 "
+      "burst-exit-probability=0.0");
+
+  gst_harness_set_src_caps_str (h, "mycaps");
+
+  /* the first packet is sent before the link goes into the burst for good */
+  push_buffers (h, 10, 100);
+  fail_unless_equals_int (1, gst_harness_buffers_received (h));
+
+  gst_harness_teardown (h);
+}
+
+GST_END_TEST;
+
+static GstHarness *
+new_delaying_harness (void)
+{
+  GstHarness *h = gst_harness_new_parse ("netsim delay-probability=1.0 "
+      "min-delay=100 max-delay=100");
+  GstEvent *event;
+
+  gst_harness_use_testclock (h);
+  gst_harness_set_src_caps_str (h, "mycaps");
+  while ((event = gst_harness_try_pull_event (h)))
+    gst_event_unref (event);
+
+  return h;
+}
+
+GST_START_TEST (netsim_events_behind_packets)
+{
+  GstHarness *h = new_delaying_harness ();
+  GstEvent *event;
+
+  push_buffers (h, 1, 100);
+  fail_unless (gst_harness_push_event (h,
+          gst_event_new_custom (GST_EVENT_CUSTOM_DOWNSTREAM,
+              gst_structure_new_empty ("netsim-test"))));
+  fail_if (gst_harness_try_pull_event (h));
+
+  /* the event follows the packet that came before it */
+  crank_and_check_time (h, 100 * GST_MSECOND);
+  event = gst_harness_pull_event (h);
+  fail_unless (event != NULL);
+  fail_unless_equals_int (GST_EVENT_TYPE (event), GST_EVENT_CUSTOM_DOWNSTREAM);
+  gst_event_unref (event);
+
+  gst_harness_teardown (h);
+}
+
+GST_END_TEST;
+
+GST_START_TEST (netsim_flush)
+{
+  GstHarness *h = new_delaying_harness ();
+  GstSegment segment;
+
+  push_buffers (h, 2, 100);
+  fail_unless (gst_harness_push_event (h, gst_event_new_flush_start ()));
+  fail_unless (gst_harness_push_event (h, gst_event_new_flush_stop (TRUE)));
+  gst_segment_init (&segment, GST_FORMAT_TIME);
+  fail_unless (gst_harness_push_event (h, gst_event_new_segment (&segment)));
+
+  /* the packets in flight are gone, only the new one comes out */
+  push_buffers (h, 1, 100);
+  crank_and_check_time (h, 100 * GST_MSECOND);
+  fail_if (gst_harness_try_pull (h));
+  fail_unless_equals_int (1, gst_harness_buffers_received (h));
+
+  gst_harness_teardown (h);
+}
+
+GST_END_TEST;
+
+static GstFlowReturn
+refuse_chain (GstPad * pad, GstObject * parent, GstBuffer * buf)
+{
+  gst_buffer_unref (buf);
+  return GST_FLOW_EOS;
+}
+
+GST_START_TEST (netsim_delayed_flow_return)
+{
+  GstHarness *h = new_delaying_harness ();
+  GstFlowReturn ret = GST_FLOW_OK;
+  guint i;
+
+  gst_pad_set_chain_function (h->sinkpad, refuse_chain);
+  push_buffers (h, 1, 100);
+  fail_unless (gst_harness_crank_single_clock_wait (h));
+
+  /* upstream learns what downstream returned for the delayed packet once
+   * the task pushed it */
+  for (i = 0; i < 1000 && ret == GST_FLOW_OK; i++) {
+    ret = gst_harness_push (h, gst_harness_create_buffer (h, 100));
+    if (ret == GST_FLOW_OK)
+      g_usleep (G_USEC_PER_SEC / 1000);
+  }
+  fail_unless_equals_int (GST_FLOW_EOS, ret);
+
+  gst_harness_teardown (h);
+}
+
+GST_END_TEST;
+
 static Suite *
 netsim_suite (void)
 {
@@ -60,6 +238,12 @@ netsim_suite (void)
   suite_add_tcase (s, (tc_chain = tcase_create ("general")));
   tcase_add_test (tc_chain, netsim_stress);
   tcase_add_test (tc_chain, netsim_stress_delayed);
+  tcase_add_test (tc_chain, netsim_link_serialization);
+  tcase_add_test (tc_chain, netsim_link_queue_drop);
+  tcase_add_test (tc_chain, netsim_burst_loss);
+  tcase_add_test (tc_chain, netsim_events_behind_packets);
+  tcase_add_test (tc_chain, netsim_flush);
+  tcase_add_test (tc_chain, netsim_delayed_flow_return);
 
   return s;
 }
@@ -1056,6 +1056,170 @@ GST_START_TEST (test_deext_seq_drop)
 
 GST_END_TEST;
 
+static void
+push_rtx_history (GstHarness * h, guint16 seqnum, guint n)
+{
+  guint i;
+
+  for (i = 0; i < n; i++) {
+    GstRTPBuffer rtp = GST_RTP_BUFFER_INIT;
+    GstBuffer *buf = alloc_ts_buffer (1);
+
+    gst_rtp_buffer_map (buf, GST_MAP_WRITE, &rtp);
+    gst_rtp_buffer_set_seq (&rtp, seqnum + i);
+    gst_rtp_buffer_set_timestamp (&rtp, (seqnum + i) * 90);
+    gst_rtp_buffer_unmap (&rtp);
+
+    gst_buffer_unref (gst_harness_push_and_pull (h, buf));
+  }
+}
+
+static void
+request_rtx (GstHarness * h, guint seqnum, guint count)
+{
+  fail_unless (gst_harness_push_upstream_event (h,
+          gst_event_new_custom (GST_EVENT_CUSTOM_UPSTREAM,
+              gst_structure_new ("GstRTPRetransmissionRequest",
+                  "seqnum", G_TYPE_UINT, seqnum,
+                  "count", G_TYPE_UINT, count,
+                  "ssrc", G_TYPE_UINT, 12, NULL))));
+}
+
+static void
+pull_rtx (GstHarness * h, guint16 seqnum)
+{
+  GstRTPBuffer rtp = GST_RTP_BUFFER_INIT;
+  GstBuffer *buf = gst_harness_pull (h);
+
+  gst_rtp_buffer_map (buf, GST_MAP_READ, &rtp);
+  fail_unless_equals_int (gst_rtp_buffer_get_seq (&rtp), seqnum);
+  fail_unless_equals_int (gst_rtp_buffer_get_ssrc (&rtp), 13);
+  gst_rtp_buffer_unmap (&rtp);
+  gst_buffer_unref (buf);
+}
+
+static void
+check_rtx_stats (GstHarness * h, guint hits, guint misses, guint late)
+{
+  guint num_hits, num_misses, num_late;
+
+  g_object_get (h->element, "num-rtx-hits", &num_hits, "num-rtx-misses",
+      &num_misses, "num-rtx-late", &num_late, NULL);
+  fail_unless_equals_int (num_hits, hits);
+  fail_unless_equals_int (num_misses, misses);
+  fail_unless_equals_int (num_late, late);
+}
+
+GST_START_TEST (test_rtxsend_range)
+{
+  GstHarness *h = gst_harness_new ("ristrtxsend");
+  guint num_packets;
+
+  gst_harness_set_src_caps_str (h, "application/x-rtp, payload=33,"
+      "clock-rate=90000, encoding-name=MP2T, ssrc=(uint)12");
+
+  /* The range goes over the seqnum wraparound */
+  push_rtx_history (h, 65530, 12);
+  request_rtx (h, 65534, 4);
+
+  pull_rtx (h, 65534);
+  pull_rtx (h, 65535);
+  pull_rtx (h, 0);
+  pull_rtx (h, 1);
+
+  check_rtx_stats (h, 4, 0, 0);
+  g_object_get (h->element, "num-rtx-packets", &num_packets, NULL);
+  fail_unless_equals_int (num_packets, 4);
+
+  gst_harness_teardown (h);
+}
+
+GST_END_TEST;
+
+GST_START_TEST (test_rtxsend_late_and_missing)
+{
+  GstHarness *h = gst_harness_new ("ristrtxsend");
+
+  g_object_set (h->element, "max-size-packets", 5, NULL);
+  gst_harness_set_src_caps_str (h, "application/x-rtp, payload=33,"
+      "clock-rate=90000, encoding-name=MP2T, ssrc=(uint)12");
+
+  push_rtx_history (h, 100, 10);
+
+  request_rtx (h, 102, 1);
+  check_rtx_stats (h, 0, 0, 1);
+
+  request_rtx (h, 120, 1);
+  check_rtx_stats (h, 0, 1, 1);
+
+  /* 108 and 109 are there, 110 and 111 are not sent yet */
+  request_rtx (h, 108, 4);
+  check_rtx_stats (h, 2, 3, 1);
+
+  pull_rtx (h, 108);
+  pull_rtx (h, 109);
+  fail_unless_equals_int (gst_harness_buffers_in_queue (h), 0);
+
+  gst_harness_teardown (h);
+}
+
+GST_END_TEST;
+
+GST_START_TEST (test_rtxsend_seqnum_gap)
+{
+  GstHarness *h = gst_harness_new ("ristrtxsend");
+
+  g_object_set (h->element, "max-size-packets", 8, NULL);
+  gst_harness_set_src_caps_str (h, "application/x-rtp, payload=33,"
+      "clock-rate=90000, encoding-name=MP2T, ssrc=(uint)12");
+
+  /* 105 to 109 are lost, they don't count in the 8 packets kept, which are
+   * 102 to 104 and 110 to 114 */
+  push_rtx_history (h, 100, 5);
+  push_rtx_history (h, 110, 5);
+
+  request_rtx (h, 101, 1);
+  check_rtx_stats (h, 0, 0, 1);
+
+  request_rtx (h, 102, 1);
+  check_rtx_stats (h, 1, 0, 1);
+  pull_rtx (h, 102);
+
+  request_rtx (h, 104, 7);
+  check_rtx_stats (h, 3, 5, 1);
+  pull_rtx (h, 104);
+  pull_rtx (h, 110);
+  fail_unless_equals_int (gst_harness_buffers_in_queue (h), 0);
+
+  gst_harness_teardown (h);
+}
+
+GST_END_TEST;
+
+GST_START_TEST (test_rtxsend_max_size_time)
+{
+  GstHarness *h = gst_harness_new ("ristrtxsend");
+
+  g_object_set (h->element, "max-size-packets", 0, "max-size-time", 500,
+      NULL);
+  gst_harness_set_src_caps_str (h, "application/x-rtp, payload=33,"
+      "clock-rate=90000, encoding-name=MP2T, ssrc=(uint)12");
+
+  /* One packet per ms, more than the initial size of the history */
+  push_rtx_history (h, 0, 1000);
+
+  request_rtx (h, 400, 1);
+  check_rtx_stats (h, 0, 0, 1);
+
+  request_rtx (h, 500, 1);
+  check_rtx_stats (h, 1, 0, 1);
+  pull_rtx (h, 500);
+
+  gst_harness_teardown (h);
+}
+
+GST_END_TEST;
+
 static Suite *
 ristrtpext_suite (void)
 {
@@ -1097,6 +1261,14 @@ ristrtpext_suite (void)
   tcase_add_test (tc, test_deext_seq_base);
   tcase_add_test (tc, test_deext_seq_drop);
 
+  tc = tcase_create ("rtxsend");
+  suite_add_tcase (s, tc);
+
+  tcase_add_test (tc, test_rtxsend_range);
+  tcase_add_test (tc, test_rtxsend_late_and_missing);
+  tcase_add_test (tc, test_rtxsend_seqnum_gap);
+  tcase_add_test (tc, test_rtxsend_max_size_time);
+
   return s;
 }
 
@@ -0,0 +1,259 @@
+/* GStreamer
+ *
+ * unit test for rtmp2serversrc
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin St, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#include <gst/check/gstcheck.h>
+#include <gst/check/gstharness.h>
+
+#include <string.h>
+
+#define FLV_HEADER_SIZE 13
+#define TAG_HEADER_SIZE 11
+#define N_MESSAGES 30
+/* The AAC sequence header sent in the middle of the stream */
+#define SEQUENCE_HEADER 20
+
+typedef struct
+{
+  GstElement *pipeline;
+  GstElement *server;
+  GstElement *sink;
+  GAsyncQueue *buffers;
+  gboolean block;
+  gulong block_id;
+  GstPad *pad;
+  GstHarness *publisher;
+} ServerTest;
+
+static void
+on_handoff (GstElement * sink, GstBuffer * buffer, GstPad * pad,
+    ServerTest * t)
+{
+  g_async_queue_push (t->buffers, gst_buffer_ref (buffer));
+}
+
+static GstPadProbeReturn
+on_blocked (GstPad * pad, GstPadProbeInfo * info, gpointer user_data)
+{
+  return GST_PAD_PROBE_OK;
+}
+
+static void
+on_pad_added (GstElement * server, GstPad * pad, ServerTest * t)
+{
+  GstPad *sinkpad = gst_element_get_static_pad (t->sink, "sink");
+
+  fail_unless_equals_string (GST_PAD_NAME (pad), "src_cam1");
+  if (t->block)
+    t->block_id = gst_pad_add_probe (pad,
+        GST_PAD_PROBE_TYPE_BLOCK | GST_PAD_PROBE_TYPE_BUFFER, on_blocked, NULL,
+        NULL);
+  t->pad = gst_object_ref (pad);
+  fail_unless_equals_int (gst_pad_link (pad, sinkpad), GST_PAD_LINK_OK);
+  gst_object_unref (sinkpad);
+}
+
+static void
+server_test_setup (ServerTest * t, guint max_size_bytes, gboolean block)
+{
+  gchar *desc;
+  gint port;
+
+  memset (t, 0, sizeof (ServerTest));
+  t->buffers = g_async_queue_new_full ((GDestroyNotify) gst_buffer_unref);
+  t->block = block;
+
+  t->pipeline = gst_pipeline_new (NULL);
+  t->server = gst_element_factory_make ("rtmp2serversrc", NULL);
+  t->sink = gst_element_factory_make ("fakesink", NULL);
+  fail_unless (t->server != NULL && t->sink != NULL);
+  g_object_set (t->server, "host", "127.0.0.1", "port", 0, "application",
+      "live", "max-size-bytes", max_size_bytes, NULL);
+  g_object_set (t->sink, "sync", FALSE, "signal-handoffs", TRUE, NULL);
+  g_signal_connect (t->sink, "handoff", G_CALLBACK (on_handoff), t);
+  g_signal_connect (t->server, "pad-added", G_CALLBACK (on_pad_added), t);
+  gst_bin_add_many (GST_BIN (t->pipeline), t->server, t->sink, NULL);
+
+  fail_unless (gst_element_set_state (t->pipeline, GST_STATE_PLAYING) !=
+      GST_STATE_CHANGE_FAILURE);
+  g_object_get (t->server, "current-port", &port, NULL);
+  fail_unless (port > 0);
+
+  desc = g_strdup_printf ("rtmp2sink location=rtmp://127.0.0.1:%d/live/cam1",
+      port);
+  t->publisher = gst_harness_new_parse (desc);
+  g_free (desc);
+  gst_harness_set_src_caps_str (t->publisher, "video/x-flv");
+}
+
+static void
+server_test_teardown (ServerTest * t)
+{
+  if (t->publisher)
+    gst_harness_teardown (t->publisher);
+  gst_element_set_state (t->pipeline, GST_STATE_NULL);
+  gst_object_unref (t->pipeline);
+  gst_clear_object (&t->pad);
+  g_async_queue_unref (t->buffers);
+}
+
+/* An FLV tag with an AAC frame, or the AAC sequence header, carrying its
+ * index */
+static GstBuffer *
+audio_tag_new (guint8 index, gboolean sequence_header)
+{
+  guint8 *data = g_malloc0 (TAG_HEADER_SIZE + 3 + 4);
+
+  data[0] = 8;
+  GST_WRITE_UINT24_BE (data + 1, 3);
+  GST_WRITE_UINT24_BE (data + 4, index * 20);
+  data[11] = 0xaf;
+  data[12] = sequence_header ? 0 : 1;
+  data[13] = index;
+  GST_WRITE_UINT32_BE (data + 14, TAG_HEADER_SIZE + 3);
+
+  return gst_buffer_new_wrapped (data, TAG_HEADER_SIZE + 3 + 4);
+}
+
+static void
+publish (ServerTest * t)
+{
+  guint i;
+
+  for (i = 0; i < N_MESSAGES; i++)
+    fail_unless_equals_int (gst_harness_push (t->publisher,
+            audio_tag_new (i, i == SEQUENCE_HEADER)), GST_FLOW_OK);
+}
+
+/* Returns the index the received tag carries */
+static guint8
+pop_tag (ServerTest * t, gboolean first, GstBuffer ** buffer)
+{
+  gsize offset = first ? FLV_HEADER_SIZE : 0;
+  guint8 tag[TAG_HEADER_SIZE + 3];
+
+  *buffer = g_async_queue_timeout_pop (t->buffers, 10 * G_USEC_PER_SEC);
+  fail_unless (*buffer != NULL);
+  fail_unless_equals_int (gst_buffer_get_size (*buffer),
+      offset + TAG_HEADER_SIZE + 3 + 4);
+  if (first)
+    fail_unless (gst_buffer_memcmp (*buffer, 0, "FLV", 3) == 0);
+  gst_buffer_extract (*buffer, offset, tag, sizeof tag);
+  fail_unless_equals_int (tag[0], 8);
+  fail_unless_equals_int (tag[11], 0xaf);
+
+  return tag[13];
+}
+
+static void
+wait_for_messages (ServerTest * t, guint64 * queued, guint64 * dropped)
+{
+  gint64 end_time = g_get_monotonic_time () + 10 * G_USEC_PER_SEC;
+  GstStructure *stats;
+
+  do {
+    g_object_get (t->server, "stats", &stats, NULL);
+    fail_unless (gst_structure_get_uint64 (stats, "messages-queued", queued));
+    fail_unless (gst_structure_get_uint64 (stats, "messages-dropped",
+            dropped));
+    gst_structure_free (stats);
+    if (*queued + *dropped >= N_MESSAGES)
+      return;
+    g_usleep (G_USEC_PER_SEC / 100);
+  } while (g_get_monotonic_time () < end_time);
+
+  fail ("Only %" G_GUINT64_FORMAT " of %d messages arrived",
+      *queued + *dropped, N_MESSAGES);
+}
+
+GST_START_TEST (test_server_publish)
+{
+  ServerTest t;
+  GstBuffer *buffer;
+  guint64 queued, dropped;
+  guint i;
+
+  server_test_setup (&t, 0, FALSE);
+  publish (&t);
+
+  for (i = 0; i < N_MESSAGES; i++) {
+    fail_unless_equals_int (pop_tag (&t, i == 0, &buffer), i);
+    fail_if (GST_BUFFER_FLAG_IS_SET (buffer, GST_BUFFER_FLAG_DISCONT));
+    gst_buffer_unref (buffer);
+  }
+
+  wait_for_messages (&t, &queued, &dropped);
+  fail_unless_equals_uint64 (queued, N_MESSAGES);
+  fail_unless_equals_uint64 (dropped, 0);
+
+  server_test_teardown (&t);
+}
+
+GST_END_TEST;
+
+GST_START_TEST (test_server_max_size_bytes)
+{
+  ServerTest t;
+  GstBuffer *buffer;
+  guint64 queued, dropped;
+  guint received = 1, index;
+
+  /* Downstream is stuck, so anything waiting for it fills the queue */
+  server_test_setup (&t, 1, TRUE);
+  publish (&t);
+  wait_for_messages (&t, &queued, &dropped);
+  fail_unless (dropped > 0);
+  fail_unless_equals_uint64 (queued + dropped, N_MESSAGES);
+
+  gst_pad_remove_probe (t.pad, t.block_id);
+
+  /* The first tag may have been pushed before the next one was queued, the
+   * sequence header is kept and marks the gap */
+  fail_unless_equals_int (pop_tag (&t, TRUE, &buffer), 0);
+  gst_buffer_unref (buffer);
+  do {
+    index = pop_tag (&t, FALSE, &buffer);
+    received++;
+    if (index == SEQUENCE_HEADER)
+      fail_unless (GST_BUFFER_FLAG_IS_SET (buffer, GST_BUFFER_FLAG_DISCONT));
+    gst_buffer_unref (buffer);
+  } while (index != SEQUENCE_HEADER);
+
+  fail_unless_equals_uint64 (received, queued);
+  fail_if (g_async_queue_timeout_pop (t.buffers, G_USEC_PER_SEC / 10));
+
+  server_test_teardown (&t);
+}
+
+GST_END_TEST;
+
+static Suite *
+rtmp2_suite (void)
+{
+  Suite *s = suite_create ("rtmp2");
+  TCase *tc_chain = tcase_create ("general");
+
+  suite_add_tcase (s, tc_chain);
+  tcase_add_test (tc_chain, test_server_publish);
+  tcase_add_test (tc_chain, test_server_max_size_bytes);
+
+  return s;
+}
+
+GST_CHECK_MAIN (rtmp2);
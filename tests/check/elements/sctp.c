@@ -0,0 +1,420 @@
+/* GStreamer
+ *
+ * unit test for sctpenc and sctpdec
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin St, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#include <gst/check/gstcheck.h>
+
+#include <string.h>
+
+#define SCTP_PORT 5000
+#define N_MESSAGES 64
+#define N_ASSOCIATIONS 2
+
+typedef struct
+{
+  gulong block_id;
+  guint n_received;
+  guint n_buffers;
+  guint n_lists;
+  gboolean in_order;
+} Receiver;
+
+typedef struct
+{
+  GMutex lock;
+  GCond cond;
+  GstElement *pipeline;
+  GstElement *senders[N_ASSOCIATIONS];
+  GstPad *receiver_pads[N_ASSOCIATIONS];
+  Receiver receivers[N_ASSOCIATIONS];
+  guint n_established;
+  guint n_blocked;
+  /* Packets pushed by sctpenc as buffers instead of buffer lists */
+  guint n_packet_buffers;
+  gboolean block_first;
+} SctpTest;
+
+static void
+on_established (GstElement * sctpenc, gboolean established, SctpTest * t)
+{
+  if (!established)
+    return;
+
+  g_mutex_lock (&t->lock);
+  t->n_established++;
+  g_cond_broadcast (&t->cond);
+  g_mutex_unlock (&t->lock);
+}
+
+static GstPadProbeReturn
+on_packet (GstPad * pad, GstPadProbeInfo * info, SctpTest * t)
+{
+  if (info->type & GST_PAD_PROBE_TYPE_BUFFER) {
+    g_mutex_lock (&t->lock);
+    t->n_packet_buffers++;
+    g_mutex_unlock (&t->lock);
+  }
+
+  return GST_PAD_PROBE_OK;
+}
+
+/* Every message carries its index */
+static gboolean
+check_message (GstBuffer ** buffer, guint idx, Receiver * r)
+{
+  guint32 n = G_MAXUINT32;
+
+  gst_buffer_extract (*buffer, 0, &n, sizeof (n));
+  if (n != r->n_received)
+    r->in_order = FALSE;
+  r->n_received++;
+
+  return TRUE;
+}
+
+static GstPadProbeReturn
+on_message (GstPad * pad, GstPadProbeInfo * info, SctpTest * t)
+{
+  Receiver *r = g_object_get_data (G_OBJECT (GST_PAD_PARENT (pad)),
+      "receiver");
+
+  g_mutex_lock (&t->lock);
+  if (info->type & GST_PAD_PROBE_TYPE_BUFFER_LIST) {
+    r->n_lists++;
+    gst_buffer_list_foreach (GST_PAD_PROBE_INFO_BUFFER_LIST (info),
+        (GstBufferListFunc) check_message, r);
+  } else {
+    r->n_buffers++;
+    check_message (&GST_PAD_PROBE_INFO_BUFFER (info), 0, r);
+  }
+  g_cond_broadcast (&t->cond);
+  g_mutex_unlock (&t->lock);
+
+  /* There is no sink, the messages end here */
+  return GST_PAD_PROBE_DROP;
+}
+
+static GstPadProbeReturn
+on_blocked (GstPad * pad, GstPadProbeInfo * info, SctpTest * t)
+{
+  g_mutex_lock (&t->lock);
+  t->n_blocked++;
+  g_cond_broadcast (&t->cond);
+  g_mutex_unlock (&t->lock);
+
+  return GST_PAD_PROBE_OK;
+}
+
+static void
+on_pad_added (GstElement * sctpdec, GstPad * pad, SctpTest * t)
+{
+  Receiver *r = g_object_get_data (G_OBJECT (sctpdec), "receiver");
+
+  g_mutex_lock (&t->lock);
+  if (t->block_first && r == &t->receivers[0])
+    r->block_id = gst_pad_add_probe (pad,
+        GST_PAD_PROBE_TYPE_BLOCK | GST_PAD_PROBE_TYPE_BUFFER |
+        GST_PAD_PROBE_TYPE_BUFFER_LIST, (GstPadProbeCallback) on_blocked, t,
+        NULL);
+  t->receiver_pads[r - t->receivers] = gst_object_ref (pad);
+  g_mutex_unlock (&t->lock);
+
+  gst_pad_add_probe (pad,
+      GST_PAD_PROBE_TYPE_BUFFER | GST_PAD_PROBE_TYPE_BUFFER_LIST,
+      (GstPadProbeCallback) on_message, t, NULL);
+}
+
+static GstElement *
+add_endpoint (SctpTest * t, const gchar * factory, guint association_id)
+{
+  GstElement *element = gst_element_factory_make (factory, NULL);
+
+  fail_unless (element != NULL);
+  g_object_set (element, "sctp-association-id", association_id,
+      "shared-worker", TRUE, NULL);
+  if (g_str_equal (factory, "sctpenc"))
+    g_object_set (element, "remote-sctp-port", SCTP_PORT, NULL);
+  else
+    g_object_set (element, "local-sctp-port", SCTP_PORT, NULL);
+  gst_bin_add (GST_BIN (t->pipeline), element);
+
+  return element;
+}
+
+static gboolean
+wait_for (SctpTest * t, guint * counter, guint value)
+{
+  gint64 end_time = g_get_monotonic_time () + 10 * G_TIME_SPAN_SECOND;
+  gboolean ret;
+
+  g_mutex_lock (&t->lock);
+  while (*counter < value)
+    if (!g_cond_wait_until (&t->cond, &t->lock, end_time))
+      break;
+  ret = *counter >= value;
+  g_mutex_unlock (&t->lock);
+
+  return ret;
+}
+
+/* Connects pairs of sctpenc/sctpdec endpoints using the shared worker pool
+ * to each other and waits for the associations to be established. The
+ * receivers get the messages sent by the senders. */
+static void
+sctp_test_setup (SctpTest * t, gboolean block_first)
+{
+  GstElement *enc1, *dec1, *enc2, *dec2;
+  GstPad *pad;
+  guint a;
+
+  memset (t, 0, sizeof (SctpTest));
+  g_mutex_init (&t->lock);
+  g_cond_init (&t->cond);
+  t->block_first = block_first;
+  t->pipeline = gst_pipeline_new (NULL);
+
+  /* sctpdec only allows association ids up to 65535, use ids no other test
+   * uses as associations are global */
+  for (a = 0; a < N_ASSOCIATIONS; a++) {
+    enc1 = add_endpoint (t, "sctpenc", 60000 + 2 * a);
+    dec1 = add_endpoint (t, "sctpdec", 60000 + 2 * a);
+    enc2 = add_endpoint (t, "sctpenc", 60000 + 2 * a + 1);
+    dec2 = add_endpoint (t, "sctpdec", 60000 + 2 * a + 1);
+    fail_unless (gst_element_link (enc1, dec2));
+    fail_unless (gst_element_link (enc2, dec1));
+
+    g_signal_connect (enc1, "sctp-association-established",
+        G_CALLBACK (on_established), t);
+    g_signal_connect (enc2, "sctp-association-established",
+        G_CALLBACK (on_established), t);
+    t->receivers[a].in_order = TRUE;
+    g_object_set_data (G_OBJECT (dec2), "receiver", &t->receivers[a]);
+    g_signal_connect (dec2, "pad-added", G_CALLBACK (on_pad_added), t);
+
+    pad = gst_element_get_static_pad (enc1, "src");
+    gst_pad_add_probe (pad,
+        GST_PAD_PROBE_TYPE_BUFFER | GST_PAD_PROBE_TYPE_BUFFER_LIST,
+        (GstPadProbeCallback) on_packet, t, NULL);
+    gst_object_unref (pad);
+    t->senders[a] = enc1;
+  }
+
+  gst_element_set_state (t->pipeline, GST_STATE_PLAYING);
+  fail_unless (wait_for (t, &t->n_established, 2 * N_ASSOCIATIONS));
+}
+
+static void
+sctp_test_teardown (SctpTest * t)
+{
+  guint a;
+
+  gst_element_set_state (t->pipeline, GST_STATE_NULL);
+  gst_object_unref (t->pipeline);
+  for (a = 0; a < N_ASSOCIATIONS; a++)
+    gst_clear_object (&t->receiver_pads[a]);
+  g_cond_clear (&t->cond);
+  g_mutex_clear (&t->lock);
+}
+
+/* Sends the messages @first to @first + N_MESSAGES - 1 */
+static void
+send_more_messages (GstElement * sctpenc, guint32 first)
+{
+  GstBufferList *list = gst_buffer_list_new_sized (N_MESSAGES);
+  GstFlowReturn ret;
+  guint32 i;
+
+  for (i = first; i < first + N_MESSAGES; i++)
+    gst_buffer_list_add (list, gst_buffer_new_memdup (&i, sizeof (i)));
+
+  g_signal_emit_by_name (sctpenc, "send-buffer-list", 0, list, FALSE, &ret);
+  gst_buffer_list_unref (list);
+  fail_unless_equals_int (ret, GST_FLOW_OK);
+}
+
+static void
+send_messages (GstElement * sctpenc)
+{
+  GstPad *pad;
+
+  pad = gst_element_request_pad_simple (sctpenc, "sink_0");
+  fail_unless (pad != NULL);
+  gst_object_unref (pad);
+
+  send_more_messages (sctpenc, 0);
+}
+
+/* The workers hold a ref on the object they push from while they run,
+ * wait for them to be done with it */
+static gboolean
+wait_for_refcount (gpointer object, gint refcount)
+{
+  gint64 end_time = g_get_monotonic_time () + 10 * G_TIME_SPAN_SECOND;
+
+  while (GST_OBJECT_REFCOUNT_VALUE (object) != refcount) {
+    if (GST_OBJECT_REFCOUNT_VALUE (object) < refcount
+        || g_get_monotonic_time () > end_time)
+      return FALSE;
+    g_usleep (G_USEC_PER_SEC / 100);
+  }
+
+  return TRUE;
+}
+
+GST_START_TEST (test_shared_worker_batched)
+{
+  SctpTest t;
+  guint a;
+
+  sctp_test_setup (&t, FALSE);
+
+  for (a = 0; a < N_ASSOCIATIONS; a++)
+    send_messages (t.senders[a]);
+
+  for (a = 0; a < N_ASSOCIATIONS; a++) {
+    Receiver *r = &t.receivers[a];
+
+    fail_unless (wait_for (&t, &r->n_received, N_MESSAGES));
+    g_mutex_lock (&t.lock);
+    fail_unless_equals_int (r->n_received, N_MESSAGES);
+    fail_unless (r->in_order);
+    /* the workers only push buffer lists */
+    fail_unless_equals_int (r->n_buffers, 0);
+    fail_unless (r->n_lists > 0 && r->n_lists <= N_MESSAGES);
+    g_mutex_unlock (&t.lock);
+  }
+
+  g_mutex_lock (&t.lock);
+  fail_unless_equals_int (t.n_packet_buffers, 0);
+  g_mutex_unlock (&t.lock);
+
+  sctp_test_teardown (&t);
+}
+
+GST_END_TEST;
+
+GST_START_TEST (test_shared_worker_blocked_downstream)
+{
+  SctpTest t;
+  Receiver *blocked, *other;
+  guint a;
+
+  /* Downstream of the first association blocks, which must not keep the
+   * other association from getting its messages */
+  sctp_test_setup (&t, TRUE);
+  blocked = &t.receivers[0];
+  other = &t.receivers[1];
+
+  for (a = 0; a < N_ASSOCIATIONS; a++)
+    send_messages (t.senders[a]);
+
+  fail_unless (wait_for (&t, &t.n_blocked, 1));
+  fail_unless (wait_for (&t, &other->n_received, N_MESSAGES));
+  g_mutex_lock (&t.lock);
+  fail_unless (other->in_order);
+  fail_unless_equals_int (blocked->n_received, 0);
+  g_mutex_unlock (&t.lock);
+
+  /* Everything received meanwhile comes out in order once unblocked, in
+   * fewer lists than messages */
+  gst_pad_remove_probe (t.receiver_pads[0], blocked->block_id);
+  fail_unless (wait_for (&t, &blocked->n_received, N_MESSAGES));
+  g_mutex_lock (&t.lock);
+  fail_unless (blocked->in_order);
+  fail_unless_equals_int (blocked->n_buffers, 0);
+  fail_unless (blocked->n_lists < N_MESSAGES);
+  g_mutex_unlock (&t.lock);
+
+  sctp_test_teardown (&t);
+}
+
+GST_END_TEST;
+
+#define N_ROUNDS 50
+
+GST_START_TEST (test_shared_worker_refcounts)
+{
+  SctpTest t;
+  gint sender_refcounts[N_ASSOCIATIONS], pad_refcounts[N_ASSOCIATIONS];
+  guint a, round;
+
+  sctp_test_setup (&t, FALSE);
+
+  /* The receiving pads only exist once the first messages arrived */
+  for (a = 0; a < N_ASSOCIATIONS; a++)
+    send_messages (t.senders[a]);
+  for (a = 0; a < N_ASSOCIATIONS; a++)
+    fail_unless (wait_for (&t, &t.receivers[a].n_received, N_MESSAGES));
+  g_usleep (G_USEC_PER_SEC / 10);
+  for (a = 0; a < N_ASSOCIATIONS; a++) {
+    sender_refcounts[a] = GST_OBJECT_REFCOUNT_VALUE (t.senders[a]);
+    pad_refcounts[a] = GST_OBJECT_REFCOUNT_VALUE (t.receiver_pads[a]);
+  }
+
+  /* Every round schedules the batches of the senders and the receiving
+   * pads again */
+  for (round = 1; round <= N_ROUNDS; round++) {
+    for (a = 0; a < N_ASSOCIATIONS; a++)
+      send_more_messages (t.senders[a], round * N_MESSAGES);
+  }
+
+  for (a = 0; a < N_ASSOCIATIONS; a++) {
+    Receiver *r = &t.receivers[a];
+
+    fail_unless (wait_for (&t, &r->n_received, (N_ROUNDS + 1) * N_MESSAGES));
+    g_mutex_lock (&t.lock);
+    fail_unless (r->in_order);
+    g_mutex_unlock (&t.lock);
+
+    fail_unless (wait_for_refcount (t.senders[a], sender_refcounts[a]),
+        "sctpenc has %d refs instead of %d",
+        GST_OBJECT_REFCOUNT_VALUE (t.senders[a]), sender_refcounts[a]);
+    fail_unless (wait_for_refcount (t.receiver_pads[a], pad_refcounts[a]),
+        "sctpdec pad has %d refs instead of %d",
+        GST_OBJECT_REFCOUNT_VALUE (t.receiver_pads[a]), pad_refcounts[a]);
+  }
+
+  /* Only the pipeline and the test hold refs after shutting down */
+  gst_element_set_state (t.pipeline, GST_STATE_NULL);
+  ASSERT_OBJECT_REFCOUNT (t.pipeline, "pipeline", 1);
+  for (a = 0; a < N_ASSOCIATIONS; a++) {
+    fail_unless (wait_for_refcount (t.senders[a], 1));
+    fail_unless (wait_for_refcount (t.receiver_pads[a], 1));
+  }
+
+  sctp_test_teardown (&t);
+}
+
+GST_END_TEST;
+
+static Suite *
+sctp_suite (void)
+{
+  Suite *s = suite_create ("sctp");
+  TCase *tc_chain = tcase_create ("general");
+
+  suite_add_tcase (s, tc_chain);
+  tcase_add_test (tc_chain, test_shared_worker_batched);
+  tcase_add_test (tc_chain, test_shared_worker_blocked_downstream);
+  tcase_add_test (tc_chain, test_shared_worker_refcounts);
+
+  return s;
+}
+
+GST_CHECK_MAIN (sctp);
@@ -42,7 +42,7 @@ GstElement *src, *sink;
 GstPad *sinkpad, *srcpad;
 
 static void
-setup_shm (void)
+setup_shm_with_ring_size (guint ring_size)
 {
   gchar *socket_path = NULL;
 
@@ -52,7 +52,8 @@ setup_shm (void)
   srcpad = gst_check_setup_src_pad (sink, &src_template);
   sinkpad = gst_check_setup_sink_pad (src, &sink_template);
 
-  g_object_set (sink, "socket-path", "shm-unit-test", NULL);
+  g_object_set (sink, "socket-path", "shm-unit-test", "ring-size", ring_size,
+      NULL);
 
   fail_unless (gst_element_set_state (sink, GST_STATE_PLAYING) ==
       GST_STATE_CHANGE_ASYNC);
@@ -69,6 +70,19 @@ setup_shm (void)
       GST_STATE_CHANGE_SUCCESS);
 }
 
+static void
+setup_shm (void)
+{
+  setup_shm_with_ring_size (0);
+}
+
+static void
+setup_shm_ring (void)
+{
+  /* a single buffer fills the ring */
+  setup_shm_with_ring_size (1);
+}
+
 static void
 teardown_shm (void)
 {
@@ -169,6 +183,130 @@ GST_START_TEST (test_shm_alloc)
 
 GST_END_TEST;
 
+static void
+push_start_events (void)
+{
+  GstSegment segment;
+
+  gst_pad_push_event (srcpad, gst_event_new_stream_start ("test"));
+  gst_segment_init (&segment, GST_FORMAT_BYTES);
+  gst_pad_push_event (srcpad, gst_event_new_segment (&segment));
+}
+
+/* Pushes a buffer of @size bytes all set to @value */
+static void
+push_filled_buffer (gsize size, guint8 value)
+{
+  GstBuffer *buf = gst_buffer_new_allocate (NULL, size, NULL);
+
+  gst_buffer_memset (buf, 0, value, size);
+  fail_unless (gst_pad_push (srcpad, buf) == GST_FLOW_OK);
+}
+
+static void
+wait_for_buffers (guint n_buffers)
+{
+  g_mutex_lock (&check_mutex);
+  while (g_list_length (buffers) < n_buffers)
+    g_cond_wait (&check_cond, &check_mutex);
+  g_mutex_unlock (&check_mutex);
+}
+
+static void
+check_filled_buffers (gsize size, guint n_buffers)
+{
+  GList *l;
+  guint8 i = 0;
+
+  fail_unless_equals_int (g_list_length (buffers), n_buffers);
+  for (l = buffers; l; l = l->next, i++) {
+    GstBuffer *buf = l->data;
+    GstMapInfo map;
+    gsize j;
+
+    fail_unless_equals_int (gst_buffer_get_size (buf), size);
+    gst_buffer_map (buf, &map, GST_MAP_READ);
+    for (j = 0; j < size; j++)
+      fail_unless_equals_int (map.data[j], i);
+    gst_buffer_unmap (buf, &map);
+  }
+}
+
+GST_START_TEST (test_shm_resize)
+{
+  guint size;
+
+  push_start_events ();
+  push_filled_buffer (1000, 0);
+  wait_for_buffers (1);
+
+  /* The buffers copied into the new area must reach the client, the old
+   * area is closed on its side once its buffer is released */
+  g_object_get (sink, "shm-size", &size, NULL);
+  g_object_set (sink, "shm-size", size * 2, NULL);
+  push_filled_buffer (1000, 1);
+  g_object_set (sink, "shm-size", size, NULL);
+  push_filled_buffer (1000, 2);
+  wait_for_buffers (3);
+  check_filled_buffers (1000, 3);
+
+  gst_check_drop_buffers ();
+  teardown_shm ();
+}
+
+GST_END_TEST;
+
+static GstPadProbeReturn
+on_src_blocked (GstPad * pad, GstPadProbeInfo * info, gboolean * blocked)
+{
+  g_mutex_lock (&check_mutex);
+  *blocked = TRUE;
+  g_cond_broadcast (&check_cond);
+  g_mutex_unlock (&check_mutex);
+
+  return GST_PAD_PROBE_OK;
+}
+
+GST_START_TEST (test_shm_resize_ring_full)
+{
+  GstPad *pad;
+  gboolean blocked = FALSE;
+  gulong probe_id;
+  guint size;
+
+  pad = gst_element_get_static_pad (src, "src");
+  probe_id = gst_pad_add_probe (pad,
+      GST_PAD_PROBE_TYPE_BLOCK | GST_PAD_PROBE_TYPE_BUFFER,
+      (GstPadProbeCallback) on_src_blocked, &blocked, NULL);
+
+  /* shmsrc holds the first buffer, the second one fills the ring */
+  push_start_events ();
+  push_filled_buffer (1000, 0);
+  g_mutex_lock (&check_mutex);
+  while (!blocked)
+    g_cond_wait (&check_cond, &check_mutex);
+  g_mutex_unlock (&check_mutex);
+  push_filled_buffer (1000, 1);
+
+  /* The close of the old area waits for space in the ring, the new area
+   * must still be announced */
+  g_object_get (sink, "shm-size", &size, NULL);
+  g_object_set (sink, "shm-size", size * 2, NULL);
+
+  gst_pad_remove_probe (pad, probe_id);
+  gst_object_unref (pad);
+
+  push_filled_buffer (1000, 2);
+  push_filled_buffer (1000, 3);
+  wait_for_buffers (4);
+  check_filled_buffers (1000, 4);
+
+  gst_check_drop_buffers ();
+  teardown_shm ();
+}
+
+GST_END_TEST;
+
 GST_START_TEST (test_shm_live)
 {
   GstElement *producer, *consumer;
@@ -239,6 +377,12 @@ shm_suite (void)
   tcase_add_checked_fixture (tc, setup_shm, NULL);
   tcase_add_test (tc, test_shm_sysmem_alloc);
   tcase_add_test (tc, test_shm_alloc);
+  tcase_add_test (tc, test_shm_resize);
+  suite_add_tcase (s, tc);
+
+  tc = tcase_create ("shm-ring");
+  tcase_add_checked_fixture (tc, setup_shm_ring, NULL);
+  tcase_add_test (tc, test_shm_resize_ring_full);
   suite_add_tcase (s, tc);
 
   tc = tcase_create ("shm2");
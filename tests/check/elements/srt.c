@@ -0,0 +1,312 @@
+/* GStreamer
+ *
+ * unit test for srtsink in listener mode
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin St, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#include <gst/check/gstcheck.h>
+#include <gst/check/gstharness.h>
+#include <gio/gio.h>
+
+#include <string.h>
+
+#define N_CALLERS 2
+#define N_MESSAGES 50
+#define MESSAGE_SIZE 1000
+#define CALLER_QUEUE_SIZE 16
+
+typedef struct
+{
+  GstElement *pipeline;
+  GAsyncQueue *buffers;
+} Receiver;
+
+typedef struct
+{
+  GMutex lock;
+  GCond cond;
+  GstHarness *sender;
+  Receiver receivers[N_CALLERS];
+  guint n_added;
+  guint n_removed;
+} SrtTest;
+
+static void
+on_caller_added (GstElement * sink, guint unused, GSocketAddress * addr,
+    SrtTest * t)
+{
+  g_mutex_lock (&t->lock);
+  t->n_added++;
+  g_cond_broadcast (&t->cond);
+  g_mutex_unlock (&t->lock);
+}
+
+static void
+on_caller_removed (GstElement * sink, guint unused, GSocketAddress * addr,
+    SrtTest * t)
+{
+  g_mutex_lock (&t->lock);
+  t->n_removed++;
+  g_cond_broadcast (&t->cond);
+  g_mutex_unlock (&t->lock);
+}
+
+static void
+on_handoff (GstElement * sink, GstBuffer * buffer, GstPad * pad, Receiver * r)
+{
+  g_async_queue_push (r->buffers, gst_buffer_ref (buffer));
+}
+
+static gboolean
+wait_for (SrtTest * t, guint * counter, guint value)
+{
+  gint64 end_time = g_get_monotonic_time () + 10 * G_TIME_SPAN_SECOND;
+  gboolean ret;
+
+  g_mutex_lock (&t->lock);
+  while (*counter < value)
+    if (!g_cond_wait_until (&t->cond, &t->lock, end_time))
+      break;
+  ret = *counter >= value;
+  g_mutex_unlock (&t->lock);
+
+  return ret;
+}
+
+/* Returns a UDP port nothing listens on right now */
+static guint
+get_free_port (void)
+{
+  GSocket *socket;
+  GInetAddress *inet;
+  GSocketAddress *addr, *bound;
+  guint port;
+
+  socket = g_socket_new (G_SOCKET_FAMILY_IPV4, G_SOCKET_TYPE_DATAGRAM,
+      G_SOCKET_PROTOCOL_UDP, NULL);
+  fail_unless (socket != NULL);
+  inet = g_inet_address_new_loopback (G_SOCKET_FAMILY_IPV4);
+  addr = g_inet_socket_address_new (inet, 0);
+  fail_unless (g_socket_bind (socket, addr, FALSE, NULL));
+  bound = g_socket_get_local_address (socket, NULL);
+  port = g_inet_socket_address_get_port (G_INET_SOCKET_ADDRESS (bound));
+
+  g_object_unref (bound);
+  g_object_unref (addr);
+  g_object_unref (inet);
+  g_socket_close (socket, NULL);
+  g_object_unref (socket);
+
+  return port;
+}
+
+/* Starts an srtsink listener queueing for each caller, and connects
+ * N_CALLERS srtsrc callers to it */
+static void
+srt_test_setup (SrtTest * t)
+{
+  guint port = get_free_port ();
+  gchar *desc;
+  guint i;
+
+  memset (t, 0, sizeof (SrtTest));
+  g_mutex_init (&t->lock);
+  g_cond_init (&t->cond);
+
+  desc = g_strdup_printf ("srtsink uri=srt://:%u?mode=listener "
+      "caller-queue-size=%u", port, CALLER_QUEUE_SIZE);
+  t->sender = gst_harness_new_parse (desc);
+  g_free (desc);
+  g_signal_connect (t->sender->element, "caller-added",
+      G_CALLBACK (on_caller_added), t);
+  g_signal_connect (t->sender->element, "caller-removed",
+      G_CALLBACK (on_caller_removed), t);
+  gst_harness_set_src_caps_str (t->sender, "application/x-test");
+
+  for (i = 0; i < N_CALLERS; i++) {
+    Receiver *r = &t->receivers[i];
+    GstElement *sink;
+
+    desc = g_strdup_printf ("srtsrc uri=srt://127.0.0.1:%u?mode=caller ! "
+        "fakesink name=sink sync=false signal-handoffs=true", port);
+    r->pipeline = gst_parse_launch (desc, NULL);
+    g_free (desc);
+    fail_unless (r->pipeline != NULL);
+
+    r->buffers = g_async_queue_new_full ((GDestroyNotify) gst_buffer_unref);
+    sink = gst_bin_get_by_name (GST_BIN (r->pipeline), "sink");
+    g_signal_connect (sink, "handoff", G_CALLBACK (on_handoff), r);
+    gst_object_unref (sink);
+
+    fail_unless (gst_element_set_state (r->pipeline, GST_STATE_PLAYING) !=
+        GST_STATE_CHANGE_FAILURE);
+  }
+
+  fail_unless (wait_for (t, &t->n_added, N_CALLERS));
+}
+
+static void
+srt_test_teardown (SrtTest * t)
+{
+  guint i;
+
+  for (i = 0; i < N_CALLERS; i++) {
+    Receiver *r = &t->receivers[i];
+
+    gst_element_set_state (r->pipeline, GST_STATE_NULL);
+    gst_object_unref (r->pipeline);
+    g_async_queue_unref (r->buffers);
+  }
+
+  gst_harness_teardown (t->sender);
+  g_cond_clear (&t->cond);
+  g_mutex_clear (&t->lock);
+}
+
+/* Every message carries its index */
+static void
+send_messages (SrtTest * t, guint first, guint n_messages)
+{
+  guint i;
+
+  for (i = first; i < first + n_messages; i++) {
+    GstBuffer *buffer = gst_buffer_new_allocate (NULL, MESSAGE_SIZE, NULL);
+
+    gst_buffer_memset (buffer, 0, i, MESSAGE_SIZE);
+    fail_unless_equals_int (gst_harness_push (t->sender, buffer), GST_FLOW_OK);
+    /* Keep the rate low enough for nothing to be dropped */
+    g_usleep (G_USEC_PER_SEC / 1000);
+  }
+}
+
+static void
+receive_messages (Receiver * r, guint first, guint n_messages)
+{
+  guint i;
+
+  for (i = first; i < first + n_messages; i++) {
+    GstBuffer *buffer = g_async_queue_timeout_pop (r->buffers,
+        10 * G_USEC_PER_SEC);
+    guint8 index;
+
+    fail_unless (buffer != NULL, "Message %u did not arrive", i);
+    fail_unless_equals_int (gst_buffer_get_size (buffer), MESSAGE_SIZE);
+    gst_buffer_extract (buffer, MESSAGE_SIZE - 1, &index, 1);
+    fail_unless_equals_int (index, i & 0xff);
+    gst_buffer_unref (buffer);
+  }
+}
+
+static guint
+check_caller_stats (SrtTest * t)
+{
+  GstStructure *stats;
+  const GValue *callers;
+  GValueArray *array;
+  guint i, n_callers;
+
+  g_object_get (t->sender->element, "stats", &stats, NULL);
+  callers = gst_structure_get_value (stats, "callers");
+  fail_unless (callers != NULL);
+
+  G_GNUC_BEGIN_IGNORE_DEPRECATIONS;
+  array = g_value_get_boxed (callers);
+  n_callers = array->n_values;
+  for (i = 0; i < n_callers; i++) {
+    const GstStructure *s =
+        gst_value_get_structure (g_value_array_get_nth (array, i));
+    guint64 dropped;
+
+    fail_unless (gst_structure_has_field (s, "send-queue-buffers"));
+    fail_unless (gst_structure_get_uint64 (s, "send-queue-dropped", &dropped));
+    fail_unless_equals_uint64 (dropped, 0);
+  }
+  G_GNUC_END_IGNORE_DEPRECATIONS;
+
+  gst_structure_free (stats);
+
+  return n_callers;
+}
+
+GST_START_TEST (test_listener_caller_queues)
+{
+  SrtTest t;
+  guint i;
+
+  srt_test_setup (&t);
+
+  send_messages (&t, 0, N_MESSAGES);
+  for (i = 0; i < N_CALLERS; i++)
+    receive_messages (&t.receivers[i], 0, N_MESSAGES);
+
+  fail_unless_equals_int (check_caller_stats (&t), N_CALLERS);
+
+  srt_test_teardown (&t);
+}
+
+GST_END_TEST;
+
+GST_START_TEST (test_listener_caller_leaves)
+{
+  SrtTest t;
+  gboolean removed = FALSE;
+  guint i;
+
+  srt_test_setup (&t);
+
+  send_messages (&t, 0, N_MESSAGES);
+  for (i = 0; i < N_CALLERS; i++)
+    receive_messages (&t.receivers[i], 0, N_MESSAGES);
+
+  /* The sender thread drops the caller that went away once sending to it
+   * fails, the other one keeps getting everything */
+  gst_element_set_state (t.receivers[0].pipeline, GST_STATE_NULL);
+  for (i = N_MESSAGES; i < 100 * N_MESSAGES && !removed; i++) {
+    send_messages (&t, i, 1);
+    receive_messages (&t.receivers[1], i, 1);
+
+    g_mutex_lock (&t.lock);
+    removed = t.n_removed > 0;
+    g_mutex_unlock (&t.lock);
+    g_usleep (G_USEC_PER_SEC / 100);
+  }
+  fail_unless (removed);
+
+  send_messages (&t, i, N_MESSAGES);
+  receive_messages (&t.receivers[1], i, N_MESSAGES);
+
+  fail_unless_equals_int (check_caller_stats (&t), N_CALLERS - 1);
+
+  srt_test_teardown (&t);
+}
+
+GST_END_TEST;
+
+static Suite *
+srt_suite (void)
+{
+  Suite *s = suite_create ("srt");
+  TCase *tc_chain = tcase_create ("general");
+
+  suite_add_tcase (s, tc_chain);
+  tcase_add_test (tc_chain, test_listener_caller_queues);
+  tcase_add_test (tc_chain, test_listener_caller_leaves);
+
+  return s;
+}
+
+GST_CHECK_MAIN (srt);
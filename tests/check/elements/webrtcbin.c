@@ -2321,6 +2321,110 @@ GST_START_TEST (test_data_channel_transfer_data)
 
 GST_END_TEST;
 
+#define N_DIRECT_MESSAGES 100
+
+static void
+on_direct_message_string (GObject * channel, const gchar * str,
+    struct test_webrtc *t)
+{
+  guint n = GPOINTER_TO_UINT (g_object_get_data (channel, "n-received"));
+  gchar *expected;
+
+  /* messages arrive in order, even though they are emitted in batches */
+  expected = g_strdup_printf ("%s %u", test_string, n);
+  g_assert_cmpstr (expected, ==, str);
+  g_free (expected);
+
+  g_object_set_data (channel, "n-received", GUINT_TO_POINTER (n + 1));
+  if (n + 1 == N_DIRECT_MESSAGES)
+    test_webrtc_signal_state (t, STATE_CUSTOM);
+}
+
+static void
+have_prepare_direct_data_channel (struct test_webrtc *t, GstElement * element,
+    GObject * data_channel, gboolean is_local, gpointer user_data)
+{
+  gboolean direct;
+
+  g_object_get (data_channel, "direct", &direct, NULL);
+  fail_unless (direct);
+
+  t->error_signal_handler_id =
+      g_signal_connect (data_channel, "on-error",
+      G_CALLBACK (on_channel_error_not_reached), NULL);
+  g_signal_connect (data_channel, "on-message-string",
+      G_CALLBACK (on_direct_message_string), t);
+}
+
+static void
+have_data_channel_transfer_direct (struct test_webrtc *t, GstElement * element,
+    GObject * our, gpointer user_data)
+{
+  GObject *other = user_data;
+  GstWebRTCDataChannelState state;
+  GError *error = NULL;
+  guint i;
+
+  g_object_get (our, "ready-state", &state, NULL);
+  fail_unless_equals_int (GST_WEBRTC_DATA_CHANNEL_STATE_OPEN, state);
+
+  /* sent in one go so that they get bundled */
+  for (i = 0; i < N_DIRECT_MESSAGES; i++) {
+    gchar *str = g_strdup_printf ("%s %u", test_string, i);
+
+    fail_unless (gst_webrtc_data_channel_send_string_full
+        (GST_WEBRTC_DATA_CHANNEL (other), str, &error));
+    g_assert_null (error);
+    g_free (str);
+  }
+}
+
+GST_START_TEST (test_data_channel_direct)
+{
+  struct test_webrtc *t = test_webrtc_new ();
+  GObject *channel = NULL;
+  gboolean direct;
+  VAL_SDP_INIT (media_count, _count_num_sdp_media, GUINT_TO_POINTER (1), NULL);
+  VAL_SDP_INIT (offer, on_sdp_has_datachannel, NULL, &media_count);
+
+  t->on_negotiation_needed = NULL;
+  t->on_ice_candidate = NULL;
+  t->on_prepare_data_channel = have_prepare_direct_data_channel;
+  t->on_data_channel = have_data_channel_transfer_direct;
+
+  g_object_set (t->webrtc1, "direct-data-channels", TRUE, NULL);
+  g_object_set (t->webrtc2, "direct-data-channels", TRUE, NULL);
+
+  fail_if (gst_element_set_state (t->webrtc1,
+          GST_STATE_READY) == GST_STATE_CHANGE_FAILURE);
+  fail_if (gst_element_set_state (t->webrtc2,
+          GST_STATE_READY) == GST_STATE_CHANGE_FAILURE);
+
+  g_signal_emit_by_name (t->webrtc1, "create-data-channel", "label", NULL,
+      &channel);
+  g_assert_nonnull (channel);
+  t->data_channel_data = channel;
+  g_signal_connect (channel, "on-error",
+      G_CALLBACK (on_channel_error_not_reached), NULL);
+
+  /* the mode can't change once a data channel exists */
+  g_object_set (t->webrtc1, "direct-data-channels", FALSE, NULL);
+  g_object_get (t->webrtc1, "direct-data-channels", &direct, NULL);
+  fail_unless (direct);
+
+  fail_if (gst_element_set_state (t->webrtc1,
+          GST_STATE_PLAYING) == GST_STATE_CHANGE_FAILURE);
+  fail_if (gst_element_set_state (t->webrtc2,
+          GST_STATE_PLAYING) == GST_STATE_CHANGE_FAILURE);
+
+  test_validate_sdp_full (t, &offer, &offer, 1 << STATE_CUSTOM, FALSE);
+
+  g_object_unref (channel);
+  test_webrtc_free (t);
+}
+
+GST_END_TEST;
+
 static void
 have_data_channel_create_data_channel (struct test_webrtc *t,
     GstElement * element, GObject * our, gpointer user_data)
@@ -5842,6 +5946,7 @@ webrtcbin_suite (void)
       tcase_add_test (tc, test_data_channel_remote_notify);
       tcase_add_test (tc, test_data_channel_transfer_string);
       tcase_add_test (tc, test_data_channel_transfer_data);
+      tcase_add_test (tc, test_data_channel_direct);
       tcase_add_test (tc, test_data_channel_create_after_negotiate);
       tcase_add_test (tc, test_data_channel_close);
       tcase_add_test (tc, test_data_channel_low_threshold);
@@ -0,0 +1,73 @@
+/* Gstreamer
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin St, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#include <gst/check/gstcheck.h>
+#include <gst/codecparsers/gstmpeg4parser.h>
+
+static const guint8 mpeg4_packets[] = {
+  /* visual object sequence start, profile and level */
+  0x00, 0x00, 0x01, 0xb0, 0x01,
+  /* leading garbage, then a visual object */
+  0xff, 0x00, 0x00, 0x01, 0xb5, 0x09,
+  /* video object plane, without a start code after it */
+  0x00, 0x00, 0x01, 0xb6, 0x10, 0x20, 0x30
+};
+
+GST_START_TEST (test_mpeg4_parse)
+{
+  GstMpeg4Packet packet;
+  GstMpeg4ParseResult res;
+  const guint8 *data = mpeg4_packets;
+  gsize size = sizeof (mpeg4_packets);
+
+  res = gst_mpeg4_parse (&packet, FALSE, NULL, data, 0, size);
+  assert_equals_int (res, GST_MPEG4_PARSER_OK);
+  assert_equals_int (packet.type, GST_MPEG4_VISUAL_OBJ_SEQ_START);
+  assert_equals_int (packet.offset, 3);
+  assert_equals_uint64 (packet.size, 3);
+
+  res = gst_mpeg4_parse (&packet, FALSE, NULL, data,
+      packet.offset + packet.size, size);
+  assert_equals_int (res, GST_MPEG4_PARSER_OK);
+  assert_equals_int (packet.type, GST_MPEG4_VISUAL_OBJ);
+  assert_equals_int (packet.offset, 9);
+  assert_equals_uint64 (packet.size, 2);
+
+  res = gst_mpeg4_parse (&packet, FALSE, NULL, data,
+      packet.offset + packet.size, size);
+  assert_equals_int (res, GST_MPEG4_PARSER_NO_PACKET_END);
+  assert_equals_int (packet.type, GST_MPEG4_VIDEO_OBJ_PLANE);
+  assert_equals_int (packet.offset, 14);
+}
+
+GST_END_TEST;
+
+static Suite *
+mpeg4parser_suite (void)
+{
+  Suite *s = suite_create ("MPEG-4 Parser library");
+
+  TCase *tc_chain = tcase_create ("general");
+
+  suite_add_tcase (s, tc_chain);
+  tcase_add_test (tc_chain, test_mpeg4_parse);
+
+  return s;
+}
+
+GST_CHECK_MAIN (mpeg4parser);
@@ -35,6 +35,7 @@
 #include <sys/types.h>
 #include <sys/socket.h>
 #include <gst/check/gstcheck.h>
+#include <gst/check/gstharness.h>
 #include <gst/video/navigation.h>
 #include <string.h>
 
@@ -5798,6 +5799,281 @@ GST_START_TEST (test_wavparse_master_process_crash)
 
 GST_END_TEST;
 
+#ifdef HAVE_MEMFD_CREATE
+/**** memfd tests ****/
+
+/* These run both sides in this process, the master pipeline is replaced by
+ * a harness around ipcpipelinesink */
+
+#define MEMFD_TEST_SIZE (128 * 1024)
+
+typedef struct
+{
+  GstHarness *h;
+  GstElement *slave;
+  GAsyncQueue *received;
+  int fds[4];
+} MemfdTest;
+
+static void
+memfd_on_handoff (GstElement * fakesink, GstBuffer * buffer, GstPad * pad,
+    GAsyncQueue * received)
+{
+  g_async_queue_push (received, gst_buffer_ref (buffer));
+}
+
+/* Connects an ipcpipelinesink using memfds to an ipcpipelinesrc, over a
+ * UNIX socket or over pipes. The buffers reaching the slave pipeline end up
+ * in t->received. With error_after, the slave fails on that buffer. */
+static void
+memfd_test_setup (MemfdTest * t, gboolean use_socket, guint max_in_flight,
+    gint error_after)
+{
+  GstElement *sink, *src, *identity, *fakesink;
+  int fdin, fdout, slave_fdin, slave_fdout;
+
+  if (use_socket) {
+    fail_unless (socketpair (AF_UNIX, SOCK_STREAM, 0, t->fds) == 0);
+    t->fds[2] = t->fds[3] = -1;
+    fdin = fdout = t->fds[0];
+    slave_fdin = slave_fdout = t->fds[1];
+  } else {
+    fail_unless (pipe2 (t->fds, O_CLOEXEC) == 0);
+    fail_unless (pipe2 (t->fds + 2, O_CLOEXEC) == 0);
+    fdout = t->fds[1];
+    slave_fdin = t->fds[0];
+    slave_fdout = t->fds[3];
+    fdin = t->fds[2];
+  }
+
+  t->received = g_async_queue_new_full ((GDestroyNotify) gst_buffer_unref);
+
+  t->slave = gst_element_factory_make ("ipcslavepipeline", NULL);
+  src = gst_element_factory_make ("ipcpipelinesrc", NULL);
+  g_object_set (src, "fdin", slave_fdin, "fdout", slave_fdout, NULL);
+  fakesink = gst_element_factory_make ("fakesink", NULL);
+  /* the last sample would keep the last buffer from being released */
+  g_object_set (fakesink, "sync", FALSE, "signal-handoffs", TRUE,
+      "enable-last-sample", FALSE, NULL);
+  g_signal_connect (fakesink, "handoff", G_CALLBACK (memfd_on_handoff),
+      t->received);
+  gst_bin_add_many (GST_BIN (t->slave), src, fakesink, NULL);
+  if (error_after > 0) {
+    identity = gst_element_factory_make ("identity", NULL);
+    g_object_set (identity, "error-after", error_after, NULL);
+    gst_bin_add (GST_BIN (t->slave), identity);
+    fail_unless (gst_element_link_many (src, identity, fakesink, NULL));
+  } else {
+    fail_unless (gst_element_link (src, fakesink));
+  }
+
+  sink = gst_element_factory_make ("ipcpipelinesink", NULL);
+  g_object_set (sink, "fdin", fdin, "fdout", fdout, "use-memfd", TRUE,
+      "max-in-flight", max_in_flight, NULL);
+  t->h = gst_harness_new_with_element (sink, "sink", NULL);
+  gst_object_unref (sink);
+  gst_harness_set_src_caps_str (t->h, "application/x-memfd-test");
+}
+
+static void
+memfd_test_teardown (MemfdTest * t)
+{
+  gint i;
+
+  gst_harness_teardown (t->h);
+  gst_element_set_state (t->slave, GST_STATE_NULL);
+  gst_object_unref (t->slave);
+  g_async_queue_unref (t->received);
+  for (i = 0; i < 4; i++) {
+    if (t->fds[i] >= 0)
+      close (t->fds[i]);
+  }
+}
+
+static GstBuffer *
+memfd_test_pop (MemfdTest * t)
+{
+  GstBuffer *buffer;
+
+  buffer = g_async_queue_timeout_pop (t->received, 5 * G_USEC_PER_SEC);
+  fail_unless (buffer != NULL);
+
+  return buffer;
+}
+
+/* Checks that all bytes of the buffer are n */
+static void
+memfd_check_buffer (GstBuffer * buffer, gsize size, guint8 n)
+{
+  GstMapInfo map;
+  gsize i;
+
+  fail_unless (gst_buffer_map (buffer, &map, GST_MAP_READ));
+  fail_unless_equals_int (map.size, size);
+  for (i = 0; i < map.size; i++) {
+    if (map.data[i] != n)
+      fail ("byte %" G_GSIZE_FORMAT " is %u, expected %u", i, map.data[i], n);
+  }
+  gst_buffer_unmap (buffer, &map);
+}
+
+/* Pushes a buffer of the given size and returns the buffer received by
+ * the slave */
+static GstBuffer *
+memfd_round_trip (MemfdTest * t, GstBuffer * buffer, guint8 n)
+{
+  gsize size = gst_buffer_get_size (buffer);
+
+  gst_buffer_memset (buffer, 0, n, size);
+  fail_unless_equals_int (gst_harness_push (t->h, buffer), GST_FLOW_OK);
+  buffer = memfd_test_pop (t);
+  memfd_check_buffer (buffer, size, n);
+
+  return buffer;
+}
+
+GST_START_TEST (test_memfd_round_trip)
+{
+  MemfdTest t;
+  GstBuffer *buffer;
+  guint i;
+
+  memfd_test_setup (&t, TRUE, 1, 0);
+
+  /* Large buffers are copied into memfds, which the slave maps read only */
+  for (i = 0; i < 4; i++) {
+    buffer = memfd_round_trip (&t,
+        gst_buffer_new_allocate (NULL, MEMFD_TEST_SIZE, NULL), i);
+    fail_unless (GST_MEMORY_IS_READONLY (gst_buffer_peek_memory (buffer, 0)));
+    gst_buffer_unref (buffer);
+  }
+
+  /* Small ones are still written to the socket */
+  buffer = memfd_round_trip (&t, gst_buffer_new_allocate (NULL, 1000, NULL),
+      0x55);
+  fail_if (GST_MEMORY_IS_READONLY (gst_buffer_peek_memory (buffer, 0)));
+  gst_buffer_unref (buffer);
+
+  memfd_test_teardown (&t);
+}
+
+GST_END_TEST;
+
+GST_START_TEST (test_memfd_release)
+{
+  GstBufferPoolAcquireParams dontwait = { 0, };
+  MemfdTest t;
+  GstAllocator *allocator = NULL;
+  GstAllocationParams params;
+  GstBufferPool *pool;
+  GstStructure *config;
+  GstBuffer *buffer, *received;
+  GstFlowReturn ret;
+  guint i, tries;
+
+  memfd_test_setup (&t, TRUE, 1, 0);
+
+  /* ipcpipelinesink proposes its memfd allocator */
+  gst_harness_get_allocator (t.h, &allocator, &params);
+  fail_unless (allocator != NULL);
+
+  /* A pool of a single buffer, which gets sent again each time it is
+   * recycled */
+  pool = gst_buffer_pool_new ();
+  config = gst_buffer_pool_get_config (pool);
+  gst_buffer_pool_config_set_params (config, NULL, MEMFD_TEST_SIZE, 1, 1);
+  gst_buffer_pool_config_set_allocator (config, allocator, &params);
+  fail_unless (gst_buffer_pool_set_config (pool, config));
+  fail_unless (gst_buffer_pool_set_active (pool, TRUE));
+  dontwait.flags = GST_BUFFER_POOL_ACQUIRE_FLAG_DONTWAIT;
+
+  for (i = 0; i < 4; i++) {
+    /* The release from the slave is asynchronous */
+    for (tries = 0; tries < 500; tries++) {
+      ret = gst_buffer_pool_acquire_buffer (pool, &buffer, &dontwait);
+      if (ret != GST_FLOW_EOS)
+        break;
+      g_usleep (10 * 1000);
+    }
+    fail_unless_equals_int (ret, GST_FLOW_OK);
+
+    received = memfd_round_trip (&t, buffer, i);
+    fail_unless (GST_MEMORY_IS_READONLY (gst_buffer_peek_memory (received,
+                0)));
+
+    /* The sink holds the buffer for as long as the slave uses its memory */
+    fail_unless_equals_int (gst_buffer_pool_acquire_buffer (pool, &buffer,
+            &dontwait), GST_FLOW_EOS);
+    gst_buffer_unref (received);
+  }
+
+  gst_buffer_pool_set_active (pool, FALSE);
+  gst_object_unref (pool);
+  memfd_test_teardown (&t);
+}
+
+GST_END_TEST;
+
+GST_START_TEST (test_memfd_pipe_fallback)
+{
+  MemfdTest t;
+  GstBuffer *buffer;
+  guint i;
+
+  /* fds can't be passed through pipes, buffers are copied through them */
+  memfd_test_setup (&t, FALSE, 1, 0);
+
+  for (i = 0; i < 4; i++) {
+    buffer = memfd_round_trip (&t,
+        gst_buffer_new_allocate (NULL, MEMFD_TEST_SIZE, NULL), i);
+    fail_if (GST_MEMORY_IS_READONLY (gst_buffer_peek_memory (buffer, 0)));
+    gst_buffer_unref (buffer);
+  }
+
+  memfd_test_teardown (&t);
+}
+
+GST_END_TEST;
+
+GST_START_TEST (test_memfd_in_flight_error)
+{
+  MemfdTest t;
+  GstBuffer *buffer;
+  GstFlowReturn ret;
+  gboolean got_error = FALSE;
+  guint i;
+
+  /* The slave fails on the second buffer, while more are in flight */
+  memfd_test_setup (&t, TRUE, 4, 2);
+
+  for (i = 0; i < 8; i++) {
+    buffer = gst_buffer_new_allocate (NULL, MEMFD_TEST_SIZE, NULL);
+    gst_buffer_memset (buffer, 0, i, MEMFD_TEST_SIZE);
+    ret = gst_harness_push (t.h, buffer);
+    if (i == 0)
+      fail_unless_equals_int (ret, GST_FLOW_OK);
+    /* the error is returned for a later buffer */
+    if (ret == GST_FLOW_ERROR) {
+      fail_unless (i >= 1);
+      got_error = TRUE;
+      break;
+    }
+    fail_unless_equals_int (ret, GST_FLOW_OK);
+  }
+  fail_unless (got_error);
+
+  /* Only the first buffer made it */
+  buffer = memfd_test_pop (&t);
+  memfd_check_buffer (buffer, MEMFD_TEST_SIZE, 0);
+  gst_buffer_unref (buffer);
+  fail_unless (g_async_queue_try_pop (t.received) == NULL);
+
+  memfd_test_teardown (&t);
+}
+
+GST_END_TEST;
+#endif
+
 static Suite *
 ipcpipeline_suite (void)
 {
@@ -6055,6 +6331,14 @@ ipcpipeline_suite (void)
      with the master pipeline. */
   tcase_add_test (tc_chain, test_wavparse_master_process_crash);
 
+#ifdef HAVE_MEMFD_CREATE
+  /* memfd tests check buffers passed in memfds, and the fallbacks */
+  tcase_add_test (tc_chain, test_memfd_round_trip);
+  tcase_add_test (tc_chain, test_memfd_release);
+  tcase_add_test (tc_chain, test_memfd_pipe_fallback);
+  tcase_add_test (tc_chain, test_memfd_in_flight_error);
+#endif
+
   return s;
 }
 
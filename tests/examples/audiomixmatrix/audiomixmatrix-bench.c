@@ -0,0 +1,284 @@
+/*
+ * audiomixmatrix-bench.c - Time audiomixmatrix with different channel counts,
+ *                          matrices and layouts
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin St, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+/* Usage:
+ *   audiomixmatrix-bench [--seconds=N] [--buffer-size=N]
+ *
+ * For 2 to 128 channels in and out, times the transform of N seconds of
+ * 48kHz F32 and S16 audio with a dense matrix, a sparse matrix where every
+ * output is a mix of two inputs and a channel permutation, for interleaved
+ * and planar layouts. The scalar loop audiomixmatrix used to run is timed
+ * on the same data for comparison, and every output is checked against
+ * it. */
+
+#include "../../../gst/audiomixmatrix/gstaudiomixmatrix.c"
+
+static gint seconds = 10;
+static gint buffer_size = 1024;
+
+static GOptionEntry entries[] = {
+  {"seconds", 's', 0, G_OPTION_ARG_INT, &seconds,
+      "Seconds of audio to process per run", "N"},
+  {"buffer-size", 'b', 0, G_OPTION_ARG_INT, &buffer_size,
+      "Samples per buffer", "N"},
+  {NULL}
+};
+
+typedef enum
+{
+  MATRIX_DENSE,
+  MATRIX_SPARSE,
+  MATRIX_PERMUTE
+} MatrixType;
+
+static const gchar *matrix_names[] = { "dense", "sparse", "permute" };
+
+static gdouble *
+make_matrix (MatrixType type, guint channels)
+{
+  gdouble *m = g_new0 (gdouble, channels * channels);
+  guint out, in;
+
+  for (out = 0; out < channels; out++) {
+    switch (type) {
+      case MATRIX_DENSE:
+        for (in = 0; in < channels; in++)
+          m[out * channels + in] = g_random_double_range (-1.0, 1.0);
+        break;
+      case MATRIX_SPARSE:
+        m[out * channels + out] = 0.5;
+        m[out * channels + (out + 1) % channels] = 0.5;
+        break;
+      case MATRIX_PERMUTE:
+        m[out * channels + channels - 1 - out] = 1.0;
+        break;
+    }
+  }
+
+  return m;
+}
+
+static void
+set_matrix (GstAudioMixMatrix * self, const gdouble * m, guint channels)
+{
+  GValue v = G_VALUE_INIT;
+  guint out, in;
+
+  g_value_init (&v, GST_TYPE_ARRAY);
+  for (out = 0; out < channels; out++) {
+    GValue row = G_VALUE_INIT;
+
+    g_value_init (&row, GST_TYPE_ARRAY);
+    for (in = 0; in < channels; in++) {
+      GValue itm = G_VALUE_INIT;
+
+      g_value_init (&itm, G_TYPE_DOUBLE);
+      g_value_set_double (&itm, m[out * channels + in]);
+      gst_value_array_append_value (&row, &itm);
+      g_value_unset (&itm);
+    }
+    gst_value_array_append_value (&v, &row);
+    g_value_unset (&row);
+  }
+
+  g_object_set (self, "in-channels", channels, "out-channels", channels, NULL);
+  g_object_set_property (G_OBJECT (self), "matrix", &v);
+  g_value_unset (&v);
+}
+
+#define IDX(c, s, channels) \
+  (planar ? (c) * n_samples + (s) : (s) * (channels) + (c))
+
+/* The scalar loop audiomixmatrix used for interleaved F32 and S16, also
+ * used on planar data to check the output */
+static void
+reference_mix (GstAudioMixMatrix * self, GstAudioFormat format,
+    gboolean planar, const GstMapInfo * inmap, GstMapInfo * outmap,
+    guint n_samples)
+{
+  guint channels = self->in_channels;
+  guint sample, out, in;
+
+  if (format == GST_AUDIO_FORMAT_F32) {
+    const gfloat *inarray = (const gfloat *) inmap->data;
+    gfloat *outarray = (gfloat *) outmap->data;
+
+    for (sample = 0; sample < n_samples; sample++) {
+      for (out = 0; out < channels; out++) {
+        gfloat outval = 0;
+        for (in = 0; in < channels; in++)
+          outval += inarray[IDX (in, sample, channels)] *
+              self->matrix[out * channels + in];
+        outarray[IDX (out, sample, channels)] = outval;
+      }
+    }
+  } else {
+    const gint16 *inarray = (const gint16 *) inmap->data;
+    gint16 *outarray = (gint16 *) outmap->data;
+
+    for (sample = 0; sample < n_samples; sample++) {
+      for (out = 0; out < channels; out++) {
+        gint32 outval = 0;
+        for (in = 0; in < channels; in++)
+          outval += (gint32) (inarray[IDX (in, sample, channels)] *
+              self->s16_conv_matrix[out * channels + in]);
+        outarray[IDX (out, sample, channels)] =
+            (gint16) (outval >> self->shift_bytes);
+      }
+    }
+  }
+}
+
+/* The S16 kernels compute exactly what the scalar loop did, the F32 ones
+ * use single precision coefficients */
+static gboolean
+check_output (GstAudioFormat format, guint channels, const GstMapInfo * map,
+    const GstMapInfo * refmap)
+{
+  gsize i;
+
+  if (format == GST_AUDIO_FORMAT_S16)
+    return memcmp (map->data, refmap->data, map->size) == 0;
+
+  for (i = 0; i < map->size / sizeof (gfloat); i++) {
+    if (fabs (((gfloat *) map->data)[i] - ((gfloat *) refmap->data)[i]) >
+        1e-5 * channels)
+      return FALSE;
+  }
+
+  return TRUE;
+}
+
+static gboolean
+bench (guint channels, GstAudioFormat format, GstAudioLayout layout,
+    MatrixType type)
+{
+  GstAudioMixMatrix *self;
+  GstAudioInfo info;
+  GstCaps *caps;
+  GstBuffer *inbuf, *outbuf, *refbuf;
+  GstMapInfo inmap, outmap, refmap;
+  gdouble *m;
+  guint n_buffers = seconds * 48000 / buffer_size, i;
+  gint64 start, elapsed, ref_elapsed = 0;
+  gboolean planar = layout == GST_AUDIO_LAYOUT_NON_INTERLEAVED, ok;
+
+  self = g_object_new (GST_TYPE_AUDIO_MIX_MATRIX, NULL);
+  m = make_matrix (type, channels);
+  set_matrix (self, m, channels);
+  g_free (m);
+
+  gst_audio_info_set_format (&info, format, 48000, channels, NULL);
+  info.layout = layout;
+  caps = gst_audio_info_to_caps (&info);
+  gst_audio_mix_matrix_set_caps (GST_BASE_TRANSFORM (self), caps, caps);
+  gst_caps_unref (caps);
+
+  inbuf = gst_buffer_new_allocate (NULL, buffer_size * info.bpf, NULL);
+  gst_buffer_map (inbuf, &inmap, GST_MAP_WRITE);
+  for (i = 0; i < inmap.size; i++)
+    inmap.data[i] = g_random_int ();
+  if (format == GST_AUDIO_FORMAT_F32) {
+    for (i = 0; i < inmap.size / sizeof (gfloat); i++)
+      ((gfloat *) inmap.data)[i] = g_random_double_range (-1.0, 1.0);
+  }
+  gst_buffer_unmap (inbuf, &inmap);
+  if (planar)
+    gst_buffer_add_audio_meta (inbuf, &info, buffer_size, NULL);
+  outbuf = gst_buffer_new_allocate (NULL, buffer_size * info.bpf, NULL);
+  refbuf = gst_buffer_new_allocate (NULL, buffer_size * info.bpf, NULL);
+
+  start = g_get_monotonic_time ();
+  for (i = 0; i < n_buffers; i++)
+    gst_audio_mix_matrix_transform (GST_BASE_TRANSFORM (self), inbuf, outbuf);
+  elapsed = MAX (g_get_monotonic_time () - start, 1);
+
+  gst_buffer_map (inbuf, &inmap, GST_MAP_READ);
+  gst_buffer_map (refbuf, &refmap, GST_MAP_WRITE);
+  if (!planar) {
+    start = g_get_monotonic_time ();
+    for (i = 0; i < n_buffers; i++)
+      reference_mix (self, format, FALSE, &inmap, &refmap, buffer_size);
+    ref_elapsed = MAX (g_get_monotonic_time () - start, 1);
+  } else {
+    reference_mix (self, format, TRUE, &inmap, &refmap, buffer_size);
+  }
+  gst_buffer_map (outbuf, &outmap, GST_MAP_READ);
+  ok = check_output (format, channels, &outmap, &refmap);
+  gst_buffer_unmap (outbuf, &outmap);
+  gst_buffer_unmap (refbuf, &refmap);
+  gst_buffer_unmap (inbuf, &inmap);
+
+  g_print ("%3u channels %-4s %-15s %-8s %9.2fx realtime",
+      channels, gst_audio_format_to_string (format),
+      planar ? "non-interleaved" : "interleaved", matrix_names[type],
+      seconds * 1e6 / elapsed);
+  if (ref_elapsed)
+    g_print (" (scalar %9.2fx realtime, %5.1fx faster)",
+        seconds * 1e6 / ref_elapsed, (gdouble) ref_elapsed / elapsed);
+  g_print ("%s\n", ok ? "" : " OUTPUT MISMATCH");
+
+  gst_buffer_unref (inbuf);
+  gst_buffer_unref (outbuf);
+  gst_buffer_unref (refbuf);
+  gst_object_unref (self);
+
+  return ok;
+}
+
+gint
+main (gint argc, gchar ** argv)
+{
+  static const GstAudioFormat formats[] =
+      { GST_AUDIO_FORMAT_F32, GST_AUDIO_FORMAT_S16 };
+  GOptionContext *ctx;
+  GError *err = NULL;
+  guint channels, f, type;
+  gboolean ok = TRUE;
+
+  ctx = g_option_context_new ("");
+  g_option_context_add_main_entries (ctx, entries, NULL);
+  g_option_context_add_group (ctx, gst_init_get_option_group ());
+  if (!g_option_context_parse (ctx, &argc, &argv, &err)) {
+    g_printerr ("Error initializing: %s\n", err->message);
+    g_clear_error (&err);
+    g_option_context_free (ctx);
+    return 1;
+  }
+  g_option_context_free (ctx);
+
+  if (seconds <= 0 || buffer_size <= 0) {
+    g_printerr ("Duration and buffer size must be positive\n");
+    return 1;
+  }
+
+  for (channels = 2; channels <= 128; channels *= 2) {
+    for (f = 0; f < G_N_ELEMENTS (formats); f++) {
+      for (type = MATRIX_DENSE; type <= MATRIX_PERMUTE; type++) {
+        ok &= bench (channels, formats[f], GST_AUDIO_LAYOUT_INTERLEAVED,
+            type);
+        ok &= bench (channels, formats[f], GST_AUDIO_LAYOUT_NON_INTERLEAVED,
+            type);
+      }
+    }
+  }
+
+  return ok ? 0 : 1;
+}
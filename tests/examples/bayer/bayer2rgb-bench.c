@@ -0,0 +1,170 @@
+/*
+ * bayer2rgb-bench.c - Time bayer2rgb demosaicing
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin St, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+/* Usage:
+ *   bayer2rgb-bench [--frames=N] [--width=N] [--height=N] [--threads=N]
+ *
+ * Demosaics N frames of 8 bit, 12 bit and packed 10 bit bayer input with
+ * the bilinear and the Malvar-He-Cutler methods, to 8 and 16 bit per
+ * component output, and prints the frame rate of each combination. */
+
+#include <gst/gst.h>
+#include <gst/app/gstappsrc.h>
+
+#include <string.h>
+
+static gint n_frames = 20;
+static gint width = 4000;
+static gint height = 3000;
+static gint n_threads = 1;
+
+static GOptionEntry entries[] = {
+  {"frames", 'n', 0, G_OPTION_ARG_INT, &n_frames,
+      "Number of frames to demosaic per run", "N"},
+  {"width", 0, 0, G_OPTION_ARG_INT, &width, "Frame width", "N"},
+  {"height", 0, 0, G_OPTION_ARG_INT, &height, "Frame height", "N"},
+  {"threads", 't', 0, G_OPTION_ARG_INT, &n_threads,
+      "Number of threads, 0 for the number of processors", "N"},
+  {NULL}
+};
+
+/* Bytes per frame of bayer input, with rows padded to 4 bytes */
+static gsize
+input_size (const gchar * in_format)
+{
+  gsize row;
+
+  if (g_str_has_suffix (in_format, "10p"))
+    row = (width + 3) / 4 * 5;
+  else if (g_str_has_suffix (in_format, "12p"))
+    row = (width + 1) / 2 * 3;
+  else if (strlen (in_format) > 4)
+    row = width * 2;
+  else
+    row = width;
+
+  return GST_ROUND_UP_4 (row) * height;
+}
+
+static void
+bench (const gchar * in_format, const gchar * out_format, const gchar * method)
+{
+  GstElement *pipeline, *src;
+  GstBuffer *inbuf;
+  GstMessage *msg;
+  GstMapInfo map;
+  gchar *desc;
+  gsize i;
+  gint64 start, elapsed;
+  gint n;
+
+  desc = g_strdup_printf ("appsrc name=src "
+      "caps=video/x-bayer,format=%s,width=%d,height=%d,framerate=30/1 ! "
+      "bayer2rgb method=%s n-threads=%d ! video/x-raw,format=%s ! "
+      "fakesink sync=false", in_format, width, height, method, n_threads,
+      out_format);
+  pipeline = gst_parse_launch (desc, NULL);
+  g_free (desc);
+  if (!pipeline) {
+    g_printerr ("The app, bayer or fakesink plugins are missing\n");
+    return;
+  }
+  src = gst_bin_get_by_name (GST_BIN (pipeline), "src");
+
+  inbuf = gst_buffer_new_allocate (NULL, input_size (in_format), NULL);
+
+  /* Noise on top of a gradient, so that each method does its usual amount
+   * of clamping */
+  gst_buffer_map (inbuf, &map, GST_MAP_WRITE);
+  for (i = 0; i < map.size; i++)
+    map.data[i] = (i * 3 + i / 4099) ^ g_random_int_range (0, 32);
+  gst_buffer_unmap (inbuf, &map);
+
+  /* Queue all frames first, so that only the conversion is timed. The
+   * input is only read, so they can all be the same buffer. */
+  for (n = 0; n < n_frames; n++)
+    gst_app_src_push_buffer (GST_APP_SRC (src), gst_buffer_ref (inbuf));
+  gst_app_src_end_of_stream (GST_APP_SRC (src));
+  gst_buffer_unref (inbuf);
+
+  gst_element_set_state (pipeline, GST_STATE_PAUSED);
+  gst_element_get_state (pipeline, NULL, NULL, GST_CLOCK_TIME_NONE);
+
+  start = g_get_monotonic_time ();
+  gst_element_set_state (pipeline, GST_STATE_PLAYING);
+  msg = gst_bus_timed_pop_filtered (GST_ELEMENT_BUS (pipeline),
+      GST_CLOCK_TIME_NONE, GST_MESSAGE_EOS | GST_MESSAGE_ERROR);
+  elapsed = MAX (g_get_monotonic_time () - start, 1);
+
+  if (GST_MESSAGE_TYPE (msg) == GST_MESSAGE_ERROR) {
+    g_printerr ("Can't convert %s to %s\n", in_format, out_format);
+  } else {
+    /* the first frame was converted during preroll */
+    g_print ("%-9s -> %-9s %-16s: %7.1f fps, %7.1f Mpixel/s\n", in_format,
+        out_format, method, (n_frames - 1) * 1e6 / elapsed,
+        (gdouble) (n_frames - 1) * width * height / elapsed);
+  }
+
+  gst_message_unref (msg);
+  gst_element_set_state (pipeline, GST_STATE_NULL);
+  gst_object_unref (src);
+  gst_object_unref (pipeline);
+}
+
+gint
+main (gint argc, gchar ** argv)
+{
+  static const struct
+  {
+    const gchar *in_format;
+    const gchar *out_format;
+  } runs[] = {
+    {"bggr", "BGRx"},
+    {"bggr12le", "BGRx"},
+    {"bggr12le", "RGBA64_LE"},
+    {"bggr10p", "BGRx"},
+    {"bggr10p", "RGBA64_LE"},
+  };
+  GOptionContext *ctx;
+  GError *err = NULL;
+  guint r;
+
+  ctx = g_option_context_new ("");
+  g_option_context_add_main_entries (ctx, entries, NULL);
+  g_option_context_add_group (ctx, gst_init_get_option_group ());
+  if (!g_option_context_parse (ctx, &argc, &argv, &err)) {
+    g_printerr ("Error initializing: %s\n", err->message);
+    g_clear_error (&err);
+    g_option_context_free (ctx);
+    return 1;
+  }
+  g_option_context_free (ctx);
+
+  if (n_frames <= 1 || width <= 0 || height <= 0 || n_threads < 0) {
+    g_printerr ("Invalid frame count, size or thread count\n");
+    return 1;
+  }
+
+  for (r = 0; r < G_N_ELEMENTS (runs); r++) {
+    bench (runs[r].in_format, runs[r].out_format, "bilinear");
+    bench (runs[r].in_format, runs[r].out_format, "malvar-he-cutler");
+  }
+
+  return 0;
+}
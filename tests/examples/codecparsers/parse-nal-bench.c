@@ -0,0 +1,208 @@
+/*
+ * parse-nal-bench.c - Time NAL unit splitting and header parsing
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin St, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+/* Usage:
+ *   parse-nal-bench [--codec=h264|h265] [--iterations=N] <byte-stream file>
+ *   parse-nal-bench --synthetic=MB [--iterations=N]
+ *
+ * The first form splits an Annex B byte-stream into NAL units and parses
+ * the parameter sets and slice headers, the second one only measures the
+ * start code scan on a generated stream of large slices with emulation
+ * prevention bytes, which is where the parser spends its time at high
+ * bitrates. */
+
+#include <gst/gst.h>
+#include <gst/codecparsers/gsth264parser.h>
+#include <gst/codecparsers/gsth265parser.h>
+
+static gchar *codec = NULL;
+static gint iterations = 10;
+static gint synthetic = 0;
+
+static GOptionEntry entries[] = {
+  {"codec", 'c', 0, G_OPTION_ARG_STRING, &codec,
+      "Codec of the input file (h264 or h265)", "CODEC"},
+  {"iterations", 'n', 0, G_OPTION_ARG_INT, &iterations,
+      "Number of passes over the data", "N"},
+  {"synthetic", 's', 0, G_OPTION_ARG_INT, &synthetic,
+      "Scan a generated stream of the given size in MB instead of a file",
+      "MB"},
+  {NULL}
+};
+
+static guint8 *
+make_synthetic_stream (gsize size)
+{
+  guint8 *data = g_malloc (size);
+  guint32 state = 0x12345678;
+  gsize i, next_sc = 0;
+
+  for (i = 0; i < size; i++) {
+    state = state * 1664525 + 1013904223;
+    data[i] = state >> 24;
+    /* Mostly random payload with an escaped 0x000003 now and then */
+    if ((state & 0xff00) == 0 && i + 3 < size) {
+      data[i] = data[i + 1] = 0x00;
+      data[i + 2] = 0x03;
+      i += 2;
+    }
+    if (i >= next_sc && i + 4 < size) {
+      data[i] = data[i + 1] = data[i + 2] = 0x00;
+      data[i + 3] = 0x01;
+      data[i + 4] = GST_H264_NAL_SLICE;
+      i += 4;
+      next_sc = i + 256 * 1024;
+    }
+  }
+
+  return data;
+}
+
+static guint
+bench_h264 (const guint8 * data, gsize size, gboolean headers)
+{
+  GstH264NalParser *parser = gst_h264_nal_parser_new ();
+  GstH264NalUnit nalu;
+  GstH264SliceHdr slice;
+  GstH264ParserResult res;
+  guint offset = 0, n_nalus = 0;
+
+  res = gst_h264_parser_identify_nalu (parser, data, offset, size, &nalu);
+  while (res == GST_H264_PARSER_OK || res == GST_H264_PARSER_NO_NAL_END) {
+    n_nalus++;
+
+    if (headers) {
+      if (nalu.type >= GST_H264_NAL_SLICE
+          && nalu.type <= GST_H264_NAL_SLICE_IDR)
+        gst_h264_parser_parse_slice_hdr (parser, &nalu, &slice, TRUE, TRUE);
+      else
+        gst_h264_parser_parse_nal (parser, &nalu);
+    }
+
+    if (res == GST_H264_PARSER_NO_NAL_END)
+      break;
+
+    offset = nalu.offset + nalu.size;
+    res = gst_h264_parser_identify_nalu (parser, data, offset, size, &nalu);
+  }
+
+  gst_h264_nal_parser_free (parser);
+
+  return n_nalus;
+}
+
+static guint
+bench_h265 (const guint8 * data, gsize size)
+{
+  GstH265Parser *parser = gst_h265_parser_new ();
+  GstH265NalUnit nalu;
+  GstH265SliceHdr slice;
+  GstH265ParserResult res;
+  guint offset = 0, n_nalus = 0;
+
+  res = gst_h265_parser_identify_nalu (parser, data, offset, size, &nalu);
+  while (res == GST_H265_PARSER_OK || res == GST_H265_PARSER_NO_NAL_END) {
+    n_nalus++;
+
+    if (nalu.type <= GST_H265_NAL_SLICE_CRA_NUT) {
+      if (gst_h265_parser_parse_slice_hdr (parser, &nalu, &slice) ==
+          GST_H265_PARSER_OK)
+        gst_h265_slice_hdr_free (&slice);
+    } else {
+      gst_h265_parser_parse_nal (parser, &nalu);
+    }
+
+    if (res == GST_H265_PARSER_NO_NAL_END)
+      break;
+
+    offset = nalu.offset + nalu.size;
+    res = gst_h265_parser_identify_nalu (parser, data, offset, size, &nalu);
+  }
+
+  gst_h265_parser_free (parser);
+
+  return n_nalus;
+}
+
+gint
+main (gint argc, gchar ** argv)
+{
+  GOptionContext *ctx;
+  GError *err = NULL;
+  guint8 *data = NULL;
+  gsize size = 0;
+  gint64 start, elapsed;
+  guint n_nalus = 0;
+  gboolean is_h265;
+  gint i;
+
+  ctx = g_option_context_new ("[FILE]");
+  g_option_context_add_main_entries (ctx, entries, NULL);
+  g_option_context_add_group (ctx, gst_init_get_option_group ());
+  if (!g_option_context_parse (ctx, &argc, &argv, &err)) {
+    g_printerr ("Error initializing: %s\n", err->message);
+    g_clear_error (&err);
+    g_option_context_free (ctx);
+    return 1;
+  }
+  g_option_context_free (ctx);
+
+  is_h265 = codec && g_ascii_strcasecmp (codec, "h265") == 0;
+  if (codec && !is_h265 && g_ascii_strcasecmp (codec, "h264") != 0) {
+    g_printerr ("Unknown codec %s\n", codec);
+    return 1;
+  }
+
+  if (synthetic > 0) {
+    size = (gsize) synthetic * 1024 * 1024;
+    data = make_synthetic_stream (size);
+  } else if (argc >= 2) {
+    if (!g_file_get_contents (argv[1], (gchar **) & data, &size, &err)) {
+      g_printerr ("Failed to read %s: %s\n", argv[1], err->message);
+      g_clear_error (&err);
+      return 1;
+    }
+  } else {
+    g_printerr ("Usage: %s [--codec=h264|h265] <byte-stream file>\n"
+        "       %s --synthetic=MB\n", argv[0], argv[0]);
+    return 1;
+  }
+
+  start = g_get_monotonic_time ();
+  for (i = 0; i < iterations; i++) {
+    if (synthetic > 0)
+      n_nalus = bench_h264 (data, size, FALSE);
+    else if (is_h265)
+      n_nalus = bench_h265 (data, size);
+    else
+      n_nalus = bench_h264 (data, size, TRUE);
+  }
+  elapsed = MAX (g_get_monotonic_time () - start, 1);
+
+  g_print ("%u NAL units in %" G_GSIZE_FORMAT " bytes, %d iterations\n",
+      n_nalus, size, iterations);
+  g_print ("%.3f ms per pass, %.1f MB/s\n",
+      elapsed / 1000.0 / iterations,
+      (gdouble) size * iterations / elapsed);
+
+  g_free (data);
+  g_free (codec);
+
+  return 0;
+}
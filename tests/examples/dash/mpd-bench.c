@@ -0,0 +1,207 @@
+/*
+ * mpd-bench.c - Time MPD parsing, segment list setup and seeking
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin St, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+/* Usage:
+ *   mpd-bench [--segments=N] [--iterations=N] [--seeks=N] [--alternate]
+ *
+ * Generates a timeshift MPD whose SegmentTimeline has one S element per
+ * segment, like many live packagers write them, and times parsing it,
+ * setting up the segment list of its representation and seeking in it.
+ * With --alternate the segment durations alternate like AAC audio segments
+ * do, so that no two consecutive S elements can be merged. */
+
+#include "../../../ext/dash/gstmpdparser.c"
+#include "../../../ext/dash/gstxmlhelper.c"
+#include "../../../ext/dash/gstmpdhelper.c"
+#include "../../../ext/dash/gstmpdnode.c"
+#include "../../../ext/dash/gstmpdrepresentationbasenode.c"
+#include "../../../ext/dash/gstmpdmultsegmentbasenode.c"
+#include "../../../ext/dash/gstmpdrootnode.c"
+#include "../../../ext/dash/gstmpdbaseurlnode.c"
+#include "../../../ext/dash/gstmpdutctimingnode.c"
+#include "../../../ext/dash/gstmpdmetricsnode.c"
+#include "../../../ext/dash/gstmpdmetricsrangenode.c"
+#include "../../../ext/dash/gstmpdsnode.c"
+#include "../../../ext/dash/gstmpdsegmenttimelinenode.c"
+#include "../../../ext/dash/gstmpdsegmenttemplatenode.c"
+#include "../../../ext/dash/gstmpdsegmenturlnode.c"
+#include "../../../ext/dash/gstmpdsegmentlistnode.c"
+#include "../../../ext/dash/gstmpdsegmentbasenode.c"
+#include "../../../ext/dash/gstmpdperiodnode.c"
+#include "../../../ext/dash/gstmpdsubrepresentationnode.c"
+#include "../../../ext/dash/gstmpdrepresentationnode.c"
+#include "../../../ext/dash/gstmpdcontentcomponentnode.c"
+#include "../../../ext/dash/gstmpdadaptationsetnode.c"
+#include "../../../ext/dash/gstmpdsubsetnode.c"
+#include "../../../ext/dash/gstmpdprograminformationnode.c"
+#include "../../../ext/dash/gstmpdlocationnode.c"
+#include "../../../ext/dash/gstmpdreportingnode.c"
+#include "../../../ext/dash/gstmpdurltypenode.c"
+#include "../../../ext/dash/gstmpddescriptortypenode.c"
+#include "../../../ext/dash/gstmpdclient.c"
+#undef GST_CAT_DEFAULT
+
+GST_DEBUG_CATEGORY (gst_dash_demux_debug);
+
+static gint n_segments = 43200;
+static gint iterations = 10;
+static gint n_seeks = 100000;
+static gboolean alternate = FALSE;
+
+static GOptionEntry entries[] = {
+  {"segments", 'n', 0, G_OPTION_ARG_INT, &n_segments,
+      "Number of segments in the timeline", "N"},
+  {"iterations", 'i', 0, G_OPTION_ARG_INT, &iterations,
+      "Number of times the MPD is parsed", "N"},
+  {"seeks", 's', 0, G_OPTION_ARG_INT, &n_seeks,
+      "Number of seeks", "N"},
+  {"alternate", 'a', 0, G_OPTION_ARG_NONE, &alternate,
+      "Alternate segment durations", NULL},
+  {NULL}
+};
+
+/* 2s segments at a 48kHz timescale, or alternating AAC-like durations */
+static guint64
+segment_duration (gint i)
+{
+  if (!alternate)
+    return 96000;
+
+  return i % 2 ? 96256 : 95744;
+}
+
+static gchar *
+make_mpd (void)
+{
+  GString *s = g_string_sized_new (n_segments * 24 + 1024);
+  gint i;
+
+  g_string_append (s, "<?xml version=\"1.0\"?>"
+      "<MPD xmlns=\"urn:mpeg:dash:schema:mpd:2011\""
+      "     profiles=\"urn:mpeg:dash:profile:isoff-live:2011\""
+      "     type=\"static\" mediaPresentationDuration=\"P1D\">"
+      "  <Period start=\"PT0S\">"
+      "    <AdaptationSet mimeType=\"audio/mp4\">"
+      "      <SegmentTemplate timescale=\"48000\""
+      "          initialization=\"init-$RepresentationID$.mp4\""
+      "          media=\"$RepresentationID$-$Time$.m4s\">"
+      "        <SegmentTimeline>\n");
+
+  g_string_append_printf (s, "<S t=\"0\" d=\"%" G_GUINT64_FORMAT "\"/>\n",
+      segment_duration (0));
+  for (i = 1; i < n_segments; i++)
+    g_string_append_printf (s, "<S d=\"%" G_GUINT64_FORMAT "\"/>\n",
+        segment_duration (i));
+
+  g_string_append (s, "        </SegmentTimeline>"
+      "      </SegmentTemplate>"
+      "      <Representation id=\"audio\" bandwidth=\"128000\"/>"
+      "    </AdaptationSet>" "  </Period>" "</MPD>");
+
+  return g_string_free (s, FALSE);
+}
+
+gint
+main (gint argc, gchar ** argv)
+{
+  GOptionContext *ctx;
+  GError *err = NULL;
+  GstMPDClient *client = NULL;
+  GstActiveStream *stream;
+  gint64 start, parse_time = 0, setup_time = 0, elapsed;
+  GstClockTime duration;
+  gchar *mpd;
+  gsize mpd_size;
+  guint found = 0;
+  gint i;
+
+  ctx = g_option_context_new ("");
+  g_option_context_add_main_entries (ctx, entries, NULL);
+  g_option_context_add_group (ctx, gst_init_get_option_group ());
+  if (!g_option_context_parse (ctx, &argc, &argv, &err)) {
+    g_printerr ("Error initializing: %s\n", err->message);
+    g_clear_error (&err);
+    g_option_context_free (ctx);
+    return 1;
+  }
+  g_option_context_free (ctx);
+
+  if (n_segments <= 0 || iterations <= 0 || n_seeks <= 0) {
+    g_printerr ("Counts must be positive\n");
+    return 1;
+  }
+
+  GST_DEBUG_CATEGORY_INIT (gst_dash_demux_debug, "dashdemux", 0, "dashdemux");
+
+  mpd = make_mpd ();
+  mpd_size = strlen (mpd);
+
+  for (i = 0; i < iterations; i++) {
+    GList *adaptation_sets;
+
+    if (client)
+      gst_mpd_client_free (client);
+    client = gst_mpd_client_new ();
+
+    start = g_get_monotonic_time ();
+    if (!gst_mpd_client_parse (client, mpd, mpd_size)) {
+      g_printerr ("Failed to parse the generated MPD\n");
+      return 1;
+    }
+    parse_time += g_get_monotonic_time () - start;
+
+    start = g_get_monotonic_time ();
+    if (!gst_mpd_client_setup_media_presentation (client, GST_CLOCK_TIME_NONE,
+            -1, NULL)) {
+      g_printerr ("Failed to set up the media presentation\n");
+      return 1;
+    }
+    adaptation_sets = gst_mpd_client_get_adaptation_sets (client);
+    if (!adaptation_sets || !gst_mpd_client_setup_streaming (client,
+            adaptation_sets->data)) {
+      g_printerr ("Failed to set up streaming\n");
+      return 1;
+    }
+    setup_time += g_get_monotonic_time () - start;
+  }
+
+  stream = gst_mpd_client_get_active_stream_by_index (client, 0);
+  g_print ("%d segments (%" G_GSIZE_FORMAT " bytes of XML) stored as %u "
+      "segment runs\n", n_segments, mpd_size, stream->segments->len);
+  g_print ("parse: %.3f ms, segment list setup: %.3f ms\n",
+      parse_time / 1000.0 / iterations, setup_time / 1000.0 / iterations);
+
+  duration = gst_util_uint64_scale (n_segments, 2 * GST_SECOND, 1);
+  start = g_get_monotonic_time ();
+  for (i = 0; i < n_seeks; i++) {
+    GstClockTime ts = gst_util_uint64_scale (i * 7919 % n_seeks, duration,
+        n_seeks);
+
+    if (gst_mpd_client_stream_seek (client, stream, TRUE, 0, ts, NULL))
+      found++;
+  }
+  elapsed = MAX (g_get_monotonic_time () - start, 1);
+  g_print ("%d seeks: %.3f us per seek (%u found)\n", n_seeks,
+      (gdouble) elapsed / n_seeks, found);
+
+  gst_mpd_client_free (client);
+  g_free (mpd);
+
+  return 0;
+}
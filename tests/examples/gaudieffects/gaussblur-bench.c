@@ -0,0 +1,128 @@
+/*
+ * gaussblur-bench.c - Time gaussianblur on 1080p frames
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin St, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+/* Usage:
+ *   gaussblur-bench [--frames=N] [--width=N] [--height=N] [--threads=N]
+ *
+ * Blurs N frames of AYUV, I420 and NV12 with increasing sigma, with the
+ * gaussian kernel and with box blurs, and prints the frame rate. The box
+ * blurs should run at the same rate whatever the sigma. */
+
+#include "../../../gst/gaudieffects/gstgaussblur.c"
+
+static gint n_frames = 60;
+static gint width = 1920;
+static gint height = 1080;
+static gint n_threads = 1;
+
+static GOptionEntry entries[] = {
+  {"frames", 'n', 0, G_OPTION_ARG_INT, &n_frames,
+      "Number of frames to blur per run", "N"},
+  {"width", 0, 0, G_OPTION_ARG_INT, &width, "Frame width", "N"},
+  {"height", 0, 0, G_OPTION_ARG_INT, &height, "Frame height", "N"},
+  {"threads", 't', 0, G_OPTION_ARG_INT, &n_threads,
+      "Number of threads, 0 for the number of processors", "N"},
+  {NULL}
+};
+
+static void
+bench (GstVideoFormat format, GstGaussianBlurMethod method, gdouble sigma)
+{
+  GstGaussianBlur *gb;
+  GstVideoInfo info;
+  GstBuffer *inbuf, *outbuf;
+  GstVideoFrame in_frame, out_frame;
+  GstMapInfo map;
+  gint64 start, elapsed;
+  gsize i;
+  gint n;
+
+  gb = g_object_new (GST_TYPE_GAUSSIANBLUR, "sigma", sigma, "method", method,
+      "n-threads", n_threads, NULL);
+
+  gst_video_info_set_format (&info, format, width, height);
+  inbuf = gst_buffer_new_allocate (NULL, info.size, NULL);
+  outbuf = gst_buffer_new_allocate (NULL, info.size, NULL);
+
+  gst_buffer_map (inbuf, &map, GST_MAP_WRITE);
+  for (i = 0; i < map.size; i++)
+    map.data[i] = (i * 7 + i / info.stride[0] * 13) ^ g_random_int_range (0,
+        16);
+  gst_buffer_unmap (inbuf, &map);
+
+  gst_video_frame_map (&in_frame, &info, inbuf, GST_MAP_READ);
+  gst_video_frame_map (&out_frame, &info, outbuf, GST_MAP_WRITE);
+
+  start = g_get_monotonic_time ();
+  for (n = 0; n < n_frames; n++)
+    gst_gaussianblur_transform_frame (GST_VIDEO_FILTER (gb), &in_frame,
+        &out_frame);
+  elapsed = MAX (g_get_monotonic_time () - start, 1);
+
+  g_print ("%-4s %-8s sigma %5.1f radius %2d: %8.1f fps\n",
+      gst_video_format_to_string (format),
+      method == GST_GAUSSIAN_BLUR_METHOD_BOX ? "box" : "gaussian", sigma,
+      gb->kernels[0].radius, n_frames * 1e6 / elapsed);
+
+  gst_video_frame_unmap (&out_frame);
+  gst_video_frame_unmap (&in_frame);
+  gst_buffer_unref (outbuf);
+  gst_buffer_unref (inbuf);
+  gst_object_unref (gb);
+}
+
+gint
+main (gint argc, gchar ** argv)
+{
+  static const GstVideoFormat formats[] = { GST_VIDEO_FORMAT_AYUV,
+    GST_VIDEO_FORMAT_I420, GST_VIDEO_FORMAT_NV12
+  };
+  static const gdouble sigmas[] = { 1.2, 3.0, 8.0, 20.0 };
+  GOptionContext *ctx;
+  GError *err = NULL;
+  guint f, s;
+
+  ctx = g_option_context_new ("");
+  g_option_context_add_main_entries (ctx, entries, NULL);
+  g_option_context_add_group (ctx, gst_init_get_option_group ());
+  if (!g_option_context_parse (ctx, &argc, &argv, &err)) {
+    g_printerr ("Error initializing: %s\n", err->message);
+    g_clear_error (&err);
+    g_option_context_free (ctx);
+    return 1;
+  }
+  g_option_context_free (ctx);
+
+  if (n_frames <= 0 || width <= 0 || height <= 0 || n_threads < 0) {
+    g_printerr ("Invalid frame count, size or thread count\n");
+    return 1;
+  }
+
+  GST_DEBUG_CATEGORY_INIT (gst_gauss_blur_debug, "gaussianblur", 0,
+      "Gaussian Blur video effect");
+
+  for (f = 0; f < G_N_ELEMENTS (formats); f++) {
+    for (s = 0; s < G_N_ELEMENTS (sigmas); s++) {
+      bench (formats[f], GST_GAUSSIAN_BLUR_METHOD_GAUSSIAN, sigmas[s]);
+      bench (formats[f], GST_GAUSSIAN_BLUR_METHOD_BOX, sigmas[s]);
+    }
+  }
+
+  return 0;
+}
@@ -0,0 +1,162 @@
+/*
+ * gdp-bench.c - Time the GDP payload CRC and gdppay ! gdpdepay
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin St, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+/* Usage:
+ *   gdp-bench [--buffers=N] [--size=N] [--crc-payload]
+ *
+ * Prints the rate of the byte-wise and the slice-by-8 CRC over buffers of
+ * the given size, then sends N buffers of that size through
+ * gdppay ! gdpdepay and prints the buffer rate and throughput. With
+ * --crc-payload, gdppay adds and gdpdepay checks the payload CRC. */
+
+#include "../../../gst/gdp/dataprotocol.c"
+
+static gint n_buffers = 10000;
+static gint buffer_size = 1024 * 1024;
+static gboolean crc_payload = FALSE;
+
+static GOptionEntry entries[] = {
+  {"buffers", 'n', 0, G_OPTION_ARG_INT, &n_buffers,
+      "Number of buffers to send", "N"},
+  {"size", 's', 0, G_OPTION_ARG_INT, &buffer_size,
+      "Size of each buffer in bytes", "N"},
+  {"crc-payload", 'c', 0, G_OPTION_ARG_NONE, &crc_payload,
+      "Checksum the payload", NULL},
+  {NULL}
+};
+
+/* what gst_dp_crc() did before slice-by-8 */
+static guint16
+crc_bytewise (const guint8 * buffer, guint length)
+{
+  guint16 crc_register = CRC_INIT;
+
+  for (; length--;) {
+    crc_register = (guint16) ((crc_register << 8) ^
+        gst_dp_crc_table[((crc_register >> 8) & 0x00ff) ^ *buffer++]);
+  }
+  return (0xffff ^ crc_register);
+}
+
+static void
+bench_crc (void)
+{
+  guint8 *data;
+  gint64 start, elapsed;
+  guint16 crc1 = 0, crc2 = 0;
+  gint i, n;
+
+  data = g_malloc (buffer_size);
+  for (i = 0; i < buffer_size; i++)
+    data[i] = g_random_int_range (0, 256);
+  /* enough for a stable figure without taking forever */
+  n = MAX (1, 256 * 1024 * 1024 / buffer_size);
+
+  start = g_get_monotonic_time ();
+  for (i = 0; i < n; i++)
+    crc1 ^= crc_bytewise (data, buffer_size);
+  elapsed = MAX (g_get_monotonic_time () - start, 1);
+  g_print ("byte-wise CRC:   %8.1f MB/s\n",
+      (gdouble) n * buffer_size / elapsed);
+
+  start = g_get_monotonic_time ();
+  for (i = 0; i < n; i++)
+    crc2 ^= gst_dp_crc (data, buffer_size);
+  elapsed = MAX (g_get_monotonic_time () - start, 1);
+  g_print ("slice-by-8 CRC:  %8.1f MB/s\n",
+      (gdouble) n * buffer_size / elapsed);
+
+  if (crc1 != crc2)
+    g_printerr ("CRC mismatch: %04x != %04x\n", crc1, crc2);
+
+  g_free (data);
+}
+
+static void
+bench_pipeline (void)
+{
+  GstElement *pipeline;
+  GstMessage *msg;
+  GError *err = NULL;
+  gint64 start, elapsed;
+  gchar *desc;
+
+  desc = g_strdup_printf ("fakesrc num-buffers=%d sizetype=fixed "
+      "sizemax=%d filltype=nothing ! application/x-bench ! "
+      "gdppay crc-payload=%s ! gdpdepay ! fakesink sync=false",
+      n_buffers, buffer_size, crc_payload ? "true" : "false");
+  pipeline = gst_parse_launch (desc, &err);
+  g_free (desc);
+  if (!pipeline) {
+    g_printerr ("Could not create pipeline: %s\n", err->message);
+    g_clear_error (&err);
+    return;
+  }
+
+  start = g_get_monotonic_time ();
+  gst_element_set_state (pipeline, GST_STATE_PLAYING);
+  msg = gst_bus_timed_pop_filtered (GST_ELEMENT_BUS (pipeline),
+      GST_CLOCK_TIME_NONE, GST_MESSAGE_EOS | GST_MESSAGE_ERROR);
+  elapsed = MAX (g_get_monotonic_time () - start, 1);
+
+  if (GST_MESSAGE_TYPE (msg) == GST_MESSAGE_ERROR) {
+    gst_message_parse_error (msg, &err, NULL);
+    g_printerr ("ERROR from element %s: %s\n", GST_OBJECT_NAME (msg->src),
+        err->message);
+    g_clear_error (&err);
+  } else {
+    g_print ("gdppay ! gdpdepay%s: %d byte buffers: %.0f buffers/s, "
+        "%.1f MB/s\n", crc_payload ? " with payload CRC" : "", buffer_size,
+        n_buffers * 1e6 / elapsed, (gdouble) n_buffers * buffer_size / elapsed);
+  }
+
+  gst_message_unref (msg);
+  gst_element_set_state (pipeline, GST_STATE_NULL);
+  gst_object_unref (pipeline);
+}
+
+gint
+main (gint argc, gchar ** argv)
+{
+  GOptionContext *ctx;
+  GError *err = NULL;
+
+  ctx = g_option_context_new ("");
+  g_option_context_add_main_entries (ctx, entries, NULL);
+  g_option_context_add_group (ctx, gst_init_get_option_group ());
+  if (!g_option_context_parse (ctx, &argc, &argv, &err)) {
+    g_printerr ("Error initializing: %s\n", err->message);
+    g_clear_error (&err);
+    g_option_context_free (ctx);
+    return 1;
+  }
+  g_option_context_free (ctx);
+
+  if (n_buffers <= 0 || buffer_size <= 0) {
+    g_printerr ("Invalid buffer count or size\n");
+    return 1;
+  }
+
+  gst_dp_init ();
+
+  bench_crc ();
+  bench_pipeline ();
+
+  return 0;
+}
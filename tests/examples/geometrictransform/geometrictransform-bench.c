@@ -0,0 +1,154 @@
+/*
+ * geometrictransform-bench.c - Time the rendering of the geometric transforms
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin St, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+/* Usage:
+ *   geometrictransform-bench [--frames=N] [--width=N] [--height=N]
+ *       [--threads=N] [--element=NAME]
+ *
+ * Transforms N frames of GRAY8, GRAY16, RGB and ARGB with rotate, or the
+ * given geometric transform element, with nearest neighbour and bilinear
+ * interpolation and prints the frame rate of each combination. The map is
+ * only generated once, so this times the rendering. */
+
+#include <gst/gst.h>
+#include <gst/app/gstappsrc.h>
+#include <gst/video/video.h>
+
+static gint n_frames = 100;
+static gint width = 1920;
+static gint height = 1080;
+static gint n_threads = 1;
+static gchar *element = NULL;
+
+static GOptionEntry entries[] = {
+  {"frames", 'n', 0, G_OPTION_ARG_INT, &n_frames,
+      "Number of frames to transform per run", "N"},
+  {"width", 0, 0, G_OPTION_ARG_INT, &width, "Frame width", "N"},
+  {"height", 0, 0, G_OPTION_ARG_INT, &height, "Frame height", "N"},
+  {"threads", 't', 0, G_OPTION_ARG_INT, &n_threads,
+      "Number of threads, 0 for the number of processors", "N"},
+  {"element", 'e', 0, G_OPTION_ARG_STRING, &element,
+      "Geometric transform to time, with its properties (default: rotate)",
+      "NAME"},
+  {NULL}
+};
+
+static void
+bench (GstVideoFormat format, const gchar * interpolation)
+{
+  GstElement *pipeline, *src;
+  GstVideoInfo info;
+  GstBuffer *inbuf;
+  GstMessage *msg;
+  GstMapInfo map;
+  gchar *desc;
+  gsize i;
+  gint64 start, elapsed;
+  gint n;
+
+  desc = g_strdup_printf ("appsrc name=src "
+      "caps=video/x-raw,format=%s,width=%d,height=%d,framerate=30/1 ! "
+      "%s interpolation=%s n-threads=%d ! fakesink sync=false",
+      gst_video_format_to_string (format), width, height,
+      element ? element : "rotate angle=0.3", interpolation, n_threads);
+  pipeline = gst_parse_launch (desc, NULL);
+  g_free (desc);
+  if (!pipeline) {
+    g_printerr ("The app, geometrictransform or fakesink plugins are "
+        "missing\n");
+    return;
+  }
+  src = gst_bin_get_by_name (GST_BIN (pipeline), "src");
+
+  gst_video_info_set_format (&info, format, width, height);
+  inbuf = gst_buffer_new_allocate (NULL, info.size, NULL);
+
+  gst_buffer_map (inbuf, &map, GST_MAP_WRITE);
+  for (i = 0; i < map.size; i++)
+    map.data[i] = (i * 7 + i / info.stride[0] * 13) ^ g_random_int_range (0,
+        16);
+  gst_buffer_unmap (inbuf, &map);
+
+  /* Queue all frames first, so that only the transform is timed. The
+   * input is only read, so they can all be the same buffer. */
+  for (n = 0; n < n_frames; n++)
+    gst_app_src_push_buffer (GST_APP_SRC (src), gst_buffer_ref (inbuf));
+  gst_app_src_end_of_stream (GST_APP_SRC (src));
+  gst_buffer_unref (inbuf);
+
+  gst_element_set_state (pipeline, GST_STATE_PAUSED);
+  gst_element_get_state (pipeline, NULL, NULL, GST_CLOCK_TIME_NONE);
+
+  start = g_get_monotonic_time ();
+  gst_element_set_state (pipeline, GST_STATE_PLAYING);
+  msg = gst_bus_timed_pop_filtered (GST_ELEMENT_BUS (pipeline),
+      GST_CLOCK_TIME_NONE, GST_MESSAGE_EOS | GST_MESSAGE_ERROR);
+  elapsed = MAX (g_get_monotonic_time () - start, 1);
+
+  if (GST_MESSAGE_TYPE (msg) == GST_MESSAGE_ERROR) {
+    g_printerr ("Can't transform %s\n", gst_video_format_to_string (format));
+  } else {
+    /* the first frame was transformed during preroll, with the map */
+    g_print ("%-9s %-8s: %7.1f fps, %7.1f Mpixel/s\n",
+        gst_video_format_to_string (format), interpolation,
+        (n_frames - 1) * 1e6 / elapsed,
+        (gdouble) (n_frames - 1) * width * height / elapsed);
+  }
+
+  gst_message_unref (msg);
+  gst_element_set_state (pipeline, GST_STATE_NULL);
+  gst_object_unref (src);
+  gst_object_unref (pipeline);
+}
+
+gint
+main (gint argc, gchar ** argv)
+{
+  static const GstVideoFormat formats[] = { GST_VIDEO_FORMAT_GRAY8,
+    GST_VIDEO_FORMAT_GRAY16_LE, GST_VIDEO_FORMAT_RGB, GST_VIDEO_FORMAT_ARGB
+  };
+  GOptionContext *ctx;
+  GError *err = NULL;
+  guint f;
+
+  ctx = g_option_context_new ("");
+  g_option_context_add_main_entries (ctx, entries, NULL);
+  g_option_context_add_group (ctx, gst_init_get_option_group ());
+  if (!g_option_context_parse (ctx, &argc, &argv, &err)) {
+    g_printerr ("Error initializing: %s\n", err->message);
+    g_clear_error (&err);
+    g_option_context_free (ctx);
+    return 1;
+  }
+  g_option_context_free (ctx);
+
+  if (n_frames <= 1 || width <= 0 || height <= 0 || n_threads < 0) {
+    g_printerr ("Invalid frame count, size or thread count\n");
+    return 1;
+  }
+
+  for (f = 0; f < G_N_ELEMENTS (formats); f++) {
+    bench (formats[f], "nearest");
+    bench (formats[f], "bilinear");
+  }
+
+  g_free (element);
+
+  return 0;
+}
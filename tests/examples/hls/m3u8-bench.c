@@ -0,0 +1,171 @@
+/*
+ * m3u8-bench.c - Time live media playlist updates and fragment lookups
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin St, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+/* Usage:
+ *   m3u8-bench [--fragments=N] [--updates=N] [--lookups=N]
+ *
+ * Generates a live playlist with a sliding window of N fragments, like a
+ * DVR window, and times its updates when one fragment is added and one
+ * removed at each refresh, followed by fragment lookups by sequence number
+ * and by position as done when seeking. */
+
+#include <gst/gst.h>
+
+#undef GST_CAT_DEFAULT
+#include "m3u8.h"
+#include "m3u8.c"
+
+GST_DEBUG_CATEGORY (hls_debug);
+
+static gint n_fragments = 10800;
+static gint n_updates = 100;
+static gint n_lookups = 100000;
+
+static GOptionEntry entries[] = {
+  {"fragments", 'f', 0, G_OPTION_ARG_INT, &n_fragments,
+      "Number of fragments in the playlist window", "N"},
+  {"updates", 'u', 0, G_OPTION_ARG_INT, &n_updates,
+      "Number of playlist refreshes", "N"},
+  {"lookups", 'l', 0, G_OPTION_ARG_INT, &n_lookups,
+      "Number of fragment lookups", "N"},
+  {NULL}
+};
+
+static gchar *
+make_playlist (gint64 first_sequence, gint n)
+{
+  GString *s = g_string_sized_new (n * 96);
+  GDateTime *dt;
+  gint i;
+
+  g_string_append_printf (s, "#EXTM3U\n#EXT-X-VERSION:3\n"
+      "#EXT-X-TARGETDURATION:2\n#EXT-X-MEDIA-SEQUENCE:%" G_GINT64_FORMAT "\n",
+      first_sequence);
+
+  for (i = 0; i < n; i++) {
+    gint64 seq = first_sequence + i;
+
+    /* one PROGRAM-DATE-TIME per minute, as many packagers do */
+    if (seq % 30 == 0) {
+      gchar *iso;
+
+      dt = g_date_time_new_from_unix_utc (1600000000 + seq * 2);
+      iso = g_date_time_format_iso8601 (dt);
+      g_string_append_printf (s, "#EXT-X-PROGRAM-DATE-TIME:%s\n", iso);
+      g_free (iso);
+      g_date_time_unref (dt);
+    }
+    g_string_append_printf (s, "#EXTINF:2.000,\n"
+        "segments/stream_1080p/%" G_GINT64_FORMAT ".ts\n", seq);
+  }
+
+  return g_string_free (s, FALSE);
+}
+
+gint
+main (gint argc, gchar ** argv)
+{
+  GOptionContext *ctx;
+  GError *err = NULL;
+  GstM3U8 *m3u8;
+  gint64 start, elapsed, first_sequence = 1000;
+  GstClockTime window;
+  guint found = 0;
+  gint i;
+
+  ctx = g_option_context_new ("");
+  g_option_context_add_main_entries (ctx, entries, NULL);
+  g_option_context_add_group (ctx, gst_init_get_option_group ());
+  if (!g_option_context_parse (ctx, &argc, &argv, &err)) {
+    g_printerr ("Error initializing: %s\n", err->message);
+    g_clear_error (&err);
+    g_option_context_free (ctx);
+    return 1;
+  }
+  g_option_context_free (ctx);
+
+  if (n_fragments <= 0 || n_updates <= 0 || n_lookups <= 0) {
+    g_printerr ("Counts must be positive\n");
+    return 1;
+  }
+
+  GST_DEBUG_CATEGORY_INIT (hls_debug, "hlsdemux", 0, "hlsdemux");
+
+  m3u8 = gst_m3u8_new ();
+  gst_m3u8_set_uri (m3u8, "http://example.com/live/stream.m3u8", NULL,
+      "stream.m3u8");
+
+  start = g_get_monotonic_time ();
+  if (!gst_m3u8_update (m3u8, make_playlist (first_sequence, n_fragments))) {
+    g_printerr ("Failed to parse the generated playlist\n");
+    gst_m3u8_unref (m3u8);
+    return 1;
+  }
+  elapsed = MAX (g_get_monotonic_time () - start, 1);
+  g_print ("initial parse of %d fragments: %.3f ms\n", n_fragments,
+      elapsed / 1000.0);
+
+  /* Generating the text is not part of the measurement */
+  elapsed = 0;
+  for (i = 0; i < n_updates; i++) {
+    gchar *data = make_playlist (++first_sequence, n_fragments);
+
+    start = g_get_monotonic_time ();
+    if (!gst_m3u8_update (m3u8, data)) {
+      g_printerr ("Failed to update the playlist\n");
+      gst_m3u8_unref (m3u8);
+      return 1;
+    }
+    elapsed += g_get_monotonic_time () - start;
+  }
+  elapsed = MAX (elapsed, 1);
+  g_print ("%d updates: %.3f ms per update\n", n_updates,
+      elapsed / 1000.0 / n_updates);
+
+  start = g_get_monotonic_time ();
+  for (i = 0; i < n_lookups; i++) {
+    m3u8->sequence = first_sequence + (i * 7919) % n_fragments;
+    m3u8->current_file = NULL;
+    if (gst_m3u8_has_next_fragment (m3u8, TRUE))
+      found++;
+  }
+  elapsed = MAX (g_get_monotonic_time () - start, 1);
+  g_print ("%d lookups by sequence: %.3f us per lookup (%u found)\n",
+      n_lookups, (gdouble) elapsed / n_lookups, found);
+
+  window = (GstClockTime) n_fragments * 2 * GST_SECOND;
+  found = 0;
+  start = g_get_monotonic_time ();
+  for (i = 0; i < n_lookups; i++) {
+    GstClockTime position = gst_util_uint64_scale (i * 7919 % n_lookups,
+        window, n_lookups);
+
+    GST_M3U8_LOCK (m3u8);
+    if (gst_m3u8_find_file_by_position (m3u8, position, NULL))
+      found++;
+    GST_M3U8_UNLOCK (m3u8);
+  }
+  elapsed = MAX (g_get_monotonic_time () - start, 1);
+  g_print ("%d lookups by position: %.3f us per lookup (%u found)\n",
+      n_lookups, (gdouble) elapsed / n_lookups, found);
+
+  gst_m3u8_unref (m3u8);
+
+  return 0;
+}
@@ -0,0 +1,259 @@
+/*
+ * ipcpipeline-bench.c - Time video frames sent from ipcpipelinesink to
+ * ipcpipelinesrc in another process
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin St, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+/* Usage:
+ *   ipcpipeline-bench [--frames=N] [--width=N] [--height=N] [--memfd]
+ *       [--window=N]
+ *
+ * Sends N I420 frames of the given size from videotestsrc in this process
+ * to a fakesink in a forked process and prints the frame rate, the
+ * throughput and the average and maximum latency from leaving
+ * ipcpipelinesink to reaching the fakesink. With --memfd, ipcpipelinesink
+ * passes the frames in memfds instead of copying them through the socket,
+ * --window sets its max-in-flight property. */
+
+#ifdef HAVE_CONFIG_H
+#  include "config.h"
+#endif
+
+#include <unistd.h>
+#include <fcntl.h>
+#include <signal.h>
+#include <stdio.h>
+#include <string.h>
+#include <errno.h>
+#include <sys/types.h>
+#include <sys/socket.h>
+#include <gst/gst.h>
+
+static gint n_frames = 300;
+static gint width = 3840;
+static gint height = 2160;
+static gboolean use_memfd = FALSE;
+static gint window = 1;
+
+static GOptionEntry entries[] = {
+  {"frames", 'n', 0, G_OPTION_ARG_INT, &n_frames,
+      "Number of frames to send", "N"},
+  {"width", 0, 0, G_OPTION_ARG_INT, &width, "Frame width", "N"},
+  {"height", 0, 0, G_OPTION_ARG_INT, &height, "Frame height", "N"},
+  {"memfd", 'm', 0, G_OPTION_ARG_NONE, &use_memfd,
+      "Pass frames in memfds", NULL},
+  {"window", 'w', 0, G_OPTION_ARG_INT, &window,
+      "Number of frames sent before waiting for a flow return", "N"},
+  {NULL}
+};
+
+static GMainLoop *loop;
+
+/* Only touched from the streaming thread of the fakesink */
+static gint64 n_received, n_bytes;
+static gint64 latency_sum, latency_max;
+static gint64 start_time;
+
+static gboolean
+_bus_watch (GstBus * bus, GstMessage * msg, gpointer user_data)
+{
+  switch (GST_MESSAGE_TYPE (msg)) {
+    case GST_MESSAGE_ERROR:{
+      GError *err = NULL;
+
+      gst_message_parse_error (msg, &err, NULL);
+      g_printerr ("ERROR from element %s: %s\n", GST_OBJECT_NAME (msg->src),
+          err->message);
+      g_error_free (err);
+      g_main_loop_quit (loop);
+      break;
+    }
+    case GST_MESSAGE_EOS:
+      g_main_loop_quit (loop);
+      break;
+    default:
+      break;
+  }
+
+  return TRUE;
+}
+
+/* The monotonic clock is shared by both processes, so the time a frame is
+ * sent at travels in its offset end */
+static GstPadProbeReturn
+_on_sent (GstPad * pad, GstPadProbeInfo * info, gpointer user_data)
+{
+  GstBuffer *buffer = gst_buffer_make_writable (GST_PAD_PROBE_INFO_BUFFER
+      (info));
+
+  GST_BUFFER_OFFSET_END (buffer) = g_get_monotonic_time ();
+  GST_PAD_PROBE_INFO_DATA (info) = buffer;
+
+  return GST_PAD_PROBE_OK;
+}
+
+static GstPadProbeReturn
+_on_received (GstPad * pad, GstPadProbeInfo * info, gpointer user_data)
+{
+  gint64 now = g_get_monotonic_time (), elapsed, latency;
+  GstBuffer *buffer;
+
+  if (info->type & GST_PAD_PROBE_TYPE_BUFFER) {
+    buffer = GST_PAD_PROBE_INFO_BUFFER (info);
+    if (n_received == 0)
+      start_time = GST_BUFFER_OFFSET_END (buffer);
+    latency = now - (gint64) GST_BUFFER_OFFSET_END (buffer);
+    latency_sum += latency;
+    latency_max = MAX (latency_max, latency);
+    n_bytes += gst_buffer_get_size (buffer);
+    n_received++;
+  } else if (GST_EVENT_TYPE (GST_PAD_PROBE_INFO_EVENT (info)) == GST_EVENT_EOS
+      && n_received > 0) {
+    elapsed = MAX (now - start_time, 1);
+    g_print ("%s, window %d: %" G_GINT64_FORMAT " %dx%d frames: %.1f fps, "
+        "%.1f MB/s, latency avg %.3f ms max %.3f ms\n",
+        use_memfd ? "memfd" : "copy", window, n_received, width, height,
+        n_received * 1e6 / elapsed, (gdouble) n_bytes / elapsed,
+        latency_sum / 1e3 / n_received, latency_max / 1e3);
+    /* the master kills us once it gets the EOS */
+    fflush (stdout);
+  }
+
+  return GST_PAD_PROBE_OK;
+}
+
+static GstElement *
+start_master (int fd)
+{
+  GstElement *pipeline, *sink;
+  GstPad *pad;
+  gchar *desc;
+
+  desc = g_strdup_printf ("videotestsrc num-buffers=%d pattern=black ! "
+      "video/x-raw,format=I420,width=%d,height=%d,framerate=1000/1 ! "
+      "ipcpipelinesink name=sink", n_frames, width, height);
+  pipeline = gst_parse_launch (desc, NULL);
+  g_free (desc);
+  if (!pipeline)
+    return NULL;
+
+  sink = gst_bin_get_by_name (GST_BIN (pipeline), "sink");
+  g_object_set (sink, "fdin", fd, "fdout", fd, "use-memfd", use_memfd,
+      "max-in-flight", window, NULL);
+  pad = gst_element_get_static_pad (sink, "sink");
+  gst_pad_add_probe (pad, GST_PAD_PROBE_TYPE_BUFFER, _on_sent, NULL, NULL);
+  gst_object_unref (pad);
+  gst_object_unref (sink);
+
+  gst_bus_add_watch (GST_ELEMENT_BUS (pipeline), _bus_watch, NULL);
+  gst_element_set_state (pipeline, GST_STATE_PLAYING);
+
+  return pipeline;
+}
+
+static GstElement *
+start_slave (int fd)
+{
+  GstElement *pipeline, *src, *sink;
+  GstPad *pad;
+
+  pipeline = gst_element_factory_make ("ipcslavepipeline", NULL);
+  src = gst_element_factory_make ("ipcpipelinesrc", NULL);
+  sink = gst_element_factory_make ("fakesink", NULL);
+  if (!pipeline || !src || !sink)
+    return NULL;
+
+  g_object_set (src, "fdin", fd, "fdout", fd, NULL);
+  g_object_set (sink, "sync", FALSE, NULL);
+  gst_bin_add_many (GST_BIN (pipeline), src, sink, NULL);
+  gst_element_link (src, sink);
+
+  pad = gst_element_get_static_pad (sink, "sink");
+  gst_pad_add_probe (pad,
+      GST_PAD_PROBE_TYPE_BUFFER | GST_PAD_PROBE_TYPE_EVENT_DOWNSTREAM,
+      _on_received, NULL, NULL);
+  gst_object_unref (pad);
+
+  /* The state of the slave pipeline follows the one of the master */
+  return pipeline;
+}
+
+int
+main (int argc, char *argv[])
+{
+  GOptionContext *ctx;
+  GError *err = NULL;
+  GstElement *pipeline;
+  int sockets[2];
+  pid_t pid;
+
+  ctx = g_option_context_new ("");
+  g_option_context_add_main_entries (ctx, entries, NULL);
+  g_option_context_add_group (ctx, gst_init_get_option_group ());
+  if (!g_option_context_parse (ctx, &argc, &argv, &err)) {
+    g_printerr ("Error initializing: %s\n", err->message);
+    g_clear_error (&err);
+    g_option_context_free (ctx);
+    return 1;
+  }
+  g_option_context_free (ctx);
+
+  if (n_frames <= 0 || width <= 0 || height <= 0 || window <= 0) {
+    g_printerr ("Invalid frame count, size or window\n");
+    return 1;
+  }
+
+  if (socketpair (AF_UNIX, SOCK_STREAM, 0, sockets)) {
+    g_printerr ("Error creating sockets: %s\n", strerror (errno));
+    return 1;
+  }
+  if (fcntl (sockets[0], F_SETFL, O_NONBLOCK) < 0 ||
+      fcntl (sockets[1], F_SETFL, O_NONBLOCK) < 0) {
+    g_printerr ("Error setting O_NONBLOCK on sockets: %s\n",
+        strerror (errno));
+    return 1;
+  }
+
+  pid = fork ();
+  if (pid < 0) {
+    g_printerr ("Error forking: %s\n", strerror (errno));
+    return 1;
+  }
+
+  loop = g_main_loop_new (NULL, FALSE);
+  if (pid > 0)
+    pipeline = start_master (sockets[0]);
+  else
+    pipeline = start_slave (sockets[1]);
+  if (!pipeline) {
+    g_printerr ("The ipcpipeline, videotestsrc or fakesink plugins are "
+        "missing\n");
+    if (pid > 0)
+      kill (pid, SIGTERM);
+    return 1;
+  }
+
+  g_main_loop_run (loop);
+
+  if (pid > 0)
+    kill (pid, SIGTERM);
+  gst_element_set_state (pipeline, GST_STATE_NULL);
+  gst_object_unref (pipeline);
+  g_main_loop_unref (loop);
+
+  return 0;
+}
@@ -0,0 +1,300 @@
+/*
+ * tsdemux-bench.c - Time the reassembly of large PES by tsdemux
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin St, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+/* Usage:
+ *   tsdemux-bench [--pes=N] [--pes-packets=N] [--chunk-size=N] [--zero-copy]
+ *       [--contiguous]
+ *
+ * Demuxes an HEVC stream made of N PES of the given number of TS packets
+ * each, pushed into tsdemux in input buffers of the given size, and prints
+ * the rate at which tsdemux output the payload. With --zero-copy, the
+ * zero-copy-pes property of tsdemux is set and the payload of each PES
+ * shares the input memory instead of being copied into a single memory.
+ * With --contiguous, the sink asks for physically contiguous memory, which
+ * makes tsdemux copy the payload again. */
+
+#include <string.h>
+
+#include <gst/gst.h>
+#include <gst/app/gstappsrc.h>
+
+#define PACKET_SIZE 188
+#define PES_PID 0x100
+
+static gint n_pes = 500;
+/* A multiple of 16, so that the continuity counters are the same in each
+ * PES and the same PES can be repeated */
+static gint pes_packets = 1088;
+static gint chunk_size = 65536;
+static gboolean zero_copy = FALSE;
+static gboolean contiguous = FALSE;
+
+static GOptionEntry entries[] = {
+  {"pes", 'n', 0, G_OPTION_ARG_INT, &n_pes, "Number of PES to demux", "N"},
+  {"pes-packets", 'p', 0, G_OPTION_ARG_INT, &pes_packets,
+      "Number of TS packets of each PES (rounded up to a multiple of 16)",
+      "N"},
+  {"chunk-size", 's', 0, G_OPTION_ARG_INT, &chunk_size,
+      "Size of the input buffers in bytes", "N"},
+  {"zero-copy", 'z', 0, G_OPTION_ARG_NONE, &zero_copy,
+      "Share the input memory in the output", NULL},
+  {"contiguous", 'c', 0, G_OPTION_ARG_NONE, &contiguous,
+      "Require physically contiguous memory downstream", NULL},
+  {NULL}
+};
+
+static GMainLoop *loop;
+static guint64 n_bytes, n_buffers;
+
+static gboolean
+_bus_watch (GstBus * bus, GstMessage * msg, gpointer user_data)
+{
+  switch (GST_MESSAGE_TYPE (msg)) {
+    case GST_MESSAGE_ERROR:{
+      GError *err = NULL;
+
+      gst_message_parse_error (msg, &err, NULL);
+      g_printerr ("ERROR from element %s: %s\n", GST_OBJECT_NAME (msg->src),
+          err->message);
+      g_error_free (err);
+      g_main_loop_quit (loop);
+      break;
+    }
+    case GST_MESSAGE_EOS:
+      g_main_loop_quit (loop);
+      break;
+    default:
+      break;
+  }
+
+  return TRUE;
+}
+
+static guint32
+_crc32 (const guint8 * data, gsize size)
+{
+  guint32 crc = 0xffffffff;
+  gsize i;
+  gint b;
+
+  for (i = 0; i < size; i++) {
+    crc ^= (guint32) data[i] << 24;
+    for (b = 0; b < 8; b++)
+      crc = crc & 0x80000000 ? (crc << 1) ^ 0x04c11db7 : crc << 1;
+  }
+
+  return crc;
+}
+
+static void
+_write_header (guint8 * p, guint16 pid, gboolean pusi, guint8 cc)
+{
+  p[0] = 0x47;
+  p[1] = (pusi ? 0x40 : 0x00) | (pid >> 8);
+  p[2] = pid & 0xff;
+  p[3] = 0x10 | (cc & 0xf);
+}
+
+static void
+_write_section (guint8 * p, guint16 pid, const guint8 * section, gsize size)
+{
+  _write_header (p, pid, TRUE, 0);
+  memset (p + 4, 0xff, PACKET_SIZE - 4);
+  p[4] = 0x00;
+  memcpy (p + 5, section, size);
+  GST_WRITE_UINT32_BE (p + 5 + size, _crc32 (section, size));
+}
+
+/* The PAT and PMT of a program with an HEVC stream and no PCR */
+static GstBuffer *
+_tables_new (void)
+{
+  static const guint8 pat[] = {
+    0x00, 0xb0, 0x0d, 0x00, 0x01, 0xc1, 0x00, 0x00,
+    0x00, 0x01, 0xe0, 0x20
+  };
+  static const guint8 pmt[] = {
+    0x02, 0xb0, 0x12, 0x00, 0x01, 0xc1, 0x00, 0x00,
+    0xff, 0xff, 0xf0, 0x00, 0x24, 0xe0 | (PES_PID >> 8), PES_PID & 0xff,
+    0xf0, 0x00
+  };
+  guint8 *data = g_malloc (2 * PACKET_SIZE);
+
+  _write_section (data, 0x0000, pat, sizeof pat);
+  _write_section (data + PACKET_SIZE, 0x0020, pmt, sizeof pmt);
+
+  return gst_buffer_new_wrapped (data, 2 * PACKET_SIZE);
+}
+
+/* A PES of unbounded length filling pes_packets packets */
+static GstBuffer *
+_pes_new (void)
+{
+  static const guint8 pes_header[] = {
+    0x00, 0x00, 0x01, 0xe0, 0x00, 0x00, 0x80, 0x00, 0x00
+  };
+  guint8 *data = g_malloc (pes_packets * PACKET_SIZE), *p;
+  gint i;
+
+  for (i = 0; i < pes_packets; i++) {
+    p = data + i * PACKET_SIZE;
+    _write_header (p, PES_PID, i == 0, i);
+    memset (p + 4, 0x5a, PACKET_SIZE - 4);
+    if (i == 0)
+      memcpy (p + 4, pes_header, sizeof pes_header);
+  }
+
+  return gst_buffer_new_wrapped (data, pes_packets * PACKET_SIZE);
+}
+
+static GstPadProbeReturn
+_on_query (GstPad * pad, GstPadProbeInfo * info, gpointer user_data)
+{
+  GstQuery *query = GST_PAD_PROBE_INFO_QUERY (info);
+  GstAllocationParams params;
+
+  if (GST_QUERY_TYPE (query) != GST_QUERY_ALLOCATION)
+    return GST_PAD_PROBE_OK;
+
+  gst_allocation_params_init (&params);
+  params.flags = GST_MEMORY_FLAG_PHYSICALLY_CONTIGUOUS;
+  gst_query_add_allocation_param (query, NULL, &params);
+
+  return GST_PAD_PROBE_HANDLED;
+}
+
+static GstPadProbeReturn
+_on_buffer (GstPad * pad, GstPadProbeInfo * info, gpointer user_data)
+{
+  if (info->type & GST_PAD_PROBE_TYPE_BUFFER_LIST) {
+    GstBufferList *list = GST_PAD_PROBE_INFO_BUFFER_LIST (info);
+
+    n_bytes += gst_buffer_list_calculate_size (list);
+    n_buffers += gst_buffer_list_length (list);
+  } else {
+    n_bytes += gst_buffer_get_size (GST_PAD_PROBE_INFO_BUFFER (info));
+    n_buffers++;
+  }
+
+  return GST_PAD_PROBE_OK;
+}
+
+static void
+_pad_added (GstElement * demux, GstPad * pad, GstElement * sink)
+{
+  GstPad *sinkpad = gst_element_get_static_pad (sink, "sink");
+
+  gst_pad_link (pad, sinkpad);
+  gst_object_unref (sinkpad);
+}
+
+int
+main (int argc, char *argv[])
+{
+  GOptionContext *ctx;
+  GError *err = NULL;
+  GstElement *pipeline, *src, *demux, *sink;
+  GstBuffer *pes;
+  GstCaps *caps;
+  GstPad *pad;
+  gint64 start, end;
+  gsize pes_size, offset;
+  gint i;
+
+  ctx = g_option_context_new ("");
+  g_option_context_add_main_entries (ctx, entries, NULL);
+  g_option_context_add_group (ctx, gst_init_get_option_group ());
+  if (!g_option_context_parse (ctx, &argc, &argv, &err)) {
+    g_printerr ("Error initializing: %s\n", err->message);
+    g_clear_error (&err);
+    g_option_context_free (ctx);
+    return 1;
+  }
+  g_option_context_free (ctx);
+
+  if (n_pes <= 0 || pes_packets <= 0 || chunk_size <= 0) {
+    g_printerr ("Invalid PES count, PES size or chunk size\n");
+    return 1;
+  }
+  pes_packets = GST_ROUND_UP_16 (pes_packets);
+
+  loop = g_main_loop_new (NULL, FALSE);
+  pipeline = gst_pipeline_new (NULL);
+  src = gst_element_factory_make ("appsrc", NULL);
+  demux = gst_element_factory_make ("tsdemux", NULL);
+  sink = gst_element_factory_make ("fakesink", NULL);
+  if (!src || !demux || !sink) {
+    g_printerr ("The app, mpegtsdemux or fakesink plugins are missing\n");
+    return 1;
+  }
+
+  caps = gst_caps_new_simple ("video/mpegts", "systemstream", G_TYPE_BOOLEAN,
+      TRUE, "packetsize", G_TYPE_INT, PACKET_SIZE, NULL);
+  g_object_set (src, "max-bytes", G_GUINT64_CONSTANT (0), "block", FALSE,
+      "caps", caps, NULL);
+  gst_caps_unref (caps);
+  g_object_set (demux, "zero-copy-pes", zero_copy, NULL);
+  g_object_set (sink, "sync", FALSE, NULL);
+  gst_bin_add_many (GST_BIN (pipeline), src, demux, sink, NULL);
+  gst_element_link (src, demux);
+  g_signal_connect (demux, "pad-added", G_CALLBACK (_pad_added), sink);
+
+  pad = gst_element_get_static_pad (sink, "sink");
+  gst_pad_add_probe (pad,
+      GST_PAD_PROBE_TYPE_BUFFER | GST_PAD_PROBE_TYPE_BUFFER_LIST, _on_buffer,
+      NULL, NULL);
+  if (contiguous)
+    gst_pad_add_probe (pad, GST_PAD_PROBE_TYPE_QUERY_DOWNSTREAM, _on_query,
+        NULL, NULL);
+  gst_object_unref (pad);
+
+  /* Queue all the input before starting, the input buffers all share the
+   * memory of the same PES */
+  gst_app_src_push_buffer (GST_APP_SRC (src), _tables_new ());
+  pes = _pes_new ();
+  pes_size = gst_buffer_get_size (pes);
+  for (i = 0; i < n_pes; i++) {
+    for (offset = 0; offset < pes_size; offset += chunk_size) {
+      gst_app_src_push_buffer (GST_APP_SRC (src),
+          gst_buffer_copy_region (pes, GST_BUFFER_COPY_MEMORY, offset,
+              MIN (chunk_size, pes_size - offset)));
+    }
+  }
+  gst_buffer_unref (pes);
+  gst_app_src_end_of_stream (GST_APP_SRC (src));
+
+  gst_bus_add_watch (GST_ELEMENT_BUS (pipeline), _bus_watch, NULL);
+
+  start = g_get_monotonic_time ();
+  gst_element_set_state (pipeline, GST_STATE_PLAYING);
+  g_main_loop_run (loop);
+  end = g_get_monotonic_time ();
+
+  g_print ("%d PES of %d packets, %d bytes input buffers%s%s: %"
+      G_GUINT64_FORMAT " bytes in %" G_GUINT64_FORMAT " buffers, %.1f MB/s\n",
+      n_pes, pes_packets, chunk_size, zero_copy ? ", zero-copy" : "",
+      contiguous ? ", contiguous" : "", n_bytes, n_buffers,
+      n_bytes / (gdouble) MAX (end - start, 1));
+
+  gst_element_set_state (pipeline, GST_STATE_NULL);
+  gst_object_unref (pipeline);
+  g_main_loop_unref (loop);
+
+  return 0;
+}
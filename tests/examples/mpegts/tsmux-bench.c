@@ -0,0 +1,185 @@
+/*
+ * tsmux-bench.c - Time the aligned output of mpegtsmux
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin St, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+/* Usage:
+ *   tsmux-bench [--frames=N] [--frame-size=N] [--alignment=N] [--m2ts]
+ *
+ * Muxes N H.264 frames of the given size with mpegtsmux, gathering the
+ * packets into output buffers of the given number of packets, and prints
+ * the rate at which mpegtsmux output them. An alignment of 0 outputs the
+ * packets without gathering them, --m2ts outputs 192 bytes packets. */
+
+#include <gst/gst.h>
+#include <gst/app/gstappsrc.h>
+
+static gint n_frames = 2000;
+static gint frame_size = 50000;
+static gint alignment = 7;
+static gboolean m2ts = FALSE;
+
+static GOptionEntry entries[] = {
+  {"frames", 'n', 0, G_OPTION_ARG_INT, &n_frames, "Number of frames to mux",
+      "N"},
+  {"frame-size", 's', 0, G_OPTION_ARG_INT, &frame_size,
+      "Size of each frame in bytes", "N"},
+  {"alignment", 'a', 0, G_OPTION_ARG_INT, &alignment,
+      "Number of packets in each output buffer", "N"},
+  {"m2ts", 'm', 0, G_OPTION_ARG_NONE, &m2ts, "Output 192 bytes packets",
+      NULL},
+  {NULL}
+};
+
+static GMainLoop *loop;
+static guint64 n_bytes, n_buffers;
+
+static gboolean
+_bus_watch (GstBus * bus, GstMessage * msg, gpointer user_data)
+{
+  switch (GST_MESSAGE_TYPE (msg)) {
+    case GST_MESSAGE_ERROR:{
+      GError *err = NULL;
+
+      gst_message_parse_error (msg, &err, NULL);
+      g_printerr ("ERROR from element %s: %s\n", GST_OBJECT_NAME (msg->src),
+          err->message);
+      g_error_free (err);
+      g_main_loop_quit (loop);
+      break;
+    }
+    case GST_MESSAGE_EOS:
+      g_main_loop_quit (loop);
+      break;
+    default:
+      break;
+  }
+
+  return TRUE;
+}
+
+static GstPadProbeReturn
+_on_buffer (GstPad * pad, GstPadProbeInfo * info, gpointer user_data)
+{
+  n_bytes += gst_buffer_get_size (GST_PAD_PROBE_INFO_BUFFER (info));
+  n_buffers++;
+
+  return GST_PAD_PROBE_OK;
+}
+
+/* An access unit made of a single slice NAL, the payload contains no start
+ * code */
+static GstBuffer *
+_frame_new (void)
+{
+  static const guint8 nal_header[] = { 0x00, 0x00, 0x00, 0x01, 0x65 };
+  GstBuffer *frame = gst_buffer_new_allocate (NULL, frame_size, NULL);
+
+  gst_buffer_memset (frame, 0, 0x5a, frame_size);
+  gst_buffer_fill (frame, 0, nal_header, sizeof nal_header);
+
+  return frame;
+}
+
+int
+main (int argc, char *argv[])
+{
+  GOptionContext *ctx;
+  GError *err = NULL;
+  GstElement *pipeline, *src, *mux, *sink;
+  GstBuffer *frame, *buf;
+  GstCaps *caps;
+  GstPad *pad;
+  gint64 start, end;
+  gint i;
+
+  ctx = g_option_context_new ("");
+  g_option_context_add_main_entries (ctx, entries, NULL);
+  g_option_context_add_group (ctx, gst_init_get_option_group ());
+  if (!g_option_context_parse (ctx, &argc, &argv, &err)) {
+    g_printerr ("Error initializing: %s\n", err->message);
+    g_clear_error (&err);
+    g_option_context_free (ctx);
+    return 1;
+  }
+  g_option_context_free (ctx);
+
+  if (n_frames <= 0 || frame_size < 5 || alignment < 0) {
+    g_printerr ("Invalid frame count, frame size or alignment\n");
+    return 1;
+  }
+
+  loop = g_main_loop_new (NULL, FALSE);
+  pipeline = gst_pipeline_new (NULL);
+  src = gst_element_factory_make ("appsrc", NULL);
+  mux = gst_element_factory_make ("mpegtsmux", NULL);
+  sink = gst_element_factory_make ("fakesink", NULL);
+  if (!src || !mux || !sink) {
+    g_printerr ("The app, mpegtsmux or fakesink plugins are missing\n");
+    return 1;
+  }
+
+  caps = gst_caps_new_simple ("video/x-h264", "stream-format", G_TYPE_STRING,
+      "byte-stream", "alignment", G_TYPE_STRING, "au", "width", G_TYPE_INT,
+      1920, "height", G_TYPE_INT, 1080, "framerate", GST_TYPE_FRACTION, 25, 1,
+      NULL);
+  g_object_set (src, "max-bytes", G_GUINT64_CONSTANT (0), "block", FALSE,
+      "format", GST_FORMAT_TIME, "caps", caps, NULL);
+  gst_caps_unref (caps);
+  /* m2ts-mode changes the automatic alignment, set the alignment after */
+  g_object_set (mux, "m2ts-mode", m2ts, NULL);
+  g_object_set (mux, "alignment", alignment, NULL);
+  g_object_set (sink, "sync", FALSE, NULL);
+  gst_bin_add_many (GST_BIN (pipeline), src, mux, sink, NULL);
+  gst_element_link_many (src, mux, sink, NULL);
+
+  pad = gst_element_get_static_pad (sink, "sink");
+  gst_pad_add_probe (pad, GST_PAD_PROBE_TYPE_BUFFER, _on_buffer, NULL, NULL);
+  gst_object_unref (pad);
+
+  /* Queue all the input before starting, the frames all share the memory
+   * of the same frame */
+  frame = _frame_new ();
+  for (i = 0; i < n_frames; i++) {
+    buf = gst_buffer_copy (frame);
+    GST_BUFFER_PTS (buf) = GST_BUFFER_DTS (buf) = i * GST_SECOND / 25;
+    GST_BUFFER_DURATION (buf) = GST_SECOND / 25;
+    if (i % 25 != 0)
+      GST_BUFFER_FLAG_SET (buf, GST_BUFFER_FLAG_DELTA_UNIT);
+    gst_app_src_push_buffer (GST_APP_SRC (src), buf);
+  }
+  gst_buffer_unref (frame);
+  gst_app_src_end_of_stream (GST_APP_SRC (src));
+
+  gst_bus_add_watch (GST_ELEMENT_BUS (pipeline), _bus_watch, NULL);
+
+  start = g_get_monotonic_time ();
+  gst_element_set_state (pipeline, GST_STATE_PLAYING);
+  g_main_loop_run (loop);
+  end = g_get_monotonic_time ();
+
+  g_print ("%d frames of %d bytes, alignment %d%s: %" G_GUINT64_FORMAT
+      " bytes in %" G_GUINT64_FORMAT " buffers, %.1f MB/s\n", n_frames,
+      frame_size, alignment, m2ts ? ", m2ts" : "", n_bytes, n_buffers,
+      n_bytes / (gdouble) MAX (end - start, 1));
+
+  gst_element_set_state (pipeline, GST_STATE_NULL);
+  gst_object_unref (pipeline);
+  g_main_loop_unref (loop);
+
+  return 0;
+}
@@ -0,0 +1,227 @@
+/*
+ * tsparse-bench.c - Time the packet sync and iteration of tsparse
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin St, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+/* Usage:
+ *   tsparse-bench [--size=MB] [--m2ts] [--garbage=N] [--location=FILE]
+ *
+ * Parses the given amount of generated transport stream with tsparse and
+ * prints the rate at which it went through. The packet size is not given in
+ * the caps, so tsparse discovers it, and --m2ts generates 192 bytes packets
+ * instead of 188 bytes ones. With --garbage, N bytes without a sync byte
+ * follow every 1024 packets and tsparse has to resync after them. With
+ * --location, a capture is parsed from the given file instead. */
+
+#include <string.h>
+
+#include <gst/gst.h>
+#include <gst/app/gstappsrc.h>
+
+#define TS_PACKET_SIZE 188
+/* Each chunk has the same number of packets, a multiple of 16, on each of
+ * the PIDs, so that the continuity counters carry on over the chunks */
+#define CHUNK_PACKETS 1024
+#define N_PIDS 4
+
+static gint size = 1024;
+static gboolean m2ts = FALSE;
+static gint garbage = 0;
+static gchar *location = NULL;
+
+static GOptionEntry entries[] = {
+  {"size", 's', 0, G_OPTION_ARG_INT, &size,
+      "Megabytes of transport stream to generate", "MB"},
+  {"m2ts", 'm', 0, G_OPTION_ARG_NONE, &m2ts, "Generate 192 bytes packets",
+      NULL},
+  {"garbage", 'g', 0, G_OPTION_ARG_INT, &garbage,
+      "Bytes of garbage after every 1024 packets", "N"},
+  {"location", 'l', 0, G_OPTION_ARG_FILENAME, &location,
+      "Parse this capture instead", "FILE"},
+  {NULL}
+};
+
+static GMainLoop *loop;
+static guint64 in_bytes, out_bytes, out_buffers;
+
+static gboolean
+_bus_watch (GstBus * bus, GstMessage * msg, gpointer user_data)
+{
+  switch (GST_MESSAGE_TYPE (msg)) {
+    case GST_MESSAGE_ERROR:{
+      GError *err = NULL;
+
+      gst_message_parse_error (msg, &err, NULL);
+      g_printerr ("ERROR from element %s: %s\n", GST_OBJECT_NAME (msg->src),
+          err->message);
+      g_error_free (err);
+      g_main_loop_quit (loop);
+      break;
+    }
+    case GST_MESSAGE_EOS:
+      g_main_loop_quit (loop);
+      break;
+    default:
+      break;
+  }
+
+  return TRUE;
+}
+
+static GstPadProbeReturn
+_on_input (GstPad * pad, GstPadProbeInfo * info, gpointer user_data)
+{
+  in_bytes += gst_buffer_get_size (GST_PAD_PROBE_INFO_BUFFER (info));
+
+  return GST_PAD_PROBE_OK;
+}
+
+static GstPadProbeReturn
+_on_output (GstPad * pad, GstPadProbeInfo * info, gpointer user_data)
+{
+  out_bytes += gst_buffer_get_size (GST_PAD_PROBE_INFO_BUFFER (info));
+  out_buffers++;
+
+  return GST_PAD_PROBE_OK;
+}
+
+/* CHUNK_PACKETS packets of PES payload on N_PIDS PIDs, followed by the
+ * garbage */
+static GstBuffer *
+_chunk_new (void)
+{
+  gint packet_size = m2ts ? TS_PACKET_SIZE + 4 : TS_PACKET_SIZE;
+  gsize chunk_size = CHUNK_PACKETS * packet_size + garbage;
+  guint8 *data = g_malloc (chunk_size), *p;
+  gint i;
+
+  for (i = 0; i < CHUNK_PACKETS; i++) {
+    guint16 pid = 0x100 + i % N_PIDS;
+    guint8 cc = i / N_PIDS;
+
+    p = data + i * packet_size;
+    if (m2ts) {
+      GST_WRITE_UINT32_BE (p, i * 1000);
+      p += 4;
+    }
+    p[0] = 0x47;
+    p[1] = pid >> 8;
+    p[2] = pid & 0xff;
+    p[3] = 0x10 | (cc & 0xf);
+    memset (p + 4, 0x5a, TS_PACKET_SIZE - 4);
+  }
+  memset (data + CHUNK_PACKETS * packet_size, 0x00, garbage);
+
+  return gst_buffer_new_wrapped (data, chunk_size);
+}
+
+int
+main (int argc, char *argv[])
+{
+  GOptionContext *ctx;
+  GError *err = NULL;
+  GstElement *pipeline, *src, *parse, *sink;
+  GstBuffer *chunk;
+  GstCaps *caps;
+  GstPad *pad;
+  gint64 start, end;
+  guint64 total, offset;
+  gsize chunk_size;
+
+  ctx = g_option_context_new ("");
+  g_option_context_add_main_entries (ctx, entries, NULL);
+  g_option_context_add_group (ctx, gst_init_get_option_group ());
+  if (!g_option_context_parse (ctx, &argc, &argv, &err)) {
+    g_printerr ("Error initializing: %s\n", err->message);
+    g_clear_error (&err);
+    g_option_context_free (ctx);
+    return 1;
+  }
+  g_option_context_free (ctx);
+
+  if (size <= 0 || garbage < 0) {
+    g_printerr ("Invalid size or garbage size\n");
+    return 1;
+  }
+
+  loop = g_main_loop_new (NULL, FALSE);
+  pipeline = gst_pipeline_new (NULL);
+  src = gst_element_factory_make (location ? "filesrc" : "appsrc", NULL);
+  parse = gst_element_factory_make ("tsparse", NULL);
+  sink = gst_element_factory_make ("fakesink", NULL);
+  if (!src || !parse || !sink) {
+    g_printerr ("The app, coreelements, mpegtsdemux or fakesink plugins are "
+        "missing\n");
+    return 1;
+  }
+
+  g_object_set (sink, "sync", FALSE, NULL);
+  gst_bin_add_many (GST_BIN (pipeline), src, parse, sink, NULL);
+  gst_element_link_many (src, parse, sink, NULL);
+
+  pad = gst_element_get_static_pad (parse, "sink");
+  gst_pad_add_probe (pad, GST_PAD_PROBE_TYPE_BUFFER, _on_input, NULL, NULL);
+  gst_object_unref (pad);
+  pad = gst_element_get_static_pad (sink, "sink");
+  gst_pad_add_probe (pad, GST_PAD_PROBE_TYPE_BUFFER, _on_output, NULL, NULL);
+  gst_object_unref (pad);
+
+  if (location) {
+    g_object_set (src, "location", location, NULL);
+  } else {
+    caps = gst_caps_new_simple ("video/mpegts", "systemstream", G_TYPE_BOOLEAN,
+        TRUE, NULL);
+    g_object_set (src, "max-bytes", G_GUINT64_CONSTANT (0), "block", FALSE,
+        "caps", caps, NULL);
+    gst_caps_unref (caps);
+
+    /* Queue all the input before starting, the input buffers all share the
+     * memory of the same chunk */
+    chunk = _chunk_new ();
+    chunk_size = gst_buffer_get_size (chunk);
+    total = (guint64) size * 1024 * 1024;
+    for (offset = 0; offset < total; offset += chunk_size) {
+      gst_app_src_push_buffer (GST_APP_SRC (src),
+          gst_buffer_copy_region (chunk, GST_BUFFER_COPY_MEMORY, 0, -1));
+    }
+    gst_buffer_unref (chunk);
+    gst_app_src_end_of_stream (GST_APP_SRC (src));
+  }
+
+  gst_bus_add_watch (GST_ELEMENT_BUS (pipeline), _bus_watch, NULL);
+
+  start = g_get_monotonic_time ();
+  gst_element_set_state (pipeline, GST_STATE_PLAYING);
+  g_main_loop_run (loop);
+  end = g_get_monotonic_time ();
+
+  if (location)
+    g_print ("%s", location);
+  else
+    g_print ("%d bytes packets, %d bytes of garbage every %d packets",
+        m2ts ? TS_PACKET_SIZE + 4 : TS_PACKET_SIZE, garbage, CHUNK_PACKETS);
+  g_print (": %" G_GUINT64_FORMAT " bytes in, %" G_GUINT64_FORMAT " bytes in %"
+      G_GUINT64_FORMAT " buffers out, %.1f MB/s\n", in_bytes, out_bytes,
+      out_buffers, in_bytes / (gdouble) MAX (end - start, 1));
+
+  gst_element_set_state (pipeline, GST_STATE_NULL);
+  gst_object_unref (pipeline);
+  g_main_loop_unref (loop);
+  g_free (location);
+
+  return 0;
+}
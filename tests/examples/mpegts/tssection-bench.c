@@ -0,0 +1,323 @@
+/*
+ * tssection-bench.c - Time the section handling of tsparse
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin St, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+/* Usage:
+ *   tssection-bench [--size=MB] [--programs=N] [--shared-pmt-pid]
+ *
+ * Parses the given amount of a generated multi-program transport stream
+ * with tsparse and prints the rate at which it went through. Each program
+ * has its PMT and one elementary stream on their own PIDs, and the tables
+ * are repeated all along. With --shared-pmt-pid, the PMTs of all the
+ * programs are carried on the same PID, which then has a subtable for each
+ * program, as the EIT of a whole multiplex would. */
+
+#include <string.h>
+
+#include <gst/gst.h>
+#include <gst/app/gstappsrc.h>
+
+#define PACKET_SIZE 188
+/* The PAT has to fit in a 1024 bytes section */
+#define MAX_PROGRAMS 250
+#define PMT_PID 0x1000
+#define ES_PID 0x100
+/* The tables are repeated this many times in each chunk, so that the
+ * continuity counters carry on over the chunks */
+#define ROUNDS 16
+
+static gint size = 256;
+static gint n_programs = 200;
+static gboolean shared_pmt_pid = FALSE;
+
+static GOptionEntry entries[] = {
+  {"size", 's', 0, G_OPTION_ARG_INT, &size,
+      "Megabytes of transport stream to generate", "MB"},
+  {"programs", 'p', 0, G_OPTION_ARG_INT, &n_programs,
+      "Number of programs (at most 250)", "N"},
+  {"shared-pmt-pid", 'S', 0, G_OPTION_ARG_NONE, &shared_pmt_pid,
+      "Carry all the PMTs on the same PID", NULL},
+  {NULL}
+};
+
+static GMainLoop *loop;
+static guint64 in_bytes, out_bytes, out_buffers;
+static guint8 cc[0x2000];
+
+static gboolean
+_bus_watch (GstBus * bus, GstMessage * msg, gpointer user_data)
+{
+  switch (GST_MESSAGE_TYPE (msg)) {
+    case GST_MESSAGE_ERROR:{
+      GError *err = NULL;
+
+      gst_message_parse_error (msg, &err, NULL);
+      g_printerr ("ERROR from element %s: %s\n", GST_OBJECT_NAME (msg->src),
+          err->message);
+      g_error_free (err);
+      g_main_loop_quit (loop);
+      break;
+    }
+    case GST_MESSAGE_EOS:
+      g_main_loop_quit (loop);
+      break;
+    default:
+      break;
+  }
+
+  return TRUE;
+}
+
+static GstPadProbeReturn
+_on_input (GstPad * pad, GstPadProbeInfo * info, gpointer user_data)
+{
+  in_bytes += gst_buffer_get_size (GST_PAD_PROBE_INFO_BUFFER (info));
+
+  return GST_PAD_PROBE_OK;
+}
+
+static GstPadProbeReturn
+_on_output (GstPad * pad, GstPadProbeInfo * info, gpointer user_data)
+{
+  out_bytes += gst_buffer_get_size (GST_PAD_PROBE_INFO_BUFFER (info));
+  out_buffers++;
+
+  return GST_PAD_PROBE_OK;
+}
+
+static guint32
+_crc32 (const guint8 * data, gsize size)
+{
+  guint32 crc = 0xffffffff;
+  gsize i;
+  gint b;
+
+  for (i = 0; i < size; i++) {
+    crc ^= (guint32) data[i] << 24;
+    for (b = 0; b < 8; b++)
+      crc = crc & 0x80000000 ? (crc << 1) ^ 0x04c11db7 : crc << 1;
+  }
+
+  return crc;
+}
+
+/* Appends a packet of @pid and returns where its payload goes */
+static guint8 *
+_append_packet (GByteArray * ts, guint16 pid, gboolean pusi)
+{
+  guint8 *p;
+
+  g_byte_array_set_size (ts, ts->len + PACKET_SIZE);
+  p = ts->data + ts->len - PACKET_SIZE;
+  p[0] = 0x47;
+  p[1] = (pusi ? 0x40 : 0x00) | (pid >> 8);
+  p[2] = pid & 0xff;
+  p[3] = 0x10 | (cc[pid]++ & 0xf);
+  memset (p + 4, 0xff, PACKET_SIZE - 4);
+
+  return p + 4;
+}
+
+/* Appends the packets carrying @section, which lacks its CRC */
+static void
+_append_section (GByteArray * ts, guint16 pid, const guint8 * section,
+    gsize size)
+{
+  guint8 *data = g_malloc (size + 4), *p;
+  gsize offset = 0, len;
+
+  memcpy (data, section, size);
+  GST_WRITE_UINT32_BE (data + size, _crc32 (section, size));
+  size += 4;
+
+  p = _append_packet (ts, pid, TRUE);
+  *p++ = 0x00;
+  len = MIN (size, PACKET_SIZE - 5);
+  while (TRUE) {
+    memcpy (p, data + offset, len);
+    offset += len;
+    if (offset == size)
+      break;
+    p = _append_packet (ts, pid, FALSE);
+    len = MIN (size - offset, PACKET_SIZE - 4);
+  }
+
+  g_free (data);
+}
+
+static void
+_append_pat (GByteArray * ts)
+{
+  guint8 pat[8 + 4 * MAX_PROGRAMS];
+  gsize len = 8 + 4 * n_programs;
+  gint i;
+
+  pat[0] = 0x00;
+  pat[1] = 0xb0 | ((len + 4 - 3) >> 8);
+  pat[2] = (len + 4 - 3) & 0xff;
+  GST_WRITE_UINT16_BE (pat + 3, 1);
+  pat[5] = 0xc1;
+  pat[6] = pat[7] = 0x00;
+  for (i = 0; i < n_programs; i++) {
+    guint16 pmt_pid = shared_pmt_pid ? PMT_PID : PMT_PID + i;
+
+    GST_WRITE_UINT16_BE (pat + 8 + 4 * i, i + 1);
+    pat[8 + 4 * i + 2] = 0xe0 | (pmt_pid >> 8);
+    pat[8 + 4 * i + 3] = pmt_pid & 0xff;
+  }
+
+  _append_section (ts, 0x0000, pat, len);
+}
+
+/* The PMT of a program with an HEVC stream and no PCR */
+static void
+_append_pmt (GByteArray * ts, gint program)
+{
+  guint8 pmt[] = {
+    0x02, 0xb0, 0x12, 0x00, 0x00, 0xc1, 0x00, 0x00,
+    0xff, 0xff, 0xf0, 0x00, 0x24, 0x00, 0x00, 0xf0, 0x00
+  };
+  guint16 es_pid = ES_PID + program;
+
+  GST_WRITE_UINT16_BE (pmt + 3, program + 1);
+  pmt[13] = 0xe0 | (es_pid >> 8);
+  pmt[14] = es_pid & 0xff;
+
+  _append_section (ts, shared_pmt_pid ? PMT_PID : PMT_PID + program, pmt,
+      sizeof pmt);
+}
+
+/* A PES of unbounded length in a single packet */
+static void
+_append_pes (GByteArray * ts, gint program)
+{
+  static const guint8 pes_header[] = {
+    0x00, 0x00, 0x01, 0xe0, 0x00, 0x00, 0x80, 0x00, 0x00
+  };
+  guint8 *p = _append_packet (ts, ES_PID + program, TRUE);
+
+  memset (p, 0x5a, PACKET_SIZE - 4);
+  memcpy (p, pes_header, sizeof pes_header);
+}
+
+/* ROUNDS times the PAT, then the PMT and a PES packet of each program */
+static GstBuffer *
+_chunk_new (void)
+{
+  GByteArray *ts = g_byte_array_new ();
+  gint round, i;
+  guint len;
+
+  for (round = 0; round < ROUNDS; round++) {
+    _append_pat (ts);
+    for (i = 0; i < n_programs; i++) {
+      _append_pmt (ts, i);
+      _append_pes (ts, i);
+    }
+  }
+
+  len = ts->len;
+
+  return gst_buffer_new_wrapped (g_byte_array_free (ts, FALSE), len);
+}
+
+int
+main (int argc, char *argv[])
+{
+  GOptionContext *ctx;
+  GError *err = NULL;
+  GstElement *pipeline, *src, *parse, *sink;
+  GstBuffer *chunk;
+  GstCaps *caps;
+  GstPad *pad;
+  gint64 start, end;
+  guint64 total, offset;
+  gsize chunk_size;
+
+  ctx = g_option_context_new ("");
+  g_option_context_add_main_entries (ctx, entries, NULL);
+  g_option_context_add_group (ctx, gst_init_get_option_group ());
+  if (!g_option_context_parse (ctx, &argc, &argv, &err)) {
+    g_printerr ("Error initializing: %s\n", err->message);
+    g_clear_error (&err);
+    g_option_context_free (ctx);
+    return 1;
+  }
+  g_option_context_free (ctx);
+
+  if (size <= 0 || n_programs <= 0 || n_programs > MAX_PROGRAMS) {
+    g_printerr ("Invalid size or number of programs\n");
+    return 1;
+  }
+
+  loop = g_main_loop_new (NULL, FALSE);
+  pipeline = gst_pipeline_new (NULL);
+  src = gst_element_factory_make ("appsrc", NULL);
+  parse = gst_element_factory_make ("tsparse", NULL);
+  sink = gst_element_factory_make ("fakesink", NULL);
+  if (!src || !parse || !sink) {
+    g_printerr ("The app, mpegtsdemux or fakesink plugins are missing\n");
+    return 1;
+  }
+
+  caps = gst_caps_new_simple ("video/mpegts", "systemstream", G_TYPE_BOOLEAN,
+      TRUE, "packetsize", G_TYPE_INT, PACKET_SIZE, NULL);
+  g_object_set (src, "max-bytes", G_GUINT64_CONSTANT (0), "block", FALSE,
+      "caps", caps, NULL);
+  gst_caps_unref (caps);
+  g_object_set (sink, "sync", FALSE, NULL);
+  gst_bin_add_many (GST_BIN (pipeline), src, parse, sink, NULL);
+  gst_element_link_many (src, parse, sink, NULL);
+
+  pad = gst_element_get_static_pad (parse, "sink");
+  gst_pad_add_probe (pad, GST_PAD_PROBE_TYPE_BUFFER, _on_input, NULL, NULL);
+  gst_object_unref (pad);
+  pad = gst_element_get_static_pad (sink, "sink");
+  gst_pad_add_probe (pad, GST_PAD_PROBE_TYPE_BUFFER, _on_output, NULL, NULL);
+  gst_object_unref (pad);
+
+  /* Queue all the input before starting, the input buffers all share the
+   * memory of the same chunk */
+  chunk = _chunk_new ();
+  chunk_size = gst_buffer_get_size (chunk);
+  total = (guint64) size * 1024 * 1024;
+  for (offset = 0; offset < total; offset += chunk_size) {
+    gst_app_src_push_buffer (GST_APP_SRC (src),
+        gst_buffer_copy_region (chunk, GST_BUFFER_COPY_MEMORY, 0, -1));
+  }
+  gst_buffer_unref (chunk);
+  gst_app_src_end_of_stream (GST_APP_SRC (src));
+
+  gst_bus_add_watch (GST_ELEMENT_BUS (pipeline), _bus_watch, NULL);
+
+  start = g_get_monotonic_time ();
+  gst_element_set_state (pipeline, GST_STATE_PLAYING);
+  g_main_loop_run (loop);
+  end = g_get_monotonic_time ();
+
+  g_print ("%d programs%s: %" G_GUINT64_FORMAT " bytes in, %" G_GUINT64_FORMAT
+      " bytes in %" G_GUINT64_FORMAT " buffers out, %.1f MB/s\n", n_programs,
+      shared_pmt_pid ? " with a shared PMT PID" : "", in_bytes, out_bytes,
+      out_buffers, in_bytes / (gdouble) MAX (end - start, 1));
+
+  gst_element_set_state (pipeline, GST_STATE_NULL);
+  gst_object_unref (pipeline);
+  g_main_loop_unref (loop);
+
+  return 0;
+}
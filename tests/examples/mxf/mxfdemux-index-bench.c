@@ -0,0 +1,236 @@
+/*
+ * mxfdemux-index-bench.c - Time opening and seeking in large MXF files with
+ *                          and without the mxfdemux index cache
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin St, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+/* Usage:
+ *   mxfdemux-index-bench [--frames=N] [--width=N] [--height=N] [--seeks=N]
+ *                        [--file=PATH]
+ *
+ * Generates an MXF file of raw video with mxfmux (unless --file is given),
+ * then opens it three times: without the index cache, with an empty cache
+ * directory and with the cache written by the previous run. Each run times
+ * prerolling and a number of flushing seeks spread over the file. */
+
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif
+
+#include <gst/gst.h>
+#include <glib/gstdio.h>
+
+static gint n_frames = 7500;
+static gint width = 320;
+static gint height = 240;
+static gint n_seeks = 200;
+static gchar *filename = NULL;
+
+static GOptionEntry entries[] = {
+  {"frames", 'n', 0, G_OPTION_ARG_INT, &n_frames,
+      "Number of frames in the generated file", "N"},
+  {"width", 0, 0, G_OPTION_ARG_INT, &width,
+      "Width of the generated frames", "N"},
+  {"height", 0, 0, G_OPTION_ARG_INT, &height,
+      "Height of the generated frames", "N"},
+  {"seeks", 's', 0, G_OPTION_ARG_INT, &n_seeks,
+      "Number of seeks", "N"},
+  {"file", 'f', 0, G_OPTION_ARG_FILENAME, &filename,
+      "Existing MXF file to use instead of generating one", "PATH"},
+  {NULL}
+};
+
+static gboolean
+run_pipeline (GstElement * pipeline, GstState state)
+{
+  GstStateChangeReturn ret;
+
+  ret = gst_element_set_state (pipeline, state);
+  if (ret == GST_STATE_CHANGE_ASYNC)
+    ret = gst_element_get_state (pipeline, NULL, NULL, GST_CLOCK_TIME_NONE);
+
+  return ret != GST_STATE_CHANGE_FAILURE;
+}
+
+static gboolean
+generate (const gchar * location)
+{
+  GstElement *pipeline;
+  GstMessage *msg;
+  GError *err = NULL;
+  gchar *desc;
+  gboolean ret;
+
+  desc = g_strdup_printf ("videotestsrc num-buffers=%d ! "
+      "video/x-raw,format=RGB,width=%d,height=%d,framerate=25/1 ! "
+      "mxfmux ! filesink location=\"%s\"", n_frames, width, height, location);
+  pipeline = gst_parse_launch (desc, &err);
+  g_free (desc);
+  if (!pipeline) {
+    g_printerr ("Failed to create pipeline: %s\n", err->message);
+    g_clear_error (&err);
+    return FALSE;
+  }
+
+  gst_element_set_state (pipeline, GST_STATE_PLAYING);
+  msg = gst_bus_timed_pop_filtered (GST_ELEMENT_BUS (pipeline),
+      GST_CLOCK_TIME_NONE, GST_MESSAGE_EOS | GST_MESSAGE_ERROR);
+  ret = GST_MESSAGE_TYPE (msg) == GST_MESSAGE_EOS;
+  gst_message_unref (msg);
+  gst_element_set_state (pipeline, GST_STATE_NULL);
+  gst_object_unref (pipeline);
+
+  return ret;
+}
+
+static gboolean
+bench (const gchar * location, const gchar * cache_dir, const gchar * name)
+{
+  GstElement *pipeline, *demux;
+  GError *err = NULL;
+  gint64 start, open_time, seek_time;
+  gint64 duration = -1;
+  gchar *desc;
+  gint i;
+
+  desc = g_strdup_printf ("filesrc location=\"%s\" ! mxfdemux name=d "
+      "d. ! fakesink sync=false", location);
+  pipeline = gst_parse_launch (desc, &err);
+  g_free (desc);
+  if (!pipeline) {
+    g_printerr ("Failed to create pipeline: %s\n", err->message);
+    g_clear_error (&err);
+    return FALSE;
+  }
+
+  demux = gst_bin_get_by_name (GST_BIN (pipeline), "d");
+  g_object_set (demux, "index-cache-dir", cache_dir, NULL);
+  gst_object_unref (demux);
+
+  start = g_get_monotonic_time ();
+  if (!run_pipeline (pipeline, GST_STATE_PAUSED)) {
+    g_printerr ("Failed to preroll %s\n", location);
+    gst_element_set_state (pipeline, GST_STATE_NULL);
+    gst_object_unref (pipeline);
+    return FALSE;
+  }
+  open_time = g_get_monotonic_time () - start;
+
+  if (!gst_element_query_duration (pipeline, GST_FORMAT_TIME, &duration)
+      || duration <= 0) {
+    g_printerr ("Failed to query the duration\n");
+    gst_element_set_state (pipeline, GST_STATE_NULL);
+    gst_object_unref (pipeline);
+    return FALSE;
+  }
+
+  start = g_get_monotonic_time ();
+  for (i = 0; i < n_seeks; i++) {
+    gint64 ts = gst_util_uint64_scale (i * 7919 % n_seeks, duration, n_seeks);
+
+    gst_element_seek_simple (pipeline, GST_FORMAT_TIME,
+        GST_SEEK_FLAG_FLUSH | GST_SEEK_FLAG_KEY_UNIT, ts);
+    gst_element_get_state (pipeline, NULL, NULL, GST_CLOCK_TIME_NONE);
+  }
+  seek_time = MAX (g_get_monotonic_time () - start, 1);
+
+  /* Writes the cache */
+  gst_element_set_state (pipeline, GST_STATE_NULL);
+  gst_object_unref (pipeline);
+
+  g_print ("%-12s open: %8.3f ms, seek: %8.3f ms\n", name,
+      open_time / 1000.0, (gdouble) seek_time / 1000.0 / n_seeks);
+
+  return TRUE;
+}
+
+gint
+main (gint argc, gchar ** argv)
+{
+  GOptionContext *ctx;
+  GError *err = NULL;
+  gchar *tmpdir, *location, *cache_dir;
+  GDir *dir;
+  const gchar *entry;
+  gint ret = 1;
+
+  ctx = g_option_context_new ("");
+  g_option_context_add_main_entries (ctx, entries, NULL);
+  g_option_context_add_group (ctx, gst_init_get_option_group ());
+  if (!g_option_context_parse (ctx, &argc, &argv, &err)) {
+    g_printerr ("Error initializing: %s\n", err->message);
+    g_clear_error (&err);
+    g_option_context_free (ctx);
+    return 1;
+  }
+  g_option_context_free (ctx);
+
+  if (n_frames <= 0 || width <= 0 || height <= 0 || n_seeks <= 0) {
+    g_printerr ("Counts and sizes must be positive\n");
+    return 1;
+  }
+
+  tmpdir = g_dir_make_tmp ("mxfdemux-index-bench-XXXXXX", &err);
+  if (!tmpdir) {
+    g_printerr ("Failed to create temporary directory: %s\n", err->message);
+    g_clear_error (&err);
+    return 1;
+  }
+  cache_dir = g_build_filename (tmpdir, "cache", NULL);
+
+  if (filename) {
+    location = g_strdup (filename);
+  } else {
+    location = g_build_filename (tmpdir, "bench.mxf", NULL);
+    g_print ("Generating %d frames of %dx%d RGB\n", n_frames, width, height);
+    if (!generate (location)) {
+      g_printerr ("Failed to generate %s\n", location);
+      goto done;
+    }
+  }
+
+  if (bench (location, NULL, "no cache")
+      && bench (location, cache_dir, "cold cache")
+      && bench (location, cache_dir, "warm cache"))
+    ret = 0;
+
+done:
+  dir = g_dir_open (cache_dir, 0, NULL);
+  while (dir && (entry = g_dir_read_name (dir))) {
+    gchar *path = g_build_filename (cache_dir, entry, NULL);
+    GStatBuf st;
+
+    if (g_stat (path, &st) == 0)
+      g_print ("Index cache %s: %" G_GINT64_FORMAT " bytes\n", entry,
+          (gint64) st.st_size);
+    g_unlink (path);
+    g_free (path);
+  }
+  if (dir)
+    g_dir_close (dir);
+  g_rmdir (cache_dir);
+
+  if (!filename)
+    g_unlink (location);
+  g_rmdir (tmpdir);
+
+  g_free (location);
+  g_free (cache_dir);
+  g_free (tmpdir);
+
+  return ret;
+}
@@ -0,0 +1,194 @@
+/*
+ * netsim-bench.c - Time many packets in flight through netsim
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin St, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+/* Usage:
+ *   netsim-bench [--packets=N] [--size=N] [--delay=MS] [--link-kbps=N]
+ *
+ * Pushes N packets of the given size into netsim as fast as possible, each
+ * delayed by the given number of milliseconds, so that they are all in
+ * flight at the same time, and prints the rate at which netsim took them,
+ * and the average and maximum time they left netsim after they were due.
+ * With --link-kbps, the packets are also sent over a link of that
+ * capacity, which then decides when they are due. */
+
+#include <gst/gst.h>
+#include <gst/app/gstappsrc.h>
+
+static gint n_packets = 100000;
+static gint packet_size = 1200;
+static gint delay = 1000;
+static gint link_kbps = -1;
+
+static GOptionEntry entries[] = {
+  {"packets", 'n', 0, G_OPTION_ARG_INT, &n_packets,
+      "Number of packets to send", "N"},
+  {"size", 's', 0, G_OPTION_ARG_INT, &packet_size,
+      "Size of each packet in bytes", "N"},
+  {"delay", 'd', 0, G_OPTION_ARG_INT, &delay,
+      "Delay of each packet in milliseconds", "MS"},
+  {"link-kbps", 'l', 0, G_OPTION_ARG_INT, &link_kbps,
+      "Capacity of the link in kilobits per second", "N"},
+  {NULL}
+};
+
+static GMainLoop *loop;
+
+/* Only touched from the streaming thread of appsrc, and read once
+ * everything went through netsim */
+static gint64 n_sent, first_sent, last_sent;
+
+/* Only touched from the streaming thread of netsim */
+static gint64 n_received;
+static gint64 lateness_sum, lateness_max;
+static gint64 link_busy_until;
+
+static gboolean
+_bus_watch (GstBus * bus, GstMessage * msg, gpointer user_data)
+{
+  if (GST_MESSAGE_TYPE (msg) == GST_MESSAGE_ERROR) {
+    GError *err = NULL;
+
+    gst_message_parse_error (msg, &err, NULL);
+    g_printerr ("ERROR from element %s: %s\n", GST_OBJECT_NAME (msg->src),
+        err->message);
+    g_error_free (err);
+    g_main_loop_quit (loop);
+  }
+
+  return TRUE;
+}
+
+/* The time a packet reaches netsim travels in its offset end, netsim uses
+ * the system clock which is monotonic by default */
+static GstPadProbeReturn
+_on_sent (GstPad * pad, GstPadProbeInfo * info, gpointer user_data)
+{
+  GstBuffer *buffer = gst_buffer_make_writable (GST_PAD_PROBE_INFO_BUFFER
+      (info));
+  gint64 now = g_get_monotonic_time ();
+
+  if (n_sent++ == 0)
+    first_sent = now;
+  last_sent = now;
+  GST_BUFFER_OFFSET_END (buffer) = now;
+  GST_PAD_PROBE_INFO_DATA (info) = buffer;
+
+  return GST_PAD_PROBE_OK;
+}
+
+static GstPadProbeReturn
+_on_received (GstPad * pad, GstPadProbeInfo * info, gpointer user_data)
+{
+  gint64 now = g_get_monotonic_time (), due, lateness;
+  GstBuffer *buffer;
+
+  buffer = GST_PAD_PROBE_INFO_BUFFER (info);
+  due = GST_BUFFER_OFFSET_END (buffer);
+  if (link_kbps > 0) {
+    /* the link sends the packets one after the other */
+    link_busy_until = MAX (link_busy_until, due) +
+        (gint64) packet_size * 8 * 1000 / link_kbps;
+    due = link_busy_until;
+  }
+  lateness = MAX (now - due - delay * 1000, 0);
+  lateness_sum += lateness;
+  lateness_max = MAX (lateness_max, lateness);
+
+  if (++n_received == n_packets) {
+    g_print ("%d packets of %d bytes, delay %d ms, link %d kbps: %.0f "
+        "packets/s scheduled, lateness avg %.3f ms max %.3f ms\n",
+        n_packets, packet_size, delay, link_kbps,
+        n_sent * 1e6 / MAX (last_sent - first_sent, 1),
+        lateness_sum / 1e3 / n_received, lateness_max / 1e3);
+    g_main_loop_quit (loop);
+  }
+
+  return GST_PAD_PROBE_OK;
+}
+
+int
+main (int argc, char *argv[])
+{
+  GOptionContext *ctx;
+  GError *err = NULL;
+  GstElement *pipeline, *src, *netsim, *sink;
+  GstPad *pad;
+  gint i;
+
+  ctx = g_option_context_new ("");
+  g_option_context_add_main_entries (ctx, entries, NULL);
+  g_option_context_add_group (ctx, gst_init_get_option_group ());
+  if (!g_option_context_parse (ctx, &argc, &argv, &err)) {
+    g_printerr ("Error initializing: %s\n", err->message);
+    g_clear_error (&err);
+    g_option_context_free (ctx);
+    return 1;
+  }
+  g_option_context_free (ctx);
+
+  if (n_packets <= 0 || packet_size <= 0 || delay < 0) {
+    g_printerr ("Invalid packet count, packet size or delay\n");
+    return 1;
+  }
+
+  loop = g_main_loop_new (NULL, FALSE);
+  pipeline = gst_pipeline_new (NULL);
+  src = gst_element_factory_make ("appsrc", NULL);
+  netsim = gst_element_factory_make ("netsim", NULL);
+  sink = gst_element_factory_make ("fakesink", NULL);
+  if (!src || !netsim || !sink) {
+    g_printerr ("The app, netsim or fakesink plugins are missing\n");
+    return 1;
+  }
+
+  /* appsrc must not block or drop, all packets go to netsim at once */
+  g_object_set (src, "max-bytes", G_GUINT64_CONSTANT (0), "block", FALSE,
+      "format", GST_FORMAT_TIME, NULL);
+  g_object_set (netsim, "delay-probability", 1.0, "min-delay", delay,
+      "max-delay", delay, "link-kbps", link_kbps, NULL);
+  g_object_set (sink, "sync", FALSE, NULL);
+  gst_bin_add_many (GST_BIN (pipeline), src, netsim, sink, NULL);
+  gst_element_link_many (src, netsim, sink, NULL);
+
+  pad = gst_element_get_static_pad (sink, "sink");
+  gst_pad_add_probe (pad, GST_PAD_PROBE_TYPE_BUFFER, _on_received, NULL,
+      NULL);
+  gst_object_unref (pad);
+
+  pad = gst_element_get_static_pad (netsim, "sink");
+  gst_pad_add_probe (pad, GST_PAD_PROBE_TYPE_BUFFER, _on_sent, NULL, NULL);
+  gst_object_unref (pad);
+
+  /* Queue all packets before starting, so that appsrc pushes them into
+   * netsim as fast as it can take them */
+  for (i = 0; i < n_packets; i++)
+    gst_app_src_push_buffer (GST_APP_SRC (src),
+        gst_buffer_new_allocate (NULL, packet_size, NULL));
+
+  gst_bus_add_watch (GST_ELEMENT_BUS (pipeline), _bus_watch, NULL);
+  gst_element_set_state (pipeline, GST_STATE_PLAYING);
+
+  g_main_loop_run (loop);
+
+  gst_element_set_state (pipeline, GST_STATE_NULL);
+  gst_object_unref (pipeline);
+  g_main_loop_unref (loop);
+
+  return 0;
+}
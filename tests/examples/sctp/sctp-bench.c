@@ -0,0 +1,322 @@
+/*
+ * sctp-bench.c - Time many SCTP associations looped back through
+ * sctpenc and sctpdec
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin St, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+/* Usage:
+ *   sctp-bench [--associations=N] [--messages=N] [--size=N]
+ *       [--shared-worker]
+ *
+ * Connects N pairs of sctpenc/sctpdec endpoints to each other in one
+ * pipeline, sends N messages of the given size from one endpoint of each
+ * pair to the other and prints the time it took to establish all
+ * associations, the number of threads of the process once they are
+ * established, the message rate and the average and maximum latency from
+ * sending to receiving a message. With --shared-worker, all elements push
+ * from the shared worker pool instead of their own streaming threads. */
+
+#include <gst/gst.h>
+
+#include <string.h>
+
+#define SCTP_PORT 5000
+#define BURST_SIZE 32
+
+static gint n_associations = 100;
+static gint n_messages = 1000;
+static gint message_size = 64;
+static gboolean shared_worker = FALSE;
+
+static GOptionEntry entries[] = {
+  {"associations", 'a', 0, G_OPTION_ARG_INT, &n_associations,
+      "Number of associations, each with two endpoints", "N"},
+  {"messages", 'n', 0, G_OPTION_ARG_INT, &n_messages,
+      "Number of messages to send per association", "N"},
+  {"size", 's', 0, G_OPTION_ARG_INT, &message_size,
+      "Size of each message in bytes, at least 8", "N"},
+  {"shared-worker", 'w', 0, G_OPTION_ARG_NONE, &shared_worker,
+      "Push from the shared worker pool", NULL},
+  {NULL}
+};
+
+static GMainLoop *loop;
+static GstElement *pipeline;
+static GstElement **senders;
+static gint *n_sent;
+static gint n_established;
+static gint64 setup_start_time, start_time;
+
+/* Updated from the streaming threads of all receivers */
+static gint64 n_received;
+static gint64 latency_sum, latency_max;
+G_LOCK_DEFINE_STATIC (stats_lock);
+
+static gboolean
+_bus_watch (GstBus * bus, GstMessage * msg, gpointer user_data)
+{
+  if (GST_MESSAGE_TYPE (msg) == GST_MESSAGE_ERROR) {
+    GError *err = NULL;
+
+    gst_message_parse_error (msg, &err, NULL);
+    g_printerr ("ERROR from element %s: %s\n", GST_OBJECT_NAME (msg->src),
+        err->message);
+    g_error_free (err);
+    g_main_loop_quit (loop);
+  }
+
+  return TRUE;
+}
+
+static gint
+_get_n_threads (void)
+{
+  gchar *status, *line;
+  gint n = -1;
+
+  if (!g_file_get_contents ("/proc/self/status", &status, NULL, NULL))
+    return -1;
+
+  line = strstr (status, "\nThreads:");
+  if (line)
+    n = g_ascii_strtoll (line + strlen ("\nThreads:"), NULL, 10);
+  g_free (status);
+
+  return n;
+}
+
+static gboolean
+_send_burst (gpointer user_data)
+{
+  guint8 *data;
+  gboolean done = TRUE;
+  gint a, i;
+
+  data = g_malloc0 (message_size);
+
+  for (a = 0; a < n_associations; a++) {
+    GstBufferList *list;
+    GstFlowReturn ret;
+
+    if (n_sent[a] >= n_messages)
+      continue;
+    done = FALSE;
+
+    list = gst_buffer_list_new_sized (BURST_SIZE);
+    for (i = 0; i < BURST_SIZE && n_sent[a] < n_messages; i++, n_sent[a]++) {
+      gint64 now = g_get_monotonic_time ();
+
+      memcpy (data, &now, sizeof (now));
+      gst_buffer_list_add (list, gst_buffer_new_memdup (data, message_size));
+    }
+
+    g_signal_emit_by_name (senders[a], "send-buffer-list", 0, list, FALSE,
+        &ret);
+    gst_buffer_list_unref (list);
+    if (ret != GST_FLOW_OK) {
+      g_printerr ("Sending failed: %s\n", gst_flow_get_name (ret));
+      g_main_loop_quit (loop);
+      break;
+    }
+  }
+
+  g_free (data);
+
+  return done ? G_SOURCE_REMOVE : G_SOURCE_CONTINUE;
+}
+
+static gboolean
+_start_sending (gpointer user_data)
+{
+  gint a;
+
+  g_print ("%d associations established in %.3f s, %d threads\n",
+      n_associations, (g_get_monotonic_time () - setup_start_time) / 1e6,
+      _get_n_threads ());
+
+  for (a = 0; a < n_associations; a++) {
+    GstPad *pad = gst_element_request_pad_simple (senders[a], "sink_0");
+
+    if (!pad) {
+      g_printerr ("Could not request stream\n");
+      g_main_loop_quit (loop);
+      return G_SOURCE_REMOVE;
+    }
+    gst_object_unref (pad);
+  }
+
+  start_time = g_get_monotonic_time ();
+  g_idle_add (_send_burst, NULL);
+
+  return G_SOURCE_REMOVE;
+}
+
+static void
+_on_established (GstElement * sctpenc, gboolean established,
+    gpointer user_data)
+{
+  if (established && g_atomic_int_add (&n_established, 1) + 1 ==
+      2 * n_associations)
+    g_idle_add (_start_sending, NULL);
+}
+
+static gboolean
+_count_buffer (GstBuffer ** buffer, guint idx, gpointer user_data)
+{
+  gint64 *now = user_data, sent, latency;
+
+  gst_buffer_extract (*buffer, 0, &sent, sizeof (sent));
+  latency = *now - sent;
+  latency_sum += latency;
+  latency_max = MAX (latency_max, latency);
+  n_received++;
+
+  return TRUE;
+}
+
+static GstPadProbeReturn
+_on_received (GstPad * pad, GstPadProbeInfo * info, gpointer user_data)
+{
+  gint64 now = g_get_monotonic_time ();
+  gboolean done;
+
+  G_LOCK (stats_lock);
+  if (info->type & GST_PAD_PROBE_TYPE_BUFFER_LIST)
+    gst_buffer_list_foreach (GST_PAD_PROBE_INFO_BUFFER_LIST (info),
+        _count_buffer, &now);
+  else
+    _count_buffer (&GST_PAD_PROBE_INFO_BUFFER (info), 0, &now);
+  done = n_received == (gint64) n_associations * n_messages;
+  G_UNLOCK (stats_lock);
+
+  if (done) {
+    gint64 elapsed = MAX (now - start_time, 1);
+
+    g_print ("%s: %d associations, %d byte messages: %.0f messages/s, "
+        "%.1f MB/s, latency avg %.3f ms max %.3f ms, %d threads\n",
+        shared_worker ? "shared worker" : "streaming threads", n_associations,
+        message_size, n_received * 1e6 / elapsed,
+        (gdouble) n_received * message_size / elapsed,
+        latency_sum / 1e3 / n_received, latency_max / 1e3, _get_n_threads ());
+    g_main_loop_quit (loop);
+  }
+
+  /* There is no sink, so the messages end here */
+  return GST_PAD_PROBE_DROP;
+}
+
+static void
+_on_pad_added (GstElement * sctpdec, GstPad * pad, gpointer user_data)
+{
+  gst_pad_add_probe (pad,
+      GST_PAD_PROBE_TYPE_BUFFER | GST_PAD_PROBE_TYPE_BUFFER_LIST,
+      _on_received, NULL, NULL);
+}
+
+static GstElement *
+_add_element (const gchar * factory, guint association_id)
+{
+  GstElement *element = gst_element_factory_make (factory, NULL);
+
+  if (!element)
+    return NULL;
+
+  g_object_set (element, "sctp-association-id", association_id,
+      "shared-worker", shared_worker, NULL);
+  if (g_str_equal (factory, "sctpenc"))
+    g_object_set (element, "remote-sctp-port", SCTP_PORT, NULL);
+  else
+    g_object_set (element, "local-sctp-port", SCTP_PORT, NULL);
+  gst_bin_add (GST_BIN (pipeline), element);
+
+  return element;
+}
+
+int
+main (int argc, char *argv[])
+{
+  GOptionContext *ctx;
+  GError *err = NULL;
+  GstBus *bus;
+  gint a;
+
+  ctx = g_option_context_new ("");
+  g_option_context_add_main_entries (ctx, entries, NULL);
+  g_option_context_add_group (ctx, gst_init_get_option_group ());
+  if (!g_option_context_parse (ctx, &argc, &argv, &err)) {
+    g_printerr ("Error initializing: %s\n", err->message);
+    g_clear_error (&err);
+    g_option_context_free (ctx);
+    return 1;
+  }
+  g_option_context_free (ctx);
+
+  /* Every association uses two association ids and sctpdec only allows
+   * ids up to 65535 */
+  if (n_associations <= 0 || n_associations > 32767 || n_messages <= 0
+      || message_size < 8) {
+    g_printerr ("Invalid association count, message count or message "
+        "size\n");
+    return 1;
+  }
+
+  loop = g_main_loop_new (NULL, FALSE);
+  pipeline = gst_pipeline_new (NULL);
+  bus = gst_pipeline_get_bus (GST_PIPELINE (pipeline));
+  gst_bus_add_watch (bus, _bus_watch, NULL);
+
+  senders = g_new0 (GstElement *, n_associations);
+  n_sent = g_new0 (gint, n_associations);
+
+  for (a = 0; a < n_associations; a++) {
+    GstElement *enc1, *dec1, *enc2, *dec2;
+
+    enc1 = _add_element ("sctpenc", 2 * a + 1);
+    dec1 = _add_element ("sctpdec", 2 * a + 1);
+    enc2 = _add_element ("sctpenc", 2 * a + 2);
+    dec2 = _add_element ("sctpdec", 2 * a + 2);
+    if (!enc1 || !dec1 || !enc2 || !dec2) {
+      g_printerr ("The sctp plugin is missing\n");
+      return 1;
+    }
+
+    gst_element_link (enc1, dec2);
+    gst_element_link (enc2, dec1);
+    g_signal_connect (enc1, "sctp-association-established",
+        G_CALLBACK (_on_established), NULL);
+    g_signal_connect (enc2, "sctp-association-established",
+        G_CALLBACK (_on_established), NULL);
+    g_signal_connect (dec2, "pad-added", G_CALLBACK (_on_pad_added), NULL);
+    senders[a] = enc1;
+  }
+
+  setup_start_time = g_get_monotonic_time ();
+  gst_element_set_state (pipeline, GST_STATE_PLAYING);
+
+  g_main_loop_run (loop);
+
+  gst_element_set_state (pipeline, GST_STATE_NULL);
+
+  g_free (senders);
+  g_free (n_sent);
+  gst_bus_remove_watch (bus);
+  gst_object_unref (bus);
+  gst_object_unref (pipeline);
+  g_main_loop_unref (loop);
+
+  return 0;
+}
@@ -0,0 +1,224 @@
+/* GStreamer
+ *
+ * Latency and throughput benchmark for the shmsink/shmsrc elements
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin St, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+/*
+ * Pushes buffers from one shmsink to 1..N shmsrc, once with the control
+ * socket and once with the shared memory ring, and prints the throughput
+ * and the latency between the two. Each buffer carries the monotonic time
+ * at which it was produced in its first bytes.
+ *
+ *   shm-bench --clients 4 --size 8294400 --buffers 600
+ */
+
+#ifdef HAVE_CONFIG_H
+#  include "config.h"
+#endif
+
+#include <gst/gst.h>
+#include <string.h>
+
+typedef struct
+{
+  GstElement *pipeline;
+  guint64 n_buffers;
+  gint64 total_latency;
+  gint64 max_latency;
+} Client;
+
+static GMutex lock;
+static GCond cond;
+static guint n_connected;
+static guint n_done;
+
+static gint n_clients = 1;
+static gint buffer_size = 4096;
+static gint n_buffers = 10000;
+static gint ring_size = 256;
+
+static void
+stamp_buffer (GstElement * src, GstBuffer * buffer, GstPad * pad,
+    gpointer user_data)
+{
+  gint64 now = g_get_monotonic_time ();
+
+  gst_buffer_fill (buffer, 0, &now, sizeof (now));
+}
+
+static void
+check_buffer (GstElement * sink, GstBuffer * buffer, GstPad * pad,
+    Client * client)
+{
+  gint64 now = g_get_monotonic_time ();
+  gint64 stamp, latency;
+
+  if (gst_buffer_extract (buffer, 0, &stamp, sizeof (stamp)) != sizeof (stamp))
+    return;
+
+  latency = now - stamp;
+  client->total_latency += latency;
+  client->max_latency = MAX (client->max_latency, latency);
+
+  if (++client->n_buffers == n_buffers) {
+    g_mutex_lock (&lock);
+    n_done++;
+    g_cond_signal (&cond);
+    g_mutex_unlock (&lock);
+  }
+}
+
+static void
+client_connected (GstElement * sink, gint fd, gpointer user_data)
+{
+  g_mutex_lock (&lock);
+  n_connected++;
+  g_cond_signal (&cond);
+  g_mutex_unlock (&lock);
+}
+
+static void
+run (guint ring, guint clients)
+{
+  GstElement *producer, *src, *sink;
+  Client *c = g_new0 (Client, clients);
+  gchar *socket_path = NULL;
+  gint64 start, elapsed, total_latency = 0, max_latency = 0;
+  GstMessage *msg;
+  guint i;
+
+  producer = gst_parse_launch ("fakesrc name=src sizetype=fixed "
+      "signal-handoffs=true ! shmsink name=sink", NULL);
+  src = gst_bin_get_by_name (GST_BIN (producer), "src");
+  sink = gst_bin_get_by_name (GST_BIN (producer), "sink");
+
+  g_object_set (src, "sizemax", buffer_size, "num-buffers", n_buffers, NULL);
+  g_object_set (sink, "socket-path", "/tmp/shm-bench", "ring-size", ring,
+      "sync", FALSE, "shm-size", MAX (buffer_size * 16, 64 * 1024 * 1024),
+      NULL);
+  g_signal_connect (src, "handoff", G_CALLBACK (stamp_buffer), NULL);
+  g_signal_connect (sink, "client-connected", G_CALLBACK (client_connected),
+      NULL);
+
+  n_connected = n_done = 0;
+
+  /* Creates the socket and prerolls, but doesn't render anything yet */
+  gst_element_set_state (producer, GST_STATE_PAUSED);
+  g_object_get (sink, "socket-path", &socket_path, NULL);
+
+  for (i = 0; i < clients; i++) {
+    GstElement *fakesink;
+
+    c[i].pipeline = gst_parse_launch ("shmsrc name=src ! "
+        "fakesink name=sink sync=false signal-handoffs=true", NULL);
+    src = gst_bin_get_by_name (GST_BIN (c[i].pipeline), "src");
+    g_object_set (src, "socket-path", socket_path, NULL);
+    gst_object_unref (src);
+
+    fakesink = gst_bin_get_by_name (GST_BIN (c[i].pipeline), "sink");
+    g_signal_connect (fakesink, "handoff", G_CALLBACK (check_buffer), &c[i]);
+    gst_object_unref (fakesink);
+
+    gst_element_set_state (c[i].pipeline, GST_STATE_PLAYING);
+  }
+
+  g_mutex_lock (&lock);
+  while (n_connected < clients)
+    g_cond_wait (&cond, &lock);
+  g_mutex_unlock (&lock);
+
+  start = g_get_monotonic_time ();
+  gst_element_set_state (producer, GST_STATE_PLAYING);
+
+  g_mutex_lock (&lock);
+  while (n_done < clients)
+    g_cond_wait (&cond, &lock);
+  g_mutex_unlock (&lock);
+  elapsed = MAX (g_get_monotonic_time () - start, 1);
+
+  msg = gst_bus_timed_pop_filtered (GST_ELEMENT_BUS (producer),
+      GST_CLOCK_TIME_NONE, GST_MESSAGE_EOS | GST_MESSAGE_ERROR);
+  gst_message_unref (msg);
+
+  for (i = 0; i < clients; i++) {
+    gst_element_set_state (c[i].pipeline, GST_STATE_NULL);
+    gst_object_unref (c[i].pipeline);
+    total_latency += c[i].total_latency;
+    max_latency = MAX (max_latency, c[i].max_latency);
+  }
+  gst_element_set_state (producer, GST_STATE_NULL);
+
+  g_print ("%-6s %7u %12.0f %10.1f %10.1f %10.1f\n",
+      ring ? "ring" : "socket", clients,
+      (gdouble) n_buffers * G_USEC_PER_SEC / elapsed,
+      (gdouble) n_buffers * buffer_size * clients / elapsed,
+      (gdouble) total_latency / (n_buffers * clients),
+      (gdouble) max_latency);
+
+  gst_object_unref (sink);
+  gst_object_unref (producer);
+  g_free (socket_path);
+  g_free (c);
+}
+
+int
+main (int argc, char **argv)
+{
+  GOptionEntry options[] = {
+    {"clients", 'c', 0, G_OPTION_ARG_INT, &n_clients,
+        "Run with 1 up to this many clients", NULL},
+    {"size", 's', 0, G_OPTION_ARG_INT, &buffer_size,
+        "Size of each buffer in bytes", NULL},
+    {"buffers", 'n', 0, G_OPTION_ARG_INT, &n_buffers,
+        "Number of buffers to send in each run", NULL},
+    {"ring-size", 'r', 0, G_OPTION_ARG_INT, &ring_size,
+        "Ring size to use for the ring runs", NULL},
+    {NULL}
+  };
+  GOptionContext *ctx;
+  GError *err = NULL;
+  gint i;
+
+  ctx = g_option_context_new ("- shmsink/shmsrc benchmark");
+  g_option_context_add_main_entries (ctx, options, NULL);
+  g_option_context_add_group (ctx, gst_init_get_option_group ());
+  if (!g_option_context_parse (ctx, &argc, &argv, &err)) {
+    g_printerr ("Error initializing: %s\n", err->message);
+    g_option_context_free (ctx);
+    g_clear_error (&err);
+    return 1;
+  }
+  g_option_context_free (ctx);
+
+  if (n_clients < 1 || buffer_size < (gint) sizeof (gint64) || n_buffers < 1
+      || ring_size < 1) {
+    g_printerr ("Invalid arguments\n");
+    return 1;
+  }
+
+  g_print ("%d buffers of %d bytes\n", n_buffers, buffer_size);
+  g_print ("%-6s %7s %12s %10s %10s %10s\n", "mode", "clients", "buffers/s",
+      "MB/s", "avg (us)", "max (us)");
+
+  for (i = 1; i <= n_clients; i++) {
+    run (0, i);
+    run (ring_size, i);
+  }
+
+  return 0;
+}
@@ -0,0 +1,295 @@
+/*
+ * webrtc-datachannel-bench.c - Time data channel messages between two
+ * webrtcbins
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin St, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+/* Usage:
+ *   webrtc-datachannel-bench [--channels=N] [--messages=N] [--size=N]
+ *       [--direct]
+ *
+ * Connects two webrtcbins over the loopback interface, sends N messages of
+ * the given size on each data channel and prints the message rate and the
+ * average and maximum latency from sending to receiving a message. With
+ * --direct, both webrtcbins use direct-data-channels. */
+
+#include <gst/gst.h>
+#include <gst/webrtc/webrtc.h>
+
+#include <string.h>
+
+/* Stop sending on a channel while this much is waiting to be sent */
+#define MAX_BUFFERED_AMOUNT (1024 * 1024)
+#define BURST_SIZE 64
+
+static gint n_channels = 4;
+static gint n_messages = 100000;
+static gint message_size = 64;
+static gboolean direct = FALSE;
+
+static GOptionEntry entries[] = {
+  {"channels", 'c', 0, G_OPTION_ARG_INT, &n_channels,
+      "Number of data channels", "N"},
+  {"messages", 'n', 0, G_OPTION_ARG_INT, &n_messages,
+      "Number of messages to send per channel", "N"},
+  {"size", 's', 0, G_OPTION_ARG_INT, &message_size,
+      "Size of each message in bytes, at least 8", "N"},
+  {"direct", 'd', 0, G_OPTION_ARG_NONE, &direct,
+      "Use direct data channels", NULL},
+  {NULL}
+};
+
+static GMainLoop *loop;
+static GstElement *pipe1, *webrtc1, *webrtc2;
+static GPtrArray *channels;
+static gint *n_sent;
+static gint n_open;
+
+/* Only touched from the receiving webrtcbin's thread */
+static gint64 n_received;
+static gint64 latency_sum, latency_max;
+static gint64 start_time;
+
+static gboolean
+_bus_watch (GstBus * bus, GstMessage * msg, gpointer user_data)
+{
+  if (GST_MESSAGE_TYPE (msg) == GST_MESSAGE_ERROR) {
+    GError *err = NULL;
+
+    gst_message_parse_error (msg, &err, NULL);
+    g_printerr ("ERROR from element %s: %s\n", GST_OBJECT_NAME (msg->src),
+        err->message);
+    g_error_free (err);
+    g_main_loop_quit (loop);
+  }
+
+  return TRUE;
+}
+
+static gboolean
+_send_burst (gpointer user_data)
+{
+  GBytes *bytes;
+  guint8 *data;
+  gboolean done = TRUE;
+  guint c;
+  gint i;
+
+  data = g_malloc0 (message_size);
+
+  for (c = 0; c < channels->len; c++) {
+    GstWebRTCDataChannel *channel = g_ptr_array_index (channels, c);
+    guint64 buffered;
+
+    if (n_sent[c] >= n_messages)
+      continue;
+    done = FALSE;
+
+    g_object_get (channel, "buffered-amount", &buffered, NULL);
+    if (buffered > MAX_BUFFERED_AMOUNT)
+      continue;
+
+    for (i = 0; i < BURST_SIZE && n_sent[c] < n_messages; i++, n_sent[c]++) {
+      gint64 now = g_get_monotonic_time ();
+
+      memcpy (data, &now, sizeof (now));
+      bytes = g_bytes_new (data, message_size);
+      gst_webrtc_data_channel_send_data_full (channel, bytes, NULL);
+      g_bytes_unref (bytes);
+    }
+  }
+
+  g_free (data);
+
+  return done ? G_SOURCE_REMOVE : G_SOURCE_CONTINUE;
+}
+
+static void
+_on_message_data (GstWebRTCDataChannel * channel, GBytes * bytes,
+    gpointer user_data)
+{
+  gint64 now = g_get_monotonic_time (), sent, latency;
+
+  memcpy (&sent, g_bytes_get_data (bytes, NULL), sizeof (sent));
+  latency = now - sent;
+  latency_sum += latency;
+  latency_max = MAX (latency_max, latency);
+
+  if (++n_received == (gint64) n_channels * n_messages) {
+    gint64 elapsed = MAX (now - start_time, 1);
+
+    g_print ("%s: %d channels, %d byte messages: %.0f messages/s, "
+        "%.1f MB/s, latency avg %.3f ms max %.3f ms\n",
+        direct ? "direct" : "appsrc/appsink", n_channels, message_size,
+        n_received * 1e6 / elapsed,
+        (gdouble) n_received * message_size / elapsed,
+        latency_sum / 1e3 / n_received, latency_max / 1e3);
+    g_main_loop_quit (loop);
+  }
+}
+
+static void
+_on_data_channel (GstElement * webrtc, GstWebRTCDataChannel * channel,
+    gpointer user_data)
+{
+  g_signal_connect (channel, "on-message-data", G_CALLBACK (_on_message_data),
+      NULL);
+}
+
+static void
+_on_open (GstWebRTCDataChannel * channel, gpointer user_data)
+{
+  if (g_atomic_int_add (&n_open, 1) + 1 == n_channels) {
+    start_time = g_get_monotonic_time ();
+    g_idle_add (_send_burst, NULL);
+  }
+}
+
+static void
+_on_answer_received (GstPromise * promise, gpointer user_data)
+{
+  GstWebRTCSessionDescription *answer = NULL;
+  const GstStructure *reply;
+
+  g_assert (gst_promise_wait (promise) == GST_PROMISE_RESULT_REPLIED);
+  reply = gst_promise_get_reply (promise);
+  gst_structure_get (reply, "answer",
+      GST_TYPE_WEBRTC_SESSION_DESCRIPTION, &answer, NULL);
+  gst_promise_unref (promise);
+
+  g_signal_emit_by_name (webrtc1, "set-remote-description", answer, NULL);
+  g_signal_emit_by_name (webrtc2, "set-local-description", answer, NULL);
+
+  gst_webrtc_session_description_free (answer);
+}
+
+static void
+_on_offer_received (GstPromise * promise, gpointer user_data)
+{
+  GstWebRTCSessionDescription *offer = NULL;
+  const GstStructure *reply;
+
+  g_assert (gst_promise_wait (promise) == GST_PROMISE_RESULT_REPLIED);
+  reply = gst_promise_get_reply (promise);
+  gst_structure_get (reply, "offer",
+      GST_TYPE_WEBRTC_SESSION_DESCRIPTION, &offer, NULL);
+  gst_promise_unref (promise);
+
+  g_signal_emit_by_name (webrtc1, "set-local-description", offer, NULL);
+  g_signal_emit_by_name (webrtc2, "set-remote-description", offer, NULL);
+
+  promise = gst_promise_new_with_change_func (_on_answer_received, user_data,
+      NULL);
+  g_signal_emit_by_name (webrtc2, "create-answer", NULL, promise);
+
+  gst_webrtc_session_description_free (offer);
+}
+
+static void
+_on_negotiation_needed (GstElement * element, gpointer user_data)
+{
+  GstPromise *promise;
+
+  promise = gst_promise_new_with_change_func (_on_offer_received, user_data,
+      NULL);
+  g_signal_emit_by_name (webrtc1, "create-offer", NULL, promise);
+}
+
+static void
+_on_ice_candidate (GstElement * webrtc, guint mlineindex, gchar * candidate,
+    GstElement * other)
+{
+  g_signal_emit_by_name (other, "add-ice-candidate", mlineindex, candidate);
+}
+
+int
+main (int argc, char *argv[])
+{
+  GOptionContext *ctx;
+  GError *err = NULL;
+  GstBus *bus;
+  gint i;
+
+  ctx = g_option_context_new ("");
+  g_option_context_add_main_entries (ctx, entries, NULL);
+  g_option_context_add_group (ctx, gst_init_get_option_group ());
+  if (!g_option_context_parse (ctx, &argc, &argv, &err)) {
+    g_printerr ("Error initializing: %s\n", err->message);
+    g_clear_error (&err);
+    g_option_context_free (ctx);
+    return 1;
+  }
+  g_option_context_free (ctx);
+
+  if (n_channels <= 0 || n_messages <= 0 || message_size < 8) {
+    g_printerr ("Invalid channel count, message count or message size\n");
+    return 1;
+  }
+
+  loop = g_main_loop_new (NULL, FALSE);
+  pipe1 = gst_parse_launch ("webrtcbin name=send webrtcbin name=recv", NULL);
+  bus = gst_pipeline_get_bus (GST_PIPELINE (pipe1));
+  gst_bus_add_watch (bus, _bus_watch, NULL);
+
+  webrtc1 = gst_bin_get_by_name (GST_BIN (pipe1), "send");
+  webrtc2 = gst_bin_get_by_name (GST_BIN (pipe1), "recv");
+  g_object_set (webrtc1, "direct-data-channels", direct, NULL);
+  g_object_set (webrtc2, "direct-data-channels", direct, NULL);
+
+  g_signal_connect (webrtc1, "on-negotiation-needed",
+      G_CALLBACK (_on_negotiation_needed), NULL);
+  g_signal_connect (webrtc1, "on-ice-candidate",
+      G_CALLBACK (_on_ice_candidate), webrtc2);
+  g_signal_connect (webrtc2, "on-ice-candidate",
+      G_CALLBACK (_on_ice_candidate), webrtc1);
+  g_signal_connect (webrtc2, "on-data-channel",
+      G_CALLBACK (_on_data_channel), NULL);
+
+  gst_element_set_state (pipe1, GST_STATE_PLAYING);
+
+  channels = g_ptr_array_new_with_free_func (g_object_unref);
+  n_sent = g_new0 (gint, n_channels);
+  for (i = 0; i < n_channels; i++) {
+    GstWebRTCDataChannel *channel = NULL;
+    gchar *label = g_strdup_printf ("bench-%d", i);
+
+    g_signal_emit_by_name (webrtc1, "create-data-channel", label, NULL,
+        &channel);
+    g_free (label);
+    if (!channel) {
+      g_printerr ("Could not create data channel\n");
+      return 1;
+    }
+    g_signal_connect (channel, "on-open", G_CALLBACK (_on_open), NULL);
+    g_ptr_array_add (channels, channel);
+  }
+
+  g_main_loop_run (loop);
+
+  gst_element_set_state (pipe1, GST_STATE_NULL);
+
+  g_ptr_array_unref (channels);
+  g_free (n_sent);
+  gst_object_unref (webrtc1);
+  gst_object_unref (webrtc2);
+  gst_bus_remove_watch (bus);
+  gst_object_unref (bus);
+  gst_object_unref (pipe1);
+  g_main_loop_unref (loop);
+
+  return 0;
+}